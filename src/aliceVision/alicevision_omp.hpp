@@ -15,6 +15,7 @@ using omp_lock_t = char;
 
 inline int omp_get_thread_num() { return 0; }
 inline int omp_get_max_threads() { return 1; }
+inline int omp_get_num_threads() { return 1; }
 inline void omp_set_num_threads(int num_threads) {}
 inline int omp_get_num_procs() { return 1; }
 inline void omp_set_nested(int nested) {}
@@ -31,9 +32,11 @@ inline void omp_unset_lock(omp_lock_t *lock) {}
 #if defined _OPENMP && _OPENMP >= 201107
 #define OMP_ATOMIC_UPDATE _Pragma("omp atomic update")
 #define OMP_ATOMIC_WRITE  _Pragma("omp atomic write")
+#define OMP_ATOMIC_READ   _Pragma("omp atomic read")
 #define OMP_HAVE_MIN_MAX_REDUCTION
 #else
 #define OMP_ATOMIC_UPDATE _Pragma("omp atomic")
 #define OMP_ATOMIC_WRITE  _Pragma("omp atomic")
+#define OMP_ATOMIC_READ   _Pragma("omp flush")
 #endif
 
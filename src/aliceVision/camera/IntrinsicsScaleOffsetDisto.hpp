@@ -27,6 +27,22 @@ public:
   , _pDistortion(distortion)
   {}
 
+  // the distortion is not shared by the copies (clone)
+  IntrinsicsScaleOffsetDisto(const IntrinsicsScaleOffsetDisto& other)
+  : IntrinsicsScaleOffset(other)
+  , _pDistortion(other._pDistortion ? other._pDistortion->clone() : nullptr)
+  {}
+
+  IntrinsicsScaleOffsetDisto& operator=(const IntrinsicsScaleOffsetDisto& other)
+  {
+    if(this != &other)
+    {
+      IntrinsicsScaleOffset::operator=(other);
+      _pDistortion.reset(other._pDistortion ? other._pDistortion->clone() : nullptr);
+    }
+    return *this;
+  }
+
   void assign(const IntrinsicBase& other) override
   {
     *this = dynamic_cast<const IntrinsicsScaleOffsetDisto&>(other);
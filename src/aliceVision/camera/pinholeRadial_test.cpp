@@ -98,3 +98,32 @@ BOOST_AUTO_TEST_CASE(cameraPinholeRadial_disto_undisto_K3)
 
   }
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Clone and copy a PinholeRadialK3 camera
+// - Update the distortion of the copies
+// - Assert that the distortion of the initial camera is unchanged
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraPinholeRadial_clone_distortion)
+{
+  const PinholeRadialK3 cam(1000, 1000, 1000, 500, 500,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  std::unique_ptr<PinholeRadialK3> clonedCam(cam.clone());
+  PinholeRadialK3 copiedCam(cam);
+  PinholeRadialK3 assignedCam;
+  assignedCam = cam;
+
+  const std::vector<double> distortionParams = {0.1, 0.2, 0.3};
+  clonedCam->setDistortionParams(distortionParams);
+  copiedCam.setDistortionParams(distortionParams);
+  assignedCam.setDistortionParams(distortionParams);
+
+  BOOST_CHECK_CLOSE(cam.getDistortionParams().at(0), -0.245539, 1e-6);
+  BOOST_CHECK_CLOSE(cam.getDistortionParams().at(1), 0.255195, 1e-6);
+  BOOST_CHECK_CLOSE(cam.getDistortionParams().at(2), 0.163773, 1e-6);
+  BOOST_CHECK_CLOSE(clonedCam->getDistortionParams().at(2), 0.3, 1e-6);
+}
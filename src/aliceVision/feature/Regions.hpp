@@ -14,6 +14,7 @@
 #include <aliceVision/feature/metric.hpp>
 
 #include <string>
+#include <vector>
 #include <cstddef>
 #include <typeinfo>
 #include <memory>
@@ -125,6 +126,10 @@ public:
   // - Binary: Hamming
   virtual double SquaredDescriptorDistance(std::size_t i, const Regions *, std::size_t j) const = 0;
 
+  /// Return the squared distances between the descriptor i and a batch of descriptors of another Regions container
+  // Same metric as SquaredDescriptorDistance, the Regions container is resolved once for the whole batch.
+  virtual void SquaredDescriptorDistances(std::size_t i, const Regions *, const std::vector<IndexT>& indexes, std::vector<double>& out_distances) const = 0;
+
   /// Add the Inth region to another Region container
   virtual void CopyRegion(std::size_t i, Regions *) const = 0;
 
@@ -238,6 +243,24 @@ public:
     return metric(this->_vec_descs[i].getData(), regionsT->_vec_descs[j].getData(), DescriptorT::static_size);
   }
 
+  // Return the distances between a descriptor and a batch of descriptors
+  void SquaredDescriptorDistances(std::size_t i, const Regions * genericRegions, const std::vector<IndexT>& indexes, std::vector<double>& out_distances) const override
+  {
+    assert(i < this->_vec_descs.size());
+    assert(genericRegions);
+
+    const This * regionsT = dynamic_cast<const This*>(genericRegions);
+    static typename SquaredMetric<T, regionType>::Metric metric;
+    const T* descriptor = this->_vec_descs[i].getData();
+
+    out_distances.resize(indexes.size());
+    for(std::size_t k = 0; k < indexes.size(); ++k)
+    {
+      assert(indexes[k] < regionsT->_vec_descs.size());
+      out_distances[k] = metric(descriptor, regionsT->_vec_descs[indexes[k]].getData(), DescriptorT::static_size);
+    }
+  }
+
   /**
    * @brief Add the Inth region to another Region container
    * @param[in] i: index of the region to copy
@@ -30,10 +30,10 @@ public:
   }
 
   template<class T>
-  T getRegions(feature::EImageDescriberType descType) { return dynamic_cast<T&>(*this->at(descType)); }
+  T& getRegions(feature::EImageDescriberType descType) { return dynamic_cast<T&>(*this->at(descType)); }
 
   template<class T>
-  const T getRegions(feature::EImageDescriberType descType) const { return dynamic_cast<const T&>(*this->at(descType)); }
+  const T& getRegions(feature::EImageDescriberType descType) const { return dynamic_cast<const T&>(*this->at(descType)); }
 };
 
 using MapRegionsPerView = std::map<IndexT, MapRegionsPerDesc>;
@@ -15,6 +15,7 @@
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
 #include <aliceVision/system/Logger.hpp>
 #include <xmmintrin.h>
+#include <emmintrin.h>
 #endif
 
 #include <cstddef>
@@ -119,6 +120,36 @@ namespace optim_ss2{
       return 0.0f;
     }
   }
+
+  // Euclidean distance (SSE2 method) (squared result)
+  // The sums are computed on integers, so the result is the same as the scalar version.
+  inline float l2_sse(const unsigned char * b1, const unsigned char * b2, int size)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i cumSum = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 16 <= size; i += 16)
+    {
+      const __m128i srcA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + i));
+      const __m128i srcB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + i));
+      //-- Subtract (on 16 bits)
+      const __m128i diffLo = _mm_sub_epi16(_mm_unpacklo_epi8(srcA, zero), _mm_unpacklo_epi8(srcB, zero));
+      const __m128i diffHi = _mm_sub_epi16(_mm_unpackhi_epi8(srcA, zero), _mm_unpackhi_epi8(srcB, zero));
+      //-- Multiply and sum pairs (on 32 bits)
+      cumSum = _mm_add_epi32(cumSum, _mm_madd_epi16(diffLo, diffLo));
+      cumSum = _mm_add_epi32(cumSum, _mm_madd_epi16(diffHi, diffHi));
+    }
+    int res[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(res), cumSum);
+    int result = res[0] + res[1] + res[2] + res[3];
+    //-- Process the last elements
+    for(; i < size; ++i)
+    {
+      const int diff = int(b1[i]) - int(b2[i]);
+      result += diff * diff;
+    }
+    return static_cast<float>(result);
+  }
 } // namespace optim_ss2
 
 // Template specification to run SSE L2 squared distance
@@ -136,6 +167,21 @@ struct L2_Vectorized<float>
   }
 };
 
+// Template specification to run SSE2 L2 squared distance
+//  on unsigned char vector
+template<>
+struct L2_Vectorized<unsigned char>
+{
+  typedef unsigned char ElementType;
+  typedef Accumulator<unsigned char>::Type ResultType;
+
+  template <typename Iterator1, typename Iterator2>
+  inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
+  {
+    return optim_ss2::l2_sse(a,b,size);
+  }
+};
+
 #endif // ALICEVISION_HAVE_SSE
 
 }  // namespace feature
@@ -8,7 +8,9 @@
 #include <aliceVision/feature/metric.hpp>
 
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 
@@ -46,6 +48,30 @@ BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized)
   BOOST_CHECK_EQUAL(168, DistanceT<L2_Vectorized<double> >());
 }
 
+BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized_UnsignedChar)
+{
+  // SIFT descriptors size and a size with remaining elements
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  for(const std::size_t size : {128, 37})
+  {
+    std::vector<unsigned char> array1(size);
+    std::vector<unsigned char> array2(size);
+
+    for(int trial = 0; trial < 100; ++trial)
+    {
+      for(std::size_t i = 0; i < size; ++i)
+      {
+        array1[i] = static_cast<unsigned char>(distribution(generator));
+        array2[i] = static_cast<unsigned char>(trial == 0 ? 255 - array1[i] : distribution(generator));
+      }
+      BOOST_CHECK_EQUAL(L2_Simple<unsigned char>()(array1.data(), array2.data(), size),
+                        L2_Vectorized<unsigned char>()(array1.data(), array2.data(), size));
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET)
 {
   std::bitset<8> a(std::string("01010101"));
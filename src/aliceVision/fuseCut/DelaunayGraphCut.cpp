@@ -28,6 +28,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <random>
 #include <stdexcept>
 
@@ -267,8 +270,23 @@ void removeInvalidPoints(std::vector<Point3d>& verticesCoordsPrepare, std::vecto
     verticesAttrPrepare.swap(verticesAttrTmp);
 }
 
+/// Lock-free accumulation of a double value
+inline void atomicAdd(std::atomic<double>& value, double increment)
+{
+    double current = value.load(std::memory_order_relaxed);
+    while(!value.compare_exchange_weak(current, current + increment, std::memory_order_relaxed))
+        ;
+}
+
+/**
+ * @brief Declare the visibilities of the vertices from the depth maps and refine their positions.
+ *
+ * Each depth map is streamed by a single thread and each depth value votes for its nearest vertex.
+ * The vertices positions are frozen during the votes: the contributions are accumulated with atomic operations
+ * and the visibilities are gathered per camera, then transposed in CSR form (vertex to cameras). No lock is needed.
+ */
 void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare,
-                                    std::vector<GC_vertexInfo>& verticesAttrPrepare, mvsUtils::MultiViewParams* mp, float simFactor, float voteMarginFactor, float contributeMarginFactor, float simGaussianSize)
+                                    std::vector<GC_vertexInfo>& verticesAttrPrepare, mvsUtils::MultiViewParams* mp, float voteMarginFactor, float contributeMarginFactor)
 {
 #ifdef USE_GEOGRAM_KDTREE
     GEO::AdaptiveKdTree kdTree(3);
@@ -280,23 +298,34 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
     kdTree.buildIndex();
     ALICEVISION_LOG_INFO("NANOFLANN: KdTree created.");
 #endif
-    // TODO FACA: update into new data structures
-    // std::vector<Point3d> newVerticesCoordsPrepare(verticesCoordsPrepare.size());
-    // std::vector<float> newSimScorePrepare(simScorePrepare.size());
-    // std::vector<double> newPixSizePrepare(pixSizePrepare.size());
-    std::vector<omp_lock_t> locks(verticesCoordsPrepare.size());
-    for (auto& lock: locks)
-        omp_init_lock(&lock);
-
-    omp_set_nested(1);
-    #pragma omp parallel for num_threads(3)
-    for(int c = 0; c < cams.size(); ++c)
+    const int nbVertices = verticesCoordsPrepare.size();
+
+    // sum and number of the contributions to the position of each vertex
+    std::vector<std::atomic<double>> contribSums(3 * std::size_t(nbVertices));
+    std::vector<std::atomic<int>> contribCounts(nbVertices);
+    #pragma omp parallel for
+    for(int vi = 0; vi < nbVertices; ++vi)
+    {
+        contribSums[3 * std::size_t(vi)].store(0.0, std::memory_order_relaxed);
+        contribSums[3 * std::size_t(vi) + 1].store(0.0, std::memory_order_relaxed);
+        contribSums[3 * std::size_t(vi) + 2].store(0.0, std::memory_order_relaxed);
+        contribCounts[vi].store(0, std::memory_order_relaxed);
+    }
+
+    // vertices seen by each camera
+    std::vector<std::vector<int>> camsVertices(cams.size());
+
+    #pragma omp parallel
     {
-        ALICEVISION_LOG_INFO("Create visibilities (" << c << "/" << cams.size() << ")");
-        std::vector<float> depthMap;
-        std::vector<float> simMap;
-        int width, height;
+        // vertices already seen by the current camera of the thread
+        std::vector<bool> seen(nbVertices, false);
+
+        #pragma omp for schedule(dynamic)
+        for(int ci = 0; ci < cams.size(); ++ci)
         {
+            const int c = cams[ci];
+            std::vector<float> depthMap;
+            int width, height;
             const std::string depthMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::depthMap, 0);
             imageIO::readImage(depthMapFilepath, width, height, depthMap, imageIO::EImageColorSpace::NO_CONVERSION);
             if(depthMap.empty())
@@ -304,107 +333,114 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
                 ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
                 continue;
             }
-            int wTmp, hTmp;
-            const std::string simMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::simMap, 0);
-            // If we have a simMap in input use it,
-            // else init with a constant value.
-            if(boost::filesystem::exists(simMapFilepath))
-            {
-                imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap, imageIO::EImageColorSpace::NO_CONVERSION);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Similarity map size doesn't match the depth map size: " + simMapFilepath +
-                                             ", " + depthMapFilepath);
-                {
-                    std::vector<float> simMapTmp(simMap.size());
-                    imageAlgo::convolveImage(width, height, simMap, simMapTmp, "gaussian", simGaussianSize,
-                                             simGaussianSize);
-                    simMap.swap(simMapTmp);
-                }
-            }
-            else
-            {
-                ALICEVISION_LOG_WARNING("simMap file can't be found.");
-                simMap.resize(width * height, -1);
-            }
 
-        }
-        // Add visibility
-        #pragma omp parallel for
-        for(int y = 0; y < height; ++y)
-        {
-            for(int x = 0; x < width; ++x)
+            std::vector<int>& camVertices = camsVertices[ci];
+            for(int y = 0; y < height; ++y)
             {
-                const std::size_t index = y * width + x;
-                const float depth = depthMap[index];
-                if(depth <= 0.0f)
-                    continue;
+                for(int x = 0; x < width; ++x)
+                {
+                    const std::size_t index = y * width + x;
+                    const float depth = depthMap[index];
+                    if(depth <= 0.0f)
+                        continue;
 
-                const Point3d p = mp->backproject(c, Point2d(x, y), depth);
-                const double pixSize = mp->getCamPixelSize(p, c);
+                    const Point3d p = mp->backproject(c, Point2d(x, y), depth);
+                    const double pixSize = mp->getCamPixelSize(p, c);
 #ifdef USE_GEOGRAM_KDTREE
-                const std::size_t nearestVertexIndex = kdTree.get_nearest_neighbor(p.m);
-                // NOTE: Could compute the distance between the line (camera to pixel) and the nearestVertex OR
-                //       the distance between the back-projected point and the nearestVertex
-                const double dist = (p - verticesCoordsPrepare[nearestVertexIndex]).size2();
+                    const std::size_t nearestVertexIndex = kdTree.get_nearest_neighbor(p.m);
+                    // NOTE: Could compute the distance between the line (camera to pixel) and the nearestVertex OR
+                    //       the distance between the back-projected point and the nearestVertex
+                    const double dist = (p - verticesCoordsPrepare[nearestVertexIndex]).size2();
 #else
-                nanoflann::KNNResultSet<double, std::size_t> resultSet(1);
-                std::size_t nearestVertexIndex = std::numeric_limits<std::size_t>::max();
-                double dist = std::numeric_limits<double>::max();
-                resultSet.init(&nearestVertexIndex, &dist);
-                if(!kdTree.findNeighbors(resultSet, p.m, nanoflann::SearchParams()))
-                {
-                    ALICEVISION_LOG_TRACE("Failed to find Neighbors.");
-                    continue;
-                }
+                    nanoflann::KNNResultSet<double, std::size_t> resultSet(1);
+                    std::size_t nearestVertexIndex = std::numeric_limits<std::size_t>::max();
+                    double dist = std::numeric_limits<double>::max();
+                    resultSet.init(&nearestVertexIndex, &dist);
+                    if(!kdTree.findNeighbors(resultSet, p.m, nanoflann::SearchParams()))
+                    {
+                        ALICEVISION_LOG_TRACE("Failed to find Neighbors.");
+                        continue;
+                    }
 #endif
-                const float pixSizeScoreI = simScorePrepare[nearestVertexIndex] * pixSize * pixSize;
-                const float pixSizeScoreV = simScorePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex];
+                    const float pixSizeScoreI = simScorePrepare[nearestVertexIndex] * pixSize * pixSize;
+                    const float pixSizeScoreV = simScorePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex] * pixSizePrepare[nearestVertexIndex];
 
-                if(dist < voteMarginFactor * std::max(pixSizeScoreI, pixSizeScoreV))
-                {
-                    GC_vertexInfo& va = verticesAttrPrepare[nearestVertexIndex];
-                    Point3d& vc = verticesCoordsPrepare[nearestVertexIndex];
-                    const float simValue = simMap[index];
-                    // remap similarity values from [-1;+1] to [+1;+simFactor]
-                    // interpretation is [goodSimilarity;badSimilarity]
-                    const float simScore = simValue < -1.0f ? 1.0f : 1.0f + (1.0f + simValue) * simFactor;
-
-                    // Custom locks to limit it to the index: nearestVertexIndex
-                    // to avoid using "omp critical"
-                    omp_lock_t* lock = &locks[nearestVertexIndex];
-                    omp_set_lock(lock);
+                    if(dist >= voteMarginFactor * std::max(pixSizeScoreI, pixSizeScoreV))
+                        continue;
+
+                    if(!seen[nearestVertexIndex])
                     {
-                        va.cams.push_back_distinct(c);
-                        if(dist < contributeMarginFactor * pixSizeScoreV)
-                        {
-                            vc = (vc * (double)va.nrc + p) / double(va.nrc + 1);
-//                            newVerticesCoordsPrepare[nearestVertexIndex] = (newVerticesCoordsPrepare[nearestVertexIndex] * double(va.nrc) + p) / double(va.nrc + 1);
-//                            newSimScorePrepare[nearestVertexIndex] = (newSimScorePrepare[nearestVertexIndex] * float(va.nrc) + simScore) / float(va.nrc + 1);
-//                            newPixSizePrepare[nearestVertexIndex] = (newPixSizePrepare[nearestVertexIndex] * double(va.nrc) + pixSize) / double(va.nrc + 1);
-                            va.nrc += 1;
-                        }
+                        seen[nearestVertexIndex] = true;
+                        camVertices.push_back(nearestVertexIndex);
+                    }
+                    if(dist < contributeMarginFactor * pixSizeScoreV)
+                    {
+                        atomicAdd(contribSums[3 * nearestVertexIndex], p.x);
+                        atomicAdd(contribSums[3 * nearestVertexIndex + 1], p.y);
+                        atomicAdd(contribSums[3 * nearestVertexIndex + 2], p.z);
+                        contribCounts[nearestVertexIndex].fetch_add(1, std::memory_order_relaxed);
                     }
-                    omp_unset_lock(lock);
                 }
             }
+            for(int vi: camVertices)
+                seen[vi] = false;
+            ALICEVISION_LOG_INFO("Create visibilities (" << ci << "/" << cams.size() << "): " << camVertices.size() << " vertices seen.");
         }
     }
-    omp_set_nested(0);
 
-    for(auto& lock: locks)
-        omp_destroy_lock(&lock);
+    // transpose the visibilities in CSR form, the cameras of each vertex are in the order of the input cameras
+    std::vector<std::size_t> visOffsets(nbVertices + 1, 0);
+    for(const std::vector<int>& camVertices: camsVertices)
+    {
+        for(int vi: camVertices)
+            ++visOffsets[vi + 1];
+    }
+    for(int vi = 0; vi < nbVertices; ++vi)
+        visOffsets[vi + 1] += visOffsets[vi];
 
-    // compute pixSize
+    std::vector<int> visCams(visOffsets.back());
+    {
+        std::vector<std::size_t> cursors(visOffsets.begin(), visOffsets.end() - 1);
+        for(int ci = 0; ci < cams.size(); ++ci)
+        {
+            for(int vi: camsVertices[ci])
+                visCams[cursors[vi]++] = cams[ci];
+            std::vector<int>().swap(camsVertices[ci]);
+        }
+    }
+
+    // update the vertices: visibilities, positions (mean of the contributions) and pixSize
     #pragma omp parallel for
-    for(int vi = 0; vi < verticesAttrPrepare.size(); ++vi)
+    for(int vi = 0; vi < nbVertices; ++vi)
     {
-        GC_vertexInfo& v = verticesAttrPrepare[vi];
-        v.pixSize = mp->getCamsMinPixelSize(verticesCoordsPrepare[vi], v.cams);
+        GC_vertexInfo& va = verticesAttrPrepare[vi];
+        Point3d& vc = verticesCoordsPrepare[vi];
+
+        const auto visBegin = visCams.begin() + visOffsets[vi];
+        const auto visEnd = visCams.begin() + visOffsets[vi + 1];
+        if(va.cams.empty())
+        {
+            va.cams.getDataWritable().assign(visBegin, visEnd);
+        }
+        else
+        {
+            va.cams.reserveAdd(visEnd - visBegin);
+            for(auto it = visBegin; it != visEnd; ++it)
+                va.cams.push_back_distinct(*it);
+        }
+
+        const int nbContribs = contribCounts[vi].load(std::memory_order_relaxed);
+        if(nbContribs > 0)
+        {
+            const Point3d contribSum(contribSums[3 * std::size_t(vi)].load(std::memory_order_relaxed),
+                                     contribSums[3 * std::size_t(vi) + 1].load(std::memory_order_relaxed),
+                                     contribSums[3 * std::size_t(vi) + 2].load(std::memory_order_relaxed));
+            vc = (vc * double(va.nrc) + contribSum) / double(va.nrc + nbContribs);
+            va.nrc += nbContribs;
+        }
+        va.pixSize = mp->getCamsMinPixelSize(vc, va.cams);
     }
 
-//    verticesCoordsPrepare.swap(newVerticesCoordsPrepare);
-//    simScorePrepare.swap(newSimScorePrepare);
-//    pixSizePrepare.swap(newPixSizePrepare);
     ALICEVISION_LOG_INFO("Visibilities created.");
 }
 
@@ -946,8 +982,9 @@ void DelaunayGraphCut::addMaskHelperPoints(const Point3d voxel[8], const StaticV
 
     ALICEVISION_LOG_INFO("Load depth maps and add points.");
     {
-        for(int c = 0; c < cams.size(); c++)
+        for(int ci = 0; ci < cams.size(); ci++)
         {
+            const int c = cams[ci];
             std::vector<float> depthMap;
             int width, height;
             {
@@ -1059,17 +1096,10 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     }
     int step = std::floor(std::sqrt(double(nbPixels) / double(params.maxInputPoints)));
     step = std::max(step, params.minStep);
-    std::size_t realMaxVertices = 0;
-    std::vector<int> startIndex(mp->getNbCameras(), 0);
-    for(int i = 0; i < mp->getNbCameras(); ++i)
-    {
-        const auto& imgParams = mp->getImageParams(i);
-        startIndex[i] = realMaxVertices;
-        realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
-    }
-    std::vector<Point3d> verticesCoordsPrepare(realMaxVertices);
-    std::vector<double> pixSizePrepare(realMaxVertices);
-    std::vector<float> simScorePrepare(realMaxVertices);
+    // filled with the valid points of all the depth maps, once their number is known
+    std::vector<Point3d> verticesCoordsPrepare;
+    std::vector<double> pixSizePrepare;
+    std::vector<float> simScorePrepare;
 
     // counter for points filtered based on the number of observations (minVis)
     int minVisCounter = 0;
@@ -1078,15 +1108,20 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     ALICEVISION_LOG_INFO("nbPixels: " << nbPixels);
     ALICEVISION_LOG_INFO("maxVertices: " << params.maxPoints);
     ALICEVISION_LOG_INFO("step: " << step);
-    ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
     ALICEVISION_LOG_INFO("minVis: " << params.minVis);
 
     ALICEVISION_LOG_INFO("Load depth maps and add points.");
     {
-        omp_set_nested(1);
-        #pragma omp parallel for num_threads(3)
-        for(int c = 0; c < cams.size(); c++)
+        // Each depth map is streamed by a single thread, only the valid points are kept.
+        // They are concatenated in the order of the input cameras.
+        std::vector<std::vector<Point3d>> camsVerticesCoords(cams.size());
+        std::vector<std::vector<double>> camsPixSize(cams.size());
+        std::vector<std::vector<float>> camsSimScore(cams.size());
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int ci = 0; ci < cams.size(); ci++)
         {
+            const int c = cams[ci];
             std::vector<float> depthMap;
             std::vector<float> simMap;
             std::vector<unsigned char> numOfModalsMap;
@@ -1137,14 +1172,16 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
                 }
             }
 
+            std::vector<Point3d>& camVerticesCoords = camsVerticesCoords[ci];
+            std::vector<double>& camPixSize = camsPixSize[ci];
+            std::vector<float>& camSimScore = camsSimScore[ci];
+
             int syMax = std::ceil(height/step);
             int sxMax = std::ceil(width/step);
-            #pragma omp parallel for
             for(int sy = 0; sy < syMax; ++sy)
             {
                 for(int sx = 0; sx < sxMax; ++sx)
                 {
-                    int index = startIndex[c] + sy * sxMax + sx;
                     float bestDepth = std::numeric_limits<float>::max();
                     float bestScore = 0;
                     float bestSimScore = 0;
@@ -1190,34 +1227,43 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
                             }
                         }
                     }
+                    // discard the point if the score is too low
                     if(bestScore < 3*13)
+                        continue;
+
+                    const Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
+
+                    // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
+                    if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel))
                     {
-                        // discard the point
-                        pixSizePrepare[index] = -1.0;
-                    }
-                    else
-                    {
-                        Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
-                        
-                        // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
-                        if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel)) 
-                        {
-                            verticesCoordsPrepare[index] = p;
-                            simScorePrepare[index] = bestSimScore;
-                            pixSizePrepare[index] = mp->getCamPixelSize(p, c);
-                        }
-                        else
-                        {
-                            // discard the point
-                            // verticesCoordsPrepare[index] = p;
-                            pixSizePrepare[index] = -1.0;
-                        }
+                        camVerticesCoords.push_back(p);
+                        camSimScore.push_back(bestSimScore);
+                        camPixSize.push_back(mp->getCamPixelSize(p, c));
                     }
                 }
             }
         }
-        omp_set_nested(0);
+
+        std::size_t nbVertices = 0;
+        for(const std::vector<Point3d>& camVerticesCoords: camsVerticesCoords)
+            nbVertices += camVerticesCoords.size();
+
+        verticesCoordsPrepare.reserve(nbVertices);
+        pixSizePrepare.reserve(nbVertices);
+        simScorePrepare.reserve(nbVertices);
+        for(int ci = 0; ci < cams.size(); ++ci)
+        {
+            verticesCoordsPrepare.insert(verticesCoordsPrepare.end(), camsVerticesCoords[ci].begin(), camsVerticesCoords[ci].end());
+            pixSizePrepare.insert(pixSizePrepare.end(), camsPixSize[ci].begin(), camsPixSize[ci].end());
+            simScorePrepare.insert(simScorePrepare.end(), camsSimScore[ci].begin(), camsSimScore[ci].end());
+            std::vector<Point3d>().swap(camsVerticesCoords[ci]);
+            std::vector<double>().swap(camsPixSize[ci]);
+            std::vector<float>().swap(camsSimScore[ci]);
+        }
     }
+    ALICEVISION_LOG_INFO(verticesCoordsPrepare.size() << " valid points loaded from the depth maps.");
+    if(verticesCoordsPrepare.empty())
+        throw std::runtime_error("Depth map fusion gives an empty result.");
 
     ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
 
@@ -1233,7 +1279,7 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     // Compute the vertices positions and simScore from all input depthMap/simMap images,
     // and declare the visibility information (the cameras indexes seeing the vertex).
     createVerticesWithVisibilities(cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
-                                   verticesAttrPrepare, mp, params.simFactor, params.voteMarginFactor, params.contributeMarginFactor, params.simGaussianSize);
+                                   verticesAttrPrepare, mp, params.voteMarginFactor, params.contributeMarginFactor);
 
     ALICEVISION_LOG_INFO("Compute max angle per point");
 
@@ -1335,7 +1381,7 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
         ALICEVISION_LOG_INFO("Create final visibilities");
         // Initialize the vertice attributes and declare the visibility information
         createVerticesWithVisibilities(cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
-                                       verticesAttrPrepare, mp, params.simFactor, params.voteMarginFactor, params.contributeMarginFactor, params.simGaussianSize);
+                                       verticesAttrPrepare, mp, params.voteMarginFactor, params.contributeMarginFactor);
     }
 
     if(verticesCoordsPrepare.empty())
@@ -1489,6 +1535,11 @@ DelaunayGraphCut::intersectNextGeom(const DelaunayGraphCut::GeometryIntersection
     {
         const CellIndex tetrahedronIndex = inGeometry.facet.cellIndex;
 
+        const Point3d* cellPoints[4];
+        for (int k = 0; k < 4; ++k)
+            cellPoints[k] = &_verticesCoords[_tetrahedralization->cell_vertex(tetrahedronIndex, k)];
+        const TetrahedronRayIntersections facetsIntersections(cellPoints, originPt, dirVect);
+
         // Test all facets of the tetrahedron using i as localVertexIndex to define next intersectionFacet
         for (int i = 0; i < 4; ++i)
         {
@@ -1499,7 +1550,9 @@ DelaunayGraphCut::intersectNextGeom(const DelaunayGraphCut::GeometryIntersection
             const Facet intersectionFacet(tetrahedronIndex, i);
             bool ambiguous = false;
 
-            const GeometryIntersection result = rayIntersectTriangle(originPt, dirVect, intersectionFacet, intersectPt, epsilonFactor, ambiguous, &lastIntersectPt);
+            const GeometryIntersection result = classifyTriangleIntersection(intersectionFacet, facetsIntersections.getIntersectPt(i),
+                facetsIntersections.u[i], facetsIntersections.v[i], facetsIntersections.minEdgeSize[i] * epsilonFactor,
+                facetsIntersections.meanEdgeSize[i] * 1.0e-2, dirVect, intersectPt, ambiguous, &lastIntersectPt);
             if (result.type != EGeometryType::None)
             {
                 if (!ambiguous)
@@ -1610,8 +1663,6 @@ DelaunayGraphCut::GeometryIntersection DelaunayGraphCut::rayIntersectTriangle(co
     Point3d& intersectPt,
     const double epsilonFactor, bool &ambiguous, const Point3d* lastIntersectPt) const
 {
-    ambiguous = false;
-
     const VertexIndex AvertexIndex = getVertexIndex(facet, 0);
     const VertexIndex BvertexIndex = getVertexIndex(facet, 1);
     const VertexIndex CvertexIndex = getVertexIndex(facet, 2);
@@ -1630,16 +1681,25 @@ DelaunayGraphCut::GeometryIntersection DelaunayGraphCut::rayIntersectTriangle(co
     Point3d tempIntersectPt;
     const Point2d triangleUv = getLineTriangleIntersectBarycCoords(&tempIntersectPt, A, B, C, &originPt, &DirVec);
 
-    if (!isnormal(tempIntersectPt.x) || !isnormal(tempIntersectPt.y) || !isnormal(tempIntersectPt.z))
+    return classifyTriangleIntersection(facet, tempIntersectPt, triangleUv.x, triangleUv.y, marginEpsilon, ambiguityEpsilon,
+                                        DirVec, intersectPt, ambiguous, lastIntersectPt);
+}
+
+DelaunayGraphCut::GeometryIntersection DelaunayGraphCut::classifyTriangleIntersection(const DelaunayGraphCut::Facet& facet,
+    const Point3d& planeIntersectPt, double u, double v,
+    const double marginEpsilon, const double ambiguityEpsilon,
+    const Point3d& DirVec, Point3d& intersectPt, bool& ambiguous, const Point3d* lastIntersectPt) const
+{
+    ambiguous = false;
+
+    if (!isnormal(planeIntersectPt.x) || !isnormal(planeIntersectPt.y) || !isnormal(planeIntersectPt.z))
     {
         // This is not suppose to happen in real life, we log a warning instead of raising an exeption if we face a border case
         // ALICEVISION_LOG_WARNING("Invalid/notNormal intersection point found during rayIntersectTriangle.");
         return GeometryIntersection();
     }
 
-    const double u = triangleUv.x; // A to C
-    const double v = triangleUv.y; // A to B
-
+    // u: A to C, v: A to B
     // If we find invalid uv coordinate
     if (!std::isfinite(u) || !std::isfinite(v))
         return GeometryIntersection();
@@ -1652,7 +1712,7 @@ DelaunayGraphCut::GeometryIntersection DelaunayGraphCut::rayIntersectTriangle(co
     // in the DirVec direction to ensure that we are moving forward in the right direction
     if (lastIntersectPt != nullptr)
     {
-        const Point3d diff = tempIntersectPt - *lastIntersectPt;
+        const Point3d diff = planeIntersectPt - *lastIntersectPt;
         const double dotValue = dot(DirVec, diff.normalize());
         if(dotValue < marginEpsilon || diff.size() < 100 * std::numeric_limits<double>::min())
         {
@@ -1665,8 +1725,15 @@ DelaunayGraphCut::GeometryIntersection DelaunayGraphCut::rayIntersectTriangle(co
         }
     }
 
-    // Change intersection point only if tempIntersectionPt is in the right direction (mean we intersect something)
-    intersectPt = tempIntersectPt;
+    // Change intersection point only if planeIntersectPt is in the right direction (mean we intersect something)
+    intersectPt = planeIntersectPt;
+
+    const VertexIndex AvertexIndex = getVertexIndex(facet, 0);
+    const VertexIndex BvertexIndex = getVertexIndex(facet, 1);
+    const VertexIndex CvertexIndex = getVertexIndex(facet, 2);
+    const Point3d* A = &_verticesCoords[AvertexIndex];
+    const Point3d* B = &_verticesCoords[BvertexIndex];
+    const Point3d* C = &_verticesCoords[CvertexIndex];
 
     if (v < marginEpsilon) // along A C edge
     {
@@ -1837,6 +1904,136 @@ float DelaunayGraphCut::weightFcn(float nrc, bool labatutWeights, int  /*ncams*/
     return weight;
 }
 
+/**
+ * @brief Statistics on the rays walks through the tetrahedralization: number of steps and time per ray.
+ */
+struct RayWalkStats
+{
+    std::size_t nbRays = 0;
+    std::size_t nbStepsFront = 0;
+    std::size_t nbStepsBehind = 0;
+    int maxStepsFront = 0;
+    int maxStepsBehind = 0;
+    /// time spent in the rays walks (in seconds, summed over the threads)
+    double duration = 0.0;
+    double maxDuration = 0.0;
+
+    void add(int stepsFront, int stepsBehind, double rayDuration)
+    {
+        ++nbRays;
+        nbStepsFront += stepsFront;
+        nbStepsBehind += stepsBehind;
+        maxStepsFront = std::max(maxStepsFront, stepsFront);
+        maxStepsBehind = std::max(maxStepsBehind, stepsBehind);
+        duration += rayDuration;
+        maxDuration = std::max(maxDuration, rayDuration);
+    }
+
+    RayWalkStats& operator+=(const RayWalkStats& other)
+    {
+        nbRays += other.nbRays;
+        nbStepsFront += other.nbStepsFront;
+        nbStepsBehind += other.nbStepsBehind;
+        maxStepsFront = std::max(maxStepsFront, other.maxStepsFront);
+        maxStepsBehind = std::max(maxStepsBehind, other.maxStepsBehind);
+        duration += other.duration;
+        maxDuration = std::max(maxDuration, other.maxDuration);
+        return *this;
+    }
+
+    void log(const std::string& name, double wallDuration) const
+    {
+        if(nbRays == 0)
+            return;
+        ALICEVISION_LOG_INFO(name << ": " << nbRays << " rays in " << wallDuration << " s (" << nbRays / wallDuration << " rays/s)." << std::endl
+                             << "\t- steps per ray in front of the point: " << nbStepsFront / double(nbRays) << " (max: " << maxStepsFront << ")" << std::endl
+                             << "\t- steps per ray behind the point: " << nbStepsBehind / double(nbRays) << " (max: " << maxStepsBehind << ")" << std::endl
+                             << "\t- time per ray: " << duration / nbRays * 1.0e6 << " us (max: " << maxDuration * 1.0e6 << " us)");
+    }
+};
+
+inline double getElapsedSeconds(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Spread the 16 lower bits of x on the even bits
+inline std::uint32_t spreadBits16(std::uint32_t x)
+{
+    x &= 0x0000FFFF;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+/**
+ * @brief Morton code of a direction, from its octahedral mapping quantized on 16 bits per axis.
+ * Close directions have close codes (except across the octahedron folds).
+ */
+std::uint32_t getDirectionMortonCode(const Point3d& dir)
+{
+    const double norm1 = std::abs(dir.x) + std::abs(dir.y) + std::abs(dir.z);
+    if(norm1 <= 0.0)
+        return 0;
+    double u = dir.x / norm1;
+    double v = dir.y / norm1;
+    if(dir.z < 0.0)
+    {
+        const double uFolded = (1.0 - std::abs(v)) * (u >= 0.0 ? 1.0 : -1.0);
+        v = (1.0 - std::abs(u)) * (v >= 0.0 ? 1.0 : -1.0);
+        u = uFolded;
+    }
+    const std::uint32_t qu = std::uint32_t(std::min(65535.0, std::max(0.0, (u + 1.0) * 32768.0)));
+    const std::uint32_t qv = std::uint32_t(std::min(65535.0, std::max(0.0, (v + 1.0) * 32768.0)));
+    return spreadBits16(qu) | (spreadBits16(qv) << 1);
+}
+
+std::vector<DelaunayGraphCut::VisibilityRay> DelaunayGraphCut::getSortedVisibilityRays() const
+{
+    // group the rays by camera (CSR)
+    std::vector<std::size_t> camsOffsets(mp->ncams + 1, 0);
+    for(const GC_vertexInfo& v: _verticesAttr)
+    {
+        for(const int cam: v.cams)
+            ++camsOffsets[cam + 1];
+    }
+    for(int cam = 0; cam < mp->ncams; ++cam)
+        camsOffsets[cam + 1] += camsOffsets[cam];
+
+    std::vector<VisibilityRay> rays(camsOffsets.back());
+    {
+        std::vector<std::size_t> cursors(camsOffsets.begin(), camsOffsets.end() - 1);
+        for(VertexIndex vi = 0; vi < _verticesAttr.size(); ++vi)
+        {
+            for(const int cam: _verticesAttr[vi].cams)
+            {
+                VisibilityRay& ray = rays[cursors[cam]++];
+                ray.vertexIndex = vi;
+                ray.cam = cam;
+            }
+        }
+    }
+
+    // sort the rays of each camera by direction
+    #pragma omp parallel for schedule(dynamic)
+    for(int cam = 0; cam < mp->ncams; ++cam)
+    {
+        std::vector<std::pair<std::uint32_t, VertexIndex>> camRays;
+        camRays.reserve(camsOffsets[cam + 1] - camsOffsets[cam]);
+        for(std::size_t i = camsOffsets[cam]; i < camsOffsets[cam + 1]; ++i)
+        {
+            const VertexIndex vi = rays[i].vertexIndex;
+            camRays.emplace_back(getDirectionMortonCode(_verticesCoords[vi] - mp->CArr[cam]), vi);
+        }
+        std::sort(camRays.begin(), camRays.end());
+        for(std::size_t i = 0; i < camRays.size(); ++i)
+            rays[camsOffsets[cam] + i].vertexIndex = camRays[i].second;
+    }
+    return rays;
+}
+
 void DelaunayGraphCut::fillGraph(double nPixelSizeBehind, bool labatutWeights, bool fillOut, float distFcnHeight,
                                  float fullWeight) // nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0
                                                       // labatutWeights=0 fillOut=1 distFcnHeight=0
@@ -1858,87 +2055,76 @@ void DelaunayGraphCut::fillGraph(double nPixelSizeBehind, bool labatutWeights, b
         }
     }
 
-    // choose random order to prevent waiting
-    const unsigned int seed = (unsigned int)mp->userParams.get<unsigned int>("delaunaycut.seed", 0);
-    const std::vector<int> verticesRandIds = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size(), seed);
-
-    int64_t totalStepsFront = 0;
-    int64_t totalRayFront = 0;
-    int64_t totalStepsBehind = 0;
-    int64_t totalRayBehind = 0;
-
-    size_t totalCamHaveVisibilityOnVertex = 0;
-    size_t totalOfVertex = 0;
+    // rays sorted by camera and direction: consecutive rays go through the same cells
+    const std::vector<VisibilityRay> rays = getSortedVisibilityRays();
 
     size_t totalIsRealNrc = 0;
-    
+    for(const GC_vertexInfo& v: _verticesAttr)
+    {
+        if(v.isReal())
+            ++totalIsRealNrc;
+    }
+    const size_t totalCamHaveVisibilityOnVertex = rays.size();
+
+    RayWalkStats totalRayWalkStats;
     GeometriesCount totalGeometriesIntersectedFrontCount;
     GeometriesCount totalGeometriesIntersectedBehindCount;
 
-    boost::progress_display progressBar(std::min(size_t(100), verticesRandIds.size()), std::cout, "fillGraphPartPtRc\n");
-    size_t progressStep = verticesRandIds.size() / 100;
+    const auto startTime = std::chrono::steady_clock::now();
+    boost::progress_display progressBar(std::min(size_t(100), rays.size()), std::cout, "fillGraphPartPtRc\n");
+    size_t progressStep = rays.size() / 100;
     progressStep = std::max(size_t(1), progressStep);
-#pragma omp parallel for reduction(+:totalStepsFront,totalRayFront,totalStepsBehind,totalRayBehind,totalCamHaveVisibilityOnVertex,totalOfVertex,totalIsRealNrc)
-    for(int i = 0; i < verticesRandIds.size(); i++)
+#pragma omp parallel
     {
-        if(i % progressStep == 0)
+        // per thread statistics, merged at the end
+        RayWalkStats rayWalkStats;
+        GeometriesCount geometriesIntersectedFrontCount;
+        GeometriesCount geometriesIntersectedBehindCount;
+
+#pragma omp for schedule(dynamic, 256)
+        for(int i = 0; i < rays.size(); i++)
         {
+            if(i % progressStep == 0)
+            {
 #pragma omp critical
-            ++progressBar;
-        }
+                ++progressBar;
+            }
 
-        const int vertexIndex = verticesRandIds[i];
-        const GC_vertexInfo& v = _verticesAttr[vertexIndex];
+            const VisibilityRay& ray = rays[i];
+            const GC_vertexInfo& v = _verticesAttr[ray.vertexIndex];
+            assert(ray.cam >= 0);
+            assert(ray.cam < mp->ncams);
 
-        if(v.isReal())
-        {
-            ++totalIsRealNrc;
             // "weight" is called alpha(p) in the paper
             const float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
 
-            for(int c = 0; c < v.cams.size(); c++)
-            {
-                assert(v.cams[c] >= 0);
-                assert(v.cams[c] < mp->ncams);
-
-                int stepsFront = 0;
-                int stepsBehind = 0;
-                GeometriesCount geometriesIntersectedFrontCount;
-                GeometriesCount geometriesIntersectedBehindCount;
-                fillGraphPartPtRc(stepsFront, stepsBehind, geometriesIntersectedFrontCount,
-                                  geometriesIntersectedBehindCount, vertexIndex, v.cams[c], weight, fullWeight,
-                                  nPixelSizeBehind,
-                                  fillOut, distFcnHeight);
-
-                totalStepsFront += stepsFront;
-                totalRayFront += 1;
-                totalStepsBehind += stepsBehind;
-                totalRayBehind += 1;
-
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedFrontCount.facets += geometriesIntersectedFrontCount.facets;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedFrontCount.vertices += geometriesIntersectedFrontCount.vertices;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedFrontCount.edges += geometriesIntersectedFrontCount.edges;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedBehindCount.facets += geometriesIntersectedBehindCount.facets;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedBehindCount.vertices += geometriesIntersectedBehindCount.vertices;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedBehindCount.edges += geometriesIntersectedBehindCount.edges;
-            } // for c
+            const auto rayStartTime = std::chrono::steady_clock::now();
+            int stepsFront = 0;
+            int stepsBehind = 0;
+            GeometriesCount rayFrontCount;
+            GeometriesCount rayBehindCount;
+            fillGraphPartPtRc(stepsFront, stepsBehind, rayFrontCount, rayBehindCount, ray.vertexIndex, ray.cam, weight,
+                              fullWeight, nPixelSizeBehind, fillOut, distFcnHeight);
+
+            rayWalkStats.add(stepsFront, stepsBehind, getElapsedSeconds(rayStartTime));
+            geometriesIntersectedFrontCount += rayFrontCount;
+            geometriesIntersectedBehindCount += rayBehindCount;
+        }
 
-            totalCamHaveVisibilityOnVertex += v.cams.size();
-            totalOfVertex += 1;
+#pragma omp critical
+        {
+            totalRayWalkStats += rayWalkStats;
+            totalGeometriesIntersectedFrontCount += geometriesIntersectedFrontCount;
+            totalGeometriesIntersectedBehindCount += geometriesIntersectedBehindCount;
         }
     }
+    totalRayWalkStats.log("fillGraph", getElapsedSeconds(startTime));
 
-    ALICEVISION_LOG_DEBUG("_verticesAttr.size(): " << _verticesAttr.size() << "(" << verticesRandIds.size() << ")");
+    ALICEVISION_LOG_DEBUG("_verticesAttr.size(): " << _verticesAttr.size() << "(" << rays.size() << " rays)");
     ALICEVISION_LOG_DEBUG("totalIsRealNrc: " << totalIsRealNrc);
-    ALICEVISION_LOG_DEBUG("totalStepsFront//totalRayFront = " << totalStepsFront << " // " << totalRayFront);
-    ALICEVISION_LOG_DEBUG("totalStepsBehind//totalRayBehind = " << totalStepsBehind << " // " << totalRayBehind);
-    ALICEVISION_LOG_DEBUG("totalCamHaveVisibilityOnVertex//totalOfVertex = " << totalCamHaveVisibilityOnVertex << " // " << totalOfVertex);
+    ALICEVISION_LOG_DEBUG("totalStepsFront//totalRayFront = " << totalRayWalkStats.nbStepsFront << " // " << totalRayWalkStats.nbRays);
+    ALICEVISION_LOG_DEBUG("totalStepsBehind//totalRayBehind = " << totalRayWalkStats.nbStepsBehind << " // " << totalRayWalkStats.nbRays);
+    ALICEVISION_LOG_DEBUG("totalCamHaveVisibilityOnVertex//totalOfVertex = " << totalCamHaveVisibilityOnVertex << " // " << totalIsRealNrc);
 
     ALICEVISION_LOG_DEBUG("- Geometries Intersected count -");
     ALICEVISION_LOG_DEBUG("Front: " << totalGeometriesIntersectedFrontCount);
@@ -2311,36 +2497,38 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(float nPixelSizeBehind)
 
     const double marginEpsilonFactor = 1.0e-4;
 
-    // choose random order to prevent waiting
-    const unsigned int seed = (unsigned int)mp->userParams.get<unsigned int>("delaunaycut.seed", 0);
-    const std::vector<int> verticesRandIds = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size(), seed);
-
-    size_t totalStepsFront = 0;
-    size_t totalRayFront = 0;
-    size_t totalStepsBehind = 0;
-    size_t totalRayBehind = 0;
-
-    size_t totalCamHaveVisibilityOnVertex = 0;
-    size_t totalOfVertex = 0;
+    // rays sorted by camera and direction: consecutive rays go through the same cells
+    const std::vector<VisibilityRay> rays = getSortedVisibilityRays();
 
     size_t totalVertexIsVirtual = 0;
+    for(const GC_vertexInfo& v: _verticesAttr)
+    {
+        if(v.isReal())
+            ++totalVertexIsVirtual;
+    }
 
+    RayWalkStats totalRayWalkStats;
     GeometriesCount totalGeometriesIntersectedFrontCount;
     GeometriesCount totalGeometriesIntersectedBehindCount;
 
-#pragma omp parallel for reduction(+:totalStepsFront,totalRayFront,totalStepsBehind,totalRayBehind)
-    for(int i = 0; i < verticesRandIds.size(); ++i)
+    const auto startTime = std::chrono::steady_clock::now();
+#pragma omp parallel
     {
-        const int vertexIndex = verticesRandIds[i];
-        const GC_vertexInfo& v = _verticesAttr[vertexIndex];
-        if(v.isVirtual())
-            continue;
+        // per thread statistics, merged at the end
+        RayWalkStats rayWalkStats;
+        GeometriesCount threadFrontCount;
+        GeometriesCount threadBehindCount;
 
-        ++totalVertexIsVirtual;
-        const Point3d& originPt = _verticesCoords[vertexIndex];
-        // For each camera that has visibility over the vertex v (vertexIndex)
-        for(const int cam : v.cams)
+#pragma omp for schedule(dynamic, 256)
+        for(int i = 0; i < rays.size(); ++i)
         {
+            const int vertexIndex = rays[i].vertexIndex;
+            const int cam = rays[i].cam;
+            const Point3d& originPt = _verticesCoords[vertexIndex];
+
+            const auto rayStartTime = std::chrono::steady_clock::now();
+            int stepsFront = 0;
+            int stepsBehind = 0;
             GeometriesCount geometriesIntersectedFrontCount;
             GeometriesCount geometriesIntersectedBehindCount;
 
@@ -2375,7 +2563,7 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(float nPixelSizeBehind)
 #ifdef ALICEVISION_DEBUG_VOTE
                     history.append(geometry, intersectPt);
 #endif
-                    ++totalStepsFront;
+                    ++stepsFront;
 
                     geometry = intersectNextGeom(previousGeometry, originPt, dirVect, intersectPt, marginEpsilonFactor, lastIntersectPt);
 
@@ -2457,13 +2645,6 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(float nPixelSizeBehind)
                         }
                     }
                 }
-                ++totalRayFront;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedFrontCount.facets += geometriesIntersectedFrontCount.facets;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedFrontCount.vertices += geometriesIntersectedFrontCount.vertices;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedFrontCount.edges += geometriesIntersectedFrontCount.edges;
             }
             {
                 // Initialisation
@@ -2490,7 +2671,7 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(float nPixelSizeBehind)
 #ifdef ALICEVISION_DEBUG_VOTE
                     history.append(geometry, intersectPt);
 #endif
-                    ++totalStepsBehind;
+                    ++stepsBehind;
 
                     geometry = intersectNextGeom(previousGeometry, originPt, dirVect, intersectPt, marginEpsilonFactor, lastIntersectPt);
 
@@ -2615,18 +2796,21 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(float nPixelSizeBehind)
                         _cellsAttr[lastIntersectedFacet.cellIndex].on += (maxJump - midSilent);
                     }
                 }
-                ++totalRayBehind;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedBehindCount.facets += totalGeometriesIntersectedBehindCount.facets;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedBehindCount.vertices += totalGeometriesIntersectedBehindCount.vertices;
-#pragma OMP_ATOMIC_UPDATE
-                totalGeometriesIntersectedBehindCount.edges += totalGeometriesIntersectedBehindCount.edges;
             }
+
+            rayWalkStats.add(stepsFront, stepsBehind, getElapsedSeconds(rayStartTime));
+            threadFrontCount += geometriesIntersectedFrontCount;
+            threadBehindCount += geometriesIntersectedBehindCount;
+        }
+
+#pragma omp critical
+        {
+            totalRayWalkStats += rayWalkStats;
+            totalGeometriesIntersectedFrontCount += threadFrontCount;
+            totalGeometriesIntersectedBehindCount += threadBehindCount;
         }
-        totalCamHaveVisibilityOnVertex += v.cams.size();
-        totalOfVertex += 1;
     }
+    totalRayWalkStats.log("forceTedgesByGradientIJCV", getElapsedSeconds(startTime));
 
     for(GC_cellInfo& c: _cellsAttr)
     {
@@ -2636,17 +2820,17 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(float nPixelSizeBehind)
         c.cellTWeight = std::max(c.cellTWeight, std::min(1000000.0f, w));
     }
 
-    ALICEVISION_LOG_DEBUG("_verticesAttr.size(): " << _verticesAttr.size() << "(" << verticesRandIds.size() << ")");
+    ALICEVISION_LOG_DEBUG("_verticesAttr.size(): " << _verticesAttr.size() << "(" << rays.size() << " rays)");
     ALICEVISION_LOG_DEBUG("totalVertexIsVirtual: " << totalVertexIsVirtual);
-    ALICEVISION_LOG_DEBUG("totalStepsFront//totalRayFront = " << totalStepsFront << " // " << totalRayFront);
-    ALICEVISION_LOG_DEBUG("totalStepsBehind//totalRayBehind = " << totalStepsBehind << " // " << totalRayBehind);
-    ALICEVISION_LOG_DEBUG("totalCamHaveVisibilityOnVertex//totalOfVertex = " << totalCamHaveVisibilityOnVertex << " // " << totalOfVertex);
+    ALICEVISION_LOG_DEBUG("totalStepsFront//totalRayFront = " << totalRayWalkStats.nbStepsFront << " // " << totalRayWalkStats.nbRays);
+    ALICEVISION_LOG_DEBUG("totalStepsBehind//totalRayBehind = " << totalRayWalkStats.nbStepsBehind << " // " << totalRayWalkStats.nbRays);
+    ALICEVISION_LOG_DEBUG("totalCamHaveVisibilityOnVertex//totalOfVertex = " << rays.size() << " // " << totalVertexIsVirtual);
 
     ALICEVISION_LOG_DEBUG("- Geometries Intersected count -");
     ALICEVISION_LOG_DEBUG("Front: " << totalGeometriesIntersectedFrontCount);
     ALICEVISION_LOG_DEBUG("Behind: " << totalGeometriesIntersectedBehindCount);
-    totalGeometriesIntersectedFrontCount /= totalRayFront;
-    totalGeometriesIntersectedBehindCount /= totalRayBehind;
+    totalGeometriesIntersectedFrontCount /= std::max(size_t(1), totalRayWalkStats.nbRays);
+    totalGeometriesIntersectedBehindCount /= std::max(size_t(1), totalRayWalkStats.nbRays);
     ALICEVISION_LOG_DEBUG("Front per vertex: " << totalGeometriesIntersectedFrontCount);
     ALICEVISION_LOG_DEBUG("Behind per vertex: " << totalGeometriesIntersectedBehindCount);
 
@@ -21,6 +21,7 @@
 #include <geogram/mesh/mesh.h>
 #include <geogram/basic/geometry_nd.h>
 
+#include <algorithm>
 #include <map>
 #include <set>
 
@@ -61,6 +62,93 @@ struct FuseParams
 };
 
 
+/**
+ * @brief Intersections of a ray with the planes of the 4 facets of a tetrahedron.
+ *
+ * The facet i is opposite to the local vertex i, its vertices are (i+1)%4, (i+2)%4, (i+3)%4 (see getVertexIndex).
+ * The tetrahedron vertices are loaded once and the facets are stored in SoA layout, so the 4 facets are
+ * tested with the same vectorizable code. The computations are the same as in getLineTriangleIntersectBarycCoords
+ * and rayIntersectTriangle, so the results are identical.
+ */
+struct TetrahedronRayIntersections
+{
+    /// intersection points with the facets planes
+    double x[4], y[4], z[4];
+    /// barycentric coordinates: u from A to C, v from A to B
+    double u[4], v[4];
+    /// min and mean edge length of each facet
+    double minEdgeSize[4], meanEdgeSize[4];
+
+    TetrahedronRayIntersections(const Point3d* cellPoints[4], const Point3d& linePoint, const Point3d& lineVect)
+    {
+        // edges lengths
+        double edgeSize[4][4];
+        for(int i = 0; i < 4; ++i)
+        {
+            for(int j = i + 1; j < 4; ++j)
+            {
+                edgeSize[i][j] = edgeSize[j][i] = (*cellPoints[i] - *cellPoints[j]).size();
+            }
+        }
+
+        // facets vertices in SoA layout
+        double ax[4], ay[4], az[4], bx[4], by[4], bz[4], cx[4], cy[4], cz[4];
+        for(int i = 0; i < 4; ++i)
+        {
+            const int a = (i + 1) % 4;
+            const int b = (i + 2) % 4;
+            const int c = (i + 3) % 4;
+            ax[i] = cellPoints[a]->x; ay[i] = cellPoints[a]->y; az[i] = cellPoints[a]->z;
+            bx[i] = cellPoints[b]->x; by[i] = cellPoints[b]->y; bz[i] = cellPoints[b]->z;
+            cx[i] = cellPoints[c]->x; cy[i] = cellPoints[c]->y; cz[i] = cellPoints[c]->z;
+
+            const double ABSize = edgeSize[a][b];
+            const double BCSize = edgeSize[b][c];
+            const double ACSize = edgeSize[a][c];
+            minEdgeSize[i] = std::min(std::min(ABSize, BCSize), ACSize);
+            meanEdgeSize[i] = (ABSize + BCSize + ACSize) / 3.0;
+        }
+
+        const double linePoint_x = linePoint.x;
+        const double linePoint_y = linePoint.y;
+        const double linePoint_z = linePoint.z;
+        const double lineVect_x = lineVect.x;
+        const double lineVect_y = lineVect.y;
+        const double lineVect_z = lineVect.z;
+
+        for(int i = 0; i < 4; ++i)
+        {
+            const double v0_x = cx[i] - ax[i];
+            const double v0_y = cy[i] - ay[i];
+            const double v0_z = cz[i] - az[i];
+            const double v1_x = bx[i] - ax[i];
+            const double v1_y = by[i] - ay[i];
+            const double v1_z = bz[i] - az[i];
+            const double _n_x = v0_y * v1_z - v0_z * v1_y;
+            const double _n_y = v0_z * v1_x - v0_x * v1_z;
+            const double _n_z = v0_x * v1_y - v0_y * v1_x;
+            const double k = ((ax[i] * _n_x + ay[i] * _n_y + az[i] * _n_z) - (_n_x * linePoint_x + _n_y * linePoint_y + _n_z * linePoint_z)) / (_n_x * lineVect_x + _n_y * lineVect_y + _n_z * lineVect_z);
+            x[i] = linePoint_x + lineVect_x * k;
+            y[i] = linePoint_y + lineVect_y * k;
+            z[i] = linePoint_z + lineVect_z * k;
+            const double v2_x = x[i] - ax[i];
+            const double v2_y = y[i] - ay[i];
+            const double v2_z = z[i] - az[i];
+            const double dot00 = (v0_x * v0_x + v0_y * v0_y + v0_z * v0_z);
+            const double dot01 = (v0_x * v1_x + v0_y * v1_y + v0_z * v1_z);
+            const double dot02 = (v0_x * v2_x + v0_y * v2_y + v0_z * v2_z);
+            const double dot11 = (v1_x * v1_x + v1_y * v1_y + v1_z * v1_z);
+            const double dot12 = (v1_x * v2_x + v1_y * v2_y + v1_z * v2_z);
+            const double invDenom = 1.0 / (dot00 * dot11 - dot01 * dot01);
+            u[i] = (dot11 * dot02 - dot01 * dot12) * invDenom;
+            v[i] = (dot00 * dot12 - dot01 * dot02) * invDenom;
+        }
+    }
+
+    Point3d getIntersectPt(int i) const { return Point3d(x[i], y[i], z[i]); }
+};
+
+
 class DelaunayGraphCut
 {
 public:
@@ -204,6 +292,15 @@ public:
         }
     };
 
+    /**
+     * @brief Line of sight between a vertex and one of the cameras seeing it.
+     */
+    struct VisibilityRay
+    {
+        VertexIndex vertexIndex;
+        int cam;
+    };
+
     mvsUtils::MultiViewParams* mp;
 
     GEO::Delaunay_var _tetrahedralization;
@@ -490,6 +587,25 @@ public:
     GeometryIntersection rayIntersectTriangle(const Point3d& originPt, const Point3d& DirVec, const Facet& facet,
         Point3d& intersectPt, const double epsilonFactor, bool& ambiguous, const Point3d* lastIntersectPt = nullptr) const;
 
+    /**
+     * @brief Classify the intersection of a ray with the plane of a facet (facet, edge, vertex or None)
+     * from the barycentric coordinates of the intersection point. See rayIntersectTriangle.
+     *
+     * @param facet the intersected facet
+     * @param planeIntersectPt the intersection point of the ray with the plane of the facet
+     * @param u the barycentric coordinate along the A to C edge
+     * @param v the barycentric coordinate along the A to B edge
+     * @param marginEpsilon the margin to consider a collision with an edge/vertex instead of the facet
+     * @param ambiguityEpsilon the min distance from the last intersection point to consider the intersection as not ambiguous
+     * @param DirVec ray direction
+     * @param intersectPt a reference that will store the computed intersection point for the next intersecting geometry
+     * @param ambiguous boolean used to know if our intersection is ambiguous or not
+     * @param lastIntersectPt pointer to the last intersection point used to test the direction (if not nulllptr)
+     */
+    GeometryIntersection classifyTriangleIntersection(const Facet& facet, const Point3d& planeIntersectPt, double u, double v,
+        double marginEpsilon, double ambiguityEpsilon, const Point3d& DirVec, Point3d& intersectPt, bool& ambiguous,
+        const Point3d* lastIntersectPt) const;
+
     float distFcn(float maxDist, float dist, float distFcnHeight) const;
 
     inline double conj(double val) const { return val; }
@@ -500,6 +616,12 @@ public:
 
     float weightFcn(float nrc, bool labatutWeights, int ncams);
 
+    /**
+     * @brief Get the lines of sight of all the real vertices, sorted by camera then by direction,
+     * so that consecutive rays go through the same cells.
+     */
+    std::vector<VisibilityRay> getSortedVisibilityRays() const;
+
     void fillGraph(double nPixelSizeBehind, bool labatutWeights, bool fillOut, float distFcnHeight,
                            float fullWeight);
     void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, GeometriesCount& outFrontCount, GeometriesCount& outBehindCount, int vertexIndex, int cam, float weight,
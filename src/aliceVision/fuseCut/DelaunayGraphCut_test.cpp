@@ -7,11 +7,19 @@
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/multiview/NViewDataSet.hpp>
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+#include <aliceVision/mvsData/imageIO.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 
 #include <boost/math/constants/constants.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
 #include <string>
 
 #define BOOST_TEST_MODULE fuseCut
@@ -52,6 +60,55 @@ BOOST_AUTO_TEST_CASE(fuseCut_solidAngle)
     }
 }
 
+BOOST_AUTO_TEST_CASE(fuseCut_tetrahedronRayIntersections)
+{
+    // the facets of random tetrahedra tested at once must give the same bits as one triangle at a time
+    const auto sameBits = [](double a, double b) { return std::memcmp(&a, &b, sizeof(double)) == 0; };
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    const auto randomPoint = [&]() { return Point3d(distribution(generator), distribution(generator), distribution(generator)); };
+
+    std::size_t nbMismatches = 0;
+    std::size_t nbInsideFacets = 0;
+    for(int t = 0; t < 100000; ++t)
+    {
+        const Point3d points[4] = {randomPoint(), randomPoint(), randomPoint(), randomPoint()};
+        const Point3d* cellPoints[4] = {&points[0], &points[1], &points[2], &points[3]};
+        const Point3d linePoint = randomPoint();
+        const Point3d lineVect = randomPoint().normalize();
+
+        const TetrahedronRayIntersections intersections(cellPoints, linePoint, lineVect);
+
+        for(int i = 0; i < 4; ++i)
+        {
+            // facet opposite to the local vertex i
+            const Point3d* A = cellPoints[(i + 1) % 4];
+            const Point3d* B = cellPoints[(i + 2) % 4];
+            const Point3d* C = cellPoints[(i + 3) % 4];
+
+            Point3d intersectPt;
+            const Point2d uv = getLineTriangleIntersectBarycCoords(&intersectPt, A, B, C, &linePoint, &lineVect);
+            const double ABSize = (*A - *B).size();
+            const double BCSize = (*B - *C).size();
+            const double ACSize = (*A - *C).size();
+
+            if(uv.x >= 0.0 && uv.y >= 0.0 && uv.x + uv.y <= 1.0)
+                ++nbInsideFacets;
+
+            if(!sameBits(intersections.u[i], uv.x) || !sameBits(intersections.v[i], uv.y) ||
+               !sameBits(intersections.x[i], intersectPt.x) || !sameBits(intersections.y[i], intersectPt.y) ||
+               !sameBits(intersections.z[i], intersectPt.z) ||
+               !sameBits(intersections.minEdgeSize[i], std::min(std::min(ABSize, BCSize), ACSize)) ||
+               !sameBits(intersections.meanEdgeSize[i], (ABSize + BCSize + ACSize) / 3.0))
+                ++nbMismatches;
+        }
+    }
+
+    BOOST_CHECK_GT(nbInsideFacets, 10000);
+    BOOST_CHECK_EQUAL(nbMismatches, 0);
+}
+
 SfMData generateSfm(const NViewDatasetConfigurator& config, const size_t size = 3, camera::EINTRINSIC eintrinsic = camera::EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
 
 BOOST_AUTO_TEST_CASE(fuseCut_delaunayGraphCut)
@@ -107,6 +164,337 @@ BOOST_AUTO_TEST_CASE(fuseCut_delaunayGraphCut)
     ALICEVISION_LOG_TRACE("CreateGraphCut Done.");
 }
 
+namespace aliceVision {
+namespace fuseCut {
+
+// helpers of DelaunayGraphCut.cpp, shared by the former and the current fusion
+void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, double pixSizeMarginCoef, std::vector<float>& simScorePrepare);
+void removeInvalidPoints(std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare);
+void removeInvalidPoints(std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare, std::vector<GC_vertexInfo>& verticesAttrPrepare);
+
+} // namespace fuseCut
+} // namespace aliceVision
+
+namespace {
+
+const int depthMapWidth = 120;
+const int depthMapHeight = 90;
+
+/// Cameras on a ring around a unit sphere centered at (0, 0, 4), away from the origin
+SfMData generateSphereSfm(int nbCameras)
+{
+    SfMData sfmData;
+    sfmData.intrinsics[0] = camera::createIntrinsic(camera::EINTRINSIC::PINHOLE_CAMERA, depthMapWidth, depthMapHeight, 110.0,
+                                                    depthMapWidth / 2.0, depthMapHeight / 2.0);
+    const Vec3 sphereCenter(0.0, 0.0, 4.0);
+    for(int i = 0; i < nbCameras; ++i)
+    {
+        const double angle = 0.35 * (i - 0.5 * (nbCameras - 1));
+        const Vec3 camCenter = sphereCenter + Vec3(3.5 * std::sin(angle), 0.3 * (i % 2), -3.5 * std::cos(angle));
+        sfmData.views[i] = std::make_shared<View>("", i, 0, i, depthMapWidth, depthMapHeight);
+        sfmData.setPose(*sfmData.views.at(i), CameraPose(geometry::Pose3(LookAt(sphereCenter - camCenter), camCenter)));
+    }
+    return sfmData;
+}
+
+/// Depth maps of the sphere with a small noise, the background has no depth
+void writeSphereDepthMaps(mvsUtils::MultiViewParams& mp, const StaticVector<int>& cams)
+{
+    std::mt19937 generator(42);
+    std::normal_distribution<double> noise(0.0, 0.002);
+    const Point3d sphereCenter(0.0, 0.0, 4.0);
+
+    for(int ci = 0; ci < cams.size(); ++ci)
+    {
+        const int c = cams[ci];
+        std::vector<float> depthMap(depthMapWidth * depthMapHeight, -1.0f);
+        for(int y = 0; y < depthMapHeight; ++y)
+        {
+            for(int x = 0; x < depthMapWidth; ++x)
+            {
+                const Point3d dir = (mp.iCamArr[c] * Point2d(x, y)).normalize();
+                const Point3d oc = mp.CArr[c] - sphereCenter;
+                const double b = dot(oc, dir);
+                const double delta = b * b - (oc.size2() - 1.0);
+                if(delta > 0.0)
+                    depthMap[y * depthMapWidth + x] = -b - std::sqrt(delta) + noise(generator);
+            }
+        }
+        imageIO::OutputFileColorSpace colorspace(imageIO::EImageColorSpace::NO_CONVERSION);
+        imageIO::writeImage(getFileNameFromIndex(&mp, c, mvsUtils::EFileType::depthMap, 0), depthMapWidth, depthMapHeight,
+                            depthMap, imageIO::EImageQuality::LOSSLESS, colorspace);
+    }
+}
+
+/**
+ * @brief The former visibilities: each depth votes for its nearest vertex, the cameras in order.
+ * With runningAverage, as before the lock-free fusion, a vertex moves as soon as a depth contributes to it
+ * and the next votes see the new position. Otherwise the positions are frozen during the votes.
+ */
+void createReferenceVisibilities(mvsUtils::MultiViewParams& mp, const StaticVector<int>& cams,
+                                 std::vector<Point3d>& verticesCoords, const std::vector<double>& pixSize,
+                                 const std::vector<float>& simScore, std::vector<GC_vertexInfo>& verticesAttr,
+                                 const FuseParams& params, bool runningAverage)
+{
+    const std::vector<Point3d> frozenCoords = verticesCoords;
+    const std::vector<Point3d>& votedCoords = runningAverage ? verticesCoords : frozenCoords;
+    std::vector<Point3d> contribSums(verticesCoords.size(), Point3d(0.0, 0.0, 0.0));
+    std::vector<int> contribCounts(verticesCoords.size(), 0);
+
+    for(int ci = 0; ci < cams.size(); ++ci)
+    {
+        const int c = cams[ci];
+        std::vector<float> depthMap;
+        int width, height;
+        imageIO::readImage(getFileNameFromIndex(&mp, c, mvsUtils::EFileType::depthMap, 0), width, height, depthMap,
+                           imageIO::EImageColorSpace::NO_CONVERSION);
+
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                const float depth = depthMap[y * width + x];
+                if(depth <= 0.0f)
+                    continue;
+
+                const Point3d p = mp.backproject(c, Point2d(x, y), depth);
+                const double pixSizeI = mp.getCamPixelSize(p, c);
+
+                std::size_t nearest = 0;
+                double dist = std::numeric_limits<double>::max();
+                for(std::size_t vi = 0; vi < votedCoords.size(); ++vi)
+                {
+                    const double d = (p - votedCoords[vi]).size2();
+                    if(d < dist)
+                    {
+                        dist = d;
+                        nearest = vi;
+                    }
+                }
+
+                const float pixSizeScoreI = simScore[nearest] * pixSizeI * pixSizeI;
+                const float pixSizeScoreV = simScore[nearest] * pixSize[nearest] * pixSize[nearest];
+                if(dist >= params.voteMarginFactor * std::max(pixSizeScoreI, pixSizeScoreV))
+                    continue;
+
+                GC_vertexInfo& va = verticesAttr[nearest];
+                va.cams.push_back_distinct(c);
+                if(dist >= params.contributeMarginFactor * pixSizeScoreV)
+                    continue;
+
+                if(runningAverage)
+                {
+                    verticesCoords[nearest] = (verticesCoords[nearest] * double(va.nrc) + p) / double(va.nrc + 1);
+                    va.nrc += 1;
+                }
+                else
+                {
+                    contribSums[nearest] = contribSums[nearest] + p;
+                    ++contribCounts[nearest];
+                }
+            }
+        }
+    }
+
+    for(std::size_t vi = 0; vi < verticesAttr.size(); ++vi)
+    {
+        GC_vertexInfo& va = verticesAttr[vi];
+        if(contribCounts[vi] > 0)
+        {
+            verticesCoords[vi] = (verticesCoords[vi] * double(va.nrc) + contribSums[vi]) / double(va.nrc + contribCounts[vi]);
+            va.nrc += contribCounts[vi];
+        }
+        va.pixSize = mp.getCamsMinPixelSize(verticesCoords[vi], va.cams);
+    }
+}
+
+/// The former depth maps fusion, in a single thread, without sim and nmod maps
+void fuseReference(mvsUtils::MultiViewParams& mp, const StaticVector<int>& cams, const FuseParams& params, bool runningAverage,
+                   std::vector<Point3d>& verticesCoords, std::vector<GC_vertexInfo>& verticesAttr)
+{
+    std::size_t nbPixels = 0;
+    for(const auto& imgParams : mp.getImagesParams())
+        nbPixels += imgParams.size;
+    const int step = std::max(int(std::floor(std::sqrt(double(nbPixels) / double(params.maxInputPoints)))), params.minStep);
+
+    std::vector<double> pixSize;
+    std::vector<float> simScore;
+    for(int ci = 0; ci < cams.size(); ++ci)
+    {
+        const int c = cams[ci];
+        std::vector<float> depthMap;
+        int width, height;
+        imageIO::readImage(getFileNameFromIndex(&mp, c, mvsUtils::EFileType::depthMap, 0), width, height, depthMap,
+                           imageIO::EImageColorSpace::NO_CONVERSION);
+
+        // the best depth of each tile, scored by the number of its valid neighbors
+        for(int sy = 0; sy < height / step; ++sy)
+        {
+            for(int sx = 0; sx < width / step; ++sx)
+            {
+                float bestDepth = 0.0f;
+                float bestScore = 0.0f;
+                int bestX = 0;
+                int bestY = 0;
+                for(int y = sy * step; y < std::min((sy + 1) * step, height); ++y)
+                {
+                    for(int x = sx * step; x < std::min((sx + 1) * step, width); ++x)
+                    {
+                        const float depth = depthMap[y * width + x];
+                        if(depth <= 0.0f)
+                            continue;
+                        int numOfModals = 0;
+                        for(int ly = std::max(y - 1, 0); ly < std::min(y + 1, height - 1); ++ly)
+                            for(int lx = std::max(x - 1, 0); lx < std::min(x + 1, width - 1); ++lx)
+                                if(depthMap[ly * width + lx] > 0.0f)
+                                    numOfModals += 10 + 1;
+                        const float score = numOfModals + 1.0f;
+                        if(score > bestScore)
+                        {
+                            bestDepth = depth;
+                            bestScore = score;
+                            bestX = x;
+                            bestY = y;
+                        }
+                    }
+                }
+                if(bestScore < 3 * 13)
+                    continue;
+
+                const Point3d p = mp.CArr[c] + (mp.iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
+                verticesCoords.push_back(p);
+                simScore.push_back(1.0f);
+                pixSize.push_back(mp.getCamPixelSize(p, c));
+            }
+        }
+    }
+
+    filterByPixSize(verticesCoords, pixSize, params.pixSizeMarginInitCoef, simScore);
+    removeInvalidPoints(verticesCoords, pixSize, simScore);
+
+    verticesAttr.resize(verticesCoords.size());
+    createReferenceVisibilities(mp, cams, verticesCoords, pixSize, simScore, verticesAttr, params, runningAverage);
+
+    for(std::size_t vi = 0; vi < verticesCoords.size(); ++vi)
+    {
+        double maxAngle = 0.0;
+        for(int i : verticesAttr[vi].cams.getData())
+            for(int j : verticesAttr[vi].cams.getData())
+                if(i != j)
+                    maxAngle = std::max(maxAngle, angleBetwABandAC(verticesCoords[vi], mp.CArr[i], mp.CArr[j]));
+
+        if(maxAngle < params.minAngleThreshold || verticesAttr[vi].cams.size() < params.minVis)
+            pixSize[vi] = -1.0;
+        else
+            simScore[vi] *= 1.0 + params.angleFactor / maxAngle;
+    }
+    removeInvalidPoints(verticesCoords, pixSize, simScore, verticesAttr);
+
+    double pixSizeMarginFinalCoef = params.pixSizeMarginFinalCoef;
+    for(int filteringIt = 0; filteringIt < 20; ++filteringIt)
+    {
+        filterByPixSize(verticesCoords, pixSize, pixSizeMarginFinalCoef, simScore);
+        removeInvalidPoints(verticesCoords, pixSize, simScore, verticesAttr);
+        if(verticesCoords.size() < params.maxPoints)
+            break;
+        pixSizeMarginFinalCoef *= 1.5;
+    }
+
+    if(params.refineFuse)
+        createReferenceVisibilities(mp, cams, verticesCoords, pixSize, simScore, verticesAttr, params, runningAverage);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(fuseCut_fuseFromDepthMaps)
+{
+    const SfMData sfmData = generateSphereSfm(5);
+    const boost::filesystem::path depthMapsFolder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(depthMapsFolder);
+
+    mvsUtils::MultiViewParams mp(sfmData, "", "", depthMapsFolder.string(), false);
+    StaticVector<int> cams;
+    cams.resize(mp.getNbCameras());
+    for(int i = 0; i < cams.size(); ++i)
+        cams[i] = i;
+    writeSphereDepthMaps(mp, cams);
+
+    // filterByPixSize kills a point if a neighbor not killed yet has a smaller pixel size: the result depends on the
+    // order of the threads, the comparisons with the former fusion run in a single thread
+    const int nbThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+
+    // with the default number of points, and with a number of points forcing the final filtering to iterate
+    for(const int maxPoints : {5000000, 1000})
+    {
+        FuseParams params;
+        params.maxPoints = maxPoints;
+
+        DelaunayGraphCut delaunayGC(&mp);
+        delaunayGC.fuseFromDepthMaps(cams, nullptr, params);
+        const std::vector<Point3d>& coords = delaunayGC._verticesCoords;
+        const std::vector<GC_vertexInfo>& attr = delaunayGC._verticesAttr;
+        BOOST_CHECK_GT(coords.size(), 500);
+        BOOST_CHECK_LT(coords.size(), maxPoints);
+
+        // the same points as the former fusion with the positions frozen during the votes,
+        // the positions are the same means of the contributions, up to the summation order
+        std::vector<Point3d> referenceCoords;
+        std::vector<GC_vertexInfo> referenceAttr;
+        fuseReference(mp, cams, params, false, referenceCoords, referenceAttr);
+
+        BOOST_REQUIRE_EQUAL(coords.size(), referenceCoords.size());
+        BOOST_REQUIRE_EQUAL(attr.size(), referenceAttr.size());
+        for(std::size_t vi = 0; vi < referenceCoords.size(); ++vi)
+        {
+            BOOST_CHECK_EQUAL(attr[vi].nrc, referenceAttr[vi].nrc);
+            BOOST_CHECK(attr[vi].cams.getData() == referenceAttr[vi].cams.getData());
+            BOOST_CHECK_SMALL((coords[vi] - referenceCoords[vi]).size(), 1e-6 * referenceAttr[vi].pixSize);
+            BOOST_CHECK_CLOSE(attr[vi].pixSize, referenceAttr[vi].pixSize, 1e-3);
+        }
+        BOOST_TEST_MESSAGE("max points " << maxPoints << ": " << coords.size() << " fused points.");
+    }
+
+    // the former running average moved the vertices during the votes, depending on the order of the depths:
+    // a few votes go to another vertex
+    std::size_t singleThreadNbPoints = 0;
+    {
+        const FuseParams params;
+        DelaunayGraphCut delaunayGC(&mp);
+        delaunayGC.fuseFromDepthMaps(cams, nullptr, params);
+
+        std::vector<Point3d> runningCoords;
+        std::vector<GC_vertexInfo> runningAttr;
+        fuseReference(mp, cams, params, true, runningCoords, runningAttr);
+
+        BOOST_TEST_MESSAGE(delaunayGC._verticesCoords.size() << " fused points, " << runningCoords.size()
+                                                             << " with the former running average.");
+        BOOST_CHECK_LE(std::abs(int(delaunayGC._verticesCoords.size()) - int(runningCoords.size())),
+                       delaunayGC._verticesCoords.size() / 100);
+        singleThreadNbPoints = delaunayGC._verticesCoords.size();
+    }
+
+    // with all the threads: about the same number of points, each camera is declared once per vertex
+    omp_set_num_threads(nbThreads);
+    {
+        const FuseParams params;
+        DelaunayGraphCut delaunayGC(&mp);
+        delaunayGC.fuseFromDepthMaps(cams, nullptr, params);
+
+        BOOST_TEST_MESSAGE(delaunayGC._verticesCoords.size() << " fused points with " << nbThreads << " threads.");
+        BOOST_CHECK_LE(std::abs(int(delaunayGC._verticesCoords.size()) - int(singleThreadNbPoints)), singleThreadNbPoints / 100);
+        for(const GC_vertexInfo& va : delaunayGC._verticesAttr)
+        {
+            std::vector<int> vertexCams = va.cams.getData();
+            std::sort(vertexCams.begin(), vertexCams.end());
+            BOOST_CHECK_GE(vertexCams.size(), params.minVis);
+            BOOST_CHECK(std::adjacent_find(vertexCams.begin(), vertexCams.end()) == vertexCams.end());
+        }
+    }
+
+    boost::filesystem::remove_all(depthMapsFolder);
+}
+
 /**
  * @brief Generate syntesize dataset with succesion of n(size) alignaed regular thetraedron and two camera on the last thetrahedron.
  * 
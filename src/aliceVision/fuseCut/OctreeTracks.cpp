@@ -9,456 +9,189 @@
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace fuseCut {
 
-OctreeTracks::Node::Node(NodeType type)
-{
-    type_ = type;
-}
-
-OctreeTracks::trackStruct* OctreeTracks::getTrack(int x, int y, int z)
-{
-    if(!((x >= 0 && x < size_) && (y >= 0 && y < size_) && (z >= 0 && z < size_)))
-    {
-        return nullptr;
-    }
-
-    Node** n = &root_;
-    int size = size_;
-
-    while(size != 1)
-    {
-        if(*n == nullptr)
-        {
-            return nullptr;
-        }
-
-        size /= 2;
-        n = &reinterpret_cast<Branch*>(*n)->children[!((x & size) == 0)][!((y & size) == 0)][!((z & size) == 0)];
-    }
+namespace {
 
-    if(*n == nullptr)
-    {
-        return nullptr;
-    }
+/// max depth of the octree (number of bits per axis of the Morton codes)
+const int maxOctreeDepth = 21;
 
-    return reinterpret_cast<trackStruct*>(*n);
-}
-
-void OctreeTracks::addPoint(int x, int y, int z, float sim, float pixSize, Point3d& p, int rc)
+/// Spread the 21 lower bits of x every 3 bits
+inline std::uint64_t spreadBits21(std::uint64_t x)
 {
-    assert(x >= 0 && x < size_);
-    assert(y >= 0 && y < size_);
-    assert(z >= 0 && z < size_);
-
-    Node** n = &root_;
-    int size = size_;
-
-    while(size != 1)
-    {
-        if(*n == nullptr)
-        {
-            *n = new Branch();
-        }
-        else
-        {
-            size /= 2;
-            n = &reinterpret_cast<Branch*>(*n)->children[!((x & size) == 0)][!((y & size) == 0)][!((z & size) == 0)];
-        }
-    }
-
-    if(*n == nullptr)
-    {
-        *n = new trackStruct(sim, pixSize, p, rc);
-        leafsNumber_++;
-    }
-    else
-    {
-        reinterpret_cast<trackStruct*>(*n)->addPoint(sim, pixSize, p, rc);
-    }
+    x &= 0x1FFFFF;
+    x = (x | (x << 32)) & 0x1F00000000FFFF;
+    x = (x | (x << 16)) & 0x1F0000FF0000FF;
+    x = (x | (x << 8)) & 0x100F00F00F00F00F;
+    x = (x | (x << 4)) & 0x10C30C30C30C30C3;
+    x = (x | (x << 2)) & 0x1249249249249249;
+    return x;
 }
 
-void OctreeTracks::addTrack(int x, int y, int z, OctreeTracks::trackStruct* t)
+/**
+ * @brief Stable LSD radix sort of (key, value) pairs on the nbBits lower bits of the keys.
+ * For each 8 bits digit, the threads count the digits of contiguous chunks of the input and scatter them
+ * at offsets ordered by digit then by chunk, so the input order is kept for equal keys.
+ */
+void radixSortByKey(std::vector<std::uint64_t>& keys, std::vector<int>& values, int nbBits)
 {
-    assert(x >= 0 && x < size_);
-    assert(y >= 0 && y < size_);
-    assert(z >= 0 && z < size_);
-
-    Node** n = &root_;
-    int size = size_;
+    const std::size_t n = keys.size();
+    std::vector<std::uint64_t> keysTmp(n);
+    std::vector<int> valuesTmp(n);
+    std::vector<std::size_t> histograms(std::size_t(omp_get_max_threads()) * 256);
 
-    while(size != 1)
+    for(int shift = 0; shift < nbBits; shift += 8)
     {
-        if(*n == nullptr)
+#pragma omp parallel
         {
-            *n = new Branch();
-        }
-        else
-        {
-            size /= 2;
-            n = &reinterpret_cast<Branch*>(*n)->children[!((x & size) == 0)][!((y & size) == 0)][!((z & size) == 0)];
-        }
-    }
-
-    if(*n == nullptr)
-    {
-        *n = new trackStruct(t);
-        leafsNumber_++;
-    }
-    else
-    {
-        reinterpret_cast<trackStruct*>(*n)->addTrack(t);
-    }
-}
-
-StaticVector<OctreeTracks::trackStruct*>* OctreeTracks::getAllPoints()
-{
-    StaticVector<trackStruct*>* out = new StaticVector<trackStruct*>();
-    out->reserve(leafsNumber_);
-    if(root_ != nullptr)
-    {
-        getAllPointsRecursive(out, root_);
-    }
-    return out;
-}
-
-void OctreeTracks::getAllPointsRecursive(StaticVector<trackStruct*>* out, Node* node)
-{
-    assert(node);
-
-    switch(node->type_)
-    {
-        case BranchNode:
-        {
-            Branch* b = reinterpret_cast<Branch*>(node);
-            for(int i = 0; i < 2; ++i)
+            const int nbThreads = omp_get_num_threads();
+            const int thread = omp_get_thread_num();
+            const std::size_t chunkBegin = n * thread / nbThreads;
+            const std::size_t chunkEnd = n * (thread + 1) / nbThreads;
+            std::size_t* histogram = &histograms[thread * 256];
+
+            std::fill(histogram, histogram + 256, 0);
+            for(std::size_t i = chunkBegin; i < chunkEnd; ++i)
+                ++histogram[(keys[i] >> shift) & 0xFF];
+
+#pragma omp barrier
+#pragma omp single
             {
-                for(int j = 0; j < 2; ++j)
+                std::size_t offset = 0;
+                for(int digit = 0; digit < 256; ++digit)
                 {
-                    for(int k = 0; k < 2; ++k)
+                    for(int t = 0; t < nbThreads; ++t)
                     {
-                        if(b->children[i][j][k] != nullptr)
-                        {
-                            getAllPointsRecursive(out, b->children[i][j][k]);
-                        }
+                        const std::size_t count = histograms[t * 256 + digit];
+                        histograms[t * 256 + digit] = offset;
+                        offset += count;
                     }
                 }
             }
-        }
-        break;
-        case LeafNode:
-            out->push_back(reinterpret_cast<trackStruct*>(node));
-            break;
-    }
-}
-
-void OctreeTracks::getNPointsByLevelsRecursive(Node* node, int level, StaticVector<int>* nptsAtLevel)
-{
-    assert(node);
 
-    switch(node->type_)
-    {
-        case BranchNode:
-        {
-            Branch* b = reinterpret_cast<Branch*>(node);
-            for(int i = 0; i < 2; ++i)
+            for(std::size_t i = chunkBegin; i < chunkEnd; ++i)
             {
-                for(int j = 0; j < 2; ++j)
-                {
-                    for(int k = 0; k < 2; ++k)
-                    {
-                        if(b->children[i][j][k] != nullptr)
-                        {
-                            (*nptsAtLevel)[level + 1] += 1;
-                            getNPointsByLevelsRecursive(b->children[i][j][k], level + 1, nptsAtLevel);
-                        }
-                    }
-                }
+                const std::size_t dst = histogram[(keys[i] >> shift) & 0xFF]++;
+                keysTmp[dst] = keys[i];
+                valuesTmp[dst] = values[i];
             }
         }
-        break;
-        case LeafNode:
-            //
-            break;
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
     }
 }
 
-OctreeTracks::Branch::Branch()
-    : Node(BranchNode)
+/**
+ * @brief Track of a leaf being merged.
+ */
+struct TrackMerger
 {
-    for(int i = 0; i < 2; ++i)
+    Point3d point;
+    float minPixSize;
+    float minSim;
+    int npts;
+    /// sorted by camera index
+    std::vector<Pixel> cams;
+
+    void init(const OctreeTracks::Tracks& tracks, int i)
     {
-        for(int j = 0; j < 2; ++j)
-        {
-            for(int k = 0; k < 2; ++k)
-            {
-                children[i][j][k] = nullptr;
-            }
-        }
+        point = tracks.points[i];
+        minPixSize = tracks.minPixSize[i];
+        minSim = tracks.minSim[i];
+        npts = tracks.npts[i];
+        cams.assign(tracks.getCams(i), tracks.getCams(i) + tracks.getNbCams(i));
     }
-}
 
-OctreeTracks::Branch::~Branch()
-{
-    for(int i = 0; i < 2; ++i)
+    void add(const OctreeTracks::Tracks& tracks, int i)
     {
-        for(int j = 0; j < 2; ++j)
+        const Pixel* trackCams = tracks.getCams(i);
+        for(int c = 0; c < tracks.getNbCams(i); ++c)
         {
-            for(int k = 0; k < 2; ++k)
-            {
-                assert(children[i][j][k] != this);
-                /*
-                Node *node = children[i][j][k];
-                if (node!=NULL) {
-                        if ( node->type_ == BranchNode ) {
-                                delete reinterpret_cast<Branch*>(node);
-                        }else {
-                                if ( node->type_ == LeafNode ) {
-                                        delete reinterpret_cast<trackStruct*>(node);
-                                }else{
-                                        printf("WARNING unknows node type\n");
-                                };
-                        }
-                        node = NULL;
-                        children[i][j][k] = NULL;
-                }
-                */
-                if(children[i][j][k] != nullptr)
-                {
-                    if(children[i][j][k]->type_ == BranchNode)
-                    {
-                        delete reinterpret_cast<Branch*>(children[i][j][k]);
-                    }
-                    else
-                    {
-                        if(children[i][j][k]->type_ == LeafNode)
-                        {
-                            delete reinterpret_cast<trackStruct*>(children[i][j][k]);
-                        }
-                        else
-                        {
-                            ALICEVISION_LOG_WARNING("Unknows node type.");
-                        }
-                    }
-                    children[i][j][k] = nullptr;
-                }
-            }
+            const auto it = std::lower_bound(cams.begin(), cams.end(), trackCams[c],
+                                             [](const Pixel& a, const Pixel& b) { return a.x < b.x; });
+            if(it != cams.end() && it->x == trackCams[c].x)
+                it->y += trackCams[c].y;
+            else
+                cams.insert(it, trackCams[c]);
         }
-    }
-}
-
-OctreeTracks::trackStruct::trackStruct(float sim, float pixSize, const Point3d& p, int rc)
-    : Node(LeafNode)
-{
-    npts = 1;
-    point = p;
-    cams.reserve(10);
-    cams.push_back(Pixel(rc, 1));
-    minPixSize = pixSize;
-    minSim = sim;
-}
-
-OctreeTracks::trackStruct::trackStruct(trackStruct* t)
-    : Node(LeafNode)
-{
-    npts = t->npts;
-    point = t->point;
-    cams = t->cams;
-    minPixSize = t->minPixSize;
-    minSim = t->minSim;
-}
 
-OctreeTracks::trackStruct::~trackStruct()
-{
-}
-
-void OctreeTracks::trackStruct::addPoint(float sim, float pixSize, const Point3d& p, int rc)
-{
-    int index = indexOf(rc);
-    if(index == -1)
-    {
-        cams.push_back(Pixel(rc, 1));
-        if(cams.size() > 1)
+        // average values with good precision (precision is given by pixel size)
+        if(tracks.minPixSize[i] < minPixSize * 0.8f) // if strongly better => replace previous values
         {
-            qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
+            point = tracks.points[i];
+            minPixSize = tracks.minPixSize[i];
+            minSim = tracks.minSim[i];
+            npts = tracks.npts[i];
         }
+        else if(tracks.minPixSize[i] < minPixSize * 1.2f) // if close to the previous value => average
+        {
+            // average with previous values of the same precision
+            point = (point * (float)npts + tracks.points[i] * (float)tracks.npts[i]) / (float)(npts + tracks.npts[i]);
+            minPixSize = std::min(minPixSize, tracks.minPixSize[i]);
+            minSim = std::min(minSim, tracks.minSim[i]);
+            npts += tracks.npts[i];
+        }
+        // else don't use the position information as it is less accurate.
     }
-    else
-    {
-        cams[index].y += 1;
-    }
+};
 
-    // strategy 1: average all values
-    // point = (point * (float)npts + p) / (float)(npts + 1);
-    // minPixSize = std::min(minPixSize, pixSize);
-    // minSim = std::min(minSim, sim);
-    // npts++;
-
-    // strategy 2: keep best from nearest cam
-    // if (pixSize < minPixSize * 1.2f) // if equivalent or better than the previous value
-    //{
-    //	if ((sim < minSim) || (pixSize * 1.2f <= minPixSize))
-    //	{
-    //		point = p;
-    //		minSim = sim;
-    //	};
-    //	minPixSize = std::min(minPixSize,pixSize);
-    //};
-
-    // strategy 3: average values with good precision (precision is given by pixel size)
-    if(pixSize < minPixSize * 0.8f) // if strongly better => replace previous values
-    {
-        point = p;
-        minPixSize = pixSize;
-        minSim = sim;
-        npts = 1;
-    }
-    else if(pixSize < minPixSize * 1.2f) // if close to the previous value => average
-    {
-        // average with previous values of the same precision
-        point = (point * (float)npts + p) / (float)(npts + 1);
-        minPixSize = std::min(minPixSize, pixSize);
-        minSim = std::min(minSim, sim);
-        npts++;
-    }
-    // else don't use the position information as it is less accurate.
-}
+} // namespace
 
-void OctreeTracks::trackStruct::addDistinctNonzeroCamsFromTrackAsZeroCams(trackStruct* t)
+void OctreeTracks::Tracks::reserve(int nbTracks, std::size_t nbCams)
 {
-    for(int i = 0; i < t->cams.size(); i++)
-    {
-        if(t->cams[i].y > 0)
-        {
-            int rc = t->cams[i].x;
-            int index = indexOf(rc);
-            if(index == -1)
-            {
-                cams.push_back(Pixel(rc, 0));
-                if(cams.size() > 1)
-                {
-                    qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
-                }
-            }
-        }
-    }
+    points.reserve(nbTracks);
+    minPixSize.reserve(nbTracks);
+    minSim.reserve(nbTracks);
+    npts.reserve(nbTracks);
+    camsOffsets.reserve(nbTracks + 1);
+    cams.reserve(nbCams);
 }
 
-void OctreeTracks::trackStruct::addTrack(OctreeTracks::trackStruct* t)
+void OctreeTracks::Tracks::clear()
 {
-    for(int i = 0; i < t->cams.size(); i++)
-    {
-        int rc = t->cams[i].x;
-        int index = indexOf(rc);
-        if(index == -1)
-        {
-            cams.push_back(t->cams[i]);
-            if(cams.size() > 1)
-            {
-                qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
-            }
-        }
-        else
-        {
-            cams[index].y += t->cams[i].y;
-        }
-    }
-
-    // // to keep CG
-    // point = (point * (float)npts + t->point * (float)t->npts) / (float)(npts + t->npts);
-    // minPixSize = std::min(minPixSize, t->minPixSize);
-    // minSim = std::min(minSim, t->minSim);
-
-    // keep best from nearest cam
-    // if (t->minPixSize<minPixSize*1.2f)
-    //{
-    //	if ((t->minSim<minSim)||(minPixSize>t->minPixSize*1.2f))
-    //	{
-    //		point = t->point;
-    //		minSim = t->minSim;
-    //	};
-    //	minPixSize = std::min(minPixSize,t->minPixSize);
-    //};
-
-    // strategy 3: average values with good precision (precision is given by pixel size)
-    if(t->minPixSize < minPixSize * 0.8f) // if strongly better => replace previous values
-    {
-        point = t->point;
-        minPixSize = t->minPixSize;
-        minSim = t->minSim;
-        npts = t->npts;
-    }
-    else if(t->minPixSize < minPixSize * 1.2f) // if close to the previous value => average
-    {
-        // average with previous values of the same precision
-        point = (point * (float)npts + t->point * (float)t->npts) / (float)(npts + t->npts);
-        minPixSize = std::min(minPixSize, t->minPixSize);
-        minSim = std::min(minSim, t->minSim);
-        npts += t->npts;
-    }
-    // else don't use the position information as it is less accurate.
+    points.clear();
+    minPixSize.clear();
+    minSim.clear();
+    npts.clear();
+    camsOffsets.assign(1, 0);
+    cams.clear();
 }
 
-int OctreeTracks::trackStruct::indexOf(int val)
+void OctreeTracks::Tracks::swap(Tracks& other)
 {
-    if(cams.size() == 0)
-    {
-        return -1;
-    }
-
-    int lef = 0;
-    int rig = cams.size() - 1;
-    int mid = lef + (rig - lef) / 2;
-    while((rig - lef) > 1)
-    {
-        if((val >= cams[lef].x) && (val < cams[mid].x))
-        {
-            //lef = lef;
-            rig = mid;
-            mid = lef + (rig - lef) / 2;
-        }
-        if((val >= cams[mid].x) && (val <= cams[rig].x))
-        {
-            lef = mid;
-            //rig = rig;
-            mid = lef + (rig - lef) / 2;
-        }
-        if((val < cams[lef].x) || (val > cams[rig].x))
-        {
-            lef = 0;
-            rig = 0;
-            mid = 0;
-        }
-    }
-
-    int id = -1;
-    if(val == cams[lef].x)
-    {
-        id = lef;
-    }
-    if(val == cams[rig].x)
-    {
-        id = rig;
-    }
-
-    // printf("index of %f is %i\n", (float)val, id);
+    points.swap(other.points);
+    minPixSize.swap(other.minPixSize);
+    minSim.swap(other.minSim);
+    npts.swap(other.npts);
+    camsOffsets.swap(other.camsOffsets);
+    cams.swap(other.cams);
+}
 
-    return id;
+void OctreeTracks::Tracks::push_back(const Point3d& point, float trackMinPixSize, float trackMinSim, int trackNpts,
+                                     const Pixel* trackCams, int nbTrackCams)
+{
+    points.push_back(point);
+    minPixSize.push_back(trackMinPixSize);
+    minSim.push_back(trackMinSim);
+    npts.push_back(trackNpts);
+    cams.insert(cams.end(), trackCams, trackCams + nbTrackCams);
+    camsOffsets.push_back(cams.size());
 }
 
-void OctreeTracks::trackStruct::doPrintf()
+void OctreeTracks::Tracks::push_back(const Tracks& other, int i)
 {
-    ALICEVISION_LOG_INFO("point: " << point.x << " " << point.y << " " << point.z);
-    ALICEVISION_LOG_INFO("ncams: " << cams.size());
-    for(int i = 0; i < cams.size(); i++)
-        ALICEVISION_LOG_INFO("\t- cam: " << i << ", rc: " << cams[i].x << ", val: " << cams[i].y);
+    push_back(other.points[i], other.minPixSize[i], other.minSim[i], other.npts[i], other.getCams(i), other.getNbCams(i));
 }
 
 OctreeTracks::OctreeTracks(const Point3d* _voxel, mvsUtils::MultiViewParams* _mp, Voxel dimensions)
@@ -493,28 +226,170 @@ OctreeTracks::OctreeTracks(const Point3d* _voxel, mvsUtils::MultiViewParams* _mp
     minNumOfConsistentCams = mp->userParams.get<int>("filter.minNumOfConsistentCams", 2);
     simWspThr = (float)mp->userParams.get<double>("LargeScale.simWspThr", -0.0f);
 
-    int maxNumSubVoxs = std::max(std::max(numSubVoxsX, numSubVoxsY), numSubVoxsZ);
-    size_ = 2;
-    while(size_ < maxNumSubVoxs)
+    const int maxNumSubVoxs = std::max(std::max(numSubVoxsX, numSubVoxsY), numSubVoxsZ);
+    int size = 2;
+    _depth = 1;
+    while(size < maxNumSubVoxs)
+    {
+        size *= 2;
+        ++_depth;
+    }
+    if(_depth > maxOctreeDepth)
+        throw std::runtime_error("OctreeTracks: too many sub-voxels per axis (" + std::to_string(maxNumSubVoxs) + ").");
+}
+
+std::uint64_t OctreeTracks::getMortonCode(const Voxel& v) const
+{
+    return spreadBits21(v.x) | (spreadBits21(v.y) << 1) | (spreadBits21(v.z) << 2);
+}
+
+int OctreeTracks::getTrack(int x, int y, int z) const
+{
+    const int size = 1 << _depth;
+    if(!((x >= 0 && x < size) && (y >= 0 && y < size) && (z >= 0 && z < size)))
     {
-        size_ *= 2;
+        return -1;
     }
 
-    root_ = nullptr;
-    leafsNumber_ = 0;
+    const std::uint64_t code = getMortonCode(Voxel(x, y, z));
+    const auto it = std::lower_bound(_codes.begin(), _codes.end(), code);
+    if(it == _codes.end() || *it != code)
+    {
+        return -1;
+    }
+    return it - _codes.begin();
+}
+
+void OctreeTracks::getNPointsByLevels(StaticVector<int>& nptsAtLevel) const
+{
+    nptsAtLevel.clear();
+    nptsAtLevel.resize_with(_depth + 1, 0);
+
+    // the nodes of a level are the distinct prefixes of the leaves codes
+    for(int level = 0; level <= _depth; ++level)
+    {
+        const int shift = 3 * (_depth - level);
+        int nbNodes = 0;
+        for(std::size_t i = 0; i < _codes.size(); ++i)
+        {
+            if(i == 0 || (_codes[i] >> shift) != (_codes[i - 1] >> shift))
+                ++nbNodes;
+        }
+        nptsAtLevel[level] = nbNodes;
+    }
 }
 
-OctreeTracks::~OctreeTracks()
+void OctreeTracks::mergeTracks(const Tracks& tracksIn, const std::vector<std::uint64_t>& codes, const std::vector<int>& order)
 {
-    // printf("deleting octree\n");
-    if(root_ != nullptr)
+    // first input index of each leaf
+    std::vector<std::size_t> groupsBegin;
+    for(std::size_t i = 0; i < codes.size(); ++i)
+    {
+        if(i == 0 || codes[i] != codes[i - 1])
+            groupsBegin.push_back(i);
+    }
+    const int nbGroups = groupsBegin.size();
+    groupsBegin.push_back(codes.size());
+
+    // merge the sorted codes of the existing leaves and of the input leaves
+    std::vector<std::uint64_t> outCodes;
+    std::vector<int> outExistingTracks; // -1 if new leaf
+    std::vector<int> outGroups; // -1 if no input track
+    outCodes.reserve(_codes.size() + nbGroups);
+    outExistingTracks.reserve(_codes.size() + nbGroups);
+    outGroups.reserve(_codes.size() + nbGroups);
+    {
+        int existingTrack = 0;
+        int group = 0;
+        while(existingTrack < _codes.size() || group < nbGroups)
+        {
+            const bool hasExisting = existingTrack < _codes.size();
+            const bool hasGroup = group < nbGroups;
+            const std::uint64_t existingCode = hasExisting ? _codes[existingTrack] : 0;
+            const std::uint64_t groupCode = hasGroup ? codes[groupsBegin[group]] : 0;
+
+            if(hasExisting && (!hasGroup || existingCode <= groupCode))
+            {
+                const bool sameLeaf = hasGroup && existingCode == groupCode;
+                outCodes.push_back(existingCode);
+                outExistingTracks.push_back(existingTrack++);
+                outGroups.push_back(sameLeaf ? group++ : -1);
+            }
+            else
+            {
+                outCodes.push_back(groupCode);
+                outExistingTracks.push_back(-1);
+                outGroups.push_back(group++);
+            }
+        }
+    }
+    const int nbLeaves = outCodes.size();
+
+    Tracks outTracks;
+    outTracks.points.resize(nbLeaves);
+    outTracks.minPixSize.resize(nbLeaves);
+    outTracks.minSim.resize(nbLeaves);
+    outTracks.npts.resize(nbLeaves);
+    outTracks.camsOffsets.assign(nbLeaves + 1, 0);
+
+    // each thread merges a contiguous range of leaves and stores their cameras,
+    // so the cameras of the threads are concatenated in the leaves order
+    std::vector<std::vector<Pixel>> threadsCams(omp_get_max_threads());
+#pragma omp parallel
+    {
+        const int nbThreads = omp_get_num_threads();
+        const int thread = omp_get_thread_num();
+        const int leafBegin = std::size_t(nbLeaves) * thread / nbThreads;
+        const int leafEnd = std::size_t(nbLeaves) * (thread + 1) / nbThreads;
+        std::vector<Pixel>& cams = threadsCams[thread];
+        TrackMerger merger;
+
+        for(int leaf = leafBegin; leaf < leafEnd; ++leaf)
+        {
+            const int group = outGroups[leaf];
+            std::size_t inBegin = 0;
+            std::size_t inEnd = 0;
+            if(group != -1)
+            {
+                inBegin = groupsBegin[group];
+                inEnd = groupsBegin[group + 1];
+            }
+
+            if(outExistingTracks[leaf] != -1)
+            {
+                merger.init(_tracks, outExistingTracks[leaf]);
+            }
+            else
+            {
+                merger.init(tracksIn, order[inBegin]);
+                ++inBegin;
+            }
+            for(std::size_t i = inBegin; i < inEnd; ++i)
+                merger.add(tracksIn, order[i]);
+
+            outTracks.points[leaf] = merger.point;
+            outTracks.minPixSize[leaf] = merger.minPixSize;
+            outTracks.minSim[leaf] = merger.minSim;
+            outTracks.npts[leaf] = merger.npts;
+            outTracks.camsOffsets[leaf + 1] = merger.cams.size();
+            cams.insert(cams.end(), merger.cams.begin(), merger.cams.end());
+        }
+    }
+
+    for(int leaf = 0; leaf < nbLeaves; ++leaf)
+        outTracks.camsOffsets[leaf + 1] += outTracks.camsOffsets[leaf];
+    outTracks.cams.reserve(outTracks.camsOffsets.back());
+    for(std::vector<Pixel>& cams: threadsCams)
     {
-        delete reinterpret_cast<Branch*>(root_);
+        outTracks.cams.insert(outTracks.cams.end(), cams.begin(), cams.end());
+        std::vector<Pixel>().swap(cams);
     }
-    // printf("deleted\n");
+
+    _codes.swap(outCodes);
+    _tracks.swap(outTracks);
 }
 
-bool OctreeTracks::getVoxelOfOctreeFor3DPoint(Voxel& out, Point3d& tp)
+bool OctreeTracks::getVoxelOfOctreeFor3DPoint(Voxel& out, const Point3d& tp) const
 {
     out.x = (int)floor(orientedPointPlaneDistance(tp, O, vx) / sx);
     out.y = (int)floor(orientedPointPlaneDistance(tp, O, vy) / sy);
@@ -523,12 +398,12 @@ bool OctreeTracks::getVoxelOfOctreeFor3DPoint(Voxel& out, Point3d& tp)
             (out.z < numSubVoxsZ));
 }
 
-void OctreeTracks::filterMinNumConsistentCams(StaticVector<trackStruct*>* tracks)
+void OctreeTracks::filterMinNumConsistentCams(std::vector<int>& tracksIds) const
 {
     using namespace boost::accumulators;
 
-    StaticVector<trackStruct*> tracksOut;
-    tracksOut.reserve(tracks->size());
+    std::vector<int> tracksIdsOut;
+    tracksIdsOut.reserve(tracksIds.size());
     typedef accumulator_set<float,
       stats<
         tag::min,
@@ -540,21 +415,18 @@ void OctreeTracks::filterMinNumConsistentCams(StaticVector<trackStruct*>* tracks
     Accumulator accNbCamsA;
     Accumulator accNbCamsB;
 
-    // long t1 = initEstimate();
-    for(int i = 0; i < tracks->size(); i++)
+    for(const int trackId: tracksIds)
     {
-        trackStruct* t = (*tracks)[i];
-        accNbCamsA(t->cams.size());
-        if(t->cams.size() >= minNumOfConsistentCams)
+        const int nbCams = _tracks.getNbCams(trackId);
+        accNbCamsA(nbCams);
+        if(nbCams >= minNumOfConsistentCams)
         {
-            tracksOut.push_back((*tracks)[i]);
-            accMinPixSize(t->minPixSize);
-            accMinSim(t->minSim);
-            accNbCamsB(t->cams.size());
-        } // ELSE DO NOT DELETE BECAUSE IT IS POINTER TO THE STRUCTURE
-        // printfEstimate(i, tracks->size(), t1);
+            tracksIdsOut.push_back(trackId);
+            accMinPixSize(_tracks.minPixSize[trackId]);
+            accMinSim(_tracks.minSim[trackId]);
+            accNbCamsB(nbCams);
+        }
     }
-    // finishEstimate();
 
     ALICEVISION_LOG_INFO("filterMinNumConsistentCams: " << std::endl
       << "\t- minPixelSize min: " << boost::accumulators::min(accMinPixSize) << ", max: " << boost::accumulators::max(accMinPixSize) << ", mean: " << boost::accumulators::mean(accMinPixSize) << ", median: " << boost::accumulators::median(accMinPixSize) << std::endl
@@ -562,113 +434,61 @@ void OctreeTracks::filterMinNumConsistentCams(StaticVector<trackStruct*>* tracks
       << "\t- accNbCamsA min: " << boost::accumulators::min(accNbCamsA) << ", max: " << boost::accumulators::max(accNbCamsA) << ", mean: " << boost::accumulators::mean(accNbCamsA) << ", median: " << boost::accumulators::median(accNbCamsA) << std::endl
       << "\t- accNbCamsB min: " << boost::accumulators::min(accNbCamsB) << ", max: " << boost::accumulators::max(accNbCamsB) << ", mean: " << boost::accumulators::mean(accNbCamsB) << ", median: " << boost::accumulators::median(accNbCamsB) << std::endl);
 
-    tracks->swap(tracksOut);
-}
-
-// TODO this is not working well ...
-// if there are two neighbouring voxels and their representants are closer than
-// 1.2 minpixsize of each of them then they must have the same set of cameras
-// this should preserve the case when the density of points is smaller than sx
-void OctreeTracks::updateOctreeTracksCams(StaticVector<trackStruct*>* tracks)
-{
-    float clusterSizeThr = 1.2f;
-
-    // long t1 = initEstimate();
-    for(int i = 0; i < tracks->size(); i++)
-    {
-        int n = (int)ceil(((*tracks)[i]->minPixSize * clusterSizeThr) / sx);
-        Voxel vox;
-        if((n > 1) && (getVoxelOfOctreeFor3DPoint(vox, (*tracks)[i]->point)))
-        {
-            // printf("n %i\n",n);
-            for(int xp = -n; xp <= n; xp++)
-            {
-                for(int yp = -n; yp <= n; yp++)
-                {
-                    for(int zp = -n; zp <= n; zp++)
-                    {
-                        if((xp == 0) && (yp == 0) && (zp == 0))
-                        {
-                            assert(getTrack(vox.x + xp, vox.y + yp, vox.z + zp) == (*tracks)[i]);
-                            continue;
-                        }
-                        trackStruct* neighborTrack = getTrack(vox.x + xp, vox.y + yp, vox.z + zp);
-                        if(neighborTrack != nullptr)
-                        {
-                            trackStruct& currentTrack = *(*tracks)[i];
-                            const float dist = (currentTrack.point - neighborTrack->point).size();
-                            if((dist < currentTrack.minPixSize * 1.2f) || (dist < neighborTrack->minPixSize * 1.2f))
-                               // (nt->minPixSize < (*tracks)[i]->minPixSize * 1.2f) && ((*tracks)[i]->minPixSize < nt->minPixSize * 1.2f)
-                            {
-                                // currentTrack.cams
-
-                                currentTrack.addDistinctNonzeroCamsFromTrackAsZeroCams(neighborTrack);
-                                neighborTrack->addDistinctNonzeroCamsFromTrackAsZeroCams((*tracks)[i]);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-    // finishEstimate();
+    tracksIds.swap(tracksIdsOut);
 }
 
 /// if there is in near distance to actual track another track that has
 /// smaller enough pix size then remove the actual track
-void OctreeTracks::filterOctreeTracks2(StaticVector<trackStruct*>* tracks)
+void OctreeTracks::filterOctreeTracks2(std::vector<int>& tracksIds) const
 {
     if(mp->verbose)
         ALICEVISION_LOG_DEBUG("filterOctreeTracks2");
-    StaticVector<trackStruct*> tracksOut;
-    tracksOut.reserve(tracks->size());
 
-    float clusterSizeThr = mp->userParams.get<double>("OctreeTracks.clusterSizeThr", 2.0f);
+    const float clusterSizeThr = mp->userParams.get<double>("OctreeTracks.clusterSizeThr", 2.0f);
 
-    // long t1 = initEstimate();
-    for(int i = 0; i < tracks->size(); i++)
+    std::vector<char> keepTracks(tracksIds.size(), 1);
+#pragma omp parallel for
+    for(int i = 0; i < tracksIds.size(); i++)
     {
-        int n = (int)ceil(((*tracks)[i]->minPixSize * clusterSizeThr) / sx);
+        const int trackId = tracksIds[i];
+        const float trackMinPixSize = _tracks.minPixSize[trackId];
+        const int n = (int)ceil((trackMinPixSize * clusterSizeThr) / sx);
 
         bool ok = true;
-        Voxel vox;
-        if((n > 1) && (getVoxelOfOctreeFor3DPoint(vox, (*tracks)[i]->point)))
+        Voxel v;
+        if((n > 1) && (getVoxelOfOctreeFor3DPoint(v, _tracks.points[trackId])))
         {
-            // printf("n %i\n",n);
-            for(int xp = -n; xp <= n; xp++)
+            for(int xp = -n; ok && xp <= n; xp++)
             {
-                for(int yp = -n; yp <= n; yp++)
+                for(int yp = -n; ok && yp <= n; yp++)
                 {
-                    for(int zp = -n; zp <= n; zp++)
+                    for(int zp = -n; ok && zp <= n; zp++)
                     {
-                        trackStruct* nt = getTrack(vox.x + xp, vox.y + yp, vox.z + zp);
                         if((xp == 0) && (yp == 0) && (zp == 0))
+                            continue;
+                        const int nt = getTrack(v.x + xp, v.y + yp, v.z + zp);
+                        if((nt != -1) && (trackMinPixSize > _tracks.minPixSize[nt] * 1.2f))
                         {
-                            assert(nt == (*tracks)[i]);
-                        }
-                        else
-                        {
-                            if((nt != nullptr) && ((*tracks)[i]->minPixSize > nt->minPixSize * 1.2f))
-                            {
-                                ok = false;
-                            }
+                            ok = false;
                         }
                     }
                 }
             }
         }
-        if(ok)
-        {
-            tracksOut.push_back((*tracks)[i]);
-        } // ELSE DO NOT DELETE BECAUSE IT IS POINTER TO THE STRUCTURE
-        // printfEstimate(i, tracks->size(), t1);
+        keepTracks[i] = ok;
     }
-    // finishEstimate();
 
-    tracks->swap(tracksOut);
+    std::vector<int> tracksIdsOut;
+    tracksIdsOut.reserve(tracksIds.size());
+    for(int i = 0; i < tracksIds.size(); i++)
+    {
+        if(keepTracks[i])
+            tracksIdsOut.push_back(tracksIds[i]);
+    }
+    tracksIds.swap(tracksIdsOut);
 }
 
-StaticVector<OctreeTracks::trackStruct*>* OctreeTracks::fillOctree(int maxPts, std::string depthMapsPtsSimsTmpDir)
+bool OctreeTracks::fillOctree(Tracks& tracks, int maxPts, const std::string& depthMapsPtsSimsTmpDir)
 {
     long t1 = clock();
     StaticVector<int> cams = mp->findCamsWhichIntersectsHexahedron(vox, depthMapsPtsSimsTmpDir + "minMaxDepths.bin");
@@ -679,134 +499,172 @@ StaticVector<OctreeTracks::trackStruct*>* OctreeTracks::fillOctree(int maxPts, s
 
     t1 = clock();
 
+    _codes.clear();
+    _tracks.clear();
 
-    // long t1=initEstimate();
-    for(int camid = 0; camid < cams.size(); camid++)
+    // The points are loaded by batches of cameras (one camera per thread), sorted by leaf
+    // and merged into the octree in the cameras order.
+    const int nbCamsPerBatch = omp_get_max_threads();
+    std::vector<Tracks> camsPoints(nbCamsPerBatch);
+    std::vector<std::vector<std::uint64_t>> camsCodes(nbCamsPerBatch);
+    for(int batchBegin = 0; batchBegin < cams.size(); batchBegin += nbCamsPerBatch)
     {
-        int rc = cams[camid];
-        StaticVector<Point3d>* pts =
-            loadArrayFromFile<Point3d>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "pts.bin");
-        StaticVector<float>* sims =
-            loadArrayFromFile<float>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "sims.bin");
-
-        // long tpts=initEstimate();
-        for(int i = 0; i < pts->size(); i++)
-        {
-            float sim = (*sims)[i];
-            Point3d p = (*pts)[i];
+        const int batchSize = std::min(nbCamsPerBatch, cams.size() - batchBegin);
 
-            Voxel otVox;
-            if(((doUseWeaklySupportedPoints) || (sim < simWspThr)) && (getVoxelOfOctreeFor3DPoint(otVox, p))) // doUseWeaklySupportedPoints: false by default
+#pragma omp parallel for schedule(dynamic)
+        for(int b = 0; b < batchSize; ++b)
+        {
+            const int rc = cams[batchBegin + b];
+            Tracks& points = camsPoints[b];
+            std::vector<std::uint64_t>& codes = camsCodes[b];
+            points.clear();
+            codes.clear();
+
+            StaticVector<Point3d>* pts =
+                loadArrayFromFile<Point3d>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "pts.bin");
+            StaticVector<float>* sims =
+                loadArrayFromFile<float>(depthMapsPtsSimsTmpDir + std::to_string(mp->getViewId(rc)) + "sims.bin");
+
+            const Pixel cam(rc, 1);
+            for(int i = 0; i < pts->size(); i++)
             {
-                if(doUseWeaklySupportedPointCam)
+                float sim = (*sims)[i];
+                const Point3d& p = (*pts)[i];
+
+                Voxel otVox;
+                if(((doUseWeaklySupportedPoints) || (sim < simWspThr)) && (getVoxelOfOctreeFor3DPoint(otVox, p))) // doUseWeaklySupportedPoints: false by default
                 {
-                    if(sim > 1.0f)
+                    if(doUseWeaklySupportedPointCam)
                     {
-                        sim -= 2.0f;
+                        if(sim > 1.0f)
+                        {
+                            sim -= 2.0f;
+                        }
                     }
+                    const float pixSize = mp->getCamPixelSize(p, rc);
+                    points.push_back(p, pixSize, sim, 1, &cam, 1);
+                    codes.push_back(getMortonCode(otVox));
                 }
-                float pixSize = mp->getCamPixelSize(p, rc);
-                addPoint(otVox.x, otVox.y, otVox.z, sim, pixSize, p, rc);
-            }
-            if(leafsNumber_ > 2 * maxPts)
-            {
-                return nullptr;
             }
 
-            // printfEstimate(i, pts->size(), tpts);
-        } // for i
-          // finishEstimate();
+            delete pts;
+            delete sims;
+        }
+
+        // each point is a track with a single camera
+        std::size_t nbPoints = 0;
+        for(int b = 0; b < batchSize; ++b)
+            nbPoints += camsPoints[b].size();
 
-        delete pts;
-        delete sims;
+        Tracks batchPoints;
+        std::vector<std::uint64_t> batchCodes;
+        batchPoints.reserve(nbPoints, nbPoints);
+        batchCodes.reserve(nbPoints);
+        for(int b = 0; b < batchSize; ++b)
+        {
+            for(int i = 0; i < camsPoints[b].size(); ++i)
+                batchPoints.push_back(camsPoints[b], i);
+            batchCodes.insert(batchCodes.end(), camsCodes[b].begin(), camsCodes[b].end());
+        }
 
-        // printfEstimate(camid, cams.size(), t1);
+        std::vector<int> order(batchCodes.size());
+        std::iota(order.begin(), order.end(), 0);
+        radixSortByKey(batchCodes, order, 3 * _depth);
+        mergeTracks(batchPoints, batchCodes, order);
+
+        if(getNbLeaves() > 2 * maxPts)
+        {
+            return false;
+        }
     }
-    // finishEstimate();
 
-    StaticVector<trackStruct*>* tracks = getAllPoints();
     if(mp->verbose)
         mvsUtils::printfElapsedTime(t1, "fillOctree fill");
 
-    // TODO this is not working well ...
-    // updateOctreeTracksCams(tracks);
-    // if (mp->verbose) printfElapsedTime(t1,"updateOctreeTracksCams");
+    std::vector<int> tracksIds(getNbLeaves());
+    std::iota(tracksIds.begin(), tracksIds.end(), 0);
 
     if(doFilterOctreeTracks)
     {
         if(mp->verbose)
-            ALICEVISION_LOG_DEBUG("# tracks before filtering: " << tracks->size());
+            ALICEVISION_LOG_DEBUG("# tracks before filtering: " << tracksIds.size());
         long t2 = clock();
 
-        filterMinNumConsistentCams(tracks);
+        filterMinNumConsistentCams(tracksIds);
         if(mp->verbose)
             mvsUtils::printfElapsedTime(t2, "filterMinNumConsistentCams");
 
         if(mp->verbose)
-            ALICEVISION_LOG_DEBUG("# tracks after filterMinNumConsistentCams: " << tracks->size());
+            ALICEVISION_LOG_DEBUG("# tracks after filterMinNumConsistentCams: " << tracksIds.size());
 
         t2 = clock();
         // filter cameras observations that have a large pixelSize regarding the others
-        filterOctreeTracks2(tracks);
+        filterOctreeTracks2(tracksIds);
 
         if(mp->verbose)
             mvsUtils::printfElapsedTime(t2, "filterOctreeTracks2");
 
         if(mp->verbose)
-            ALICEVISION_LOG_DEBUG("# tracks after filterOctreeTracks2: " << tracks->size());
+            ALICEVISION_LOG_DEBUG("# tracks after filterOctreeTracks2: " << tracksIds.size());
         if(mp->verbose)
-            ALICEVISION_LOG_DEBUG("# tracks after filtering: " << tracks->size());
+            ALICEVISION_LOG_DEBUG("# tracks after filtering: " << tracksIds.size());
     }
 
-    if(tracks->size() > maxPts)
+    if(tracksIds.size() > maxPts)
     {
         if(mp->verbose)
-            ALICEVISION_LOG_DEBUG("Too much tracks (" << tracks->size() << "), clear all.");
-        delete tracks; // DO NOT DELETE POINTER JUST DELETE THE ARRAY!!!
-        return nullptr;
+            ALICEVISION_LOG_DEBUG("Too much tracks (" << tracksIds.size() << "), clear all.");
+        return false;
     }
 
+    tracks.clear();
+    tracks.reserve(tracksIds.size(), _tracks.cams.size());
+    for(const int trackId: tracksIds)
+        tracks.push_back(_tracks, trackId);
+
     if(mp->verbose)
-        ALICEVISION_LOG_DEBUG("number of tracks: " << tracks->size());
+        ALICEVISION_LOG_DEBUG("number of tracks: " << tracks.size());
 
-    return tracks;
+    return true;
 }
 
-StaticVector<OctreeTracks::trackStruct*>*
-OctreeTracks::fillOctreeFromTracks(StaticVector<OctreeTracks::trackStruct*>* tracksIn)
+void OctreeTracks::fillOctreeFromTracks(const Tracks& tracksIn)
 {
     long t1 = clock();
 
-    for(int i = 0; i < tracksIn->size(); i++)
+    _codes.clear();
+    _tracks.clear();
+
+    std::vector<std::uint64_t> codes;
+    std::vector<int> order;
+    codes.reserve(tracksIn.size());
+    order.reserve(tracksIn.size());
+    for(int i = 0; i < tracksIn.size(); i++)
     {
-        trackStruct* t = (*tracksIn)[i];
         Voxel otVox;
-        if(getVoxelOfOctreeFor3DPoint(otVox, t->point))
+        if(getVoxelOfOctreeFor3DPoint(otVox, tracksIn.points[i]))
         {
-            addTrack(otVox.x, otVox.y, otVox.z, t);
+            codes.push_back(getMortonCode(otVox));
+            order.push_back(i);
         }
-    } // for i
+    }
 
-    StaticVector<trackStruct*>* tracks = getAllPoints();
+    radixSortByKey(codes, order, 3 * _depth);
+    mergeTracks(tracksIn, codes, order);
 
     if(mp->verbose)
         mvsUtils::printfElapsedTime(t1, "fillOctreeFromTracks");
-
-    return tracks;
 }
 
-StaticVector<int>* OctreeTracks::getTracksCams(StaticVector<OctreeTracks::trackStruct*>* tracks)
+StaticVector<int>* OctreeTracks::getTracksCams(const Tracks& tracks) const
 {
     StaticVectorBool* camsb = new StaticVectorBool();
     camsb->reserve(mp->ncams);
     camsb->resize_with(mp->ncams, false);
 
-    for(int i = 0; i < tracks->size(); i++)
+    for(const Pixel& cam: tracks.cams)
     {
-        for(int c = 0; c < (*tracks)[i]->cams.size(); c++)
-        {
-            (*camsb)[(*tracks)[i]->cams[c].x] = true;
-        }
+        (*camsb)[cam.x] = true;
     }
 
     StaticVector<int>* cams = new StaticVector<int>();
@@ -13,67 +13,51 @@
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/fuseCut/Fuser.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace aliceVision {
 namespace fuseCut {
 
+/**
+ * @brief Linear octree of tracks.
+ *
+ * The octree leaves are the sub-voxels of the voxel. Only the occupied leaves are stored, sorted by Morton code,
+ * with their tracks in compact arrays. The octree is built by sorting the input points by Morton code
+ * (parallel radix sort) and by merging the points of each leaf in their input order, without any node allocation.
+ */
 class OctreeTracks : public Fuser
 {
 public:
-    enum NodeType
-    {
-        BranchNode,
-        LeafNode
-    };
-
-    class Node
-    {
-    public:
-        NodeType type_ : 2;
-
-        explicit Node(NodeType type);
-        ~Node(){};
-    };
-
-    class Branch : public Node
-    {
-    public:
-        Node* children[2][2][2];
-
-        Branch();
-        ~Branch();
-    };
-
-    class trackStruct : public Node
+    /**
+     * @brief Tracks stored in compact arrays.
+     * The cameras of the track i are cams[camsOffsets[i]] to cams[camsOffsets[i + 1] - 1], sorted by camera index.
+     * Each camera is stored as Pixel(camera index, number of points of the camera in the track).
+     */
+    struct Tracks
     {
-    public:
-        int npts;
-        Point3d point;
-        StaticVector<Pixel> cams;
-        float minPixSize;
-        float minSim;
-
-        explicit trackStruct(trackStruct* t);
-        trackStruct(float sim, float pixSize, const Point3d& p, int rc);
-        ~trackStruct();
-        void resizeCamsAdd(int nadd);
-        void addPoint(float sim, float pixSize, const Point3d& p, int rc);
-        void addTrack(trackStruct* t);
-        void addDistinctNonzeroCamsFromTrackAsZeroCams(trackStruct* t);
-        int indexOf(int val);
-        void doPrintf();
+        std::vector<Point3d> points;
+        std::vector<float> minPixSize;
+        std::vector<float> minSim;
+        std::vector<int> npts;
+        std::vector<std::size_t> camsOffsets = {0};
+        std::vector<Pixel> cams;
+
+        int size() const { return points.size(); }
+        int getNbCams(int i) const { return camsOffsets[i + 1] - camsOffsets[i]; }
+        const Pixel* getCams(int i) const { return cams.data() + camsOffsets[i]; }
+
+        void reserve(int nbTracks, std::size_t nbCams);
+        void clear();
+        void swap(Tracks& other);
+        void push_back(const Point3d& point, float trackMinPixSize, float trackMinSim, int trackNpts,
+                       const Pixel* trackCams, int nbTrackCams);
+        /// append the track i of other
+        void push_back(const Tracks& other, int i);
     };
 
-    Node* root_;
-    int size_;
-    int leafsNumber_;
-
-    // trackStruct* at( int x, int y, int z );
-    trackStruct* getTrack(int x, int y, int z);
-    void addTrack(int x, int y, int z, trackStruct* t);
-    void addPoint(int x, int y, int z, float sim, float pixSize, Point3d& p, int rc);
-    StaticVector<trackStruct*>* getAllPoints();
-    void getAllPointsRecursive(StaticVector<trackStruct*>* out, Node* node);
-
     Point3d O, vx, vy, vz;
     float sx, sy, sz, svx, svy, svz;
 
@@ -88,19 +72,53 @@ public:
     float simWspThr;
 
     OctreeTracks(const Point3d* _voxel, mvsUtils::MultiViewParams* _mp, Voxel dimensions);
-    ~OctreeTracks();
 
-    float computeAveragePixelSizeForVoxel();
-    bool getVoxelOfOctreeFor3DPoint(Voxel& out, Point3d& tp);
+    /// number of occupied leaves
+    int getNbLeaves() const { return _codes.size(); }
+
+    /// index of the track of the sub-voxel (x, y, z), -1 if the sub-voxel is empty
+    int getTrack(int x, int y, int z) const;
+
+    /// tracks of all the occupied leaves, sorted by Morton code
+    const Tracks& getAllPoints() const { return _tracks; }
+
+    /// number of nodes at each level of the octree (from the root to the leaves)
+    void getNPointsByLevels(StaticVector<int>& nptsAtLevel) const;
+
+    bool getVoxelOfOctreeFor3DPoint(Voxel& out, const Point3d& tp) const;
+
+    void filterMinNumConsistentCams(std::vector<int>& tracksIds) const;
+    void filterOctreeTracks2(std::vector<int>& tracksIds) const;
+
+    /**
+     * @brief Fill the octree with the points of the depth maps of the cameras intersecting the voxel, and filter the tracks.
+     * @param[out] tracks the filtered tracks
+     * @return false if there are too many tracks (more than maxPts)
+     */
+    bool fillOctree(Tracks& tracks, int maxPts, const std::string& depthMapsPtsSimsTmpDir);
+
+    /// Fill the octree with tracks, the tracks in the same leaf are merged in their input order.
+    void fillOctreeFromTracks(const Tracks& tracksIn);
+
+    StaticVector<int>* getTracksCams(const Tracks& tracks) const;
+
+private:
+    std::uint64_t getMortonCode(const Voxel& v) const;
 
-    void filterMinNumConsistentCams(StaticVector<trackStruct*>* tracks);
+    /**
+     * @brief Merge the input tracks into the octree.
+     * @param[in] tracksIn the input tracks
+     * @param[in] codes the Morton codes of the input tracks leaves, sorted
+     * @param[in] order the index of the input track of each code, in input order for the same code
+     */
+    void mergeTracks(const Tracks& tracksIn, const std::vector<std::uint64_t>& codes, const std::vector<int>& order);
 
-    void filterOctreeTracks2(StaticVector<trackStruct*>* tracks);
-    void updateOctreeTracksCams(StaticVector<trackStruct*>* tracks);
-    StaticVector<trackStruct*>* fillOctreeFromTracks(StaticVector<trackStruct*>* tracksIn);
-    StaticVector<trackStruct*>* fillOctree(int maxPts, std::string depthMapsPtsSimsTmpDir);
-    StaticVector<int>* getTracksCams(StaticVector<OctreeTracks::trackStruct*>* tracks);
-    void getNPointsByLevelsRecursive(Node* node, int level, StaticVector<int>* nptsAtLevel);
+    /// log2 of the octree size
+    int _depth;
+    /// Morton codes of the occupied leaves, sorted
+    std::vector<std::uint64_t> _codes;
+    /// track of each occupied leaf
+    Tracks _tracks;
 };
 
 } // namespace fuseCut
@@ -0,0 +1,425 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/OctreeTracks.hpp>
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#define BOOST_TEST_MODULE fuseCutOctreeTracks
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace {
+
+/**
+ * @brief The former pointer based octree of tracks, kept as a reference.
+ */
+class ReferenceOctree
+{
+public:
+    struct Node
+    {
+        explicit Node(bool leaf)
+            : isLeaf(leaf)
+        {}
+        virtual ~Node() = default;
+
+        bool isLeaf;
+    };
+
+    struct Branch : public Node
+    {
+        Branch()
+            : Node(false)
+        {}
+
+        std::unique_ptr<Node> children[2][2][2];
+    };
+
+    struct Track : public Node
+    {
+        Track(const OctreeTracks::Tracks& tracks, int i)
+            : Node(true)
+        {
+            point = tracks.points[i];
+            minPixSize = tracks.minPixSize[i];
+            minSim = tracks.minSim[i];
+            npts = tracks.npts[i];
+            cams.assign(tracks.getCams(i), tracks.getCams(i) + tracks.getNbCams(i));
+        }
+
+        int indexOf(int val) const
+        {
+            if(cams.size() == 0)
+            {
+                return -1;
+            }
+
+            int lef = 0;
+            int rig = cams.size() - 1;
+            int mid = lef + (rig - lef) / 2;
+            while((rig - lef) > 1)
+            {
+                if((val >= cams[lef].x) && (val < cams[mid].x))
+                {
+                    rig = mid;
+                    mid = lef + (rig - lef) / 2;
+                }
+                if((val >= cams[mid].x) && (val <= cams[rig].x))
+                {
+                    lef = mid;
+                    mid = lef + (rig - lef) / 2;
+                }
+                if((val < cams[lef].x) || (val > cams[rig].x))
+                {
+                    lef = 0;
+                    rig = 0;
+                    mid = 0;
+                }
+            }
+
+            int id = -1;
+            if(val == cams[lef].x)
+            {
+                id = lef;
+            }
+            if(val == cams[rig].x)
+            {
+                id = rig;
+            }
+            return id;
+        }
+
+        void addTrack(const OctreeTracks::Tracks& tracks, int i)
+        {
+            const Pixel* trackCams = tracks.getCams(i);
+            for(int c = 0; c < tracks.getNbCams(i); c++)
+            {
+                const int index = indexOf(trackCams[c].x);
+                if(index == -1)
+                {
+                    cams.push_back(trackCams[c]);
+                    if(cams.size() > 1)
+                    {
+                        qsort(&cams[0], cams.size(), sizeof(Pixel), qSortComparePixelByXAsc);
+                    }
+                }
+                else
+                {
+                    cams[index].y += trackCams[c].y;
+                }
+            }
+
+            if(tracks.minPixSize[i] < minPixSize * 0.8f)
+            {
+                point = tracks.points[i];
+                minPixSize = tracks.minPixSize[i];
+                minSim = tracks.minSim[i];
+                npts = tracks.npts[i];
+            }
+            else if(tracks.minPixSize[i] < minPixSize * 1.2f)
+            {
+                point = (point * (float)npts + tracks.points[i] * (float)tracks.npts[i]) / (float)(npts + tracks.npts[i]);
+                minPixSize = std::min(minPixSize, tracks.minPixSize[i]);
+                minSim = std::min(minSim, tracks.minSim[i]);
+                npts += tracks.npts[i];
+            }
+        }
+
+        Point3d point;
+        float minPixSize;
+        float minSim;
+        int npts;
+        std::vector<Pixel> cams;
+    };
+
+    /// leaf of getAllPoints, with its sub-voxel
+    struct Leaf
+    {
+        const Track* track;
+        Voxel voxel;
+    };
+
+    explicit ReferenceOctree(int maxNumSubVoxs)
+    {
+        size = 2;
+        depth = 1;
+        while(size < maxNumSubVoxs)
+        {
+            size *= 2;
+            ++depth;
+        }
+    }
+
+    const Track* getTrack(int x, int y, int z) const
+    {
+        if(!((x >= 0 && x < size) && (y >= 0 && y < size) && (z >= 0 && z < size)))
+        {
+            return nullptr;
+        }
+
+        const Node* n = root.get();
+        int s = size;
+        while(s != 1)
+        {
+            if(n == nullptr)
+            {
+                return nullptr;
+            }
+            s /= 2;
+            n = static_cast<const Branch*>(n)->children[!((x & s) == 0)][!((y & s) == 0)][!((z & s) == 0)].get();
+        }
+        return static_cast<const Track*>(n);
+    }
+
+    void addTrack(int x, int y, int z, const OctreeTracks::Tracks& tracks, int i)
+    {
+        std::unique_ptr<Node>* n = &root;
+        int s = size;
+        while(s != 1)
+        {
+            if(*n == nullptr)
+            {
+                n->reset(new Branch());
+            }
+            else
+            {
+                s /= 2;
+                n = &static_cast<Branch*>(n->get())->children[!((x & s) == 0)][!((y & s) == 0)][!((z & s) == 0)];
+            }
+        }
+
+        if(*n == nullptr)
+        {
+            n->reset(new Track(tracks, i));
+        }
+        else
+        {
+            static_cast<Track*>(n->get())->addTrack(tracks, i);
+        }
+    }
+
+    void getAllPoints(std::vector<Leaf>& out) const
+    {
+        if(root != nullptr)
+            getAllPointsRecursive(out, root.get(), Voxel(0, 0, 0), size);
+    }
+
+    void getNPointsByLevels(std::vector<int>& nptsAtLevel) const
+    {
+        nptsAtLevel.assign(depth + 1, 0);
+        if(root != nullptr)
+        {
+            nptsAtLevel[0] = 1;
+            getNPointsByLevelsRecursive(root.get(), 0, nptsAtLevel);
+        }
+    }
+
+    int size;
+    int depth;
+
+private:
+    void getAllPointsRecursive(std::vector<Leaf>& out, const Node* node, const Voxel& origin, int s) const
+    {
+        if(node->isLeaf)
+        {
+            out.push_back({static_cast<const Track*>(node), origin});
+            return;
+        }
+        const Branch* b = static_cast<const Branch*>(node);
+        s /= 2;
+        for(int i = 0; i < 2; ++i)
+            for(int j = 0; j < 2; ++j)
+                for(int k = 0; k < 2; ++k)
+                    if(b->children[i][j][k] != nullptr)
+                        getAllPointsRecursive(out, b->children[i][j][k].get(), Voxel(origin.x + i * s, origin.y + j * s, origin.z + k * s), s);
+    }
+
+    void getNPointsByLevelsRecursive(const Node* node, int level, std::vector<int>& nptsAtLevel) const
+    {
+        if(node->isLeaf)
+            return;
+        const Branch* b = static_cast<const Branch*>(node);
+        for(int i = 0; i < 2; ++i)
+        {
+            for(int j = 0; j < 2; ++j)
+            {
+                for(int k = 0; k < 2; ++k)
+                {
+                    if(b->children[i][j][k] != nullptr)
+                    {
+                        nptsAtLevel[level + 1] += 1;
+                        getNPointsByLevelsRecursive(b->children[i][j][k].get(), level + 1, nptsAtLevel);
+                    }
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<Node> root;
+};
+
+/**
+ * @brief Random tracks around a few clusters, so that many sub-voxels get several tracks,
+ * with a few tracks outside of the voxel.
+ */
+OctreeTracks::Tracks generateTracks(int nbTracks, const Point3d& voxelSize, int nbCams, std::mt19937& generator)
+{
+    std::uniform_real_distribution<double> unitDistribution(0.0, 1.0);
+    std::normal_distribution<double> clusterDistribution(0.0, 0.02);
+    std::uniform_real_distribution<float> pixSizeDistribution(0.005f, 0.02f);
+    std::uniform_real_distribution<float> simDistribution(-1.0f, 0.0f);
+    std::uniform_int_distribution<int> nptsDistribution(1, 3);
+    std::uniform_int_distribution<int> nbTrackCamsDistribution(1, 4);
+    std::uniform_int_distribution<int> camDistribution(0, nbCams - 1);
+
+    std::vector<Point3d> clusters(50);
+    for(Point3d& cluster : clusters)
+        cluster = Point3d(unitDistribution(generator) * voxelSize.x, unitDistribution(generator) * voxelSize.y,
+                          unitDistribution(generator) * voxelSize.z);
+    std::uniform_int_distribution<int> clusterIdDistribution(0, clusters.size() - 1);
+
+    OctreeTracks::Tracks tracks;
+    for(int i = 0; i < nbTracks; ++i)
+    {
+        const Point3d& cluster = clusters[clusterIdDistribution(generator)];
+        const Point3d point(cluster.x + clusterDistribution(generator) * voxelSize.x,
+                            cluster.y + clusterDistribution(generator) * voxelSize.y,
+                            cluster.z + clusterDistribution(generator) * voxelSize.z);
+
+        // distinct cameras sorted by camera index
+        std::vector<Pixel> cams;
+        const int nbTrackCams = nbTrackCamsDistribution(generator);
+        while(cams.size() < nbTrackCams)
+        {
+            const int cam = camDistribution(generator);
+            if(std::none_of(cams.begin(), cams.end(), [cam](const Pixel& p) { return p.x == cam; }))
+                cams.push_back(Pixel(cam, nptsDistribution(generator)));
+        }
+        std::sort(cams.begin(), cams.end(), [](const Pixel& a, const Pixel& b) { return a.x < b.x; });
+
+        tracks.push_back(point, pixSizeDistribution(generator), simDistribution(generator), nptsDistribution(generator),
+                         cams.data(), cams.size());
+    }
+    return tracks;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(fuseCut_octreeTracksFromTracks)
+{
+    std::mt19937 generator(42);
+
+    sfmData::SfMData sfmData;
+    mvsUtils::MultiViewParams mp(sfmData, "", "", "", false);
+
+    // a voxel with a number of sub-voxels per axis which is not a power of two
+    const Point3d voxelSize(2.0, 3.0, 1.5);
+    const Voxel dimensions(37, 50, 23);
+    Point3d voxel[8];
+    voxel[0] = Point3d(0.0, 0.0, 0.0);
+    voxel[1] = Point3d(voxelSize.x, 0.0, 0.0);
+    voxel[2] = Point3d(voxelSize.x, voxelSize.y, 0.0);
+    voxel[3] = Point3d(0.0, voxelSize.y, 0.0);
+    for(int i = 0; i < 4; ++i)
+        voxel[i + 4] = voxel[i] + Point3d(0.0, 0.0, voxelSize.z);
+
+    const OctreeTracks::Tracks tracks = generateTracks(20000, voxelSize, 30, generator);
+
+    for(const int nbThreads : {1, omp_get_max_threads()})
+    {
+        omp_set_num_threads(nbThreads);
+
+        OctreeTracks octree(voxel, &mp, dimensions);
+        octree.fillOctreeFromTracks(tracks);
+
+        ReferenceOctree reference(std::max(std::max(dimensions.x, dimensions.y), dimensions.z));
+        int nbInsideTracks = 0;
+        for(int i = 0; i < tracks.size(); ++i)
+        {
+            Voxel v;
+            if(octree.getVoxelOfOctreeFor3DPoint(v, tracks.points[i]))
+            {
+                reference.addTrack(v.x, v.y, v.z, tracks, i);
+                ++nbInsideTracks;
+            }
+        }
+        BOOST_CHECK_GT(nbInsideTracks, tracks.size() / 2);
+        BOOST_CHECK_LT(nbInsideTracks, tracks.size());
+
+        // all the points: the same tracks in each sub-voxel, the order of the leaves differs
+        std::vector<ReferenceOctree::Leaf> referenceLeaves;
+        reference.getAllPoints(referenceLeaves);
+        const OctreeTracks::Tracks& allPoints = octree.getAllPoints();
+        BOOST_REQUIRE_EQUAL(allPoints.size(), referenceLeaves.size());
+        BOOST_REQUIRE_EQUAL(octree.getNbLeaves(), referenceLeaves.size());
+        BOOST_CHECK_LT(referenceLeaves.size(), nbInsideTracks / 2);
+
+        for(const ReferenceOctree::Leaf& leaf : referenceLeaves)
+        {
+            const int i = octree.getTrack(leaf.voxel.x, leaf.voxel.y, leaf.voxel.z);
+            BOOST_REQUIRE_NE(i, -1);
+            const ReferenceOctree::Track& track = *leaf.track;
+            BOOST_CHECK_EQUAL(allPoints.points[i].x, track.point.x);
+            BOOST_CHECK_EQUAL(allPoints.points[i].y, track.point.y);
+            BOOST_CHECK_EQUAL(allPoints.points[i].z, track.point.z);
+            BOOST_CHECK_EQUAL(allPoints.minPixSize[i], track.minPixSize);
+            BOOST_CHECK_EQUAL(allPoints.minSim[i], track.minSim);
+            BOOST_CHECK_EQUAL(allPoints.npts[i], track.npts);
+            BOOST_REQUIRE_EQUAL(allPoints.getNbCams(i), track.cams.size());
+            for(int c = 0; c < track.cams.size(); ++c)
+            {
+                BOOST_CHECK_EQUAL(allPoints.getCams(i)[c].x, track.cams[c].x);
+                BOOST_CHECK_EQUAL(allPoints.getCams(i)[c].y, track.cams[c].y);
+            }
+        }
+
+        // number of nodes at each level
+        std::vector<int> referenceNptsAtLevel;
+        reference.getNPointsByLevels(referenceNptsAtLevel);
+        StaticVector<int> nptsAtLevel;
+        octree.getNPointsByLevels(nptsAtLevel);
+        BOOST_REQUIRE_EQUAL(nptsAtLevel.size(), referenceNptsAtLevel.size());
+        for(int level = 0; level < nptsAtLevel.size(); ++level)
+            BOOST_CHECK_EQUAL(nptsAtLevel[level], referenceNptsAtLevel[level]);
+
+        // neighbour lookups of filterOctreeTracks2, out of the octree bounds too
+        int nbFoundNeighbours = 0;
+        for(const ReferenceOctree::Leaf& leaf : referenceLeaves)
+        {
+            for(int xp = -2; xp <= 2; xp++)
+            {
+                for(int yp = -2; yp <= 2; yp++)
+                {
+                    for(int zp = -2; zp <= 2; zp++)
+                    {
+                        const Voxel v(leaf.voxel.x + xp, leaf.voxel.y + yp, leaf.voxel.z + zp);
+                        const int i = octree.getTrack(v.x, v.y, v.z);
+                        const ReferenceOctree::Track* track = reference.getTrack(v.x, v.y, v.z);
+                        BOOST_REQUIRE_EQUAL(i == -1, track == nullptr);
+                        if(track == nullptr)
+                            continue;
+                        ++nbFoundNeighbours;
+                        BOOST_REQUIRE_EQUAL(allPoints.minPixSize[i], track->minPixSize);
+                        BOOST_REQUIRE_EQUAL(allPoints.points[i].x, track->point.x);
+                    }
+                }
+            }
+        }
+        BOOST_CHECK_GT(nbFoundNeighbours, 2 * referenceLeaves.size());
+        BOOST_TEST_MESSAGE(nbThreads << " threads: " << nbInsideTracks << " tracks in " << referenceLeaves.size()
+                                     << " leaves, " << nbFoundNeighbours << " neighbours found");
+    }
+}
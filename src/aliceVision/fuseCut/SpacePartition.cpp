@@ -0,0 +1,819 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SpacePartition.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mesh/MeshConnectivity.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+bool isInBox(const Point3d& p, const SpacePartition::Cell& cell)
+{
+    return p.x >= cell.min.x && p.x <= cell.max.x &&
+           p.y >= cell.min.y && p.y <= cell.max.y &&
+           p.z >= cell.min.z && p.z <= cell.max.z;
+}
+
+/**
+ * @brief Keep a subset of the triangles and remove the unused points,
+ *        with the points colors and visibilities
+ */
+void keepTriangles(mesh::Mesh& mesh, const StaticVector<int>& trisToKeep)
+{
+    mesh::Mesh outMesh;
+    StaticVector<int> ptIdToNewPtId;
+    mesh.generateMeshFromTrianglesSubset(trisToKeep, outMesh, ptIdToNewPtId);
+
+    if(mesh.pointsVisibilities.size() == mesh.pts.size())
+    {
+        outMesh.pointsVisibilities.resize(outMesh.pts.size());
+        for(int i = 0; i < ptIdToNewPtId.size(); ++i)
+        {
+            if(ptIdToNewPtId[i] > -1)
+                std::swap(outMesh.pointsVisibilities[ptIdToNewPtId[i]], mesh.pointsVisibilities[i]);
+        }
+    }
+
+    std::swap(mesh.pts, outMesh.pts);
+    std::swap(mesh.tris, outMesh.tris);
+    std::swap(mesh.colors(), outMesh.colors());
+    std::swap(mesh.pointsVisibilities, outMesh.pointsVisibilities);
+    mesh.invalidateConnectivity();
+}
+
+/**
+ * @brief Cut the mesh on the plane of normalized coordinate value along axis, keep the triangles above the plane
+ *        (keepAbove), below it (keepBelow) or both. The triangles lying on the plane are kept if keepOnPlane is true.
+ *        The vertices created on the edges crossing the plane are shared by the triangles of the edge,
+ *        their colors are interpolated and their visibilities are the union of the edge ones.
+ *        The unused points are not removed.
+ */
+void cutMesh(mesh::Mesh& mesh, const SpacePartition& partition, int axis, double value, bool keepAbove, bool keepBelow,
+             bool keepOnPlane)
+{
+    // the vertices closer to the plane are considered on the plane
+    const double epsilon = 1e-9;
+
+    const int nbPts = mesh.pts.size();
+    std::vector<double> dists(nbPts);
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const double d = partition.getLocalCoords(mesh.pts[i]).m[axis] - value;
+        dists[i] = (std::abs(d) < epsilon) ? 0.0 : d;
+    }
+
+    std::vector<rgb>& colors = mesh.colors();
+    const bool useColors = (colors.size() == std::size_t(nbPts));
+    const bool useVisibilities = (mesh.pointsVisibilities.size() == nbPts);
+
+    std::map<std::pair<int, int>, int> edgesPts;
+    const auto getEdgePt = [&](int a, int b) {
+        const std::pair<int, int> edge(std::min(a, b), std::max(a, b));
+        const auto it = edgesPts.find(edge);
+        if(it != edgesPts.end())
+            return it->second;
+
+        const double t = dists[a] / (dists[a] - dists[b]);
+        const int ptId = mesh.pts.size();
+        mesh.pts.push_back(mesh.pts[a] + (mesh.pts[b] - mesh.pts[a]) * t);
+        dists.push_back(0.0);
+        if(useColors)
+        {
+            const rgb& cA = colors[a];
+            const rgb& cB = colors[b];
+            const auto lerp = [t](unsigned char u, unsigned char v) {
+                return static_cast<unsigned char>(std::round(u + (double(v) - double(u)) * t));
+            };
+            colors.push_back(rgb(lerp(cA.r, cB.r), lerp(cA.g, cB.g), lerp(cA.b, cB.b)));
+        }
+        if(useVisibilities)
+        {
+            StaticVector<int> visibilities = mesh.pointsVisibilities[a];
+            const StaticVector<int>& visibilitiesB = mesh.pointsVisibilities[b];
+            for(int j = 0; j < visibilitiesB.size(); ++j)
+                visibilities.push_back_distinct(visibilitiesB[j]);
+            mesh.pointsVisibilities.push_back(visibilities);
+        }
+        edgesPts.emplace(edge, ptId);
+        return ptId;
+    };
+
+    StaticVector<mesh::Mesh::triangle> tris;
+    tris.reserve(mesh.tris.size());
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const mesh::Mesh::triangle& t = mesh.tris[i];
+        const double d[3] = {dists[t.v[0]], dists[t.v[1]], dists[t.v[2]]};
+        if(d[0] == 0.0 && d[1] == 0.0 && d[2] == 0.0)
+        {
+            if(keepOnPlane)
+                tris.push_back(t);
+            continue;
+        }
+        if(d[0] >= 0.0 && d[1] >= 0.0 && d[2] >= 0.0)
+        {
+            if(keepAbove)
+                tris.push_back(t);
+            continue;
+        }
+        if(d[0] <= 0.0 && d[1] <= 0.0 && d[2] <= 0.0)
+        {
+            if(keepBelow)
+                tris.push_back(t);
+            continue;
+        }
+
+        // Sutherland-Hodgman clipping of the triangle on each kept side, the polygons have 3 or 4 vertices
+        for(const double side : {1.0, -1.0})
+        {
+            if((side > 0.0 && !keepAbove) || (side < 0.0 && !keepBelow))
+                continue;
+            std::array<int, 4> polygon;
+            int nbPolygonPts = 0;
+            for(int k = 0; k < 3; ++k)
+            {
+                const int a = t.v[k];
+                const int b = t.v[(k + 1) % 3];
+                if(d[k] * side >= 0.0)
+                    polygon[nbPolygonPts++] = a;
+                if((d[k] > 0.0 && d[(k + 1) % 3] < 0.0) || (d[k] < 0.0 && d[(k + 1) % 3] > 0.0))
+                    polygon[nbPolygonPts++] = getEdgePt(a, b);
+            }
+            for(int k = 1; k + 1 < nbPolygonPts; ++k)
+                tris.push_back(mesh::Mesh::triangle(polygon[0], polygon[k], polygon[k + 1]));
+        }
+    }
+    std::swap(mesh.tris, tris);
+    mesh.invalidateConnectivity();
+}
+
+/// max distance of a point to a cell face, in normalized coordinates
+const double faceEpsilon = 1e-6;
+
+/// face shared by two cells: its axis and its normalized coordinate, axis -1 if the cells are not neighbors
+std::pair<int, double> getSharedFace(const SpacePartition::Cell& cellA, const SpacePartition::Cell& cellB)
+{
+    std::pair<int, double> face(-1, 0.0);
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        // the cells bounds are copies of the split values, the cells touching on an edge are not neighbors
+        if(cellA.max.m[axis] == cellB.min.m[axis] || cellA.min.m[axis] == cellB.max.m[axis])
+        {
+            if(face.first != -1)
+                return std::make_pair(-1, 0.0);
+            face = std::make_pair(axis, (cellA.max.m[axis] == cellB.min.m[axis]) ? cellA.max.m[axis] : cellA.min.m[axis]);
+        }
+        else if(std::max(cellA.min.m[axis], cellB.min.m[axis]) >= std::min(cellA.max.m[axis], cellB.max.m[axis]))
+            return std::make_pair(-1, 0.0);
+    }
+    return face;
+}
+
+/**
+ * @brief True if the point (in normalized coordinates) lies on the face shared by the two cells.
+ *        The face is not bounded on the borders of the volume, where the meshes are not cut.
+ */
+bool isOnSharedFace(const SpacePartition::Cell& cellA, const SpacePartition::Cell& cellB, int faceAxis,
+                    double faceValue, const Point3d& local)
+{
+    if(std::abs(local.m[faceAxis] - faceValue) >= faceEpsilon)
+        return false;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        if(axis == faceAxis)
+            continue;
+        const double lower = std::max(cellA.min.m[axis], cellB.min.m[axis]);
+        const double upper = std::min(cellA.max.m[axis], cellB.max.m[axis]);
+        if((lower > 0.0 && local.m[axis] < lower - faceEpsilon) || (upper < 1.0 && local.m[axis] > upper + faceEpsilon))
+            return false;
+    }
+    return true;
+}
+
+/// boundary edge of a cell mesh lying on a face shared with a neighbor cell, in the orientation of its triangle
+struct FaceEdge
+{
+    int cellId;
+    int neighborId;
+    int from;
+    int to;
+    int triId;
+    /// index of the edge in the triangle (from its vertex k to the next one)
+    int k;
+};
+
+/// chain of consecutive boundary edges of a cell on a face shared with a neighbor cell
+struct FaceChain
+{
+    int cellId;
+    int neighborId;
+    std::vector<int> pts;
+    /// index of the face edge from pts[i] to pts[i + 1]
+    std::vector<int> edges;
+};
+
+/**
+ * @brief Link the face edges of each cell and neighbor in open chains, the closed loops are ignored.
+ * @param[in,out] faceEdges the face edges, sorted by cell, neighbor and first vertex
+ */
+std::vector<FaceChain> buildFaceChains(std::vector<FaceEdge>& faceEdges)
+{
+    std::sort(faceEdges.begin(), faceEdges.end(), [](const FaceEdge& a, const FaceEdge& b) {
+        return std::tie(a.cellId, a.neighborId, a.from) < std::tie(b.cellId, b.neighborId, b.from);
+    });
+
+    std::vector<FaceChain> chains;
+    std::vector<int> tos;
+    for(std::size_t begin = 0; begin < faceEdges.size();)
+    {
+        std::size_t end = begin + 1;
+        while(end < faceEdges.size() && faceEdges[end].cellId == faceEdges[begin].cellId &&
+              faceEdges[end].neighborId == faceEdges[begin].neighborId)
+            ++end;
+
+        tos.clear();
+        for(std::size_t i = begin; i < end; ++i)
+            tos.push_back(faceEdges[i].to);
+        std::sort(tos.begin(), tos.end());
+
+        // edge starting from a vertex, -1 if there is none
+        const auto findEdge = [&](int from) {
+            const auto it = std::lower_bound(faceEdges.begin() + begin, faceEdges.begin() + end, from,
+                                             [](const FaceEdge& e, int v) { return e.from < v; });
+            return (it != faceEdges.begin() + end && it->from == from) ? int(it - faceEdges.begin()) : -1;
+        };
+
+        // the chains start from the vertices without incoming edge
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            if(std::binary_search(tos.begin(), tos.end(), faceEdges[i].from))
+                continue;
+            FaceChain chain;
+            chain.cellId = faceEdges[i].cellId;
+            chain.neighborId = faceEdges[i].neighborId;
+            chain.pts.push_back(faceEdges[i].from);
+            for(int edgeId = i; edgeId != -1 && chain.edges.size() < end - begin; edgeId = findEdge(faceEdges[edgeId].to))
+            {
+                chain.edges.push_back(edgeId);
+                chain.pts.push_back(faceEdges[edgeId].to);
+            }
+            chains.push_back(std::move(chain));
+        }
+        begin = end;
+    }
+    return chains;
+}
+
+/// normalized curvilinear abscissa of the vertices of a chain
+std::vector<double> getAbscissae(const mesh::Mesh& mesh, const std::vector<int>& pts)
+{
+    std::vector<double> abscissae(pts.size(), 0.0);
+    for(std::size_t i = 1; i < pts.size(); ++i)
+        abscissae[i] = abscissae[i - 1] + (mesh.pts[pts[i]] - mesh.pts[pts[i - 1]]).size();
+    if(abscissae.back() > 0.0)
+    {
+        for(double& abscissa : abscissae)
+            abscissa /= abscissae.back();
+    }
+    return abscissae;
+}
+
+int findRoot(std::vector<int>& parents, int i)
+{
+    while(parents[i] != i)
+    {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+} // namespace
+
+SpacePartition::SpacePartition(const Point3d hexah[8])
+    : _origin(hexah[0])
+{
+    _axes[0] = hexah[1] - hexah[0];
+    _axes[1] = hexah[3] - hexah[0];
+    _axes[2] = hexah[4] - hexah[0];
+
+    // invert the normalized axes, the matrix inversion uses an absolute determinant threshold
+    Matrix3x3 axes;
+    const Point3d x = _axes[0].normalize();
+    const Point3d y = _axes[1].normalize();
+    const Point3d z = _axes[2].normalize();
+    axes.m11 = x.x; axes.m12 = y.x; axes.m13 = z.x;
+    axes.m21 = x.y; axes.m22 = y.y; axes.m23 = z.y;
+    axes.m31 = x.z; axes.m32 = y.z; axes.m33 = z.z;
+    if(!axes.inverse(_toLocal))
+        throw std::invalid_argument("SpacePartition: degenerated reconstruction volume.");
+}
+
+Point3d SpacePartition::getLocalCoords(const Point3d& p) const
+{
+    const Point3d local = _toLocal * (p - _origin);
+    return Point3d(local.x / _axes[0].size(), local.y / _axes[1].size(), local.z / _axes[2].size());
+}
+
+SpacePartition::Cell SpacePartition::getInflatedCell(const Cell& cell) const
+{
+    Cell inflated;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const double margin = _overlap * (cell.max.m[axis] - cell.min.m[axis]);
+        inflated.min.m[axis] = std::max(0.0, cell.min.m[axis] - margin);
+        inflated.max.m[axis] = std::min(1.0, cell.max.m[axis] + margin);
+    }
+    return inflated;
+}
+
+std::size_t SpacePartition::countLandmarks(const Cell& cell) const
+{
+    std::size_t count = 0;
+    for(const Point3d& landmark : _landmarks)
+    {
+        if(isInBox(landmark, cell))
+            ++count;
+    }
+    return count;
+}
+
+std::size_t SpacePartition::estimateNbPoints(const Cell& cell) const
+{
+    if(_landmarks.empty())
+        return _nbPoints;
+    const double ratio = double(countLandmarks(getInflatedCell(cell))) / double(_landmarks.size());
+    return std::size_t(std::ceil(ratio * double(_nbPoints)));
+}
+
+void SpacePartition::build(const std::vector<Point3d>& landmarks, std::size_t nbPoints, std::size_t maxPointsPerCell,
+                           double overlap, int maxDepth)
+{
+    _nbPoints = nbPoints;
+    _overlap = overlap;
+    _cells.clear();
+    _cellsNbPoints.clear();
+
+    // landmarks in normalized coordinates, the ones outside of the volume are ignored
+    const Cell volume{Point3d(0.0, 0.0, 0.0), Point3d(1.0, 1.0, 1.0)};
+    _landmarks.clear();
+    _landmarks.reserve(landmarks.size());
+    for(const Point3d& landmark : landmarks)
+    {
+        const Point3d p = getLocalCoords(landmark);
+        if(isInBox(p, volume))
+            _landmarks.push_back(p);
+    }
+
+    std::vector<std::pair<Cell, int>> toDivide;
+    toDivide.emplace_back(volume, 0);
+    std::vector<double> coords;
+
+    while(!toDivide.empty())
+    {
+        const Cell cell = toDivide.back().first;
+        const int depth = toDivide.back().second;
+        toDivide.pop_back();
+
+        const std::size_t nbCellPoints = estimateNbPoints(cell);
+        const std::size_t nbCellLandmarks = countLandmarks(cell);
+        if(nbCellPoints <= maxPointsPerCell || depth >= maxDepth || nbCellLandmarks < 2)
+        {
+            // nothing to reconstruct in the cells without landmarks
+            if(nbCellLandmarks > 0 || _landmarks.empty())
+            {
+                _cells.push_back(cell);
+                _cellsNbPoints.push_back(nbCellPoints);
+            }
+            continue;
+        }
+
+        // split the longest axis at the median of the landmarks, but not too close to the cell borders
+        int axis = 0;
+        double maxLength = 0.0;
+        for(int a = 0; a < 3; ++a)
+        {
+            const double length = (cell.max.m[a] - cell.min.m[a]) * _axes[a].size();
+            if(length > maxLength)
+            {
+                maxLength = length;
+                axis = a;
+            }
+        }
+
+        coords.clear();
+        for(const Point3d& landmark : _landmarks)
+        {
+            if(isInBox(landmark, cell))
+                coords.push_back(landmark.m[axis]);
+        }
+        std::nth_element(coords.begin(), coords.begin() + coords.size() / 2, coords.end());
+
+        const double extent = cell.max.m[axis] - cell.min.m[axis];
+        const double split = std::min(std::max(coords[coords.size() / 2], cell.min.m[axis] + 0.25 * extent),
+                                      cell.max.m[axis] - 0.25 * extent);
+
+        Cell lower = cell;
+        Cell upper = cell;
+        lower.max.m[axis] = split;
+        upper.min.m[axis] = split;
+        toDivide.emplace_back(upper, depth + 1);
+        toDivide.emplace_back(lower, depth + 1);
+    }
+
+    ALICEVISION_LOG_INFO("Space partition: " << _cells.size() << " cells from " << _landmarks.size() << " landmarks.");
+}
+
+void SpacePartition::getCellHexahedron(int cellId, Point3d hexah[8]) const
+{
+    const Cell cell = getInflatedCell(_cells.at(cellId));
+    const auto getPoint = [&](double u, double v, double w) {
+        return _origin + _axes[0] * u + _axes[1] * v + _axes[2] * w;
+    };
+    hexah[0] = getPoint(cell.min.x, cell.min.y, cell.min.z);
+    hexah[1] = getPoint(cell.max.x, cell.min.y, cell.min.z);
+    hexah[2] = getPoint(cell.max.x, cell.max.y, cell.min.z);
+    hexah[3] = getPoint(cell.min.x, cell.max.y, cell.min.z);
+    hexah[4] = getPoint(cell.min.x, cell.min.y, cell.max.z);
+    hexah[5] = getPoint(cell.max.x, cell.min.y, cell.max.z);
+    hexah[6] = getPoint(cell.max.x, cell.max.y, cell.max.z);
+    hexah[7] = getPoint(cell.min.x, cell.max.y, cell.max.z);
+}
+
+bool SpacePartition::isInCell(int cellId, const Point3d& p) const
+{
+    const Cell& cell = _cells.at(cellId);
+    const Point3d local = getLocalCoords(p);
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const double v = std::min(std::max(local.m[axis], 0.0), 1.0);
+        if(v < cell.min.m[axis])
+            return false;
+        // the upper bound only belongs to the cells on the border of the volume
+        if(v > cell.max.m[axis] || (v == cell.max.m[axis] && cell.max.m[axis] < 1.0))
+            return false;
+    }
+    return true;
+}
+
+void cropMeshToCell(mesh::Mesh& mesh, const SpacePartition& partition, int cellId)
+{
+    const int nbInputTris = mesh.tris.size();
+
+    // the faces on the border of the volume are not cut: the points outside of the volume belong to the closest cell
+    const SpacePartition::Cell& cell = partition.getCell(cellId);
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        if(cell.min.m[axis] > 0.0)
+            cutMesh(mesh, partition, axis, cell.min.m[axis], true, false, true);
+        if(cell.max.m[axis] < 1.0)
+            cutMesh(mesh, partition, axis, cell.max.m[axis], false, true, false);
+    }
+
+    // the faces are also cut on the borders of the neighbor cells,
+    // so that the corners shared by several cells are vertices of each cell border
+    std::array<std::vector<double>, 3> cuts;
+    const int nbCells = partition.getNbCells();
+    for(int neighborId = 0; neighborId < nbCells; ++neighborId)
+    {
+        const SpacePartition::Cell& neighbor = partition.getCell(neighborId);
+        const int faceAxis = getSharedFace(cell, neighbor).first;
+        if(neighborId == cellId || faceAxis == -1)
+            continue;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            for(const double value : {neighbor.min.m[axis], neighbor.max.m[axis]})
+            {
+                if(axis != faceAxis && value > cell.min.m[axis] && value < cell.max.m[axis])
+                    cuts[axis].push_back(value);
+            }
+        }
+    }
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        std::sort(cuts[axis].begin(), cuts[axis].end());
+        cuts[axis].erase(std::unique(cuts[axis].begin(), cuts[axis].end()), cuts[axis].end());
+        for(const double value : cuts[axis])
+            cutMesh(mesh, partition, axis, value, true, true, true);
+    }
+
+    StaticVector<int> trisToKeep;
+    trisToKeep.resize(mesh.tris.size());
+    for(int i = 0; i < trisToKeep.size(); ++i)
+        trisToKeep[i] = i;
+
+    ALICEVISION_LOG_INFO("Crop mesh to cell " << cellId << ": " << mesh.tris.size() << " triangles from " << nbInputTris << " triangles.");
+    keepTriangles(mesh, trisToKeep);
+}
+
+int stitchCellsMeshes(mesh::Mesh& mesh, const std::vector<int>& ptsCellIds, const SpacePartition& partition,
+                      double weldRatio)
+{
+    const int nbPts = mesh.pts.size();
+    if(ptsCellIds.size() != std::size_t(nbPts))
+        throw std::invalid_argument("stitchCellsMeshes: invalid number of cell ids.");
+
+    // faces shared by each cell with its neighbors: neighbor, axis and normalized coordinate
+    const int nbCells = partition.getNbCells();
+    std::vector<std::vector<std::tuple<int, int, double>>> cellsFaces(nbCells);
+    for(int cellId = 0; cellId < nbCells; ++cellId)
+    {
+        for(int neighborId = 0; neighborId < nbCells; ++neighborId)
+        {
+            const std::pair<int, double> face = getSharedFace(partition.getCell(cellId), partition.getCell(neighborId));
+            if(neighborId != cellId && face.first != -1)
+                cellsFaces[cellId].emplace_back(neighborId, face.first, face.second);
+        }
+    }
+
+    std::vector<Point3d> localPts(nbPts);
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+        localPts[i] = partition.getLocalCoords(mesh.pts[i]);
+
+    // boundary edges of each cell on its shared faces, an edge on several faces (on the corner of the cell or on a face
+    // where the other cell has no triangle) is added to each of them
+    std::vector<FaceEdge> faceEdges;
+    {
+        const mesh::MeshConnectivity connectivity(mesh);
+        for(int edgeId = 0; edgeId < connectivity.getNbEdges(); ++edgeId)
+        {
+            if(!connectivity.isBoundaryEdge(edgeId))
+                continue;
+            const int triId = connectivity.getEdgeTris(edgeId)[0];
+            int k = 0;
+            while(k < 2 && connectivity.getTriEdge(triId, k) != edgeId)
+                ++k;
+            const mesh::Mesh::triangle& t = mesh.tris[triId];
+            const int from = t.v[k];
+            const int to = t.v[(k + 1) % 3];
+            const int cellId = ptsCellIds[from];
+            const Point3d middle = (localPts[from] + localPts[to]) * 0.5;
+            for(const auto& face : cellsFaces[cellId])
+            {
+                const SpacePartition::Cell& cell = partition.getCell(cellId);
+                const SpacePartition::Cell& neighbor = partition.getCell(std::get<0>(face));
+                const int axis = std::get<1>(face);
+                const double value = std::get<2>(face);
+                if(std::abs(localPts[from].m[axis] - value) < faceEpsilon &&
+                   std::abs(localPts[to].m[axis] - value) < faceEpsilon &&
+                   isOnSharedFace(cell, neighbor, axis, value, middle))
+                    faceEdges.push_back({cellId, std::get<0>(face), from, to, triId, k});
+            }
+        }
+    }
+    const std::vector<FaceChain> chains = buildFaceChains(faceEdges);
+
+    // chains of each cell and neighbor
+    std::map<std::pair<int, int>, std::pair<std::size_t, std::size_t>> chainsRanges;
+    for(std::size_t i = 0; i < chains.size(); ++i)
+    {
+        auto& range = chainsRanges.emplace(std::make_pair(chains[i].cellId, chains[i].neighborId), std::make_pair(i, i)).first->second;
+        range.second = i + 1;
+    }
+
+    // the ends of the chains of the two sides of a face are welded if they are closer than
+    // weldRatio times the length of their edge, the closest pairs first
+    std::vector<std::tuple<double, int, int>> matches;
+    const auto getEndMaxDist = [&](const FaceChain& chain, bool front) {
+        const int a = front ? chain.pts[0] : chain.pts[chain.pts.size() - 2];
+        const int b = front ? chain.pts[1] : chain.pts.back();
+        return weldRatio * (mesh.pts[a] - mesh.pts[b]).size();
+    };
+    for(const auto& ranges : chainsRanges)
+    {
+        const int cellId = ranges.first.first;
+        const int neighborId = ranges.first.second;
+        const auto otherRanges = chainsRanges.find(std::make_pair(neighborId, cellId));
+        if(cellId > neighborId || otherRanges == chainsRanges.end())
+            continue;
+        for(std::size_t i = ranges.second.first; i < ranges.second.second; ++i)
+        {
+            for(std::size_t j = otherRanges->second.first; j < otherRanges->second.second; ++j)
+            {
+                for(const bool frontA : {true, false})
+                {
+                    for(const bool frontB : {true, false})
+                    {
+                        const int a = frontA ? chains[i].pts.front() : chains[i].pts.back();
+                        const int b = frontB ? chains[j].pts.front() : chains[j].pts.back();
+                        const double dist = (mesh.pts[a] - mesh.pts[b]).size();
+                        if(dist < std::max(getEndMaxDist(chains[i], frontA), getEndMaxDist(chains[j], frontB)))
+                            matches.emplace_back(dist, a, b);
+                    }
+                }
+            }
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+
+    // a welded vertex has at most one vertex of each cell
+    std::vector<int> parents(nbPts);
+    for(int i = 0; i < nbPts; ++i)
+        parents[i] = i;
+    // cells of the vertices welded to each root (filled on the first weld)
+    std::vector<std::vector<int>> rootsCellIds(nbPts);
+    const auto getRootCellIds = [&](int root) -> std::vector<int>& {
+        if(rootsCellIds[root].empty())
+            rootsCellIds[root].push_back(ptsCellIds[root]);
+        return rootsCellIds[root];
+    };
+    std::vector<int> weldedPts;
+    for(const auto& match : matches)
+    {
+        const int rootA = findRoot(parents, std::get<1>(match));
+        const int rootB = findRoot(parents, std::get<2>(match));
+        if(rootA == rootB)
+            continue;
+        const std::vector<int>& cellIdsA = getRootCellIds(rootA);
+        const std::vector<int>& cellIdsB = getRootCellIds(rootB);
+        const bool sharedCell = std::any_of(cellIdsA.begin(), cellIdsA.end(), [&](int cellId) {
+            return std::find(cellIdsB.begin(), cellIdsB.end(), cellId) != cellIdsB.end();
+        });
+        if(sharedCell)
+            continue;
+        const int root = std::min(rootA, rootB);
+        const int child = std::max(rootA, rootB);
+        parents[child] = root;
+        rootsCellIds[root].insert(rootsCellIds[root].end(), rootsCellIds[child].begin(), rootsCellIds[child].end());
+        std::vector<int>().swap(rootsCellIds[child]);
+        weldedPts.push_back(std::get<1>(match));
+        weldedPts.push_back(std::get<2>(match));
+    }
+    std::sort(weldedPts.begin(), weldedPts.end());
+    weldedPts.erase(std::unique(weldedPts.begin(), weldedPts.end()), weldedPts.end());
+
+    // the welded vertices are moved to their barycenter (on the corner or the face they share)
+    const bool useVisibilities = (mesh.pointsVisibilities.size() == mesh.pts.size());
+    std::map<int, std::pair<Point3d, int>> rootsSums;
+    int nbWelded = 0;
+    for(int i : weldedPts)
+    {
+        const int root = findRoot(parents, i);
+        auto& sum = rootsSums.emplace(root, std::make_pair(Point3d(0.0, 0.0, 0.0), 0)).first->second;
+        sum.first = sum.first + mesh.pts[i];
+        ++sum.second;
+        if(root == i)
+            continue;
+        ++nbWelded;
+        if(useVisibilities)
+        {
+            const StaticVector<int>& visibilities = mesh.pointsVisibilities[i];
+            for(int j = 0; j < visibilities.size(); ++j)
+                mesh.pointsVisibilities[root].push_back_distinct(visibilities[j]);
+        }
+    }
+    for(const auto& sum : rootsSums)
+        mesh.pts[sum.first] = sum.second.first / double(sum.second.second);
+
+    // zip the chains of the two sides of a face between their welded ends: the vertices of each chain are inserted
+    // in the edges of the other one at the same curvilinear abscissa, so that both chains get the same edges
+    std::vector<std::vector<int>> edgesInserts(faceEdges.size());
+    std::vector<char> zipped(chains.size(), 0);
+    int nbZipped = 0;
+    for(const auto& ranges : chainsRanges)
+    {
+        const int cellId = ranges.first.first;
+        const int neighborId = ranges.first.second;
+        const auto otherRanges = chainsRanges.find(std::make_pair(neighborId, cellId));
+        if(cellId > neighborId || otherRanges == chainsRanges.end())
+            continue;
+        for(std::size_t i = ranges.second.first; i < ranges.second.second; ++i)
+        {
+            const FaceChain& chainA = chains[i];
+            const int front = findRoot(parents, chainA.pts.front());
+            const int back = findRoot(parents, chainA.pts.back());
+            if(front == back)
+                continue;
+
+            // the chain of the other side has the opposite orientation
+            std::size_t j = otherRanges->second.first;
+            while(j < otherRanges->second.second &&
+                  (zipped[j] || findRoot(parents, chains[j].pts.front()) != back || findRoot(parents, chains[j].pts.back()) != front))
+                ++j;
+            if(j == otherRanges->second.second)
+                continue;
+            zipped[j] = 1;
+            const FaceChain& chainB = chains[j];
+            const std::vector<int> ptsB(chainB.pts.rbegin(), chainB.pts.rend());
+
+            const std::vector<double> abscissaeA = getAbscissae(mesh, chainA.pts);
+            const std::vector<double> abscissaeB = getAbscissae(mesh, ptsB);
+            std::vector<std::tuple<double, int, int>> merged;
+            for(std::size_t k = 1; k + 1 < chainA.pts.size(); ++k)
+                merged.emplace_back(abscissaeA[k], 0, k);
+            for(std::size_t k = 1; k + 1 < ptsB.size(); ++k)
+                merged.emplace_back(abscissaeB[k], 1, k);
+            std::sort(merged.begin(), merged.end());
+
+            // current edge of each chain, the edge k of the reversed chain B is its edge (size - 1 - k)
+            int edgeA = 0;
+            int edgeB = 0;
+            const int nbEdgesB = chainB.edges.size();
+            for(const auto& m : merged)
+            {
+                if(std::get<1>(m) == 0)
+                {
+                    edgesInserts[chainB.edges[nbEdgesB - 1 - edgeB]].push_back(chainA.pts[std::get<2>(m)]);
+                    edgeA = std::get<2>(m);
+                }
+                else
+                {
+                    edgesInserts[chainA.edges[edgeA]].push_back(ptsB[std::get<2>(m)]);
+                    edgeB = std::get<2>(m);
+                }
+                ++nbZipped;
+            }
+            // the chain B is zipped in the opposite direction
+            for(int edgeId : chainB.edges)
+                std::reverse(edgesInserts[edgeId].begin(), edgesInserts[edgeId].end());
+        }
+    }
+
+    // split the triangles of the edges with inserted vertices
+    std::map<int, std::array<int, 3>> trisEdges;
+    for(std::size_t i = 0; i < faceEdges.size(); ++i)
+    {
+        if(edgesInserts[i].empty())
+            continue;
+        std::array<int, 3> init = {-1, -1, -1};
+        int& edgeId = trisEdges.emplace(faceEdges[i].triId, init).first->second[faceEdges[i].k];
+        if(edgeId == -1)
+            edgeId = i;
+    }
+    for(const auto& triEdges : trisEdges)
+    {
+        const mesh::Mesh::triangle t = mesh.tris[triEdges.first];
+        std::vector<int> polygon;
+        int nbSplitEdges = 0;
+        int splitEdge = 0;
+        for(int k = 0; k < 3; ++k)
+        {
+            polygon.push_back(t.v[k]);
+            const int edgeId = triEdges.second[k];
+            if(edgeId == -1)
+                continue;
+            polygon.insert(polygon.end(), edgesInserts[edgeId].begin(), edgesInserts[edgeId].end());
+            ++nbSplitEdges;
+            splitEdge = k;
+        }
+        // fan from the vertex opposite to the split edge
+        if(nbSplitEdges == 1)
+        {
+            const auto apex = std::find(polygon.begin(), polygon.end(), t.v[(splitEdge + 2) % 3]);
+            std::rotate(polygon.begin(), apex, polygon.end());
+        }
+        mesh.tris[triEdges.first] = mesh::Mesh::triangle(polygon[0], polygon[1], polygon[2]);
+        for(std::size_t k = 2; k + 1 < polygon.size(); ++k)
+            mesh.tris.push_back(mesh::Mesh::triangle(polygon[0], polygon[k], polygon[k + 1]));
+    }
+
+    // remap the triangles, remove the degenerated and duplicated ones
+    std::vector<std::pair<std::array<int, 3>, int>> sortedTris;
+    sortedTris.reserve(mesh.tris.size());
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        mesh::Mesh::triangle& t = mesh.tris[i];
+        for(int k = 0; k < 3; ++k)
+            t.v[k] = findRoot(parents, t.v[k]);
+        if(t.v[0] == t.v[1] || t.v[1] == t.v[2] || t.v[2] == t.v[0])
+            continue;
+        std::array<int, 3> sorted = {t.v[0], t.v[1], t.v[2]};
+        std::sort(sorted.begin(), sorted.end());
+        sortedTris.emplace_back(sorted, i);
+    }
+    std::sort(sortedTris.begin(), sortedTris.end());
+
+    StaticVector<int> trisToKeep;
+    trisToKeep.reserve(sortedTris.size());
+    for(std::size_t i = 0; i < sortedTris.size(); ++i)
+    {
+        if(i == 0 || sortedTris[i].first != sortedTris[i - 1].first)
+            trisToKeep.push_back(sortedTris[i].second);
+    }
+    std::sort(trisToKeep.begin(), trisToKeep.end());
+    keepTriangles(mesh, trisToKeep);
+
+    ALICEVISION_LOG_INFO("Stitch cells meshes: " << nbWelded << " vertices welded, " << nbZipped << " vertices zipped, " << mesh.pts.size() << " vertices and " << mesh.tris.size() << " triangles.");
+    return nbWelded + nbZipped;
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,116 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Partition of the reconstruction volume in cells meshed independently.
+ *
+ * The cells are boxes in the normalized coordinates of the reconstruction hexahedron ([0,1]^3).
+ * They are built by recursive binary splits of the longest axis near the median of the SfM landmarks,
+ * until the number of points expected in each cell (with its overlap margins) fits the budget.
+ * Each point of the volume belongs to exactly one cell: the cells share their faces, the lower bounds are inclusive.
+ */
+class SpacePartition
+{
+public:
+    struct Cell
+    {
+        /// lower bounds in normalized coordinates
+        Point3d min;
+        /// upper bounds in normalized coordinates
+        Point3d max;
+    };
+
+    /**
+     * @param[in] hexah the reconstruction volume (parallelepiped, see VoxelsGrid::getHexah for the vertices order)
+     */
+    explicit SpacePartition(const Point3d hexah[8]);
+
+    /**
+     * @brief Split the volume.
+     * @param[in] landmarks the SfM landmarks, used to estimate the points distribution
+     * @param[in] nbPoints the number of points expected in the whole volume
+     * @param[in] maxPointsPerCell the max number of points expected in a cell, including its overlap margins
+     * @param[in] overlap the overlap margins of the cells, relatively to their size
+     * @param[in] maxDepth the max number of splits from the whole volume to a cell
+     */
+    void build(const std::vector<Point3d>& landmarks, std::size_t nbPoints, std::size_t maxPointsPerCell,
+               double overlap, int maxDepth = 12);
+
+    std::size_t getNbCells() const { return _cells.size(); }
+    const Cell& getCell(int cellId) const { return _cells.at(cellId); }
+
+    /// number of points expected in the cell with its overlap margins
+    std::size_t getNbEstimatedPoints(int cellId) const { return _cellsNbPoints.at(cellId); }
+
+    /// hexahedron of the cell with its overlap margins (clamped to the volume)
+    void getCellHexahedron(int cellId, Point3d hexah[8]) const;
+
+    /// normalized coordinates of a point
+    Point3d getLocalCoords(const Point3d& p) const;
+
+    /// true if the cell owns the point (the points outside the volume belong to the closest cell)
+    bool isInCell(int cellId, const Point3d& p) const;
+
+private:
+    Cell getInflatedCell(const Cell& cell) const;
+    std::size_t countLandmarks(const Cell& cell) const;
+    std::size_t estimateNbPoints(const Cell& cell) const;
+
+    Point3d _origin;
+    Point3d _axes[3];
+    Matrix3x3 _toLocal;
+
+    std::vector<Point3d> _landmarks;
+    std::size_t _nbPoints = 0;
+    double _overlap = 0.0;
+
+    std::vector<Cell> _cells;
+    std::vector<std::size_t> _cellsNbPoints;
+};
+
+/**
+ * @brief Cut the mesh on the inner faces of a cell and keep the part in the cell, remove the unused points.
+ * The triangles crossing a face are split on the face plane, so the borders of two neighbor cells meshes
+ * lie on their shared plane. The mesh is also cut on the borders of the neighbor cells faces, so that the corners
+ * shared by several cells are vertices of each cell border. As in isInCell, a triangle on a face belongs to the cell
+ * of the lower bound. The points colors and visibilities are kept consistent (interpolated colors and merged
+ * visibilities on the cuts).
+ */
+void cropMeshToCell(mesh::Mesh& mesh, const SpacePartition& partition, int cellId);
+
+/**
+ * @brief Stitch the borders of the cells meshes (cut by cropMeshToCell) merged in a single mesh.
+ * The boundary edges of each cell on a face shared with a neighbor cell are linked in chains, the borders of the volume
+ * are kept. The ends of the chains of the two sides of a face are welded if they are closer than weldRatio times the
+ * length of their edge, the closest pairs first and with at most one vertex of each cell (so that the corners of
+ * several cells are welded together). The welded vertices are moved to their barycenter, their visibilities are merged.
+ * Then the two chains between the same welded ends are zipped: the vertices of each chain are inserted in the edges of
+ * the other one at the same curvilinear abscissa, so that the two independent tessellations of a face get the same
+ * border edges. Degenerated and duplicated triangles and the unused points are removed.
+ *
+ * @param[in,out] mesh the merged cells meshes
+ * @param[in] ptsCellIds the cell of each point
+ * @param[in] partition the partition of the cells
+ * @param[in] weldRatio the max weld distance relatively to the length of the boundary edges
+ * @return the number of welded and zipped vertices
+ */
+int stitchCellsMeshes(mesh::Mesh& mesh, const std::vector<int>& ptsCellIds, const SpacePartition& partition,
+                      double weldRatio = 0.5);
+
+} // namespace fuseCut
+} // namespace aliceVision
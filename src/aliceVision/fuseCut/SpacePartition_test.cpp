@@ -0,0 +1,311 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/SpacePartition.hpp>
+#include <aliceVision/mesh/MeshConnectivity.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE fuseCutSpacePartition
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace {
+
+void getBox(const Point3d& origin, const Point3d& size, Point3d hexah[8])
+{
+    hexah[0] = origin;
+    hexah[1] = origin + Point3d(size.x, 0.0, 0.0);
+    hexah[2] = origin + Point3d(size.x, size.y, 0.0);
+    hexah[3] = origin + Point3d(0.0, size.y, 0.0);
+    hexah[4] = origin + Point3d(0.0, 0.0, size.z);
+    hexah[5] = origin + Point3d(size.x, 0.0, size.z);
+    hexah[6] = origin + size;
+    hexah[7] = origin + Point3d(0.0, size.y, size.z);
+}
+
+/// regular grid of n x n vertices in the plane z = 0.5 of the unit cube, each vertex seen by the camera of its row
+mesh::Mesh createGridMesh(int n)
+{
+    mesh::Mesh mesh;
+    for(int y = 0; y < n; ++y)
+    {
+        for(int x = 0; x < n; ++x)
+        {
+            mesh.pts.push_back(Point3d(x / double(n - 1), y / double(n - 1), 0.5));
+            StaticVector<int> visibilities;
+            visibilities.push_back(y);
+            mesh.pointsVisibilities.push_back(visibilities);
+        }
+    }
+    for(int y = 0; y + 1 < n; ++y)
+    {
+        for(int x = 0; x + 1 < n; ++x)
+        {
+            const int i = y * n + x;
+            mesh.tris.push_back(mesh::Mesh::triangle(i, i + 1, i + n + 1));
+            mesh.tris.push_back(mesh::Mesh::triangle(i, i + n + 1, i + n));
+        }
+    }
+    return mesh;
+}
+
+int getNbBoundaryEdges(const mesh::Mesh& mesh)
+{
+    const mesh::MeshConnectivity connectivity(mesh);
+    int nbBoundaryEdges = 0;
+    for(int edgeId = 0; edgeId < connectivity.getNbEdges(); ++edgeId)
+    {
+        if(connectivity.isBoundaryEdge(edgeId))
+            ++nbBoundaryEdges;
+    }
+    return nbBoundaryEdges;
+}
+
+/// the boundary edges of the mesh are on the faces x = 0, x = 1, y = 0 or y = 1 of the unit cube
+bool isClosedInside(const mesh::Mesh& mesh)
+{
+    const auto isOnBorder = [](const Point3d& p) {
+        const double epsilon = 1e-9;
+        return p.x < epsilon || p.x > 1.0 - epsilon || p.y < epsilon || p.y > 1.0 - epsilon;
+    };
+    const mesh::MeshConnectivity connectivity(mesh);
+    for(int edgeId = 0; edgeId < connectivity.getNbEdges(); ++edgeId)
+    {
+        if(!connectivity.isBoundaryEdge(edgeId))
+            continue;
+        const Pixel& edge = connectivity.getEdge(edgeId);
+        const Point3d middle = (mesh.pts[edge.x] + mesh.pts[edge.y]) / 2.0;
+        if(!isOnBorder(mesh.pts[edge.x]) || !isOnBorder(mesh.pts[edge.y]) || !isOnBorder(middle))
+            return false;
+    }
+    return true;
+}
+
+/// manifold edges and Euler characteristic of a disk
+void checkDisk(const mesh::Mesh& mesh)
+{
+    const mesh::MeshConnectivity connectivity(mesh);
+    for(int edgeId = 0; edgeId < connectivity.getNbEdges(); ++edgeId)
+        BOOST_REQUIRE_LE(connectivity.getNbEdgeTris(edgeId), 2);
+    BOOST_CHECK_EQUAL(mesh.pts.size() - connectivity.getNbEdges() + mesh.tris.size(), 1);
+}
+
+double getArea(const mesh::Mesh& mesh)
+{
+    double area = 0.0;
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const mesh::Mesh::triangle& t = mesh.tris[i];
+        area += 0.5 * cross(mesh.pts[t.v[1]] - mesh.pts[t.v[0]], mesh.pts[t.v[2]] - mesh.pts[t.v[0]]).size();
+    }
+    return area;
+}
+
+/// height field of the wavy surface
+double getHeight(double x, double y)
+{
+    return 0.5 + 0.05 * std::sin(2.0 * M_PI * x) * std::cos(3.0 * M_PI * y);
+}
+
+/**
+ * @brief Tessellation of the wavy surface in the box [min, max] (x, y), with nx x ny vertices,
+ *        the diagonals of the quads are flipped if flip is true. Each vertex is seen by camera.
+ */
+mesh::Mesh createWavyMesh(const Point3d& min, const Point3d& max, int nx, int ny, bool flip, int camera)
+{
+    mesh::Mesh mesh;
+    for(int j = 0; j < ny; ++j)
+    {
+        for(int i = 0; i < nx; ++i)
+        {
+            const double x = min.x + (max.x - min.x) * i / double(nx - 1);
+            const double y = min.y + (max.y - min.y) * j / double(ny - 1);
+            mesh.pts.push_back(Point3d(x, y, getHeight(x, y)));
+            StaticVector<int> visibilities;
+            visibilities.push_back(camera);
+            mesh.pointsVisibilities.push_back(visibilities);
+        }
+    }
+    for(int j = 0; j + 1 < ny; ++j)
+    {
+        for(int i = 0; i + 1 < nx; ++i)
+        {
+            const int a = j * nx + i;
+            if(flip)
+            {
+                mesh.tris.push_back(mesh::Mesh::triangle(a, a + 1, a + nx));
+                mesh.tris.push_back(mesh::Mesh::triangle(a + 1, a + nx + 1, a + nx));
+            }
+            else
+            {
+                mesh.tris.push_back(mesh::Mesh::triangle(a, a + 1, a + nx + 1));
+                mesh.tris.push_back(mesh::Mesh::triangle(a, a + nx + 1, a + nx));
+            }
+        }
+    }
+    return mesh;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(fuseCut_spacePartition_build)
+{
+    Point3d hexah[8];
+    getBox(Point3d(-2.0, 1.0, 3.0), Point3d(4.0, 2.0, 1.0), hexah);
+
+    // landmarks concentrated on one side of the volume
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    std::vector<Point3d> landmarks;
+    for(int i = 0; i < 20000; ++i)
+    {
+        const double u = distribution(generator);
+        landmarks.push_back(Point3d(-2.0 + 4.0 * u * u, 1.0 + 2.0 * distribution(generator), 3.0 + distribution(generator)));
+    }
+
+    const std::size_t nbPoints = 1000000;
+    const std::size_t maxPointsPerCell = 100000;
+
+    SpacePartition partition(hexah);
+    partition.build(landmarks, nbPoints, maxPointsPerCell, 0.1);
+
+    BOOST_CHECK_GT(partition.getNbCells(), 10);
+    for(int cellId = 0; cellId < partition.getNbCells(); ++cellId)
+        BOOST_CHECK_LE(partition.getNbEstimatedPoints(cellId), maxPointsPerCell);
+
+    // each landmark belongs to exactly one cell, and is in the hexahedron of this cell
+    for(const Point3d& landmark : landmarks)
+    {
+        int nbOwners = 0;
+        for(int cellId = 0; cellId < partition.getNbCells(); ++cellId)
+        {
+            if(!partition.isInCell(cellId, landmark))
+                continue;
+            ++nbOwners;
+            Point3d cellHexah[8];
+            partition.getCellHexahedron(cellId, cellHexah);
+            BOOST_CHECK(mvsUtils::isPointInHexahedron(landmark, cellHexah));
+        }
+        BOOST_CHECK_EQUAL(nbOwners, 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fuseCut_spacePartition_stitch)
+{
+    Point3d hexah[8];
+    getBox(Point3d(0.0, 0.0, 0.0), Point3d(1.0, 1.0, 1.0), hexah);
+
+    std::vector<Point3d> landmarks;
+    for(int y = 0; y < 10; ++y)
+    {
+        for(int x = 0; x < 10; ++x)
+            landmarks.push_back(Point3d((x + 0.5) / 10.0, (y + 0.5) / 10.0, 0.5));
+    }
+
+    SpacePartition partition(hexah);
+    partition.build(landmarks, 100, 30, 0.1);
+    BOOST_REQUIRE_GT(partition.getNbCells(), 1);
+
+    // crop the same surface to each cell, then merge the cells meshes
+    const mesh::Mesh gridMesh = createGridMesh(40);
+    mesh::Mesh merged;
+    std::vector<int> ptsCellIds;
+    for(int cellId = 0; cellId < partition.getNbCells(); ++cellId)
+    {
+        mesh::Mesh cellMesh = gridMesh;
+        cropMeshToCell(cellMesh, partition, cellId);
+        BOOST_CHECK_EQUAL(cellMesh.pointsVisibilities.size(), cellMesh.pts.size());
+        merged.addMesh(cellMesh);
+        ptsCellIds.resize(merged.pts.size(), cellId);
+    }
+    // the triangles crossing the cells faces are cut
+    BOOST_CHECK_GT(merged.tris.size(), gridMesh.tris.size());
+    BOOST_CHECK_CLOSE(getArea(merged), 1.0, 1e-6);
+
+    const int nbStitched = stitchCellsMeshes(merged, ptsCellIds, partition);
+
+    // the cuts of the same tessellation are stitched
+    BOOST_CHECK_GT(nbStitched, 0);
+    BOOST_CHECK(isClosedInside(merged));
+    checkDisk(merged);
+    BOOST_CHECK_CLOSE(getArea(merged), 1.0, 1e-6);
+    BOOST_REQUIRE_EQUAL(merged.pointsVisibilities.size(), merged.pts.size());
+    for(int i = 0; i < merged.pts.size(); ++i)
+    {
+        // the rows are not mixed, the cut vertices are seen by the rows of their edge
+        const StaticVector<int>& visibilities = merged.pointsVisibilities[i];
+        BOOST_REQUIRE_GT(visibilities.size(), 0);
+        for(int j = 0; j < visibilities.size(); ++j)
+            BOOST_CHECK_LE(std::abs(visibilities[j] - merged.pts[i].y * 39.0), 1.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(fuseCut_spacePartition_stitchOverlappingCells)
+{
+    Point3d hexah[8];
+    // thin volume around the surface, the cells are only split along x and y
+    getBox(Point3d(0.0, 0.0, 0.4), Point3d(1.0, 1.0, 0.2), hexah);
+
+    std::vector<Point3d> landmarks;
+    for(int y = 0; y < 10; ++y)
+    {
+        for(int x = 0; x < 10; ++x)
+            landmarks.push_back(Point3d((x + 0.5) / 10.0, (y + 0.5) / 10.0, getHeight((x + 0.5) / 10.0, (y + 0.5) / 10.0)));
+    }
+
+    // the smaller cells have T-junctions: a face shared with two neighbor cells
+    for(const std::size_t maxPointsPerCell : {30, 15})
+    {
+        SpacePartition partition(hexah);
+        partition.build(landmarks, 100, maxPointsPerCell, 0.1);
+        BOOST_REQUIRE_GT(partition.getNbCells(), 2);
+
+        // each cell gets its own tessellation of the surface in its hexahedron, with the overlap margins
+        mesh::Mesh merged;
+        std::vector<int> ptsCellIds;
+        for(int cellId = 0; cellId < partition.getNbCells(); ++cellId)
+        {
+            Point3d cellHexah[8];
+            partition.getCellHexahedron(cellId, cellHexah);
+            const int nx = 13 + 5 * (cellId % 3);
+            const int ny = 11 + 3 * (cellId % 4);
+            mesh::Mesh cellMesh = createWavyMesh(cellHexah[0], cellHexah[6], nx, ny, cellId % 2 == 1, cellId);
+            cropMeshToCell(cellMesh, partition, cellId);
+            merged.addMesh(cellMesh);
+            ptsCellIds.resize(merged.pts.size(), cellId);
+        }
+        BOOST_CHECK(!isClosedInside(merged));
+        const double croppedArea = getArea(merged);
+
+        stitchCellsMeshes(merged, ptsCellIds, partition);
+
+        // no crack and no overlap between the cells
+        BOOST_CHECK(isClosedInside(merged));
+        checkDisk(merged);
+        BOOST_CHECK_CLOSE(getArea(merged), croppedArea, 0.1);
+
+        // the vertices are seen by the cameras of the cells they come from
+        BOOST_REQUIRE_EQUAL(merged.pointsVisibilities.size(), merged.pts.size());
+        for(int i = 0; i < merged.pts.size(); ++i)
+        {
+            const StaticVector<int>& visibilities = merged.pointsVisibilities[i];
+            BOOST_REQUIRE_GT(visibilities.size(), 0);
+            for(int j = 0; j < visibilities.size(); ++j)
+            {
+                BOOST_REQUIRE(visibilities[j] >= 0 && visibilities[j] < partition.getNbCells());
+                Point3d cellHexah[8];
+                partition.getCellHexahedron(visibilities[j], cellHexah);
+                BOOST_CHECK(mvsUtils::isPointInHexahedron(merged.pts[i], cellHexah));
+            }
+        }
+    }
+}
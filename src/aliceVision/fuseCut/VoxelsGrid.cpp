@@ -153,7 +153,7 @@ std::string VoxelsGrid::getVoxelFolderName(int id) const
     return fnxyz;
 }
 
-StaticVector<OctreeTracks::trackStruct*>* VoxelsGrid::loadTracksFromVoxelFiles(StaticVector<int>** cams, int id)
+bool VoxelsGrid::loadTracksFromVoxelFiles(StaticVector<int>** cams, OctreeTracks::Tracks& tracks, int id)
 {
     const std::string folderName = getVoxelFolderName(id);
 
@@ -163,39 +163,37 @@ StaticVector<OctreeTracks::trackStruct*>* VoxelsGrid::loadTracksFromVoxelFiles(S
     const std::string fileNameTracksStat = folderName + "tracksGridStat.bin";
 
     if(!mvsUtils::FileExists(fileNameTracksPts))
-        return nullptr;
+        return false;
 
     StaticVector<Point3d>* tracksStat = loadArrayFromFile<Point3d>(fileNameTracksStat); // minPixSize, minSim, npts
     StaticVector<Point3d>* tracksPoints = loadArrayFromFile<Point3d>(fileNameTracksPts);
     StaticVector<StaticVector<Pixel>*>* tracksPointsCams = loadArrayOfArraysFromFile<Pixel>(fileNameTracksPtsCams);
     *cams = loadArrayFromFile<int>(fileNameTracksCams);
 
-    StaticVector<OctreeTracks::trackStruct*>* tracks = new StaticVector<OctreeTracks::trackStruct*>();
-    tracks->reserve(tracksPoints->size());
+    std::size_t nbTracksCams = 0;
+    for(int i = 0; i < tracksPointsCams->size(); i++)
+        nbTracksCams += (*tracksPointsCams)[i]->size();
+
+    tracks.clear();
+    tracks.reserve(tracksPoints->size(), nbTracksCams);
 
     for(int i = 0; i < tracksPoints->size(); i++)
     {
-        StaticVector<Pixel>* tcams = (*tracksPointsCams)[i];
-        OctreeTracks::trackStruct* t = new OctreeTracks::trackStruct(0.0f, 0.0f, Point3d(), 0);
-        t->point = (*tracksPoints)[i];
-        t->minPixSize = (*tracksStat)[i].x;
-        t->minSim = (*tracksStat)[i].y;
-        t->npts = (int)(*tracksStat)[i].z;
-        t->cams = *tcams;
-        tracks->push_back(t);
+        const StaticVector<Pixel>* tcams = (*tracksPointsCams)[i];
+        tracks.push_back((*tracksPoints)[i], (*tracksStat)[i].x, (*tracksStat)[i].y, (int)(*tracksStat)[i].z,
+                         tcams->getData().data(), tcams->size());
     }
 
     delete tracksStat;
     delete tracksPoints;
     deleteArrayOfArrays<Pixel>(&tracksPointsCams);
 
-    return tracks;
+    return true;
 }
 
-bool VoxelsGrid::saveTracksToVoxelFiles(StaticVector<int>* cams, StaticVector<OctreeTracks::trackStruct*>* tracks,
-                                        int id)
+bool VoxelsGrid::saveTracksToVoxelFiles(StaticVector<int>* cams, const OctreeTracks::Tracks& tracks, int id)
 {
-    if(sizeOfStaticVector<OctreeTracks::trackStruct*>(tracks) <= 10)
+    if(tracks.size() <= 10)
     {
         return false;
     }
@@ -209,23 +207,22 @@ bool VoxelsGrid::saveTracksToVoxelFiles(StaticVector<int>* cams, StaticVector<Oc
     }
 
     StaticVector<Point3d>* tracksPoints = new StaticVector<Point3d>();
-    tracksPoints->reserve(tracks->size());
+    tracksPoints->reserve(tracks.size());
     StaticVector<StaticVector<Pixel>*>* tracksPointsCams = new StaticVector<StaticVector<Pixel>*>();
-    tracksPointsCams->reserve(tracks->size());
+    tracksPointsCams->reserve(tracks.size());
     StaticVector<Point3d>* tracksStat = new StaticVector<Point3d>();
-    tracksStat->reserve(tracks->size());
+    tracksStat->reserve(tracks.size());
 
-    for(int j = 0; j < tracks->size(); j++)
+    for(int j = 0; j < tracks.size(); j++)
     {
-        OctreeTracks::trackStruct* info = (*tracks)[j];
-        tracksPoints->push_back(info->point);
-        tracksStat->push_back(Point3d(info->minPixSize, info->minSim, info->npts));
+        tracksPoints->push_back(tracks.points[j]);
+        tracksStat->push_back(Point3d(tracks.minPixSize[j], tracks.minSim[j], tracks.npts[j]));
 
         StaticVector<Pixel>* tcams = new StaticVector<Pixel>();
-        tcams->reserve(info->cams.size());
-        for(int k = 0; k < info->cams.size(); k++)
+        tcams->reserve(tracks.getNbCams(j));
+        for(int k = 0; k < tracks.getNbCams(j); k++)
         {
-            tcams->push_back(info->cams[k]);
+            tcams->push_back(tracks.getCams(j)[k]);
         }
         tracksPointsCams->push_back(tcams);
     }
@@ -278,10 +275,11 @@ void VoxelsGrid::generateTracksForEachVoxel(StaticVector<Point3d>* Reconstructio
 
         long t1 = clock();
         OctreeTracks* ott = new OctreeTracks(&(*voxels)[i * 8], mp, Voxel(numSubVoxs, numSubVoxs, numSubVoxs));
-        StaticVector<OctreeTracks::trackStruct*>* tracks = ott->fillOctree(maxPts, depthMapsPtsSimsTmpDir);
+        OctreeTracks::Tracks tracks;
+        const bool filled = ott->fillOctree(tracks, maxPts, depthMapsPtsSimsTmpDir);
         if(mp->verbose)
             mvsUtils::printfElapsedTime(t1, "fillOctree");
-        if(tracks == nullptr)
+        if(!filled)
         {
             if(mp->verbose)
                 ALICEVISION_LOG_DEBUG("deleting OTT: " << i);
@@ -296,7 +294,7 @@ void VoxelsGrid::generateTracksForEachVoxel(StaticVector<Point3d>* Reconstructio
         else
         {
             // printf("SAVING %i-th VOXEL TRACKS FILES\n",i);
-            if(tracks->size() > 10)
+            if(tracks.size() > 10)
             {
                 if(ReconstructionPlan != nullptr)
                 {
@@ -319,7 +317,6 @@ void VoxelsGrid::generateTracksForEachVoxel(StaticVector<Point3d>* Reconstructio
                 saveTracksToVoxelFiles(cams, tracks, i);
                 delete cams;
             }
-            delete tracks;
             if(mp->verbose)
                 ALICEVISION_LOG_DEBUG("deleting OTT: " << i);
             delete ott;
@@ -396,40 +393,19 @@ void VoxelsGrid::generateSpace(VoxelsGrid* vgnew, const Voxel& LU, const Voxel&
             OctreeTracks* ott = new OctreeTracks(&(*voxels)[voxid * 8], mp, part);
             VoxelsGrid* vgg = new VoxelsGrid(part, &(*voxels)[voxid * 8], mp, folderName, doVisualize);
             StaticVector<int>* cams = nullptr;
-            StaticVector<OctreeTracks::trackStruct*>* tracks = loadTracksFromVoxelFiles(&cams, voxid);
+            OctreeTracks::Tracks tracks;
+            const bool loaded = loadTracksFromVoxelFiles(&cams, tracks, voxid);
             Voxel vrel;
 
-            if((tracks != nullptr) && (tracks->size() > 0))
+            if(loaded && (tracks.size() > 0))
             {
-                // estimate nubers // TODO FACA: remove costly estimation of numbers
-                StaticVector<int>* nnewVoxsTracks = new StaticVector<int>();
-                nnewVoxsTracks->reserve(part.x * part.y * part.z);
-                nnewVoxsTracks->resize_with(part.x * part.y * part.z, 0);
-                for(int i = 0; i < tracks->size(); i++)
-                {
-                    if(ott->getVoxelOfOctreeFor3DPoint(vrel, (*tracks)[i]->point))
-                    {
-                        (*nnewVoxsTracks)[vgg->getIdForVoxel(vrel)] += 1;
-                    }
-                }
-
-                // allocate
-                StaticVector<StaticVector<OctreeTracks::trackStruct*>*>* newVoxsTracks =
-                    new StaticVector<StaticVector<OctreeTracks::trackStruct*>*>();
-                newVoxsTracks->reserve(part.x * part.y * part.z);
-                for(int i = 0; i < part.x * part.y * part.z; i++)
-                {
-                    auto* newVoxTracks = new StaticVector<OctreeTracks::trackStruct*>();
-                    newVoxTracks->reserve((*nnewVoxsTracks)[i]);
-                    newVoxsTracks->push_back(newVoxTracks);
-                }
-
-                // fill
-                for(int i = 0; i < tracks->size(); i++)
+                // split the tracks by sub-voxel
+                std::vector<OctreeTracks::Tracks> newVoxsTracks(part.x * part.y * part.z);
+                for(int i = 0; i < tracks.size(); i++)
                 {
-                    if(ott->getVoxelOfOctreeFor3DPoint(vrel, (*tracks)[i]->point))
+                    if(ott->getVoxelOfOctreeFor3DPoint(vrel, tracks.points[i]))
                     {
-                        (*newVoxsTracks)[vgg->getIdForVoxel(vrel)]->push_back((*tracks)[i]);
+                        newVoxsTracks[vgg->getIdForVoxel(vrel)].push_back(tracks, i);
                     }
                 }
 
@@ -439,19 +415,15 @@ void VoxelsGrid::generateSpace(VoxelsGrid* vgnew, const Voxel& LU, const Voxel&
                     Voxel vglob = subLU + vact;
                     int newid = vgnew->getIdForVoxel(vglob);
 
-                    vgnew->saveTracksToVoxelFiles(cams, (*newVoxsTracks)[i], newid);
+                    vgnew->saveTracksToVoxelFiles(cams, newVoxsTracks[i], newid);
 
                     /*
                     printf("idlocal %i of %i, voxel local %i %i %i, voxel global %i %i %i, id global %i, ntracks %i \n",
                             i,part.x*part.y*part.z, vact.x, vact.y, vact.z, vglob.x, vglob.y, vglob.z, newid,
-                            (*newVoxsTracks)[i]->size()
+                            newVoxsTracks[i].size()
                     );
                     */
                 }
-
-                // deallocate
-                delete newVoxsTracks;
-                delete nnewVoxsTracks;
             }
 
             if(cams != nullptr)
@@ -459,15 +431,6 @@ void VoxelsGrid::generateSpace(VoxelsGrid* vgnew, const Voxel& LU, const Voxel&
                 delete cams;
             }
 
-            if(tracks != nullptr)
-            {
-                for(int i = 0; i < tracks->size(); i++)
-                {
-                    delete(*tracks)[i];
-                }
-                delete tracks;
-            }
-
             delete vgg;
             delete ott;
         }
@@ -484,17 +447,12 @@ void VoxelsGrid::cloneSpaceVoxel(int voxelId, int numSubVoxs, VoxelsGrid* newSpa
         OctreeTracks* ott =
             new OctreeTracks(&(*voxels)[voxelId * 8], mp, Voxel(numSubVoxs, numSubVoxs, numSubVoxs));
         StaticVector<int>* tcams;
-        StaticVector<OctreeTracks::trackStruct*>* tracksOld = loadTracksFromVoxelFiles(&tcams, voxelId);
-        StaticVector<OctreeTracks::trackStruct*>* tracksNew = ott->fillOctreeFromTracks(tracksOld);
-        for(int i = 0; i < tracksOld->size(); i++)
-        {
-            delete(*tracksOld)[i];
-        }
-        delete tracksOld;
-        newSpace->saveTracksToVoxelFiles(tcams, tracksNew, voxelId);
+        OctreeTracks::Tracks tracksOld;
+        loadTracksFromVoxelFiles(&tcams, tracksOld, voxelId);
+        ott->fillOctreeFromTracks(tracksOld);
+        newSpace->saveTracksToVoxelFiles(tcams, ott->getAllPoints(), voxelId);
 
         delete tcams;
-        delete tracksNew; // DO NOT NEEDED TO DELETE PARTICULAR POINTERS BECAUSE THEY POINT TO ott STRUCTURES
         delete ott;
     }
 }
@@ -528,14 +486,10 @@ void VoxelsGrid::copySpaceVoxel(int voxelId, VoxelsGrid* newSpace)
     if(mvsUtils::FileExists(fileNameTracksPts))
     {
         StaticVector<int>* tcams;
-        StaticVector<OctreeTracks::trackStruct*>* tracksOld = loadTracksFromVoxelFiles(&tcams, voxelId);
+        OctreeTracks::Tracks tracksOld;
+        loadTracksFromVoxelFiles(&tcams, tracksOld, voxelId);
         newSpace->saveTracksToVoxelFiles(tcams, tracksOld, voxelId);
 
-        for(int i = 0; i < tracksOld->size(); i++)
-        {
-            delete(*tracksOld)[i];
-        }
-        delete tracksOld;
         delete tcams;
     }
 }
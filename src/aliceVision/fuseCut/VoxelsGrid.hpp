@@ -39,8 +39,8 @@ public:
     StaticVector<int>* getNVoxelsTracks();
     unsigned long getNTracks() const;
     bool isValidVoxel(const Voxel& v);
-    bool saveTracksToVoxelFiles(StaticVector<int>* cams, StaticVector<OctreeTracks::trackStruct*>* tracks, int id);
-    StaticVector<OctreeTracks::trackStruct*>* loadTracksFromVoxelFiles(StaticVector<int>** cams, int id);
+    bool saveTracksToVoxelFiles(StaticVector<int>* cams, const OctreeTracks::Tracks& tracks, int id);
+    bool loadTracksFromVoxelFiles(StaticVector<int>** cams, OctreeTracks::Tracks& tracks, int id);
     void generateCamsPtsFromVoxelsTracks();
     void generateSpace(VoxelsGrid* vgnew, const Voxel& LU, const Voxel& RD, const std::string& depthMapsPtsSimsTmpDir);
     void generateTracksForEachVoxel(StaticVector<Point3d>* ReconstructionPlan, int numSubVoxs, int maxPts, int level,
@@ -9,6 +9,7 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/graph/graph.hpp>
+#include <aliceVision/graph/ViewGraph.hpp>
 
 #include <lemon/list_graph.h>
 
@@ -120,28 +121,13 @@ bool List_Triplets(const GraphT & g, std::vector< Triplet > & vec_triplets)
 }
 
 /// Return triplets contained in the graph build from IterablePairs
+/// (sorted node ids, in lexicographic order)
 template <typename IterablePairs>
 inline std::vector< graph::Triplet > tripletListing(
   const IterablePairs & pairs)
 {
   std::vector< graph::Triplet > vec_triplets;
-
-  indexedGraph putativeGraph(pairs);
-
-  graph::List_Triplets<indexedGraph::GraphT>(putativeGraph.g, vec_triplets);
-
-  //Change triplets to ImageIds
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
-  {
-    graph::Triplet & triplet = vec_triplets[i];
-    IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-    I = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(I)];
-    J = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(J)];
-    K = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(K)];
-    IndexT triplet_[3] = { I, J, K };
-    std::sort(&triplet_[0], &triplet_[3]);
-    triplet = graph::Triplet(triplet_[0],triplet_[1],triplet_[2]);
-  }
+  listTriplets(ViewGraph(pairs), vec_triplets);
   return vec_triplets;
 }
 
@@ -0,0 +1,290 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ViewGraph.hpp"
+#include <aliceVision/graph/Triplet.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <tuple>
+
+namespace aliceVision {
+namespace graph {
+
+void ViewGraph::buildFromEdges(std::vector<std::pair<IndexT, IndexT>>& edges)
+{
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  _offsets.assign(_nodeIds.size() + 1, 0);
+  _neighbors.resize(edges.size());
+
+  for(std::size_t e = 0; e < edges.size(); ++e)
+  {
+    ++_offsets[edges[e].first + 1];
+    _neighbors[e] = edges[e].second;
+  }
+  std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+}
+
+void listTriplets(const ViewGraph& graph, std::vector<Triplet>& out_triplets)
+{
+  out_triplets.clear();
+
+  const std::size_t nbNodes = graph.nbNodes();
+
+  // rank the nodes by degree (the node index breaks the ties)
+  std::vector<IndexT> order(nbNodes);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&graph](IndexT a, IndexT b)
+  {
+    return std::make_pair(graph.degree(a), a) < std::make_pair(graph.degree(b), b);
+  });
+  std::vector<IndexT> rank(nbNodes);
+  for(std::size_t r = 0; r < nbNodes; ++r)
+    rank[order[r]] = static_cast<IndexT>(r);
+
+  // oriented graph: keep the neighbors of higher rank (still sorted by node index),
+  // the out degree of each node is bounded by O(sqrt(nbEdges))
+  std::vector<std::size_t> offsets(nbNodes + 1, 0);
+  for(std::size_t u = 0; u < nbNodes; ++u)
+  {
+    offsets[u + 1] = offsets[u] + std::count_if(graph.neighborsBegin(u), graph.neighborsEnd(u), [&rank, u](IndexT v)
+    {
+      return rank[v] > rank[u];
+    });
+  }
+  std::vector<IndexT> neighbors(offsets.back());
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(int u = 0; u < static_cast<int>(nbNodes); ++u)
+  {
+    std::copy_if(graph.neighborsBegin(u), graph.neighborsEnd(u), neighbors.begin() + offsets[u], [&rank, u](IndexT v)
+    {
+      return rank[v] > rank[u];
+    });
+  }
+
+  // each triangle is found once, from its lowest ranked node
+  std::vector<std::vector<Triplet>> tripletsPerThread(omp_get_max_threads());
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int u = 0; u < static_cast<int>(nbNodes); ++u)
+  {
+    std::vector<Triplet>& triplets = tripletsPerThread[omp_get_thread_num()];
+    const IndexT* uBegin = neighbors.data() + offsets[u];
+    const IndexT* uEnd = neighbors.data() + offsets[u + 1];
+
+    for(const IndexT* itV = uBegin; itV != uEnd; ++itV)
+    {
+      const IndexT v = *itV;
+
+      // merge-intersection of the sorted lists
+      const IndexT* itA = uBegin;
+      const IndexT* itB = neighbors.data() + offsets[v];
+      const IndexT* itBEnd = neighbors.data() + offsets[v + 1];
+      while(itA != uEnd && itB != itBEnd)
+      {
+        if(*itA < *itB)
+          ++itA;
+        else if(*itB < *itA)
+          ++itB;
+        else
+        {
+          IndexT triplet[3] = {graph.getNodeId(u), graph.getNodeId(v), graph.getNodeId(*itA)};
+          std::sort(&triplet[0], &triplet[3]);
+          triplets.emplace_back(triplet[0], triplet[1], triplet[2]);
+          ++itA;
+          ++itB;
+        }
+      }
+    }
+  }
+
+  std::size_t nbTriplets = 0;
+  for(const auto& triplets : tripletsPerThread)
+    nbTriplets += triplets.size();
+  out_triplets.reserve(nbTriplets);
+  for(auto& triplets : tripletsPerThread)
+  {
+    out_triplets.insert(out_triplets.end(), triplets.begin(), triplets.end());
+    triplets.clear();
+  }
+
+  // the result does not depend on the number of threads
+  std::sort(out_triplets.begin(), out_triplets.end(), [](const Triplet& a, const Triplet& b)
+  {
+    return std::make_tuple(a.i, a.j, a.k) < std::make_tuple(b.i, b.j, b.k);
+  });
+}
+
+/**
+ * @brief Find the root of a node in a concurrent union-find forest (with path halving)
+ */
+static IndexT findRoot(std::vector<std::atomic<IndexT>>& parents, IndexT node)
+{
+  while(true)
+  {
+    IndexT parent = parents[node].load();
+    if(parent == node)
+      return node;
+    const IndexT grandParent = parents[parent].load();
+    if(grandParent != parent)
+      parents[node].compare_exchange_weak(parent, grandParent);
+    node = grandParent;
+  }
+}
+
+std::size_t connectedComponents(const ViewGraph& graph,
+                                std::vector<IndexT>& out_componentPerNode,
+                                const std::vector<unsigned char>* isEdgeRemoved)
+{
+  const std::size_t nbNodes = graph.nbNodes();
+
+  // union-find forest, the roots are always hooked to the smallest root:
+  // the root of a tree is its smallest node whatever the order of the unions
+  std::vector<std::atomic<IndexT>> parents(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    parents[i].store(static_cast<IndexT>(i));
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(int u = 0; u < static_cast<int>(nbNodes); ++u)
+  {
+    for(std::size_t slot = graph.adjacencyBegin(u); slot < graph.adjacencyEnd(u); ++slot)
+    {
+      IndexT a = static_cast<IndexT>(u);
+      IndexT b = graph.getNeighbor(slot);
+      if(b < a || (isEdgeRemoved && (*isEdgeRemoved)[slot]))
+        continue;
+
+      while(true)
+      {
+        a = findRoot(parents, a);
+        b = findRoot(parents, b);
+        if(a == b)
+          break;
+        if(a < b)
+          std::swap(a, b);
+        IndexT expected = a;
+        if(parents[a].compare_exchange_strong(expected, b))
+          break;
+      }
+    }
+  }
+
+  out_componentPerNode.resize(nbNodes);
+
+  std::size_t nbComponents = 0;
+  for(std::size_t i = 0; i < nbNodes; ++i)
+  {
+    const IndexT root = findRoot(parents, static_cast<IndexT>(i));
+    out_componentPerNode[i] = (root == i) ? static_cast<IndexT>(nbComponents++) : out_componentPerNode[root];
+  }
+  return nbComponents;
+}
+
+std::size_t findBridges(const ViewGraph& graph, std::vector<unsigned char>& out_isBridge)
+{
+  const std::size_t nbNodes = graph.nbNodes();
+  out_isBridge.assign(graph.nbEdges() * 2, 0);
+
+  std::vector<IndexT> componentPerNode;
+  const std::size_t nbComponents = connectedComponents(graph, componentPerNode);
+
+  // first node of each component
+  std::vector<IndexT> roots(nbComponents);
+  for(std::size_t i = nbNodes; i-- > 0;)
+    roots[componentPerNode[i]] = static_cast<IndexT>(i);
+
+  // discovery time and low link of each node (each component has its own time)
+  std::vector<std::size_t> discovery(nbNodes, 0);
+  std::vector<std::size_t> low(nbNodes, 0);
+  std::vector<IndexT> parents(nbNodes, UndefinedIndexT);
+  std::size_t nbBridges = 0;
+
+  #pragma omp parallel reduction(+:nbBridges)
+  {
+    // iterative depth-first search stack: (node, next adjacency slot)
+    std::vector<std::pair<IndexT, std::size_t>> stack;
+
+    #pragma omp for schedule(dynamic)
+    for(int c = 0; c < static_cast<int>(nbComponents); ++c)
+    {
+      std::size_t time = 0;
+      const IndexT root = roots[c];
+      discovery[root] = low[root] = ++time;
+      stack.emplace_back(root, graph.adjacencyBegin(root));
+
+      while(!stack.empty())
+      {
+        const IndexT u = stack.back().first;
+        if(stack.back().second < graph.adjacencyEnd(u))
+        {
+          const IndexT v = graph.getNeighbor(stack.back().second++);
+          if(v == parents[u])
+            continue;
+          if(discovery[v] == 0)
+          {
+            parents[v] = u;
+            discovery[v] = low[v] = ++time;
+            stack.emplace_back(v, graph.adjacencyBegin(v));
+          }
+          else
+          {
+            low[u] = std::min(low[u], discovery[v]);
+          }
+        }
+        else
+        {
+          stack.pop_back();
+          if(stack.empty())
+            continue;
+          const IndexT p = stack.back().first;
+          low[p] = std::min(low[p], low[u]);
+          if(low[u] > discovery[p])
+          {
+            // (p, u) is a bridge: flag both directions
+            out_isBridge[graph.adjacencyBegin(p) + (std::lower_bound(graph.neighborsBegin(p), graph.neighborsEnd(p), u) - graph.neighborsBegin(p))] = 1;
+            out_isBridge[graph.adjacencyBegin(u) + (std::lower_bound(graph.neighborsBegin(u), graph.neighborsEnd(u), p) - graph.neighborsBegin(u))] = 1;
+            ++nbBridges;
+          }
+        }
+      }
+    }
+  }
+  return nbBridges;
+}
+
+std::set<IndexT> getLargestBiEdgeConnectedComponent(const ViewGraph& graph)
+{
+  std::set<IndexT> largestComponent;
+  if(graph.nbNodes() == 0)
+    return largestComponent;
+
+  // remove the bridges, the remaining connected components are bi-edge connected
+  std::vector<unsigned char> isBridge;
+  const std::size_t nbBridges = findBridges(graph, isBridge);
+
+  std::vector<IndexT> componentPerNode;
+  const std::size_t nbComponents = connectedComponents(graph, componentPerNode, nbBridges > 0 ? &isBridge : nullptr);
+
+  std::vector<std::size_t> componentSizes(nbComponents, 0);
+  for(const IndexT component : componentPerNode)
+    ++componentSizes[component];
+
+  const IndexT largest = static_cast<IndexT>(std::max_element(componentSizes.begin(), componentSizes.end()) - componentSizes.begin());
+
+  for(std::size_t i = 0; i < graph.nbNodes(); ++i)
+  {
+    if(componentPerNode[i] == largest)
+      largestComponent.insert(largestComponent.end(), graph.getNodeId(i));
+  }
+  return largestComponent;
+}
+
+} // namespace graph
+} // namespace aliceVision
@@ -0,0 +1,158 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace graph {
+
+struct Triplet;
+
+/**
+ * @brief Undirected simple graph of views stored in compressed sparse rows (CSR).
+ * The nodes are indexed from 0 to nbNodes()-1 in the ascending order of their ids
+ * and the sorted neighbors of each node are stored contiguously.
+ * Self loops are ignored and duplicated edges (in any direction) are merged.
+ */
+class ViewGraph
+{
+public:
+  ViewGraph() = default;
+
+  /**
+   * @brief Build the graph from pairs of node ids (e.g. a PairSet or the keys of the pairwise matches).
+   *        The nodes are the ids used by the pairs.
+   */
+  template <typename IterablePairs>
+  explicit ViewGraph(const IterablePairs& pairs)
+  {
+    std::vector<IndexT> nodeIds;
+    for(const auto& pair : pairs)
+    {
+      nodeIds.push_back(pair.first);
+      nodeIds.push_back(pair.second);
+    }
+    std::sort(nodeIds.begin(), nodeIds.end());
+    nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+    build(std::move(nodeIds), pairs);
+  }
+
+  /**
+   * @brief Build the graph from node ids and pairs (edges)
+   * @warning pairs must contains valid nodes ids
+   */
+  template <typename IterableNodes, typename IterablePairs>
+  ViewGraph(const IterableNodes& nodes, const IterablePairs& pairs)
+  {
+    std::vector<IndexT> nodeIds(nodes.begin(), nodes.end());
+    std::sort(nodeIds.begin(), nodeIds.end());
+    nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+    build(std::move(nodeIds), pairs);
+  }
+
+  std::size_t nbNodes() const { return _nodeIds.size(); }
+  std::size_t nbEdges() const { return _neighbors.size() / 2; }
+
+  /// id of a node
+  IndexT getNodeId(std::size_t node) const { return _nodeIds[node]; }
+
+  /// index of a node id (nbNodes() if the id is not in the graph)
+  std::size_t getNodeIndex(IndexT nodeId) const
+  {
+    const auto it = std::lower_bound(_nodeIds.begin(), _nodeIds.end(), nodeId);
+    return (it != _nodeIds.end() && *it == nodeId) ? (it - _nodeIds.begin()) : _nodeIds.size();
+  }
+
+  std::size_t degree(std::size_t node) const { return _offsets[node + 1] - _offsets[node]; }
+
+  /// first adjacency slot of a node
+  std::size_t adjacencyBegin(std::size_t node) const { return _offsets[node]; }
+  /// one past the last adjacency slot of a node
+  std::size_t adjacencyEnd(std::size_t node) const { return _offsets[node + 1]; }
+  /// node index stored in an adjacency slot
+  IndexT getNeighbor(std::size_t slot) const { return _neighbors[slot]; }
+
+  const IndexT* neighborsBegin(std::size_t node) const { return _neighbors.data() + _offsets[node]; }
+  const IndexT* neighborsEnd(std::size_t node) const { return _neighbors.data() + _offsets[node + 1]; }
+
+private:
+  template <typename IterablePairs>
+  void build(std::vector<IndexT>&& nodeIds, const IterablePairs& pairs)
+  {
+    _nodeIds = std::move(nodeIds);
+
+    std::vector<std::pair<IndexT, IndexT>> edges;
+    for(const auto& pair : pairs)
+    {
+      const IndexT i = static_cast<IndexT>(getNodeIndex(pair.first));
+      const IndexT j = static_cast<IndexT>(getNodeIndex(pair.second));
+      if(i == j || i == _nodeIds.size() || j == _nodeIds.size())
+        continue;
+      edges.emplace_back(i, j);
+      edges.emplace_back(j, i);
+    }
+    buildFromEdges(edges);
+  }
+
+  /**
+   * @brief Fill the CSR arrays from the edges in both directions (node indexes)
+   */
+  void buildFromEdges(std::vector<std::pair<IndexT, IndexT>>& edges);
+
+  /// sorted node ids
+  std::vector<IndexT> _nodeIds;
+  /// first adjacency slot of each node (size: nbNodes + 1)
+  std::vector<std::size_t> _offsets = std::vector<std::size_t>(1, 0);
+  /// sorted neighbors of each node
+  std::vector<IndexT> _neighbors;
+};
+
+/**
+ * @brief List all the triangles of the graph (in parallel).
+ * The nodes are ranked by degree and each triangle is found once from its lowest ranked node,
+ * by intersecting the sorted lists of higher ranked neighbors.
+ * @param[in] graph The view graph
+ * @param[out] out_triplets The triplets of node ids (i < j < k), in lexicographic order
+ */
+void listTriplets(const ViewGraph& graph, std::vector<Triplet>& out_triplets);
+
+/**
+ * @brief Compute the connected components of the graph (in parallel, lock-free union-find).
+ * @param[in] graph The view graph
+ * @param[out] out_componentPerNode The component index of each node, the components are indexed
+ *             in the order of their smallest node
+ * @param[in] isEdgeRemoved optional flag per adjacency slot, the flagged edges are ignored
+ * @return the number of connected components
+ */
+std::size_t connectedComponents(const ViewGraph& graph,
+                                std::vector<IndexT>& out_componentPerNode,
+                                const std::vector<unsigned char>* isEdgeRemoved = nullptr);
+
+/**
+ * @brief Find the bridges of the graph: the edges whose removal disconnects their component
+ * (the cut edges of the bi-edge connected components).
+ * The connected components are processed in parallel.
+ * @param[in] graph The view graph
+ * @param[out] out_isBridge The bridge flag of each adjacency slot (both directions of an edge are flagged)
+ * @return the number of bridges
+ */
+std::size_t findBridges(const ViewGraph& graph, std::vector<unsigned char>& out_isBridge);
+
+/**
+ * @brief Get the node ids of the largest bi-edge connected component of the graph
+ *        (largest connected component once the bridges are removed).
+ */
+std::set<IndexT> getLargestBiEdgeConnectedComponent(const ViewGraph& graph);
+
+} // namespace graph
+} // namespace aliceVision
@@ -9,6 +9,7 @@
 
 #include "aliceVision/types.hpp"
 #include "aliceVision/graph/IndexedGraph.hpp"
+#include "aliceVision/graph/ViewGraph.hpp"
 #include "aliceVision/graph/indexedGraphGraphvizExport.hpp"
 #include "aliceVision/graph/connectedComponent.hpp"
 #include "aliceVision/graph/Triplet.hpp"
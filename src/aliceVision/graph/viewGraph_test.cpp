@@ -0,0 +1,196 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/graph/graph.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#define BOOST_TEST_MODULE viewGraph
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::graph;
+
+/**
+ * @brief Random pairs of views: some clusters of densely connected views,
+ *        linked by a few pairs, and some isolated pairs (with non contiguous view ids).
+ */
+PairSet randomPairs(std::size_t nbClusters, std::size_t clusterSize, double density, std::mt19937& generator)
+{
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  PairSet pairs;
+
+  for(std::size_t c = 0; c < nbClusters; ++c)
+  {
+    for(std::size_t i = 0; i < clusterSize; ++i)
+      for(std::size_t j = i + 1; j < clusterSize; ++j)
+        if(uniform(generator) < density)
+          pairs.emplace(3 * (c * clusterSize + i), 3 * (c * clusterSize + j));
+
+    // a single link between some clusters (a bridge)
+    if(c > 0 && c % 3 != 0)
+      pairs.emplace(3 * ((c - 1) * clusterSize), 3 * (c * clusterSize + 1));
+  }
+  // isolated pairs
+  const IndexT first = 3 * nbClusters * clusterSize + 1;
+  for(IndexT i = 0; i < 10; ++i)
+    pairs.emplace(first + 2 * i, first + 2 * i + 1);
+
+  return pairs;
+}
+
+BOOST_AUTO_TEST_CASE(ViewGraph_CSR)
+{
+  // duplicated edges and self loops are ignored
+  const std::vector<Pair> pairs = {{10, 2}, {2, 10}, {2, 5}, {5, 5}, {7, 2}, {10, 2}};
+  const ViewGraph graph(pairs);
+
+  BOOST_CHECK_EQUAL(graph.nbNodes(), 4);
+  BOOST_CHECK_EQUAL(graph.nbEdges(), 3);
+  BOOST_CHECK_EQUAL(graph.getNodeId(0), 2);
+  BOOST_CHECK_EQUAL(graph.getNodeIndex(10), 3);
+  BOOST_CHECK_EQUAL(graph.getNodeIndex(3), graph.nbNodes());
+  BOOST_CHECK_EQUAL(graph.degree(graph.getNodeIndex(2)), 3);
+  BOOST_CHECK_EQUAL(graph.degree(graph.getNodeIndex(5)), 1);
+
+  // isolated nodes
+  const std::set<IndexT> nodes = {2, 5, 7, 10, 11};
+  const ViewGraph graphWithNodes(nodes, pairs);
+  BOOST_CHECK_EQUAL(graphWithNodes.nbNodes(), 5);
+  BOOST_CHECK_EQUAL(graphWithNodes.degree(4), 0);
+
+  std::vector<IndexT> componentPerNode;
+  BOOST_CHECK_EQUAL(connectedComponents(graphWithNodes, componentPerNode), 2);
+  BOOST_CHECK_EQUAL(componentPerNode[4], 1);
+}
+
+BOOST_AUTO_TEST_CASE(ViewGraph_Triplets)
+{
+  std::mt19937 generator(0);
+  const PairSet pairs = randomPairs(20, 30, 0.3, generator);
+
+  // reference: lemon graph triplets
+  std::vector<Triplet> referenceTriplets;
+  {
+    indexedGraph putativeGraph(pairs);
+    List_Triplets<indexedGraph::GraphT>(putativeGraph.g, referenceTriplets);
+    for(Triplet& triplet : referenceTriplets)
+    {
+      IndexT ids[3] = {(*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(triplet.i)],
+                       (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(triplet.j)],
+                       (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(triplet.k)]};
+      std::sort(&ids[0], &ids[3]);
+      triplet = Triplet(ids[0], ids[1], ids[2]);
+    }
+    std::sort(referenceTriplets.begin(), referenceTriplets.end(), [](const Triplet& a, const Triplet& b)
+    {
+      return std::make_tuple(a.i, a.j, a.k) < std::make_tuple(b.i, b.j, b.k);
+    });
+  }
+
+  const std::vector<Triplet> triplets = tripletListing(pairs);
+
+  BOOST_CHECK_GT(triplets.size(), 1000);
+  BOOST_REQUIRE_EQUAL(triplets.size(), referenceTriplets.size());
+  for(std::size_t t = 0; t < triplets.size(); ++t)
+  {
+    BOOST_CHECK_EQUAL(triplets[t].i, referenceTriplets[t].i);
+    BOOST_CHECK_EQUAL(triplets[t].j, referenceTriplets[t].j);
+    BOOST_CHECK_EQUAL(triplets[t].k, referenceTriplets[t].k);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ViewGraph_BiEdgeConnectedComponent)
+{
+  std::mt19937 generator(1);
+  const PairSet pairs = randomPairs(20, 30, 0.1, generator);
+  const ViewGraph graph(pairs);
+
+  // reference: lemon bridges
+  std::set<Pair> referenceBridges;
+  {
+    indexedGraph putativeGraph(pairs);
+    lemon::ListGraph::EdgeMap<bool> cutMap(putativeGraph.g);
+    lemon::biEdgeConnectedCutEdges(putativeGraph.g, cutMap);
+    for(lemon::ListGraph::EdgeIt e(putativeGraph.g); e != lemon::INVALID; ++e)
+    {
+      if(cutMap[e])
+        referenceBridges.insert(std::minmax((*putativeGraph.map_nodeMapIndex)[putativeGraph.g.u(e)],
+                                            (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.v(e)]));
+    }
+  }
+
+  std::vector<unsigned char> isBridge;
+  const std::size_t nbBridges = findBridges(graph, isBridge);
+
+  std::set<Pair> bridges;
+  for(std::size_t u = 0; u < graph.nbNodes(); ++u)
+    for(std::size_t slot = graph.adjacencyBegin(u); slot < graph.adjacencyEnd(u); ++slot)
+      if(isBridge[slot])
+        bridges.insert(std::minmax(graph.getNodeId(u), graph.getNodeId(graph.getNeighbor(slot))));
+
+  BOOST_CHECK_GT(nbBridges, 10);
+  BOOST_CHECK_EQUAL(nbBridges, bridges.size());
+  BOOST_CHECK(bridges == referenceBridges);
+
+  // the largest bi-edge connected component is one of the clusters
+  const std::set<IndexT> largestComponent = CleanGraph_KeepLargestBiEdge_Nodes<PairSet, IndexT>(pairs);
+  BOOST_CHECK_GE(largestComponent.size(), 20);
+  BOOST_CHECK_LE(largestComponent.size(), 30);
+  const IndexT cluster = *largestComponent.begin() / 90;
+  for(const IndexT id : largestComponent)
+    BOOST_CHECK_EQUAL(id / 90, cluster);
+}
+
+BOOST_AUTO_TEST_CASE(ViewGraph_Threads)
+{
+  // 30 clusters of 40 views: ~12k edges
+  std::mt19937 generator(2);
+  const PairSet pairs = randomPairs(30, 40, 0.5, generator);
+
+  const int maxNbThreads = omp_get_max_threads();
+  const int maxNbThreadsTested = std::max(2, std::min(8, maxNbThreads));
+
+  std::vector<Triplet> referenceTriplets;
+  std::vector<IndexT> referenceComponents;
+  std::vector<unsigned char> referenceBridges;
+
+  for(int nbThreads = 1; nbThreads <= maxNbThreadsTested; nbThreads *= 2)
+  {
+    omp_set_num_threads(nbThreads);
+
+    const ViewGraph graph(pairs);
+
+    std::vector<Triplet> triplets;
+    listTriplets(graph, triplets);
+
+    std::vector<IndexT> componentPerNode;
+    connectedComponents(graph, componentPerNode);
+    std::vector<unsigned char> isBridge;
+    findBridges(graph, isBridge);
+
+    if(nbThreads == 1)
+    {
+      referenceTriplets.swap(triplets);
+      referenceComponents.swap(componentPerNode);
+      referenceBridges.swap(isBridge);
+      continue;
+    }
+
+    // the result does not depend on the number of threads
+    BOOST_REQUIRE_EQUAL(triplets.size(), referenceTriplets.size());
+    for(std::size_t t = 0; t < triplets.size(); ++t)
+      BOOST_CHECK(triplets[t].i == referenceTriplets[t].i && triplets[t].j == referenceTriplets[t].j && triplets[t].k == referenceTriplets[t].k);
+    BOOST_CHECK(componentPerNode == referenceComponents);
+    BOOST_CHECK(isBridge == referenceBridges);
+  }
+
+  omp_set_num_threads(maxNbThreads);
+}
@@ -17,6 +17,8 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <algorithm>
+#include <vector>
 
 
 namespace aliceVision {
@@ -45,34 +47,43 @@ bool DebevecCalibrate::process(const std::vector<std::vector<ImageSample>>& ldrS
     // Initialize response
     response = rgbCurve(channelQuantization);
 
-    // Store intermediate data for all three channels
-
-    // Initialize intermediate buffers
-    for(unsigned int channel = 0; channel < channelsCount; ++channel)
+    // The unknowns are the response curve f (channelQuantization values) and the log radiance of each sample.
+    // Each sample radiance only appears in its own equations, so it is eliminated sample by sample:
+    // the normal equations are
+    //
+    // [A   B] [f]   [h1]
+    // [B^T D] [x] = [h2]
+    //
+    // with D diagonal, which gives (A - B D^-1 B^T) f = h1 - B D^-1 h2.
+    // Each column of B (one sample) only has a few non-zero values (one per bracket),
+    // so the Schur complement is accumulated directly without building B.
+
+    // Channels are independent
+    #pragma omp parallel for
+    for(int channel = 0; channel < int(channelsCount); ++channel)
     {
-        Eigen::MatrixXd A(channelQuantization, channelQuantization);
-        Eigen::MatrixXd B(channelQuantization, totalPoints);
-        Eigen::DiagonalMatrix<double, Eigen::Dynamic> Dinv(totalPoints);
-        Eigen::VectorXd h1(channelQuantization);
-        Eigen::VectorXd h2(totalPoints);
-
-        // Initialize
-        A.fill(0);
-        B.fill(0);
-        h1.fill(0);
-        h2.fill(0);
-        Dinv.setZero();
-
-        size_t countPoints = 0;
+        Eigen::MatrixXd left(channelQuantization, channelQuantization);
+        Eigen::VectorXd right(channelQuantization);
+        left.fill(0);
+        right.fill(0);
+
+        // Non-zero values of the sample column of B
+        std::vector<std::size_t> indices;
+        std::vector<double> values;
+
         for(size_t groupId = 0; groupId < ldrSamples.size(); groupId++)
         {
             /*Process a group of brackets*/
             const std::vector<ImageSample>& group = ldrSamples[groupId];
-            const std::vector<float> & local_times = times[groupId];
 
             for (size_t sampleId = 0; sampleId < group.size(); sampleId++) {
                 
                 const ImageSample & sample = group[sampleId];
+
+                indices.clear();
+                values.clear();
+                double d = 0.0;
+                double h2 = 0.0;
                 
                 for (size_t bracketPos = 0; bracketPos < sample.descriptions.size(); bracketPos++) {
                     
@@ -83,22 +94,45 @@ bool DebevecCalibrate::process(const std::vector<std::vector<ImageSample>>& ldrS
                     const std::size_t index = quantizedValue;
 
                     const float w_ij = std::max(1e-6f, weight(value, channel));
-                    
-                    const std::size_t pospoint = countPoints + sampleId;
 
-                    const double w_ij_2 = w_ij * w_ij;
+                    // a deduplicated sample stands for count identical equations
+                    const double w_ij_2 = double(w_ij) * w_ij * sample.count;
                     const double w_ij2_time = w_ij_2 * time;
 
-                    Dinv.diagonal()[pospoint] += w_ij_2;
-                    A(index, index) += w_ij_2;
-                    B(index, pospoint) -= w_ij_2;
-                    h1(index) += w_ij2_time;
-                    h2(pospoint) += -w_ij2_time;
+                    d += w_ij_2;
+                    left(index, index) += w_ij_2;
+                    right(index) += w_ij2_time;
+                    h2 += -w_ij2_time;
+
+                    const auto it = std::find(indices.begin(), indices.end(), index);
+                    if(it == indices.end())
+                    {
+                        indices.push_back(index);
+                        values.push_back(-w_ij_2);
+                    }
+                    else
+                    {
+                        values[it - indices.begin()] -= w_ij_2;
+                    }
+                }
+
+                if(indices.empty())
+                {
+                    continue;
                 }
-            }
 
-            countPoints += group.size();
-            
+                // Remove B D^-1 B^T and B D^-1 h2 for this sample
+                const double dinv = 1.0 / d;
+                for(std::size_t i = 0; i < indices.size(); ++i)
+                {
+                    const double bdinv = values[i] * dinv;
+                    for(std::size_t j = 0; j < indices.size(); ++j)
+                    {
+                        left(indices[i], indices[j]) -= bdinv * values[j];
+                    }
+                    right(indices[i]) -= bdinv * h2;
+                }
+            }
         }
 
         // Make sure the discrete response curve has a minimal second derivative
@@ -112,17 +146,17 @@ bool DebevecCalibrate::process(const std::vector<std::vector<ImageSample>>& ldrS
             const double v2 = -2.0f * lambda * w;
             const double v3 = lambda * w;
 
-            A(k, k) += v1 * v1;
-            A(k, k + 1) += v1 * v2;
-            A(k, k + 2) += v1 * v3;
+            left(k, k) += v1 * v1;
+            left(k, k + 1) += v1 * v2;
+            left(k, k + 2) += v1 * v3;
 
-            A(k + 1, k) += v2 * v1;
-            A(k + 1, k + 1) += v2 * v2;
-            A(k + 1, k + 2) += v2 * v3;
+            left(k + 1, k) += v2 * v1;
+            left(k + 1, k + 1) += v2 * v2;
+            left(k + 1, k + 2) += v2 * v3;
 
-            A(k + 2, k) += v3 * v1;
-            A(k + 2, k + 1) += v3 * v2;
-            A(k + 2, k + 2) += v3 * v3;
+            left(k + 2, k) += v3 * v1;
+            left(k + 2, k + 1) += v3 * v2;
+            left(k + 2, k + 2) += v3 * v3;
         }
 
         //
@@ -130,30 +164,7 @@ bool DebevecCalibrate::process(const std::vector<std::vector<ImageSample>>& ldrS
         // Enforce f(0.5) = 0.0
         //
         const size_t pos_middle = std::floor(channelQuantization / 2);
-        A(pos_middle, pos_middle) += 1.0f;
-
-        // M is
-        //
-        // [ATL ATR]   [[Mgradient       ][     0]]
-        // [ABL ABR] = [[constraintMiddle][     0]]
-        //             [Mleft               Mright]
-        //
-        // [A B] = [Atl Atr]^T [Atl Atr] = [Atl   0]^T [Atl   0]
-        // [C D]   [Abl Abr]   [Abl Abr]   [Abl Abr]   [Abl Abr]
-        // [A B] = [Atl^T Abl^T][Atl   0] = [Atl^TAtl + Abl^TAbl Abl^TAbr]
-        // [C D]   [0     Abr^T][Abl Abr]   [Abr^TAbl            Abr^TAbr]
-        // [h1] = [Atl^T bh + Abl^T bb] = [Abl^T bb]
-        // [h2]   [Atr^T bh + Abr^T bb]   [Abr^T bb]
-        const Eigen::MatrixXd C = B.transpose();
-
-        for(int i = 0; i < Dinv.rows(); i++)
-        {
-            Dinv.diagonal()[i] = 1.0 / Dinv.diagonal()[i];
-        }
-
-        const Eigen::MatrixXd Bdinv = B * Dinv;
-        const Eigen::MatrixXd left = A - Bdinv * C;
-        const Eigen::VectorXd right = h1 - Bdinv * h2;
+        left(pos_middle, pos_middle) += 1.0f;
 
         const Eigen::VectorXd x = left.lu().solve(right);
 
@@ -42,6 +42,127 @@ inline float sigmoidInv(float zeroVal, float endVal, float sigwidth, float sigMi
     return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + expf(10.0f * ((sigMid - xval) / sigwidth))));
 }
 
+/**
+ * @brief Merge the brackets of a pixel
+ */
+inline void mergePixel(const std::vector< image::Image<image::RGBfColor> > &images,
+                       int y, int x,
+                       const std::vector<float> &times,
+                       const rgbCurve &weight,
+                       const rgbCurve &weightShortestExposure,
+                       const rgbCurve &weightLongestExposure,
+                       const rgbCurve &response,
+                       float targetCameraExposure,
+                       image::RGBfColor &radianceColor)
+{
+  for(std::size_t channel = 0; channel < 3; ++channel)
+  {
+    double wsum = 0.0;
+    double wdiv = 0.0;
+
+    // Merge shortest exposure
+    {
+        int exposureIndex = 0;
+
+        // for each image
+        const double value = images[exposureIndex](y, x)(channel);
+        const double time = times[exposureIndex];
+        //
+        // weightShortestExposure:          _______
+        //                          _______/
+        //                                0      1
+        double w = std::max(0.001f, weightShortestExposure(value, channel));
+
+        const double r = response(value, channel);
+
+        wsum += w * r / time;
+        wdiv += w;
+    }
+    // Merge intermediate exposures
+    for(std::size_t i = 1; i < images.size() - 1; ++i)
+    {
+      // for each image
+      const double value = images[i](y, x)(channel);
+      const double time = times[i];
+      //
+      // weight:          ____
+      //          _______/    \________
+      //                0      1
+      double w = std::max(0.001f, weight(value, channel));
+
+      const double r = response(value, channel);
+      wsum += w * r / time;
+      wdiv += w;
+    }
+    // Merge longest exposure
+    {
+        int exposureIndex = images.size() - 1;
+
+        // for each image
+        const double value = images[exposureIndex](y, x)(channel);
+        const double time = times[exposureIndex];
+        //
+        // weightLongestExposure:  ____________
+        //                                      \_______
+        //                                0      1
+        double w = std::max(0.001f, weightLongestExposure(value, channel));
+
+        const double r = response(value, channel);
+
+        wsum += w * r / time;
+        wdiv += w;
+    }
+    radianceColor(channel) = wsum / std::max(0.001, wdiv) * targetCameraExposure;
+  }
+}
+
+/**
+ * @brief Clamping estimation of a pixel of the shortest exposure
+ */
+inline float getClampingLevel(const image::RGBfColor &color)
+{
+  float isClamped = 0.0f;
+  for (std::size_t channel = 0; channel < 3; ++channel)
+  {
+    // https://www.desmos.com/calculator/vpvzmidy1a
+    //                       ____
+    // sigmoid inv:  _______/
+    //                  0    1
+    isClamped += sigmoidInv(0.0f, 1.0f, /*sigWidth=*/0.08f,  /*sigMid=*/0.95f, color(channel));
+  }
+  return isClamped / 3.0f;
+}
+
+/**
+ * @brief Apply the highlight correction to a pixel
+ */
+inline void correctHighlight(image::RGBfColor &radianceColor, float isPixelClamped_g, float highlightCorrectionFactor, float highlightTarget)
+{
+  double clampingCompensation = highlightCorrectionFactor * isPixelClamped_g;
+  double clampingCompensationInv = (1.0 - clampingCompensation);
+  assert(clampingCompensation <= 1.0);
+
+  for (std::size_t channel = 0; channel < 3; ++channel)
+  {
+    if(highlightTarget > radianceColor(channel))
+    {
+      radianceColor(channel) = float(clampingCompensation * highlightTarget + clampingCompensationInv * radianceColor(channel));
+    }
+  }
+}
+
+/**
+ * @brief Mirrored index (21 | 0123 | 21), the border convention of the separable convolution
+ */
+inline int mirrorIndex(int index, int size)
+{
+  if(index < 0)
+    return std::min(-index, size - 1);
+  if(index >= size)
+    return std::max(2 * size - 2 - index, 0);
+  return index;
+}
+
 void hdrMerge::process(const std::vector< image::Image<image::RGBfColor> > &images,
                         const std::vector<float> &times,
                         const rgbCurve &weight,
@@ -50,16 +171,10 @@ void hdrMerge::process(const std::vector< image::Image<image::RGBfColor> > &imag
                         float targetCameraExposure)
 {
   //checks
-  assert(!response.isEmpty());
   assert(!images.empty());
-  assert(images.size() == times.size());
 
-  // get images width, height
-  const std::size_t width = images.front().Width();
-  const std::size_t height = images.front().Height();
-
-  // resize and reset radiance image to 0.0
-  radiance.resize(width, height, true, image::RGBfColor(0.f, 0.f, 0.f));
+  // resize radiance image
+  radiance.resize(images.front().Width(), images.front().Height(), false);
 
   ALICEVISION_LOG_TRACE("[hdrMerge] Images to fuse:");
   for(int i = 0; i < images.size(); ++i)
@@ -67,78 +182,86 @@ void hdrMerge::process(const std::vector< image::Image<image::RGBfColor> > &imag
     ALICEVISION_LOG_TRACE(images[i].Width() << "x" << images[i].Height() << ", time: " << times[i]);
   }
 
+  processBand(images, 0, times, weight, response, radiance, targetCameraExposure, 0.0f, 0.0f);
+}
+
+void hdrMerge::processBand(const std::vector< image::Image<image::RGBfColor> > &images,
+                           int bandBegin,
+                           const std::vector<float> &times,
+                           const rgbCurve &weight,
+                           const rgbCurve &response,
+                           image::Image<image::RGBfColor> &radiance,
+                           float targetCameraExposure,
+                           float highlightCorrectionFactor,
+                           float highlightTargetLux)
+{
+  //checks
+  assert(!response.isEmpty());
+  assert(!images.empty());
+  assert(images.size() == times.size());
+  assert(bandBegin + radiance.Height() <= images.front().Height());
+
+  const int width = images.front().Width();
+  const int height = images.front().Height();
+
   rgbCurve weightShortestExposure = weight;
   weightShortestExposure.freezeSecondPartValues();
   rgbCurve weightLongestExposure = weight;
   weightLongestExposure.freezeFirstPartValues();
 
-  #pragma omp parallel for
-  for(int y = 0; y < height; ++y)
-  {
-    for(int x = 0; x < width; ++x)
-    {
-      //for each pixels
-      image::RGBfColor &radianceColor = radiance(y, x);
+  const bool correctHighlights = (highlightCorrectionFactor > 0.0f);
 
-      for(std::size_t channel = 0; channel < 3; ++channel)
-      {
-        double wsum = 0.0;
-        double wdiv = 0.0;
+  // Target Camera Exposure = 1 for EV-0 (iso=100, shutter=1, fnumber=1) => 2.5 lux
+  const float highlightTarget = highlightTargetLux * targetCameraExposure * 2.5;
 
-        // Merge shortest exposure
-        {
-            int exposureIndex = 0;
+  // Clamped pixels of the shortest exposure, on the rows of the band and its neighbors
+  image::Image<float> isClamped;
+  const int clampedBegin = std::max(0, bandBegin - 1);
+  const int clampedEnd = std::min(height, bandBegin + int(radiance.Height()) + 1);
+  Vec kernel;
 
-            // for each image
-            const double value = images[exposureIndex](y, x)(channel);
-            const double time = times[exposureIndex];
-            //
-            // weightShortestExposure:          _______
-            //                          _______/
-            //                                0      1
-            double w = std::max(0.001f, weightShortestExposure(value, channel));
+  if(correctHighlights)
+  {
+    kernel = image::ComputeGaussianKernel(3, 1.0);
+    isClamped.resize(width, clampedEnd - clampedBegin, false);
 
-            const double r = response(value, channel);
+    #pragma omp parallel for
+    for(int y = clampedBegin; y < clampedEnd; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        isClamped(y - clampedBegin, x) = getClampingLevel(images.front()(y, x));
+      }
+    }
+  }
 
-            wsum += w * r / time;
-            wdiv += w;
-        }
-        // Merge intermediate exposures
-        for(std::size_t i = 1; i < images.size() - 1; ++i)
-        {
-          // for each image
-          const double value = images[i](y, x)(channel);
-          const double time = times[i];
-          //
-          // weight:          ____
-          //          _______/    \________
-          //                0      1
-          double w = std::max(0.001f, weight(value, channel));
-
-          const double r = response(value, channel);
-          wsum += w * r / time;
-          wdiv += w;
-        }
-        // Merge longest exposure
-        {
-            int exposureIndex = images.size() - 1;
+  #pragma omp parallel for
+  for(int i = 0; i < radiance.Height(); ++i)
+  {
+    const int y = bandBegin + i;
 
-            // for each image
-            const double value = images[exposureIndex](y, x)(channel);
-            const double time = times[exposureIndex];
-            //
-            // weightLongestExposure:  ____________
-            //                                      \_______
-            //                                0      1
-            double w = std::max(0.001f, weightLongestExposure(value, channel));
+    for(int x = 0; x < width; ++x)
+    {
+      image::RGBfColor &radianceColor = radiance(i, x);
 
-            const double r = response(value, channel);
+      mergePixel(images, y, x, times, weight, weightShortestExposure, weightLongestExposure, response, targetCameraExposure, radianceColor);
 
-            wsum += w * r / time;
-            wdiv += w;
+      if(!correctHighlights)
+        continue;
+
+      // Gaussian smoothing of the clamping estimation (3x3, sigma=1)
+      float isClamped_g = 0.0f;
+      for(int ky = 0; ky < 3; ++ky)
+      {
+        const int cy = mirrorIndex(y + ky - 1, height) - clampedBegin;
+        for(int kx = 0; kx < 3; ++kx)
+        {
+          const int cx = mirrorIndex(x + kx - 1, width);
+          isClamped_g += kernel(ky) * kernel(kx) * isClamped(cy, cx);
         }
-        radianceColor(channel) = wsum / std::max(0.001, wdiv) * targetCameraExposure;
       }
+
+      correctHighlight(radianceColor, isClamped_g, highlightCorrectionFactor, highlightTarget);
     }
   }
 }
@@ -175,24 +298,7 @@ void hdrMerge::postProcessHighlight(const std::vector< image::Image<image::RGBfC
     {
         for (int x = 0; x < width; ++x)
         {
-            //for each pixels
-            image::RGBfColor &radianceColor = radiance(y, x);
-
-            float& isClamped = isPixelClamped(y, x);
-            isClamped = 0.0f;
-
-            for (std::size_t channel = 0; channel < 3; ++channel)
-            {
-                const float value = inputImage(y, x)(channel);
-
-                // https://www.desmos.com/calculator/vpvzmidy1a
-                //                       ____
-                // sigmoid inv:  _______/
-                //                  0    1
-                const float isChannelClamped = sigmoidInv(0.0f, 1.0f, /*sigWidth=*/0.08f,  /*sigMid=*/0.95f, value);
-                isClamped += isChannelClamped;
-            }
-            isPixelClamped(y, x) /= 3.0;
+            isPixelClamped(y, x) = getClampingLevel(inputImage(y, x));
         }
     }
 
@@ -204,19 +310,7 @@ void hdrMerge::postProcessHighlight(const std::vector< image::Image<image::RGBfC
     {
         for (int x = 0; x < width; ++x)
         {
-            image::RGBfColor& radianceColor = radiance(y, x);
-
-            double clampingCompensation = highlightCorrectionFactor * isPixelClamped_g(y, x);
-            double clampingCompensationInv = (1.0 - clampingCompensation);
-            assert(clampingCompensation <= 1.0);
-
-            for (std::size_t channel = 0; channel < 3; ++channel)
-            {
-                if(highlightTarget > radianceColor(channel))
-                {
-                    radianceColor(channel) = float(clampingCompensation * highlightTarget + clampingCompensationInv * radianceColor(channel));
-                }
-            }
+            correctHighlight(radiance(y, x), isPixelClamped_g(y, x), highlightCorrectionFactor, highlightTarget);
         }
     }
 }
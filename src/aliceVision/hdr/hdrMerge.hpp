@@ -31,6 +31,31 @@ public:
                 image::Image<image::RGBfColor> &radiance,
                 float targetCameraExposure);
 
+  /**
+   * @brief Merge a band of rows and apply the highlight correction in the same pass.
+   * The brackets only need to contain the rows of the band, plus the rows above and below
+   * (when they exist) used to smooth the highlight correction.
+   * The rows outside of the brackets are mirrored, as for the whole image.
+   * @param[in] images the rows of the LDR images, from the shortest to the longest exposure
+   * @param[in] bandBegin the row of the images where the band begins
+   * @param[in] times the exposures of the images
+   * @param[in] weight the fusion weight function
+   * @param[in] response the camera response function
+   * @param[out] radiance the merged band, already allocated with the size of the band
+   * @param[in] targetCameraExposure the exposure of the output
+   * @param[in] highlightCorrectionFactor the highlight correction (0 means no correction)
+   * @param[in] highlightTargetLux the maximum luminance of the corrected highlights
+   */
+  void processBand(const std::vector< image::Image<image::RGBfColor> > &images,
+                   int bandBegin,
+                   const std::vector<float> &times,
+                   const rgbCurve &weight,
+                   const rgbCurve &response,
+                   image::Image<image::RGBfColor> &radiance,
+                   float targetCameraExposure,
+                   float highlightCorrectionFactor,
+                   float highlightTargetLux);
+
   void postProcessHighlight(const std::vector< image::Image<image::RGBfColor> > &images,
       const std::vector<float> &times,
       const rgbCurve &weight,
@@ -0,0 +1,117 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/hdr/hdrMerge.hpp>
+
+#include <algorithm>
+#include <random>
+
+#define BOOST_TEST_MODULE hdrMerge
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+const int width = 97;
+const int height = 61;
+
+/**
+ * @brief Random brackets of the same scene, with saturated pixels on all the exposures.
+ */
+std::vector<image::Image<image::RGBfColor>> generateBrackets(const std::vector<float>& times)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(0.0f, 8.0f);
+
+    image::Image<image::RGBfColor> radiance(width, height);
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < width; ++x)
+            radiance(y, x) = image::RGBfColor(distribution(generator), distribution(generator), distribution(generator));
+
+    std::vector<image::Image<image::RGBfColor>> brackets;
+    for(const float time : times)
+    {
+        image::Image<image::RGBfColor> bracket(width, height);
+        for(int y = 0; y < height; ++y)
+            for(int x = 0; x < width; ++x)
+                for(int channel = 0; channel < 3; ++channel)
+                    bracket(y, x)(channel) = std::min(1.0f, radiance(y, x)(channel) * time);
+        brackets.push_back(bracket);
+    }
+    return brackets;
+}
+
+/**
+ * @brief Merge the brackets band by band, each band only seeing its rows and their neighbors, as LdrToHdrMerge.
+ */
+image::Image<image::RGBfColor> mergeByBands(const std::vector<image::Image<image::RGBfColor>>& brackets,
+                                            const std::vector<float>& times, const hdr::rgbCurve& weight,
+                                            const hdr::rgbCurve& response, float highlightCorrectionFactor,
+                                            int rowsPerBand)
+{
+    hdr::hdrMerge merge;
+    image::Image<image::RGBfColor> radiance(width, height);
+
+    for(int bandBegin = 0; bandBegin < height; bandBegin += rowsPerBand)
+    {
+        const int bandEnd = std::min(height, bandBegin + rowsPerBand);
+        const int rowsBegin = std::max(0, bandBegin - 1);
+        const int rowsEnd = std::min(height, bandEnd + 1);
+
+        std::vector<image::Image<image::RGBfColor>> rows;
+        for(const image::Image<image::RGBfColor>& bracket : brackets)
+            rows.emplace_back(bracket.block(rowsBegin, 0, rowsEnd - rowsBegin, width));
+
+        image::Image<image::RGBfColor> band(width, bandEnd - bandBegin);
+        merge.processBand(rows, bandBegin - rowsBegin, times, weight, response, band, 1.0f, highlightCorrectionFactor, 120000.0f);
+        radiance.block(bandBegin, 0, bandEnd - bandBegin, width) = band;
+    }
+    return radiance;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(hdr_mergeBandsFull)
+{
+    const std::vector<float> times = {0.25f, 1.0f, 4.0f};
+    const std::vector<image::Image<image::RGBfColor>> brackets = generateBrackets(times);
+
+    hdr::rgbCurve weight(1024);
+    weight.setFunction(hdr::EFunctionType::GAUSSIAN);
+    hdr::rgbCurve response(1024);
+    response.setLinear();
+
+    for(const float highlightCorrectionFactor : {0.0f, 1.0f})
+    {
+        hdr::hdrMerge merge;
+        image::Image<image::RGBfColor> reference(width, height);
+        merge.process(brackets, times, weight, response, reference, 1.0f);
+        if(highlightCorrectionFactor > 0.0f)
+            merge.postProcessHighlight(brackets, times, weight, response, reference, 1.0f, highlightCorrectionFactor, 120000.0f);
+
+        for(const int rowsPerBand : {1, 2, 7, 16, height})
+        {
+            const image::Image<image::RGBfColor> radiance =
+                mergeByBands(brackets, times, weight, response, highlightCorrectionFactor, rowsPerBand);
+
+            // the whole image smoothing mirrors the right border one column too far: the last column is skipped
+            const int checkedWidth = (highlightCorrectionFactor > 0.0f) ? width - 1 : width;
+
+            float maxError = 0.0f;
+            for(int y = 0; y < height; ++y)
+                for(int x = 0; x < checkedWidth; ++x)
+                    for(int channel = 0; channel < 3; ++channel)
+                        maxError = std::max(maxError, std::abs(radiance(y, x)(channel) - reference(y, x)(channel)) /
+                                                          std::max(1.0f, std::abs(reference(y, x)(channel))));
+
+            BOOST_TEST_MESSAGE("highlight correction " << highlightCorrectionFactor << ", " << rowsPerBand
+                                                       << " rows per band: max relative error " << maxError);
+            BOOST_CHECK_SMALL(maxError, 1e-5f);
+        }
+    }
+}
@@ -11,6 +11,10 @@
 
 #include <OpenImageIO/imagebufalgo.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
 
 namespace aliceVision {
 namespace hdr {
@@ -29,63 +33,217 @@ bool UniqueDescriptor::operator<(const UniqueDescriptor &o ) const
     return false;
 }
 
-std::ostream & operator<<(std::ostream& os, const ImageSample & s)
+namespace {
+
+const char samplesFileMagic[4] = {'A', 'V', 'H', 'S'};
+const std::uint32_t samplesFileVersion = 2;
+
+template <typename T>
+void writeArray(std::ostream& os, const std::vector<T>& values)
+{
+    if(!values.empty())
+        os.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+void readArray(std::istream& is, std::vector<T>& values, std::size_t size)
 {
-    os.write((const char*)&s.x, sizeof(s.x));
-    os.write((const char*)&s.y, sizeof(s.y));
+    values.resize(size);
+    if(!values.empty())
+        is.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+}
+
+} // namespace
 
-    std::size_t size = s.descriptions.size();
-    os.write((const char*)&size, sizeof(size));
+bool writeSamples(const std::string& path, const std::vector<ImageSample>& samples)
+{
+    // Table of the exposures used by the samples
+    std::vector<float> exposures;
+    for(const ImageSample& sample : samples)
+    {
+        for(const PixelDescription& description : sample.descriptions)
+        {
+            if(std::find(exposures.begin(), exposures.end(), description.exposure) == exposures.end())
+                exposures.push_back(description.exposure);
+        }
+    }
 
-    for (int i = 0; i  < s.descriptions.size(); ++i)
+    if(exposures.size() > 255)
     {
-        os << s.descriptions[i];
+        ALICEVISION_LOG_ERROR("Too many exposures to write the samples (" << exposures.size() << ").");
+        return false;
     }
 
-    return os;
-}
+    std::size_t countDescriptions = 0;
+    for(const ImageSample& sample : samples)
+    {
+        if(sample.descriptions.size() > 255)
+        {
+            ALICEVISION_LOG_ERROR("Too many descriptions in a sample to write the samples (" << sample.descriptions.size() << ").");
+            return false;
+        }
+        countDescriptions += sample.descriptions.size();
+    }
 
-std::istream & operator>>(std::istream& is, ImageSample & s)
-{
-    std::size_t size;
+    std::vector<std::uint32_t> coordinates(samples.size() * 2);
+    std::vector<std::uint32_t> sampleCounts(samples.size());
+    std::vector<std::uint8_t> countPerSample(samples.size());
+    std::vector<std::uint8_t> exposureIndices(countDescriptions);
+    std::vector<float> values(countDescriptions * 6);
 
-    is.read((char *)&s.x, sizeof(s.x));
-    is.read((char *)&s.y, sizeof(s.y));
-    is.read((char *)&size, sizeof(size));
-    s.descriptions.resize(size);
+    std::size_t descriptionIndex = 0;
+    for(std::size_t i = 0; i < samples.size(); ++i)
+    {
+        const ImageSample& sample = samples[i];
+        coordinates[2 * i] = std::uint32_t(sample.x);
+        coordinates[2 * i + 1] = std::uint32_t(sample.y);
+        sampleCounts[i] = sample.count;
+        countPerSample[i] = std::uint8_t(sample.descriptions.size());
+
+        for(const PixelDescription& description : sample.descriptions)
+        {
+            exposureIndices[descriptionIndex] = std::uint8_t(std::find(exposures.begin(), exposures.end(), description.exposure) - exposures.begin());
+            float* value = &values[descriptionIndex * 6];
+            for(int channel = 0; channel < 3; ++channel)
+            {
+                value[channel] = description.mean(channel);
+                value[3 + channel] = description.variance(channel);
+            }
+            ++descriptionIndex;
+        }
+    }
 
-    for (int i = 0; i  < size; ++i)
+    std::ofstream os(path, std::ios::binary);
+    if(!os.is_open())
     {
-        is >> s.descriptions[i];
+        ALICEVISION_LOG_ERROR("Impossible to write samples to file " << path);
+        return false;
     }
 
-    return is;
-}
+    const std::uint32_t countExposures = std::uint32_t(exposures.size());
+    const std::uint64_t countSamples = samples.size();
+    const std::uint64_t countAllDescriptions = countDescriptions;
+
+    os.write(samplesFileMagic, sizeof(samplesFileMagic));
+    os.write(reinterpret_cast<const char*>(&samplesFileVersion), sizeof(samplesFileVersion));
+    os.write(reinterpret_cast<const char*>(&countExposures), sizeof(countExposures));
+    os.write(reinterpret_cast<const char*>(&countSamples), sizeof(countSamples));
+    os.write(reinterpret_cast<const char*>(&countAllDescriptions), sizeof(countAllDescriptions));
+    writeArray(os, exposures);
+    writeArray(os, coordinates);
+    writeArray(os, sampleCounts);
+    writeArray(os, countPerSample);
+    writeArray(os, exposureIndices);
+    writeArray(os, values);
+
+    if(!os.good())
+    {
+        ALICEVISION_LOG_ERROR("Failed to write samples to file " << path);
+        return false;
+    }
 
-std::ostream & operator<<(std::ostream& os, const PixelDescription & p)
-{
-    os.write((const char *)&p.exposure, sizeof(p.exposure));
-    os.write((const char *)&p.mean.r(), sizeof(p.mean.r()));
-    os.write((const char *)&p.mean.g(), sizeof(p.mean.g()));
-    os.write((const char *)&p.mean.b(), sizeof(p.mean.b()));
-    os.write((const char *)&p.variance.r(), sizeof(p.variance.r()));
-    os.write((const char *)&p.variance.g(), sizeof(p.variance.g()));
-    os.write((const char *)&p.variance.b(), sizeof(p.variance.b()));
-
-    return os;
+    return true;
 }
 
-std::istream & operator>>(std::istream& is, PixelDescription & p)
+bool readSamples(std::vector<ImageSample>& samples, const std::string& path)
 {
-    is.read((char *)&p.exposure, sizeof(p.exposure));
-    is.read((char *)&p.mean.r(), sizeof(p.mean.r()));
-    is.read((char *)&p.mean.g(), sizeof(p.mean.g()));
-    is.read((char *)&p.mean.b(), sizeof(p.mean.b()));
-    is.read((char *)&p.variance.r(), sizeof(p.variance.r()));
-    is.read((char *)&p.variance.g(), sizeof(p.variance.g()));
-    is.read((char *)&p.variance.b(), sizeof(p.variance.b()));
-
-    return is;
+    std::ifstream is(path, std::ios::binary);
+    if(!is.is_open())
+    {
+        ALICEVISION_LOG_ERROR("Impossible to read samples from file " << path);
+        return false;
+    }
+
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint32_t countExposures = 0;
+    std::uint64_t countSamples = 0;
+    std::uint64_t countDescriptions = 0;
+
+    is.read(magic, sizeof(magic));
+    is.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if(!is.good() || !std::equal(magic, magic + 4, samplesFileMagic) || version != samplesFileVersion)
+    {
+        ALICEVISION_LOG_ERROR("Invalid samples file (unknown format or version): " << path);
+        return false;
+    }
+
+    is.read(reinterpret_cast<char*>(&countExposures), sizeof(countExposures));
+    is.read(reinterpret_cast<char*>(&countSamples), sizeof(countSamples));
+    is.read(reinterpret_cast<char*>(&countDescriptions), sizeof(countDescriptions));
+
+    // Check the counts against the file size before allocating the arrays
+    const std::streampos dataBegin = is.tellg();
+    is.seekg(0, std::ios::end);
+    const std::uint64_t fileDataSize = std::uint64_t(is.tellg() - dataBegin);
+    is.seekg(dataBegin);
+    if(!is.good() || countExposures > fileDataSize || countSamples > fileDataSize || countDescriptions > fileDataSize ||
+       std::uint64_t(countExposures) * sizeof(float) +
+               countSamples * (3 * sizeof(std::uint32_t) + sizeof(std::uint8_t)) +
+               countDescriptions * (sizeof(std::uint8_t) + 6 * sizeof(float)) != fileDataSize)
+    {
+        ALICEVISION_LOG_ERROR("Corrupted samples file: " << path);
+        return false;
+    }
+
+    std::vector<float> exposures;
+    std::vector<std::uint32_t> coordinates;
+    std::vector<std::uint32_t> sampleCounts;
+    std::vector<std::uint8_t> countPerSample;
+    std::vector<std::uint8_t> exposureIndices;
+    std::vector<float> values;
+
+    readArray(is, exposures, countExposures);
+    readArray(is, coordinates, countSamples * 2);
+    readArray(is, sampleCounts, countSamples);
+    readArray(is, countPerSample, countSamples);
+    readArray(is, exposureIndices, countDescriptions);
+    readArray(is, values, countDescriptions * 6);
+
+    if(!is.good())
+    {
+        ALICEVISION_LOG_ERROR("Failed to read samples from file " << path);
+        return false;
+    }
+
+    samples.clear();
+    samples.resize(countSamples);
+
+    std::size_t descriptionIndex = 0;
+    for(std::size_t i = 0; i < samples.size(); ++i)
+    {
+        ImageSample& sample = samples[i];
+        sample.x = coordinates[2 * i];
+        sample.y = coordinates[2 * i + 1];
+        sample.count = sampleCounts[i];
+        sample.descriptions.resize(countPerSample[i]);
+
+        if(descriptionIndex + countPerSample[i] > countDescriptions)
+        {
+            ALICEVISION_LOG_ERROR("Corrupted samples file: " << path);
+            return false;
+        }
+
+        for(PixelDescription& description : sample.descriptions)
+        {
+            if(exposureIndices[descriptionIndex] >= countExposures)
+            {
+                ALICEVISION_LOG_ERROR("Corrupted samples file: " << path);
+                return false;
+            }
+
+            description.exposure = exposures[exposureIndices[descriptionIndex]];
+            const float* value = &values[descriptionIndex * 6];
+            for(int channel = 0; channel < 3; ++channel)
+            {
+                description.mean(channel) = value[channel];
+                description.variance(channel) = value[3 + channel];
+            }
+            ++descriptionIndex;
+        }
+    }
+
+    return true;
 }
 
 void integral(image::Image<image::Rgb<double>> & dest, const Eigen::Matrix<image::RGBfColor, Eigen::Dynamic, Eigen::Dynamic> & source)
@@ -162,14 +320,26 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
         }
     }
 
+    const std::size_t nbPixels = imageWidth * imageHeight;
+    const int nbBrackets = int(imagePaths.size());
+
+    if (nbPixels == 0)
+    {
+        // Why? just to be sure
+        return false;
+    }
+
+    // Mean and variance of the patch around each pixel, stored bracket after bracket
+    std::vector<RGBfColor> means(nbPixels * nbBrackets);
+    std::vector<RGBfColor> variances(nbPixels * nbBrackets);
+    // Pixels with a full patch inside a block
+    std::vector<std::uint8_t> hasPatch(nbPixels, 0);
+
     Image<RGBfColor> img;
 
     // For all brackets, For each pixel, compute image sample
-    image::Image<ImageSample> samples(imageWidth, imageHeight, true);
     for (unsigned int idBracket = 0; idBracket < imagePaths.size(); ++idBracket)
     {
-        const float exposure = times[idBracket];
-
         image::ImageReadOptions options;
         options.outputColorSpace = colorspace;
         options.applyWhiteBalance = applyWhiteBalance;
@@ -187,6 +357,9 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
             throw std::runtime_error(ss.str());
         }
 
+        RGBfColor* bracketMeans = &means[idBracket * nbPixels];
+        RGBfColor* bracketVariances = &variances[idBracket * nbPixels];
+
         #pragma omp parallel for
         for (int idx = 0; idx < vec_blocks.size(); ++idx)
         {
@@ -197,7 +370,6 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
             int blockHeight = ((img.Height() - cy) > params.blockSize) ? params.blockSize : img.Height() - cy;
 
             auto blockInput = img.block(cy, cx, blockHeight, blockWidth);
-            auto blockOutput = samples.block(cy, cx, blockHeight, blockWidth);
 
             // Stats for deviation
             Image<Rgb<double>> imgIntegral, imgIntegralSquare; 
@@ -213,54 +385,44 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
                 {
                     image::Rgb<double> S1 = imgIntegral(y + params.radius, x + params.radius) + imgIntegral(y - radiusp1, x - radiusp1) - imgIntegral(y + params.radius, x - radiusp1) - imgIntegral(y - radiusp1, x + params.radius);
                     image::Rgb<double> S2 = imgIntegralSquare(y + params.radius, x + params.radius) + imgIntegralSquare(y - radiusp1, x - radiusp1) - imgIntegralSquare(y + params.radius, x - radiusp1) - imgIntegralSquare(y - radiusp1, x + params.radius);
-                    
-                    PixelDescription pd;
-                    
-                    pd.exposure = exposure;
-                    pd.mean.r() = blockInput(y,x).r(); 
-                    pd.mean.g() = blockInput(y,x).g(); 
-                    pd.mean.b() = blockInput(y,x).b();
-                    pd.variance.r() = (S2.r() - (S1.r()*S1.r()) / area) / area;
-                    pd.variance.g() = (S2.g() - (S1.g()*S1.g()) / area) / area;
-                    pd.variance.b() = (S2.b() - (S1.b()*S1.b()) / area) / area;
-
-                    blockOutput(y, x).x = cx + x;
-                    blockOutput(y, x).y = cy + y;
-                    blockOutput(y, x).descriptions.push_back(pd);
+
+                    const std::size_t pixel = std::size_t(cy + y) * imageWidth + std::size_t(cx + x);
+
+                    bracketMeans[pixel] = blockInput(y, x);
+                    bracketVariances[pixel].r() = (S2.r() - (S1.r()*S1.r()) / area) / area;
+                    bracketVariances[pixel].g() = (S2.g() - (S1.g()*S1.g()) / area) / area;
+                    bracketVariances[pixel].b() = (S2.b() - (S1.b()*S1.b()) / area) / area;
+                    hasPatch[pixel] = 1;
                 }
             }
         }
     }
 
-    if (samples.Width() == 0)
-    {
-        // Why? just to be sure
-        return false;
-    }
+    // Range of valid brackets for each pixel (-1 if the pixel is not used)
+    std::vector<int> firstValid(nbPixels, -1);
+    std::vector<int> lastValid(nbPixels, -1);
 
-    // Create samples image
     #pragma omp parallel for
-    for (int y = params.radius; y < samples.Height() - params.radius; ++y)
+    for (int y = params.radius; y < int(imageHeight) - params.radius; ++y)
     {
-        for (int x = params.radius; x < samples.Width() - params.radius; ++x)
+        for (int x = params.radius; x < int(imageWidth) - params.radius; ++x)
         {
-            ImageSample & sample = samples(y, x);
-            if (sample.descriptions.size() < 2)
+            const std::size_t pixel = std::size_t(y) * imageWidth + std::size_t(x);
+            if (!hasPatch[pixel] || nbBrackets < 2)
             {
                 continue;
             }
 
-            int last_ok = 0;
-
             // Make sure we don't have a patch with high variance on any bracket.
             // If the variance is too high somewhere, ignore the whole coordinate samples
             bool valid = true;
             const float maxVariance = 0.05f;
-            for (int k = 0; k < sample.descriptions.size(); ++k)
+            for (int k = 0; k < nbBrackets; ++k)
             {
-                if (sample.descriptions[k].variance.r() > maxVariance ||
-                    sample.descriptions[k].variance.g() > maxVariance ||
-                    sample.descriptions[k].variance.b() > maxVariance)
+                const RGBfColor& variance = variances[k * nbPixels + pixel];
+                if (variance.r() > maxVariance ||
+                    variance.g() > maxVariance ||
+                    variance.b() > maxVariance)
                 {
                     valid = false;
                     break;
@@ -269,23 +431,25 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
 
             if (!valid)
             {
-                sample.descriptions.clear();
                 continue;
             }
 
             // Makes sure the curve is monotonic
             int firstvalid = -1;
             int lastvalid = 0;
-            for (std::size_t k = 1; k < sample.descriptions.size(); ++k)
+            for (int k = 1; k < nbBrackets; ++k)
             {
+                const RGBfColor& previous = means[(k - 1) * nbPixels + pixel];
+                const RGBfColor& current = means[k * nbPixels + pixel];
+
                 bool valid = false;
 
                 // Threshold on the max values, to avoid using fully saturated pixels
                 // TODO: on RAW images, values can be higher. May need to be computed dynamically?
                 const float maxValue = 0.99f;
-                if(sample.descriptions[k].mean.r() > maxValue ||
-                   sample.descriptions[k].mean.g() > maxValue ||
-                   sample.descriptions[k].mean.b() > maxValue)
+                if(current.r() > maxValue ||
+                   current.g() > maxValue ||
+                   current.b() > maxValue)
                 {
                     continue;
                 }
@@ -293,29 +457,29 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
                 // Ensures that at least one channel is strictly increasing with increasing exposure
                 // TODO: check "exposure" params, we may have the same exposure multiple times
                 const float minIncreaseRatio = 1.004f;
-                if(sample.descriptions[k].mean.r() > minIncreaseRatio * sample.descriptions[k - 1].mean.r() ||
-                   sample.descriptions[k].mean.g() > minIncreaseRatio * sample.descriptions[k - 1].mean.g() ||
-                   sample.descriptions[k].mean.b() > minIncreaseRatio * sample.descriptions[k - 1].mean.b())
+                if(current.r() > minIncreaseRatio * previous.r() ||
+                   current.g() > minIncreaseRatio * previous.g() ||
+                   current.b() > minIncreaseRatio * previous.b())
                 {
                     valid = true;
                 }
 
                 // Ensures that the values of each channel are increasing with increasing exposure
-                if (sample.descriptions[k].mean.r() < sample.descriptions[k - 1].mean.r() ||
-                    sample.descriptions[k].mean.g() < sample.descriptions[k - 1].mean.g() ||
-                    sample.descriptions[k].mean.b() < sample.descriptions[k - 1].mean.b())
+                if (current.r() < previous.r() ||
+                    current.g() < previous.g() ||
+                    current.b() < previous.b())
                 {
                     valid = false;
                 }
 
                 // If we have enough information to analyze the chrominance
                 const float minGlobalValue = 0.1f;
-                if(sample.descriptions[k - 1].mean.norm() > minGlobalValue)
+                if(previous.norm() > minGlobalValue)
                 {
                     // Check that both colors are similars
-                    const float n1 = sample.descriptions[k - 1].mean.norm();
-                    const float n2 = sample.descriptions[k].mean.norm();
-                    const float dot = sample.descriptions[k - 1].mean.dot(sample.descriptions[k].mean);
+                    const float n1 = previous.norm();
+                    const float n2 = current.norm();
+                    const float dot = previous.dot(current);
                     const float cosa = dot / (n1*n2);
                     
                     const float maxCosa = 0.95f; // ~ 18deg
@@ -329,9 +493,9 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
                 {
                     if (firstvalid < 0)
                     {
-                        firstvalid = int(k) - 1;
+                        firstvalid = k - 1;
                     }
-                    lastvalid = int(k);
+                    lastvalid = k;
                 }
                 else
                 {
@@ -344,95 +508,221 @@ bool Sampling::extractSamplesFromImages(std::vector<ImageSample>& out_samples, c
 
             if (lastvalid == 0 || firstvalid < 0)
             {
-                sample.descriptions.clear();
                 continue;
             }
 
-            if (firstvalid > 0 || lastvalid < int(sample.descriptions.size()) - 1)
+            firstValid[pixel] = firstvalid;
+            lastValid[pixel] = lastvalid;
+        }
+    }
+
+    const auto quantize = [channelQuantization](float value) {
+        return int(std::round(value * (channelQuantization - 1)));
+    };
+
+    // Number of pixels represented by each pixel (empty without deduplication)
+    std::vector<std::uint32_t> pixelCounts;
+
+    if (params.removeDuplicates)
+    {
+        // Pixels with the same quantized values on the same brackets only repeat the same equations
+        // in the calibration: keep the first one of them, with the number of pixels it represents.
+        std::vector<std::uint64_t> hashes(nbPixels, 0);
+
+        #pragma omp parallel for
+        for (int y = 0; y < int(imageHeight); ++y)
+        {
+            for (std::size_t pixel = y * imageWidth; pixel < (y + 1) * imageWidth; ++pixel)
+            {
+                if (firstValid[pixel] < 0)
+                {
+                    continue;
+                }
+
+                // FNV-1a on the bracket range and the quantized values
+                std::uint64_t hash = 14695981039346656037ULL;
+                const auto combine = [&hash](std::uint64_t value) {
+                    hash = (hash ^ value) * 1099511628211ULL;
+                };
+                combine(std::uint64_t(firstValid[pixel]));
+                combine(std::uint64_t(lastValid[pixel]));
+                for (int k = firstValid[pixel]; k <= lastValid[pixel]; ++k)
+                {
+                    for (int channel = 0; channel < 3; ++channel)
+                    {
+                        combine(std::uint64_t(std::uint32_t(quantize(means[k * nbPixels + pixel](channel)))));
+                    }
+                }
+                hashes[pixel] = hash;
+            }
+        }
+
+        std::vector<std::pair<std::uint64_t, std::size_t>> sortedPixels;
+        for (std::size_t pixel = 0; pixel < nbPixels; ++pixel)
+        {
+            if (firstValid[pixel] >= 0)
+            {
+                sortedPixels.emplace_back(hashes[pixel], pixel);
+            }
+        }
+        std::sort(sortedPixels.begin(), sortedPixels.end());
+
+        const auto isSameSample = [&](std::size_t pixelA, std::size_t pixelB) {
+            if (firstValid[pixelA] != firstValid[pixelB] || lastValid[pixelA] != lastValid[pixelB])
+            {
+                return false;
+            }
+            for (int k = firstValid[pixelA]; k <= lastValid[pixelA]; ++k)
+            {
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    if (quantize(means[k * nbPixels + pixelA](channel)) != quantize(means[k * nbPixels + pixelB](channel)))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        };
+
+        std::size_t countDuplicates = 0;
+        pixelCounts.assign(nbPixels, 1);
+        for (std::size_t begin = 0; begin < sortedPixels.size();)
+        {
+            std::size_t end = begin + 1;
+            while (end < sortedPixels.size() && sortedPixels[end].first == sortedPixels[begin].first)
+            {
+                ++end;
+            }
+
+            // Compare each pixel with the kept pixels of the same hash (usually a single one)
+            std::vector<std::size_t> kept;
+            for (std::size_t i = begin; i < end; ++i)
             {
-                std::vector<PixelDescription> replace;
-                for (int pos = firstvalid; pos <= lastvalid; ++pos)
+                const std::size_t pixel = sortedPixels[i].second;
+                bool duplicate = false;
+                for (std::size_t keptPixel : kept)
+                {
+                    if (isSameSample(keptPixel, pixel))
+                    {
+                        ++pixelCounts[keptPixel];
+                        duplicate = true;
+                        break;
+                    }
+                }
+
+                if (duplicate)
+                {
+                    firstValid[pixel] = -1;
+                    ++countDuplicates;
+                }
+                else
                 {
-                    replace.push_back(sample.descriptions[pos]);
+                    kept.push_back(pixel);
                 }
-                sample.descriptions = replace;
             }
+
+            begin = end;
         }
+
+        ALICEVISION_LOG_DEBUG("Removed " << countDuplicates << " duplicated samples out of " << sortedPixels.size() << ".");
+    }
+
+    // Unique exposures, in the order of the descriptors
+    std::vector<float> exposures(times.begin(), times.end());
+    std::sort(exposures.begin(), exposures.end());
+    exposures.erase(std::unique(exposures.begin(), exposures.end()), exposures.end());
+
+    std::vector<int> exposureIndices(nbBrackets);
+    for (int k = 0; k < nbBrackets; ++k)
+    {
+        exposureIndices[k] = int(std::lower_bound(exposures.begin(), exposures.end(), times[k]) - exposures.begin());
     }
 
-    // Get a counter for all unique descriptors
-    using Coordinates = std::pair<int, int>;
-    using CoordinatesList = std::vector<Coordinates>;
-    using Counters = std::map<UniqueDescriptor, CoordinatesList>;
+    // Get a counter for all unique descriptors, sorted as the UniqueDescriptor (exposure, channel, quantized value)
+    using CoordinatesList = std::vector<std::uint32_t>;
+    using Counters = std::vector<CoordinatesList>;
+    const std::size_t nbDescriptors = exposures.size() * 3 * channelQuantization;
 
-    Counters counters;
+    Counters counters(nbDescriptors);
     {
-        std::vector<Counters> counters_vec(omp_get_max_threads());
+        std::vector<Counters> counters_vec(omp_get_max_threads(), Counters(nbDescriptors));
 
         #pragma omp parallel for
-        for (int y = params.radius; y < samples.Height() - params.radius; ++y)
+        for (int y = params.radius; y < int(imageHeight) - params.radius; ++y)
         {
             Counters & counters_thread = counters_vec[omp_get_thread_num()];
 
-            for (int x = params.radius; x < samples.Width() - params.radius; ++x)
+            for (int x = params.radius; x < int(imageWidth) - params.radius; ++x)
             {
-                const ImageSample & sample = samples(y, x);
-                UniqueDescriptor desc;
-
-                for (int k = 0; k < sample.descriptions.size(); ++k)
+                const std::size_t pixel = std::size_t(y) * imageWidth + std::size_t(x);
+                if (firstValid[pixel] < 0)
                 {
-                    desc.exposure = sample.descriptions[k].exposure;
+                    continue;
+                }
 
+                for (int k = firstValid[pixel]; k <= lastValid[pixel]; ++k)
+                {
                     for (int channel = 0; channel < 3; ++channel)
                     {
-                        desc.channel = channel;
                         // Get quantized value
-                        desc.quantizedValue = int(std::round(sample.descriptions[k].mean(channel)  * (channelQuantization - 1)));
-                        if (desc.quantizedValue < 0 || desc.quantizedValue >= channelQuantization)
+                        const int quantizedValue = quantize(means[k * nbPixels + pixel](channel));
+                        if (quantizedValue < 0 || quantizedValue >= channelQuantization)
                         {
                             continue;
-                        }                        
-                        Coordinates coordinates = std::make_pair(sample.x, sample.y);
-                        counters_thread[desc].push_back(coordinates);
+                        }
+                        const std::size_t descriptor = (exposureIndices[k] * 3 + channel) * channelQuantization + quantizedValue;
+                        counters_thread[descriptor].push_back(std::uint32_t(pixel));
                     }
                 }
             }
         }
 
-        for(int i = 0; i < counters_vec.size(); ++i)
+        #pragma omp parallel for
+        for (int descriptor = 0; descriptor < int(nbDescriptors); ++descriptor)
         {
-            for (auto & item : counters_vec[i])
+            for (int i = 0; i < counters_vec.size(); ++i)
             {
-                auto found = counters.find(item.first);
-                if (found != counters.end())
-                {
-                    found->second.insert(found->second.end(), item.second.begin(), item.second.end());
-                }
-                else
-                {
-                    counters[item.first] = item.second;
-                }
+                const CoordinatesList & item = counters_vec[i][descriptor];
+                counters[descriptor].insert(counters[descriptor].end(), item.begin(), item.end());
             }
         }
     }
 
     for (auto & item : counters)
     {
-        if (item.second.size() > params.maxCountSample)
+        if (item.size() > params.maxCountSample)
         {
             // Shuffle and ignore the exceeding samples
-            std::random_shuffle(item.second.begin(), item.second.end());
-            item.second.resize(params.maxCountSample);
+            std::random_shuffle(item.begin(), item.end());
+            item.resize(params.maxCountSample);
         }
 
-        for (std::size_t i = 0; i < item.second.size(); ++i)
+        for (std::size_t i = 0; i < item.size(); ++i)
         {
-            const Coordinates& coords = item.second[i];
+            const std::size_t pixel = item[i];
 
-            if (!samples(coords.second, coords.first).descriptions.empty())
+            if (firstValid[pixel] >= 0)
             {
-                out_samples.push_back(samples(coords.second, coords.first));
-                samples(coords.second, coords.first).descriptions.clear();
+                ImageSample sample;
+                sample.x = pixel % imageWidth;
+                sample.y = pixel / imageWidth;
+                if (!pixelCounts.empty())
+                {
+                    sample.count = pixelCounts[pixel];
+                }
+
+                for (int k = firstValid[pixel]; k <= lastValid[pixel]; ++k)
+                {
+                    PixelDescription pd;
+                    pd.exposure = times[k];
+                    pd.mean = means[k * nbPixels + pixel];
+                    pd.variance = variances[k * nbPixels + pixel];
+                    sample.descriptions.push_back(pd);
+                }
+
+                out_samples.push_back(sample);
+                firstValid[pixel] = -1;
             }
         }
     }
@@ -8,7 +8,10 @@
 
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/numeric/numeric.hpp>
+#include <cstdint>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace hdr {
@@ -33,15 +36,30 @@ struct ImageSample
 {
     size_t x = 0;
     size_t y = 0;
+    /// number of pixels with the same quantized values on the same brackets represented by this sample
+    std::uint32_t count = 1;
     std::vector<PixelDescription> descriptions;
 
     ImageSample() = default;
 };
 
-std::ostream & operator<<(std::ostream& os, const ImageSample & s);
-std::ostream & operator<<(std::ostream& os, const PixelDescription & p);
-std::istream & operator>>(std::istream& os, ImageSample & s);
-std::istream & operator>>(std::istream& os, PixelDescription & p);
+/**
+ * @brief Write samples to a binary file.
+ * The exposures are stored once in a table and the samples as flat arrays
+ * (32 bits coordinates and counts, one byte per exposure index) written in a few bulk writes.
+ * @param[in] path the output file path
+ * @param[in] samples the samples to write (at most 255 descriptions per sample and 255 distinct exposures)
+ * @return false if the file cannot be written
+ */
+bool writeSamples(const std::string& path, const std::vector<ImageSample>& samples);
+
+/**
+ * @brief Read samples from a binary file written by writeSamples.
+ * @param[out] samples the samples of the file
+ * @param[in] path the input file path
+ * @return false if the file cannot be read or is not a samples file
+ */
+bool readSamples(std::vector<ImageSample>& samples, const std::string& path);
 
 
 class Sampling
@@ -57,6 +75,9 @@ public:
         int blockSize = 256;
         int radius = 5;
         size_t maxCountSample = 200;
+        /// keep a single pixel among the pixels with the same quantized values on the same brackets,
+        /// with the number of pixels it represents as sample count
+        bool removeDuplicates = true;
     };
 
     using MapSampleRefList = std::map<UniqueDescriptor, std::vector<Coordinates>>;
@@ -0,0 +1,172 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/hdr/DebevecCalibrate.hpp>
+#include <aliceVision/hdr/sampling.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#define BOOST_TEST_MODULE hdrSampling
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+namespace fs = boost::filesystem;
+
+namespace {
+
+std::vector<hdr::ImageSample> generateSamples(std::size_t count)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> coordinateDistribution(0, 100000);
+    std::uniform_int_distribution<int> exposureDistribution(0, 11);
+    std::uniform_int_distribution<int> countDistribution(0, 12);
+    std::uniform_real_distribution<float> valueDistribution(0.0f, 1.0f);
+
+    std::vector<hdr::ImageSample> samples(count);
+    for(hdr::ImageSample& sample : samples)
+    {
+        sample.x = coordinateDistribution(generator);
+        sample.y = coordinateDistribution(generator);
+        sample.count = 1 + coordinateDistribution(generator);
+        sample.descriptions.resize(countDistribution(generator));
+        for(hdr::PixelDescription& description : sample.descriptions)
+        {
+            description.exposure = 0.05f * float(1 + exposureDistribution(generator));
+            for(int channel = 0; channel < 3; ++channel)
+            {
+                description.mean(channel) = valueDistribution(generator);
+                description.variance(channel) = valueDistribution(generator);
+            }
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(hdr_samplesRoundTrip)
+{
+    const std::vector<hdr::ImageSample> samples = generateSamples(1000);
+    const std::string path = (fs::temp_directory_path() / fs::unique_path("samples_%%%%%%.dat")).string();
+
+    BOOST_REQUIRE(hdr::writeSamples(path, samples));
+
+    std::vector<hdr::ImageSample> readSamples;
+    BOOST_REQUIRE(hdr::readSamples(readSamples, path));
+    BOOST_REQUIRE_EQUAL(readSamples.size(), samples.size());
+
+    for(std::size_t i = 0; i < samples.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(readSamples[i].x, samples[i].x);
+        BOOST_CHECK_EQUAL(readSamples[i].y, samples[i].y);
+        BOOST_CHECK_EQUAL(readSamples[i].count, samples[i].count);
+        BOOST_REQUIRE_EQUAL(readSamples[i].descriptions.size(), samples[i].descriptions.size());
+        for(std::size_t j = 0; j < samples[i].descriptions.size(); ++j)
+        {
+            const hdr::PixelDescription& expected = samples[i].descriptions[j];
+            const hdr::PixelDescription& description = readSamples[i].descriptions[j];
+            BOOST_CHECK_EQUAL(description.exposure, expected.exposure);
+            for(int channel = 0; channel < 3; ++channel)
+            {
+                BOOST_CHECK_EQUAL(description.mean(channel), expected.mean(channel));
+                BOOST_CHECK_EQUAL(description.variance(channel), expected.variance(channel));
+            }
+        }
+    }
+
+    // Empty list of samples
+    BOOST_REQUIRE(hdr::writeSamples(path, std::vector<hdr::ImageSample>()));
+    BOOST_CHECK(hdr::readSamples(readSamples, path));
+    BOOST_CHECK(readSamples.empty());
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(hdr_samplesInvalidFile)
+{
+    const std::vector<hdr::ImageSample> samples = generateSamples(100);
+    const std::string path = (fs::temp_directory_path() / fs::unique_path("samples_%%%%%%.dat")).string();
+    std::vector<hdr::ImageSample> readSamples;
+
+    BOOST_CHECK(!hdr::readSamples(readSamples, path));
+
+    BOOST_REQUIRE(hdr::writeSamples(path, samples));
+    const std::uintmax_t fileSize = fs::file_size(path);
+
+    // Truncated file
+    fs::resize_file(path, fileSize - 1);
+    BOOST_CHECK(!hdr::readSamples(readSamples, path));
+
+    // Truncated header
+    fs::resize_file(path, 10);
+    BOOST_CHECK(!hdr::readSamples(readSamples, path));
+
+    // Not a samples file
+    {
+        std::ofstream os(path, std::ios::binary);
+        os << "x y exposure mean variance\n";
+    }
+    BOOST_CHECK(!hdr::readSamples(readSamples, path));
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(hdr_debevecSampleCount)
+{
+    // Brackets of a linear camera, on a few distinct radiances
+    const std::vector<float> times = {0.25f, 1.0f, 4.0f};
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> radianceDistribution(0.01f, 1.0f);
+    std::uniform_int_distribution<int> countDistribution(1, 20);
+
+    std::vector<hdr::ImageSample> duplicatedSamples;
+    std::vector<hdr::ImageSample> countedSamples;
+    for(int i = 0; i < 200; ++i)
+    {
+        hdr::ImageSample sample;
+        const float radiance = radianceDistribution(generator);
+        for(const float time : times)
+        {
+            hdr::PixelDescription description;
+            description.exposure = time;
+            description.mean = image::Rgb<float>(std::min(1.0f, radiance * time));
+            description.variance = image::Rgb<float>(0.0f);
+            sample.descriptions.push_back(description);
+        }
+
+        // the same equations, repeated or weighted by the sample count
+        sample.count = countDistribution(generator);
+        countedSamples.push_back(sample);
+        const std::uint32_t count = sample.count;
+        sample.count = 1;
+        duplicatedSamples.insert(duplicatedSamples.end(), count, sample);
+    }
+
+    const std::size_t channelQuantization = 256;
+    hdr::rgbCurve weight(channelQuantization);
+    weight.setFunction(hdr::EFunctionType::GAUSSIAN);
+
+    hdr::DebevecCalibrate calibration;
+    hdr::rgbCurve duplicatedResponse(channelQuantization);
+    hdr::rgbCurve countedResponse(channelQuantization);
+    BOOST_REQUIRE(calibration.process({duplicatedSamples}, {times}, channelQuantization, weight, 50.0f, duplicatedResponse));
+    BOOST_REQUIRE(calibration.process({countedSamples}, {times}, channelQuantization, weight, 50.0f, countedResponse));
+
+    for(std::size_t channel = 0; channel < 3; ++channel)
+    {
+        for(std::size_t i = 0; i < channelQuantization; ++i)
+        {
+            const float expected = duplicatedResponse.getCurve(channel)[i];
+            BOOST_CHECK_SMALL(countedResponse.getCurve(channel)[i] - expected, 1e-4f * std::max(1.0f, std::abs(expected)));
+        }
+    }
+}
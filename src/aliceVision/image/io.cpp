@@ -242,16 +242,11 @@ void getBufferFromImage(Image<RGBColor>& image, oiio::ImageBuf& buffer)
   getBufferFromImage(image, oiio::TypeDesc::UINT8, 3, buffer);
 }
 
-template<typename T>
-void readImage(const std::string& path,
-               oiio::TypeDesc format,
-               int nchannels,
-               Image<T>& image,
-               const ImageReadOptions & imageReadOptions)
+/**
+ * @brief Reading configuration of the image plugins (libRAW)
+ */
+oiio::ImageSpec getReadConfigSpec(const ImageReadOptions & imageReadOptions)
 {
-  // check requested channels number
-  assert(nchannels == 1 || nchannels >= 3);
-
   oiio::ImageSpec configSpec;
 
   // libRAW configuration
@@ -267,6 +262,21 @@ void readImage(const std::string& path,
   configSpec.attribute("raw:ColorSpace", "Linear"); // use linear colorspace with sRGB primaries
 #endif
 
+  return configSpec;
+}
+
+template<typename T>
+void readImage(const std::string& path,
+               oiio::TypeDesc format,
+               int nchannels,
+               Image<T>& image,
+               const ImageReadOptions & imageReadOptions)
+{
+  // check requested channels number
+  assert(nchannels == 1 || nchannels >= 3);
+
+  oiio::ImageSpec configSpec = getReadConfigSpec(imageReadOptions);
+
   oiio::ImageBuf inBuf(path, 0, 0, NULL, &configSpec);
 
   inBuf.read(0, 0, true, oiio::TypeDesc::FLOAT); // force image convertion to float (for grayscale and color space convertion)
@@ -623,5 +633,251 @@ void writeImage(const std::string& path, const Image<RGBColor>& image, EImageCol
   writeImage(path, oiio::TypeDesc::UINT8, 3, image, imageColorSpace, metadata);
 }
 
+ImageRowsReader::ImageRowsReader(const std::string& path, const ImageReadOptions& imageReadOptions)
+  : _path(path)
+  , _imageReadOptions(imageReadOptions)
+{
+  const oiio::ImageSpec configSpec = getReadConfigSpec(imageReadOptions);
+
+  _input = std::unique_ptr<oiio::ImageInput>(oiio::ImageInput::open(path, &configSpec));
+
+  if(!_input)
+    throw std::runtime_error("Cannot find/open image file '" + path + "'.");
+
+  // check picture channels number
+  if(_input->spec().nchannels != 1 && _input->spec().nchannels < 3)
+    throw std::runtime_error("Can't load channels of image file '" + path + "'.");
+
+  if(imageReadOptions.outputColorSpace == EImageColorSpace::AUTO)
+    throw std::runtime_error("You must specify a requested color space for image file '" + path + "'.");
+
+  _colorSpace = _input->spec().get_string_attribute("oiio:ColorSpace", "sRGB"); // default image color space is sRGB
+  ALICEVISION_LOG_TRACE("Read image " << path << " by rows (encoded in " << _colorSpace << " colorspace).");
+}
+
+ImageRowsReader::~ImageRowsReader()
+{
+  if(_input)
+    _input->close();
+}
+
+int ImageRowsReader::getWidth() const
+{
+  return _input->spec().width;
+}
+
+int ImageRowsReader::getHeight() const
+{
+  return _input->spec().height;
+}
+
+void ImageRowsReader::readRows(int yBegin, int yEnd, Image<RGBfColor>& image, int imageRow)
+{
+  const oiio::ImageSpec& spec = _input->spec();
+
+  assert(image.Width() == spec.width);
+  assert(imageRow + yEnd - yBegin <= image.Height());
+
+  if(yEnd <= yBegin)
+    return;
+
+  float* data = image(imageRow, 0).data();
+  const int nchannels = std::min(spec.nchannels, 3);
+
+  // read the first channels (converted to float) directly in the output buffer
+  if(!_input->read_scanlines(0, 0, spec.y + yBegin, spec.y + yEnd, 0, 0, nchannels, oiio::TypeDesc::FLOAT, data,
+                             sizeof(RGBfColor), sizeof(RGBfColor) * spec.width))
+    throw std::runtime_error("Can't read rows of image file '" + _path + "': " + _input->geterror());
+
+  // duplicate first channel for RGB
+  if(nchannels == 1)
+  {
+    for(int i = imageRow; i < imageRow + yEnd - yBegin; ++i)
+    {
+      for(int j = 0; j < spec.width; ++j)
+      {
+        RGBfColor& pixel = image(i, j);
+        pixel.g() = pixel.r();
+        pixel.b() = pixel.r();
+      }
+    }
+  }
+
+  // color conversion of the rows
+  std::string outputColorSpace;
+  if(_imageReadOptions.outputColorSpace == EImageColorSpace::SRGB && _colorSpace != "sRGB")
+    outputColorSpace = "sRGB";
+  else if(_imageReadOptions.outputColorSpace == EImageColorSpace::LINEAR && _colorSpace != "Linear")
+    outputColorSpace = "Linear";
+
+  if(!outputColorSpace.empty())
+  {
+    oiio::ImageSpec rowsSpec(spec.width, yEnd - yBegin, 3, oiio::TypeDesc::FLOAT);
+    oiio::ImageBuf rowsBuf(rowsSpec, data);
+    oiio::ImageBufAlgo::colorconvert(rowsBuf, rowsBuf, _colorSpace, outputColorSpace);
+  }
+}
+
+ImageRowsWriter::ImageRowsWriter(const std::string& path, int width, int height, EImageColorSpace imageColorSpace,
+                                 const oiio::ParamValueList& metadata)
+  : _path(path)
+  , _width(width)
+  , _height(height)
+  , _imageColorSpace(imageColorSpace)
+  , _storageDataType(EStorageDataType::Float)
+  , _metadata(metadata)
+{
+  const fs::path bPath = fs::path(path);
+  const std::string extension = boost::to_lower_copy(bPath.extension().string());
+  const bool isEXR = (extension == ".exr");
+  const bool isJPG = (extension == ".jpg");
+  const bool isPNG = (extension == ".png");
+
+  _tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
+
+  if(_imageColorSpace == EImageColorSpace::AUTO)
+  {
+    if(isJPG || isPNG)
+      _imageColorSpace = EImageColorSpace::SRGB;
+    else
+      _imageColorSpace = EImageColorSpace::LINEAR;
+  }
+
+  oiio::TypeDesc typeDesc = oiio::TypeDesc::FLOAT;
+  if(isEXR)
+  {
+    oiio::ImageSpec metadataSpec;
+    metadataSpec.extra_attribs = metadata;
+    _storageDataType = EStorageDataType_stringToEnum(metadataSpec.get_string_attribute("AliceVision:storageDataType", EStorageDataType_enumToString(EStorageDataType::HalfFinite)));
+
+    // with the Auto storage data type, the rows are written in float
+    // and converted to half by close() if none of them overflows
+    if(_storageDataType == EStorageDataType::Half || _storageDataType == EStorageDataType::HalfFinite)
+      typeDesc = oiio::TypeDesc::HALF;
+  }
+
+  _output = openOutput(_tmpPath, typeDesc);
+}
+
+std::unique_ptr<oiio::ImageOutput> ImageRowsWriter::openOutput(const std::string& path, oiio::TypeDesc typeDesc) const
+{
+  const bool isEXR = (boost::to_lower_copy(fs::path(_path).extension().string()) == ".exr");
+
+  oiio::ImageSpec imageSpec(_width, _height, 3, typeDesc);
+  imageSpec.extra_attribs = _metadata; // add custom metadata
+
+  imageSpec.attribute("jpeg:subsampling", "4:4:4");           // if possible, always subsampling 4:4:4 for jpeg
+  imageSpec.attribute("CompressionQuality", 100);             // if possible, best compression quality
+  imageSpec.attribute("compression", isEXR ? "piz" : "none"); // if possible, set compression (piz for EXR, none for the other)
+
+  std::unique_ptr<oiio::ImageOutput> output(oiio::ImageOutput::create(path));
+  if(!output || !output->open(path, imageSpec))
+    throw std::runtime_error("Can't write output image file '" + _path + "'.");
+  return output;
+}
+
+ImageRowsWriter::~ImageRowsWriter()
+{
+  // not closed: remove the incomplete temporary file
+  if(_output)
+  {
+    _output->close();
+    fs::remove(_tmpPath);
+  }
+}
+
+void ImageRowsWriter::writeRows(int yBegin, const Image<RGBfColor>& rows)
+{
+  assert(rows.Width() == _width);
+  assert(yBegin + rows.Height() <= _height);
+
+  const oiio::ImageSpec rowsSpec(_width, rows.Height(), 3, oiio::TypeDesc::FLOAT);
+  const oiio::ImageBuf rowsBuf(rowsSpec, const_cast<RGBfColor*>(rows.data()));
+  const oiio::ImageBuf* outBuf = &rowsBuf;
+
+  oiio::ImageBuf colorspaceBuf; // buffer for image colorspace modification
+  if(_imageColorSpace == EImageColorSpace::SRGB)
+  {
+    oiio::ImageBufAlgo::colorconvert(colorspaceBuf, *outBuf, "Linear", "sRGB");
+    outBuf = &colorspaceBuf;
+  }
+
+  if(_storageDataType == EStorageDataType::HalfFinite)
+  {
+    oiio::ImageBufAlgo::clamp(colorspaceBuf, *outBuf, -HALF_MAX, HALF_MAX);
+    outBuf = &colorspaceBuf;
+  }
+  else if(_storageDataType == EStorageDataType::Auto && !_halfOverflow)
+  {
+    _halfOverflow = containsHalfFloatOverflow(*outBuf);
+  }
+
+  // the rows are converted to the file format by the output
+  if(!_output->write_scanlines(yBegin, yBegin + rows.Height(), 0, oiio::TypeDesc::FLOAT, outBuf->localpixels()))
+    throw std::runtime_error("Can't write output image file '" + _path + "': " + _output->geterror());
+}
+
+void ImageRowsWriter::close()
+{
+  if(!_output->close())
+    throw std::runtime_error("Can't write output image file '" + _path + "': " + _output->geterror());
+  _output.reset();
+
+  if(_storageDataType == EStorageDataType::Auto && !_halfOverflow)
+  {
+    ALICEVISION_LOG_DEBUG("ImageRowsWriter storageDataType: " << EStorageDataType::Half);
+    try
+    {
+      convertToHalf();
+    }
+    catch(...)
+    {
+      fs::remove(_tmpPath);
+      throw;
+    }
+  }
+
+  // rename temporay filename
+  fs::rename(_tmpPath, _path);
+}
+
+void ImageRowsWriter::convertToHalf()
+{
+  const fs::path bPath = fs::path(_path);
+  const std::string halfPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+  std::unique_ptr<oiio::ImageInput> input(oiio::ImageInput::open(_tmpPath));
+  if(!input)
+    throw std::runtime_error("Can't read back output image file '" + _path + "'.");
+
+  // the float rows are copied by bands: the whole image is never in memory
+  const int rowsPerBand = 256;
+  std::vector<float> band(std::size_t(rowsPerBand) * _width * 3);
+  {
+    std::unique_ptr<oiio::ImageOutput> output = openOutput(halfPath, oiio::TypeDesc::HALF);
+    for(int yBegin = 0; yBegin < _height; yBegin += rowsPerBand)
+    {
+      const int yEnd = std::min(_height, yBegin + rowsPerBand);
+      if(!input->read_scanlines(0, 0, yBegin, yEnd, 0, 0, 3, oiio::TypeDesc::FLOAT, band.data()) ||
+         !output->write_scanlines(yBegin, yEnd, 0, oiio::TypeDesc::FLOAT, band.data()))
+      {
+        output->close();
+        fs::remove(halfPath);
+        throw std::runtime_error("Can't write output image file '" + _path + "'.");
+      }
+    }
+    input->close();
+
+    if(!output->close())
+    {
+      fs::remove(halfPath);
+      throw std::runtime_error("Can't write output image file '" + _path + "': " + output->geterror());
+    }
+  }
+
+  fs::remove(_tmpPath);
+  fs::rename(halfPath, _tmpPath);
+}
+
 }  // namespace image
 }  // namespace aliceVision
@@ -14,6 +14,7 @@
 #include <OpenImageIO/paramlist.h>
 #include <OpenImageIO/imagebuf.h>
 
+#include <memory>
 #include <string>
 
 namespace oiio = OIIO;
@@ -210,6 +211,88 @@ void writeImage(const std::string& path, const Image<RGBAColor>& image, EImageCo
 void writeImage(const std::string& path, const Image<RGBfColor>& image, EImageColorSpace imageColorSpace,const oiio::ParamValueList& metadata = oiio::ParamValueList(),const oiio::ROI& roi = oiio::ROI());
 void writeImage(const std::string& path, const Image<RGBColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 
+/**
+ * @brief Read an RGB image by bands of rows, with the same options and color conversions as readImage.
+ * Only the requested rows are decoded and kept in memory.
+ * The rows should be read in increasing order: some formats can only be decoded sequentially.
+ */
+class ImageRowsReader
+{
+public:
+  /**
+   * @brief Open the image file and read its header
+   * @param[in] path The given path to the image
+   * @param[in] imageReadOptions The color space and white balance options
+   */
+  ImageRowsReader(const std::string& path, const ImageReadOptions& imageReadOptions);
+  ~ImageRowsReader();
+
+  int getWidth() const;
+  int getHeight() const;
+
+  /**
+   * @brief Read the rows [yBegin, yEnd) of the image
+   * @param[in] yBegin The first row to read
+   * @param[in] yEnd The row after the last row to read
+   * @param[out] image The output image buffer, with the same width as the image
+   * @param[in] imageRow The row of the output image buffer receiving the first read row
+   */
+  void readRows(int yBegin, int yEnd, Image<RGBfColor>& image, int imageRow = 0);
+
+private:
+  std::string _path;
+  ImageReadOptions _imageReadOptions;
+  std::string _colorSpace;
+  std::unique_ptr<oiio::ImageInput> _input;
+};
+
+/**
+ * @brief Write an RGB image by bands of rows, with the same options and storage data types as writeImage.
+ * The rows must be written in increasing order. The image is written in a temporary file,
+ * renamed to the given path by close().
+ * With the Auto storage data type, the rows are written in float and close() converts the file
+ * to half by bands of rows if none of the values overflows the half float range.
+ */
+class ImageRowsWriter
+{
+public:
+  /**
+   * @param[in] path The given path to the image
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @param[in] imageColorSpace The output color space (the rows are given in linear)
+   * @param[in] metadata The image metadata, including the AliceVision:storageDataType
+   */
+  ImageRowsWriter(const std::string& path, int width, int height, EImageColorSpace imageColorSpace,
+                  const oiio::ParamValueList& metadata = oiio::ParamValueList());
+  ~ImageRowsWriter();
+
+  /**
+   * @brief Write all the rows of the given band, starting at the row yBegin of the image
+   */
+  void writeRows(int yBegin, const Image<RGBfColor>& rows);
+
+  /**
+   * @brief Finish the image file and move it to its final path
+   */
+  void close();
+
+private:
+  std::unique_ptr<oiio::ImageOutput> openOutput(const std::string& path, oiio::TypeDesc typeDesc) const;
+  void convertToHalf();
+
+  std::string _path;
+  std::string _tmpPath;
+  int _width;
+  int _height;
+  EImageColorSpace _imageColorSpace;
+  EStorageDataType _storageDataType;
+  oiio::ParamValueList _metadata;
+  std::unique_ptr<oiio::ImageOutput> _output;
+  /// with the Auto storage data type, true if a written value overflows the half float range
+  bool _halfOverflow = false;
+};
+
 
 template <typename T>
 struct ColorTypeInfo
@@ -13,6 +13,9 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 
+#include <OpenEXR/half.h>
+
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <vector>
@@ -258,3 +261,73 @@ BOOST_AUTO_TEST_CASE(read_write_from_grayscale_to_rgb) {
     remove(filename.c_str());
   }
 }
+
+BOOST_AUTO_TEST_CASE(read_write_rows) {
+  const int width = 37;
+  const int height = 23;
+  const int rowsPerBand = 5;
+
+  Image<RGBfColor> image(width, height);
+  for(int i = 0; i < height; ++i)
+    for(int j = 0; j < width; ++j)
+      image(i, j) = RGBfColor(0.01f * j, 0.1f * i, 0.5f);
+  // out of the half float range: kept in float by the auto storage data type
+  const float overflowValue = 1.0e6f;
+
+  for(const bool overflow : {false, true})
+  {
+    if(overflow)
+      image(height - 1, width - 1).r() = overflowValue;
+
+    for(const EStorageDataType storageDataType : {EStorageDataType::Float, EStorageDataType::HalfFinite, EStorageDataType::Auto})
+    {
+      const std::string filename = "test_write_rows.exr";
+
+      oiio::ParamValueList metadata;
+      metadata.push_back(oiio::ParamValue("AliceVision:storageDataType", EStorageDataType_enumToString(storageDataType)));
+
+      // write and read the rows by bands, the last band is incomplete
+      {
+        ImageRowsWriter writer(filename, width, height, EImageColorSpace::LINEAR, metadata);
+        for(int yBegin = 0; yBegin < height; yBegin += rowsPerBand)
+        {
+          const int yEnd = std::min(height, yBegin + rowsPerBand);
+          writer.writeRows(yBegin, Image<RGBfColor>(image.block(yBegin, 0, yEnd - yBegin, width)));
+        }
+        writer.close();
+      }
+
+      ImageReadOptions options;
+      options.outputColorSpace = EImageColorSpace::LINEAR;
+      ImageRowsReader reader(filename, options);
+      BOOST_REQUIRE_EQUAL(reader.getWidth(), width);
+      BOOST_REQUIRE_EQUAL(reader.getHeight(), height);
+
+      Image<RGBfColor> readImage(width, height);
+      for(int yBegin = 0; yBegin < height; yBegin += rowsPerBand)
+        reader.readRows(yBegin, std::min(height, yBegin + rowsPerBand), readImage, yBegin);
+
+      const bool isHalf = (storageDataType == EStorageDataType::HalfFinite) ||
+                          (storageDataType == EStorageDataType::Auto && !overflow);
+
+      for(int i = 0; i < height; ++i)
+      {
+        for(int j = 0; j < width; ++j)
+        {
+          for(int c = 0; c < 3; ++c)
+          {
+            float expected = image(i, j)(c);
+            if(storageDataType == EStorageDataType::HalfFinite)
+              expected = std::min(expected, HALF_MAX);
+
+            if(isHalf)
+              BOOST_CHECK_SMALL(readImage(i, j)(c) - expected, 1e-3f * std::max(1.0f, expected));
+            else
+              BOOST_CHECK_EQUAL(readImage(i, j)(c), expected);
+          }
+        }
+      }
+      remove(filename.c_str());
+    }
+  }
+}
@@ -7,9 +7,164 @@
 
 #include "guidedMatching.hpp"
 
+#include <algorithm>
+#include <limits>
+
 namespace aliceVision {
 namespace matching {
 
+PointsGrid::PointsGrid(const std::vector<Vec2>& points, double searchRadius)
+{
+  // maximum number of cells per dimension
+  const int maxNbCellsPerDim = 512;
+
+  Vec2 pointsMin = Vec2::Constant(std::numeric_limits<double>::max());
+  Vec2 pointsMax = Vec2::Constant(std::numeric_limits<double>::lowest());
+  std::size_t nbPoints = 0;
+
+  for(const Vec2& point : points)
+  {
+    if(!point.allFinite())
+      continue;
+    pointsMin = pointsMin.cwiseMin(point);
+    pointsMax = pointsMax.cwiseMax(point);
+    ++nbPoints;
+  }
+
+  if(nbPoints > 0)
+  {
+    const Vec2 extent = pointsMax - pointsMin;
+
+    // cells at least as large as the queries, with a fraction of point on average
+    // (small cells keep the epipolar bands queries tight)
+    _cellSize = std::max(2.0 * searchRadius, 0.5 * std::sqrt(extent(0) * extent(1) / nbPoints));
+    _cellSize = std::max(_cellSize, extent.maxCoeff() / maxNbCellsPerDim);
+
+    if(!std::isfinite(_cellSize) || _cellSize <= 0.0)
+      _cellSize = 1.0;
+
+    _origin = pointsMin;
+    _nbCols = std::min(maxNbCellsPerDim, static_cast<int>(extent(0) / _cellSize) + 1);
+    _nbRows = std::min(maxNbCellsPerDim, static_cast<int>(extent(1) / _cellSize) + 1);
+  }
+
+  const auto getCell = [&](const Vec2& point)
+  {
+    const int col = std::min(_nbCols - 1, static_cast<int>((point(0) - _origin(0)) / _cellSize));
+    const int row = std::min(_nbRows - 1, static_cast<int>((point(1) - _origin(1)) / _cellSize));
+    return row * _nbCols + col;
+  };
+
+  // counting sort of the points by cell (stable: increasing indexes in each cell)
+  _cellsBegin.assign(_nbCols * _nbRows + 1, 0);
+
+  for(const Vec2& point : points)
+  {
+    if(point.allFinite())
+      ++_cellsBegin[getCell(point) + 1];
+  }
+
+  for(std::size_t c = 1; c < _cellsBegin.size(); ++c)
+    _cellsBegin[c] += _cellsBegin[c - 1];
+
+  _indexes.resize(nbPoints);
+  std::vector<std::size_t> cellsEnd(_cellsBegin.begin(), _cellsBegin.end() - 1);
+
+  for(std::size_t i = 0; i < points.size(); ++i)
+  {
+    if(points[i].allFinite())
+      _indexes[cellsEnd[getCell(points[i])]++] = static_cast<IndexT>(i);
+  }
+}
+
+void PointsGrid::appendColumnCells(int col, double rowBegin, double rowEnd, std::vector<IndexT>& out_indexes) const
+{
+  if(col < 0 || col >= _nbCols || rowEnd < 0.0 || rowBegin >= _nbRows || !(rowBegin <= rowEnd))
+    return;
+
+  const int rowFirst = static_cast<int>(std::max(0.0, rowBegin));
+  const int rowLast = static_cast<int>(std::min(_nbRows - 1.0, rowEnd));
+
+  for(int row = rowFirst; row <= rowLast; ++row)
+  {
+    const int cell = row * _nbCols + col;
+    out_indexes.insert(out_indexes.end(), _indexes.begin() + _cellsBegin[cell], _indexes.begin() + _cellsBegin[cell + 1]);
+  }
+}
+
+void PointsGrid::appendRowCells(int row, double colBegin, double colEnd, std::vector<IndexT>& out_indexes) const
+{
+  if(row < 0 || row >= _nbRows || colEnd < 0.0 || colBegin >= _nbCols || !(colBegin <= colEnd))
+    return;
+
+  const int colFirst = static_cast<int>(std::max(0.0, colBegin));
+  const int colLast = static_cast<int>(std::min(_nbCols - 1.0, colEnd));
+
+  // the cells of a row are contiguous
+  out_indexes.insert(out_indexes.end(),
+                     _indexes.begin() + _cellsBegin[row * _nbCols + colFirst],
+                     _indexes.begin() + _cellsBegin[row * _nbCols + colLast + 1]);
+}
+
+void PointsGrid::getPointsInDisc(const Vec2& center, double radius, std::vector<IndexT>& out_indexes) const
+{
+  out_indexes.clear();
+
+  // disc bounding box in cells coordinates (with a margin for the rounding errors)
+  const double margin = radius * (1.0 + 1e-6) + 1e-6 * _cellSize;
+  const Vec2 cellMin = (center - _origin - Vec2::Constant(margin)) / _cellSize;
+  const Vec2 cellMax = (center - _origin + Vec2::Constant(margin)) / _cellSize;
+
+  if(cellMax(0) < 0.0 || cellMin(0) >= _nbCols)
+    return;
+
+  const int rowFirst = static_cast<int>(std::floor(std::max(0.0, cellMin(1))));
+  const int rowLast = static_cast<int>(std::floor(std::min(_nbRows - 1.0, cellMax(1))));
+
+  for(int row = rowFirst; row <= rowLast; ++row)
+    appendRowCells(row, std::floor(cellMin(0)), std::floor(cellMax(0)), out_indexes);
+
+  std::sort(out_indexes.begin(), out_indexes.end());
+}
+
+void PointsGrid::getPointsNearLine(const Vec3& line, double distance, std::vector<IndexT>& out_indexes) const
+{
+  out_indexes.clear();
+
+  const double a = line(0);
+  const double b = line(1);
+  // line equation in cells coordinates: a.u + b.v + c = 0
+  const double c = (line(2) + a * _origin(0) + b * _origin(1)) / _cellSize;
+  // band half-width in cells coordinates (with a margin for the rounding errors)
+  const double halfWidth = distance / _cellSize * (1.0 + 1e-6) + 1e-6;
+  const double norm = std::hypot(a, b);
+
+  if(std::abs(b) >= std::abs(a))
+  {
+    // mostly horizontal line: walk along the columns
+    const double rowMargin = halfWidth * norm / std::abs(b);
+    for(int col = 0; col < _nbCols; ++col)
+    {
+      const double v0 = -(a * col + c) / b;
+      const double v1 = -(a * (col + 1) + c) / b;
+      appendColumnCells(col, std::floor(std::min(v0, v1) - rowMargin), std::floor(std::max(v0, v1) + rowMargin), out_indexes);
+    }
+  }
+  else
+  {
+    // mostly vertical line: walk along the rows
+    const double colMargin = halfWidth * norm / std::abs(a);
+    for(int row = 0; row < _nbRows; ++row)
+    {
+      const double u0 = -(b * row + c) / a;
+      const double u1 = -(b * (row + 1) + c) / a;
+      appendRowCells(row, std::floor(std::min(u0, u1) - colMargin), std::floor(std::max(u0, u1) + colMargin), out_indexes);
+    }
+  }
+
+  std::sort(out_indexes.begin(), out_indexes.end());
+}
+
 unsigned int pix_to_bucket(const Vec2i& x, int W, int H)
 {
     if(x(1) == 0)
@@ -12,12 +12,139 @@
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/feature/Regions.hpp>
 #include <aliceVision/camera/IntrinsicBase.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
+#include <cmath>
 #include <vector>
 
 namespace aliceVision {
+
+namespace multiview {
+namespace relativePose {
+struct HomographyAsymmetricError;
+struct FundamentalEpipolarDistanceError;
+} // namespace relativePose
+} // namespace multiview
+
 namespace matching {
 
+/**
+ * @brief Regular grid of 2D points used to retrieve the points of a given area
+ *        without testing all of them.
+ *        The points indexes of each cell are stored contiguously (CSR layout).
+ */
+class PointsGrid
+{
+public:
+
+  /**
+   * @brief PointsGrid constructor
+   * @param[in] points The 2D points
+   * @param[in] searchRadius The expected radius of the queries (the cells are at least twice larger)
+   */
+  PointsGrid(const std::vector<Vec2>& points, double searchRadius);
+
+  /**
+   * @brief Get the points that may be in a disc
+   * @param[in] center The disc center
+   * @param[in] radius The disc radius
+   * @param[out] out_indexes The points indexes in increasing order (superset of the points in the disc)
+   */
+  void getPointsInDisc(const Vec2& center, double radius, std::vector<IndexT>& out_indexes) const;
+
+  /**
+   * @brief Get the points that may be close to a line
+   * @param[in] line The line (a, b, c) of equation: a.x + b.y + c = 0
+   * @param[in] distance The maximum distance to the line
+   * @param[out] out_indexes The points indexes in increasing order (superset of the points close to the line)
+   */
+  void getPointsNearLine(const Vec3& line, double distance, std::vector<IndexT>& out_indexes) const;
+
+private:
+
+  /// append the points of the cells [col, rowBegin..rowEnd] (clamped to the grid)
+  void appendColumnCells(int col, double rowBegin, double rowEnd, std::vector<IndexT>& out_indexes) const;
+  /// append the points of the cells [colBegin..colEnd, row] (clamped to the grid)
+  void appendRowCells(int row, double colBegin, double colEnd, std::vector<IndexT>& out_indexes) const;
+
+  /// grid origin
+  Vec2 _origin = Vec2::Zero();
+  /// cells size
+  double _cellSize = 1.0;
+  /// number of cells columns
+  int _nbCols = 1;
+  /// number of cells rows
+  int _nbRows = 1;
+  /// first point of each cell in _indexes (size: _nbCols * _nbRows + 1)
+  std::vector<std::size_t> _cellsBegin;
+  /// points indexes sorted by cell
+  std::vector<IndexT> _indexes;
+};
+
+/**
+ * @brief Spatial search of the guided matching candidates for a given error metric.
+ *        By default there is no spatial search and all the right points are candidates.
+ *
+ * @tparam ModelT The used model type
+ * @tparam ErrorT The metric to compute distance to the model
+ */
+template<typename ModelT, typename ErrorT>
+struct GuidedMatchingSearch
+{
+  /// true if the candidates can be retrieved from a PointsGrid
+  static const bool isSpatial = false;
+
+  /**
+   * @brief Get the right points that may be under the error threshold for a left point
+   * @return false if the spatial search is not possible (all the right points are candidates)
+   */
+  static bool getCandidates(const ModelT& mod, const Vec2& xLeft, double errorTh, const PointsGrid& grid, std::vector<IndexT>& out_candidates)
+  {
+    return false;
+  }
+};
+
+/**
+ * @brief Homography transfer error: the candidates are around the transferred left point.
+ */
+template<typename ModelT>
+struct GuidedMatchingSearch<ModelT, multiview::relativePose::HomographyAsymmetricError>
+{
+  static const bool isSpatial = true;
+
+  static bool getCandidates(const ModelT& mod, const Vec2& xLeft, double errorTh, const PointsGrid& grid, std::vector<IndexT>& out_candidates)
+  {
+    const Vec3 x = mod.getMatrix() * Vec3(xLeft(0), xLeft(1), 1.0);
+    const Vec2 center = x.head<2>() / x(2);
+
+    if(!std::isfinite(center(0)) || !std::isfinite(center(1)))
+      return false;
+
+    grid.getPointsInDisc(center, std::sqrt(errorTh), out_candidates);
+    return true;
+  }
+};
+
+/**
+ * @brief Epipolar distance error: the candidates are along the epipolar line of the left point.
+ */
+template<typename ModelT>
+struct GuidedMatchingSearch<ModelT, multiview::relativePose::FundamentalEpipolarDistanceError>
+{
+  static const bool isSpatial = true;
+
+  static bool getCandidates(const ModelT& mod, const Vec2& xLeft, double errorTh, const PointsGrid& grid, std::vector<IndexT>& out_candidates)
+  {
+    const Vec3 line = mod.getMatrix() * Vec3(xLeft(0), xLeft(1), 1.0);
+
+    if(!line.allFinite() || line.head<2>().squaredNorm() == 0.0)
+      return false;
+
+    grid.getPointsNearLine(line, std::sqrt(errorTh), out_candidates);
+    return true;
+  }
+};
+
 /**
  * @brief Guided Matching (features only):
  *        Use a model to find valid correspondences:
@@ -38,31 +165,67 @@ void guidedMatching(const ModelT& mod, const Mat& xLeft, const Mat& xRight, doub
 {
   assert(xLeft.rows() == xRight.rows());
 
+  using Search = GuidedMatchingSearch<ModelT, ErrorT>;
   const ErrorT errorEstimator = ErrorT();
+  const bool useGrid = Search::isSpatial && std::isfinite(errorTh) && xLeft.rows() == 2;
 
-  // looking for the corresponding points that have
-  // the smallest distance (smaller than the provided Threshold)
-  for(Mat::Index i = 0; i < xLeft.cols(); ++i)
+  std::vector<Vec2> rightPoints;
+  if(useGrid)
   {
-    double min = std::numeric_limits<double>::max();
-    matching::IndMatch match;
+    rightPoints.resize(xRight.cols());
     for(Mat::Index j = 0; j < xRight.cols(); ++j)
+      rightPoints[j] = xRight.col(j);
+  }
+  const PointsGrid grid(rightPoints, useGrid ? std::sqrt(errorTh) : 0.0);
+
+  // best corresponding index of each left point
+  std::vector<IndexT> bestMatches(xLeft.cols(), UndefinedIndexT);
+
+  #pragma omp parallel
+  {
+    std::vector<IndexT> candidates;
+
+    // looking for the corresponding points that have
+    // the smallest distance (smaller than the provided Threshold)
+    #pragma omp for schedule(dynamic, 64)
+    for(Mat::Index i = 0; i < xLeft.cols(); ++i)
     {
-      // compute the geometric error: error to the model
-      const double err = errorEstimator.error(mod, xLeft.col(i), xRight.col(j));
+      double min = std::numeric_limits<double>::max();
+      IndexT match = UndefinedIndexT;
+
+      const auto testCandidate = [&](Mat::Index j)
+      {
+        // compute the geometric error: error to the model
+        const double err = errorEstimator.error(mod, xLeft.col(i), xRight.col(j));
+
+        // if smaller error update corresponding index
+        if(err < errorTh && err < min)
+        {
+          min = err;
+          match = j;
+        }
+      };
 
-      // if smaller error update corresponding index
-      if(err < errorTh && err < min)
+      if(useGrid && Search::getCandidates(mod, xLeft.col(i), errorTh, grid, candidates))
       {
-        min = err;
-        match = matching::IndMatch(i, j);
+        for(const IndexT j : candidates)
+          testCandidate(j);
       }
+      else
+      {
+        for(Mat::Index j = 0; j < xRight.cols(); ++j)
+          testCandidate(j);
+      }
+
+      bestMatches[i] = match;
     }
-    if(min < errorTh)
-    {
-      // save the best corresponding index
-      out_validMatches.push_back(match);
-    }
+  }
+
+  for(std::size_t i = 0; i < bestMatches.size(); ++i)
+  {
+    // save the best corresponding index
+    if(bestMatches[i] != UndefinedIndexT)
+      out_validMatches.emplace_back(i, bestMatches[i]);
   }
 
   // remove duplicates (when multiple points at same position exist)
@@ -251,26 +414,58 @@ void guidedMatching(const ModelT& mod,
       rRegionsPos[i] = rRegions.GetRegionPosition(i);
   }
 
-  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+  using Search = GuidedMatchingSearch<ModelT, ErrorT>;
+  const bool useGrid = Search::isSpatial && std::isfinite(errorTh);
+  const std::vector<Vec2> noPoints;
+  const PointsGrid grid(useGrid ? rRegionsPos : noPoints, useGrid ? std::sqrt(errorTh) : 0.0);
+
+  // best corresponding index of each left point
+  std::vector<IndexT> bestMatches(lRegions.RegionCount(), UndefinedIndexT);
+
+  #pragma omp parallel
   {
-    distanceRatio<double> dR;
-    for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    std::vector<IndexT> candidates;
+    std::vector<IndexT> geometricCandidates;
+    std::vector<double> descDistances;
+
+    #pragma omp for schedule(dynamic, 64)
+    for(int i = 0; i < static_cast<int>(lRegions.RegionCount()); ++i)
     {
-      // compute the geometric error: error to the model
-      const double geomErr = errorEstimator.error(mod, lRegionsPos[i], rRegionsPos[j]);
+      // right points that may satisfy the model (spatial search or all the points)
+      const bool hasCandidates = useGrid && Search::getCandidates(mod, lRegionsPos[i], errorTh, grid, candidates);
+      const std::size_t nbCandidates = hasCandidates ? candidates.size() : rRegions.RegionCount();
 
-      if(geomErr < errorTh)
+      // compute the geometric error: error to the model
+      geometricCandidates.clear();
+      for(std::size_t k = 0; k < nbCandidates; ++k)
       {
-        // update the corresponding points & distance (if required)
-        dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+        const IndexT j = hasCandidates ? candidates[k] : static_cast<IndexT>(k);
+        if(errorEstimator.error(mod, lRegionsPos[i], rRegionsPos[j]) < errorTh)
+          geometricCandidates.push_back(j);
       }
+
+      if(geometricCandidates.empty())
+        continue;
+
+      // compute the descriptors distances of the valid geometric correspondences in one batch
+      lRegions.SquaredDescriptorDistances(i, &rRegions, geometricCandidates, descDistances);
+
+      // update the corresponding points & distance (if required)
+      distanceRatio<double> dR;
+      for(std::size_t k = 0; k < geometricCandidates.size(); ++k)
+        dR.update(geometricCandidates[k], descDistances[k]);
+
+      // add correspondence only iff the distance ratio is valid
+      if(dR.isValid(distRatio))
+        bestMatches[i] = dR.idx;
     }
-    // add correspondence only iff the distance ratio is valid
-    if(dR.isValid(distRatio))
-    {
-      // save the best corresponding index
-      out_matches.emplace_back(i, dR.idx);
-    }
+  }
+
+  for(std::size_t i = 0; i < bestMatches.size(); ++i)
+  {
+    // save the best corresponding index
+    if(bestMatches[i] != UndefinedIndexT)
+      out_matches.emplace_back(i, bestMatches[i]);
   }
 
   // remove duplicates (when multiple points at same position exist)
@@ -0,0 +1,214 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matching/guidedMatching.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/multiview/relativePose/HomographyError.hpp>
+#include <aliceVision/multiview/relativePose/FundamentalError.hpp>
+#include <aliceVision/robustEstimation/ISolver.hpp>
+
+#include <algorithm>
+#include <random>
+
+#define BOOST_TEST_MODULE guidedMatching
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+
+/**
+ * @brief Reference exhaustive guided matching (all left x right points).
+ */
+template<typename ErrorT>
+void exhaustiveGuidedMatching(const robustEstimation::Mat3Model& mod,
+                              const feature::Regions& lRegions,
+                              const feature::Regions& rRegions,
+                              double errorTh,
+                              double distRatio,
+                              IndMatches& out_matches)
+{
+  const ErrorT errorEstimator = ErrorT();
+
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+  {
+    distanceRatio<double> dR;
+    for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    {
+      if(errorEstimator.error(mod, lRegions.GetRegionPosition(i), rRegions.GetRegionPosition(j)) < errorTh)
+        dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+    }
+    if(dR.isValid(distRatio))
+      out_matches.emplace_back(i, dR.idx);
+  }
+  IndMatch::getDeduplicated(out_matches);
+}
+
+/**
+ * @brief Random SIFT regions in a 1000x800 image.
+ */
+void randomRegions(std::mt19937& generator, std::size_t nbRegions, feature::SIFT_Regions& regions)
+{
+  std::uniform_real_distribution<float> distributionX(0.f, 1000.f);
+  std::uniform_real_distribution<float> distributionY(0.f, 800.f);
+  std::uniform_int_distribution<int> distributionDesc(0, 255);
+
+  regions.Features().clear();
+  regions.Descriptors().resize(nbRegions);
+  for(std::size_t i = 0; i < nbRegions; ++i)
+  {
+    regions.Features().emplace_back(distributionX(generator), distributionY(generator), 1.f, 0.f);
+    for(std::size_t d = 0; d < 128; ++d)
+      regions.Descriptors()[i][d] = static_cast<unsigned char>(distributionDesc(generator));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_PointsGrid)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> distribution(-100.0, 300.0);
+
+  std::vector<Vec2> points(2000);
+  for(Vec2& point : points)
+    point = Vec2(distribution(generator), 0.5 * distribution(generator));
+
+  const double radius = 5.0;
+  const PointsGrid grid(points, radius);
+  std::vector<IndexT> indexes;
+
+  for(int q = 0; q < 200; ++q)
+  {
+    // disc queries, partially outside of the points area
+    const Vec2 center(distribution(generator), distribution(generator));
+    grid.getPointsInDisc(center, radius, indexes);
+    BOOST_CHECK(std::is_sorted(indexes.begin(), indexes.end()));
+
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+      if((points[i] - center).norm() < radius)
+        BOOST_CHECK(std::binary_search(indexes.begin(), indexes.end(), i));
+    }
+
+    // line queries with all orientations
+    const double angle = q * M_PI / 100.0;
+    const Vec3 line(std::cos(angle), std::sin(angle), -(std::cos(angle) * center(0) + std::sin(angle) * center(1)));
+    grid.getPointsNearLine(3.0 * line, radius, indexes);
+    BOOST_CHECK(std::is_sorted(indexes.begin(), indexes.end()));
+    BOOST_CHECK_LT(indexes.size(), points.size() / 2);
+
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+      if(std::abs(line.dot(points[i].homogeneous())) < radius)
+        BOOST_CHECK(std::binary_search(indexes.begin(), indexes.end(), i));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_Homography)
+{
+  std::mt19937 generator(1);
+  feature::SIFT_Regions lRegions;
+  feature::SIFT_Regions rRegions;
+  randomRegions(generator, 1500, lRegions);
+  randomRegions(generator, 1500, rRegions);
+
+  Mat3 H;
+  H << 1.05, 0.02, 10.0,
+      -0.03, 0.98, -5.0,
+       1e-5, 2e-5, 1.0;
+  const robustEstimation::Mat3Model model(H);
+
+  // transfer a part of the left regions in the right image with the same descriptors
+  // (large threshold to have other candidates for the distance ratio)
+  for(std::size_t i = 0; i < 500; ++i)
+  {
+    const Vec2 x = (H * lRegions.GetRegionPosition(i).homogeneous()).hnormalized();
+    rRegions.Features()[i * 3] = feature::PointFeature(x(0) + 0.5, x(1) - 0.5, 1.f, 0.f);
+    rRegions.Descriptors()[i * 3] = lRegions.Descriptors()[i];
+  }
+
+  IndMatches matches;
+  IndMatches referenceMatches;
+  guidedMatching<robustEstimation::Mat3Model, multiview::relativePose::HomographyAsymmetricError>(model, nullptr, lRegions, nullptr, rRegions, 900.0, 0.8 * 0.8, matches);
+  exhaustiveGuidedMatching<multiview::relativePose::HomographyAsymmetricError>(model, lRegions, rRegions, 900.0, 0.8 * 0.8, referenceMatches);
+
+  BOOST_CHECK_GE(matches.size(), 450);
+  BOOST_CHECK(matches == referenceMatches);
+
+  // features only
+  Mat xLeft(2, lRegions.RegionCount());
+  Mat xRight(2, rRegions.RegionCount());
+  for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
+    xLeft.col(i) = lRegions.GetRegionPosition(i);
+  for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    xRight.col(j) = rRegions.GetRegionPosition(j);
+
+  IndMatches featuresMatches;
+  guidedMatching<robustEstimation::Mat3Model, multiview::relativePose::HomographyAsymmetricError>(model, xLeft, xRight, 900.0, featuresMatches);
+
+  const multiview::relativePose::HomographyAsymmetricError errorEstimator;
+  IndMatches referenceFeaturesMatches;
+  for(Mat::Index i = 0; i < xLeft.cols(); ++i)
+  {
+    double min = std::numeric_limits<double>::max();
+    IndMatch match;
+    for(Mat::Index j = 0; j < xRight.cols(); ++j)
+    {
+      const double err = errorEstimator.error(model, xLeft.col(i), xRight.col(j));
+      if(err < 900.0 && err < min)
+      {
+        min = err;
+        match = IndMatch(i, j);
+      }
+    }
+    if(min < 900.0)
+      referenceFeaturesMatches.push_back(match);
+  }
+  IndMatch::getDeduplicated(referenceFeaturesMatches);
+
+  BOOST_CHECK_GE(featuresMatches.size(), 450);
+  BOOST_CHECK(featuresMatches == referenceFeaturesMatches);
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_Fundamental)
+{
+  std::mt19937 generator(2);
+  feature::SIFT_Regions lRegions;
+  feature::SIFT_Regions rRegions;
+  randomRegions(generator, 1500, lRegions);
+  randomRegions(generator, 1500, rRegions);
+
+  // fundamental matrix of a translation along x: epipolar lines are the horizontal lines y' = y
+  Mat3 F;
+  F << 0.0, 0.0,  0.0,
+       0.0, 0.0, -1.0,
+       0.0, 1.0,  0.0;
+  const robustEstimation::Mat3Model model(F);
+
+  // move a part of the left regions along their epipolar line with the same descriptors
+  for(std::size_t i = 0; i < 500; ++i)
+  {
+    const Vec2 x = lRegions.GetRegionPosition(i);
+    rRegions.Features()[i * 3] = feature::PointFeature(std::fmod(x(0) + 200.0, 1000.0), x(1) + 0.5, 1.f, 0.f);
+    rRegions.Descriptors()[i * 3] = lRegions.Descriptors()[i];
+  }
+
+  IndMatches matches;
+  IndMatches referenceMatches;
+  guidedMatching<robustEstimation::Mat3Model, multiview::relativePose::FundamentalEpipolarDistanceError>(model, nullptr, lRegions, nullptr, rRegions, 4.0, 0.8 * 0.8, matches);
+  exhaustiveGuidedMatching<multiview::relativePose::FundamentalEpipolarDistanceError>(model, lRegions, rRegions, 4.0, 0.8 * 0.8, referenceMatches);
+
+  BOOST_CHECK_GE(matches.size(), 450);
+  BOOST_CHECK(matches == referenceMatches);
+
+  // error without spatial search: all the right points are compared
+  IndMatches sampsonMatches;
+  IndMatches referenceSampsonMatches;
+  guidedMatching<robustEstimation::Mat3Model, multiview::relativePose::FundamentalSampsonError>(model, nullptr, lRegions, nullptr, rRegions, 4.0, 0.8 * 0.8, sampsonMatches);
+  exhaustiveGuidedMatching<multiview::relativePose::FundamentalSampsonError>(model, lRegions, rRegions, 4.0, 0.8 * 0.8, referenceSampsonMatches);
+
+  BOOST_CHECK(sampsonMatches == referenceSampsonMatches);
+}
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
@@ -15,8 +16,12 @@
 
 #include <boost/progress.hpp>
 
-#include <vector>
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <random>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace matchingImageCollection {
@@ -28,6 +33,12 @@ using namespace aliceVision::matching;
  * or all the pairs and regions correspondences contained in the putativeMatches set.
  * Allow to keep only geometrically coherent matches.
  * It discards pairs that do not lead to a valid robust model estimation.
+ *
+ * The pairs are processed in parallel, the ones with the most putative matches first to balance
+ * the threads workload. Each thread keeps its results in its own shard and the shards are merged
+ * at the end. Each pair uses its own random generator seeded from randomNumberGenerator, so the
+ * result does not depend on the number of threads.
+ *
  * @param[out] geometricMatches
  * @param[in] sfmData
  * @param[in] regionsPerView
@@ -51,23 +62,54 @@ void robustModelEstimation(
 {
   out_geometricMatches.clear();
 
-  boost::progress_display progressBar(putativeMatches.size(), std::cout, "Robust Model Estimation\n");
-  
-#pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < (int)putativeMatches.size(); ++i)
+  const std::size_t nbPairs = putativeMatches.size();
+
+  // direct access to the pairs and one random seed per pair (in the pairs order)
+  std::vector<PairwiseMatches::const_iterator> pairs;
+  std::vector<std::mt19937::result_type> seeds;
+  pairs.reserve(nbPairs);
+  seeds.reserve(nbPairs);
+
+  for(PairwiseMatches::const_iterator iter = putativeMatches.begin(); iter != putativeMatches.end(); ++iter)
   {
-    PairwiseMatches::const_iterator iter = putativeMatches.begin();
-    std::advance(iter, i);
+    pairs.push_back(iter);
+    seeds.push_back(randomNumberGenerator());
+  }
 
-    const Pair currentPair = iter->first;
-    const MatchesPerDescType& putativeMatchesPerType = iter->second;
-    const Pair& imagePair = iter->first;
+  // schedule the pairs with the largest number of putative matches first
+  std::vector<std::size_t> pairsOrder(nbPairs);
+  std::vector<std::size_t> nbPutativeMatches(nbPairs);
+
+  for(std::size_t i = 0; i < nbPairs; ++i)
+  {
+    pairsOrder[i] = i;
+    nbPutativeMatches[i] = pairs[i]->second.getNbAllMatches();
+  }
+
+  std::stable_sort(pairsOrder.begin(), pairsOrder.end(), [&](std::size_t a, std::size_t b)
+  {
+    return nbPutativeMatches[a] > nbPutativeMatches[b];
+  });
+
+  // per-thread results
+  std::vector<std::vector<std::pair<Pair, MatchesPerDescType>>> shards(omp_get_max_threads());
+
+  boost::progress_display progressBar(nbPairs, std::cout, "Robust Model Estimation\n");
+  std::size_t nbProcessedPairs = 0;
+
+#pragma omp parallel for schedule(dynamic)
+  for (int p = 0; p < (int)nbPairs; ++p)
+  {
+    const std::size_t i = pairsOrder[p];
+    const Pair& imagePair = pairs[i]->first;
+    const MatchesPerDescType& putativeMatchesPerType = pairs[i]->second;
 
     // apply the geometric filter (robust model estimation)
     {
+      std::mt19937 pairRandomNumberGenerator(seeds[i]);
       MatchesPerDescType inliers;
       GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
-      const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, randomNumberGenerator, inliers);
+      const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, pairRandomNumberGenerator, inliers);
       if(state.hasStrongSupport)
       {
         if(guidedMatching)
@@ -78,19 +120,47 @@ void robustModelEstimation(
           std::swap(inliers, guidedGeometricInliers);
         }
 
-#pragma omp critical
-        {
-          out_geometricMatches.emplace(currentPair, std::move(inliers));
-        }
-
+        shards[omp_get_thread_num()].emplace_back(imagePair, std::move(inliers));
       }
     }
 
-#pragma omp critical
+    OMP_ATOMIC_UPDATE
+    ++nbProcessedPairs;
+
+    // the progress display is only updated by the first thread
+    if(omp_get_thread_num() == 0)
     {
-      ++progressBar;
+      std::size_t nbProcessedPairsCopy;
+      OMP_ATOMIC_READ
+      nbProcessedPairsCopy = nbProcessedPairs;
+      progressBar += nbProcessedPairsCopy - progressBar.count();
     }
   }
+
+  progressBar += nbPairs - progressBar.count();
+
+  // merge the shards, inserted in the pairs order
+  std::vector<std::pair<Pair, MatchesPerDescType>> geometricMatches;
+  {
+    std::size_t nbGeometricMatches = 0;
+    for(const auto& shard : shards)
+      nbGeometricMatches += shard.size();
+    geometricMatches.reserve(nbGeometricMatches);
+  }
+
+  for(auto& shard : shards)
+  {
+    std::move(shard.begin(), shard.end(), std::back_inserter(geometricMatches));
+    shard.clear();
+  }
+
+  std::sort(geometricMatches.begin(), geometricMatches.end(), [](const std::pair<Pair, MatchesPerDescType>& a, const std::pair<Pair, MatchesPerDescType>& b)
+  {
+    return a.first < b.first;
+  });
+
+  for(auto& geometricMatch : geometricMatches)
+    out_geometricMatches.emplace_hint(out_geometricMatches.end(), geometricMatch.first, std::move(geometricMatch.second));
 }
 
 } // namespace matchingImageCollection
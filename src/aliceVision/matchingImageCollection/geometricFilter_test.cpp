@@ -0,0 +1,144 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilter.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_H_AC.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE matchingImageCollectionGeometricFilter
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+/**
+ * @brief Generate a scene of random views where each pair has putative matches
+ *        following a random homography, polluted with outliers.
+ *        The pairs have various number of putative matches.
+ */
+void generateScene(std::size_t nbViews,
+                   std::size_t nbFeatures,
+                   sfmData::SfMData& sfmData,
+                   feature::RegionsPerView& regionsPerView,
+                   matching::PairwiseMatches& putativeMatches)
+{
+  const feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT;
+  const double width = 1000.0;
+  const double height = 800.0;
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+  // all the views see the same plane, each view with its own homography from the plane
+  std::vector<Vec2> planePoints(nbFeatures);
+
+  for(Vec2& point : planePoints)
+    point = Vec2(distribution(generator) * width, distribution(generator) * height);
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    sfmData.views.emplace(viewId, std::make_shared<sfmData::View>("", viewId, UndefinedIndexT, viewId, width, height));
+
+    Mat3 H = Mat3::Identity();
+    H(0, 0) += 0.1 * (distribution(generator) - 0.5);
+    H(0, 1) += 0.1 * (distribution(generator) - 0.5);
+    H(1, 0) += 0.1 * (distribution(generator) - 0.5);
+    H(1, 1) += 0.1 * (distribution(generator) - 0.5);
+    H(0, 2) = 50.0 * (distribution(generator) - 0.5);
+    H(1, 2) = 50.0 * (distribution(generator) - 0.5);
+    H(2, 0) = 1e-5 * (distribution(generator) - 0.5);
+    H(2, 1) = 1e-5 * (distribution(generator) - 0.5);
+
+    feature::SIFT_Regions* regions = new feature::SIFT_Regions();
+    for(const Vec2& point : planePoints)
+    {
+      const Vec2 x = (H * point.homogeneous()).hnormalized();
+      regions->Features().emplace_back(x.x() + 0.5 * (distribution(generator) - 0.5), x.y() + 0.5 * (distribution(generator) - 0.5), 1.0f, 0.0f);
+    }
+    regions->Descriptors().resize(nbFeatures);
+    regionsPerView.addRegions(viewId, descType, regions);
+  }
+
+  for(IndexT I = 0; I < nbViews; ++I)
+  {
+    for(IndexT J = I + 1; J < nbViews; ++J)
+    {
+      // various number of putative matches per pair with 30% of outliers
+      const std::size_t nbMatches = nbFeatures / 4 + static_cast<std::size_t>(distribution(generator) * (nbFeatures - nbFeatures / 4));
+      matching::IndMatches& matches = putativeMatches[Pair(I, J)][descType];
+
+      for(std::size_t i = 0; i < nbMatches; ++i)
+      {
+        const IndexT featureI = static_cast<IndexT>(i);
+        const IndexT featureJ = (distribution(generator) < 0.3) ? static_cast<IndexT>(distribution(generator) * (nbFeatures - 1)) : featureI;
+        matches.emplace_back(featureI, featureJ);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GeometricFilter_robustModelEstimation_threads)
+{
+  const std::size_t nbViews = 12;
+  const std::size_t nbFeatures = 400;
+
+  sfmData::SfMData sfmData;
+  feature::RegionsPerView regionsPerView;
+  matching::PairwiseMatches putativeMatches;
+
+  generateScene(nbViews, nbFeatures, sfmData, regionsPerView, putativeMatches);
+
+  const int maxNbThreads = omp_get_max_threads();
+
+  // reference result with a single thread
+  matching::PairwiseMatches referenceMatches;
+  {
+    omp_set_num_threads(1);
+    std::mt19937 randomNumberGenerator(0);
+    aliceVision::system::Timer timer;
+    matchingImageCollection::robustModelEstimation(referenceMatches, &sfmData, regionsPerView,
+      matchingImageCollection::GeometricFilterMatrix_H_AC(4.0, 1024), putativeMatches, randomNumberGenerator);
+    ALICEVISION_LOG_INFO("Robust model estimation with 1 thread: " << timer.elapsedMs() << " ms");
+  }
+
+  BOOST_CHECK_EQUAL(referenceMatches.size(), putativeMatches.size());
+
+  // the result must not depend on the number of threads
+  const int maxNbThreadsTested = std::max(2, std::min(64, maxNbThreads));
+  for(int nbThreads = 2; nbThreads <= maxNbThreadsTested; nbThreads *= 2)
+  {
+    omp_set_num_threads(nbThreads);
+    std::mt19937 randomNumberGenerator(0);
+    matching::PairwiseMatches geometricMatches;
+    aliceVision::system::Timer timer;
+    matchingImageCollection::robustModelEstimation(geometricMatches, &sfmData, regionsPerView,
+      matchingImageCollection::GeometricFilterMatrix_H_AC(4.0, 1024), putativeMatches, randomNumberGenerator);
+    ALICEVISION_LOG_INFO("Robust model estimation with " << nbThreads << " threads: " << timer.elapsedMs() << " ms");
+
+    BOOST_CHECK(geometricMatches == referenceMatches);
+  }
+
+  omp_set_num_threads(maxNbThreads);
+
+  // the inliers must be mostly the putative matches without outliers
+  std::size_t nbInliers = 0;
+  std::size_t nbOutliers = 0;
+  for(const auto& matchesPair : referenceMatches)
+  {
+    for(const auto& matchesPerDesc : matchesPair.second)
+    {
+      for(const matching::IndMatch& match : matchesPerDesc.second)
+        ++((match._i == match._j) ? nbInliers : nbOutliers);
+    }
+  }
+  BOOST_CHECK_LT(nbOutliers, nbInliers / 20);
+}
@@ -5,14 +5,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include "MeshBVH.hpp"
+#include "MeshConnectivity.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 
 #include <boost/filesystem.hpp>
 
-#include <fstream>
 #include <map>
 
 namespace aliceVision {
@@ -28,45 +30,6 @@ Mesh::~Mesh()
 {
 }
 
-void Mesh::saveToObj(const std::string& filename)
-{
-  ALICEVISION_LOG_INFO("Save mesh to obj: " << filename);
-  ALICEVISION_LOG_INFO("Nb points: " << pts.size());
-  ALICEVISION_LOG_INFO("Nb triangles: " << tris.size());
-
-  FILE* f = fopen(filename.c_str(), "w");
-
-  fprintf(f, "# \n");
-  fprintf(f, "# Wavefront OBJ file\n");
-  fprintf(f, "# Created with AliceVision\n");
-  fprintf(f, "# \n");
-  fprintf(f, "g Mesh\n");
-
-  if(_colors.size() == pts.size())
-  {
-    std::size_t i = 0;
-    for(const auto& point : pts)
-    {
-      const rgb& col = _colors[i];
-      fprintf(f, "v %f %f %f %f %f %f\n", point.x, point.y, point.z, col.r/255.0f, col.g/255.0f, col.b/255.0f);
-      ++i;
-    }
-  }
-  else
-  {
-    for(const auto& point : pts)
-      fprintf(f, "v %f %f %f\n", point.x, point.y, point.z);    
-  }
-
-  for(int i = 0; i < tris.size(); i++)
-  {
-      Mesh::triangle& t = tris[i];
-      fprintf(f, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1);
-  }
-  fclose(f);
-  ALICEVISION_LOG_INFO("Save mesh to obj done.");
-}
-
 bool Mesh::loadFromBin(const std::string& binFileName)
 {
     FILE* f = fopen(binFileName.c_str(), "rb");
@@ -87,6 +50,7 @@ bool Mesh::loadFromBin(const std::string& binFileName)
     fread(&tris[0], sizeof(Mesh::triangle), ntris, f);
 
     fclose(f);
+    invalidateConnectivity();
     return true;
 }
 
@@ -119,6 +83,17 @@ void Mesh::addMesh(const Mesh& mesh)
 {
     const std::size_t npts = pts.size();
 
+    // keep the points visibilities only if both meshes have them
+    if(pointsVisibilities.size() == pts.size() && mesh.pointsVisibilities.size() == mesh.pts.size())
+    {
+        pointsVisibilities.reserveAdd(mesh.pointsVisibilities.size());
+        std::copy(mesh.pointsVisibilities.begin(), mesh.pointsVisibilities.end(), std::back_inserter(pointsVisibilities.getDataWritable()));
+    }
+    else
+    {
+        pointsVisibilities.clear();
+    }
+
     pts.reserveAdd(mesh.pts.size());
     std::copy(mesh.pts.begin(), mesh.pts.end(), std::back_inserter(pts.getDataWritable()));
 
@@ -144,6 +119,7 @@ void Mesh::addMesh(const Mesh& mesh)
             ALICEVISION_LOG_WARNING("addMesh: bad triangle index: " << t.v[0] << " " << t.v[1] << " " << t.v[2] << ", npts: " << mesh.pts.size());
         }
     }
+    invalidateConnectivity();
 
     if(!mesh.uvCoords.empty())
     {
@@ -462,56 +438,31 @@ bool Mesh::doesTriangleIntersectsRectangle(Mesh::triangle_proj& tp, Mesh::rectan
     */
 }
 
-void Mesh::getPtsNeighborTriangles(StaticVector<StaticVector<int>>& out_ptsNeighTris) const
+std::shared_ptr<const MeshConnectivity> Mesh::getConnectivity() const
 {
-    // array of tuples <x: vertexIndex, y: triangleIndex, z: numberOfNeighbors>
-    StaticVector<Voxel> vertexNeighborhoodPairs;
-    vertexNeighborhoodPairs.reserve(tris.size() * 3);
-    for(int i = 0; i < tris.size(); ++i)
-    {
-        vertexNeighborhoodPairs.push_back(Voxel(tris[i].v[0], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel(tris[i].v[1], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel(tris[i].v[2], i, 0));
-    }
-    qsort(&vertexNeighborhoodPairs[0], vertexNeighborhoodPairs.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    std::lock_guard<std::mutex> lock(_connectivityCache.mutex);
+    if(!_connectivityCache.connectivity)
+        _connectivityCache.connectivity = std::make_shared<const MeshConnectivity>(*this);
+    return _connectivityCache.connectivity;
+}
 
-    int i = 0; // index of the unique pair of <vertex, neighborhood>
-    int j = 0; // index of the vertex
-    int k = 0; // number of neighbors
-    int firstid = 0;
-    while(i < vertexNeighborhoodPairs.size())
-    {
-        k++;
-        // (*vertexNeighborhoodPairs)[i].z = j;
-        if((i == vertexNeighborhoodPairs.size() - 1) || (vertexNeighborhoodPairs[i].x != vertexNeighborhoodPairs[i + 1].x))
-        {
-            vertexNeighborhoodPairs[firstid].z = k; // store the number of neighbors
-            ++j;
-            firstid = i + 1;
-            k = 0;
-        }
-        ++i;
-    }
-    int npts = j;
+void Mesh::invalidateConnectivity()
+{
+    std::lock_guard<std::mutex> lock(_connectivityCache.mutex);
+    _connectivityCache.connectivity.reset();
+}
+
+void Mesh::getPtsNeighborTriangles(StaticVector<StaticVector<int>>& out_ptsNeighTris) const
+{
+    const std::shared_ptr<const MeshConnectivity> connectivity = getConnectivity();
 
-    out_ptsNeighTris.reserve(pts.size());
     out_ptsNeighTris.resize(pts.size());
 
-    i = 0;
-    for(j = 0; j < npts; ++j)
+    #pragma omp parallel for
+    for(int ptId = 0; ptId < pts.size(); ++ptId)
     {
-        int middlePtId = vertexNeighborhoodPairs[i].x;
-        int nbNeighbors = vertexNeighborhoodPairs[i].z;
-        int i0 = i;
-        int i1 = i + nbNeighbors;
-        i = i1;
-
-        StaticVector<int>& triTmp = out_ptsNeighTris[middlePtId];
-        triTmp.reserve(nbNeighbors);
-        for(int l = i0; l < i1; ++l)
-        {
-            triTmp.push_back(vertexNeighborhoodPairs[l].y); // index of triangle
-        }
+        const int* ptTris = connectivity->getPtTris(ptId);
+        out_ptsNeighTris[ptId].getDataWritable().assign(ptTris, ptTris + connectivity->getNbPtTris(ptId));
     }
 }
 
@@ -536,20 +487,40 @@ void Mesh::getPtsNeighbors(std::vector<std::vector<int>>& out_ptsNeigh) const
 
 void Mesh::getPtsNeighPtsOrdered(StaticVector<StaticVector<int>>& out_ptsNeighPts) const
 {
-    StaticVector<StaticVector<int>> ptsNeighborTriangles;
-    getPtsNeighborTriangles(ptsNeighborTriangles);
+    const std::shared_ptr<const MeshConnectivity> connectivity = getConnectivity();
 
     out_ptsNeighPts.resize(pts.size());
 
+    #pragma omp parallel for schedule(dynamic, 1024)
     for(int middlePtId = 0; middlePtId < pts.size(); ++middlePtId)
     {
-        StaticVector<int>& neighborTriangles = ptsNeighborTriangles[middlePtId];
-        if(neighborTriangles.empty())
+        if(connectivity->getNbPtTris(middlePtId) == 0)
             continue;
 
+        const int* ptTris = connectivity->getPtTris(middlePtId);
+        StaticVector<int> neighborTriangles;
+        neighborTriangles.getDataWritable().assign(ptTris, ptTris + connectivity->getNbPtTris(middlePtId));
+
         StaticVector<int> vhid;
         vhid.reserve(neighborTriangles.size() * 2);
-        int currentTriPtId = tris[neighborTriangles[0]].v[0];
+        // start from a vertex of the first triangle other than the middle one,
+        // or from a boundary edge to walk through the whole fan of the boundary vertices
+        const Mesh::triangle& firstTri = tris[neighborTriangles[0]];
+        int currentTriPtId = (firstTri.v[0] != middlePtId) ? firstTri.v[0] : firstTri.v[1];
+        bool onBoundary = false;
+        for(int n = 0; n < neighborTriangles.size() && !onBoundary; ++n)
+        {
+            for(int k = 0; k < 3 && !onBoundary; ++k)
+            {
+                const int edgeId = connectivity->getTriEdge(neighborTriangles[n], k);
+                const Pixel& edge = connectivity->getEdge(edgeId);
+                if(connectivity->isBoundaryEdge(edgeId) && edge.x != edge.y && (edge.x == middlePtId || edge.y == middlePtId))
+                {
+                    currentTriPtId = (edge.x == middlePtId) ? edge.y : edge.x;
+                    onBoundary = true;
+                }
+            }
+        }
         int firstTriPtId = currentTriPtId;
         vhid.push_back(currentTriPtId);
 
@@ -758,9 +729,61 @@ void Mesh::getTrisMap(StaticVector<StaticVector<int>>& out, StaticVector<int>& v
 
 void Mesh::getDepthMap(StaticVector<float>& depthMap, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w, int h)
 {
-    StaticVector<StaticVector<int>> tmp;
-    getTrisMap(tmp, mp, rc, scale, w, h);
-    getDepthMap(depthMap, tmp, mp, rc, scale, w, h);
+    const MeshBVH bvh(*this);
+    getDepthMap(depthMap, bvh, mp, rc, scale, w, h);
+}
+
+namespace {
+
+/**
+ * @brief Cast a ray from the camera rc through the center of each pixel of a w x h map,
+ *        by packets of 2x2 pixels, and call f(pixelIndex, hit) for each pixel (index x * h + y).
+ */
+template <typename F>
+void castCameraRays(const MeshBVH& bvh, const mvsUtils::MultiViewParams& mp, int rc, double scaleX, double scaleY, int w, int h, F f)
+{
+    const Point3d& C = mp.CArr[rc];
+    const Matrix3x3& iCam = mp.iCamArr[rc];
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int x0 = 0; x0 < w; x0 += 2)
+    {
+        Point3d origins[4] = {C, C, C, C};
+        Point3d directions[4];
+        float tMax[4];
+        MeshBVH::Hit hits[4];
+
+        for(int y0 = 0; y0 < h; y0 += 2)
+        {
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                const int x = x0 + (lane & 1);
+                const int y = y0 + (lane >> 1);
+                tMax[lane] = (x < w && y < h) ? std::numeric_limits<float>::max() : -1.0f;
+                directions[lane] = (iCam * Point2d((x + 0.5) * scaleX, (y + 0.5) * scaleY)).normalize();
+            }
+
+            bvh.intersect4(origins, directions, hits, tMax);
+
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                if(tMax[lane] > 0.0f)
+                    f((x0 + (lane & 1)) * h + y0 + (lane >> 1), hits[lane]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void Mesh::getDepthMap(StaticVector<float>& depthMap, const MeshBVH& bvh, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w,
+                       int h) const
+{
+    depthMap.resize_with(w * h, -1.0f);
+
+    castCameraRays(bvh, mp, rc, scale, scale, w, h, [&](int index, const MeshBVH::Hit& hit) {
+        depthMap[index] = (hit.triangle >= 0) ? hit.t : -1.0f;
+    });
 }
 
 void Mesh::getDepthMap(StaticVector<float>& depthMap, StaticVector<StaticVector<int>>& tmp, const mvsUtils::MultiViewParams& mp,
@@ -914,6 +937,29 @@ void Mesh::getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, StaticVecto
     }
 }
 
+void Mesh::getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, const MeshBVH& bvh, const mvsUtils::MultiViewParams& mp, int rc,
+                                      int w, int h) const
+{
+    std::vector<int> pixelsTriangle(w * h, -1);
+
+    castCameraRays(bvh, mp, rc, double(mp.getWidth(rc)) / w, double(mp.getHeight(rc)) / h, w, h,
+                   [&](int index, const MeshBVH::Hit& hit) { pixelsTriangle[index] = hit.triangle; });
+
+    std::vector<bool> visible(tris.size(), false);
+    for(const int idTri : pixelsTriangle)
+    {
+        if(idTri >= 0)
+            visible[idTri] = true;
+    }
+
+    out_visTri.reserve(tris.size());
+    for(int i = 0; i < tris.size(); ++i)
+    {
+        if(visible[i])
+            out_visTri.push_back(i);
+    }
+}
+
 void Mesh::getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, StaticVector<StaticVector<int>>& trisMap,
                                                        StaticVector<float>& depthMap, const mvsUtils::MultiViewParams& mp, int rc,
                                                        int w, int h)
@@ -1057,56 +1103,19 @@ void Mesh::generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, Mes
 
 void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>>& edgesNeighTris, StaticVector<Pixel>& edgesPointsPairs)
 {
-    StaticVector<Voxel> edges;
-    edges.reserve(tris.size() * 3);
-
-    for(int i = 0; i < tris.size(); i++)
-    {
-        int a = tris[i].v[0];
-        int b = tris[i].v[1];
-        int c = tris[i].v[2];
-        edges.push_back(Voxel(std::min(a, b), std::max(a, b), i));
-        edges.push_back(Voxel(std::min(b, c), std::max(b, c), i));
-        edges.push_back(Voxel(std::min(c, a), std::max(c, a), i));
-    }
+    const std::shared_ptr<const MeshConnectivity> connectivity = getConnectivity();
+    const int nbEdges = connectivity->getNbEdges();
 
-    qsort(&edges[0], edges.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    edgesNeighTris.resize(nbEdges);
+    edgesPointsPairs.resize(nbEdges);
 
-    edgesNeighTris.reserve(tris.size() * 3);
-    edgesPointsPairs.reserve(tris.size() * 3);
-    // remove duplicities
-    int i0 = 0;
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < edges.size(); i++)
+    #pragma omp parallel for
+    for(int edgeId = 0; edgeId < nbEdges; ++edgeId)
     {
-        if((i == edges.size() - 1) || (edges[i].x != edges[i + 1].x))
-        {
-            StaticVector<Voxel> edges1;
-            edges1.reserve(i - i0 + 1);
-            edges1.getDataWritable().insert(edges1.begin(), edges.begin()+i0, edges.begin()+i+1);
-            qsort(&edges1[0], edges1.size(), sizeof(Voxel), qSortCompareVoxelByYAsc);
-
-            int j0 = 0;
-            for(int j = 0; j < edges1.size(); j++)
-            {
-                if((j == edges1.size() - 1) || (edges1[j].y != edges1[j + 1].y))
-                {
-                    edgesPointsPairs.push_back(Pixel(edges1[j].x, edges1[j].y));
-                    edgesNeighTris.resize(edgesNeighTris.size() + 1);
-                    StaticVector<int>& neighTris = edgesNeighTris.back();
-                    neighTris.reserve(j - j0 + 1);
-                    for(int k = j0; k <= j; k++)
-                    {
-                        neighTris.push_back(edges1[k].z);
-                    }
-                    j0 = j + 1;
-                }
-            }
-            i0 = i + 1;
-        }
-        mvsUtils::printfEstimate(i, edges.size(), t1);
+        const int* edgeTris = connectivity->getEdgeTris(edgeId);
+        edgesPointsPairs[edgeId] = connectivity->getEdge(edgeId);
+        edgesNeighTris[edgeId].getDataWritable().assign(edgeTris, edgeTris + connectivity->getNbEdgeTris(edgeId));
     }
-    mvsUtils::finishEstimate();
 }
 
 void Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>>& ptsNeighPts, StaticVector<Point3d>& out_nms,
@@ -1297,6 +1306,7 @@ void Mesh::removeFreePointsFromMesh(StaticVector<int>& out_ptIdToNewPtId)
     std::swap(cleanedMesh.pts, pts);
     std::swap(cleanedMesh.tris, tris);
     std::swap(cleanedMesh._colors, _colors);
+    invalidateConnectivity();
 }
 
 double Mesh::computeTriangleProjectionArea(const triangle_proj& tp) const
@@ -1749,6 +1759,7 @@ int Mesh::subdivideMeshOnce(const Mesh& refMesh, const GEO::AdaptiveKdTree& refM
     uvCoords.swap(new_uvCoords);
     trisUvIds.swap(new_trisUvIds);
     _trisMtlIds.swap(new_trisMtlIds);
+    invalidateConnectivity();
 
     return trianglesToSubdivide.size();
 }
@@ -1801,6 +1812,7 @@ void Mesh::letJustTringlesIdsInMesh(StaticVector<int>& trisIdsToStay)
         trisTmp.push_back(tris[trisIdsToStay[i]]);
     }
     tris.swap(trisTmp);
+    invalidateConnectivity();
 }
 
 void Mesh::letJustTringlesIdsInMesh(const StaticVectorBool& trisToStay)
@@ -1818,6 +1830,7 @@ void Mesh::letJustTringlesIdsInMesh(const StaticVectorBool& trisToStay)
             trisTmp.push_back(tris[i]);
 
     tris.swap(trisTmp);
+    invalidateConnectivity();
 }
 
 void Mesh::computeTrisCams(StaticVector<StaticVector<int>>& trisCams, const mvsUtils::MultiViewParams& mp, const std::string tmpDir)
@@ -2104,6 +2117,7 @@ void Mesh::invertTriangleOrientations()
         Mesh::triangle& t = tris[i];
         std::swap(t.v[1], t.v[2]);
     }
+    invalidateConnectivity();
 }
 
 void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
@@ -2115,6 +2129,7 @@ void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
             tris[triId].v[k] = newPtId;
         }
     }
+    invalidateConnectivity();
 }
 
 int Mesh::getTriPtIndex(int triId, int ptId, bool failIfDoesNotExists) const
@@ -2254,276 +2269,6 @@ void Mesh::getLargestConnectedComponentTrisIds(StaticVector<int>& out) const
     }
 }
 
-bool Mesh::loadFromObjAscii(const std::string& objAsciiFileName)
-{  
-    ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
-    // read number of points, triangles, uvcoords
-    int npts = 0;
-    int ntris = 0;
-    int nuvs = 0;
-    int nnorms = 0;
-    int nlines = 0;
-    bool useColors = false;
-
-    {
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-        while(getline(in, line))
-        {
-            if((line[0] == 'v') && (line[1] == ' '))
-            {
-                if(npts == 0)
-                {
-                  useColors = mvsUtils::findNSubstrsInString(line, ".") == 6;
-                }
-                npts += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                nnorms += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                nuvs += 1;
-            }
-            if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                if((n1 == 3 && n2 == 0) || 
-                   (n1 == 6 && n2 == 0) ||
-                   (n1 == 0 && n2 == 3) ||
-                   (n1 == 0 && n2 == 0))
-                    ntris += 1;
-                else if((n1 == 4 && n2 == 0) ||
-                        (n1 == 8 && n2 == 0) ||
-                        (n1 == 0 && n2 == 4))
-                    ntris += 2;
-            }
-            nlines++;
-        }
-        in.close();
-    }
-
-    ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
-      << "\t- # normals: " << nnorms << std::endl
-      << "\t- # uv coordinates: " << nuvs << std::endl
-      << "\t- # triangles: " << ntris);
-
-    pts = StaticVector<Point3d>();
-    pts.reserve(npts);
-    tris = StaticVector<Mesh::triangle>();
-    tris.reserve(ntris);
-    uvCoords.reserve(nuvs);
-    trisUvIds.reserve(ntris);
-    normals.reserve(nnorms);
-    trisNormalsIds.reserve(ntris);
-    _trisMtlIds.reserve(ntris);
-    if(useColors)
-    {
-        _colors.reserve(npts);
-    }
-
-    std::map<std::string, int> materialCache;
-
-    {
-        int mtlId = -1;
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-
-        long t1 = mvsUtils::initEstimate();
-        int idline = 0;
-        while(getline(in, line))
-        {
-            if(line.size() < 3 || line[0] == '#')
-            {
-                // nothing to do
-            }
-            else if(mvsUtils::findNSubstrsInString(line, "usemtl") == 1)
-            {
-                char buff[5000];
-                sscanf(line.c_str(), "usemtl %s", buff);
-                auto it = materialCache.find(buff);
-                if(it == materialCache.end())
-                    materialCache.emplace(buff, ++mtlId); // new material
-                else
-                    mtlId = it->second;                   // already known material
-            }
-            else if((line[0] == 'v') && (line[1] == ' '))
-            {
-                Point3d pt;
-                if(useColors)
-                {
-                    float r, g, b;
-                    sscanf(line.c_str(), "v %lf %lf %lf %f %f %f", &pt.x, &pt.y, &pt.z, &r, &g, &b);
-                    // convert float color data to uchar
-                    _colors.emplace_back(
-                      static_cast<unsigned char>(r*255.0f),
-                      static_cast<unsigned char>(g*255.0f),
-                      static_cast<unsigned char>(b*255.0f)
-                    );
-                }
-                else
-                {
-                    sscanf(line.c_str(), "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                }
-                pts.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                // printf("%f %f %f\n", pt.x, pt.y, pt.z);
-                normals.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                Point2d pt;
-                sscanf(line.c_str(), "vt %lf %lf", &pt.x, &pt.y);
-                uvCoords.push_back(pt);
-            }
-            else if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                Voxel vertex, uvCoord, vertexNormal;
-                Voxel vertex2, uvCoord2, vertexNormal2;
-                bool ok = false;
-                bool withNormal = false;
-                bool withUV = false;
-                bool withQuad = false;
-                if(n2 == 0)
-                {
-                    if(n1 == 0)
-                    {
-                        sscanf(line.c_str(), "f %i %i %i", &vertex.x, &vertex.y, &vertex.z);
-                        ok = true;
-                    }
-                    else if(n1 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z);
-                        ok = true;
-                        withUV = true;
-                    }
-                    else if(n1 == 6)
-                    {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i", &vertex.x, &uvCoord.x, &vertexNormal.x, &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z);
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                    }
-                    else if(n1 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z, &vertex2.z, &uvCoord2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        ok = true;
-                        withUV = true;
-                        withQuad = true;
-                    }
-                    else if(n1 == 8)
-                    {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i",
-                               &vertex.x, &uvCoord.x, &vertexNormal.x,
-                               &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z,
-                               &vertex2.z, &uvCoord2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                else
-                {
-                    if(n2 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i", &vertex.x, &vertexNormal.x, &vertex.y, &vertexNormal.y, &vertex.z, &vertexNormal.z);
-                        ok = true;
-                        withNormal = true;
-                    }
-                    else if(n2 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i %i//%i",
-                               &vertex.x, &vertexNormal.x,
-                               &vertex.y, &vertexNormal.y,
-                               &vertex.z, &vertexNormal.z,
-                               &vertex2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                if(!ok)
-                {
-                    throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
-                }
-
-                // 1st triangle
-                {
-                    triangle t;
-                    t.v[0] = vertex.x - 1;
-                    t.v[1] = vertex.y - 1;
-                    t.v[2] = vertex.z - 1;
-                    t.alive = true;
-                    tris.push_back(t);
-                    _trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal - Voxel(1, 1, 1));
-                    }
-                }
-
-                // potential 2nd triangle
-                if(withQuad)
-                {
-                    triangle t;
-                    t.v[0] = vertex2.x - 1;
-                    t.v[1] = vertex2.y - 1;
-                    t.v[2] = vertex2.z - 1;
-                    t.alive = true;
-                    tris.push_back(t);
-                    _trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord2 - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal2 - Voxel(1, 1, 1));
-                    }
-                }
-            }
-
-            mvsUtils::printfEstimate(idline, nlines, t1);
-            idline++;
-        }
-        mvsUtils::finishEstimate();
-
-        in.close();
-        nmtls = materialCache.size();
-    }
-    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
-    return npts != 0 && ntris != 0;
-}
-
 bool Mesh::getEdgeNeighTrisInterval(Pixel& itr, Pixel& edge, StaticVector<Voxel>& edgesXStat,
                                        StaticVector<Voxel>& edgesXYStat)
 {
@@ -2554,69 +2299,24 @@ bool Mesh::getEdgeNeighTrisInterval(Pixel& itr, Pixel& edge, StaticVector<Voxel>
 
 bool Mesh::lockSurfaceBoundaries(int neighbourIterations, StaticVectorBool& out_ptsCanMove, bool invert) const
 {
-    using Edge = std::pair<int, int>;  // min vertex index, max vertex index
- 
-    // qSort lambda for Edge structure
-    auto qSortCompareEdgeAsc = [] (const void* ia, const void* ib)
-    {
-        const Edge a = *(Edge*)ia;
-        const Edge b = *(Edge*)ib;
-
-        if(a.first < b.first)
-            return -1;
-        else if(a.first == b.first)
-            return (a.second < b.second) ? -1 : 1;
-        return 1;
-    };
-
     ALICEVISION_LOG_INFO("Lock surface " << (invert? "inner part" : "boundaries") << ".");
 
     StaticVectorBool boundariesVertices(pts.size(), false);
 
-    // Get all edges
-    StaticVector<Edge> edges(tris.size() * 3);
-
-    #pragma omp parallel for
-    for(int i = 0; i < tris.size(); ++i)
-    {
-      const int edgeStartIndex = i * 3;
-      const Mesh::triangle& t = tris[i];
-
-      edges[edgeStartIndex] = std::make_pair(std::min(t.v[0], t.v[1]), std::max(t.v[0], t.v[1]));
-      edges[edgeStartIndex + 1] = std::make_pair(std::min(t.v[1], t.v[2]), std::max(t.v[1], t.v[2]));
-      edges[edgeStartIndex + 2] = std::make_pair(std::min(t.v[2], t.v[0]), std::max(t.v[2], t.v[0]));
-    }
+    const std::shared_ptr<const MeshConnectivity> connectivity = getConnectivity();
+    const std::vector<Pixel>& edges = connectivity->getEdges();
+    const int nbEdges = connectivity->getNbEdges();
 
-    // Sort edges by vertex indexes
-    qsort(&edges[0], edges.size(), sizeof(Edge), qSortCompareEdgeAsc);
-
-    // Count edge, set is on boundary
-    int lastEdgeFirst = edges[0].first;
-    int lastEdgeSecond = edges[0].second;
-    int edgeCount = 0;
+    // Vertices of the edges used by a single triangle
     bool boundary = false;
-
-    for(int i = 0; i < edges.size(); ++i)
+    for(int i = 0; i < nbEdges; ++i)
     {
-      const Edge& edge = edges[i];
-
-      if((edge.first == lastEdgeFirst) && (edge.second == lastEdgeSecond))
-      {
-         ++edgeCount;
-      }
-      else
-      {
-         if(edgeCount < 2)
-         {
-           boundariesVertices[lastEdgeFirst] = true;
-           boundariesVertices[lastEdgeSecond] = true;
-           boundary = true;
-         }
-
-         lastEdgeFirst = edge.first;
-         lastEdgeSecond = edge.second;
-         edgeCount = 1;
-      }
+        if(connectivity->isBoundaryEdge(i))
+        {
+            boundariesVertices[edges[i].x] = true;
+            boundariesVertices[edges[i].y] = true;
+            boundary = true;
+        }
     }
 
     // Return false if no boundary
@@ -2632,24 +2332,24 @@ bool Mesh::lockSurfaceBoundaries(int neighbourIterations, StaticVectorBool& out_
         StaticVectorBool boundariesVerticesCurrent = boundariesVertices;
         
         #pragma omp parallel for
-        for(int i = 0; i < edges.size(); ++i)
+        for(int i = 0; i < nbEdges; ++i)
         {
-            Edge& edge = edges[i];
+            const Pixel& edge = edges[i];
 
-            if(boundariesVertices[edge.first] && 
-               boundariesVertices[edge.second]) // 2 vertices on boundary, skip
+            if(boundariesVertices[edge.x] && 
+               boundariesVertices[edge.y]) // 2 vertices on boundary, skip
                 continue;
 
-            if(boundariesVertices[edge.first])
+            if(boundariesVertices[edge.x])
             {
                 #pragma OMP_ATOMIC_WRITE
-                boundariesVerticesCurrent[edge.second] = true;
+                boundariesVerticesCurrent[edge.y] = true;
             }
 
-            if(boundariesVertices[edge.second])
+            if(boundariesVertices[edge.y])
             {
                 #pragma OMP_ATOMIC_WRITE
-                boundariesVerticesCurrent[edge.first] = true;
+                boundariesVerticesCurrent[edge.x] = true;
             }
         }
         std::swap(boundariesVertices, boundariesVerticesCurrent);
@@ -2672,84 +2372,13 @@ bool Mesh::lockSurfaceBoundaries(int neighbourIterations, StaticVectorBool& out_
 
 bool Mesh::getSurfaceBoundaries(StaticVectorBool& out_trisToConsider, bool invert) const
 {
-    // Edge struct
-    struct Edge
-    {
-      int first;  // min vertex index
-      int second; // max vertex index
-      int triId;  // triangle index
-
-      Edge() : first(0), second(0), triId(0)
-      {}
-
-      Edge(int vertexId1, int vertexId2, int triangleId) : triId(triangleId)
-      {
-        first  = std::min(vertexId1, vertexId2);
-        second = std::max(vertexId1, vertexId2);
-      }
-    };
-
-    // qSort lambda for Edge structure
-    auto qSortCompareEdgeAsc = [] (const void* ia, const void* ib)
-    {
-        const Edge a = *(Edge*)ia;
-        const Edge b = *(Edge*)ib;
-
-        if(a.first < b.first)
-            return -1;
-        else if(a.first == b.first)
-            return (a.second < b.second) ? -1 : 1;
-        return 1;
-    };
-
     ALICEVISION_LOG_INFO("Get surface " << (invert? "inner part" : "boundaries") << ".");
 
-    StaticVectorBool boundariesEdges(tris.size() * 3, false);
-
-    // Get all edges
-    StaticVector<Edge> edges(tris.size() * 3);
+    const std::shared_ptr<const MeshConnectivity> connectivity = getConnectivity();
 
-    #pragma omp parallel for
-    for(int i = 0; i < tris.size(); ++i)
-    {
-      const int edgeStartIndex = i * 3;
-      const Mesh::triangle& t = tris[i];
-
-      edges[edgeStartIndex] = Edge(t.v[0], t.v[1], i);
-      edges[edgeStartIndex + 1] = Edge(t.v[1], t.v[2], i);
-      edges[edgeStartIndex + 2] = Edge(t.v[2], t.v[0], i);
-    }
-
-    // Sort edges by vertex indexes
-    qsort(&edges[0], edges.size(), sizeof(Edge), qSortCompareEdgeAsc);
-
-    // Count edge, set is on boundary
-    int lastEdgeFirst = edges[0].first;
-    int lastEdgeSecond = edges[0].second;
-    int edgeCount = 0;
     bool boundary = false;
-
-    for(int i = 0; i < edges.size(); ++i)
-    {
-      const Edge& edge = edges[i];
-
-      if((edge.first == lastEdgeFirst) && (edge.second == lastEdgeSecond))
-      {
-         ++edgeCount;
-      }
-      else
-      {
-         if(edgeCount < 2)
-         {
-           boundariesEdges[i-1] = true;
-           boundary = true;
-         }
-
-         lastEdgeFirst = edge.first;
-         lastEdgeSecond = edge.second;
-         edgeCount = 1;
-      }
-    }
+    for(int i = 0; i < connectivity->getNbEdges() && !boundary; ++i)
+        boundary = connectivity->isBoundaryEdge(i);
 
     // Return false if no boundary
     if(!boundary)
@@ -2761,16 +2390,17 @@ bool Mesh::getSurfaceBoundaries(StaticVectorBool& out_trisToConsider, bool inver
     // Create output vectors
     out_trisToConsider.resize(tris.size(), false);
 
-    // Surface triangles
+    // Surface triangles: with an edge on the boundary (or not if invert)
     #pragma omp parallel for
-    for(int i = 0; i < edges.size(); ++i)
+    for(int triId = 0; triId < tris.size(); ++triId)
     {
-        Edge& edge = edges[i];
-
-        if(boundariesEdges[i] == !invert)
+        for(int k = 0; k < 3; ++k)
         {
-            #pragma OMP_ATOMIC_WRITE
-            out_trisToConsider[edge.triId] = true;
+            if(connectivity->isBoundaryEdge(connectivity->getTriEdge(triId, k)) == !invert)
+            {
+                out_trisToConsider[triId] = true;
+                break;
+            }
         }
     }
 
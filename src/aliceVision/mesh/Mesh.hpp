@@ -16,9 +16,15 @@
 
 #include <geogram/points/kd_tree.h>
 
+#include <memory>
+#include <mutex>
+
 namespace aliceVision {
 namespace mesh {
 
+class MeshBVH;
+class MeshConnectivity;
+
 using PointVisibility = StaticVector<int>;
 using PointsVisibility = StaticVector<PointVisibility>;
 
@@ -125,15 +131,55 @@ public:
     StaticVector<Voxel> trisNormalsIds;
     PointsVisibility pointsVisibilities;
 
+    /// Supported mesh file formats
+    enum class EFileType
+    {
+        OBJ,    ///< Wavefront OBJ (ascii)
+        PLY,    ///< Stanford PLY (read: ascii and binary, write: binary)
+        NATIVE, ///< AliceVision binary format (.avmesh), memory-mapped when loading
+        UNKNOWN
+    };
+
     Mesh();
     ~Mesh();
 
-    void saveToObj(const std::string& filename);
+    /// File format of a mesh file from its extension
+    static EFileType getFileType(const std::string& filepath);
+
+    /**
+     * @brief Load a mesh file in any supported format (from its extension)
+     * @return false if the file can't be read or if the mesh is empty,
+     *         except for the native format which loads the files of empty meshes
+     */
+    bool load(const std::string& filepath);
+
+    /**
+     * @brief Save the mesh in any supported format (from the file extension).
+     * Only the OBJ format saves the vertex colors without the visibilities,
+     * PLY and native formats save both.
+     */
+    bool save(const std::string& filepath) const;
+
+    bool saveToObj(const std::string& filename) const;
 
     bool loadFromBin(const std::string& binFileName);
     void saveToBin(const std::string& binFileName);
+    /// Parse an OBJ file by chunks of lines in parallel (materials, uv coordinates and normals included)
     bool loadFromObjAscii(const std::string& objAsciiFileName);
 
+    /// Save the vertices (with colors and visibilities) and the triangles in a binary PLY file
+    bool saveToPly(const std::string& filepath) const;
+    /// Load an ascii or binary PLY file (polygons are triangulated, vertex colors and visibilities are loaded if any)
+    bool loadFromPly(const std::string& filepath);
+
+    /**
+     * @brief Save the vertices, colors, visibilities and triangles in the native binary format:
+     * a versioned header followed by 8-byte aligned arrays that are copied as is when loading.
+     * An empty mesh is a valid native file (e.g. an empty cell of a partitioned reconstruction).
+     */
+    bool saveToNative(const std::string& filepath) const;
+    bool loadFromNative(const std::string& filepath);
+
     void addMesh(const Mesh& mesh);
 
     void getTrisMap(StaticVector<StaticVector<int>>& out, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w, int h);
@@ -148,9 +194,40 @@ public:
     const std::vector<int>& trisMtlIds() const { return _trisMtlIds; }
     std::vector<int>& trisMtlIds() { return _trisMtlIds; }
 
+    /**
+     * @brief Depth map of the mesh seen from the camera rc, see the overload taking a BVH (which is built here)
+     */
     void getDepthMap(StaticVector<float>& depthMap, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w, int h);
+    /**
+     * @brief Depth map from the triangles rasterized in each pixel (tmp): for each triangle overlapping the pixel footprint,
+     *        the farthest distance to the camera center of its part inside the footprint, minimal over the triangles
+     */
     void getDepthMap(StaticVector<float>& depthMap, StaticVector<StaticVector<int>>& tmp, const mvsUtils::MultiViewParams& mp, int rc,
                      int scale, int w, int h);
+    /**
+     * @brief Depth map (distance to the camera center) of the mesh seen from the camera rc,
+     *        by casting a single ray through the center of each pixel (-1 where no triangle is hit).
+     * @note Unlike the rasterized depth map, a pixel only partially covered by the mesh has no depth
+     *       when its center is not covered, and the depth is the distance of the first triangle hit at the pixel center
+     *       (x + 0.5, y + 0.5) rather than an extremum over the pixel footprint.
+     * @param[in] bvh the BVH of this mesh
+     */
+    void getDepthMap(StaticVector<float>& depthMap, const MeshBVH& bvh, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w,
+                     int h) const;
+
+    /**
+     * @brief Get the connectivity of the mesh (vertex/edge/triangle adjacency).
+     *        It is built on the first call and cached until invalidateConnectivity is called.
+     * @note Concurrent calls are safe (the cache update is locked).
+     *       The returned connectivity stays valid after an invalidation, but describes the former topology.
+     */
+    std::shared_ptr<const MeshConnectivity> getConnectivity() const;
+
+    /**
+     * @brief Drop the cached connectivity.
+     *        Called by the methods changing the topology; to call after editing tris or the number of pts directly.
+     */
+    void invalidateConnectivity();
 
     void getPtsNeighbors(std::vector<std::vector<int>>& out_ptsNeighTris) const;
     void getPtsNeighborTriangles(StaticVector<StaticVector<int>>& out_ptsNeighTris) const;
@@ -164,6 +241,12 @@ public:
                                                   int h);
     void getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, StaticVector<float>& depthMap, const mvsUtils::MultiViewParams& mp, int rc, int w,
                                                   int h);
+    /**
+     * @brief Triangles seen by the camera rc: the first triangle hit by the ray through the center of each pixel
+     * @param[in] bvh the BVH of this mesh
+     */
+    void getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, const MeshBVH& bvh, const mvsUtils::MultiViewParams& mp, int rc, int w,
+                                    int h) const;
 
     void generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, Mesh& outMesh, StaticVector<int>& out_ptIdToNewPtId) const;
 
@@ -265,7 +348,26 @@ public:
     */
     bool getSurfaceBoundaries(StaticVectorBool& out_trisToConsider, bool invert = false) const;
 
+private:
+    /// Cached connectivity
+    struct ConnectivityCache
+    {
+        mutable std::mutex mutex;
+        std::shared_ptr<const MeshConnectivity> connectivity;
 
+        ConnectivityCache() = default;
+        ConnectivityCache(const ConnectivityCache& other) { *this = other; }
+        ConnectivityCache& operator=(const ConnectivityCache& other)
+        {
+            if(this != &other)
+            {
+                std::lock_guard<std::mutex> lock(other.mutex);
+                connectivity = other.connectivity;
+            }
+            return *this;
+        }
+    };
+    mutable ConnectivityCache _connectivityCache;
 };
 
 } // namespace mesh
@@ -0,0 +1,679 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshBVH.hpp"
+#include "Mesh.hpp"
+
+#include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#endif
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// above this depth, the nodes are split at the median to bound the depth of the tree (and the traversal stack)
+const int maxSAHDepth = 64;
+const int traversalStackSize = 128;
+
+inline float surfaceArea(const float boundsMin[3], const float boundsMax[3])
+{
+    const float dx = boundsMax[0] - boundsMin[0];
+    const float dy = boundsMax[1] - boundsMin[1];
+    const float dz = boundsMax[2] - boundsMin[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+inline void resetBounds(float boundsMin[3], float boundsMax[3])
+{
+    for(int k = 0; k < 3; ++k)
+    {
+        boundsMin[k] = std::numeric_limits<float>::max();
+        boundsMax[k] = -std::numeric_limits<float>::max();
+    }
+}
+
+inline void growBounds(float boundsMin[3], float boundsMax[3], const float otherMin[3], const float otherMax[3])
+{
+    for(int k = 0; k < 3; ++k)
+    {
+        boundsMin[k] = std::min(boundsMin[k], otherMin[k]);
+        boundsMax[k] = std::max(boundsMax[k], otherMax[k]);
+    }
+}
+
+/// squared distance between a point and a box
+inline double boxDistance2(const float boundsMin[3], const float boundsMax[3], const double point[3])
+{
+    double distance2 = 0.0;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const double d = std::max(0.0, std::max(boundsMin[axis] - point[axis], point[axis] - boundsMax[axis]));
+        distance2 += d * d;
+    }
+    return distance2;
+}
+
+/// inverse of the direction components, avoiding infinities on axis-aligned rays
+inline float safeInverse(float value)
+{
+    const float minValue = 1e-20f;
+    if(std::abs(value) < minValue)
+        return value < 0.0f ? -1.0f / minValue : 1.0f / minValue;
+    return 1.0f / value;
+}
+
+} // namespace
+
+MeshBVH::MeshBVH(const Mesh& mesh, int maxLeafSize)
+{
+    maxLeafSize = std::max(1, std::min(maxLeafSize, 255));
+
+    const int nbTriangles = mesh.tris.size();
+    std::vector<BuildTriangle> buildTriangles(nbTriangles);
+
+    // Local origin of the single precision coordinates
+    if(!mesh.pts.empty())
+    {
+        Point3d pointsMin = mesh.pts[0];
+        Point3d pointsMax = mesh.pts[0];
+        for(const Point3d& p : mesh.pts)
+        {
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                pointsMin.m[axis] = std::min(pointsMin.m[axis], p.m[axis]);
+                pointsMax.m[axis] = std::max(pointsMax.m[axis], p.m[axis]);
+            }
+        }
+        _origin = (pointsMin + pointsMax) / 2.0;
+    }
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTriangles; ++i)
+    {
+        BuildTriangle& buildTriangle = buildTriangles[i];
+        buildTriangle.index = i;
+        resetBounds(buildTriangle.boundsMin, buildTriangle.boundsMax);
+        for(int k = 0; k < 3; ++k)
+        {
+            const Point3d p = mesh.pts[mesh.tris[i].v[k]] - _origin;
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                buildTriangle.boundsMin[axis] = std::min(buildTriangle.boundsMin[axis], float(p.m[axis]));
+                buildTriangle.boundsMax[axis] = std::max(buildTriangle.boundsMax[axis], float(p.m[axis]));
+            }
+        }
+        for(int axis = 0; axis < 3; ++axis)
+            buildTriangle.centroid[axis] = 0.5f * (buildTriangle.boundsMin[axis] + buildTriangle.boundsMax[axis]);
+    }
+
+    if(nbTriangles == 0)
+        return;
+
+    _nodes.reserve(2 * (nbTriangles / maxLeafSize + 1));
+    build(buildTriangles, 0, nbTriangles, maxLeafSize, 0);
+
+    // Store the triangles in the leaves order
+    _triangles.resize(nbTriangles);
+    _trianglesIndex.resize(nbTriangles);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTriangles; ++i)
+    {
+        const int index = buildTriangles[i].index;
+        const Point3d& a = mesh.pts[mesh.tris[index].v[0]];
+        const Point3d& b = mesh.pts[mesh.tris[index].v[1]];
+        const Point3d& c = mesh.pts[mesh.tris[index].v[2]];
+
+        Triangle& triangle = _triangles[i];
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            triangle.v0[axis] = float(a.m[axis] - _origin.m[axis]);
+            triangle.edge1[axis] = float(b.m[axis] - a.m[axis]);
+            triangle.edge2[axis] = float(c.m[axis] - a.m[axis]);
+        }
+        _trianglesIndex[i] = index;
+    }
+}
+
+int MeshBVH::build(std::vector<BuildTriangle>& buildTriangles, int begin, int end, int maxLeafSize, int depth)
+{
+    const int nodeIndex = _nodes.size();
+    _nodes.emplace_back();
+
+    Node node;
+    float centroidsMin[3];
+    float centroidsMax[3];
+    resetBounds(node.boundsMin, node.boundsMax);
+    resetBounds(centroidsMin, centroidsMax);
+    for(int i = begin; i < end; ++i)
+    {
+        growBounds(node.boundsMin, node.boundsMax, buildTriangles[i].boundsMin, buildTriangles[i].boundsMax);
+        growBounds(centroidsMin, centroidsMax, buildTriangles[i].centroid, buildTriangles[i].centroid);
+    }
+
+    const int count = end - begin;
+    if(count <= maxLeafSize)
+    {
+        node.offset = begin;
+        node.count = count;
+        node.axis = 0;
+        _nodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    // Split along the largest extent of the centroids
+    int axis = 0;
+    for(int k = 1; k < 3; ++k)
+    {
+        if(centroidsMax[k] - centroidsMin[k] > centroidsMax[axis] - centroidsMin[axis])
+            axis = k;
+    }
+    const float extent = centroidsMax[axis] - centroidsMin[axis];
+
+    int middle = begin + count / 2;
+    if(extent <= 0.0f || depth >= maxSAHDepth)
+    {
+        // All centroids are equal (or the tree is too deep): median split
+        std::nth_element(buildTriangles.begin() + begin, buildTriangles.begin() + middle, buildTriangles.begin() + end,
+                         [axis](const BuildTriangle& a, const BuildTriangle& b) { return a.centroid[axis] < b.centroid[axis]; });
+    }
+    else
+    {
+        // Binned surface area heuristic
+        const int nbBins = 16;
+        struct Bin
+        {
+            float boundsMin[3];
+            float boundsMax[3];
+            int count = 0;
+        };
+        Bin bins[nbBins];
+        for(Bin& bin : bins)
+            resetBounds(bin.boundsMin, bin.boundsMax);
+
+        const float binScale = nbBins / extent;
+        const auto getBin = [&](const BuildTriangle& buildTriangle) {
+            return std::min(nbBins - 1, int((buildTriangle.centroid[axis] - centroidsMin[axis]) * binScale));
+        };
+
+        for(int i = begin; i < end; ++i)
+        {
+            Bin& bin = bins[getBin(buildTriangles[i])];
+            ++bin.count;
+            growBounds(bin.boundsMin, bin.boundsMax, buildTriangles[i].boundsMin, buildTriangles[i].boundsMax);
+        }
+
+        // Cost of the triangles on the right of each split
+        float rightCosts[nbBins];
+        {
+            float boundsMin[3];
+            float boundsMax[3];
+            resetBounds(boundsMin, boundsMax);
+            int rightCount = 0;
+            for(int b = nbBins - 1; b > 0; --b)
+            {
+                growBounds(boundsMin, boundsMax, bins[b].boundsMin, bins[b].boundsMax);
+                rightCount += bins[b].count;
+                rightCosts[b] = rightCount ? rightCount * surfaceArea(boundsMin, boundsMax) : 0.0f;
+            }
+        }
+
+        int bestSplit = -1;
+        float bestCost = std::numeric_limits<float>::max();
+        {
+            float boundsMin[3];
+            float boundsMax[3];
+            resetBounds(boundsMin, boundsMax);
+            int leftCount = 0;
+            for(int b = 0; b < nbBins - 1; ++b)
+            {
+                growBounds(boundsMin, boundsMax, bins[b].boundsMin, bins[b].boundsMax);
+                leftCount += bins[b].count;
+                if(leftCount == 0 || leftCount == count)
+                    continue;
+                const float cost = leftCount * surfaceArea(boundsMin, boundsMax) + rightCosts[b + 1];
+                if(cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        // extent > 0 so the first and last bins are not empty
+        const auto itMiddle = std::partition(buildTriangles.begin() + begin, buildTriangles.begin() + end,
+                                             [&](const BuildTriangle& buildTriangle) { return getBin(buildTriangle) <= bestSplit; });
+        middle = int(itMiddle - buildTriangles.begin());
+    }
+
+    build(buildTriangles, begin, middle, maxLeafSize, depth + 1);
+    node.offset = build(buildTriangles, middle, end, maxLeafSize, depth + 1);
+    node.count = 0;
+    node.axis = axis;
+    _nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+inline float MeshBVH::intersectTriangle(const Triangle& triangle, const float origin[3], const float direction[3],
+                                        float& u, float& v)
+{
+    const float* e1 = triangle.edge1;
+    const float* e2 = triangle.edge2;
+
+    const float p[3] = {direction[1] * e2[2] - direction[2] * e2[1],
+                        direction[2] * e2[0] - direction[0] * e2[2],
+                        direction[0] * e2[1] - direction[1] * e2[0]};
+    const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if(det == 0.0f)
+        return -1.0f;
+
+    const float invDet = 1.0f / det;
+    const float s[3] = {origin[0] - triangle.v0[0], origin[1] - triangle.v0[1], origin[2] - triangle.v0[2]};
+    u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+    if(!(u >= 0.0f && u <= 1.0f))
+        return -1.0f;
+
+    const float q[3] = {s[1] * e1[2] - s[2] * e1[1],
+                        s[2] * e1[0] - s[0] * e1[2],
+                        s[0] * e1[1] - s[1] * e1[0]};
+    v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * invDet;
+    if(!(v >= 0.0f && u + v <= 1.0f))
+        return -1.0f;
+
+    return (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+}
+
+inline double MeshBVH::nearestTriangle(const Triangle& triangle, const double point[3], double closest[3])
+{
+    // Closest point on a triangle, from Real-Time Collision Detection (C. Ericson), with a = v0, b = v0 + edge1, c = v0 + edge2
+    double a[3], ab[3], ac[3], ap[3];
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        a[axis] = triangle.v0[axis];
+        ab[axis] = triangle.edge1[axis];
+        ac[axis] = triangle.edge2[axis];
+        ap[axis] = point[axis] - a[axis];
+    }
+    const auto dot = [](const double x[3], const double y[3]) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+
+    const double abab = dot(ab, ab);
+    const double abac = dot(ab, ac);
+    const double acac = dot(ac, ac);
+    const double d1 = dot(ab, ap);
+    const double d2 = dot(ac, ap);
+    // dot products with b - p and c - p
+    const double d3 = d1 - abab;
+    const double d4 = d2 - abac;
+    const double d5 = d1 - abac;
+    const double d6 = d2 - acac;
+
+    // barycentric coordinates of the closest point relative to b and c
+    double v = 0.0;
+    double w = 0.0;
+    const double vc = d1 * d4 - d3 * d2;
+    const double vb = d5 * d2 - d1 * d6;
+    const double va = d3 * d6 - d5 * d4;
+
+    if(d1 <= 0.0 && d2 <= 0.0)
+    {
+        // vertex a
+    }
+    else if(d3 >= 0.0 && d4 <= d3)
+    {
+        v = 1.0;
+    }
+    else if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        v = d1 / (d1 - d3);
+    }
+    else if(d6 >= 0.0 && d5 <= d6)
+    {
+        w = 1.0;
+    }
+    else if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        w = d2 / (d2 - d6);
+    }
+    else if(va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+    {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        v = 1.0 - w;
+    }
+    else
+    {
+        const double denom = va + vb + vc;
+        if(denom <= 0.0)
+        {
+            // degenerate triangle, covered by the edge cases above up to rounding
+            v = 0.0;
+            w = 0.0;
+        }
+        else
+        {
+            v = vb / denom;
+            w = vc / denom;
+        }
+    }
+
+    double distance2 = 0.0;
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        closest[axis] = a[axis] + v * ab[axis] + w * ac[axis];
+        const double d = point[axis] - closest[axis];
+        distance2 += d * d;
+    }
+    return distance2;
+}
+
+bool MeshBVH::nearest(const Point3d& point, Nearest& nearest, double maxDistance2) const
+{
+    nearest = Nearest();
+    if(_nodes.empty())
+        return false;
+
+    const double p[3] = {point.x - _origin.x, point.y - _origin.y, point.z - _origin.z};
+    double bestDistance2 = maxDistance2;
+
+    struct StackEntry
+    {
+        int nodeIndex;
+        double distance2;
+    };
+    StackEntry stack[traversalStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = {0, boxDistance2(_nodes[0].boundsMin, _nodes[0].boundsMax, p)};
+
+    while(stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        if(entry.distance2 >= bestDistance2)
+            continue;
+
+        const Node& node = _nodes[entry.nodeIndex];
+        if(node.count > 0)
+        {
+            for(int i = node.offset; i < node.offset + node.count; ++i)
+            {
+                double closest[3];
+                const double distance2 = nearestTriangle(_triangles[i], p, closest);
+                if(distance2 < bestDistance2)
+                {
+                    bestDistance2 = distance2;
+                    nearest.triangle = _trianglesIndex[i];
+                    nearest.distance2 = distance2;
+                    nearest.point = Point3d(closest[0], closest[1], closest[2]) + _origin;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearest child first
+        const int leftIndex = entry.nodeIndex + 1;
+        const int rightIndex = node.offset;
+        const double leftDistance2 = boxDistance2(_nodes[leftIndex].boundsMin, _nodes[leftIndex].boundsMax, p);
+        const double rightDistance2 = boxDistance2(_nodes[rightIndex].boundsMin, _nodes[rightIndex].boundsMax, p);
+        if(leftDistance2 < rightDistance2)
+        {
+            stack[stackSize++] = {rightIndex, rightDistance2};
+            stack[stackSize++] = {leftIndex, leftDistance2};
+        }
+        else
+        {
+            stack[stackSize++] = {leftIndex, leftDistance2};
+            stack[stackSize++] = {rightIndex, rightDistance2};
+        }
+    }
+
+    return nearest.triangle >= 0;
+}
+
+bool MeshBVH::intersect(const Point3d& origin, const Point3d& direction, Hit& hit, float tMax) const
+{
+    hit = Hit();
+    if(_nodes.empty())
+        return false;
+
+    const float o[3] = {float(origin.x - _origin.x), float(origin.y - _origin.y), float(origin.z - _origin.z)};
+    const float d[3] = {float(direction.x), float(direction.y), float(direction.z)};
+    const float invD[3] = {safeInverse(d[0]), safeInverse(d[1]), safeInverse(d[2])};
+
+    float tBest = tMax;
+    int stack[traversalStackSize];
+    int stackSize = 0;
+    int nodeIndex = 0;
+
+    while(true)
+    {
+        const Node& node = _nodes[nodeIndex];
+
+        // Slab test
+        float tNear = 0.0f;
+        float tFar = tBest;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (node.boundsMin[axis] - o[axis]) * invD[axis];
+            float t1 = (node.boundsMax[axis] - o[axis]) * invD[axis];
+            if(t0 > t1)
+                std::swap(t0, t1);
+            tNear = std::max(tNear, t0);
+            tFar = std::min(tFar, t1);
+        }
+
+        if(tNear <= tFar)
+        {
+            if(node.count > 0)
+            {
+                for(int i = node.offset; i < node.offset + node.count; ++i)
+                {
+                    float u, v;
+                    const float t = intersectTriangle(_triangles[i], o, d, u, v);
+                    if(t > 0.0f && t < tBest)
+                    {
+                        tBest = t;
+                        hit.triangle = _trianglesIndex[i];
+                        hit.t = t;
+                        hit.u = u;
+                        hit.v = v;
+                    }
+                }
+            }
+            else
+            {
+                // Visit the nearest child first
+                if(d[node.axis] < 0.0f)
+                {
+                    stack[stackSize++] = nodeIndex + 1;
+                    nodeIndex = node.offset;
+                }
+                else
+                {
+                    stack[stackSize++] = node.offset;
+                    nodeIndex = nodeIndex + 1;
+                }
+                continue;
+            }
+        }
+
+        if(stackSize == 0)
+            break;
+        nodeIndex = stack[--stackSize];
+    }
+
+    return hit.triangle >= 0;
+}
+
+int MeshBVH::intersect4(const Point3d origins[4], const Point3d directions[4], Hit hits[4], const float tMax[4]) const
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    for(int lane = 0; lane < 4; ++lane)
+        hits[lane] = Hit();
+
+    int firstLane = 0;
+    while(firstLane < 4 && !(tMax[firstLane] > 0.0f))
+        ++firstLane;
+
+    if(_nodes.empty() || firstLane == 4)
+        return 0;
+
+    // Rays as structure of arrays
+    float values[9][4];
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            values[axis][lane] = float(origins[lane].m[axis] - _origin.m[axis]);
+            values[3 + axis][lane] = float(directions[lane].m[axis]);
+            values[6 + axis][lane] = safeInverse(values[3 + axis][lane]);
+        }
+    }
+    __m128 o[3], d[3], invD[3];
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        o[axis] = _mm_loadu_ps(values[axis]);
+        d[axis] = _mm_loadu_ps(values[3 + axis]);
+        invD[axis] = _mm_loadu_ps(values[6 + axis]);
+    }
+
+    // Ignored rays have a negative maximal distance and never intersect a box
+    float tInit[4];
+    for(int lane = 0; lane < 4; ++lane)
+        tInit[lane] = tMax[lane] > 0.0f ? tMax[lane] : -1.0f;
+    __m128 tBest = _mm_loadu_ps(tInit);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    int stack[traversalStackSize];
+    int stackSize = 0;
+    int nodeIndex = 0;
+
+    while(true)
+    {
+        const Node& node = _nodes[nodeIndex];
+
+        // Slab test of the 4 rays
+        __m128 tNear = zero;
+        __m128 tFar = tBest;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[axis]), o[axis]), invD[axis]);
+            const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[axis]), o[axis]), invD[axis]);
+            tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+            tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+        }
+
+        if(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) != 0)
+        {
+            if(node.count > 0)
+            {
+                for(int i = node.offset; i < node.offset + node.count; ++i)
+                {
+                    // Moller-Trumbore on the 4 rays
+                    const Triangle& triangle = _triangles[i];
+                    const __m128 e1x = _mm_set1_ps(triangle.edge1[0]);
+                    const __m128 e1y = _mm_set1_ps(triangle.edge1[1]);
+                    const __m128 e1z = _mm_set1_ps(triangle.edge1[2]);
+                    const __m128 e2x = _mm_set1_ps(triangle.edge2[0]);
+                    const __m128 e2y = _mm_set1_ps(triangle.edge2[1]);
+                    const __m128 e2z = _mm_set1_ps(triangle.edge2[2]);
+
+                    const __m128 px = _mm_sub_ps(_mm_mul_ps(d[1], e2z), _mm_mul_ps(d[2], e2y));
+                    const __m128 py = _mm_sub_ps(_mm_mul_ps(d[2], e2x), _mm_mul_ps(d[0], e2z));
+                    const __m128 pz = _mm_sub_ps(_mm_mul_ps(d[0], e2y), _mm_mul_ps(d[1], e2x));
+                    const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+                    const __m128 invDet = _mm_div_ps(one, det);
+
+                    const __m128 sx = _mm_sub_ps(o[0], _mm_set1_ps(triangle.v0[0]));
+                    const __m128 sy = _mm_sub_ps(o[1], _mm_set1_ps(triangle.v0[1]));
+                    const __m128 sz = _mm_sub_ps(o[2], _mm_set1_ps(triangle.v0[2]));
+                    const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+                    const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+                    const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+                    const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+                    const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], qx), _mm_mul_ps(d[1], qy)), _mm_mul_ps(d[2], qz)), invDet);
+                    const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+                    // The comparisons are false for NaN values (degenerate triangles)
+                    __m128 valid = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+                    valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+                    valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, zero));
+                    valid = _mm_and_ps(valid, _mm_cmplt_ps(t, tBest));
+
+                    const int mask = _mm_movemask_ps(valid);
+                    if(mask == 0)
+                        continue;
+
+                    tBest = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, tBest));
+
+                    float tValues[4], uValues[4], vValues[4];
+                    _mm_storeu_ps(tValues, t);
+                    _mm_storeu_ps(uValues, u);
+                    _mm_storeu_ps(vValues, v);
+                    for(int lane = 0; lane < 4; ++lane)
+                    {
+                        if(mask & (1 << lane))
+                        {
+                            hits[lane].triangle = _trianglesIndex[i];
+                            hits[lane].t = tValues[lane];
+                            hits[lane].u = uValues[lane];
+                            hits[lane].v = vValues[lane];
+                        }
+                    }
+                }
+            }
+            else
+            {
+                // Visit the nearest child first (for the first ray, the packet is supposed to be coherent)
+                if(directions[firstLane].m[node.axis] < 0.0)
+                {
+                    stack[stackSize++] = nodeIndex + 1;
+                    nodeIndex = node.offset;
+                }
+                else
+                {
+                    stack[stackSize++] = node.offset;
+                    nodeIndex = nodeIndex + 1;
+                }
+                continue;
+            }
+        }
+
+        if(stackSize == 0)
+            break;
+        nodeIndex = stack[--stackSize];
+    }
+
+    int nbHits = 0;
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        if(hits[lane].triangle >= 0)
+            ++nbHits;
+    }
+    return nbHits;
+#else
+    int nbHits = 0;
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        if(tMax[lane] > 0.0f && intersect(origins[lane], directions[lane], hits[lane], tMax[lane]))
+            ++nbHits;
+        else
+            hits[lane] = Hit();
+    }
+    return nbHits;
+#endif
+}
+
+} // namespace mesh
+} // namespace aliceVision
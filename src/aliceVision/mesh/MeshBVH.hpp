@@ -0,0 +1,144 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+class Mesh;
+
+/**
+ * @brief Bounding volume hierarchy over the triangles of a mesh, for ray queries.
+ *
+ * The tree is built with the surface area heuristic (binned on the triangle centroids)
+ * and stored as a flat array of nodes in depth-first order (the left child follows its parent).
+ * Triangles are stored in the leaves order with their precomputed edges (single precision).
+ * The nodes and the triangles are expressed relative to the center of the mesh bounding box,
+ * so that the single precision is kept on georeferenced meshes (far from the coordinates origin).
+ * The queries are thread-safe.
+ */
+class MeshBVH
+{
+public:
+    /// Ray intersection
+    struct Hit
+    {
+        /// triangle index in the mesh (-1 if no intersection)
+        int triangle = -1;
+        /// distance along the ray direction
+        float t = std::numeric_limits<float>::max();
+        /// barycentric coordinates of the intersection (relative to the 2nd and 3rd vertices)
+        float u = 0.0f;
+        float v = 0.0f;
+    };
+
+    /// Closest point of the mesh
+    struct Nearest
+    {
+        /// triangle index in the mesh (-1 if no triangle)
+        int triangle = -1;
+        /// squared distance to the closest point
+        double distance2 = std::numeric_limits<double>::max();
+        /// closest point on the triangle
+        Point3d point;
+    };
+
+    /**
+     * @brief Build the BVH of the mesh triangles
+     * @param[in] mesh the mesh (only used during the construction)
+     * @param[in] maxLeafSize the maximum number of triangles per leaf
+     */
+    explicit MeshBVH(const Mesh& mesh, int maxLeafSize = 4);
+
+    /**
+     * @brief Closest intersection of the ray origin + t * direction, with t in ]0, tMax[
+     * @param[in] origin the ray origin
+     * @param[in] direction the ray direction (the distances are expressed in its length unit)
+     * @param[out] hit the closest intersection
+     * @param[in] tMax the maximal distance
+     * @return true if the ray intersects a triangle
+     */
+    bool intersect(const Point3d& origin, const Point3d& direction, Hit& hit,
+                   float tMax = std::numeric_limits<float>::max()) const;
+
+    /**
+     * @brief Closest intersections of a packet of 4 rays.
+     * The rays are traversed together, which is faster for coherent rays (e.g. neighbor pixels of a camera).
+     * @param[in] origins the ray origins
+     * @param[in] directions the ray directions
+     * @param[out] hits the closest intersection of each ray
+     * @param[in] tMax the maximal distance of each ray (a ray with tMax <= 0 is ignored)
+     * @return the number of rays intersecting a triangle
+     */
+    int intersect4(const Point3d origins[4], const Point3d directions[4], Hit hits[4], const float tMax[4]) const;
+
+    /**
+     * @brief Closest triangle of a point
+     * @param[in] point the query point
+     * @param[out] nearest the closest triangle and its closest point
+     * @param[in] maxDistance2 the maximal squared distance
+     * @return true if a triangle is closer than the maximal distance
+     */
+    bool nearest(const Point3d& point, Nearest& nearest, double maxDistance2 = std::numeric_limits<double>::max()) const;
+
+    /// Number of nodes of the tree
+    std::size_t getNbNodes() const { return _nodes.size(); }
+
+private:
+    struct Node
+    {
+        float boundsMin[3];
+        float boundsMax[3];
+        /// inner node: index of the right child, leaf: index of the first triangle
+        std::int32_t offset;
+        /// number of triangles (0 for inner nodes)
+        std::uint16_t count;
+        /// split axis of inner nodes
+        std::uint16_t axis;
+    };
+
+    struct Triangle
+    {
+        float v0[3];
+        float edge1[3];
+        float edge2[3];
+    };
+
+    struct BuildTriangle
+    {
+        float boundsMin[3];
+        float boundsMax[3];
+        float centroid[3];
+        int index;
+    };
+
+    /// build the node of the triangles [begin, end[ and its children, returns the node index
+    int build(std::vector<BuildTriangle>& buildTriangles, int begin, int end, int maxLeafSize, int depth);
+
+    /// Moller-Trumbore ray/triangle intersection, returns the distance or a negative value
+    static inline float intersectTriangle(const Triangle& triangle, const float origin[3], const float direction[3],
+                                          float& u, float& v);
+
+    /// closest point of a triangle, returns the squared distance
+    static inline double nearestTriangle(const Triangle& triangle, const double point[3], double closest[3]);
+
+    /// center of the mesh bounding box, origin of the nodes and triangles coordinates
+    Point3d _origin;
+    std::vector<Node> _nodes;
+    std::vector<Triangle> _triangles;
+    /// mesh triangle index of each triangle
+    std::vector<int> _trianglesIndex;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,254 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshBVH.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#define BOOST_TEST_MODULE MeshBVH
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+/// A grid plane (z = 0) with a random triangle soup above it
+void buildMesh(mesh::Mesh& mesh, std::mt19937& generator)
+{
+    const int gridSize = 10;
+    for(int y = 0; y <= gridSize; ++y)
+        for(int x = 0; x <= gridSize; ++x)
+            mesh.pts.push_back(Point3d(x / double(gridSize), y / double(gridSize), 0.0));
+    for(int y = 0; y < gridSize; ++y)
+    {
+        for(int x = 0; x < gridSize; ++x)
+        {
+            const int v = y * (gridSize + 1) + x;
+            mesh.tris.push_back(mesh::Mesh::triangle(v, v + 1, v + gridSize + 2));
+            mesh.tris.push_back(mesh::Mesh::triangle(v, v + gridSize + 2, v + gridSize + 1));
+        }
+    }
+
+    std::uniform_real_distribution<double> centerDistribution(0.0, 1.0);
+    std::uniform_real_distribution<double> offsetDistribution(-0.1, 0.1);
+    for(int i = 0; i < 300; ++i)
+    {
+        const Point3d center(centerDistribution(generator), centerDistribution(generator), 0.1 + 0.5 * centerDistribution(generator));
+        const int v = mesh.pts.size();
+        for(int k = 0; k < 3; ++k)
+            mesh.pts.push_back(center + Point3d(offsetDistribution(generator), offsetDistribution(generator), offsetDistribution(generator)));
+        mesh.tris.push_back(mesh::Mesh::triangle(v, v + 1, v + 2));
+    }
+}
+
+/// Brute force closest intersection (double precision Moller-Trumbore)
+int intersectBruteForce(const mesh::Mesh& mesh, const Point3d& origin, const Point3d& direction, double& tBest)
+{
+    int best = -1;
+    tBest = std::numeric_limits<double>::max();
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const Point3d& a = mesh.pts[mesh.tris[i].v[0]];
+        const Point3d e1 = mesh.pts[mesh.tris[i].v[1]] - a;
+        const Point3d e2 = mesh.pts[mesh.tris[i].v[2]] - a;
+        const Point3d p = cross(direction, e2);
+        const double det = dot(e1, p);
+        if(det == 0.0)
+            continue;
+        const Point3d s = origin - a;
+        const double u = dot(s, p) / det;
+        const Point3d q = cross(s, e1);
+        const double v = dot(direction, q) / det;
+        const double t = dot(e2, q) / det;
+        if(u >= 0.0 && v >= 0.0 && u + v <= 1.0 && t > 0.0 && t < tBest)
+        {
+            tBest = t;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/// Brute force closest triangle: minimal distance to the triangle plane inside the triangle, or to its edges
+double nearestBruteForce(const mesh::Mesh& mesh, const Point3d& point)
+{
+    const auto segmentDistance2 = [](const Point3d& p, const Point3d& a, const Point3d& b) {
+        const Point3d ab = b - a;
+        const double t = std::max(0.0, std::min(1.0, dot(p - a, ab) / dot(ab, ab)));
+        const Point3d d = p - (a + ab * t);
+        return dot(d, d);
+    };
+
+    double best = std::numeric_limits<double>::max();
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const Point3d& a = mesh.pts[mesh.tris[i].v[0]];
+        const Point3d& b = mesh.pts[mesh.tris[i].v[1]];
+        const Point3d& c = mesh.pts[mesh.tris[i].v[2]];
+        double distance2 = std::min(segmentDistance2(point, a, b), std::min(segmentDistance2(point, b, c), segmentDistance2(point, c, a)));
+
+        const Point3d n = cross(b - a, c - a);
+        const Point3d projected = point - n * (dot(point - a, n) / dot(n, n));
+        if(dot(cross(b - a, projected - a), n) >= 0.0 && dot(cross(c - b, projected - b), n) >= 0.0 &&
+           dot(cross(a - c, projected - c), n) >= 0.0)
+        {
+            const Point3d d = point - projected;
+            distance2 = std::min(distance2, dot(d, d));
+        }
+        best = std::min(best, distance2);
+    }
+    return best;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshBVH_intersect)
+{
+    std::mt19937 generator(42);
+    mesh::Mesh mesh;
+    buildMesh(mesh, generator);
+
+    const mesh::MeshBVH bvh(mesh);
+    BOOST_CHECK(bvh.getNbNodes() > 1);
+
+    // Rays from cameras above the mesh, looking down
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    int nbHits = 0;
+    for(int packet = 0; packet < 500; ++packet)
+    {
+        const Point3d center(distribution(generator), distribution(generator), 2.0 + distribution(generator));
+        Point3d origins[4];
+        Point3d directions[4];
+        float tMax[4];
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            origins[lane] = center;
+            const Point3d target(1.2 * distribution(generator) - 0.1, 1.2 * distribution(generator) - 0.1, 0.0);
+            directions[lane] = (target - center).normalize();
+            tMax[lane] = std::numeric_limits<float>::max();
+        }
+
+        mesh::MeshBVH::Hit hits4[4];
+        bvh.intersect4(origins, directions, hits4, tMax);
+
+        for(int lane = 0; lane < 4; ++lane)
+        {
+            double tReference;
+            const int reference = intersectBruteForce(mesh, origins[lane], directions[lane], tReference);
+
+            mesh::MeshBVH::Hit hit;
+            const bool intersect = bvh.intersect(origins[lane], directions[lane], hit);
+
+            BOOST_CHECK_EQUAL(intersect, reference >= 0);
+            BOOST_CHECK_EQUAL(hits4[lane].triangle, hit.triangle);
+            if(reference < 0)
+                continue;
+
+            ++nbHits;
+            // The depth is the distance to the ray origin along the normalized direction
+            BOOST_CHECK_SMALL(hit.t - tReference, 1e-4);
+            BOOST_CHECK_SMALL(hits4[lane].t - tReference, 1e-4);
+            // The same triangle, unless another one is hit at the same depth (shared edge)
+            if(hit.triangle != reference)
+                BOOST_CHECK_SMALL(hit.t - tReference, 1e-6);
+        }
+    }
+    BOOST_CHECK(nbHits > 1000);
+
+    // Ignored rays in a packet
+    {
+        const Point3d origins[4] = {Point3d(0.5, 0.5, 1.0), Point3d(0.5, 0.5, 1.0), Point3d(0.5, 0.5, 1.0), Point3d(0.5, 0.5, 1.0)};
+        const Point3d direction(0.0, 0.0, -1.0);
+        const Point3d directions[4] = {direction, direction, direction, direction};
+        const float tMax[4] = {10.0f, -1.0f, 0.5f, 10.0f};
+        mesh::MeshBVH::Hit hits[4];
+        BOOST_CHECK_EQUAL(bvh.intersect4(origins, directions, hits, tMax), 2);
+        BOOST_CHECK_EQUAL(hits[1].triangle, -1);
+        BOOST_CHECK_EQUAL(hits[2].triangle, -1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshBVH_nearest)
+{
+    std::mt19937 generator(7);
+    mesh::Mesh mesh;
+    buildMesh(mesh, generator);
+
+    const mesh::MeshBVH bvh(mesh);
+
+    std::uniform_real_distribution<double> distribution(-0.5, 1.5);
+    for(int i = 0; i < 1000; ++i)
+    {
+        const Point3d point(distribution(generator), distribution(generator), distribution(generator));
+
+        mesh::MeshBVH::Nearest nearest;
+        BOOST_REQUIRE(bvh.nearest(point, nearest));
+
+        const double reference = nearestBruteForce(mesh, point);
+        BOOST_CHECK_SMALL(nearest.distance2 - reference, 1e-6);
+
+        // The closest point is on the returned triangle
+        const Point3d d = point - nearest.point;
+        BOOST_CHECK_SMALL(dot(d, d) - nearest.distance2, 1e-9);
+        BOOST_CHECK_SMALL(nearestBruteForce(mesh, nearest.point), 1e-9);
+
+        // Nothing closer than the maximal distance
+        mesh::MeshBVH::Nearest bounded;
+        BOOST_CHECK(!bvh.nearest(point, bounded, 0.5 * reference));
+        BOOST_CHECK_EQUAL(bounded.triangle, -1);
+    }
+
+    // Empty mesh
+    const mesh::Mesh emptyMesh;
+    const mesh::MeshBVH emptyBVH(emptyMesh);
+    mesh::MeshBVH::Nearest nearest;
+    BOOST_CHECK(!emptyBVH.nearest(Point3d(0.0, 0.0, 0.0), nearest));
+    mesh::MeshBVH::Hit hit;
+    BOOST_CHECK(!emptyBVH.intersect(Point3d(0.0, 0.0, 0.0), Point3d(0.0, 0.0, 1.0), hit));
+}
+
+BOOST_AUTO_TEST_CASE(MeshBVH_georeferenced)
+{
+    std::mt19937 generator(11);
+    mesh::Mesh mesh;
+    buildMesh(mesh, generator);
+
+    // The same mesh in georeferenced coordinates: the float precision is 0.5 at 5e6
+    const Point3d offset(4.5e5, 5.2e6, 300.0);
+    mesh::Mesh georeferencedMesh = mesh;
+    for(Point3d& p : georeferencedMesh.pts)
+        p = p + offset;
+
+    const mesh::MeshBVH bvh(mesh);
+    const mesh::MeshBVH georeferencedBVH(georeferencedMesh);
+
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    for(int i = 0; i < 500; ++i)
+    {
+        const Point3d origin(distribution(generator), distribution(generator), 2.0);
+        const Point3d target(distribution(generator), distribution(generator), 0.0);
+        const Point3d direction = (target - origin).normalize();
+
+        mesh::MeshBVH::Hit hit;
+        mesh::MeshBVH::Hit georeferencedHit;
+        BOOST_REQUIRE(bvh.intersect(origin, direction, hit));
+        BOOST_REQUIRE(georeferencedBVH.intersect(origin + offset, direction, georeferencedHit));
+        BOOST_CHECK_SMALL(georeferencedHit.t - hit.t, 1e-4f);
+
+        const Point3d point = origin + Point3d(0.0, 0.0, -1.5 * distribution(generator));
+        mesh::MeshBVH::Nearest nearest;
+        mesh::MeshBVH::Nearest georeferencedNearest;
+        BOOST_REQUIRE(bvh.nearest(point, nearest));
+        BOOST_REQUIRE(georeferencedBVH.nearest(point + offset, georeferencedNearest));
+        BOOST_CHECK_SMALL(georeferencedNearest.distance2 - nearest.distance2, 1e-6);
+        const Point3d d = georeferencedNearest.point - offset - nearest.point;
+        BOOST_CHECK_SMALL(dot(d, d), 1e-9);
+    }
+}
@@ -261,6 +261,7 @@ int MeshClean::path::deployTriangles(StaticVector<int>& trisIds, bool isBoundary
     // add new pt to pts
     meshClean->pts.reserveAddIfNeeded(1, 1000);
     meshClean->pts.push_back(meshClean->pts[_ptId]);
+    meshClean->invalidateConnectivity();
     int newPtId = meshClean->pts.size() - 1;
 
     int origPtId = _ptId;
@@ -0,0 +1,155 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshConnectivity.hpp"
+#include "Mesh.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/**
+ * @brief Stable LSD radix sort of (key, value) pairs, with keys lower than maxKey.
+ * Each pass counts the digits of contiguous chunks in parallel and scatters the chunks in order.
+ */
+void radixSortPairs(std::vector<std::uint64_t>& keys, std::vector<int>& values, std::uint64_t maxKey)
+{
+    const int digitBits = 11;
+    const int nbBuckets = 1 << digitBits;
+    const int n = keys.size();
+
+    int nbBits = 0;
+    while(nbBits < 64 && (maxKey >> nbBits) != 0)
+        ++nbBits;
+
+    const int nbChunks = std::max(1, std::min(omp_get_max_threads(), n / 65536));
+    const int chunkSize = (n + nbChunks - 1) / nbChunks;
+
+    std::vector<std::uint64_t> keysTmp(n);
+    std::vector<int> valuesTmp(n);
+    std::vector<int> histograms(nbChunks * nbBuckets);
+
+    for(int shift = 0; shift < nbBits; shift += digitBits)
+    {
+        #pragma omp parallel for
+        for(int c = 0; c < nbChunks; ++c)
+        {
+            int* histogram = &histograms[c * nbBuckets];
+            std::fill(histogram, histogram + nbBuckets, 0);
+            const int end = std::min(n, (c + 1) * chunkSize);
+            for(int i = c * chunkSize; i < end; ++i)
+                ++histogram[(keys[i] >> shift) & (nbBuckets - 1)];
+        }
+
+        // Output position of each digit of each chunk
+        int offset = 0;
+        for(int b = 0; b < nbBuckets; ++b)
+        {
+            for(int c = 0; c < nbChunks; ++c)
+            {
+                const int count = histograms[c * nbBuckets + b];
+                histograms[c * nbBuckets + b] = offset;
+                offset += count;
+            }
+        }
+
+        #pragma omp parallel for
+        for(int c = 0; c < nbChunks; ++c)
+        {
+            int* histogram = &histograms[c * nbBuckets];
+            const int end = std::min(n, (c + 1) * chunkSize);
+            for(int i = c * chunkSize; i < end; ++i)
+            {
+                const int position = histogram[(keys[i] >> shift) & (nbBuckets - 1)]++;
+                keysTmp[position] = keys[i];
+                valuesTmp[position] = values[i];
+            }
+        }
+
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+} // namespace
+
+MeshConnectivity::MeshConnectivity(const Mesh& mesh)
+{
+    const int nbPts = mesh.pts.size();
+    const int nbCorners = mesh.tris.size() * 3;
+
+    std::vector<std::uint64_t> keys(nbCorners);
+    std::vector<int> values(nbCorners);
+
+    // Vertex -> triangles
+    #pragma omp parallel for
+    for(int i = 0; i < nbCorners; ++i)
+    {
+        keys[i] = mesh.tris[i / 3].v[i % 3];
+        values[i] = i / 3;
+    }
+
+    radixSortPairs(keys, values, nbPts);
+
+    _ptTrisOffsets.resize(nbPts + 1);
+    #pragma omp parallel for
+    for(int i = 0; i <= nbCorners; ++i)
+    {
+        const int previous = (i > 0) ? int(keys[i - 1]) : -1;
+        const int current = (i < nbCorners) ? int(keys[i]) : nbPts;
+        for(int ptId = previous + 1; ptId <= current; ++ptId)
+            _ptTrisOffsets[ptId] = i;
+    }
+    _ptTris.swap(values);
+
+    // Edges -> triangles, with the corner (triangle * 3 + k) of the edge (v[k], v[(k + 1) % 3]) as value
+    values.resize(nbCorners);
+    #pragma omp parallel for
+    for(int i = 0; i < nbCorners; ++i)
+    {
+        const Mesh::triangle& t = mesh.tris[i / 3];
+        const int a = t.v[i % 3];
+        const int b = t.v[(i + 1) % 3];
+        keys[i] = std::uint64_t(std::min(a, b)) * nbPts + std::max(a, b);
+        values[i] = i;
+    }
+
+    radixSortPairs(keys, values, std::uint64_t(nbPts) * nbPts);
+
+    _edgeTrisOffsets.clear();
+    _edgeTrisOffsets.reserve(nbCorners / 2 + 1);
+    for(int i = 0; i < nbCorners; ++i)
+    {
+        if(i == 0 || keys[i] != keys[i - 1])
+            _edgeTrisOffsets.push_back(i);
+    }
+    _edgeTrisOffsets.push_back(nbCorners);
+
+    const int nbEdges = int(_edgeTrisOffsets.size()) - 1;
+    _edges.resize(nbEdges);
+    _edgeTris.resize(nbCorners);
+    _trisEdges.resize(nbCorners);
+
+    #pragma omp parallel for
+    for(int edgeId = 0; edgeId < nbEdges; ++edgeId)
+    {
+        const int first = _edgeTrisOffsets[edgeId];
+        _edges[edgeId] = Pixel(int(keys[first] / nbPts), int(keys[first] % nbPts));
+        for(int i = first; i < _edgeTrisOffsets[edgeId + 1]; ++i)
+        {
+            _edgeTris[i] = values[i] / 3;
+            _trisEdges[values[i]] = edgeId;
+        }
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,68 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Pixel.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+class Mesh;
+
+/**
+ * @brief Compact (CSR) connectivity of a triangle mesh:
+ *        vertex -> triangles, undirected edges -> triangles and triangle -> edges.
+ *
+ * Edges are unique, sorted by (min vertex index, max vertex index).
+ * The triangles of a vertex or of an edge are sorted by index.
+ * Built in parallel with a radix sort of the vertex and edge keys.
+ */
+class MeshConnectivity
+{
+public:
+    explicit MeshConnectivity(const Mesh& mesh);
+
+    int getNbVertices() const { return int(_ptTrisOffsets.size()) - 1; }
+    int getNbEdges() const { return int(_edges.size()); }
+
+    /// Number of triangles using the vertex
+    int getNbPtTris(int ptId) const { return _ptTrisOffsets[ptId + 1] - _ptTrisOffsets[ptId]; }
+    /// Triangles using the vertex (getNbPtTris(ptId) values)
+    const int* getPtTris(int ptId) const { return _ptTris.data() + _ptTrisOffsets[ptId]; }
+
+    /// Vertices of the edge (x < y)
+    const Pixel& getEdge(int edgeId) const { return _edges[edgeId]; }
+    const std::vector<Pixel>& getEdges() const { return _edges; }
+    /// Number of triangles using the edge (1 on the surface boundaries, > 2 on non-manifold edges)
+    int getNbEdgeTris(int edgeId) const { return _edgeTrisOffsets[edgeId + 1] - _edgeTrisOffsets[edgeId]; }
+    /// Triangles using the edge (getNbEdgeTris(edgeId) values)
+    const int* getEdgeTris(int edgeId) const { return _edgeTris.data() + _edgeTrisOffsets[edgeId]; }
+    bool isBoundaryEdge(int edgeId) const { return getNbEdgeTris(edgeId) < 2; }
+
+    /**
+     * @brief Edge of a triangle
+     * @param[in] triId the triangle index
+     * @param[in] k the edge of the triangle: 0 for (v[0], v[1]), 1 for (v[1], v[2]), 2 for (v[2], v[0])
+     */
+    int getTriEdge(int triId, int k) const { return _trisEdges[triId * 3 + k]; }
+
+private:
+    std::vector<int> _ptTrisOffsets;
+    std::vector<int> _ptTris;
+
+    std::vector<Pixel> _edges;
+    std::vector<int> _edgeTrisOffsets;
+    std::vector<int> _edgeTris;
+
+    std::vector<int> _trisEdges;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,672 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshDecimate.hpp"
+#include "Mesh.hpp"
+#include "MeshConnectivity.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/// selection passes of the independent collapses of a round
+const int nbSelectionPasses = 3;
+
+/// Quadric error: weighted sum of the squared distances to a set of planes (symmetric 4x4 matrix)
+struct Quadric
+{
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+    double b2 = 0.0, bc = 0.0, bd = 0.0;
+    double c2 = 0.0, cd = 0.0;
+    double d2 = 0.0;
+
+    Quadric() = default;
+
+    /// quadric of the plane n.p + d = 0 (n normalized)
+    Quadric(const Point3d& n, double d, double w)
+        : a2(w * n.x * n.x), ab(w * n.x * n.y), ac(w * n.x * n.z), ad(w * n.x * d)
+        , b2(w * n.y * n.y), bc(w * n.y * n.z), bd(w * n.y * d)
+        , c2(w * n.z * n.z), cd(w * n.z * d)
+        , d2(w * d * d)
+    {}
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        return *this;
+    }
+
+    double evaluate(const Point3d& p) const
+    {
+        return a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x
+             + b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y
+             + c2 * p.z * p.z + 2.0 * cd * p.z
+             + d2;
+    }
+
+    /// position minimizing the error (Cramer's rule), false if the system is ill-conditioned
+    bool optimize(Point3d& p) const
+    {
+        const double det = a2 * (b2 * c2 - bc * bc) - ab * (ab * c2 - bc * ac) + ac * (ab * bc - b2 * ac);
+        const double scale = a2 + b2 + c2;
+        if(std::abs(det) <= 1e-9 * scale * scale * scale)
+            return false;
+        const double r0 = -ad;
+        const double r1 = -bd;
+        const double r2 = -cd;
+        p.x = (r0 * (b2 * c2 - bc * bc) - ab * (r1 * c2 - bc * r2) + ac * (r1 * bc - b2 * r2)) / det;
+        p.y = (a2 * (r1 * c2 - bc * r2) - r0 * (ab * c2 - bc * ac) + ac * (ab * r2 - r1 * ac)) / det;
+        p.z = (a2 * (b2 * r2 - r1 * bc) - ab * (ab * r2 - r1 * ac) + r0 * (ab * bc - b2 * ac)) / det;
+        return true;
+    }
+};
+
+/**
+ * @brief Ordering key of a collapse: cost bucket first, then a bijective hash of the edge index so that the keys are unique.
+ * The candidates of a round are only coarsely ordered (nbBuckets up to the round threshold): randomizing the order of
+ * similar costs avoids long chains of dependent collapses, which would only let a few collapses run per round.
+ */
+inline std::uint64_t getCollapseKey(float cost, float threshold, int edgeId)
+{
+    const int nbBuckets = 4;
+    const std::uint32_t bucket = (threshold > 0.0f) ? std::uint32_t(std::min(1.0f, cost / threshold) * (nbBuckets - 1) + 0.5f) : 0;
+    std::uint32_t hash = std::uint32_t(edgeId);
+    hash ^= hash >> 16;
+    hash *= 0x7feb352dU;
+    hash ^= hash >> 15;
+    hash *= 0x846ca68bU;
+    hash ^= hash >> 16;
+    return (std::uint64_t(bucket) << 32) | hash;
+}
+
+inline void atomicMin(std::atomic<std::uint64_t>& value, std::uint64_t candidate)
+{
+    std::uint64_t current = value.load(std::memory_order_relaxed);
+    while(candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+    {
+    }
+}
+
+class Decimator
+{
+public:
+    Decimator(Mesh& mesh, const DecimationParams& params)
+        : _mesh(mesh)
+        , _params(params)
+    {}
+
+    int run();
+
+private:
+    /// number of collapses left before reaching a target
+    int getNbCollapsesNeeded() const;
+    void computeQuadrics(const MeshConnectivity& connectivity);
+    void computeBoundaryVertices(const MeshConnectivity& connectivity);
+    /**
+     * @brief Cost and position of the collapse of an edge
+     * @return the collapse cost, infinity if the collapse is not allowed
+     */
+    float evaluateCollapse(const MeshConnectivity& connectivity, int edgeId, Point3d& position,
+                           std::vector<int>& neighborsA, std::vector<int>& neighborsB) const;
+    /// call f on the vertices of the triangles around the edge until it returns false
+    template <typename F>
+    bool forEachNeighborhoodVertex(const MeshConnectivity& connectivity, int edgeId, F f) const
+    {
+        const Pixel& edge = connectivity.getEdge(edgeId);
+        for(int ptId : {edge.x, edge.y})
+        {
+            const int* ptTris = connectivity.getPtTris(ptId);
+            for(int i = 0; i < connectivity.getNbPtTris(ptId); ++i)
+            {
+                const Mesh::triangle& t = _mesh.tris[ptTris[i]];
+                for(int k = 0; k < 3; ++k)
+                {
+                    if(!f(t.v[k]))
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+    /// collapse the edge on its first vertex (the triangles are only flagged as dead)
+    void collapse(const MeshConnectivity& connectivity, int edgeId, const Point3d& position);
+    /// remove the dead triangles and the removed vertices
+    void compact();
+
+    Mesh& _mesh;
+    const DecimationParams& _params;
+    std::vector<Quadric> _quadrics;
+    std::vector<char> _boundaryVertices;
+    std::vector<char> _removedVertices;
+};
+
+int Decimator::getNbCollapsesNeeded() const
+{
+    int needed = std::numeric_limits<int>::max();
+    if(_params.nbVertices > 0)
+        needed = std::min(needed, _mesh.pts.size() - _params.nbVertices);
+    if(_params.nbTriangles > 0)
+        needed = std::min(needed, (_mesh.tris.size() - _params.nbTriangles + 1) / 2); // 2 triangles per collapse
+    return needed;
+}
+
+void Decimator::computeQuadrics(const MeshConnectivity& connectivity)
+{
+    const int nbPts = _mesh.pts.size();
+    _quadrics.assign(nbPts, Quadric());
+
+    #pragma omp parallel for
+    for(int ptId = 0; ptId < nbPts; ++ptId)
+    {
+        Quadric& quadric = _quadrics[ptId];
+        const int* ptTris = connectivity.getPtTris(ptId);
+        for(int i = 0; i < connectivity.getNbPtTris(ptId); ++i)
+        {
+            const int triId = ptTris[i];
+            const Mesh::triangle& t = _mesh.tris[triId];
+            const Point3d& p0 = _mesh.pts[t.v[0]];
+            const Point3d n = cross(_mesh.pts[t.v[1]] - p0, _mesh.pts[t.v[2]] - p0);
+            const double length = n.size();
+            if(length <= 0.0)
+                continue;
+            const Point3d normal = n / length;
+            quadric += Quadric(normal, -dot(normal, p0), 1.0);
+
+            // planes orthogonal to the boundary edges keep the boundaries in place
+            for(int k = 0; k < 3; ++k)
+            {
+                const int edgeId = connectivity.getTriEdge(triId, k);
+                const Pixel& edge = connectivity.getEdge(edgeId);
+                if(!connectivity.isBoundaryEdge(edgeId) || (edge.x != ptId && edge.y != ptId))
+                    continue;
+                const Point3d& e0 = _mesh.pts[t.v[k]];
+                const Point3d& e1 = _mesh.pts[t.v[(k + 1) % 3]];
+                const Point3d m = cross(e1 - e0, normal);
+                const double mLength = m.size();
+                if(mLength > 0.0)
+                    quadric += Quadric(m / mLength, -dot(m, e0) / mLength, _params.boundaryWeight);
+            }
+        }
+    }
+}
+
+void Decimator::computeBoundaryVertices(const MeshConnectivity& connectivity)
+{
+    const int nbPts = _mesh.pts.size();
+    _boundaryVertices.assign(nbPts, 0);
+
+    #pragma omp parallel for
+    for(int ptId = 0; ptId < nbPts; ++ptId)
+    {
+        const int* ptTris = connectivity.getPtTris(ptId);
+        for(int i = 0; i < connectivity.getNbPtTris(ptId) && !_boundaryVertices[ptId]; ++i)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                const int edgeId = connectivity.getTriEdge(ptTris[i], k);
+                const Pixel& edge = connectivity.getEdge(edgeId);
+                if(connectivity.isBoundaryEdge(edgeId) && (edge.x == ptId || edge.y == ptId))
+                    _boundaryVertices[ptId] = 1;
+            }
+        }
+    }
+}
+
+float Decimator::evaluateCollapse(const MeshConnectivity& connectivity, int edgeId, Point3d& position,
+                                  std::vector<int>& neighborsA, std::vector<int>& neighborsB) const
+{
+    const float invalid = std::numeric_limits<float>::infinity();
+    const int nbEdgeTris = connectivity.getNbEdgeTris(edgeId);
+    if(nbEdgeTris > 2)
+        return invalid; // non-manifold edge
+
+    const int a = connectivity.getEdge(edgeId).x;
+    const int b = connectivity.getEdge(edgeId).y;
+    const bool boundaryA = _boundaryVertices[a];
+    const bool boundaryB = _boundaryVertices[b];
+    // an inner edge between two boundaries would pinch the surface
+    if(boundaryA && boundaryB && nbEdgeTris != 1)
+        return invalid;
+
+    // link condition: the common neighbors of a and b are the vertices opposite to the edge
+    const auto getNeighbors = [&](int ptId, std::vector<int>& neighbors) {
+        neighbors.clear();
+        const int* ptTris = connectivity.getPtTris(ptId);
+        for(int i = 0; i < connectivity.getNbPtTris(ptId); ++i)
+        {
+            const Mesh::triangle& t = _mesh.tris[ptTris[i]];
+            for(int k = 0; k < 3; ++k)
+            {
+                if(t.v[k] != a && t.v[k] != b)
+                    neighbors.push_back(t.v[k]);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    };
+    getNeighbors(a, neighborsA);
+    getNeighbors(b, neighborsB);
+    int nbCommonNeighbors = 0;
+    for(auto itA = neighborsA.begin(), itB = neighborsB.begin(); itA != neighborsA.end() && itB != neighborsB.end();)
+    {
+        if(*itA < *itB)
+            ++itA;
+        else if(*itB < *itA)
+            ++itB;
+        else
+        {
+            ++nbCommonNeighbors;
+            ++itA;
+            ++itB;
+        }
+    }
+    if(nbCommonNeighbors != nbEdgeTris)
+        return invalid;
+    // collapsing a tetrahedron would create duplicated triangles
+    if(neighborsA.size() <= 2 && neighborsB.size() <= 2)
+        return invalid;
+
+    // position: on the boundary vertex, or minimizing the error
+    Quadric quadric = _quadrics[a];
+    quadric += _quadrics[b];
+    const Point3d& pA = _mesh.pts[a];
+    const Point3d& pB = _mesh.pts[b];
+    if(boundaryA != boundaryB)
+    {
+        position = boundaryA ? pA : pB;
+    }
+    else
+    {
+        const Point3d middle = (pA + pB) * 0.5;
+        if(!quadric.optimize(position) || (position - middle).size2() > (pB - pA).size2())
+        {
+            // fallback on the best of the edge vertices and middle
+            position = middle;
+            double bestError = quadric.evaluate(middle);
+            for(const Point3d* p : {&pA, &pB})
+            {
+                const double error = quadric.evaluate(*p);
+                if(error < bestError)
+                {
+                    bestError = error;
+                    position = *p;
+                }
+            }
+        }
+    }
+
+    const double error = std::max(0.0, quadric.evaluate(position));
+    if(_params.maxError > 0.0 && error > _params.maxError * _params.maxError)
+        return invalid;
+
+    // reject the normal flips of the triangles moving with the collapse
+    for(int ptId : {a, b})
+    {
+        const int* ptTris = connectivity.getPtTris(ptId);
+        for(int i = 0; i < connectivity.getNbPtTris(ptId); ++i)
+        {
+            const Mesh::triangle& t = _mesh.tris[ptTris[i]];
+            Point3d p[3];
+            Point3d pNew[3];
+            bool isEdgeTriangle = false;
+            for(int k = 0; k < 3; ++k)
+            {
+                p[k] = _mesh.pts[t.v[k]];
+                pNew[k] = (t.v[k] == ptId) ? position : p[k];
+                isEdgeTriangle = isEdgeTriangle || (t.v[k] == (ptId == a ? b : a));
+            }
+            if(isEdgeTriangle)
+                continue; // removed by the collapse
+            const Point3d n = cross(p[1] - p[0], p[2] - p[0]);
+            const Point3d nNew = cross(pNew[1] - pNew[0], pNew[2] - pNew[0]);
+            const double lengths = std::sqrt(n.size2() * nNew.size2());
+            if(lengths <= 0.0 || dot(n, nNew) <= _params.minNormalCos * lengths)
+                return invalid;
+        }
+    }
+
+    return static_cast<float>(error);
+}
+
+void Decimator::collapse(const MeshConnectivity& connectivity, int edgeId, const Point3d& position)
+{
+    const int a = connectivity.getEdge(edgeId).x;
+    const int b = connectivity.getEdge(edgeId).y;
+
+    const int* ptTris = connectivity.getPtTris(b);
+    for(int i = 0; i < connectivity.getNbPtTris(b); ++i)
+    {
+        Mesh::triangle& t = _mesh.tris[ptTris[i]];
+        if(t.v[0] == a || t.v[1] == a || t.v[2] == a)
+        {
+            t.alive = false;
+            continue;
+        }
+        for(int k = 0; k < 3; ++k)
+        {
+            if(t.v[k] == b)
+                t.v[k] = a;
+        }
+    }
+
+    _mesh.pts[a] = position;
+    _quadrics[a] += _quadrics[b];
+    _boundaryVertices[a] = _boundaryVertices[a] || _boundaryVertices[b];
+    _removedVertices[b] = 1;
+
+    std::vector<rgb>& colors = _mesh.colors();
+    if(colors.size() == std::size_t(_mesh.pts.size()))
+    {
+        const rgb& cA = colors[a];
+        const rgb& cB = colors[b];
+        colors[a] = rgb((cA.r + cB.r + 1) / 2, (cA.g + cB.g + 1) / 2, (cA.b + cB.b + 1) / 2);
+    }
+
+    PointsVisibility& visibilities = _mesh.pointsVisibilities;
+    if(visibilities.size() == _mesh.pts.size())
+    {
+        PointVisibility& visA = visibilities[a];
+        const PointVisibility& visB = visibilities[b];
+        for(int i = 0; i < visB.size(); ++i)
+        {
+            if(visA.indexOf(visB[i]) < 0)
+                visA.push_back(visB[i]);
+        }
+    }
+}
+
+void Decimator::compact()
+{
+    // the collapses edited the triangles in place
+    _mesh.invalidateConnectivity();
+
+    std::vector<Mesh::triangle>& tris = _mesh.tris.getDataWritable();
+    tris.erase(std::remove_if(tris.begin(), tris.end(), [](const Mesh::triangle& t) { return !t.alive; }), tris.end());
+
+    const int nbPts = _mesh.pts.size();
+    std::vector<int> newIds(nbPts, -1);
+    int nbNewPts = 0;
+    for(int i = 0; i < nbPts; ++i)
+    {
+        if(!_removedVertices[i])
+            newIds[i] = nbNewPts++;
+    }
+    if(nbNewPts == nbPts)
+        return;
+
+    #pragma omp parallel for
+    for(int i = 0; i < int(tris.size()); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+            tris[i].v[k] = newIds[tris[i].v[k]];
+    }
+
+    std::vector<rgb>& colors = _mesh.colors();
+    const bool hasColors = (colors.size() == std::size_t(nbPts));
+    const bool hasVisibilities = (_mesh.pointsVisibilities.size() == nbPts);
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const int newId = newIds[i];
+        if(newId < 0 || newId == i)
+            continue;
+        _mesh.pts[newId] = _mesh.pts[i];
+        _quadrics[newId] = _quadrics[i];
+        _boundaryVertices[newId] = _boundaryVertices[i];
+        if(hasColors)
+            colors[newId] = colors[i];
+        if(hasVisibilities)
+            _mesh.pointsVisibilities[newId].swap(_mesh.pointsVisibilities[i]);
+    }
+    _mesh.pts.resize(nbNewPts);
+    _quadrics.resize(nbNewPts);
+    _boundaryVertices.resize(nbNewPts);
+    if(hasColors)
+        colors.resize(nbNewPts);
+    if(hasVisibilities)
+        _mesh.pointsVisibilities.resize(nbNewPts);
+}
+
+int Decimator::run()
+{
+    // dead triangles and data not preserved by the collapses
+    _removedVertices.assign(_mesh.pts.size(), 0);
+    compact();
+    _mesh.uvCoords = StaticVector<Point2d>();
+    _mesh.trisUvIds = StaticVector<Voxel>();
+    _mesh.normals = StaticVector<Point3d>();
+    _mesh.trisNormalsIds = StaticVector<Voxel>();
+    _mesh.trisMtlIds().clear();
+    _mesh.nmtls = 0;
+
+    int nbCollapses = 0;
+    bool firstRound = true;
+    std::vector<float> costs;
+    std::vector<float> validCosts;
+    std::vector<std::atomic<std::uint64_t>> claims;
+    std::vector<char> selected;
+    std::vector<char> taken;
+    std::vector<int> candidates;
+    std::vector<int> collapses;
+
+    while(true)
+    {
+        const int needed = getNbCollapsesNeeded();
+        if(needed <= 0)
+            break;
+
+        const MeshConnectivity connectivity(_mesh);
+        if(firstRound)
+            computeQuadrics(connectivity);
+        firstRound = false;
+        computeBoundaryVertices(connectivity);
+
+        const int nbEdges = connectivity.getNbEdges();
+        const int nbPts = _mesh.pts.size();
+        costs.resize(nbEdges);
+
+        #pragma omp parallel
+        {
+            std::vector<int> neighborsA;
+            std::vector<int> neighborsB;
+            Point3d position;
+
+            #pragma omp for schedule(dynamic, 4096)
+            for(int edgeId = 0; edgeId < nbEdges; ++edgeId)
+                costs[edgeId] = evaluateCollapse(connectivity, edgeId, position, neighborsA, neighborsB);
+        }
+
+        // the cheapest edges are the candidates of this round
+        validCosts.clear();
+        for(float cost : costs)
+        {
+            if(cost != std::numeric_limits<float>::infinity())
+                validCosts.push_back(cost);
+        }
+        if(validCosts.empty())
+            break;
+        const std::size_t nbCandidates = std::max<std::size_t>(1, std::min<std::size_t>(
+            std::size_t(needed) * 2, std::max<std::size_t>(1, std::size_t(validCosts.size() * _params.candidatesRatio))));
+        const std::size_t thresholdIndex = std::min(nbCandidates, validCosts.size()) - 1;
+        std::nth_element(validCosts.begin(), validCosts.begin() + thresholdIndex, validCosts.end());
+        const float threshold = validCosts[thresholdIndex];
+
+        candidates.clear();
+        for(int edgeId = 0; edgeId < nbEdges; ++edgeId)
+        {
+            if(costs[edgeId] <= threshold)
+                candidates.push_back(edgeId);
+        }
+
+        // each candidate claims the vertices of its neighborhood, the collapses holding all their claims are independent.
+        // The next passes select among the candidates whose neighborhood is still free.
+        claims = std::vector<std::atomic<std::uint64_t>>(nbPts);
+        taken.assign(nbPts, 0);
+        collapses.clear();
+        for(int pass = 0; pass < nbSelectionPasses && !candidates.empty(); ++pass)
+        {
+            const int nbCandidates = candidates.size();
+
+            #pragma omp parallel for
+            for(int ptId = 0; ptId < nbPts; ++ptId)
+                claims[ptId].store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+
+            #pragma omp parallel for schedule(dynamic, 4096)
+            for(int i = 0; i < nbCandidates; ++i)
+            {
+                const int edgeId = candidates[i];
+                const std::uint64_t key = getCollapseKey(costs[edgeId], threshold, edgeId);
+                forEachNeighborhoodVertex(connectivity, edgeId, [&](int ptId) {
+                    atomicMin(claims[ptId], key);
+                    return true;
+                });
+            }
+
+            selected.assign(nbCandidates, 0);
+            #pragma omp parallel for schedule(dynamic, 4096)
+            for(int i = 0; i < nbCandidates; ++i)
+            {
+                const int edgeId = candidates[i];
+                const std::uint64_t key = getCollapseKey(costs[edgeId], threshold, edgeId);
+                selected[i] = forEachNeighborhoodVertex(connectivity, edgeId, [&](int ptId) {
+                    return claims[ptId].load(std::memory_order_relaxed) == key;
+                });
+            }
+
+            // the neighborhoods of the selected collapses are disjoint
+            #pragma omp parallel for schedule(dynamic, 4096)
+            for(int i = 0; i < nbCandidates; ++i)
+            {
+                if(!selected[i])
+                    continue;
+                forEachNeighborhoodVertex(connectivity, candidates[i], [&](int ptId) {
+                    taken[ptId] = 1;
+                    return true;
+                });
+            }
+
+            const std::size_t nbPreviousCollapses = collapses.size();
+            std::size_t nbRemaining = 0;
+            for(int i = 0; i < nbCandidates; ++i)
+            {
+                if(selected[i])
+                    collapses.push_back(candidates[i]);
+                else
+                    candidates[nbRemaining++] = candidates[i];
+            }
+            candidates.resize(nbRemaining);
+            if(collapses.size() == nbPreviousCollapses)
+                break;
+
+            // drop the candidates touching a selected collapse
+            selected.assign(candidates.size(), 0);
+            #pragma omp parallel for schedule(dynamic, 4096)
+            for(int i = 0; i < int(candidates.size()); ++i)
+            {
+                selected[i] = forEachNeighborhoodVertex(connectivity, candidates[i], [&](int ptId) {
+                    return !taken[ptId];
+                });
+            }
+            nbRemaining = 0;
+            for(std::size_t i = 0; i < candidates.size(); ++i)
+            {
+                if(selected[i])
+                    candidates[nbRemaining++] = candidates[i];
+            }
+            candidates.resize(nbRemaining);
+        }
+
+        if(collapses.empty())
+            break;
+        if(collapses.size() > std::size_t(needed))
+        {
+            std::nth_element(collapses.begin(), collapses.begin() + needed, collapses.end(), [&](int e0, int e1) {
+                return costs[e0] < costs[e1] || (costs[e0] == costs[e1] && e0 < e1);
+            });
+            collapses.resize(needed);
+        }
+
+        // the neighborhoods are disjoint: the collapses are applied concurrently
+        _removedVertices.assign(nbPts, 0);
+        const int nbRoundCollapses = collapses.size();
+
+        #pragma omp parallel
+        {
+            std::vector<int> neighborsA;
+            std::vector<int> neighborsB;
+            Point3d position;
+
+            #pragma omp for schedule(dynamic, 1024)
+            for(int i = 0; i < nbRoundCollapses; ++i)
+            {
+                evaluateCollapse(connectivity, collapses[i], position, neighborsA, neighborsB);
+                collapse(connectivity, collapses[i], position);
+            }
+        }
+        compact();
+        nbCollapses += nbRoundCollapses;
+
+        ALICEVISION_LOG_DEBUG("Decimation: " << nbRoundCollapses << " collapses (max error: " << std::sqrt(threshold)
+                              << "), " << _mesh.pts.size() << " vertices and " << _mesh.tris.size() << " triangles.");
+    }
+    return nbCollapses;
+}
+
+} // namespace
+
+int decimateMesh(Mesh& mesh, const DecimationParams& params)
+{
+    if(params.nbVertices <= 0 && params.nbTriangles <= 0 && params.maxError <= 0.0)
+    {
+        ALICEVISION_LOG_WARNING("Mesh decimation: no target number of vertices or triangles and no maximal error.");
+        return 0;
+    }
+
+    ALICEVISION_LOG_INFO("Mesh decimation: " << mesh.pts.size() << " vertices and " << mesh.tris.size() << " triangles.");
+
+    // attributes not preserved by the collapses
+    std::string discarded;
+    if(!mesh.uvCoords.empty() || !mesh.trisUvIds.empty())
+        discarded += " uv coordinates,";
+    if(!mesh.normals.empty() || !mesh.trisNormalsIds.empty())
+        discarded += " normals,";
+    if(!mesh.trisMtlIds().empty() || mesh.nmtls > 0)
+        discarded += " materials,";
+    if(!discarded.empty())
+    {
+        discarded.pop_back();
+        ALICEVISION_LOG_WARNING("Mesh decimation: the input" << discarded << " are discarded.");
+    }
+
+    const std::size_t nbInputTris = mesh.tris.size();
+    const system::Timer timer;
+    Decimator decimator(mesh, params);
+    const int nbCollapses = decimator.run();
+    const double elapsed = timer.elapsed();
+
+    ALICEVISION_LOG_INFO("Mesh decimation done: " << nbCollapses << " collapses, " << mesh.pts.size() << " vertices and "
+                         << mesh.tris.size() << " triangles.");
+    ALICEVISION_LOG_INFO("Mesh decimation time: " << elapsed << " s (" << nbInputTris / std::max(elapsed, 1e-6) / 1e6
+                         << " M input triangles/s, " << omp_get_max_threads() << " threads).");
+    return nbCollapses;
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,46 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+namespace aliceVision {
+namespace mesh {
+
+class Mesh;
+
+struct DecimationParams
+{
+    /// target number of vertices (0 to ignore)
+    int nbVertices = 0;
+    /// target number of triangles (0 to ignore)
+    int nbTriangles = 0;
+    /// maximal collapse error, as a distance to the input surface planes (0 to ignore)
+    double maxError = 0.0;
+    /// weight of the planes keeping the surface boundaries in place, relative to the surface planes
+    double boundaryWeight = 100.0;
+    /// minimal cosine of the rotation of the triangle normals during a collapse
+    double minNormalCos = 0.0;
+    /// fraction of the cheapest edges considered at each collapse round
+    double candidatesRatio = 0.125;
+};
+
+/**
+ * @brief Quadric error metric decimation (Garland & Heckbert) of a triangle mesh, in parallel.
+ *
+ * The edges are collapsed by rounds: each round computes the cost of all the edges in parallel,
+ * selects among the cheapest ones a set of collapses with disjoint neighborhoods and applies them concurrently.
+ * The collapses keep the mesh manifold (link condition) and reject the normal flips.
+ * Vertex colors are averaged and point visibilities are merged, uv coordinates, normals and materials are removed.
+ * Stops when one of the targets (vertices, triangles) is reached or when no edge can be collapsed under maxError.
+ *
+ * @param[in,out] mesh the mesh to decimate
+ * @param[in] params the decimation targets and constraints
+ * @return the number of collapsed edges
+ */
+int decimateMesh(Mesh& mesh, const DecimationParams& params);
+
+} // namespace mesh
+} // namespace aliceVision
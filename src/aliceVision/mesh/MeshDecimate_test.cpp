@@ -0,0 +1,225 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshDecimate.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE MeshDecimate
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+const double majorRadius = 3.0;
+const double minorRadius = 1.0;
+
+/**
+ * @brief Torus around the z axis, sampled on a nu x nv grid, with outward oriented triangles.
+ *        Each vertex is seen by the camera of its own index and has a color.
+ */
+void buildTorus(mesh::Mesh& mesh, int nu, int nv)
+{
+    for(int i = 0; i < nu; ++i)
+    {
+        const double u = 2.0 * M_PI * i / nu;
+        for(int j = 0; j < nv; ++j)
+        {
+            const double v = 2.0 * M_PI * j / nv;
+            const double r = majorRadius + minorRadius * std::cos(v);
+            mesh.pts.push_back(Point3d(r * std::cos(u), r * std::sin(u), minorRadius * std::sin(v)));
+        }
+    }
+    for(int i = 0; i < nu; ++i)
+    {
+        for(int j = 0; j < nv; ++j)
+        {
+            const int a = i * nv + j;
+            const int b = ((i + 1) % nu) * nv + j;
+            const int c = ((i + 1) % nu) * nv + (j + 1) % nv;
+            const int d = i * nv + (j + 1) % nv;
+            mesh.tris.push_back(mesh::Mesh::triangle(a, b, c));
+            mesh.tris.push_back(mesh::Mesh::triangle(a, c, d));
+        }
+    }
+
+    mesh.pointsVisibilities.resize(mesh.pts.size());
+    mesh.colors().resize(mesh.pts.size());
+    for(int i = 0; i < mesh.pts.size(); ++i)
+    {
+        mesh.pointsVisibilities[i].push_back(i);
+        mesh.colors()[i] = rgb(i % 256, (i / 256) % 256, 128);
+    }
+}
+
+/// outward direction of the torus surface at p
+Point3d torusNormal(const Point3d& p)
+{
+    const double rxy = std::sqrt(p.x * p.x + p.y * p.y);
+    const Point3d center(majorRadius * p.x / rxy, majorRadius * p.y / rxy, 0.0);
+    return (p - center).normalize();
+}
+
+/// each edge is shared by exactly two triangles, in opposite directions, and no triangle is degenerate
+void checkClosedManifold(const mesh::Mesh& mesh)
+{
+    std::map<std::pair<int, int>, int> halfEdges;
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const mesh::Mesh::triangle& t = mesh.tris[i];
+        BOOST_REQUIRE(t.v[0] != t.v[1] && t.v[1] != t.v[2] && t.v[2] != t.v[0]);
+        for(int k = 0; k < 3; ++k)
+        {
+            BOOST_REQUIRE(t.v[k] >= 0 && t.v[k] < mesh.pts.size());
+            ++halfEdges[std::make_pair(t.v[k], t.v[(k + 1) % 3])];
+        }
+    }
+    for(const auto& halfEdge : halfEdges)
+    {
+        BOOST_REQUIRE_EQUAL(halfEdge.second, 1);
+        const auto opposite = halfEdges.find(std::make_pair(halfEdge.first.second, halfEdge.first.first));
+        BOOST_REQUIRE(opposite != halfEdges.end());
+    }
+
+    // Euler characteristic of the torus: V - E + F = 0
+    const int nbEdges = halfEdges.size() / 2;
+    BOOST_CHECK_EQUAL(mesh.pts.size() - nbEdges + mesh.tris.size(), 0);
+}
+
+/// all the triangles still face outwards
+void checkNoFlip(const mesh::Mesh& mesh)
+{
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const mesh::Mesh::triangle& t = mesh.tris[i];
+        const Point3d& a = mesh.pts[t.v[0]];
+        const Point3d& b = mesh.pts[t.v[1]];
+        const Point3d& c = mesh.pts[t.v[2]];
+        const Point3d n = cross(b - a, c - a);
+        const Point3d center = (a + b + c) / 3.0;
+        BOOST_REQUIRE_GT(dot(n, torusNormal(center)), 0.0);
+    }
+}
+
+/// every input vertex is seen exactly once in the output visibilities
+void checkVisibilitiesMerged(const mesh::Mesh& mesh, int nbInputPts)
+{
+    BOOST_REQUIRE_EQUAL(mesh.pointsVisibilities.size(), mesh.pts.size());
+    std::vector<int> seen(nbInputPts, 0);
+    for(int i = 0; i < mesh.pointsVisibilities.size(); ++i)
+    {
+        const mesh::PointVisibility& visibility = mesh.pointsVisibilities[i];
+        BOOST_REQUIRE_GT(visibility.size(), 0);
+        for(int k = 0; k < visibility.size(); ++k)
+        {
+            BOOST_REQUIRE(visibility[k] >= 0 && visibility[k] < nbInputPts);
+            ++seen[visibility[k]];
+        }
+    }
+    BOOST_CHECK(std::all_of(seen.begin(), seen.end(), [](int count) { return count == 1; }));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshDecimate_targetVertices)
+{
+    mesh::Mesh mesh;
+    buildTorus(mesh, 120, 40);
+    const int nbInputPts = mesh.pts.size();
+
+    mesh::DecimationParams params;
+    params.nbVertices = 400;
+    const int nbCollapses = mesh::decimateMesh(mesh, params);
+
+    // each collapse removes one vertex and two triangles of the closed surface
+    BOOST_CHECK_EQUAL(nbCollapses, nbInputPts - mesh.pts.size());
+    BOOST_CHECK_LE(mesh.pts.size(), params.nbVertices);
+    BOOST_CHECK_GE(mesh.pts.size(), params.nbVertices / 2);
+    BOOST_CHECK_EQUAL(mesh.tris.size(), 2 * mesh.pts.size());
+    BOOST_CHECK_EQUAL(mesh.colors().size(), mesh.pts.size());
+
+    checkClosedManifold(mesh);
+    checkNoFlip(mesh);
+    checkVisibilitiesMerged(mesh, nbInputPts);
+
+    // the decimated vertices stay close to the torus
+    for(int i = 0; i < mesh.pts.size(); ++i)
+    {
+        const Point3d& p = mesh.pts[i];
+        const double rxy = std::sqrt(p.x * p.x + p.y * p.y);
+        const double distance = std::abs(std::hypot(rxy - majorRadius, p.z) - minorRadius);
+        BOOST_CHECK_LT(distance, 0.1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshDecimate_targetTriangles)
+{
+    mesh::Mesh mesh;
+    buildTorus(mesh, 60, 20);
+    const int nbInputPts = mesh.pts.size();
+
+    mesh::DecimationParams params;
+    params.nbTriangles = 500;
+    mesh::decimateMesh(mesh, params);
+
+    BOOST_CHECK_LE(mesh.tris.size(), params.nbTriangles);
+    BOOST_CHECK_GE(mesh.tris.size(), params.nbTriangles / 2);
+
+    checkClosedManifold(mesh);
+    checkNoFlip(mesh);
+    checkVisibilitiesMerged(mesh, nbInputPts);
+}
+
+BOOST_AUTO_TEST_CASE(MeshDecimate_maxErrorKeepsPlane)
+{
+    // flat n x n grid: the collapses are free inside the plane, the boundary is kept in place
+    mesh::Mesh mesh;
+    const int n = 30;
+    for(int y = 0; y < n; ++y)
+        for(int x = 0; x < n; ++x)
+            mesh.pts.push_back(Point3d(x, y, 0.0));
+    for(int y = 0; y + 1 < n; ++y)
+    {
+        for(int x = 0; x + 1 < n; ++x)
+        {
+            const int a = y * n + x;
+            mesh.tris.push_back(mesh::Mesh::triangle(a, a + 1, a + n + 1));
+            mesh.tris.push_back(mesh::Mesh::triangle(a, a + n + 1, a + n));
+        }
+    }
+    const int nbInputTris = mesh.tris.size();
+
+    mesh::DecimationParams params;
+    params.maxError = 1e-6;
+    mesh::decimateMesh(mesh, params);
+
+    BOOST_CHECK_LT(mesh.tris.size(), nbInputTris / 4);
+
+    double area = 0.0;
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const mesh::Mesh::triangle& t = mesh.tris[i];
+        const Point3d n = cross(mesh.pts[t.v[1]] - mesh.pts[t.v[0]], mesh.pts[t.v[2]] - mesh.pts[t.v[0]]);
+        // still flat and facing +z
+        BOOST_CHECK_GT(n.z, 0.0);
+        area += 0.5 * n.z;
+    }
+    for(int i = 0; i < mesh.pts.size(); ++i)
+    {
+        const Point3d& p = mesh.pts[i];
+        BOOST_CHECK_SMALL(p.z, 1e-9);
+        BOOST_CHECK(p.x > -1e-9 && p.x < n - 1 + 1e-9 && p.y > -1e-9 && p.y < n - 1 + 1e-9);
+    }
+    // the boundary did not move
+    BOOST_CHECK_CLOSE(area, (n - 1) * (n - 1), 1e-6);
+}
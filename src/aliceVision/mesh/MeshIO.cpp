@@ -0,0 +1,1500 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Mesh.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    bool open(const std::string& filepath)
+    {
+        boost::system::error_code ec;
+        const auto size = bfs::file_size(filepath, ec);
+        if(ec || size == 0)
+        {
+            ALICEVISION_LOG_ERROR("Unable to open mesh file: " << filepath);
+            return false;
+        }
+        try
+        {
+            _file.open(filepath);
+        }
+        catch(const std::exception& e)
+        {
+            ALICEVISION_LOG_ERROR("Unable to map mesh file: " << filepath << " (" << e.what() << ")");
+            return false;
+        }
+        return _file.is_open();
+    }
+
+    const char* data() const { return _file.data(); }
+    std::size_t size() const { return _file.size(); }
+
+private:
+    boost::iostreams::mapped_file_source _file;
+};
+
+bool isHostLittleEndian()
+{
+    const std::uint16_t value = 1;
+    std::uint8_t firstByte;
+    std::memcpy(&firstByte, &value, 1);
+    return firstByte == 1;
+}
+
+/**
+ * @brief Split the buffer in about nbChunks ranges of whole lines
+ * @return the nbRanges + 1 range bounds
+ */
+std::vector<std::size_t> splitLines(const char* data, std::size_t size, int nbChunks)
+{
+    std::vector<std::size_t> bounds(1, 0);
+    for(int c = 1; c < nbChunks; ++c)
+    {
+        const std::size_t start = std::max(bounds.back(), size / nbChunks * c);
+        if(start >= size)
+            break;
+        const void* eol = std::memchr(data + start, '\n', size - start);
+        if(eol == nullptr)
+            break;
+        const std::size_t bound = static_cast<const char*>(eol) - data + 1;
+        if(bound > bounds.back() && bound < size)
+            bounds.push_back(bound);
+    }
+    bounds.push_back(size);
+    return bounds;
+}
+
+/// Call f(lineBegin, lineEnd) on each line of the range (without the end of line characters)
+template <typename F>
+void forEachLine(const char* begin, const char* end, F f)
+{
+    while(begin < end)
+    {
+        const void* eol = std::memchr(begin, '\n', end - begin);
+        const char* lineEnd = eol ? static_cast<const char*>(eol) : end;
+        const char* contentEnd = lineEnd;
+        if(contentEnd > begin && contentEnd[-1] == '\r')
+            --contentEnd;
+        f(begin, contentEnd);
+        begin = lineEnd + 1;
+    }
+}
+
+inline void skipSpaces(const char*& p, const char* end)
+{
+    while(p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+}
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/// Parse a floating point value of the range (never reads after end)
+inline bool parseDouble(const char*& p, const char* end, double& value)
+{
+    while(p < end && isSpace(*p))
+        ++p;
+    std::size_t length = 0;
+    while(p + length < end && !isSpace(p[length]))
+        ++length;
+    if(length == 0)
+        return false;
+
+    // null terminated copy of the token, on the heap for the long ones (large values written with %f)
+    char buffer[64];
+    std::string longBuffer;
+    char* token = buffer;
+    if(length >= sizeof(buffer))
+    {
+        longBuffer.assign(p, length);
+        token = &longBuffer[0];
+    }
+    else
+    {
+        std::memcpy(buffer, p, length);
+        buffer[length] = '\0';
+    }
+
+    char* parsedEnd;
+    value = std::strtod(token, &parsedEnd);
+    if(parsedEnd == token)
+        return false;
+    p += parsedEnd - token;
+    return true;
+}
+
+/// Parse a signed integer value of the range
+inline bool parseInt(const char*& p, const char* end, int& value)
+{
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+    if(p >= end || *p < '0' || *p > '9')
+        return false;
+    long long result = 0;
+    while(p < end && *p >= '0' && *p <= '9')
+    {
+        result = result * 10 + (*p - '0');
+        ++p;
+    }
+    value = int(negative ? -result : result);
+    return true;
+}
+
+/// Number of values of an OBJ line after its keyword
+inline int countTokens(const char* p, const char* end)
+{
+    int count = 0;
+    while(p < end)
+    {
+        while(p < end && isSpace(*p))
+            ++p;
+        if(p < end)
+            ++count;
+        while(p < end && !isSpace(*p))
+            ++p;
+    }
+    return count;
+}
+
+/// Line keyword of an OBJ file
+enum class EObjLine
+{
+    VERTEX,
+    NORMAL,
+    UV,
+    FACE,
+    MATERIAL,
+    OTHER
+};
+
+inline EObjLine getObjLineType(const char*& p, const char* end)
+{
+    skipSpaces(p, end);
+    const std::size_t length = end - p;
+    if(length >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+    {
+        p += 2;
+        return EObjLine::VERTEX;
+    }
+    if(length >= 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+    {
+        p += 3;
+        return EObjLine::NORMAL;
+    }
+    if(length >= 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+    {
+        p += 3;
+        return EObjLine::UV;
+    }
+    if(length >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+    {
+        p += 2;
+        return EObjLine::FACE;
+    }
+    if(length >= 7 && std::strncmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+    {
+        p += 7;
+        return EObjLine::MATERIAL;
+    }
+    return EObjLine::OTHER;
+}
+
+/// Polygon of an OBJ face line: "v", "v/vt", "v/vt/vn" or "v//vn" corners
+struct ObjFace
+{
+    std::vector<Voxel> corners; // (vertex, uv, normal), 0 if not defined
+    bool withUV = false;
+    bool withNormal = false;
+
+    bool parse(const char* p, const char* end)
+    {
+        corners.clear();
+        int nbUV = 0;
+        int nbNormal = 0;
+        while(true)
+        {
+            while(p < end && isSpace(*p))
+                ++p;
+            if(p >= end)
+                break;
+            Voxel corner(0, 0, 0);
+            if(!parseInt(p, end, corner.x))
+                return false;
+            if(p < end && *p == '/')
+            {
+                ++p;
+                if(p < end && *p != '/')
+                {
+                    if(!parseInt(p, end, corner.y))
+                        return false;
+                    ++nbUV;
+                }
+                if(p < end && *p == '/')
+                {
+                    ++p;
+                    if(!parseInt(p, end, corner.z))
+                        return false;
+                    ++nbNormal;
+                }
+            }
+            if(p < end && !isSpace(*p))
+                return false;
+            corners.push_back(corner);
+        }
+        const int nbCorners = corners.size();
+        if(nbCorners < 3 || (nbUV != 0 && nbUV != nbCorners) || (nbNormal != 0 && nbNormal != nbCorners))
+            return false;
+        withUV = nbUV != 0;
+        withNormal = nbNormal != 0;
+        return true;
+    }
+
+    int getNbTriangles() const { return int(corners.size()) - 2; }
+};
+
+/// Counters and materials of a range of lines of an OBJ file
+struct ObjChunk
+{
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    int nbPts = 0;
+    int nbNormals = 0;
+    int nbUVs = 0;
+    int nbTris = 0;
+    int nbTrisUV = 0;
+    int nbTrisNormal = 0;
+    /// number of values of the first vertex of the chunk (-1 if no vertex)
+    int firstVertexNbValues = -1;
+    /// materials used in the chunk, in order
+    std::vector<std::string> materials;
+    std::vector<int> materialsIds;
+    /// material at the beginning of the chunk
+    int initialMtlId = -1;
+    /// first line with a syntax error (nullptr if none)
+    const char* errorLine = nullptr;
+};
+
+/// Write the items [0, count[ formatted by blocks in parallel, in order
+template <typename F>
+bool writeByBlocks(FILE* f, int count, int blockSize, F format)
+{
+    const int nbThreads = omp_get_max_threads();
+    std::vector<std::string> buffers(nbThreads);
+    for(int batchBegin = 0; batchBegin < count; batchBegin += nbThreads * blockSize)
+    {
+        const int nbBlocks = std::min(nbThreads, (count - batchBegin + blockSize - 1) / blockSize);
+
+        #pragma omp parallel for
+        for(int b = 0; b < nbBlocks; ++b)
+        {
+            const int begin = batchBegin + b * blockSize;
+            buffers[b].clear();
+            format(begin, std::min(count, begin + blockSize), buffers[b]);
+        }
+
+        for(int b = 0; b < nbBlocks; ++b)
+        {
+            if(std::fwrite(buffers[b].data(), 1, buffers[b].size(), f) != buffers[b].size())
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+inline void appendBinary(std::string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+#if defined(__GNUC__)
+inline bool appendFormatted(std::string& buffer, const char* format, ...) __attribute__((format(printf, 2, 3)));
+#endif
+
+/// Append printf formatted text to the buffer, returns false on a formatting error
+inline bool appendFormatted(std::string& buffer, const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    const int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if(length >= 0 && length < int(sizeof(line)))
+        buffer.append(line, length);
+    else if(length >= 0)
+    {
+        // longer line: format again directly at the end of the buffer
+        const std::size_t size = buffer.size();
+        buffer.resize(size + length + 1);
+        std::vsnprintf(&buffer[size], length + 1, format, argsCopy);
+        buffer.resize(size + length);
+    }
+    va_end(argsCopy);
+    return length >= 0;
+}
+
+// PLY
+
+enum class EPlyScalar
+{
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64
+};
+
+bool parsePlyScalar(const std::string& name, EPlyScalar& type)
+{
+    static const std::map<std::string, EPlyScalar> types = {
+        {"char", EPlyScalar::INT8},     {"int8", EPlyScalar::INT8},       {"uchar", EPlyScalar::UINT8},
+        {"uint8", EPlyScalar::UINT8},   {"short", EPlyScalar::INT16},     {"int16", EPlyScalar::INT16},
+        {"ushort", EPlyScalar::UINT16}, {"uint16", EPlyScalar::UINT16},   {"int", EPlyScalar::INT32},
+        {"int32", EPlyScalar::INT32},   {"uint", EPlyScalar::UINT32},     {"uint32", EPlyScalar::UINT32},
+        {"float", EPlyScalar::FLOAT32}, {"float32", EPlyScalar::FLOAT32}, {"double", EPlyScalar::FLOAT64},
+        {"float64", EPlyScalar::FLOAT64}};
+    const auto it = types.find(name);
+    if(it == types.end())
+        return false;
+    type = it->second;
+    return true;
+}
+
+inline int getPlyScalarSize(EPlyScalar type)
+{
+    switch(type)
+    {
+        case EPlyScalar::INT8:
+        case EPlyScalar::UINT8: return 1;
+        case EPlyScalar::INT16:
+        case EPlyScalar::UINT16: return 2;
+        case EPlyScalar::INT32:
+        case EPlyScalar::UINT32:
+        case EPlyScalar::FLOAT32: return 4;
+        case EPlyScalar::FLOAT64: return 8;
+    }
+    return 0;
+}
+
+struct PlyProperty
+{
+    std::string name;
+    EPlyScalar type = EPlyScalar::FLOAT32;
+    bool isList = false;
+    EPlyScalar countType = EPlyScalar::UINT8;
+};
+
+struct PlyElement
+{
+    std::string name;
+    std::size_t count = 0;
+    std::vector<PlyProperty> properties;
+
+    /// size of a record if no property is a list (0 otherwise)
+    std::size_t getFixedRecordSize() const
+    {
+        std::size_t size = 0;
+        for(const PlyProperty& property : properties)
+        {
+            if(property.isList)
+                return 0;
+            size += getPlyScalarSize(property.type);
+        }
+        return size;
+    }
+};
+
+/// Read the values of the PLY data (ascii or binary, with the file endianness)
+struct PlyValueReader
+{
+    bool ascii = false;
+    bool swapBytes = false;
+    const char* end = nullptr;
+
+    template <typename T>
+    inline T readBinary(const char*& p) const
+    {
+        T value;
+        if(swapBytes)
+        {
+            char bytes[sizeof(T)];
+            for(std::size_t i = 0; i < sizeof(T); ++i)
+                bytes[i] = p[sizeof(T) - 1 - i];
+            std::memcpy(&value, bytes, sizeof(T));
+        }
+        else
+        {
+            std::memcpy(&value, p, sizeof(T));
+        }
+        p += sizeof(T);
+        return value;
+    }
+
+    /// read a value, p is moved after it
+    inline bool read(const char*& p, EPlyScalar type, double& value) const
+    {
+        if(ascii)
+            return parseDouble(p, end, value);
+
+        if(p + getPlyScalarSize(type) > end)
+            return false;
+        switch(type)
+        {
+            case EPlyScalar::INT8: value = readBinary<std::int8_t>(p); break;
+            case EPlyScalar::UINT8: value = readBinary<std::uint8_t>(p); break;
+            case EPlyScalar::INT16: value = readBinary<std::int16_t>(p); break;
+            case EPlyScalar::UINT16: value = readBinary<std::uint16_t>(p); break;
+            case EPlyScalar::INT32: value = readBinary<std::int32_t>(p); break;
+            case EPlyScalar::UINT32: value = readBinary<std::uint32_t>(p); break;
+            case EPlyScalar::FLOAT32: value = readBinary<float>(p); break;
+            case EPlyScalar::FLOAT64: value = readBinary<double>(p); break;
+        }
+        return true;
+    }
+
+    /// skip a record, p is moved after it
+    bool skipRecord(const char*& p, const PlyElement& element) const
+    {
+        double value;
+        for(const PlyProperty& property : element.properties)
+        {
+            int count = 1;
+            if(property.isList)
+            {
+                if(!read(p, property.countType, value) || value < 0)
+                    return false;
+                count = int(value);
+            }
+            if(!ascii)
+            {
+                p += std::size_t(count) * getPlyScalarSize(property.type);
+                if(p > end)
+                    return false;
+                continue;
+            }
+            for(int i = 0; i < count; ++i)
+            {
+                if(!read(p, property.type, value))
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+/// Parse the header of a PLY file, data is moved to the first element data
+bool parsePlyHeader(const char*& data, const char* end, std::vector<PlyElement>& elements, PlyValueReader& reader)
+{
+    const char* headerEnd = nullptr;
+    for(const char* p = data; p + 10 <= end; ++p)
+    {
+        if(std::strncmp(p, "end_header", 10) == 0 && (p == data || p[-1] == '\n'))
+        {
+            headerEnd = p + 10;
+            break;
+        }
+    }
+    if(headerEnd == nullptr || std::strncmp(data, "ply", 3) != 0)
+        return false;
+    // data starts after the end of line
+    while(headerEnd < end && *headerEnd != '\n')
+        ++headerEnd;
+    if(headerEnd == end)
+        return false;
+
+    std::istringstream header(std::string(data, headerEnd));
+    data = headerEnd + 1;
+    reader.end = end;
+
+    std::string line;
+    bool hasFormat = false;
+    while(std::getline(header, line))
+    {
+        std::istringstream ss(line);
+        std::string keyword;
+        ss >> keyword;
+        if(keyword == "format")
+        {
+            std::string format;
+            ss >> format;
+            if(format == "ascii")
+                reader.ascii = true;
+            else if(format == "binary_little_endian")
+                reader.swapBytes = !isHostLittleEndian();
+            else if(format == "binary_big_endian")
+                reader.swapBytes = isHostLittleEndian();
+            else
+                return false;
+            hasFormat = true;
+        }
+        else if(keyword == "element")
+        {
+            PlyElement element;
+            ss >> element.name >> element.count;
+            if(ss.fail())
+                return false;
+            elements.push_back(element);
+        }
+        else if(keyword == "property")
+        {
+            if(elements.empty())
+                return false;
+            PlyProperty property;
+            std::string type;
+            ss >> type;
+            if(type == "list")
+            {
+                std::string countType;
+                ss >> countType >> type;
+                property.isList = true;
+                if(!parsePlyScalar(countType, property.countType))
+                    return false;
+            }
+            if(!parsePlyScalar(type, property.type))
+                return false;
+            ss >> property.name;
+            elements.back().properties.push_back(property);
+        }
+    }
+    return hasFormat;
+}
+
+/// Offsets of the records of an element (count + 1 values, relative to data)
+bool computePlyRecordOffsets(const char* data, const PlyElement& element, const PlyValueReader& reader,
+                             std::vector<std::size_t>& offsets)
+{
+    offsets.resize(element.count + 1);
+    const std::size_t fixedSize = reader.ascii ? 0 : element.getFixedRecordSize();
+    if(fixedSize != 0)
+    {
+        for(std::size_t i = 0; i <= element.count; ++i)
+            offsets[i] = i * fixedSize;
+        return data + offsets.back() <= reader.end;
+    }
+    const char* p = data;
+    for(std::size_t i = 0; i < element.count; ++i)
+    {
+        offsets[i] = p - data;
+        if(!reader.skipRecord(p, element))
+            return false;
+    }
+    offsets.back() = p - data;
+    return true;
+}
+
+/// Native file header
+struct NativeHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t nbPts;
+    std::uint64_t nbTris;
+    std::uint64_t nbColors;
+    std::uint64_t nbVisibilities;
+    std::uint64_t nbVisibilityValues;
+    std::uint64_t reserved[3];
+};
+static_assert(sizeof(NativeHeader) == 80, "Unexpected native mesh header size");
+
+const char nativeMagic[8] = {'A', 'V', 'M', 'E', 'S', 'H', '\0', '\0'};
+const std::uint32_t nativeVersion = 1;
+const std::uint32_t nativeByteOrder = 0x01020304;
+
+inline std::size_t alignNative(std::size_t offset)
+{
+    return (offset + 7) & ~std::size_t(7);
+}
+
+/// Size of the native file sections
+struct NativeLayout
+{
+    std::size_t pts, tris, colors, visibilityOffsets, visibilityValues, end;
+
+    explicit NativeLayout(const NativeHeader& header)
+    {
+        pts = alignNative(sizeof(NativeHeader));
+        tris = alignNative(pts + header.nbPts * 3 * sizeof(double));
+        colors = alignNative(tris + header.nbTris * 3 * sizeof(std::int32_t));
+        visibilityOffsets = alignNative(colors + header.nbColors * 3);
+        visibilityValues = alignNative(visibilityOffsets + (header.nbVisibilities ? (header.nbVisibilities + 1) * sizeof(std::uint64_t) : 0));
+        end = visibilityValues + header.nbVisibilityValues * sizeof(std::int32_t);
+    }
+};
+
+/// Convert a color component in [0, 1] to uchar, rounded to the nearest value
+inline unsigned char colorToUChar(double value)
+{
+    return static_cast<unsigned char>(std::min(255.0, std::max(0.0, value * 255.0)) + 0.5);
+}
+
+/// Check that the triangles only use existing vertices
+bool checkTrianglesIndexes(const StaticVector<Mesh::triangle>& tris, int nbPts)
+{
+    bool ok = true;
+    #pragma omp parallel for reduction(&&: ok)
+    for(int i = 0; i < tris.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+            ok = ok && tris[i].v[k] >= 0 && tris[i].v[k] < nbPts;
+    }
+    return ok;
+}
+
+/// Check that the triangles only use existing uv coordinates or normals
+bool checkTrianglesIndexes(const StaticVector<Voxel>& trisIds, int nbValues)
+{
+    bool ok = true;
+    #pragma omp parallel for reduction(&&: ok)
+    for(int i = 0; i < trisIds.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+            ok = ok && trisIds[i].m[k] >= 0 && trisIds[i].m[k] < nbValues;
+    }
+    return ok;
+}
+
+} // namespace
+
+Mesh::EFileType Mesh::getFileType(const std::string& filepath)
+{
+    const std::string extension = boost::to_lower_copy(bfs::path(filepath).extension().string());
+    if(extension == ".obj")
+        return EFileType::OBJ;
+    if(extension == ".ply")
+        return EFileType::PLY;
+    if(extension == ".avmesh")
+        return EFileType::NATIVE;
+    return EFileType::UNKNOWN;
+}
+
+bool Mesh::load(const std::string& filepath)
+{
+    switch(getFileType(filepath))
+    {
+        case EFileType::OBJ: return loadFromObjAscii(filepath);
+        case EFileType::PLY: return loadFromPly(filepath);
+        case EFileType::NATIVE: return loadFromNative(filepath);
+        case EFileType::UNKNOWN: break;
+    }
+    ALICEVISION_LOG_ERROR("Unsupported mesh file format: " << filepath);
+    return false;
+}
+
+bool Mesh::save(const std::string& filepath) const
+{
+    switch(getFileType(filepath))
+    {
+        case EFileType::OBJ: return saveToObj(filepath);
+        case EFileType::PLY: return saveToPly(filepath);
+        case EFileType::NATIVE: return saveToNative(filepath);
+        case EFileType::UNKNOWN: break;
+    }
+    ALICEVISION_LOG_ERROR("Unsupported mesh file format: " << filepath);
+    return false;
+}
+
+bool Mesh::saveToObj(const std::string& filename) const
+{
+    ALICEVISION_LOG_INFO("Save mesh to obj: " << filename);
+    ALICEVISION_LOG_INFO("Nb points: " << pts.size());
+    ALICEVISION_LOG_INFO("Nb triangles: " << tris.size());
+
+    FILE* f = std::fopen(filename.c_str(), "wb");
+    if(f == nullptr)
+    {
+        ALICEVISION_LOG_ERROR("Unable to open file: " << filename);
+        return false;
+    }
+
+    std::fprintf(f, "# \n");
+    std::fprintf(f, "# Wavefront OBJ file\n");
+    std::fprintf(f, "# Created with AliceVision\n");
+    std::fprintf(f, "# \n");
+    std::fprintf(f, "g Mesh\n");
+
+    const bool useColors = (_colors.size() == pts.size());
+    const int blockSize = 65536;
+    std::atomic<bool> formatted(true);
+
+    bool ok = writeByBlocks(f, pts.size(), blockSize, [&](int begin, int end, std::string& buffer) {
+        buffer.reserve((end - begin) * (useColors ? 80 : 40));
+        for(int i = begin; i < end; ++i)
+        {
+            const Point3d& point = pts[i];
+            if(useColors)
+            {
+                const rgb& col = _colors[i];
+                if(!appendFormatted(buffer, "v %f %f %f %f %f %f\n", point.x, point.y, point.z, col.r / 255.0f, col.g / 255.0f, col.b / 255.0f))
+                    formatted = false;
+            }
+            else
+            {
+                if(!appendFormatted(buffer, "v %f %f %f\n", point.x, point.y, point.z))
+                    formatted = false;
+            }
+        }
+    });
+
+    ok = ok && writeByBlocks(f, tris.size(), blockSize, [&](int begin, int end, std::string& buffer) {
+        buffer.reserve((end - begin) * 32);
+        for(int i = begin; i < end; ++i)
+        {
+            const Mesh::triangle& t = tris[i];
+            if(!appendFormatted(buffer, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1))
+                formatted = false;
+        }
+    });
+
+    ok = (std::fclose(f) == 0) && ok && formatted;
+    if(!ok)
+    {
+        ALICEVISION_LOG_ERROR("Failed to write file: " << filename);
+        return false;
+    }
+    ALICEVISION_LOG_INFO("Save mesh to obj done.");
+    return true;
+}
+
+bool Mesh::loadFromObjAscii(const std::string& objAsciiFileName)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
+    invalidateConnectivity();
+
+    MappedFile file;
+    if(!file.open(objAsciiFileName))
+        return false;
+
+    const char* data = file.data();
+    const std::vector<std::size_t> bounds = splitLines(data, file.size(), omp_get_max_threads() * 4);
+    const int nbChunks = int(bounds.size()) - 1;
+    std::vector<ObjChunk> chunks(nbChunks);
+
+    // 1st pass: count the elements of each chunk
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < nbChunks; ++c)
+    {
+        ObjChunk& chunk = chunks[c];
+        chunk.begin = bounds[c];
+        chunk.end = bounds[c + 1];
+        ObjFace face;
+        forEachLine(data + chunk.begin, data + chunk.end, [&](const char* p, const char* end) {
+            const char* line = p;
+            switch(getObjLineType(p, end))
+            {
+                case EObjLine::VERTEX:
+                    if(chunk.firstVertexNbValues < 0)
+                        chunk.firstVertexNbValues = countTokens(p, end);
+                    ++chunk.nbPts;
+                    break;
+                case EObjLine::NORMAL: ++chunk.nbNormals; break;
+                case EObjLine::UV: ++chunk.nbUVs; break;
+                case EObjLine::FACE:
+                    if(!face.parse(p, end))
+                    {
+                        if(chunk.errorLine == nullptr)
+                            chunk.errorLine = line;
+                        break;
+                    }
+                    chunk.nbTris += face.getNbTriangles();
+                    if(face.withUV)
+                        chunk.nbTrisUV += face.getNbTriangles();
+                    if(face.withNormal)
+                        chunk.nbTrisNormal += face.getNbTriangles();
+                    break;
+                case EObjLine::MATERIAL:
+                {
+                    skipSpaces(p, end);
+                    const char* nameEnd = p;
+                    while(nameEnd < end && !isSpace(*nameEnd))
+                        ++nameEnd;
+                    chunk.materials.emplace_back(p, nameEnd);
+                    break;
+                }
+                case EObjLine::OTHER: break;
+            }
+        });
+    }
+
+    // Totals, materials ids (in order of appearance) and colors usage (from the 1st vertex)
+    int npts = 0;
+    int ntris = 0;
+    int nuvs = 0;
+    int nnorms = 0;
+    int ntrisUV = 0;
+    int ntrisNormal = 0;
+    int firstVertexNbValues = -1;
+    std::map<std::string, int> materialCache;
+    int mtlId = -1;
+    for(ObjChunk& chunk : chunks)
+    {
+        if(chunk.errorLine != nullptr)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(chunk.errorLine, '\n', data + chunk.end - chunk.errorLine));
+            throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName + " (" +
+                                     std::string(chunk.errorLine, lineEnd ? lineEnd : data + chunk.end) + ")");
+        }
+        npts += chunk.nbPts;
+        ntris += chunk.nbTris;
+        nuvs += chunk.nbUVs;
+        nnorms += chunk.nbNormals;
+        ntrisUV += chunk.nbTrisUV;
+        ntrisNormal += chunk.nbTrisNormal;
+        if(firstVertexNbValues < 0)
+            firstVertexNbValues = chunk.firstVertexNbValues;
+
+        chunk.initialMtlId = mtlId;
+        for(const std::string& material : chunk.materials)
+        {
+            auto it = materialCache.find(material);
+            if(it == materialCache.end())
+                it = materialCache.emplace(material, int(materialCache.size())).first; // new material
+            mtlId = it->second;
+            chunk.materialsIds.push_back(mtlId);
+        }
+    }
+    const bool useColors = (firstVertexNbValues == 6);
+
+    ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
+      << "\t- # normals: " << nnorms << std::endl
+      << "\t- # uv coordinates: " << nuvs << std::endl
+      << "\t- # triangles: " << ntris);
+
+    pts = StaticVector<Point3d>();
+    pts.resize(npts);
+    tris = StaticVector<Mesh::triangle>();
+    tris.resize(ntris);
+    uvCoords = StaticVector<Point2d>();
+    uvCoords.resize(nuvs);
+    trisUvIds = StaticVector<Voxel>();
+    trisUvIds.resize(ntrisUV);
+    normals = StaticVector<Point3d>();
+    normals.resize(nnorms);
+    trisNormalsIds = StaticVector<Voxel>();
+    trisNormalsIds.resize(ntrisNormal);
+    _trisMtlIds.assign(ntris, -1);
+    _colors.clear();
+    if(useColors)
+        _colors.resize(npts);
+
+    // 2nd pass: parse the chunks at their offsets
+    std::vector<ObjChunk> offsets(nbChunks);
+    for(int c = 1; c < nbChunks; ++c)
+    {
+        offsets[c].nbPts = offsets[c - 1].nbPts + chunks[c - 1].nbPts;
+        offsets[c].nbNormals = offsets[c - 1].nbNormals + chunks[c - 1].nbNormals;
+        offsets[c].nbUVs = offsets[c - 1].nbUVs + chunks[c - 1].nbUVs;
+        offsets[c].nbTris = offsets[c - 1].nbTris + chunks[c - 1].nbTris;
+        offsets[c].nbTrisUV = offsets[c - 1].nbTrisUV + chunks[c - 1].nbTrisUV;
+        offsets[c].nbTrisNormal = offsets[c - 1].nbTrisNormal + chunks[c - 1].nbTrisNormal;
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < nbChunks; ++c)
+    {
+        const ObjChunk& chunk = chunks[c];
+        ObjChunk& offset = offsets[c];
+        int chunkMtlId = chunk.initialMtlId;
+        int materialIndex = 0;
+        ObjFace face;
+
+        forEachLine(data + chunk.begin, data + chunk.end, [&](const char* p, const char* end) {
+            switch(getObjLineType(p, end))
+            {
+                case EObjLine::VERTEX:
+                {
+                    Point3d& pt = pts[offset.nbPts];
+                    for(int k = 0; k < 3; ++k)
+                    {
+                        if(!parseDouble(p, end, pt.m[k]))
+                            pt.m[k] = 0.0;
+                    }
+                    if(useColors)
+                    {
+                        // convert float color data to uchar
+                        double color[3] = {0.0, 0.0, 0.0};
+                        for(int k = 0; k < 3; ++k)
+                            parseDouble(p, end, color[k]);
+                        _colors[offset.nbPts] = rgb(colorToUChar(color[0]), colorToUChar(color[1]), colorToUChar(color[2]));
+                    }
+                    ++offset.nbPts;
+                    break;
+                }
+                case EObjLine::NORMAL:
+                {
+                    Point3d& pt = normals[offset.nbNormals++];
+                    for(int k = 0; k < 3; ++k)
+                    {
+                        if(!parseDouble(p, end, pt.m[k]))
+                            pt.m[k] = 0.0;
+                    }
+                    break;
+                }
+                case EObjLine::UV:
+                {
+                    Point2d& pt = uvCoords[offset.nbUVs++];
+                    for(int k = 0; k < 2; ++k)
+                    {
+                        if(!parseDouble(p, end, pt.m[k]))
+                            pt.m[k] = 0.0;
+                    }
+                    break;
+                }
+                case EObjLine::FACE:
+                {
+                    face.parse(p, end);
+                    // triangle fan (the 2nd triangle of a quad is (v0, v2, v3))
+                    for(int k = 1; k + 1 < face.corners.size(); ++k)
+                    {
+                        const Voxel& c0 = face.corners[0];
+                        const Voxel& c1 = face.corners[k];
+                        const Voxel& c2 = face.corners[k + 1];
+                        triangle& t = tris[offset.nbTris];
+                        t.v[0] = c0.x - 1;
+                        t.v[1] = c1.x - 1;
+                        t.v[2] = c2.x - 1;
+                        t.alive = true;
+                        _trisMtlIds[offset.nbTris] = chunkMtlId;
+                        ++offset.nbTris;
+                        if(face.withUV)
+                            trisUvIds[offset.nbTrisUV++] = Voxel(c0.y - 1, c1.y - 1, c2.y - 1);
+                        if(face.withNormal)
+                            trisNormalsIds[offset.nbTrisNormal++] = Voxel(c0.z - 1, c1.z - 1, c2.z - 1);
+                    }
+                    break;
+                }
+                case EObjLine::MATERIAL: chunkMtlId = chunk.materialsIds[materialIndex++]; break;
+                case EObjLine::OTHER: break;
+            }
+        });
+    }
+
+    nmtls = materialCache.size();
+
+    if(!checkTrianglesIndexes(tris, npts) || !checkTrianglesIndexes(trisUvIds, nuvs) ||
+       !checkTrianglesIndexes(trisNormalsIds, nnorms))
+    {
+        ALICEVISION_LOG_ERROR("Invalid vertex, uv or normal indices in the obj faces: " << objAsciiFileName);
+        return false;
+    }
+
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
+    return npts != 0 && ntris != 0;
+}
+
+bool Mesh::saveToPly(const std::string& filepath) const
+{
+    ALICEVISION_LOG_INFO("Save mesh to ply: " << filepath);
+
+    FILE* f = std::fopen(filepath.c_str(), "wb");
+    if(f == nullptr)
+    {
+        ALICEVISION_LOG_ERROR("Unable to open file: " << filepath);
+        return false;
+    }
+
+    const bool useColors = (_colors.size() == pts.size());
+    const bool useVisibilities = (pointsVisibilities.size() == pts.size());
+
+    std::fprintf(f, "ply\n");
+    std::fprintf(f, "format %s 1.0\n", isHostLittleEndian() ? "binary_little_endian" : "binary_big_endian");
+    std::fprintf(f, "comment Created with AliceVision\n");
+    std::fprintf(f, "element vertex %d\n", pts.size());
+    std::fprintf(f, "property double x\nproperty double y\nproperty double z\n");
+    if(useColors)
+        std::fprintf(f, "property uchar red\nproperty uchar green\nproperty uchar blue\n");
+    if(useVisibilities)
+        std::fprintf(f, "property list int int visibilities\n");
+    std::fprintf(f, "element face %d\n", tris.size());
+    std::fprintf(f, "property list uchar int vertex_indices\n");
+    std::fprintf(f, "end_header\n");
+
+    const int blockSize = 65536;
+
+    bool ok = writeByBlocks(f, pts.size(), blockSize, [&](int begin, int end, std::string& buffer) {
+        buffer.reserve((end - begin) * (3 * sizeof(double) + 3 + (useVisibilities ? 16 : 0)));
+        for(int i = begin; i < end; ++i)
+        {
+            buffer.append(reinterpret_cast<const char*>(pts[i].m), 3 * sizeof(double));
+            if(useColors)
+            {
+                appendBinary(buffer, _colors[i].r);
+                appendBinary(buffer, _colors[i].g);
+                appendBinary(buffer, _colors[i].b);
+            }
+            if(useVisibilities)
+            {
+                const PointVisibility& visibility = pointsVisibilities[i];
+                appendBinary(buffer, std::int32_t(visibility.size()));
+                if(!visibility.empty())
+                    buffer.append(reinterpret_cast<const char*>(visibility.getData().data()), visibility.size() * sizeof(int));
+            }
+        }
+    });
+
+    ok = ok && writeByBlocks(f, tris.size(), blockSize, [&](int begin, int end, std::string& buffer) {
+        buffer.reserve((end - begin) * (1 + 3 * sizeof(std::int32_t)));
+        for(int i = begin; i < end; ++i)
+        {
+            appendBinary(buffer, std::uint8_t(3));
+            for(int k = 0; k < 3; ++k)
+                appendBinary(buffer, std::int32_t(tris[i].v[k]));
+        }
+    });
+
+    ok = (std::fclose(f) == 0) && ok;
+    if(!ok)
+    {
+        ALICEVISION_LOG_ERROR("Failed to write file: " << filepath);
+        return false;
+    }
+    ALICEVISION_LOG_INFO("Save mesh to ply done.");
+    return true;
+}
+
+bool Mesh::loadFromPly(const std::string& filepath)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from ply file: " << filepath);
+    invalidateConnectivity();
+
+    MappedFile file;
+    if(!file.open(filepath))
+        return false;
+
+    const char* data = file.data();
+    const char* end = data + file.size();
+    std::vector<PlyElement> elements;
+    PlyValueReader reader;
+    if(!parsePlyHeader(data, end, elements, reader))
+    {
+        ALICEVISION_LOG_ERROR("Invalid ply header: " << filepath);
+        return false;
+    }
+
+    pts = StaticVector<Point3d>();
+    tris = StaticVector<Mesh::triangle>();
+    _colors.clear();
+    _trisMtlIds.clear();
+    pointsVisibilities = PointsVisibility();
+    uvCoords = StaticVector<Point2d>();
+    trisUvIds = StaticVector<Voxel>();
+    normals = StaticVector<Point3d>();
+    trisNormalsIds = StaticVector<Voxel>();
+    nmtls = 0;
+
+    std::vector<std::size_t> offsets;
+    for(const PlyElement& element : elements)
+    {
+        if(!computePlyRecordOffsets(data, element, reader, offsets))
+        {
+            ALICEVISION_LOG_ERROR("Truncated or invalid ply element '" << element.name << "': " << filepath);
+            return false;
+        }
+        const int count = element.count;
+        bool ok = true;
+
+        if(element.name == "vertex")
+        {
+            bool hasColors = false;
+            bool hasVisibilities = false;
+            for(const PlyProperty& property : element.properties)
+            {
+                hasColors = hasColors || property.name == "red";
+                hasVisibilities = hasVisibilities || (property.name == "visibilities" && property.isList);
+            }
+
+            pts.resize(count);
+            if(hasColors)
+                _colors.resize(count);
+            if(hasVisibilities)
+                pointsVisibilities.resize(count);
+
+            #pragma omp parallel for if(!reader.ascii) reduction(&&: ok)
+            for(int i = 0; i < count; ++i)
+            {
+                const char* p = data + offsets[i];
+                double value = 0.0;
+                for(const PlyProperty& property : element.properties)
+                {
+                    if(property.isList)
+                    {
+                        if(!reader.read(p, property.countType, value))
+                        {
+                            ok = false;
+                            break;
+                        }
+                        const int listSize = int(value);
+                        const bool isVisibilities = (property.name == "visibilities");
+                        if(isVisibilities)
+                            pointsVisibilities[i].resize(listSize);
+                        for(int k = 0; k < listSize && ok; ++k)
+                        {
+                            ok = reader.read(p, property.type, value);
+                            if(isVisibilities)
+                                pointsVisibilities[i][k] = int(value);
+                        }
+                        continue;
+                    }
+                    if(!reader.read(p, property.type, value))
+                    {
+                        ok = false;
+                        break;
+                    }
+                    // colors are stored as uchar or as float in [0, 1]
+                    const bool isFloat = (property.type == EPlyScalar::FLOAT32 || property.type == EPlyScalar::FLOAT64);
+                    const unsigned char color = isFloat ? colorToUChar(value) : static_cast<unsigned char>(value);
+                    if(property.name == "x")
+                        pts[i].x = value;
+                    else if(property.name == "y")
+                        pts[i].y = value;
+                    else if(property.name == "z")
+                        pts[i].z = value;
+                    else if(property.name == "red")
+                        _colors[i].r = color;
+                    else if(property.name == "green")
+                        _colors[i].g = color;
+                    else if(property.name == "blue")
+                        _colors[i].b = color;
+                }
+            }
+        }
+        else if(element.name == "face")
+        {
+            // triangles of each face (triangle fan of the polygons)
+            std::vector<int> trisOffsets(count + 1, 0);
+            int indicesProperty = -1;
+            for(int k = 0; k < element.properties.size(); ++k)
+            {
+                const PlyProperty& property = element.properties[k];
+                if(property.isList && (property.name == "vertex_indices" || property.name == "vertex_index"))
+                    indicesProperty = k;
+            }
+            if(indicesProperty < 0)
+            {
+                ALICEVISION_LOG_ERROR("No vertex indices in the ply faces: " << filepath);
+                return false;
+            }
+            // properties stored before the vertex indices
+            PlyElement previousProperties;
+            previousProperties.properties.assign(element.properties.begin(), element.properties.begin() + indicesProperty);
+
+            #pragma omp parallel for if(!reader.ascii) reduction(&&: ok)
+            for(int i = 0; i < count; ++i)
+            {
+                const char* p = data + offsets[i];
+                double value = 0.0;
+                ok = ok && reader.skipRecord(p, previousProperties);
+                ok = ok && reader.read(p, element.properties[indicesProperty].countType, value);
+                trisOffsets[i + 1] = std::max(0, int(value) - 2);
+            }
+            for(int i = 0; i < count; ++i)
+                trisOffsets[i + 1] += trisOffsets[i];
+
+            tris.resize(trisOffsets.back());
+
+            #pragma omp parallel for if(!reader.ascii) reduction(&&: ok)
+            for(int i = 0; i < count; ++i)
+            {
+                const char* p = data + offsets[i];
+                double value = 0.0;
+                ok = ok && reader.skipRecord(p, previousProperties);
+                const PlyProperty& property = element.properties[indicesProperty];
+                ok = ok && reader.read(p, property.countType, value);
+                const int nbCorners = int(value);
+                int firstCorner = -1;
+                int previousCorner = -1;
+                for(int k = 0; k < nbCorners && ok; ++k)
+                {
+                    ok = reader.read(p, property.type, value);
+                    const int corner = int(value);
+                    if(k == 0)
+                        firstCorner = corner;
+                    else if(k >= 2)
+                        tris[trisOffsets[i] + k - 2] = triangle(firstCorner, previousCorner, corner);
+                    previousCorner = corner;
+                }
+            }
+        }
+
+        if(!ok)
+        {
+            ALICEVISION_LOG_ERROR("Invalid ply element '" << element.name << "': " << filepath);
+            return false;
+        }
+        data += offsets.back();
+    }
+
+    if(!checkTrianglesIndexes(tris, pts.size()))
+    {
+        ALICEVISION_LOG_ERROR("Invalid vertex indices in the ply faces: " << filepath);
+        return false;
+    }
+
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << pts.size() << "\n\t- # triangles: " << tris.size());
+    return !pts.empty() && !tris.empty();
+}
+
+bool Mesh::saveToNative(const std::string& filepath) const
+{
+    ALICEVISION_LOG_INFO("Save mesh to native file: " << filepath);
+
+    NativeHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, nativeMagic, sizeof(nativeMagic));
+    header.version = nativeVersion;
+    header.byteOrder = nativeByteOrder;
+    header.nbPts = pts.size();
+    header.nbTris = tris.size();
+    header.nbColors = (_colors.size() == pts.size()) ? pts.size() : 0;
+    header.nbVisibilities = (pointsVisibilities.size() == pts.size()) ? pts.size() : 0;
+
+    std::vector<std::uint64_t> visibilityOffsets;
+    if(header.nbVisibilities)
+    {
+        visibilityOffsets.resize(header.nbVisibilities + 1, 0);
+        for(int i = 0; i < pointsVisibilities.size(); ++i)
+            visibilityOffsets[i + 1] = visibilityOffsets[i] + pointsVisibilities[i].size();
+        header.nbVisibilityValues = visibilityOffsets.back();
+    }
+
+    FILE* f = std::fopen(filepath.c_str(), "wb");
+    if(f == nullptr)
+    {
+        ALICEVISION_LOG_ERROR("Unable to open file: " << filepath);
+        return false;
+    }
+
+    const NativeLayout layout(header);
+    std::size_t position = 0;
+    const auto writeSection = [&](std::size_t offset, const void* buffer, std::size_t size) {
+        static const char padding[8] = {0};
+        bool sectionOk = std::fwrite(padding, 1, offset - position, f) == offset - position;
+        sectionOk = sectionOk && (size == 0 || std::fwrite(buffer, 1, size, f) == size);
+        position = offset + size;
+        return sectionOk;
+    };
+
+    const int blockSize = 1 << 20;
+    bool ok = writeSection(0, &header, sizeof(header));
+
+    // Point3d and the triangles are not tightly packed: sections are converted by blocks
+    ok = ok && writeSection(layout.pts, nullptr, 0);
+    ok = ok && writeByBlocks(f, pts.size(), blockSize, [&](int begin, int end, std::string& buffer) {
+        for(int i = begin; i < end; ++i)
+            buffer.append(reinterpret_cast<const char*>(pts[i].m), 3 * sizeof(double));
+    });
+    position += header.nbPts * 3 * sizeof(double);
+
+    ok = ok && writeSection(layout.tris, nullptr, 0);
+    ok = ok && writeByBlocks(f, tris.size(), blockSize, [&](int begin, int end, std::string& buffer) {
+        for(int i = begin; i < end; ++i)
+        {
+            for(int k = 0; k < 3; ++k)
+                appendBinary(buffer, std::int32_t(tris[i].v[k]));
+        }
+    });
+    position += header.nbTris * 3 * sizeof(std::int32_t);
+
+    ok = ok && writeSection(layout.colors, nullptr, 0);
+    ok = ok && writeByBlocks(f, header.nbColors, blockSize, [&](int begin, int end, std::string& buffer) {
+        for(int i = begin; i < end; ++i)
+        {
+            appendBinary(buffer, _colors[i].r);
+            appendBinary(buffer, _colors[i].g);
+            appendBinary(buffer, _colors[i].b);
+        }
+    });
+    position += header.nbColors * 3;
+
+    if(header.nbVisibilities)
+    {
+        ok = ok && writeSection(layout.visibilityOffsets, visibilityOffsets.data(), visibilityOffsets.size() * sizeof(std::uint64_t));
+        ok = ok && writeSection(layout.visibilityValues, nullptr, 0);
+        ok = ok && writeByBlocks(f, header.nbVisibilities, blockSize / 8, [&](int begin, int end, std::string& buffer) {
+            for(int i = begin; i < end; ++i)
+            {
+                const PointVisibility& visibility = pointsVisibilities[i];
+                if(!visibility.empty())
+                    buffer.append(reinterpret_cast<const char*>(visibility.getData().data()), visibility.size() * sizeof(int));
+            }
+        });
+    }
+
+    ok = (std::fclose(f) == 0) && ok;
+    if(!ok)
+    {
+        ALICEVISION_LOG_ERROR("Failed to write file: " << filepath);
+        return false;
+    }
+    ALICEVISION_LOG_INFO("Save mesh to native file done.");
+    return true;
+}
+
+bool Mesh::loadFromNative(const std::string& filepath)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from native file: " << filepath);
+    invalidateConnectivity();
+
+    MappedFile file;
+    if(!file.open(filepath))
+        return false;
+
+    NativeHeader header;
+    if(file.size() < sizeof(header))
+    {
+        ALICEVISION_LOG_ERROR("Invalid native mesh file: " << filepath);
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if(std::memcmp(header.magic, nativeMagic, sizeof(nativeMagic)) != 0 || header.byteOrder != nativeByteOrder)
+    {
+        ALICEVISION_LOG_ERROR("Invalid native mesh file (or byte order): " << filepath);
+        return false;
+    }
+    if(header.version > nativeVersion)
+    {
+        ALICEVISION_LOG_ERROR("Unsupported native mesh file version " << header.version << ": " << filepath);
+        return false;
+    }
+    if(header.nbPts > std::uint64_t(std::numeric_limits<int>::max()) ||
+       header.nbTris > std::uint64_t(std::numeric_limits<int>::max()) ||
+       (header.nbColors != 0 && header.nbColors != header.nbPts) ||
+       (header.nbVisibilities != 0 && header.nbVisibilities != header.nbPts))
+    {
+        ALICEVISION_LOG_ERROR("Invalid native mesh file: " << filepath);
+        return false;
+    }
+    const NativeLayout layout(header);
+    if(file.size() < layout.end)
+    {
+        ALICEVISION_LOG_ERROR("Truncated native mesh file: " << filepath);
+        return false;
+    }
+
+    const int npts = header.nbPts;
+    const int ntris = header.nbTris;
+    const char* data = file.data();
+
+    pts = StaticVector<Point3d>();
+    pts.resize(npts);
+    tris = StaticVector<Mesh::triangle>();
+    tris.resize(ntris);
+    _colors.resize(header.nbColors);
+    pointsVisibilities = PointsVisibility();
+    pointsVisibilities.resize(header.nbVisibilities);
+    _trisMtlIds.clear();
+    uvCoords = StaticVector<Point2d>();
+    trisUvIds = StaticVector<Voxel>();
+    normals = StaticVector<Point3d>();
+    trisNormalsIds = StaticVector<Voxel>();
+    nmtls = 0;
+
+    #pragma omp parallel for
+    for(int i = 0; i < npts; ++i)
+        std::memcpy(pts[i].m, data + layout.pts + i * 3 * sizeof(double), 3 * sizeof(double));
+
+    #pragma omp parallel for
+    for(int i = 0; i < ntris; ++i)
+    {
+        std::int32_t v[3];
+        std::memcpy(v, data + layout.tris + i * 3 * sizeof(std::int32_t), sizeof(v));
+        tris[i] = triangle(v[0], v[1], v[2]);
+    }
+
+    if(!checkTrianglesIndexes(tris, npts))
+    {
+        ALICEVISION_LOG_ERROR("Invalid triangles in native mesh file: " << filepath);
+        return false;
+    }
+
+    if(header.nbColors)
+    {
+        #pragma omp parallel for
+        for(int i = 0; i < npts; ++i)
+        {
+            const unsigned char* color = reinterpret_cast<const unsigned char*>(data + layout.colors + i * 3);
+            _colors[i] = rgb(color[0], color[1], color[2]);
+        }
+    }
+
+    if(header.nbVisibilities)
+    {
+        const std::uint64_t* visibilityOffsets = reinterpret_cast<const std::uint64_t*>(data + layout.visibilityOffsets);
+        if(visibilityOffsets[npts] != header.nbVisibilityValues)
+        {
+            ALICEVISION_LOG_ERROR("Invalid visibilities in native mesh file: " << filepath);
+            return false;
+        }
+        bool ok = true;
+
+        #pragma omp parallel for reduction(&&: ok)
+        for(int i = 0; i < npts; ++i)
+        {
+            const std::uint64_t begin = visibilityOffsets[i];
+            const std::uint64_t end = visibilityOffsets[i + 1];
+            if(begin > end || end > header.nbVisibilityValues)
+            {
+                ok = false;
+                continue;
+            }
+            PointVisibility& visibility = pointsVisibilities[i];
+            visibility.resize(int(end - begin));
+            if(end > begin)
+                std::memcpy(visibility.getDataWritable().data(), data + layout.visibilityValues + begin * sizeof(std::int32_t),
+                            (end - begin) * sizeof(std::int32_t));
+        }
+        if(!ok)
+        {
+            ALICEVISION_LOG_ERROR("Invalid visibilities in native mesh file: " << filepath);
+            return false;
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
+    return true;
+}
+
+} // namespace mesh
+} // namespace aliceVision
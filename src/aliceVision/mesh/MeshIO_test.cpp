@@ -0,0 +1,409 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE MeshIO
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/// Temporary file removed at the end of the test
+struct TemporaryFile
+{
+    explicit TemporaryFile(const std::string& extension)
+        : path((bfs::temp_directory_path() / bfs::unique_path("mesh_%%%%%%%%" + extension)).string())
+    {
+    }
+    ~TemporaryFile() { bfs::remove(path); }
+
+    std::string path;
+};
+
+void writeFile(const std::string& path, const std::string& content)
+{
+    std::ofstream os(path, std::ios::binary);
+    os << content;
+}
+
+/// A pyramid with colors and visibilities (one vertex without visibility)
+void buildMesh(mesh::Mesh& mesh)
+{
+    mesh.pts.push_back(Point3d(0.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(1.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(1.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.5, 0.5, 0.75));
+
+    mesh.tris.push_back(mesh::Mesh::triangle(0, 2, 1));
+    mesh.tris.push_back(mesh::Mesh::triangle(0, 3, 2));
+    mesh.tris.push_back(mesh::Mesh::triangle(0, 1, 4));
+    mesh.tris.push_back(mesh::Mesh::triangle(1, 2, 4));
+    mesh.tris.push_back(mesh::Mesh::triangle(2, 3, 4));
+    mesh.tris.push_back(mesh::Mesh::triangle(3, 0, 4));
+
+    mesh.colors() = {rgb(0, 0, 0), rgb(255, 128, 1), rgb(200, 100, 50), rgb(17, 34, 51), rgb(254, 253, 252)};
+
+    mesh.pointsVisibilities.resize(mesh.pts.size());
+    mesh.pointsVisibilities[0].push_back(3);
+    mesh.pointsVisibilities[1].push_back(0);
+    mesh.pointsVisibilities[1].push_back(7);
+    mesh.pointsVisibilities[2].push_back(1);
+    mesh.pointsVisibilities[4].push_back(2);
+    mesh.pointsVisibilities[4].push_back(5);
+    mesh.pointsVisibilities[4].push_back(1000000);
+}
+
+void checkMesh(const mesh::Mesh& expected, const mesh::Mesh& mesh, double tolerance, bool withVisibilities)
+{
+    BOOST_REQUIRE_EQUAL(mesh.pts.size(), expected.pts.size());
+    for(int i = 0; i < expected.pts.size(); ++i)
+        for(int k = 0; k < 3; ++k)
+            BOOST_CHECK_SMALL(mesh.pts[i].m[k] - expected.pts[i].m[k], tolerance);
+
+    BOOST_REQUIRE_EQUAL(mesh.tris.size(), expected.tris.size());
+    for(int i = 0; i < expected.tris.size(); ++i)
+        for(int k = 0; k < 3; ++k)
+            BOOST_CHECK_EQUAL(mesh.tris[i].v[k], expected.tris[i].v[k]);
+
+    BOOST_REQUIRE_EQUAL(mesh.colors().size(), expected.colors().size());
+    for(std::size_t i = 0; i < expected.colors().size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(int(mesh.colors()[i].r), int(expected.colors()[i].r));
+        BOOST_CHECK_EQUAL(int(mesh.colors()[i].g), int(expected.colors()[i].g));
+        BOOST_CHECK_EQUAL(int(mesh.colors()[i].b), int(expected.colors()[i].b));
+    }
+
+    if(!withVisibilities)
+        return;
+    BOOST_REQUIRE_EQUAL(mesh.pointsVisibilities.size(), expected.pointsVisibilities.size());
+    for(int i = 0; i < expected.pointsVisibilities.size(); ++i)
+    {
+        const std::vector<int>& visibility = mesh.pointsVisibilities[i].getData();
+        const std::vector<int>& expectedVisibility = expected.pointsVisibilities[i].getData();
+        BOOST_CHECK_EQUAL_COLLECTIONS(visibility.begin(), visibility.end(), expectedVisibility.begin(), expectedVisibility.end());
+    }
+}
+
+/// Binary PLY writer in a given byte order
+class PlyWriter
+{
+public:
+    explicit PlyWriter(bool bigEndian)
+        : _bigEndian(bigEndian)
+    {
+    }
+
+    template <typename T>
+    void write(T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        const std::uint16_t one = 1;
+        const bool hostLittleEndian = (*reinterpret_cast<const char*>(&one) == 1);
+        if(hostLittleEndian == _bigEndian)
+            std::reverse(bytes, bytes + sizeof(T));
+        data.append(bytes, sizeof(T));
+    }
+
+    std::string data;
+
+private:
+    bool _bigEndian;
+};
+
+/**
+ * @brief Square split in a quad and a triangle, with float positions, colors, visibilities,
+ *        an unknown vertex property and an unknown element
+ */
+std::string buildBinaryPly(bool bigEndian)
+{
+    std::string header = std::string("ply\nformat ") + (bigEndian ? "binary_big_endian" : "binary_little_endian") + " 1.0\n" +
+                         "comment test\n"
+                         "element vertex 5\n"
+                         "property float x\nproperty float y\nproperty float z\n"
+                         "property short unknown\n"
+                         "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+                         "property list uchar int visibilities\n"
+                         "element face 2\n"
+                         "property list uchar int vertex_indices\n"
+                         "element other 1\n"
+                         "property int value\n"
+                         "end_header\n";
+
+    PlyWriter writer(bigEndian);
+    const float positions[5][3] = {{0.f, 0.f, 0.f}, {1.f, 0.f, 0.f}, {1.f, 1.f, 0.f}, {0.f, 1.f, 0.f}, {0.5f, 1.5f, 0.25f}};
+    for(int i = 0; i < 5; ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+            writer.write(positions[i][k]);
+        writer.write(std::int16_t(-i));
+        writer.write(std::uint8_t(10 * i));
+        writer.write(std::uint8_t(10 * i + 1));
+        writer.write(std::uint8_t(10 * i + 2));
+        writer.write(std::uint8_t(i % 3));
+        for(int k = 0; k < i % 3; ++k)
+            writer.write(std::int32_t(100 * i + k));
+    }
+    writer.write(std::uint8_t(4));
+    for(int v : {0, 1, 2, 3})
+        writer.write(std::int32_t(v));
+    writer.write(std::uint8_t(3));
+    for(int v : {3, 2, 4})
+        writer.write(std::int32_t(v));
+    writer.write(std::int32_t(42));
+
+    return header + writer.data;
+}
+
+/// Expected mesh of buildBinaryPly (the quad is split in 2 triangles)
+void buildExpectedPlyMesh(mesh::Mesh& mesh)
+{
+    mesh.pts.push_back(Point3d(0.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(1.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(1.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.5, 1.5, 0.25));
+    mesh.tris.push_back(mesh::Mesh::triangle(0, 1, 2));
+    mesh.tris.push_back(mesh::Mesh::triangle(0, 2, 3));
+    mesh.tris.push_back(mesh::Mesh::triangle(3, 2, 4));
+    mesh.pointsVisibilities.resize(5);
+    for(int i = 0; i < 5; ++i)
+    {
+        mesh.colors().push_back(rgb(10 * i, 10 * i + 1, 10 * i + 2));
+        for(int k = 0; k < i % 3; ++k)
+            mesh.pointsVisibilities[i].push_back(100 * i + k);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshIO_roundTrip)
+{
+    mesh::Mesh mesh;
+    buildMesh(mesh);
+
+    // OBJ: positions written with 6 decimals, no visibilities
+    {
+        TemporaryFile file(".obj");
+        BOOST_REQUIRE(mesh.save(file.path));
+        mesh::Mesh loaded;
+        BOOST_REQUIRE(loaded.load(file.path));
+        checkMesh(mesh, loaded, 1e-6, false);
+    }
+    // Binary PLY (host byte order) and native mesh: exact
+    for(const std::string extension : {".ply", ".avmesh"})
+    {
+        BOOST_TEST_CONTEXT("extension " << extension)
+        {
+            TemporaryFile file(extension);
+            BOOST_REQUIRE(mesh.save(file.path));
+            mesh::Mesh loaded;
+            BOOST_REQUIRE(loaded.load(file.path));
+            checkMesh(mesh, loaded, 0.0, true);
+        }
+    }
+    // Mesh without colors and visibilities
+    {
+        mesh::Mesh plainMesh;
+        buildMesh(plainMesh);
+        plainMesh.colors().clear();
+        plainMesh.pointsVisibilities = mesh::PointsVisibility();
+        for(const std::string extension : {".obj", ".ply", ".avmesh"})
+        {
+            BOOST_TEST_CONTEXT("extension " << extension)
+            {
+                TemporaryFile file(extension);
+                BOOST_REQUIRE(plainMesh.save(file.path));
+                mesh::Mesh loaded;
+                BOOST_REQUIRE(loaded.load(file.path));
+                checkMesh(plainMesh, loaded, 1e-6, false);
+                BOOST_CHECK(loaded.pointsVisibilities.empty());
+            }
+        }
+    }
+    // OBJ lines longer than the formatting buffer (the integer part of the coordinates is written in full)
+    {
+        mesh::Mesh largeMesh;
+        buildMesh(largeMesh);
+        largeMesh.pts[4] = Point3d(1e200, -3.5e150, 2e100);
+        TemporaryFile file(".obj");
+        BOOST_REQUIRE(largeMesh.save(file.path));
+        mesh::Mesh loaded;
+        BOOST_REQUIRE(loaded.load(file.path));
+        checkMesh(largeMesh, loaded, 1e-6, false);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshIO_binaryPly)
+{
+    mesh::Mesh expected;
+    buildExpectedPlyMesh(expected);
+
+    for(const bool bigEndian : {false, true})
+    {
+        BOOST_TEST_CONTEXT("big endian " << bigEndian)
+        {
+            TemporaryFile file(".ply");
+            writeFile(file.path, buildBinaryPly(bigEndian));
+            mesh::Mesh loaded;
+            BOOST_REQUIRE(loaded.load(file.path));
+            checkMesh(expected, loaded, 0.0, true);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshIO_asciiPly)
+{
+    mesh::Mesh expected;
+    buildExpectedPlyMesh(expected);
+    // float colors in [0, 1]
+    expected.colors()[1] = rgb(255, 0, 51);
+
+    TemporaryFile file(".ply");
+    writeFile(file.path, "ply\n"
+                         "format ascii 1.0\n"
+                         "element vertex 5\n"
+                         "property float x\nproperty float y\nproperty float z\n"
+                         "property float red\nproperty float green\nproperty float blue\n"
+                         "property list uchar int visibilities\n"
+                         "element face 2\n"
+                         "property uchar flags\n"
+                         "property list uchar int vertex_indices\n"
+                         "end_header\n"
+                         "0 0 0 0 0.00392157 0.00784314 0\n"
+                         "1 0 0 1 0 0.2 1 100\n"
+                         "1 1 0 0.0784314 0.0823529 0.0862745 2 200 201\n"
+                         "0 1 0 0.117647 0.121569 0.12549 0\n"
+                         "0.5 1.5 0.25 0.156863 0.160784 0.164706 1 400\n"
+                         "7 4 0 1 2 3\n"
+                         "7 3 3 2 4\n");
+
+    mesh::Mesh loaded;
+    BOOST_REQUIRE(loaded.load(file.path));
+    checkMesh(expected, loaded, 0.0, true);
+}
+
+BOOST_AUTO_TEST_CASE(MeshIO_objPolygons)
+{
+    TemporaryFile file(".obj");
+    writeFile(file.path, "# quad and pentagon\n"
+                         "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 2 0 0\nv 3 1 0\nv 2 2 0\n"
+                         "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                         "usemtl A\n"
+                         "f 1/1 2/2 3/3 4/4\n"
+                         "usemtl B\n"
+                         "f 2 5 6 7 3\n");
+
+    mesh::Mesh loaded;
+    BOOST_REQUIRE(loaded.load(file.path));
+    BOOST_REQUIRE_EQUAL(loaded.tris.size(), 5);
+    const int expectedTris[5][3] = {{0, 1, 2}, {0, 2, 3}, {1, 4, 5}, {1, 5, 6}, {1, 6, 2}};
+    for(int i = 0; i < 5; ++i)
+        for(int k = 0; k < 3; ++k)
+            BOOST_CHECK_EQUAL(loaded.tris[i].v[k], expectedTris[i][k]);
+
+    BOOST_REQUIRE_EQUAL(loaded.trisUvIds.size(), 2);
+    BOOST_CHECK_EQUAL(loaded.trisUvIds[1].x, 0);
+    BOOST_CHECK_EQUAL(loaded.trisUvIds[1].y, 2);
+    BOOST_CHECK_EQUAL(loaded.trisUvIds[1].z, 3);
+
+    const std::vector<int> expectedMtlIds = {0, 0, 1, 1, 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(loaded.trisMtlIds().begin(), loaded.trisMtlIds().end(), expectedMtlIds.begin(), expectedMtlIds.end());
+}
+
+BOOST_AUTO_TEST_CASE(MeshIO_invalidFiles)
+{
+    mesh::Mesh mesh;
+    buildMesh(mesh);
+    mesh::Mesh loaded;
+
+    // Missing file and unknown extension
+    BOOST_CHECK(!loaded.load((bfs::temp_directory_path() / bfs::unique_path("missing_%%%%%%%%.ply")).string()));
+    {
+        TemporaryFile file(".off");
+        writeFile(file.path, "OFF\n");
+        BOOST_CHECK(!loaded.load(file.path));
+        BOOST_CHECK(!mesh.save(file.path));
+    }
+
+    // Truncated binary files
+    for(const std::string extension : {".ply", ".avmesh"})
+    {
+        BOOST_TEST_CONTEXT("extension " << extension)
+        {
+            TemporaryFile file(extension);
+            BOOST_REQUIRE(mesh.save(file.path));
+            bfs::resize_file(file.path, bfs::file_size(file.path) - 5);
+            BOOST_CHECK(!loaded.load(file.path));
+        }
+    }
+
+    // Not a mesh file
+    for(const std::string extension : {".ply", ".avmesh"})
+    {
+        BOOST_TEST_CONTEXT("extension " << extension)
+        {
+            TemporaryFile file(extension);
+            writeFile(file.path, std::string(200, 'x'));
+            BOOST_CHECK(!loaded.load(file.path));
+        }
+    }
+
+    // Out of range vertex indices
+    {
+        TemporaryFile file(".obj");
+        writeFile(file.path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n");
+        BOOST_CHECK(!loaded.load(file.path));
+    }
+    {
+        TemporaryFile file(".obj");
+        writeFile(file.path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nvt 0 0\nf 1/1 2/1 3/2\n");
+        BOOST_CHECK(!loaded.load(file.path));
+    }
+    {
+        TemporaryFile file(".ply");
+        writeFile(file.path, "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\nproperty float z\n"
+                             "element face 1\nproperty list uchar int vertex_indices\nend_header\n"
+                             "0 0 0\n1 0 0\n1 1 0\n3 0 1 3\n");
+        BOOST_CHECK(!loaded.load(file.path));
+    }
+
+    // Unrecognized facet syntax
+    {
+        TemporaryFile file(".obj");
+        writeFile(file.path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 a 3\n");
+        BOOST_CHECK_THROW(loaded.load(file.path), std::runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshIO_emptyNative)
+{
+    const mesh::Mesh empty;
+    TemporaryFile file(".avmesh");
+    BOOST_REQUIRE(empty.save(file.path));
+
+    mesh::Mesh loaded;
+    buildMesh(loaded);
+    BOOST_REQUIRE(loaded.load(file.path));
+    BOOST_CHECK_EQUAL(loaded.pts.size(), 0);
+    BOOST_CHECK_EQUAL(loaded.tris.size(), 0);
+    BOOST_CHECK(loaded.colors().empty());
+    BOOST_CHECK(loaded.pointsVisibilities.empty());
+}
@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshConnectivity.hpp>
+
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE Mesh
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+/**
+ * @brief Hexagon fan: center 0, ring vertices 1 to 6 (counter clockwise).
+ *        Triangle i is (0, i + 1, i + 2), the last one closes the fan unless open is true.
+ *        Vertex 7 is an isolated vertex.
+ */
+void buildFan(mesh::Mesh& mesh, bool open)
+{
+    mesh.pts.push_back(Point3d(0.0, 0.0, 0.0));
+    for(int i = 0; i < 6; ++i)
+        mesh.pts.push_back(Point3d(std::cos(i * M_PI / 3.0), std::sin(i * M_PI / 3.0), 0.0));
+    mesh.pts.push_back(Point3d(5.0, 5.0, 5.0));
+
+    const int nbTris = open ? 5 : 6;
+    for(int i = 0; i < nbTris; ++i)
+        mesh.tris.push_back(mesh::Mesh::triangle(0, 1 + i, 1 + (i + 1) % 6));
+}
+
+std::vector<int> toVector(const StaticVector<int>& values)
+{
+    return std::vector<int>(values.begin(), values.end());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Mesh_getPtsNeighPtsOrdered_closed)
+{
+    mesh::Mesh mesh;
+    buildFan(mesh, false);
+
+    StaticVector<StaticVector<int>> ptsNeighPts;
+    mesh.getPtsNeighPtsOrdered(ptsNeighPts);
+    BOOST_REQUIRE_EQUAL(ptsNeighPts.size(), mesh.pts.size());
+
+    // Inner vertex: the ring in the triangles order, from the first vertex of the first triangle
+    const std::vector<int> centerRing = {1, 2, 3, 4, 5, 6};
+    const std::vector<int> center = toVector(ptsNeighPts[0]);
+    BOOST_CHECK_EQUAL_COLLECTIONS(center.begin(), center.end(), centerRing.begin(), centerRing.end());
+
+    // Boundary vertices of the fan: start from the boundary edge
+    const std::vector<int> ring1 = {2, 0, 6};
+    const std::vector<int> neigh1 = toVector(ptsNeighPts[1]);
+    BOOST_CHECK_EQUAL_COLLECTIONS(neigh1.begin(), neigh1.end(), ring1.begin(), ring1.end());
+
+    const std::vector<int> ring4 = {3, 0, 5};
+    const std::vector<int> neigh4 = toVector(ptsNeighPts[4]);
+    BOOST_CHECK_EQUAL_COLLECTIONS(neigh4.begin(), neigh4.end(), ring4.begin(), ring4.end());
+
+    // Isolated vertex
+    BOOST_CHECK(ptsNeighPts[7].empty());
+}
+
+BOOST_AUTO_TEST_CASE(Mesh_getPtsNeighPtsOrdered_open)
+{
+    mesh::Mesh mesh;
+    buildFan(mesh, true);
+
+    StaticVector<StaticVector<int>> ptsNeighPts;
+    mesh.getPtsNeighPtsOrdered(ptsNeighPts);
+
+    // Boundary center: the whole fan is walked from the boundary edge of the first triangle
+    const std::vector<int> centerRing = {1, 2, 3, 4, 5, 6};
+    const std::vector<int> center = toVector(ptsNeighPts[0]);
+    BOOST_CHECK_EQUAL_COLLECTIONS(center.begin(), center.end(), centerRing.begin(), centerRing.end());
+
+    const std::vector<int> ring6 = {5, 0};
+    const std::vector<int> neigh6 = toVector(ptsNeighPts[6]);
+    BOOST_CHECK_EQUAL_COLLECTIONS(neigh6.begin(), neigh6.end(), ring6.begin(), ring6.end());
+}
+
+BOOST_AUTO_TEST_CASE(Mesh_getConnectivity_cache)
+{
+    mesh::Mesh mesh;
+    buildFan(mesh, false);
+
+    // Concurrent calls on the same mesh share the same connectivity
+    std::vector<std::shared_ptr<const mesh::MeshConnectivity>> results(4);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; ++i)
+        threads.emplace_back([&mesh, &results, i]() { results[i] = mesh.getConnectivity(); });
+    for(std::thread& thread : threads)
+        thread.join();
+    for(int i = 1; i < 4; ++i)
+        BOOST_CHECK_EQUAL(results[i], results[0]);
+
+    BOOST_CHECK_EQUAL(mesh.getConnectivity()->getNbEdges(), 12);
+    BOOST_CHECK_EQUAL(mesh.getConnectivity()->getNbPtTris(0), 6);
+
+    // The connectivity is kept until it is invalidated
+    mesh.tris.resize(5);
+    BOOST_CHECK_EQUAL(mesh.getConnectivity(), results[0]);
+    mesh.invalidateConnectivity();
+    const std::shared_ptr<const mesh::MeshConnectivity> connectivity = mesh.getConnectivity();
+    BOOST_CHECK_EQUAL(connectivity->getNbEdges(), 11);
+    BOOST_CHECK_EQUAL(connectivity->getNbPtTris(0), 5);
+    BOOST_CHECK(connectivity->isBoundaryEdge(connectivity->getTriEdge(0, 0)));
+    // the former connectivity is still valid for its holders
+    BOOST_CHECK_EQUAL(results[0]->getNbEdges(), 12);
+
+    // The methods changing the topology invalidate it
+    StaticVector<int> trisIdsToStay;
+    trisIdsToStay.push_back(0);
+    trisIdsToStay.push_back(1);
+    mesh.letJustTringlesIdsInMesh(trisIdsToStay);
+    BOOST_CHECK_EQUAL(mesh.getConnectivity()->getNbEdges(), 5);
+
+    // A copy of the mesh has its own cache
+    const mesh::Mesh copy = mesh;
+    BOOST_CHECK_EQUAL(copy.getConnectivity()->getNbEdges(), 5);
+}
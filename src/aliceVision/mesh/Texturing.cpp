@@ -17,6 +17,7 @@
 #include <aliceVision/mvsData/Image.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
 
 #include <geogram/basic/common.h>
 #include <geogram/basic/geometry_nd.h>
@@ -26,8 +27,12 @@
 
 #include <boost/algorithm/string/case_conv.hpp> 
 
+#include <functional>
+#include <future>
 #include <map>
+#include <memory>
 #include <set>
+#include <tuple>
 
 // Debug mode: save atlases decomposition in frequency bands and
 // the number of contribution in each band (if useScore is set to false)
@@ -258,9 +263,7 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
     std::partial_sum(m.begin(), m.end(), m.begin());
 
     ALICEVISION_LOG_INFO("Texturing in " + imageIO::EImageColorSpace_enumToString(texParams.processColorspace) + " colorspace.");
-    mvsUtils::ImagesCache imageCache(&mp, texParams.processColorspace, texParams.correctEV);
-    imageCache.setCacheSize(2);
-    ALICEVISION_LOG_INFO("Images loaded from cache with: " + imageCache.ECorrectEV_enumToString(texParams.correctEV));
+    ALICEVISION_LOG_INFO("Images loaded with: " << (texParams.correctEV == mvsUtils::ImagesCache::ECorrectEV::APPLY_CORRECTION ? "exposure correction" : "no exposure correction"));
 
     //calculate the maximum number of atlases in memory in MB
     system::MemoryInfo memInfo = system::getMemoryInfo();
@@ -270,7 +273,7 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
     const std::size_t atlasPyramidMaxMemSize = texParams.nbBand * atlasContribMemSize;
 
     const int availableRam = int(memInfo.availableRam / std::pow(2,20));
-    const int availableMem = availableRam - 2 * (imagePyramidMaxMemSize + imageMaxMemSize); // keep some memory for the 2 input images in cache and one laplacian pyramid
+    const int availableMem = availableRam - 2 * (imagePyramidMaxMemSize + imageMaxMemSize); // keep some memory for the 2 input images (in use and loaded in advance) and their laplacian pyramids
 
     const int nbAtlas = _atlases.size();
     // Memory needed to process each attlas = input + input pyramid + output atlas pyramid
@@ -317,23 +320,63 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
             atlasIDs.push_back(atlasID);
         }
         ALICEVISION_LOG_INFO("Generating texture for atlases " << n*nbAtlasMax + 1 << " to " << n*nbAtlasMax+imax );
-        generateTexturesSubSet(mp, atlasIDs, imageCache, outPath, textureFileType);
+        generateTexturesSubSet(mp, atlasIDs, outPath, textureFileType);
     }
 }
 
+void Texturing::getTriangleTexturePixels(unsigned int triangleId, Point2d* triPixs, Point3d* triPts, Pixel& LU, Pixel& RD) const
+{
+    Point2d pixs[3];
+    auto& triangleUvIds = mesh->trisUvIds[triangleId];
+    // compute the Bottom-Left minima of the current UDIM for [0,1] range remapping
+    Point2d udimBL;
+    const StaticVector<Point2d>& uvCoords = mesh->uvCoords;
+    udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
+    udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
+
+    for(int k = 0; k < 3; k++)
+    {
+        if(triPts != nullptr)
+        {
+            const int pointIndex = mesh->tris[triangleId].v[k];
+            triPts[k] = mesh->pts[pointIndex];                               // 3D coordinates
+        }
+        const int uvPointIndex = triangleUvIds.m[k];
+        Point2d uv = uvCoords[uvPointIndex];
+        // UDIM: remap coordinates between [0,1]
+        uv = uv - udimBL;
+
+        pixs[k] = uv * texParams.textureSide;   // UV coordinates
+        if(triPixs != nullptr)
+            triPixs[k] = pixs[k];
+    }
+
+    // compute triangle bounding box in pixel indexes
+    // min values: floor(value)
+    // max values: ceil(value)
+    LU.x = static_cast<int>(std::floor(std::min(std::min(pixs[0].x, pixs[1].x), pixs[2].x)));
+    LU.y = static_cast<int>(std::floor(std::min(std::min(pixs[0].y, pixs[1].y), pixs[2].y)));
+    RD.x = static_cast<int>(std::ceil(std::max(std::max(pixs[0].x, pixs[1].x), pixs[2].x)));
+    RD.y = static_cast<int>(std::ceil(std::max(std::max(pixs[0].y, pixs[1].y), pixs[2].y)));
+
+    // sanity check: clamp values to [0; textureSide]
+    int texSide = static_cast<int>(texParams.textureSide);
+    LU.x = clamp(LU.x, 0, texSide);
+    LU.y = clamp(LU.y, 0, texSide);
+    RD.x = clamp(RD.x, 0, texSide);
+    RD.y = clamp(RD.y, 0, texSide);
+}
+
 void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
-                                const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, imageIO::EImageFileType textureFileType)
+                                const std::vector<size_t>& atlasIDs, const bfs::path& outPath, imageIO::EImageFileType textureFileType)
 {
     if(atlasIDs.size() > _atlases.size())
         throw std::runtime_error("Invalid atlas IDs ");
 
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
-
     // We select the best cameras for each triangle and store it per camera for each output texture files.
     // Triangles contributions are stored per frequency bands for multi-band blending.
     using AtlasIndex = size_t;
-    using ScorePerTriangle = std::vector<std::pair<unsigned int, float>>; //list of <triangleId, score>
-    std::vector<std::map<AtlasIndex, std::vector<ScorePerTriangle>>> contributionsPerCamera(mp.ncams);
+    std::vector<CameraContributions> contributionsPerCamera(mp.ncams);
 
     //for each atlasID, calculate contributionPerCamera
     for(const size_t atlasID : atlasIDs)
@@ -341,8 +384,12 @@ void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
         ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
                   << " (" << _atlases[atlasID].size() << " triangles).");
 
+        // selected contributions of each triangle: <camId, score, band>
+        std::vector<std::vector<std::tuple<int, float, int>>> trianglesContributions(_atlases[atlasID].size());
+
         // iterate over atlas' triangles
-        for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
+        #pragma omp parallel for schedule(dynamic, 256)
+        for(int i = 0; i < _atlases[atlasID].size(); ++i)
         {
             int triangleID = _atlases[atlasID][i];
 
@@ -449,10 +496,7 @@ void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
                 //for the camera camId : add triangle score to the corresponding texture, at the right frequency band
                 const int camId = std::get<2>(scorePerCamId[contrib]);
                 const int triangleScore = std::get<1>(scorePerCamId[contrib]);
-                auto& camContribution = contributionsPerCamera[camId];
-                if(camContribution.find(atlasID) == camContribution.end())
-                    camContribution[atlasID].resize(texParams.nbBand);
-                camContribution.at(atlasID)[band].emplace_back(triangleID, triangleScore);
+                trianglesContributions[i].emplace_back(camId, triangleScore, band);
 
                 if(contrib + 1 == texParams.multiBandNbContrib[band])
                 {
@@ -460,237 +504,357 @@ void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
                 }
             }
         }
+
+        // store the contributions per camera, in the triangles order
+        for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
+        {
+            const int triangleID = _atlases[atlasID][i];
+            for(const auto& contribution : trianglesContributions[i])
+            {
+                auto& camContribution = contributionsPerCamera[std::get<0>(contribution)];
+                if(camContribution.find(atlasID) == camContribution.end())
+                    camContribution[atlasID].resize(texParams.nbBand);
+                camContribution.at(atlasID)[std::get<2>(contribution)].emplace_back(triangleID, std::get<1>(contribution));
+            }
+        }
     }
 
     ALICEVISION_LOG_INFO("Reading pixel color.");
 
-    //pyramid of atlases frequency bands
+    // The last camera contributing to each atlas: the atlas is written as soon as this camera is processed
+    std::map<AtlasIndex, int> lastCameraPerAtlas;
+    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
+    {
+        for(const auto& c : contributionsPerCamera[camId])
+            lastCameraPerAtlas[c.first] = camId;
+    }
+
+    std::vector<int> usedCameras;
+    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
+    {
+        if(contributionsPerCamera[camId].empty())
+            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") unused.");
+        else
+            usedCameras.push_back(camId);
+    }
+
+    // Camera image with its laplacian pyramid
+    struct CameraImage
+    {
+        Image img;
+        std::vector<Image> pyramidL;
+    };
+
+    // Load the image and compute the laplacian pyramid of a camera.
+    // Each camera is used once, so it is loaded in its own buffer rather than in a shared image cache:
+    // the image loaded in advance cannot overwrite the image in use.
+    const auto loadCameraImage = [&](int camId) {
+        CameraImage cameraImage;
+        mvsUtils::loadImage(mp.getImagePath(camId), &mp, camId, cameraImage.img, texParams.processColorspace, texParams.correctEV);
+        cameraImage.img.laplacianPyramid(cameraImage.pyramidL, texParams.nbBand, texParams.multiBandDownscale);
+        return cameraImage;
+    };
+
+    //pyramid of atlases frequency bands, allocated when the first contributing camera is processed
     std::map<AtlasIndex, AccuPyramid> accuPyramids;
-    for(std::size_t atlasID: atlasIDs)
-        accuPyramids[atlasID].init(texParams.nbBand, texParams.textureSide, texParams.textureSide);
+
+    // atlases finalized and written in the background
+    std::vector<std::future<void>> writings;
+    const auto writeAtlas = [&](AtlasIndex atlasID) {
+        auto accuPyramid = std::make_shared<AccuPyramid>(std::move(accuPyramids.at(atlasID)));
+        accuPyramids.erase(atlasID);
+        writings.push_back(std::async(std::launch::async, [this, accuPyramid, atlasID, &outPath, textureFileType]() {
+            fuseAndWriteTexture(*accuPyramid, atlasID, outPath, textureFileType);
+        }));
+    };
+
+    std::future<CameraImage> nextCameraImage;
+    if(!usedCameras.empty())
+        nextCameraImage = std::async(std::launch::async, loadCameraImage, usedCameras.front());
 
     //for each camera, for each texture, iterate over triangles and fill the accuPyramids map
-    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
+    for(std::size_t usedCameraIndex = 0; usedCameraIndex < usedCameras.size(); ++usedCameraIndex)
     {
-        const std::map<AtlasIndex, std::vector<ScorePerTriangle>>& cameraContributions = contributionsPerCamera[camId];
+        const int camId = usedCameras[usedCameraIndex];
+        const CameraContributions& cameraContributions = contributionsPerCamera[camId];
 
-        if(cameraContributions.empty())
-        {
-            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") unused.");
-            continue;
-        }
         ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") with contributions to " << cameraContributions.size() << " texture files:");
 
-        // Load camera image from cache
-        mvsUtils::ImagesCache::ImgSharedPtr imgPtr = imageCache.getImg_sync(camId);
-        const Image& camImg = *imgPtr;
+        // Get the camera image and its laplacian pyramid, and start to load the next one
+        const CameraImage cameraImage = nextCameraImage.get();
+        if(usedCameraIndex + 1 < usedCameras.size())
+            nextCameraImage = std::async(std::launch::async, loadCameraImage, usedCameras[usedCameraIndex + 1]);
 
-        // Calculate laplacianPyramid
-        std::vector<Image> pyramidL; //laplacian pyramid
-        camImg.laplacianPyramid(pyramidL, texParams.nbBand, texParams.multiBandDownscale);
+        const auto getImagePixel = [&mp, camId](const Point3d& pt3d, Point2d& pixRC) {
+            mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+            return mp.isPixelInImage(pixRC, camId);
+        };
+        accumulateCameraContributions(cameraContributions, cameraImage.img, cameraImage.pyramidL, getImagePixel, accuPyramids);
 
-        // for each output texture file
+        // write the atlases without other contributions
         for(const auto& c : cameraContributions)
         {
-            AtlasIndex atlasID = c.first;
-            ALICEVISION_LOG_INFO("  - Texture file: " << atlasID + 1);
-            //for each frequency band
-            for(int band = 0; band < c.second.size(); ++band)
+            if(lastCameraPerAtlas.at(c.first) == camId)
+                writeAtlas(c.first);
+        }
+    }
+
+    // atlases without any contribution
+    for(std::size_t atlasID : atlasIDs)
+    {
+        if(lastCameraPerAtlas.find(atlasID) != lastCameraPerAtlas.end())
+            continue;
+        accuPyramids[atlasID].init(texParams.nbBand, texParams.textureSide, texParams.textureSide);
+        writeAtlas(atlasID);
+    }
+
+    for(auto& writing : writings)
+        writing.get();
+}
+
+void Texturing::accumulateCameraContributions(const CameraContributions& cameraContributions, const Image& camImg,
+                                              const std::vector<Image>& pyramidL,
+                                              const std::function<bool(const Point3d&, Point2d&)>& getImagePixel,
+                                              std::map<std::size_t, AccuPyramid>& accuPyramids) const
+{
+    using AtlasIndex = size_t;
+
+    // Downscale factor of each pyramid level
+    std::vector<int> downscaleCoefs(texParams.nbBand);
+    for(std::size_t level = 0; level < downscaleCoefs.size(); ++level)
+        downscaleCoefs[level] = std::pow(texParams.multiBandDownscale, level);
+
+    // The atlases are accumulated by square tiles, each tile is filled by a single thread
+    const int tileSize = 256;
+    const int texSide = static_cast<int>(texParams.textureSide);
+    const int nbTilesPerSide = (texSide + tileSize - 1) / tileSize;
+
+    // Triangle contribution to a tile
+    struct TileTriangle
+    {
+        unsigned int triangleId;
+        float score;
+        int band;
+    };
+
+    // Dispatch the triangles on the tiles of the atlases covered by their bounding box
+    std::vector<AtlasIndex> tilesAtlas;
+    std::vector<int> tilesIndex;
+    std::vector<std::vector<TileTriangle>> tilesTriangles;
+
+    // for each output texture file
+    for(const auto& c : cameraContributions)
+    {
+        AtlasIndex atlasID = c.first;
+        ALICEVISION_LOG_INFO("  - Texture file: " << atlasID + 1);
+
+        if(accuPyramids.find(atlasID) == accuPyramids.end())
+            accuPyramids[atlasID].init(texParams.nbBand, texParams.textureSide, texParams.textureSide);
+
+        std::vector<std::vector<TileTriangle>> atlasTiles(nbTilesPerSide * nbTilesPerSide);
+
+        //for each frequency band
+        for(int band = 0; band < c.second.size(); ++band)
+        {
+            const ScorePerTriangle& trianglesId = c.second[band];
+            ALICEVISION_LOG_INFO("      - band " << band + 1 << ": " << trianglesId.size() << " triangles.");
+
+            for(const auto& triangle : trianglesId)
             {
-                const ScorePerTriangle& trianglesId = c.second[band];
-                ALICEVISION_LOG_INFO("      - band " << band + 1 << ": " << trianglesId.size() << " triangles.");
+                Pixel LU, RD;
+                getTriangleTexturePixels(triangle.first, nullptr, nullptr, LU, RD);
+                if(LU.x >= RD.x || LU.y >= RD.y)
+                    continue;
 
-                // for each triangle
-                #pragma omp parallel for
-                for(int ti = 0; ti < trianglesId.size(); ++ti)
+                for(int ty = LU.y / tileSize; ty <= (RD.y - 1) / tileSize; ++ty)
                 {
-                    const unsigned int triangleId = std::get<0>(trianglesId[ti]);
-                    const float triangleScore = texParams.useScore ? std::get<1>(trianglesId[ti]) : 1.0f;
-                    // retrieve triangle 3D and UV coordinates
-                    Point2d triPixs[3];
-                    Point3d triPts[3];
-                    auto& triangleUvIds = mesh->trisUvIds[triangleId];
-                    // compute the Bottom-Left minima of the current UDIM for [0,1] range remapping
-                    Point2d udimBL;
-                    StaticVector<Point2d>& uvCoords = mesh->uvCoords;
-                    udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
-                    udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
-
-                    for(int k = 0; k < 3; k++)
-                    {
-                       const int pointIndex = mesh->tris[triangleId].v[k];
-                       triPts[k] = mesh->pts[pointIndex];                               // 3D coordinates
-                       const int uvPointIndex = triangleUvIds.m[k];
-                       Point2d uv = uvCoords[uvPointIndex];
-                       // UDIM: remap coordinates between [0,1]
-                       uv = uv - udimBL;
-
-                       triPixs[k] = uv * texParams.textureSide;   // UV coordinates
-                    }
-
-                    // compute triangle bounding box in pixel indexes
-                    // min values: floor(value)
-                    // max values: ceil(value)
-                    Pixel LU, RD;
-                    LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-                    LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-                    RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-                    RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-                    // sanity check: clamp values to [0; textureSide]
-                    int texSide = static_cast<int>(texParams.textureSide);
-                    LU.x = clamp(LU.x, 0, texSide);
-                    LU.y = clamp(LU.y, 0, texSide);
-                    RD.x = clamp(RD.x, 0, texSide);
-                    RD.y = clamp(RD.y, 0, texSide);
-
-                    // iterate over pixels of the triangle's bounding box
-                    for(int y = LU.y; y < RD.y; y++)
+                    for(int tx = LU.x / tileSize; tx <= (RD.x - 1) / tileSize; ++tx)
                     {
-                       for(int x = LU.x; x < RD.x; x++)
-                       {
-                           Pixel pix(x, y); // top-left corner of the pixel
-                           Point2d barycCoords;
-
-                           // test if the pixel is inside triangle
-                           // and retrieve its barycentric coordinates
-                           if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                           {
-                               continue;
-                           }
-
-                           // remap 'y' to image coordinates system (inverted Y axis)
-                           const unsigned int y_ = (texParams.textureSide - 1) - y;
-                           // 1D pixel index
-                           unsigned int xyoffset = y_ * texParams.textureSide + x;
-                           // get 3D coordinates
-                           Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                           // get 2D coordinates in source image
-                           Point2d pixRC;
-                           mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                           // exclude out of bounds pixels
-                           if(!mp.isPixelInImage(pixRC, camId))
-                               continue;
-
-                           // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
-                           if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
-                               continue;
-
-                           // Fill the accumulated pyramid for this pixel
-                           // each frequency band also contributes to lower frequencies (higher band indexes)
-                           AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
-                           for(std::size_t bandContrib = band; bandContrib < pyramidL.size(); ++bandContrib)
-                           {
-                               int downscaleCoef = std::pow(texParams.multiBandDownscale, bandContrib);
-                               AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
-
-                               // fill the accumulated color map for this pixel
-                               accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC/downscaleCoef) * triangleScore;
-                               accuImage.imgCount[xyoffset] += triangleScore;
-                           }
-                       }
+                        atlasTiles[ty * nbTilesPerSide + tx].push_back({triangle.first, triangle.second, band});
                     }
                 }
             }
         }
+
+        for(int tileIndex = 0; tileIndex < atlasTiles.size(); ++tileIndex)
+        {
+            if(atlasTiles[tileIndex].empty())
+                continue;
+            tilesAtlas.push_back(atlasID);
+            tilesIndex.push_back(tileIndex);
+            tilesTriangles.push_back(std::move(atlasTiles[tileIndex]));
+        }
     }
 
-    //calculate atlas texture in the first level of the pyramid (avoid creating a new buffer)
-    //debug mode : write all the frequencies levels for each texture
-    for(std::size_t atlasID : atlasIDs)
+    // for each tile
+    #pragma omp parallel for schedule(dynamic)
+    for(int t = 0; t < tilesTriangles.size(); ++t)
     {
-        AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
-        AccuImage& atlasTexture = accuPyramid.pyramid[0];
-        ALICEVISION_LOG_INFO("Create texture " << atlasID + 1);
+        AccuPyramid& accuPyramid = accuPyramids.at(tilesAtlas[t]);
+        const int tileX = (tilesIndex[t] % nbTilesPerSide) * tileSize;
+        const int tileY = (tilesIndex[t] / nbTilesPerSide) * tileSize;
+
+        // for each triangle
+        for(const TileTriangle& tileTriangle : tilesTriangles[t])
+        {
+            const float triangleScore = texParams.useScore ? tileTriangle.score : 1.0f;
+            const int band = tileTriangle.band;
+
+            // retrieve triangle 3D and UV coordinates
+            Point2d triPixs[3];
+            Point3d triPts[3];
+            Pixel LU, RD;
+            getTriangleTexturePixels(tileTriangle.triangleId, triPixs, triPts, LU, RD);
+
+            // restrict the triangle's bounding box to the tile
+            LU.x = std::max(LU.x, tileX);
+            LU.y = std::max(LU.y, tileY);
+            RD.x = std::min(RD.x, tileX + tileSize);
+            RD.y = std::min(RD.y, tileY + tileSize);
+
+            // iterate over pixels of the triangle's bounding box
+            for(int y = LU.y; y < RD.y; y++)
+            {
+               for(int x = LU.x; x < RD.x; x++)
+               {
+                   Pixel pix(x, y); // top-left corner of the pixel
+                   Point2d barycCoords;
+
+                   // test if the pixel is inside triangle
+                   // and retrieve its barycentric coordinates
+                   if(!isPixelInTriangle(triPixs, pix, barycCoords))
+                   {
+                       continue;
+                   }
+
+                   // remap 'y' to image coordinates system (inverted Y axis)
+                   const unsigned int y_ = (texParams.textureSide - 1) - y;
+                   // 1D pixel index
+                   unsigned int xyoffset = y_ * texParams.textureSide + x;
+                   // get 3D coordinates
+                   Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+                   // get 2D coordinates in source image, excluding out of bounds pixels
+                   Point2d pixRC;
+                   if(!getImagePixel(pt3d, pixRC))
+                       continue;
+
+                   // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
+                   if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
+                       continue;
+
+                   // Fill the accumulated pyramid for this pixel
+                   // each frequency band also contributes to lower frequencies (higher band indexes)
+                   for(std::size_t bandContrib = band; bandContrib < pyramidL.size(); ++bandContrib)
+                   {
+                       AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
+
+                       // fill the accumulated color map for this pixel
+                       accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC/downscaleCoefs[bandContrib]) * triangleScore;
+                       accuImage.imgCount[xyoffset] += triangleScore;
+                   }
+               }
+            }
+        }
+    }
+}
+
+void Texturing::fuseAndWriteTexture(AccuPyramid& accuPyramid, const std::size_t atlasID, const bfs::path& outPath,
+                                    imageIO::EImageFileType textureFileType)
+{
+#if TEXTURING_MBB_DEBUG
+    const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+#endif
+    AccuImage& atlasTexture = accuPyramid.pyramid[0];
+    ALICEVISION_LOG_INFO("Create texture " << atlasID + 1);
 
 #if TEXTURING_MBB_DEBUG
+    {
+        // write the number of contribution per atlas frequency bands
+        if(!texParams.useScore)
         {
-            // write the number of contribution per atlas frequency bands
-            if(!texParams.useScore)
+            for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
             {
-                for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
 
-                    //write the number of contributions for each texture
-                    std::vector<float> imgContrib(textureSize);
+                //write the number of contributions for each texture
+                std::vector<float> imgContrib(textureSize);
 
-                    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+                for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+                {
+                    unsigned int yoffset = yp * texParams.textureSide;
+                    for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
                     {
-                        unsigned int yoffset = yp * texParams.textureSide;
-                        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
-                        {
-                            unsigned int xyoffset = yoffset + xp;
-                            imgContrib[xyoffset] = atlasLevelTexture.imgCount[xyoffset];
-                        }
+                        unsigned int xyoffset = yoffset + xp;
+                        imgContrib[xyoffset] = atlasLevelTexture.imgCount[xyoffset];
                     }
+                }
 
-                    const std::string textureName = "contrib_" + std::to_string(1001 + atlasID) + std::string("_") + std::to_string(level) + std::string(".") + EImageFileType_enumToString(textureFileType); // starts at '1001' for UDIM compatibility
-                    bfs::path texturePath = outPath / textureName;
+                const std::string textureName = "contrib_" + std::to_string(1001 + atlasID) + std::string("_") + std::to_string(level) + std::string(".") + EImageFileType_enumToString(textureFileType); // starts at '1001' for UDIM compatibility
+                bfs::path texturePath = outPath / textureName;
 
-                    using namespace imageIO;
-                    OutputFileColorSpace colorspace(EImageColorSpace::SRGB, EImageColorSpace::AUTO);
-                    if(texParams.convertLAB)
-                        colorspace.from = EImageColorSpace::LAB;
-                    writeImage(texturePath.string(), texParams.textureSide, texParams.textureSide, imgContrib, EImageQuality::OPTIMIZED, colorspace);
-                }
+                using namespace imageIO;
+                OutputFileColorSpace colorspace(EImageColorSpace::SRGB, EImageColorSpace::AUTO);
+                if(texParams.convertLAB)
+                    colorspace.from = EImageColorSpace::LAB;
+                writeImage(texturePath.string(), texParams.textureSide, texParams.textureSide, imgContrib, EImageQuality::OPTIMIZED, colorspace);
             }
         }
+    }
 #endif
 
-        ALICEVISION_LOG_INFO("  - Computing final (average) color.");
-        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    ALICEVISION_LOG_INFO("  - Computing final (average) color.");
+    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    {
+        unsigned int yoffset = yp * texParams.textureSide;
+        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
         {
-            unsigned int yoffset = yp * texParams.textureSide;
-            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
-            {
-                unsigned int xyoffset = yoffset + xp;
+            unsigned int xyoffset = yoffset + xp;
 
-                // If the imgCount is valid on the first band, it will be valid on all the other bands
-                if(atlasTexture.imgCount[xyoffset] == 0)
-                    continue;
+            // If the imgCount is valid on the first band, it will be valid on all the other bands
+            if(atlasTexture.imgCount[xyoffset] == 0)
+                continue;
 
-                atlasTexture.img[xyoffset] /= atlasTexture.imgCount[xyoffset];
-                atlasTexture.imgCount[xyoffset] = 1;
+            atlasTexture.img[xyoffset] /= atlasTexture.imgCount[xyoffset];
+            atlasTexture.imgCount[xyoffset] = 1;
 
-                for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                    atlasLevelTexture.img[xyoffset] /= atlasLevelTexture.imgCount[xyoffset];
-                }
+            for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
+            {
+                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                atlasLevelTexture.img[xyoffset] /= atlasLevelTexture.imgCount[xyoffset];
             }
         }
+    }
 
 #if TEXTURING_MBB_DEBUG
+    {
+        //write each frequency band, for each texture
+        for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
         {
-            //write each frequency band, for each texture
-            for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
-            {
-                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                writeTexture(atlasLevelTexture, atlasID, outPath, textureFileType, level);
-            }
-
+            AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+            writeTexture(atlasLevelTexture, atlasID, outPath, textureFileType, level);
         }
+
+    }
 #endif
 
-        // Fuse frequency bands into the first buffer, calculate final texture
-        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    // Fuse frequency bands into the first buffer, calculate final texture
+    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    {
+        unsigned int yoffset = yp * texParams.textureSide;
+        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
         {
-            unsigned int yoffset = yp * texParams.textureSide;
-            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+            unsigned int xyoffset = yoffset + xp;
+            for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
             {
-                unsigned int xyoffset = yoffset + xp;
-                for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                    atlasTexture.img[xyoffset] += atlasLevelTexture.img[xyoffset];
-                }
+                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                atlasTexture.img[xyoffset] += atlasLevelTexture.img[xyoffset];
             }
         }
-        writeTexture(atlasTexture, atlasID, outPath, textureFileType, -1);
     }
+    writeTexture(atlasTexture, atlasID, outPath, textureFileType, -1);
 }
 
+
 void Texturing::writeTexture(AccuImage& atlasTexture, const std::size_t atlasID, const boost::filesystem::path &outPath,
                              imageIO::EImageFileType textureFileType, const int level)
 {
@@ -838,16 +1002,19 @@ void Texturing::clear()
     mesh = nullptr;
 }
 
-void Texturing::loadOBJWithAtlas(const std::string& filename, bool flipNormals)
+void Texturing::loadWithAtlas(const std::string& filename, bool flipNormals)
 {
     // Clear internal data
     clear();
     mesh = new Mesh();
-    // Load .obj
-    if(!mesh->loadFromObjAscii(filename.c_str()))
+    // Load the mesh file (.obj, .ply or .avmesh)
+    if(!mesh->load(filename))
     {
         throw std::runtime_error("Unable to load: " + filename);
     }
+    // Only the obj files define materials
+    if(mesh->trisMtlIds().empty())
+        mesh->trisMtlIds().assign(mesh->tris.size(), -1);
 
     // Handle normals flipping
     if(flipNormals)
@@ -881,12 +1048,12 @@ void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
 {
     // keep previous mesh/visibilities as reference
     Mesh* refMesh = mesh;
-    // set pointers to null to avoid deallocation by 'loadFromObj'
+    // set pointers to null to avoid deallocation by 'loadWithAtlas'
     mesh->pointsVisibilities.resize(0);
     mesh = nullptr;
     
-    // load input obj file
-    loadOBJWithAtlas(otherMeshPath, flipNormals);
+    // load input mesh file
+    loadWithAtlas(otherMeshPath, flipNormals);
     // allocate pointsVisibilities for new internal mesh
     mesh->pointsVisibilities = PointsVisibility();
     // remap visibilities from reconstruction onto input mesh
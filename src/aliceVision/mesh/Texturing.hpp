@@ -7,6 +7,7 @@
 #pragma once
 
 #include <aliceVision/mvsData/imageIO.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
@@ -18,6 +19,10 @@
 
 #include <boost/filesystem.hpp>
 
+#include <functional>
+#include <map>
+#include <vector>
+
 namespace bfs = boost::filesystem;
 
 namespace aliceVision {
@@ -88,6 +93,17 @@ struct TexturingParams
     float subdivisionTargetRatio = 0.8;
 };
 
+/**
+ * @brief Return whether a pixel is contained in or intersected by a 2D triangle.
+ * @param[in] triangle the triangle as an array of 3 point2Ds
+ * @param[in] pixel the pixel to test
+ * @param[out] barycentricCoords the barycentric coordinates of this pixel relative to \p triangle
+ */
+bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& barycentricCoords);
+
+/// Return the point of a 3D triangle with the given barycentric coordinates (as given by isPixelInTriangle)
+Point3d barycentricToCartesian(const Point3d* triangle, const Point2d& coords);
+
 struct Texturing
 {
     TexturingParams texParams;
@@ -106,8 +122,8 @@ public:
     /// Clear internal mesh data
     void clear();
 
-    /// Load a mesh from a .obj file and initialize internal structures
-    void loadOBJWithAtlas(const std::string& filename, bool flipNormals=false);
+    /// Load a mesh file (.obj, .ply or .avmesh) and initialize internal structures
+    void loadWithAtlas(const std::string& filename, bool flipNormals=false);
 
     /**
      * @brief Remap visibilities
@@ -177,15 +193,51 @@ public:
         }
     };
 
+    /// list of <triangleId, score>
+    using ScorePerTriangle = std::vector<std::pair<unsigned int, float>>;
+    /// triangles of each texture atlas and frequency band
+    using CameraContributions = std::map<std::size_t, std::vector<ScorePerTriangle>>;
+
     /// Generate texture files for all texture atlases
     void generateTextures(const mvsUtils::MultiViewParams& mp,
                           const bfs::path &outPath, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
 
     /// Generate texture files for the given sub-set of texture atlases
     void generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
-                         const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
+                         const std::vector<size_t>& atlasIDs,
                          const bfs::path &outPath, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
 
+    /**
+     * @brief Accumulate the contributions of a camera in the pyramids of the texture atlases.
+     * The atlases are filled by square tiles in parallel, each tile by a single thread.
+     * The contributions of a pixel are accumulated in the order of the triangles.
+     *
+     * @param[in] cameraContributions the triangles of each atlas and frequency band
+     * @param[in] camImg the camera image
+     * @param[in] pyramidL the laplacian pyramid of the camera image
+     * @param[in] getImagePixel gives the camera image pixel of a 3D point, false if it is out of the image
+     * @param[in,out] accuPyramids the pyramids of the atlases, allocated on first use
+     */
+    void accumulateCameraContributions(const CameraContributions& cameraContributions, const Image& camImg,
+                                       const std::vector<Image>& pyramidL,
+                                       const std::function<bool(const Point3d&, Point2d&)>& getImagePixel,
+                                       std::map<std::size_t, AccuPyramid>& accuPyramids) const;
+
+    /// Average and fuse the frequency bands of an atlas, then write its texture file
+    void fuseAndWriteTexture(AccuPyramid& accuPyramid, const std::size_t atlasID, const bfs::path& outPath,
+                             imageIO::EImageFileType textureFileType);
+
+    /**
+     * @brief Get the texture pixel coordinates of a triangle in its UDIM tile
+     *
+     * @param[in] triangleId the triangle
+     * @param[out] triPixs the texture pixel coordinates of the 3 vertices (ignored if null)
+     * @param[out] triPts the 3D coordinates of the 3 vertices (ignored if null)
+     * @param[out] LU the top-left corner of the bounding box (clamped to the texture)
+     * @param[out] RD the bottom-right corner of the bounding box (excluded, clamped to the texture)
+     */
+    void getTriangleTexturePixels(unsigned int triangleId, Point2d* triPixs, Point3d* triPts, Pixel& LU, Pixel& RD) const;
+
     ///Fill holes and write texture files for the given texture atlas
     void writeTexture(AccuImage& atlasTexture, const std::size_t atlasID, const bfs::path& outPath,
                       imageIO::EImageFileType textureFileType, const int level);
@@ -0,0 +1,253 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Texturing.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#define BOOST_TEST_MODULE Texturing
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+const int imageWidth = 640;
+const int imageHeight = 480;
+
+/// A plane (z = 0) covering the camera image, cut in a grid of triangles, with a UV atlas made of shuffled squares
+void buildMesh(mesh::Mesh& mesh, int gridSize, std::mt19937& generator)
+{
+    for(int y = 0; y <= gridSize; ++y)
+        for(int x = 0; x <= gridSize; ++x)
+            mesh.pts.push_back(Point3d(x * (imageWidth - 1.0) / gridSize, y * (imageHeight - 1.0) / gridSize, 0.0));
+
+    // each grid cell is mapped on a UV square of the atlas, the squares are shuffled
+    std::vector<int> squares(gridSize * gridSize);
+    for(int i = 0; i < squares.size(); ++i)
+        squares[i] = i;
+    std::shuffle(squares.begin(), squares.end(), generator);
+
+    // with a margin between the squares, and a small jitter of the vertices
+    std::uniform_real_distribution<double> jitter(0.0, 0.1);
+    const double squareSide = 1.0 / gridSize;
+    for(int y = 0; y < gridSize; ++y)
+    {
+        for(int x = 0; x < gridSize; ++x)
+        {
+            const int cell = y * gridSize + x;
+            const int v = y * (gridSize + 1) + x;
+            const double u0 = (squares[cell] % gridSize) * squareSide;
+            const double v0 = (squares[cell] / gridSize) * squareSide;
+            const int uv = mesh.uvCoords.size();
+            mesh.uvCoords.push_back(Point2d(u0 + squareSide * (0.05 + jitter(generator)), v0 + squareSide * (0.05 + jitter(generator))));
+            mesh.uvCoords.push_back(Point2d(u0 + squareSide * (0.95 - jitter(generator)), v0 + squareSide * (0.05 + jitter(generator))));
+            mesh.uvCoords.push_back(Point2d(u0 + squareSide * (0.95 - jitter(generator)), v0 + squareSide * (0.95 - jitter(generator))));
+            mesh.uvCoords.push_back(Point2d(u0 + squareSide * (0.05 + jitter(generator)), v0 + squareSide * (0.95 - jitter(generator))));
+
+            mesh.tris.push_back(mesh::Mesh::triangle(v, v + 1, v + gridSize + 2));
+            mesh.trisUvIds.push_back(Voxel(uv, uv + 1, uv + 2));
+            mesh.tris.push_back(mesh::Mesh::triangle(v, v + gridSize + 2, v + gridSize + 1));
+            mesh.trisUvIds.push_back(Voxel(uv, uv + 2, uv + 3));
+        }
+    }
+}
+
+/// A random camera image and the levels of its pyramid
+void buildImages(Image& camImg, std::vector<Image>& pyramidL, int nbBand, int downscale, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> colorDistribution(0.0f, 1.0f);
+    const auto fillRandom = [&](Image& img) {
+        for(int i = 0; i < img.width() * img.height(); ++i)
+            img[i] = Color(colorDistribution(generator), colorDistribution(generator), colorDistribution(generator));
+    };
+
+    camImg.resize(imageWidth, imageHeight);
+    fillRandom(camImg);
+    // a black area: the pixels without any contribution
+    for(int y = 0; y < 40; ++y)
+        for(int x = 0; x < 80; ++x)
+            camImg.at(x, y) = Color(0.f, 0.f, 0.f);
+
+    pyramidL.resize(nbBand);
+    int levelDownscale = 1;
+    for(Image& level : pyramidL)
+    {
+        level.resize(imageWidth / levelDownscale + 1, imageHeight / levelDownscale + 1);
+        fillRandom(level);
+        levelDownscale *= downscale;
+    }
+}
+
+/// Each triangle contributes to a random frequency band, with a random score
+mesh::Texturing::CameraContributions buildContributions(const mesh::Mesh& mesh, int nbBand, std::mt19937& generator)
+{
+    std::uniform_int_distribution<int> bandDistribution(0, nbBand - 1);
+    std::uniform_real_distribution<float> scoreDistribution(0.1f, 2.0f);
+
+    mesh::Texturing::CameraContributions contributions;
+    std::vector<mesh::Texturing::ScorePerTriangle>& bands = contributions[0];
+    bands.resize(nbBand);
+    for(unsigned int triangleId = 0; triangleId < mesh.tris.size(); ++triangleId)
+        bands[bandDistribution(generator)].emplace_back(triangleId, scoreDistribution(generator));
+    return contributions;
+}
+
+bool getImagePixel(const Point3d& pt3d, Point2d& pixRC)
+{
+    pixRC = Point2d(pt3d.x, pt3d.y);
+    return pixRC.x >= 0 && pixRC.y >= 0 && pixRC.x < imageWidth - 1 && pixRC.y < imageHeight - 1;
+}
+
+/// The former accumulation: all the pixels of each triangle, band by band, in a single thread
+void accumulateReference(const mesh::Texturing& texturing, const mesh::Texturing::CameraContributions& cameraContributions,
+                         const Image& camImg, const std::vector<Image>& pyramidL,
+                         std::map<std::size_t, mesh::Texturing::AccuPyramid>& accuPyramids)
+{
+    const mesh::TexturingParams& texParams = texturing.texParams;
+    std::vector<int> downscaleCoefs(texParams.nbBand);
+    for(std::size_t level = 0; level < downscaleCoefs.size(); ++level)
+        downscaleCoefs[level] = std::pow(texParams.multiBandDownscale, level);
+
+    for(const auto& c : cameraContributions)
+    {
+        mesh::Texturing::AccuPyramid& accuPyramid = accuPyramids[c.first];
+        accuPyramid.init(texParams.nbBand, texParams.textureSide, texParams.textureSide);
+
+        for(int band = 0; band < c.second.size(); ++band)
+        {
+            for(const auto& triangle : c.second[band])
+            {
+                const float triangleScore = texParams.useScore ? triangle.second : 1.0f;
+                Point2d triPixs[3];
+                Point3d triPts[3];
+                Pixel LU, RD;
+                texturing.getTriangleTexturePixels(triangle.first, triPixs, triPts, LU, RD);
+
+                for(int y = LU.y; y < RD.y; y++)
+                {
+                    for(int x = LU.x; x < RD.x; x++)
+                    {
+                        Point2d barycCoords;
+                        if(!mesh::isPixelInTriangle(triPixs, Pixel(x, y), barycCoords))
+                            continue;
+
+                        const unsigned int y_ = (texParams.textureSide - 1) - y;
+                        const unsigned int xyoffset = y_ * texParams.textureSide + x;
+                        const Point3d pt3d = mesh::barycentricToCartesian(triPts, barycCoords);
+                        Point2d pixRC;
+                        if(!getImagePixel(pt3d, pixRC))
+                            continue;
+                        if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
+                            continue;
+
+                        for(std::size_t bandContrib = band; bandContrib < pyramidL.size(); ++bandContrib)
+                        {
+                            mesh::Texturing::AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
+                            accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC / downscaleCoefs[bandContrib]) * triangleScore;
+                            accuImage.imgCount[xyoffset] += triangleScore;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Compare the accumulated pyramids, the contributions of a pixel are added in the same order
+void checkSamePyramids(const mesh::Texturing::AccuPyramid& pyramid, const mesh::Texturing::AccuPyramid& reference)
+{
+    BOOST_REQUIRE_EQUAL(pyramid.pyramid.size(), reference.pyramid.size());
+
+    std::size_t nbFilledPixels = 0;
+    std::size_t nbDifferentPixels = 0;
+    for(std::size_t level = 0; level < reference.pyramid.size(); ++level)
+    {
+        const mesh::Texturing::AccuImage& accuImage = pyramid.pyramid[level];
+        const mesh::Texturing::AccuImage& referenceImage = reference.pyramid[level];
+        BOOST_REQUIRE_EQUAL(accuImage.imgCount.size(), referenceImage.imgCount.size());
+
+        for(std::size_t i = 0; i < referenceImage.imgCount.size(); ++i)
+        {
+            if(referenceImage.imgCount[i] != 0.f)
+                ++nbFilledPixels;
+            const Color& color = accuImage.img[i];
+            const Color& referenceColor = referenceImage.img[i];
+            if(accuImage.imgCount[i] != referenceImage.imgCount[i] || color.r != referenceColor.r ||
+               color.g != referenceColor.g || color.b != referenceColor.b)
+                ++nbDifferentPixels;
+        }
+    }
+
+    BOOST_CHECK_GT(nbFilledPixels, 0);
+    BOOST_CHECK_EQUAL(nbDifferentPixels, 0);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Texturing_accumulateCameraContributions)
+{
+    std::mt19937 generator(42);
+
+    mesh::Texturing texturing;
+    texturing.texParams.textureSide = 700; // not a multiple of the tiles size
+    texturing.mesh = new mesh::Mesh();
+    buildMesh(*texturing.mesh, 20, generator);
+
+    Image camImg;
+    std::vector<Image> pyramidL;
+    buildImages(camImg, pyramidL, texturing.texParams.nbBand, texturing.texParams.multiBandDownscale, generator);
+
+    for(const bool useScore : {true, false})
+    {
+        texturing.texParams.useScore = useScore;
+        const mesh::Texturing::CameraContributions contributions = buildContributions(*texturing.mesh, texturing.texParams.nbBand, generator);
+
+        std::map<std::size_t, mesh::Texturing::AccuPyramid> referencePyramids;
+        accumulateReference(texturing, contributions, camImg, pyramidL, referencePyramids);
+
+        std::map<std::size_t, mesh::Texturing::AccuPyramid> accuPyramids;
+        texturing.accumulateCameraContributions(contributions, camImg, pyramidL, getImagePixel, accuPyramids);
+
+        BOOST_REQUIRE_EQUAL(accuPyramids.size(), 1);
+        checkSamePyramids(accuPyramids.at(0), referencePyramids.at(0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Texturing_accumulateCameraContributionsTiming)
+{
+    std::mt19937 generator(7);
+
+    mesh::Texturing texturing;
+    texturing.texParams.textureSide = 2048;
+    texturing.mesh = new mesh::Mesh();
+    buildMesh(*texturing.mesh, 200, generator);
+
+    Image camImg;
+    std::vector<Image> pyramidL;
+    buildImages(camImg, pyramidL, texturing.texParams.nbBand, texturing.texParams.multiBandDownscale, generator);
+    const mesh::Texturing::CameraContributions contributions = buildContributions(*texturing.mesh, texturing.texParams.nbBand, generator);
+
+    std::map<std::size_t, mesh::Texturing::AccuPyramid> referencePyramids;
+    system::Timer timer;
+    accumulateReference(texturing, contributions, camImg, pyramidL, referencePyramids);
+    const double referenceTime = timer.elapsed();
+
+    std::map<std::size_t, mesh::Texturing::AccuPyramid> accuPyramids;
+    timer.reset();
+    texturing.accumulateCameraContributions(contributions, camImg, pyramidL, getImagePixel, accuPyramids);
+    const double time = timer.elapsed();
+
+    checkSamePyramids(accuPyramids.at(0), referencePyramids.at(0));
+    BOOST_TEST_MESSAGE(texturing.mesh->tris.size() << " triangles in a " << texturing.texParams.textureSide
+                       << " atlas: " << referenceTime << " s in a single thread, " << time << " s by tiles with "
+                       << omp_get_max_threads() << " threads.");
+}
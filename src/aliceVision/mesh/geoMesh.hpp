@@ -41,5 +41,36 @@ inline void toGeoMesh(const Mesh& src, GEO::Mesh& dst)
     assert(src.tris.size() == dst.facets.nb());
 }
 
+/**
+* @brief Create an aliceVision::Mesh from a Geogram GEO::Mesh
+*
+* @note only initialize vertices and triangles (polygonal facets are triangulated)
+* @param[in] the source GEO::Mesh
+* @param[out] the destination aliceVision mesh
+*/
+inline void fromGeoMesh(const GEO::Mesh& src, Mesh& dst)
+{
+    dst.pts = StaticVector<Point3d>();
+    dst.pts.resize(src.vertices.nb());
+    for (GEO::index_t i = 0; i < src.vertices.nb(); ++i)
+    {
+        const double* point = src.vertices.point_ptr(i);
+        dst.pts[i] = Point3d(point[0], point[1], point[2]);
+    }
+
+    int nbTriangles = 0;
+    for (GEO::index_t f = 0; f < src.facets.nb(); ++f)
+        nbTriangles += src.facets.nb_vertices(f) - 2;
+
+    dst.tris = StaticVector<Mesh::triangle>();
+    dst.tris.reserve(nbTriangles);
+    for (GEO::index_t f = 0; f < src.facets.nb(); ++f)
+    {
+        for (GEO::index_t lv = 1; lv + 1 < src.facets.nb_vertices(f); ++lv)
+            dst.tris.push_back(Mesh::triangle(src.facets.vertex(f, 0), src.facets.vertex(f, lv), src.facets.vertex(f, lv + 1)));
+    }
+    dst.invalidateConnectivity();
+}
+
 }
 }
@@ -5,15 +5,13 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "meshVisibility.hpp"
-#include "geoMesh.hpp"
+#include "MeshBVH.hpp"
 
 #include <aliceVision/system/Logger.hpp>
 
-#include <geogram/basic/permutation.h>
-#include <geogram/basic/attributes.h>
 #include <geogram/points/kd_tree.h>
-#include <geogram/mesh/mesh_AABB.h>
-#include <geogram/mesh/mesh_reorder.h>
+
+#include <cmath>
 
 
 namespace aliceVision {
@@ -67,14 +65,18 @@ void remapMeshVisibilities_pullVerticesVisibility(const Mesh& refMesh, Mesh& mes
 }
 
 
-double mesh_facet_edges_length(const GEO::Mesh &M, GEO::index_t f)
+namespace {
+
+double triangleEdgesLength(const Mesh& mesh, int triangle)
 {
-    const GEO::vec3& p0 = M.vertices.point(M.facets.vertex(f, 0));
-    const GEO::vec3& p1 = M.vertices.point(M.facets.vertex(f, 1));
-    const GEO::vec3& p2 = M.vertices.point(M.facets.vertex(f, 2));
-    return (p1 - p0).length() + (p2 - p1).length() + (p0 - p2).length();
+    const Point3d& p0 = mesh.pts[mesh.tris[triangle].v[0]];
+    const Point3d& p1 = mesh.pts[mesh.tris[triangle].v[1]];
+    const Point3d& p2 = mesh.pts[mesh.tris[triangle].v[2]];
+    return (p1 - p0).size() + (p2 - p1).size() + (p0 - p2).size();
 }
 
+} // namespace
+
 void remapMeshVisibilities_pushVerticesVisibilityToTriangles(const Mesh& refMesh, Mesh& mesh)
 {
     ALICEVISION_LOG_INFO("remapMeshVisibility based on triangles start.");
@@ -82,18 +84,7 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(const Mesh& refMesh
     const PointsVisibility& refPtsVisibilities = refMesh.pointsVisibilities;
     PointsVisibility& out_ptsVisibilities = mesh.pointsVisibilities;
 
-    GEO::initialize();
-    GEO::Mesh meshG;
-    toGeoMesh(mesh, meshG);
-
-    // MeshFacetAABB will reorder the mesh, so we need to keep indices
-    GEO::Attribute<GEO::index_t> reorderedVerticesAttr(meshG.vertices.attributes(), "reorder");
-    for(int i = 0; i < meshG.vertices.nb(); ++i)
-        reorderedVerticesAttr[i] = i;
-
-    GEO::MeshFacetsAABB meshAABB(meshG);  // warning: mesh_reorder called inside
-
-    GEO::vector<GEO::index_t> reorderedVertices = reorderedVerticesAttr.get_vector();
+    const MeshBVH meshBVH(mesh);
 
     if (out_ptsVisibilities.size() != mesh.pts.size())
     {
@@ -107,28 +98,23 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(const Mesh& refMesh
         if (rpVis.empty())
             continue;
 
-        const GEO::vec3 rp(refMesh.pts[rvi].m);
-        GEO::vec3 nearestPoint;
-        double dist2 = 0.0;
-        GEO::index_t f = meshAABB.nearest_facet(rp, nearestPoint, dist2);
-        if(f == GEO::NO_FACET)
+        MeshBVH::Nearest nearest;
+        if(!meshBVH.nearest(refMesh.pts[rvi], nearest))
             continue;
+        const int f = nearest.triangle;
 
-        double avgEdgeLength = mesh_facet_edges_length(meshG, f) / 3.0;
+        double avgEdgeLength = triangleEdgesLength(mesh, f) / 3.0;
         // if average edge length is larger than the distance between the output mesh
         // and the closest point in the reference mesh.
-        if(std::sqrt(dist2) > avgEdgeLength)
+        if(std::sqrt(nearest.distance2) > avgEdgeLength)
             continue;
 
         #pragma omp critical
         {
             for (int i = 0; i < 3; ++i)
             {
-                GEO::index_t v = meshG.facets.vertex(f, i);
-                if (v == GEO::NO_VERTEX)
-                    continue;
-                PointVisibility& pOut = out_ptsVisibilities[reorderedVertices[v]];
-                
+                PointVisibility& pOut = out_ptsVisibilities[mesh.tris[f].v[i]];
+
                 for(int j = 0; j < rpVis.size(); ++j)
                     pOut.push_back_distinct(rpVis[j]);
             }
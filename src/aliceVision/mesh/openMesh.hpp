@@ -0,0 +1,118 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <OpenMesh/Core/IO/MeshIO.hh>
+
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+* @brief Create an OpenMesh triangle mesh from an aliceVision::Mesh
+*
+* @note only initialize vertices and faces (OpenMesh skips the non-manifold faces)
+* @param[in] the source aliceVision mesh
+* @param[out] the destination OpenMesh mesh (e.g. OpenMesh::TriMesh_ArrayKernelT<>)
+*/
+template <typename OMesh>
+void toOpenMesh(const Mesh& src, OMesh& dst)
+{
+    using Scalar = typename OMesh::Point::value_type;
+
+    dst.clear();
+    dst.reserve(src.pts.size(), src.tris.size() * 3 / 2, src.tris.size());
+
+    std::vector<typename OMesh::VertexHandle> vertices(src.pts.size());
+    for(int i = 0; i < src.pts.size(); ++i)
+    {
+        const Point3d& point = src.pts[i];
+        vertices[i] = dst.add_vertex(typename OMesh::Point(Scalar(point.x), Scalar(point.y), Scalar(point.z)));
+    }
+
+    for(int i = 0; i < src.tris.size(); ++i)
+    {
+        const Mesh::triangle& tri = src.tris[i];
+        dst.add_face(vertices[tri.v[0]], vertices[tri.v[1]], vertices[tri.v[2]]);
+    }
+}
+
+/**
+* @brief Create an aliceVision::Mesh from an OpenMesh triangle mesh
+*
+* @note only initialize vertices and triangles, the OpenMesh mesh must be garbage collected
+*       (the vertex indices are used as is)
+* @param[in] the source OpenMesh mesh
+* @param[out] the destination aliceVision mesh
+*/
+template <typename OMesh>
+void fromOpenMesh(const OMesh& src, Mesh& dst)
+{
+    dst.pts = StaticVector<Point3d>();
+    dst.pts.resize(src.n_vertices());
+    for(const auto& vh : src.vertices())
+    {
+        const auto& point = src.point(vh);
+        dst.pts[vh.idx()] = Point3d(point[0], point[1], point[2]);
+    }
+
+    dst.tris = StaticVector<Mesh::triangle>();
+    dst.tris.reserve(src.n_faces());
+    for(const auto& fh : src.faces())
+    {
+        int v[3];
+        int k = 0;
+        for(auto fv = src.cfv_iter(fh); fv.is_valid() && k < 3; ++fv)
+            v[k++] = fv->idx();
+        if(k == 3)
+            dst.tris.push_back(Mesh::triangle(v[0], v[1], v[2]));
+    }
+    dst.invalidateConnectivity();
+}
+
+/**
+* @brief Load a mesh file in an OpenMesh triangle mesh.
+* PLY and native files are read with aliceVision::Mesh (for the binary layouts and the visibilities
+* written by AliceVision), the other formats with OpenMesh.
+* @return false if the file can't be read
+*/
+template <typename OMesh>
+bool loadOpenMesh(const std::string& filepath, OMesh& dst)
+{
+    const Mesh::EFileType fileType = Mesh::getFileType(filepath);
+    if(fileType != Mesh::EFileType::PLY && fileType != Mesh::EFileType::NATIVE)
+        return OpenMesh::IO::read_mesh(dst, filepath);
+
+    Mesh mesh;
+    if(!mesh.load(filepath))
+        return false;
+    toOpenMesh(mesh, dst);
+    return true;
+}
+
+/**
+* @brief Save an OpenMesh triangle mesh, see loadOpenMesh
+* @return false if the file can't be written
+*/
+template <typename OMesh>
+bool saveOpenMesh(const std::string& filepath, const OMesh& src)
+{
+    const Mesh::EFileType fileType = Mesh::getFileType(filepath);
+    if(fileType != Mesh::EFileType::PLY && fileType != Mesh::EFileType::NATIVE)
+        return OpenMesh::IO::write_mesh(src, filepath);
+
+    Mesh mesh;
+    fromOpenMesh(src, mesh);
+    return mesh.save(filepath);
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -8,6 +8,7 @@
 
 #include <aliceVision/config.hpp>
 #include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/multiview/essential.hpp>
 #include <aliceVision/robustEstimation/conditioning.hpp>
 #include <aliceVision/robustEstimation/ISolver.hpp>
 #include <aliceVision/robustEstimation/PointFittingRansacKernel.hpp>
@@ -69,6 +70,12 @@ public:
     }
   }
 
+  void errors(const ModelT_& model, std::vector<double>& errors) const override
+  {
+    // batched evaluation of all the correspondences
+    PFRansacKernel::PFKernel::_errorEstimator.errors(model, PFRansacKernel::PFKernel::_x1, PFRansacKernel::PFKernel::_x2, errors);
+  }
+
   void unnormalize(ModelT_& model) const override
   {
     // Unnormalize model from the computed conditioning.
@@ -154,6 +161,15 @@ public:
     return _errorEstimator.error(modelF, PFRansacKernel::PFKernel::_x1.col(sample), PFRansacKernel::PFKernel::_x2.col(sample));
   }
 
+  void errors(const ModelT_& model, std::vector<double>& errors) const override
+  {
+    // the fundamental matrix is computed once for all the correspondences
+    Mat3 F;
+    fundamentalFromEssential(model.getMatrix(), _K1, _K2, &F);
+    const ModelT_ modelF(F);
+    _errorEstimator.errors(modelF, PFRansacKernel::PFKernel::_x1, PFRansacKernel::PFKernel::_x2, errors);
+  }
+
   void unnormalize(ModelT_& model) const override
   {
     // do nothing, no normalization in this case
@@ -48,6 +48,12 @@ public:
     robustEstimation::normalizePointsFromImageSize(x2d, &_x2d, &_N1, w, h);
   }
 
+  void errors(const ModelT_& model, std::vector<double>& errors) const override
+  {
+    // batched evaluation of all the correspondences
+    KernelBase::PFKernel::_errorEstimator.errors(model, KernelBase::PFKernel::_x1, KernelBase::PFKernel::_x2, errors);
+  }
+
   void unnormalize(ModelT_& model) const override
   {
     // unnormalize model from the computed conditioning.
@@ -115,6 +121,12 @@ public:
     robustEstimation::applyTransformationToPoints(x2d, _N1, &_x2d);
   }
 
+  void errors(const ModelT_& model, std::vector<double>& errors) const override
+  {
+    // batched evaluation of all the correspondences
+    KernelBase::PFKernel::_errorEstimator.errors(model, KernelBase::PFKernel::_x1, KernelBase::PFKernel::_x2, errors);
+  }
+
   void unnormalize(ModelT_& model) const override
   {
     // unnormalize model from the computed conditioning.
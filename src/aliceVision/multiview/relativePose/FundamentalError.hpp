@@ -15,6 +15,44 @@ namespace aliceVision {
 namespace multiview {
 namespace relativePose {
 
+/**
+ * @brief Epipolar lines of a batch of correspondences, evaluated on arrays
+ *        (one coefficient per correspondence) to be vectorized.
+ * @note The sums follow the evaluation order of the Eigen fixed size products,
+ *       the batched errors are the same as the errors of each correspondence.
+ */
+struct EpipolarLines
+{
+  /**
+   * @param[in] F The fundamental matrix
+   * @param[in] x1 The points in the first view, one per column
+   * @param[in] x2 The points in the second view, one per column
+   */
+  EpipolarLines(const Mat3& F, const Mat& x1, const Mat& x2)
+    : u1(x1.row(0).transpose().array())
+    , v1(x1.row(1).transpose().array())
+    , u2(x2.row(0).transpose().array())
+    , v2(x2.row(1).transpose().array())
+  {
+    // epipolar lines of x1 in the second view: F * x1
+    F_x0 = F(0, 0) * u1 + (F(0, 1) * v1 + F(0, 2));
+    F_x1 = F(1, 0) * u1 + (F(1, 1) * v1 + F(1, 2));
+    F_x2 = F(2, 0) * u1 + (F(2, 1) * v1 + F(2, 2));
+
+    // epipolar lines of x2 in the first view: F^t * x2 (only the normal is needed)
+    Ft_y0 = F(0, 0) * u2 + (F(1, 0) * v2 + F(2, 0));
+    Ft_y1 = F(0, 1) * u2 + (F(1, 1) * v2 + F(2, 1));
+
+    // epipolar constraint: x2^t * F * x1
+    yFx = u2 * F_x0 + (v2 * F_x1 + F_x2);
+  }
+
+  Eigen::ArrayXd u1, v1, u2, v2;
+  Eigen::ArrayXd F_x0, F_x1, F_x2;
+  Eigen::ArrayXd Ft_y0, Ft_y1;
+  Eigen::ArrayXd yFx;
+};
+
 /**
  * @brief Compute FundamentalSampsonError related to the Fundamental matrix and 2 correspondences
  */
@@ -31,6 +69,14 @@ struct FundamentalSampsonError : public ISolverErrorRelativePose<robustEstimatio
 
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm() + Ft_y.head<2>().squaredNorm());
   }
+
+  void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+  {
+    const EpipolarLines l(F.getMatrix(), x1, x2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::ArrayXd> e(errors.data(), errors.size());
+    e = l.yFx.square() / ((l.F_x0.square() + l.F_x1.square()) + (l.Ft_y0.square() + l.Ft_y1.square()));
+  }
 };
 
 struct FundamentalSymmetricEpipolarDistanceError: public ISolverErrorRelativePose<robustEstimation::Mat3Model>
@@ -47,6 +93,14 @@ struct FundamentalSymmetricEpipolarDistanceError: public ISolverErrorRelativePos
     // @note the divide by 4 is to make this match the Sampson distance.
     return Square(y.dot(F_x)) * ( 1.0 / F_x.head<2>().squaredNorm() + 1.0 / Ft_y.head<2>().squaredNorm()) / 4.0;
   }
+
+  void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+  {
+    const EpipolarLines l(F.getMatrix(), x1, x2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::ArrayXd> e(errors.data(), errors.size());
+    e = l.yFx.square() * ((l.F_x0.square() + l.F_x1.square()).inverse() + (l.Ft_y0.square() + l.Ft_y1.square()).inverse()) / 4.0;
+  }
 };
 
 struct FundamentalEpipolarDistanceError : public ISolverErrorRelativePose<robustEstimation::Mat3Model>
@@ -61,6 +115,14 @@ struct FundamentalEpipolarDistanceError : public ISolverErrorRelativePose<robust
 
     return Square(F_x.dot(y)) /  F_x.head<2>().squaredNorm();
   }
+
+  void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+  {
+    const EpipolarLines l(F.getMatrix(), x1, x2);
+    errors.resize(x1.cols());
+    Eigen::Map<Eigen::ArrayXd> e(errors.data(), errors.size());
+    e = l.yFx.square() / (l.F_x0.square() + l.F_x1.square());
+  }
 };
 
 
@@ -28,6 +28,22 @@ struct HomographyAsymmetricError : ISolverErrorRelativePose<robustEstimation::Ma
         const Vec2 x2_est = x2h_est.head<2>() / x2h_est[2];
         return (x2 - x2_est).squaredNorm();
     }
+
+    void errors(const robustEstimation::Mat3Model& H, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+    {
+        const Mat3& h = H.getMatrix();
+        const Eigen::ArrayXd u1 = x1.row(0).transpose().array();
+        const Eigen::ArrayXd v1 = x1.row(1).transpose().array();
+
+        // transfer of x1 in the second view
+        const Eigen::ArrayXd w = h(2, 0) * u1 + (h(2, 1) * v1 + h(2, 2));
+        const Eigen::ArrayXd du = x2.row(0).transpose().array() - (h(0, 0) * u1 + (h(0, 1) * v1 + h(0, 2))) / w;
+        const Eigen::ArrayXd dv = x2.row(1).transpose().array() - (h(1, 0) * u1 + (h(1, 1) * v1 + h(1, 2))) / w;
+
+        errors.resize(x1.cols());
+        Eigen::Map<Eigen::ArrayXd> e(errors.data(), errors.size());
+        e = du.square() + dv.square();
+    }
 };
 
 }  // namespace relativePose
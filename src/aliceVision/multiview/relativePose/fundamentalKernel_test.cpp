@@ -133,3 +133,33 @@ BOOST_AUTO_TEST_CASE(NormalizedFundamental8PKernel_EasyCase)
 
   BOOST_CHECK(expectKernelProperties<relativePose::NormalizedFundamental8PKernel>(x1, x2));
 }
+
+// check that the batched evaluation of the errors matches the evaluation of each correspondence
+template<typename ErrorT>
+void expectBatchedErrors(const Mat3& F, const Mat& x1, const Mat& x2)
+{
+  const ErrorT errorEstimator;
+  const robustEstimation::Mat3Model model(F);
+
+  std::vector<double> errors;
+  errorEstimator.errors(model, x1, x2, errors);
+
+  BOOST_REQUIRE_EQUAL(errors.size(), x1.cols());
+  for(Mat::Index i = 0; i < x1.cols(); ++i)
+    BOOST_CHECK_CLOSE(errors[i], errorEstimator.error(model, x1.col(i), x2.col(i)), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(FundamentalError_Batched)
+{
+  Mat3 F;
+  F << 1e-6, -2e-5, 3e-3,
+       4e-5, 1e-6, -2e-2,
+       -5e-3, 3e-2, 1.0;
+
+  const Mat x1 = Mat::Random(2, 100) * 500.0;
+  const Mat x2 = Mat::Random(2, 100) * 500.0;
+
+  expectBatchedErrors<relativePose::FundamentalSampsonError>(F, x1, x2);
+  expectBatchedErrors<relativePose::FundamentalSymmetricEpipolarDistanceError>(F, x1, x2);
+  expectBatchedErrors<relativePose::FundamentalEpipolarDistanceError>(F, x1, x2);
+}
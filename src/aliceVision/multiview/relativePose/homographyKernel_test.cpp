@@ -100,3 +100,25 @@ BOOST_AUTO_TEST_CASE(Homography4PKernel_Fitting)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(HomographyError_Batched)
+{
+  Mat3 H;
+  H << 1.1, 0.05, 20.0,
+       -0.03, 0.95, -10.0,
+       1e-5, 2e-5, 1.0;
+
+  const Mat x1 = Mat::Random(2, 100) * 500.0;
+  const Mat x2 = Mat::Random(2, 100) * 500.0;
+
+  const relativePose::HomographyAsymmetricError errorEstimator;
+  const robustEstimation::Mat3Model model(H);
+
+  // the batched evaluation of the errors matches the evaluation of each correspondence
+  std::vector<double> errors;
+  errorEstimator.errors(model, x1, x2, errors);
+
+  BOOST_REQUIRE_EQUAL(errors.size(), x1.cols());
+  for(Mat::Index i = 0; i < x1.cols(); ++i)
+    BOOST_CHECK_CLOSE(errors[i], errorEstimator.error(model, x1.col(i), x2.col(i)), 1e-10);
+}
@@ -16,6 +16,28 @@ namespace aliceVision {
 namespace multiview {
 namespace resection {
 
+/**
+ * @brief Compute the squared reprojection error of each correspondence, evaluated on arrays to be vectorized
+ * @param[in] P The projection matrix
+ * @param[in] x2d The 2D points, one per column
+ * @param[in] x3d The 3D points, one per column
+ * @param[out] errors The squared error of each correspondence
+ */
+inline void projectionSquaredErrors(const Mat34& P, const Mat& x2d, const Mat& x3d, std::vector<double>& errors)
+{
+  const Eigen::ArrayXd X = x3d.row(0).transpose().array();
+  const Eigen::ArrayXd Y = x3d.row(1).transpose().array();
+  const Eigen::ArrayXd Z = x3d.row(2).transpose().array();
+
+  const Eigen::ArrayXd w = (P(2, 0) * X + (P(2, 1) * Y + P(2, 2) * Z)) + P(2, 3);
+  const Eigen::ArrayXd du = ((P(0, 0) * X + (P(0, 1) * Y + P(0, 2) * Z)) + P(0, 3)) / w - x2d.row(0).transpose().array();
+  const Eigen::ArrayXd dv = ((P(1, 0) * X + (P(1, 1) * Y + P(1, 2) * Z)) + P(1, 3)) / w - x2d.row(1).transpose().array();
+
+  errors.resize(x2d.cols());
+  Eigen::Map<Eigen::ArrayXd> e(errors.data(), errors.size());
+  e = du.square() + dv.square();
+}
+
 /**
  * @brief Compute the residual of the projection distance
  *        (pt2D, project(P,pt3D))
@@ -26,6 +48,13 @@ struct ProjectionDistanceError : public ISolverErrorResection<robustEstimation::
   {
     return (project(P.getMatrix(), p3d) - p2d).norm();
   }
+
+  void errors(const robustEstimation::Mat34Model& P, const Mat& x2d, const Mat& x3d, std::vector<double>& errors) const override
+  {
+    projectionSquaredErrors(P.getMatrix(), x2d, x3d, errors);
+    Eigen::Map<Eigen::ArrayXd> e(errors.data(), errors.size());
+    e = e.sqrt();
+  }
 };
 
 /**
@@ -38,6 +67,11 @@ struct ProjectionDistanceSquaredError : public ISolverErrorResection<robustEstim
   {
     return (project(P.getMatrix(), p3d) - p2d).squaredNorm();
   }
+
+  void errors(const robustEstimation::Mat34Model& P, const Mat& x2d, const Mat& x3d, std::vector<double>& errors) const override
+  {
+    projectionSquaredErrors(P.getMatrix(), x2d, x3d, errors);
+  }
 };
 
 }  // namespace resection
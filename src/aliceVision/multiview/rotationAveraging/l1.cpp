@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "l1.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #ifdef ALICEVISION_ROTATION_AVERAGING_WITH_BOOST
@@ -30,6 +31,8 @@
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
 
+#include <Eigen/SparseCholesky>
+
 #include <map>
 #include <queue>
 #include <stdint.h>
@@ -44,6 +47,44 @@ namespace aliceVision   {
 namespace rotationAveraging  {
 namespace l1  {
 
+// Solver of the (symmetric positive definite) normal equations built from A:
+// - dense A: dense LDLT,
+// - sparse A: sparse LDLT, the sparsity pattern of the view graph is analysed once
+//   and reused for all the iterations.
+template<typename MATRIX_TYPE>
+struct NormalEquationsSolver
+{
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+
+  void analyzePattern(const Matrix&) {}
+  bool factorize(const Matrix& H)
+  {
+    _solver.compute(H);
+    return _solver.info() == Eigen::Success;
+  }
+  template<typename VECTOR_TYPE>
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1> solve(const VECTOR_TYPE& b) const { return _solver.solve(b); }
+
+  Eigen::LDLT<Matrix> _solver;
+};
+
+template<>
+struct NormalEquationsSolver<Eigen::SparseMatrix<REAL, Eigen::ColMajor> >
+{
+  typedef Eigen::SparseMatrix<REAL, Eigen::ColMajor> Matrix;
+
+  void analyzePattern(const Matrix& H) { _solver.analyzePattern(H); }
+  bool factorize(const Matrix& H)
+  {
+    _solver.factorize(H);
+    return _solver.info() == Eigen::Success;
+  }
+  template<typename VECTOR_TYPE>
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1> solve(const VECTOR_TYPE& b) const { return _solver.solve(b); }
+
+  Eigen::SimplicialLDLT<Matrix> _solver;
+};
+
 // Minimum l1 error approximation:
 //
 // Let A be a M x N matrix with full rank. Given y of R^M, the problem
@@ -67,7 +108,6 @@ inline bool TRobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& xp,
   REAL pdtol, unsigned pdmaxiter)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned M = (unsigned)y.size();
   const unsigned N = (unsigned)xp.size();
@@ -100,7 +140,8 @@ inline bool TRobustRegressionL1PD(
   Vector w2(M), sig1(M), sig2(M), sigx(M), dx(N), up(N), Atdv(N);
   Vector Axp(M), Atvp(M);
   Vector &Adx(sigx), &du(w2), &w1p(dx);
-  Matrix H11p(N,N);
+  NormalEquationsSolver<MATRIX_TYPE> solver;
+  typename NormalEquationsSolver<MATRIX_TYPE>::Matrix H11p(N,N);
   Vector &dlamu1(tmpM3), &dlamu2(tmpM4);
   for (unsigned pditer=0; pditer<pdmaxiter; ++pditer) {
     // surrogate duality gap
@@ -131,7 +172,11 @@ inline bool TRobustRegressionL1PD(
     w1p = At*(tmpM4 - tmpM3 - (sig2.cwiseQuotient(sig1).cwiseProduct(w2)));
 
     // optimized solver as A is positive definite and symmetric
-    dx = H11p.ldlt().solve(w1p);
+    if (pditer == 0)
+      solver.analyzePattern(H11p);
+    if (!solver.factorize(H11p))
+      return false;
+    dx = solver.solve(w1p);
 
     Adx = A*dx;
 
@@ -205,6 +250,40 @@ inline bool TRobustRegressionL1PD(
   return true;
 }
 
+// Minimum l1 error approximation by Iteratively Reweighted Least Squares:
+// each iteration solves the least squares problem weighted by 1/max(|y-Ax|, delta).
+// It needs far fewer factorizations of the normal equations than the primal-dual
+// iterations above, which makes it the method of choice on large sparse problems.
+inline bool TRobustRegressionL1IRLS(
+  const Eigen::SparseMatrix<REAL, Eigen::ColMajor>& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& y,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL delta, unsigned maxiter, REAL eps)
+{
+  typedef Eigen::SparseMatrix<REAL, Eigen::ColMajor> Matrix;
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
+  const unsigned M = (unsigned)y.size();
+  assert(A.rows() == M && A.cols() == x.size());
+
+  NormalEquationsSolver<Matrix> solver;
+  Vector w(M), xp;
+  for (unsigned iter=0; iter<maxiter; ++iter) {
+    w = (y - A*x).cwiseAbs().cwiseMax(delta).cwiseInverse();
+    const Matrix AtW(A.transpose()*w.asDiagonal());
+    const Matrix AtWA(AtW*A);
+    if (iter == 0)
+      solver.analyzePattern(AtWA);
+    if (!solver.factorize(AtWA))
+      return false;
+    xp = solver.solve(AtW*y);
+    const REAL change = (xp-x).norm();
+    x.swap(xp);
+    if (change <= eps*std::max(REAL(1), x.norm()))
+      break;
+  }
+  return true;
+}
+
 bool RobustRegressionL1PD(
   const Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic>& A,
   const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
@@ -222,6 +301,15 @@ bool RobustRegressionL1PD(
   return TRobustRegressionL1PD(A, b, x, pdtol, pdmaxiter);
 }
 
+bool RobustRegressionL1IRLS(
+  const Eigen::SparseMatrix<REAL, Eigen::ColMajor>& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL delta, unsigned maxiter, REAL eps)
+{
+  return TRobustRegressionL1IRLS(A, b, x, delta, maxiter, eps);
+}
+
 /*----------------------------------------------------------------*/
 
 // Iteratively Re-weighted Least Squares (IRLS) implementation
@@ -232,7 +320,6 @@ inline bool TIterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned m = (unsigned)b.size();
   const unsigned n = (unsigned)x.size();
@@ -243,6 +330,7 @@ inline bool TIterativelyReweightedLeastSquares(
   const REAL sigmaSq(Square(sigma));
   unsigned iter = 0;
   REAL delta = std::numeric_limits<REAL>::max(), deltap;
+  NormalEquationsSolver<MATRIX_TYPE> solver;
   do {
     xp = x;
     // compute error vector
@@ -255,16 +343,15 @@ inline bool TIterativelyReweightedLeastSquares(
     }
     // solve the linear system using l2 norm
     const MATRIX_TYPE AtF(A.transpose()*e.asDiagonal());
-    const Eigen::LDLT<Matrix> solver(AtF*A); // compute the Cholesky decomposition
-    if (solver.info() != Eigen::Success) {
+    const typename NormalEquationsSolver<MATRIX_TYPE>::Matrix AtFA(AtF*A);
+    if (iter == 0)
+      solver.analyzePattern(AtFA);
+    // compute the Cholesky decomposition
+    if (!solver.factorize(AtFA)) {
       ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
       return false;
     }
     x = solver.solve(AtF*b);
-    if (solver.info() != Eigen::Success) {
-      ALICEVISION_LOG_WARNING("error: solving linear system failed");
-      return false;
-    }
     if (++iter > 32)
       break;
     deltap = delta; delta = (xp-x).norm();
@@ -434,6 +521,7 @@ unsigned int FilterRelativeRotations(
   assert(threshold >= 0);
   // compute errors for each relative rotation
   std::vector<float> errors(RelRs.size());
+  #pragma omp parallel for
   for(int r= 0; r<RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
@@ -578,24 +666,26 @@ inline void _FillMappingMatrix(
   const size_t nMainViewID,
   Eigen::SparseMatrix<REAL,Eigen::ColMajor>& A)
 {
-  A.reserve(A.rows()*2); // estimate of the number of non-zeros (optional)
+  std::vector<Eigen::Triplet<REAL> > triplets;
+  triplets.reserve(RelRs.size()*6);
   Eigen::SparseMatrix<REAL,Eigen::ColMajor>::Index i = 0, j = 0;
   for(int r=0; r<RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     if (relR.i != nMainViewID) {
       j = 3*(relR.i<nMainViewID ? relR.i : relR.i-1);
-      A.insert(i+0,j+0) = REAL(-1);
-      A.insert(i+1,j+1) = REAL(-1);
-      A.insert(i+2,j+2) = REAL(-1);
+      triplets.emplace_back(i+0, j+0, REAL(-1));
+      triplets.emplace_back(i+1, j+1, REAL(-1));
+      triplets.emplace_back(i+2, j+2, REAL(-1));
     }
     if (relR.j != nMainViewID) {
       j = 3*(relR.j<nMainViewID ? relR.j : relR.j-1);
-      A.insert(i+0,j+0) = REAL(1);
-      A.insert(i+1,j+1) = REAL(1);
-      A.insert(i+2,j+2) = REAL(1);
+      triplets.emplace_back(i+0, j+0, REAL(1));
+      triplets.emplace_back(i+1, j+1, REAL(1));
+      triplets.emplace_back(i+2, j+2, REAL(1));
     }
     i+=3;
   }
+  A.setFromTriplets(triplets.begin(), triplets.end());
   A.makeCompressed();
 }
 
@@ -605,7 +695,8 @@ inline void _FillErrorMatrix(
   const Matrix3x3Arr& Rs,
   Eigen::Matrix<REAL,Eigen::Dynamic,1>& b)
 {
-  for (size_t r = 0; r < RelRs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < RelRs.size(); ++r) {
     const RelativeRotation& relR = RelRs[r];
     const Matrix3x3& Ri = Rs[relR.i];
     const Matrix3x3& Rj = Rs[relR.j];
@@ -623,7 +714,8 @@ inline void _CorrectMatrix(
   const size_t nMainViewID,
   Matrix3x3Arr& Rs)
 {
-  for (size_t r = 0; r < Rs.size(); ++r) {
+  #pragma omp parallel for
+  for (int r = 0; r < Rs.size(); ++r) {
     if (r == nMainViewID)
       continue;
     Matrix3x3& Ri = Rs[r];
@@ -658,6 +750,9 @@ bool RefineRotationsAvgL1IRLS(
   Eigen::SparseMatrix<REAL,Eigen::ColMajor> A(m, n);
   _FillMappingMatrix(RelRs, nMainViewID, A);
 
+  // the primal-dual l1 solver needs too many factorizations on large view graphs
+  const bool bLargeGraph = (nVars > 1000);
+
   // init x with 0 that corresponds to trusting completely the initial Ri guess
   Vec x(Vec::Zero(n)), b(m);
 
@@ -668,7 +763,8 @@ bool RefineRotationsAvgL1IRLS(
     // compute errors for each relative rotation
     _FillErrorMatrix(RelRs, Rs, b);
     // solve the linear system using l1 norm
-    if (!RobustRegressionL1PD(A, b, x)) {
+    const bool bL1 = bLargeGraph ? RobustRegressionL1IRLS(A, b, x) : RobustRegressionL1PD(A, b, x);
+    if (!bL1) {
       ALICEVISION_LOG_WARNING("error: l1 robust regression failed.");
       return false;
     }
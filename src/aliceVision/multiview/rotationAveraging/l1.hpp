@@ -100,6 +100,13 @@ bool RobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL pdtol=1e-3, unsigned pdmaxiter=50);
 
+// L1 minimization by IRLS for sparse A matrix
+bool RobustRegressionL1IRLS(
+  const Eigen::SparseMatrix<REAL, Eigen::ColMajor>& A,
+  const Eigen::Matrix<REAL, Eigen::Dynamic, 1>& b,
+  Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
+  REAL delta=1e-4, unsigned maxiter=16, REAL eps=1e-3);
+
 /// IRLS [1] for dense A matrix
 bool IterativelyReweightedLeastSquares(
   const Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic>& A,
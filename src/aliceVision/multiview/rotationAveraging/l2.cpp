@@ -10,6 +10,8 @@
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 
+#include <Eigen/SparseCholesky>
+
 #include <vector>
 #include <map>
 
@@ -45,15 +47,9 @@ Mat3 ClosestSVDRotationMatrix(const Mat3 & rotMat)
   return U*V.transpose();
 }
 
-// <eigenvalue, eigenvector> pair comparator
-bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> const &y)
-{
- return fabs(x.first) < fabs(y.first);
-}
-
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
-//    [1] formula 6.62 page 100. Dense formulation.
+//    [1] formula 6.62 page 100. Sparse formulation.
 //- nCamera:               The number of camera to solve
 //- vec_rotationEstimate:  The relative rotation i->j
 //- vec_ApprRotMatrix:     The output global rotation
@@ -62,6 +58,10 @@ bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> c
 // => || wij * (rj - Rij * ri) ||= 0
 // With rj et rj the global rotation and Rij the relative rotation from i to j.
 //
+// The gauge freedom is removed by setting R0 to Identity: each column of the
+// other rotations is then the solution of a sparse linear least squares problem
+// (all the columns share the same normal equations).
+//
 // Example:
 // 0_______2
 //  \     /
@@ -79,12 +79,18 @@ bool L2RotationAveraging( size_t nCamera,
   // Output
   std::vector<Mat3> & vec_ApprRotMatrix)
 {
+  if (nCamera < 2)
+    return false;
+
   const size_t nRotationEstimation = vec_relativeRot.size();
   //--
-  // Setup the Action Matrix
+  // Setup the Action Matrix (without the columns of the camera 0)
   //--
   std::vector<Eigen::Triplet<double> > tripletList;
   tripletList.reserve(nRotationEstimation*12); // 3*3 + 3
+  // right hand sides (one per column of the rotations)
+  Mat B = Mat::Zero(nRotationEstimation*3, 3);
+
   //-- Encode constraint (6.62 Martinec Thesis page 100):
   sMat::Index cpt = 0;
   for(RelativeRotations::const_iterator
@@ -92,93 +98,63 @@ bool L2RotationAveraging( size_t nCamera,
     iter != vec_relativeRot.end();
     iter++, cpt++)
   {
-   const RelativeRotation & Elem = *iter;
-
-   //-- Encode weight * ( rj - Rij * ri ) = 0
-   const size_t i = iter->i;
-   const size_t j = iter->j;
-
-   // A.block<3,3>(3 * cpt, 3 * i) = - Rij * weight;
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * i, - iter->Rij(0,0) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * i + 1, - iter->Rij(0,1) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * i + 2, - iter->Rij(0,2) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * i, - iter->Rij(1,0) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * i + 1, - iter->Rij(1,1) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * i + 2, - iter->Rij(1,2) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * i, - iter->Rij(2,0) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * i + 1, - iter->Rij(2,1) * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * i + 2, - iter->Rij(2,2) * iter->weight));
-
-   // A.block<3,3>(3 * cpt, 3 * j) = Id * weight;
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt, 3 * j, 1.0 * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 1, 3 * j + 1, 1.0 * iter->weight));
-   tripletList.push_back(Eigen::Triplet<double>(3 * cpt + 2, 3 * j + 2, 1.0 * iter->weight));
+    //-- Encode weight * ( rj - Rij * ri ) = 0
+    const size_t i = iter->i;
+    const size_t j = iter->j;
+    const Mat3 wRij = iter->Rij * iter->weight;
+
+    // A.block<3,3>(3 * cpt, 3 * i) = - Rij * weight;
+    if (i == 0)
+      B.block<3,3>(3 * cpt, 0) += wRij;
+    else
+    {
+      for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+          tripletList.emplace_back(3 * cpt + r, 3 * (i - 1) + c, - wRij(r, c));
+    }
+
+    // A.block<3,3>(3 * cpt, 3 * j) = Id * weight;
+    if (j == 0)
+      B.block<3,3>(3 * cpt, 0) -= Mat3::Identity() * iter->weight;
+    else
+    {
+      for (int r = 0; r < 3; ++r)
+        tripletList.emplace_back(3 * cpt + r, 3 * (j - 1) + r, iter->weight);
+    }
   }
 
-  // nCamera * 3 because each columns have 3 elements.
-  sMat A(nRotationEstimation*3, 3*nCamera);
+  // (nCamera - 1) * 3 because each columns have 3 elements.
+  sMat A(nRotationEstimation*3, 3*(nCamera-1));
   A.setFromTriplets(tripletList.begin(), tripletList.end());
   tripletList.clear();
 
-  sMat AtAsparse = A.transpose() * A;
-  const Mat AtA = Mat(AtAsparse); // convert to dense
-
-  // You can use either SVD or eigen solver (eigen solver will be faster) to solve Ax=0
+  // Solve the normal equations (sparse and positive definite if the graph is connected)
+  const sMat At = A.transpose();
+  const Eigen::SimplicialLDLT<sMat> solver(At * A);
+  if (solver.info() != Eigen::Success)
+    return false;
 
-  // Solve Ax=0 => SVD
-  //Eigen::JacobiSVD<Mat> svd(A,Eigen::ComputeFullV);
-  //const Vec & NullspaceVector0 = svd.matrixV().col(A.cols()-1);
-  //const Vec & NullspaceVector1 = svd.matrixV().col(A.cols()-2);
-  //const Vec & NullspaceVector2 = svd.matrixV().col(A.cols()-3);
+  const Mat X = solver.solve(At * B);
+  if (solver.info() != Eigen::Success)
+    return false;
 
-  // Solve Ax=0 => eigen vectors
-  Eigen::SelfAdjointEigenSolver<Mat> es(AtA, Eigen::ComputeEigenvectors);
+  //--
+  // Search the closest matrix :
+  //  - Get back columns and reconstruct Rotation matrix
+  //  - Enforce the orthogonality constraint
+  //     (approximate rotation in the Frobenius norm using SVD).
+  //--
+  vec_ApprRotMatrix.resize(nCamera);
+  vec_ApprRotMatrix[0] = Mat3::Identity();
 
-  if (es.info() != Eigen::Success)
+  #pragma omp parallel for
+  for(int i = 1; i < nCamera; ++i)
   {
-    return false;
+    //-- Compute the closest SVD rotation matrix
+    vec_ApprRotMatrix[i] = ClosestSVDRotationMatrix(X.block<3,3>(3 * (i - 1), 0));
   }
-  else
-  {
-    // Sort abs(eigenvalues)
-    std::vector<std::pair<double, Vec> > eigs(AtA.cols());
-    for (size_t i = 0; i < AtA.cols(); ++i)
-    {
-      eigs[i] = std::make_pair(es.eigenvalues()[i], es.eigenvectors().col(i));
-    }
-    std::stable_sort(eigs.begin(), eigs.end(), &compare_first_abs);
-
-    const Vec & NullspaceVector0 = eigs[0].second;
-    const Vec & NullspaceVector1 = eigs[1].second;
-    const Vec & NullspaceVector2 = eigs[2].second;
-
-    //--
-    // Search the closest matrix :
-    //  - From solution of SVD get back column and reconstruct Rotation matrix
-    //  - Enforce the orthogonality constraint
-    //     (approximate rotation in the Frobenius norm using SVD).
-    //--
-    vec_ApprRotMatrix.clear();
-    vec_ApprRotMatrix.reserve(nCamera);
-    for(size_t i=0; i < nCamera; ++i)
-    {
-      Mat3 Rotation;
-      Rotation << NullspaceVector0.segment(3 * i, 3),
-                  NullspaceVector1.segment(3 * i, 3),
-                  NullspaceVector2.segment(3 * i, 3);
-
-      //-- Compute the closest SVD rotation matrix
-      Rotation = ClosestSVDRotationMatrix(Rotation);
-      vec_ApprRotMatrix.push_back(Rotation);
-    }
-    // Force R0 to be Identity
-    const Mat3 R0T = vec_ApprRotMatrix[0].transpose();
-    for(size_t i = 0; i < nCamera; ++i) {
-      vec_ApprRotMatrix[i] *= R0T;
-    }
 
-    return true;
-  }
+  return true;
 }
 
 // Ceres Functor to minimize global rotation regarding fixed relative rotation
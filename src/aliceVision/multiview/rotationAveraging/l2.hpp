@@ -34,7 +34,7 @@ Mat3 ClosestSVDRotationMatrix(const Mat3 & rotMat);
 
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
-//    [1] formula 6.62 page 100. Dense formulation.
+//    [1] formula 6.62 page 100. Sparse formulation (R0 is set to Identity).
 //- nCamera:               The number of camera to solve
 //- vec_rotationEstimate:  The relative rotation i->j
 //- vec_ApprRotMatrix:     The output global rotation
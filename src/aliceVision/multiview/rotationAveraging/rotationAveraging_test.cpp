@@ -15,6 +15,7 @@
 #include <vector>
 #include <iterator>
 #include <utility>
+#include <random>
 
 #define BOOST_TEST_MODULE rotationAveraging
 
@@ -398,3 +399,105 @@ BOOST_AUTO_TEST_CASE ( rotationAveraging_RobustRegressionL1PD)
 }
 */
 
+
+/**
+ * @brief Generate a synthetic view graph of an aerial survey:
+ *        the views are acquired along parallel strips, each view is linked to the next views
+ *        of its strip and to the closest views of the next strip.
+ *        The relative rotations are perturbed with a small noise and some outliers.
+ */
+void generateSurveyGraph(std::size_t nbViews, std::size_t stripSize, double outlierRatio,
+                         std::vector<Mat3>& globalR, RelativeRotations& relativeRotations)
+{
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(0.0, degreeToRadian(0.5));
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  globalR.resize(nbViews);
+  for(std::size_t i = 0; i < nbViews; ++i)
+    globalR[i] = RotationAroundZ(((i / stripSize) % 2) * M_PI + 0.1 * std::sin(0.05 * i)) * RotationAroundX(0.1 * std::sin(0.3 * i)) * RotationAroundY(0.1 * std::cos(0.2 * i));
+  // R0 is the reference
+  const Mat3 R0t = globalR[0].transpose();
+  for(Mat3& R : globalR)
+    R = R * R0t;
+
+  relativeRotations.clear();
+  for(std::size_t i = 0; i < nbViews; ++i)
+  {
+    const std::size_t strip = i / stripSize;
+    // position along the strips (the strips are acquired back and forth)
+    const std::size_t position = (strip % 2 == 0) ? (i % stripSize) : (stripSize - 1 - i % stripSize);
+
+    std::vector<std::size_t> neighbors;
+    for(std::size_t j = i + 1; j < std::min((strip + 1) * stripSize, i + 4); ++j)
+      neighbors.push_back(j);
+    for(int d = -1; d <= 1; ++d)
+    {
+      const int nextPosition = static_cast<int>(position) + d;
+      if(nextPosition < 0 || nextPosition >= static_cast<int>(stripSize))
+        continue;
+      const std::size_t j = (strip + 1) * stripSize + ((strip % 2 == 1) ? nextPosition : (stripSize - 1 - nextPosition));
+      if(j < nbViews)
+        neighbors.push_back(j);
+    }
+
+    for(const std::size_t j : neighbors)
+    {
+      const Mat3 Rij = globalR[j] * globalR[i].transpose();
+      const bool outlier = (uniform(generator) < outlierRatio);
+      const Mat3 perturbation = outlier ? RotationAroundX(1.0) : (RotationAroundX(noise(generator)) * RotationAroundY(noise(generator)));
+      relativeRotations.emplace_back(i, j, perturbation * Rij);
+    }
+  }
+}
+
+double maxAngularError(const std::vector<Mat3>& globalR, const std::vector<Mat3>& estimatedR)
+{
+  double maxError = 0.0;
+  for(std::size_t i = 0; i < globalR.size(); ++i)
+    maxError = std::max(maxError, radianToDegree(getRotationMagnitude(globalR[i] * estimatedR[i].transpose())));
+  return maxError;
+}
+
+BOOST_AUTO_TEST_CASE ( rotationAveraging_SurveyGraph )
+{
+  // more than 1000 views: the robust refinement uses the IRLS l1 solver of the large view graphs
+  const std::size_t nbViews = 1200;
+  const std::size_t stripSize = 40;
+
+  std::vector<Mat3> globalR;
+  RelativeRotations relativeRotations;
+
+  {
+    generateSurveyGraph(nbViews, stripSize, 0.0, globalR, relativeRotations);
+
+    std::vector<Mat3> estimatedR;
+    BOOST_CHECK(L2RotationAveraging(nbViews, relativeRotations, estimatedR));
+    BOOST_REQUIRE_EQUAL(estimatedR.size(), nbViews);
+    BOOST_CHECK_LT(maxAngularError(globalR, estimatedR), 2.0);
+  }
+  {
+    generateSurveyGraph(nbViews, stripSize, 0.01, globalR, relativeRotations);
+
+    std::vector<Mat3> estimatedR(nbViews);
+    std::vector<bool> inliers;
+    BOOST_CHECK(GlobalRotationsRobust(relativeRotations, estimatedR, 0, 0.0f, &inliers));
+    BOOST_CHECK_LT(maxAngularError(globalR, estimatedR), 2.0);
+
+    // the outliers (rotated by 1 rad) are all rejected
+    BOOST_REQUIRE_EQUAL(inliers.size(), relativeRotations.size());
+    std::size_t nbOutliers = 0;
+    std::size_t nbAcceptedOutliers = 0;
+    for(std::size_t r = 0; r < relativeRotations.size(); ++r)
+    {
+      const RelativeRotation& relR = relativeRotations[r];
+      if(getRotationMagnitude(relR.Rij * (globalR[relR.j] * globalR[relR.i].transpose()).transpose()) < 0.5)
+        continue;
+      ++nbOutliers;
+      if(inliers[r])
+        ++nbAcceptedOutliers;
+    }
+    BOOST_CHECK_GT(nbOutliers, 0);
+    BOOST_CHECK_EQUAL(nbAcceptedOutliers, 0);
+  }
+}
@@ -10,6 +10,10 @@
 namespace aliceVision {
 namespace translationAveraging {
 
+/// Number of poses above which the solvers use a preconditioned conjugate gradient
+/// instead of a sparse Cholesky factorization of the normal equations
+const int iterativeSolverMinNbPoses = 1000;
+
 /**
  * @brief Compute camera center positions from relative camera translations (translation directions).
  *
@@ -180,7 +180,14 @@ bool solve_translations_problem_softl1
   // Solve
   ceres::Solver::Options options;
   options.minimizer_progress_to_stdout = false;
-  if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
+  if (nb_poses > iterativeSolverMinNbPoses)
+  {
+    // large view graphs: preconditioned conjugate gradients on the normal equations
+    // (no factorization fill-in)
+    options.linear_solver_type = ceres::CGNR;
+    options.preconditioner_type = ceres::JACOBI;
+  }
+  else if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
       ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::CX_SPARSE) ||
       ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE))
   {
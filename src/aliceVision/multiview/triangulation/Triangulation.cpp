@@ -45,16 +45,12 @@ void TriangulateNViewAlgebraic(const Mat2X &x,
   Mat2X::Index nviews = x.cols();
   assert(static_cast<std::size_t>(nviews) == Ps.size());
 
-  Mat design(2 * nviews, 4);
+  TriangulationSystem system;
   for(Mat2X::Index i = 0; i < nviews; ++i)
   {
-    design.block<2, 4>(2 * i, 0) = SkewMatMinimal(x.col(i)) * Ps[i];
-    if(weights != nullptr)
-    {
-      design.block<2, 4>(2 * i, 0) *= (*weights)[i];
-    }
+    system.add(Ps[i], x.col(i), (weights != nullptr) ? (*weights)[i] : 1.0);
   }
-  Nullspace(&design, X);
+  system.compute(X);
 }
 
 void TriangulateNViewLORANSAC(const Mat2X& x,
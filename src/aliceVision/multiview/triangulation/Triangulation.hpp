@@ -11,6 +11,7 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/robustEstimation/ISolver.hpp>
 
+#include <cmath>
 #include <vector>
 #include <random>
 
@@ -70,6 +71,80 @@ void TriangulateNViewLORANSAC(const Mat2X &x,
                               std::vector<std::size_t> *inliersIndex = NULL,
                               const double & thresholdError = 4.0);                               
 
+/**
+ * @brief Linear system of the algebraic triangulation (same system as TriangulateNViewAlgebraic).
+ * The two rows [x]_x P of each observation are folded with Givens rotations into
+ * a 4x4 triangular factor of the system, so any number of views can be added
+ * without dynamic allocation.
+ */
+class TriangulationSystem
+{
+public:
+
+  void clear()
+  {
+    _R.setZero();
+    _nbObservations = 0;
+  }
+
+  std::size_t size() const { return _nbObservations; }
+
+  /**
+   * @brief Add an observation to the system
+   * @param[in] projMatrix The projection matrix of the view
+   * @param[in] x The 2D observation in the view
+   * @param[in] weight The weight of the observation
+   */
+  void add(const Mat34& projMatrix, const Vec2& x, double weight = 1.0)
+  {
+    // rows of SkewMatMinimal(x) * projMatrix
+    Vec4 row0 = weight * (x(1) * projMatrix.row(2) - projMatrix.row(1)).transpose();
+    Vec4 row1 = weight * (projMatrix.row(0) - x(0) * projMatrix.row(2)).transpose();
+    addRow(row0);
+    addRow(row1);
+    ++_nbObservations;
+  }
+
+  /**
+   * @brief Solve the system
+   * @param[out] X The homogeneous 3D point (unit norm)
+   */
+  void compute(Vec4* X) const
+  {
+    Mat4 R = _R;
+    Nullspace(&R, X);
+  }
+
+private:
+
+  void addRow(Vec4& row)
+  {
+    for(int k = 0; k < 4; ++k)
+    {
+      if(row(k) == 0.0)
+        continue;
+
+      // rotation zeroing row(k) against _R(k, k)
+      const double rho = std::hypot(_R(k, k), row(k));
+      const double c = _R(k, k) / rho;
+      const double s = row(k) / rho;
+
+      for(int j = k; j < 4; ++j)
+      {
+        const double a = _R(k, j);
+        const double b = row(j);
+        _R(k, j) = c * a + s * b;
+        row(j) = c * b - s * a;
+      }
+    }
+  }
+
+  /// upper triangular factor of the system
+  Mat4 _R = Mat4::Zero();
+  /// number of observations
+  std::size_t _nbObservations = 0;
+};
+
 //Iterated linear method
 
 class Triangulation
@@ -0,0 +1,120 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TriangulationBatch.hpp"
+#include "Triangulation.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace multiview {
+
+/**
+ * @brief Compute the depths and the reprojection errors of the inliers of a triangulated point
+ */
+static void computePointStatistics(const TriangulationBatch& batch,
+                                   std::size_t point,
+                                   const std::vector<unsigned char>& inliers,
+                                   TriangulatedPoint& triangulatedPoint)
+{
+  triangulatedPoint.nbInliers = 0;
+  triangulatedPoint.minDepth = std::numeric_limits<double>::max();
+  triangulatedPoint.maxResidual = 0.0;
+
+  for(std::size_t o = batch.pointBegin(point); o < batch.pointEnd(point); ++o)
+  {
+    if(!inliers[o])
+      continue;
+
+    const Vec3 proj = batch.getProjMatrix(o) * triangulatedPoint.X.homogeneous();
+    triangulatedPoint.minDepth = std::min(triangulatedPoint.minDepth, proj(2));
+    triangulatedPoint.maxResidual = std::max(triangulatedPoint.maxResidual, (proj.hnormalized() - batch.getObservation(o)).norm());
+    ++triangulatedPoint.nbInliers;
+  }
+}
+
+void triangulateBatch(const TriangulationBatch& batch,
+                      const TriangulationBatchOptions& options,
+                      std::mt19937& randomNumberGenerator,
+                      std::vector<TriangulatedPoint>& out_points,
+                      std::vector<unsigned char>& out_inliers)
+{
+  const std::size_t nbPoints = batch.nbPoints();
+
+  out_points.assign(nbPoints, TriangulatedPoint());
+  out_inliers.assign(batch.nbObservations(), 0);
+
+  // one random seed per point (in the points order)
+  std::vector<std::mt19937::result_type> seeds;
+  if(options.useLORansac)
+  {
+    seeds.resize(nbPoints);
+    for(auto& seed : seeds)
+      seed = randomNumberGenerator();
+  }
+
+  #pragma omp parallel
+  {
+    // LO-RANSAC buffers, reused for all the points of a thread
+    Mat2X features;
+    std::vector<Mat34> Ps;
+    std::vector<std::size_t> inliersIndex;
+
+    #pragma omp for schedule(dynamic, 256)
+    for(int p = 0; p < static_cast<int>(nbPoints); ++p)
+    {
+      const std::size_t begin = batch.pointBegin(p);
+      const std::size_t end = batch.pointEnd(p);
+      const std::size_t nbObservations = end - begin;
+
+      if(nbObservations < 2)
+        continue;
+
+      TriangulatedPoint& triangulatedPoint = out_points[p];
+      Vec4 X = Vec4::Zero();
+
+      if(options.useLORansac && nbObservations > 2)
+      {
+        features.resize(2, nbObservations);
+        Ps.resize(nbObservations);
+        for(std::size_t o = begin; o < end; ++o)
+        {
+          features.col(o - begin) = batch.getObservation(o);
+          Ps[o - begin] = batch.getProjMatrix(o);
+        }
+
+        std::mt19937 generator(seeds[p]);
+        inliersIndex.clear();
+        TriangulateNViewLORANSAC(features, Ps, generator, &X, &inliersIndex, options.loRansacThreshold);
+
+        for(const std::size_t i : inliersIndex)
+          out_inliers[begin + i] = 1;
+      }
+      else
+      {
+        TriangulationSystem system;
+        for(std::size_t o = begin; o < end; ++o)
+          system.add(batch.getProjMatrix(o), batch.getObservation(o));
+        system.compute(&X);
+
+        std::fill(out_inliers.begin() + begin, out_inliers.begin() + end, 1);
+      }
+
+      if(X(3) == 0.0 || !X.allFinite())
+      {
+        std::fill(out_inliers.begin() + begin, out_inliers.begin() + end, 0);
+        continue;
+      }
+
+      triangulatedPoint.X = X.hnormalized();
+      computePointStatistics(batch, p, out_inliers, triangulatedPoint);
+    }
+  }
+}
+
+} // namespace multiview
+} // namespace aliceVision
@@ -0,0 +1,139 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <cassert>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace aliceVision {
+namespace multiview {
+
+/**
+ * @brief Observations of a batch of points to triangulate.
+ * The projection matrices are shared by all the points and the observations
+ * of each point are stored contiguously (CSR layout).
+ */
+class TriangulationBatch
+{
+public:
+
+  void clear()
+  {
+    _projMatrices.clear();
+    _pointsBegin.assign(1, 0);
+    _cameraIndexes.clear();
+    _observations.clear();
+  }
+
+  /**
+   * @brief Add a camera
+   * @param[in] projMatrix The projection matrix of the camera
+   * @return the camera index
+   */
+  std::size_t addCamera(const Mat34& projMatrix)
+  {
+    _projMatrices.push_back(projMatrix);
+    return _projMatrices.size() - 1;
+  }
+
+  /**
+   * @brief Add a point, its observations are the next added observations
+   * @return the point index
+   */
+  std::size_t addPoint()
+  {
+    _pointsBegin.push_back(_observations.size());
+    return _pointsBegin.size() - 2;
+  }
+
+  /**
+   * @brief Add an observation to the last added point
+   * @param[in] cameraIndex The camera index
+   * @param[in] x The undistorted 2D observation
+   */
+  void addObservation(std::size_t cameraIndex, const Vec2& x)
+  {
+    assert(_pointsBegin.size() > 1);
+    assert(cameraIndex < _projMatrices.size());
+    _cameraIndexes.push_back(static_cast<IndexT>(cameraIndex));
+    _observations.push_back(x);
+    _pointsBegin.back() = _observations.size();
+  }
+
+  std::size_t nbPoints() const { return _pointsBegin.size() - 1; }
+  std::size_t nbObservations() const { return _observations.size(); }
+
+  /// first observation of a point
+  std::size_t pointBegin(std::size_t point) const { return _pointsBegin[point]; }
+  /// one past the last observation of a point
+  std::size_t pointEnd(std::size_t point) const { return _pointsBegin[point + 1]; }
+
+  const Mat34& getProjMatrix(std::size_t observation) const { return _projMatrices[_cameraIndexes[observation]]; }
+  const Vec2& getObservation(std::size_t observation) const { return _observations[observation]; }
+
+private:
+  /// projection matrix of each camera
+  std::vector<Mat34> _projMatrices;
+  /// first observation of each point (size: nbPoints + 1)
+  std::vector<std::size_t> _pointsBegin = std::vector<std::size_t>(1, 0);
+  /// camera index of each observation
+  std::vector<IndexT> _cameraIndexes;
+  /// undistorted 2D position of each observation
+  std::vector<Vec2> _observations;
+};
+
+/**
+ * @brief Options of the batch triangulation.
+ */
+struct TriangulationBatchOptions
+{
+  /// use a LO-RANSAC estimation for the points with more than 2 observations (algebraic DLT otherwise)
+  bool useLORansac = false;
+  /// LO-RANSAC inlier threshold on the reprojection error (in pixels)
+  double loRansacThreshold = 4.0;
+};
+
+/**
+ * @brief Result of the triangulation of a point.
+ */
+struct TriangulatedPoint
+{
+  /// 3D point
+  Vec3 X = Vec3::Zero();
+  /// number of inlier observations (0 if the triangulation failed)
+  std::size_t nbInliers = 0;
+  /// minimal depth of the point in the inlier observations
+  double minDepth = std::numeric_limits<double>::lowest();
+  /// maximal reprojection error of the inlier observations (in pixels)
+  double maxResidual = 0.0;
+};
+
+/**
+ * @brief Triangulate a batch of points in parallel.
+ * Each point is solved with fixed-size matrices (see TriangulationSystem),
+ * or with LO-RANSAC if requested. The LO-RANSAC random generators are seeded
+ * from the given generator in the points order, so the result does not depend
+ * on the number of threads.
+ * @param[in] batch The points observations
+ * @param[in] options The triangulation options
+ * @param[in] randomNumberGenerator The random number generator (only used with LO-RANSAC)
+ * @param[out] out_points The triangulated points (one per batch point)
+ * @param[out] out_inliers The inlier flag of each batch observation
+ */
+void triangulateBatch(const TriangulationBatch& batch,
+                      const TriangulationBatchOptions& options,
+                      std::mt19937& randomNumberGenerator,
+                      std::vector<TriangulatedPoint>& out_points,
+                      std::vector<unsigned char>& out_inliers);
+
+} // namespace multiview
+} // namespace aliceVision
@@ -0,0 +1,154 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/multiview/triangulation/Triangulation.hpp>
+#include <aliceVision/multiview/triangulation/TriangulationBatch.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE TriangulationBatch
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+
+/**
+ * @brief Fill a batch with the points of a dataset,
+ *        each point is seen by a different number of views.
+ */
+void fillBatch(const NViewDataSet& d, std::size_t nbViews, std::size_t nbPoints, multiview::TriangulationBatch& batch)
+{
+  batch.clear();
+  for(std::size_t j = 0; j < nbViews; ++j)
+    batch.addCamera(d.P(j));
+
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    batch.addPoint();
+    const std::size_t nbObservations = 2 + i % (nbViews - 1);
+    for(std::size_t j = 0; j < nbObservations; ++j)
+    {
+      const std::size_t view = (i + j) % nbViews;
+      batch.addObservation(view, d._x[view].col(i));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TriangulationBatch_DLT)
+{
+  const std::size_t nbViews = 6;
+  const std::size_t nbPoints = 1000;
+  const NViewDataSet d = NRealisticCamerasRing(nbViews, nbPoints);
+
+  multiview::TriangulationBatch batch;
+  fillBatch(d, nbViews, nbPoints, batch);
+  BOOST_CHECK_EQUAL(batch.nbPoints(), nbPoints);
+
+  std::mt19937 randomNumberGenerator(0);
+  std::vector<multiview::TriangulatedPoint> points;
+  std::vector<unsigned char> inliers;
+  multiview::triangulateBatch(batch, multiview::TriangulationBatchOptions(), randomNumberGenerator, points, inliers);
+
+  BOOST_CHECK_EQUAL(points.size(), nbPoints);
+  BOOST_CHECK_EQUAL(inliers.size(), batch.nbObservations());
+
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    const multiview::TriangulatedPoint& point = points[i];
+    BOOST_CHECK_EQUAL(point.nbInliers, batch.pointEnd(i) - batch.pointBegin(i));
+    BOOST_CHECK_GT(point.minDepth, 0.0);
+    BOOST_CHECK_SMALL(point.maxResidual, 1e-6);
+    BOOST_CHECK_SMALL((point.X - d._X.col(i)).norm(), 1e-6);
+
+    // same result as the single point triangulation
+    Mat2X xs(2, point.nbInliers);
+    std::vector<Mat34> Ps(point.nbInliers);
+    for(std::size_t o = batch.pointBegin(i); o < batch.pointEnd(i); ++o)
+    {
+      xs.col(o - batch.pointBegin(i)) = batch.getObservation(o);
+      Ps[o - batch.pointBegin(i)] = batch.getProjMatrix(o);
+    }
+    Vec4 X;
+    multiview::TriangulateNViewAlgebraic(xs, Ps, &X);
+    BOOST_CHECK_SMALL((X.hnormalized() - point.X).norm(), 1e-9);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TriangulationBatch_LORansac_threads)
+{
+  const std::size_t nbViews = 8;
+  const std::size_t nbPoints = 2000;
+  const NViewDataSet d = NRealisticCamerasRing(nbViews, nbPoints);
+
+  multiview::TriangulationBatch batch;
+  multiview::TriangulationBatch noisyBatch;
+  fillBatch(d, nbViews, nbPoints, batch);
+
+  // add an outlier observation to the points with at least 4 observations
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> distribution(-50.0, 50.0);
+  std::vector<bool> isOutlier;
+
+  for(std::size_t j = 0; j < nbViews; ++j)
+    noisyBatch.addCamera(d.P(j));
+
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    noisyBatch.addPoint();
+    const std::size_t nbObservations = batch.pointEnd(i) - batch.pointBegin(i);
+    for(std::size_t o = batch.pointBegin(i); o < batch.pointEnd(i); ++o)
+    {
+      const std::size_t view = (i + o - batch.pointBegin(i)) % nbViews;
+      const bool outlier = (nbObservations >= 4 && o == batch.pointBegin(i));
+      noisyBatch.addObservation(view, batch.getObservation(o) + (outlier ? Vec2(distribution(generator) + 60.0, distribution(generator)) : Vec2::Zero()));
+      isOutlier.push_back(outlier);
+    }
+  }
+
+  multiview::TriangulationBatchOptions options;
+  options.useLORansac = true;
+  options.loRansacThreshold = 4.0;
+
+  const int maxNbThreads = omp_get_max_threads();
+
+  std::vector<multiview::TriangulatedPoint> referencePoints;
+  std::vector<unsigned char> referenceInliers;
+  {
+    omp_set_num_threads(1);
+    std::mt19937 randomNumberGenerator(0);
+    multiview::triangulateBatch(noisyBatch, options, randomNumberGenerator, referencePoints, referenceInliers);
+  }
+
+  for(std::size_t o = 0; o < noisyBatch.nbObservations(); ++o)
+    BOOST_CHECK_EQUAL(referenceInliers[o] == 0, isOutlier[o]);
+
+  for(std::size_t i = 0; i < nbPoints; ++i)
+    BOOST_CHECK_SMALL((referencePoints[i].X - d._X.col(i)).norm(), 1e-6);
+
+  // the result must not depend on the number of threads
+  const int maxNbThreadsTested = std::max(2, std::min(64, maxNbThreads));
+  for(int nbThreads = 2; nbThreads <= maxNbThreadsTested; nbThreads *= 2)
+  {
+    omp_set_num_threads(nbThreads);
+    std::mt19937 randomNumberGenerator(0);
+    std::vector<multiview::TriangulatedPoint> points;
+    std::vector<unsigned char> inliers;
+    multiview::triangulateBatch(noisyBatch, options, randomNumberGenerator, points, inliers);
+
+    BOOST_CHECK(inliers == referenceInliers);
+    for(std::size_t i = 0; i < nbPoints; ++i)
+    {
+      BOOST_CHECK_EQUAL(points[i].nbInliers, referencePoints[i].nbInliers);
+      BOOST_CHECK_EQUAL(points[i].X, referencePoints[i].X);
+    }
+  }
+
+  omp_set_num_threads(maxNbThreads);
+}
@@ -26,8 +26,9 @@ GaussianPyramidNoMask::GaussianPyramidNoMask(const size_t width_base, const size
     for(int i = 0; i < _scales; i++)
     {
 
-        _pyramid_color.push_back(image::Image<image::RGBfColor>(new_width, new_height, true, image::RGBfColor(0)));
-        _filter_buffer.push_back(image::Image<image::RGBfColor>(new_width, new_height, true, image::RGBfColor(0)));
+        // the first level is the input image (not allocated here)
+        _pyramid_color.push_back((i == 0) ? image::Image<image::RGBfColor>()
+                                          : image::Image<image::RGBfColor>(new_width, new_height, true, image::RGBfColor(0)));
         new_height /= 2;
         new_width /= 2;
     }
@@ -36,11 +37,38 @@ GaussianPyramidNoMask::GaussianPyramidNoMask(const size_t width_base, const size
 bool GaussianPyramidNoMask::process(const image::Image<image::RGBfColor>& input)
 {
 
-    if(input.Height() != _pyramid_color[0].Height())
+    if(_scales == 0)
         return false;
-    if(input.Width() != _pyramid_color[0].Width())
+    if(input.Height() != _height_base)
         return false;
+    if(input.Width() != _width_base)
+        return false;
+
+    _pyramid_color[0] = input;
+    buildLevels();
+
+    return true;
+}
+
+bool GaussianPyramidNoMask::processInPlace(image::Image<image::RGBfColor>& input)
+{
+
+    if(_scales == 0)
+        return false;
+    if(input.Height() != _height_base)
+        return false;
+    if(input.Width() != _width_base)
+        return false;
+
+    _pyramid_color[0].swap(input);
+    input.resize(0, 0);
+    buildLevels();
+
+    return true;
+}
 
+void GaussianPyramidNoMask::buildLevels()
+{
     /**
      * Kernel
      */
@@ -49,24 +77,23 @@ bool GaussianPyramidNoMask::process(const image::Image<image::RGBfColor>& input)
 
     /**
      * Build pyramid
+     * A single filtering buffer is used for all the levels
      */
-    _pyramid_color[0] = input;
+    image::Image<image::RGBfColor> filtered;
     for(int lvl = 0; lvl < _scales - 1; lvl++)
     {
 
         const image::Image<image::RGBfColor>& source = _pyramid_color[lvl];
-        image::Image<image::RGBfColor>& dst = _filter_buffer[lvl];
+        filtered.resize(source.Width(), source.Height(), false);
 
         oiio::ImageSpec spec(source.Width(), source.Height(), 3, oiio::TypeDesc::FLOAT);
 
         const oiio::ImageBuf inBuf(spec, const_cast<image::RGBfColor*>(source.data()));
-        oiio::ImageBuf outBuf(spec, dst.data());
+        oiio::ImageBuf outBuf(spec, filtered.data());
         oiio::ImageBufAlgo::convolve(outBuf, inBuf, K);
 
-        downscale(_pyramid_color[lvl + 1], _filter_buffer[lvl]);
+        downscale(_pyramid_color[lvl + 1], filtered);
     }
-
-    return true;
 }
 
 bool GaussianPyramidNoMask::downscale(image::Image<image::RGBfColor>& output,
@@ -12,6 +12,11 @@ public:
 
     bool process(const image::Image<image::RGBfColor>& input);
 
+    /**
+     * @brief Build the pyramid, the input image is moved in the first level (and is left empty)
+     */
+    bool processInPlace(image::Image<image::RGBfColor>& input);
+
     bool downscale(image::Image<image::RGBfColor>& output, const image::Image<image::RGBfColor>& input);
 
     const size_t getScalesCount() const { return _scales; }
@@ -21,8 +26,10 @@ public:
     std::vector<image::Image<image::RGBfColor>>& getPyramidColor() { return _pyramid_color; }
 
 protected:
+    /// build the levels from the first one
+    void buildLevels();
+
     std::vector<image::Image<image::RGBfColor>> _pyramid_color;
-    std::vector<image::Image<image::RGBfColor>> _filter_buffer;
     size_t _width_base;
     size_t _height_base;
     size_t _scales;
@@ -1,138 +1,17 @@
 #pragma once
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/boykov_kolmogorov_max_flow.hpp>
-
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include "distance.hpp"
 #include "boundingBox.hpp"
+#include "gridMaxFlow.hpp"
 #include "imageOps.hpp"
 #include "seams.hpp"
 
 namespace aliceVision
 {
 
-/**
- * @brief Maxflow computation based on a standard Adjacency List graph reprensentation.
- *
- * @see MaxFlow_CSR which use less memory.
- */
-class MaxFlow_AdjList
-{
-public:
-    using NodeType = int;
-    using ValueType = float;
-
-    using Traits = boost::adjacency_list_traits<boost::vecS, // OutEdgeListS
-                                                boost::vecS, // VertexListS
-                                                boost::directedS,
-                                                boost::vecS // EdgeListS
-                                                >;
-    using edge_descriptor = typename Traits::edge_descriptor;
-    using vertex_descriptor = typename Traits::vertex_descriptor;
-    using vertex_size_type = typename Traits::vertices_size_type;
-    struct Edge
-    {
-        ValueType capacity{};
-        ValueType residual{};
-        edge_descriptor reverse;
-    };
-    using Graph = boost::adjacency_list<boost::vecS, // OutEdgeListS
-                                        boost::vecS, // VertexListS
-                                        boost::directedS,
-                                        boost::no_property, // VertexProperty
-                                        Edge,               // EdgeProperty
-                                        boost::no_property, // GraphProperty
-                                        boost::vecS         // EdgeListS
-                                        >;
-    using VertexIterator = typename boost::graph_traits<Graph>::vertex_iterator;
-
-public:
-    explicit MaxFlow_AdjList(size_t numNodes)
-        : _graph(numNodes + 2)
-        , _S(NodeType(numNodes))
-        , _T(NodeType(numNodes + 1))
-    {
-        VertexIterator vi, vi_end;
-        for(boost::tie(vi, vi_end) = vertices(_graph); vi != vi_end; ++vi)
-        {
-            _graph.m_vertices[*vi].m_out_edges.reserve(9);
-        }
-        _graph.m_vertices[numNodes].m_out_edges.reserve(numNodes);
-        _graph.m_vertices[numNodes + 1].m_out_edges.reserve(numNodes);
-    }
-
-    inline void addNodeToSource(NodeType n, ValueType source)
-    {
-        assert(source >= 0);
-
-        edge_descriptor edge(boost::add_edge(_S, n, _graph).first);
-        edge_descriptor reverseEdge(boost::add_edge(n, _S, _graph).first);
-
-        _graph[edge].capacity = source;
-        _graph[edge].reverse = reverseEdge;
-        _graph[reverseEdge].reverse = edge;
-        _graph[reverseEdge].capacity = source;
-    }
-
-    inline void addNodeToSink(NodeType n, ValueType sink)
-    {
-        assert(sink >= 0);
-
-        edge_descriptor edge(boost::add_edge(_T, n, _graph).first);
-        edge_descriptor reverseEdge(boost::add_edge(n, _T, _graph).first);
-
-        _graph[edge].capacity = sink;
-        _graph[edge].reverse = reverseEdge;
-        _graph[reverseEdge].reverse = edge;
-        _graph[reverseEdge].capacity = sink;
-    }
-
-    inline void addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity)
-    {
-        assert(capacity >= 0 && reverseCapacity >= 0);
-
-        edge_descriptor edge(boost::add_edge(n1, n2, _graph).first);
-        edge_descriptor reverseEdge(boost::add_edge(n2, n1, _graph).first);
-        _graph[edge].capacity = capacity;
-        _graph[edge].reverse = reverseEdge;
-
-        _graph[reverseEdge].capacity = reverseCapacity;
-        _graph[reverseEdge].reverse = edge;
-    }
-
-    void printStats() const;
-    void printColorStats() const;
-
-    inline ValueType compute()
-    {
-        vertex_size_type nbVertices(boost::num_vertices(_graph));
-        _color.resize(nbVertices, boost::white_color);
-        std::vector<edge_descriptor> pred(nbVertices);
-        std::vector<vertex_size_type> dist(nbVertices);
-
-        ValueType v = boost::boykov_kolmogorov_max_flow(_graph, boost::get(&Edge::capacity, _graph),
-                                                        boost::get(&Edge::residual, _graph),
-                                                        boost::get(&Edge::reverse, _graph), &pred[0], &_color[0],
-                                                        &dist[0], boost::get(boost::vertex_index, _graph), _S, _T);
-
-        return v;
-    }
-
-    /// is empty
-    inline bool isSource(NodeType n) const { return (_color[n] == boost::black_color); }
-    /// is full
-    inline bool isTarget(NodeType n) const { return (_color[n] == boost::white_color); }
-
-protected:
-    Graph _graph;
-    std::vector<boost::default_color_type> _color;
-    const NodeType _S; //< emptyness
-    const NodeType _T; //< fullness
-};
-
-
 bool computeSeamsMap(image::Image<unsigned char>& seams, const image::Image<IndexT>& labels);
 
 class GraphcutSeams
@@ -156,6 +35,8 @@ public:
         , _outputHeight(outputHeight)
         , _maximal_distance_change(outputWidth + outputHeight)
         , _labels(outputWidth, outputHeight, true, UndefinedIndexT)
+        , _tileSize(512)
+        , _tileMargin(64)
     {
     }
 
@@ -228,6 +109,17 @@ public:
         _maximal_distance_change = dist; 
     }
 
+    /**
+     * @brief Set the size of the tiles of the graph cuts
+     * @param[in] tileSize the size of the area kept from each tile
+     * @param[in] tileMargin the overlap of the tiles on each side
+     */
+    void setTileSize(int tileSize, int tileMargin)
+    {
+        _tileSize = tileSize;
+        _tileMargin = tileMargin;
+    }
+
     bool createInputOverlappingObservations(image::Image<PixelInfo> & graphCutInput, const BoundingBox & interestBbox)
     {
         for (auto  & otherInput : _inputs)
@@ -612,6 +504,7 @@ public:
     {
         double cost = 0.0;
 
+        #pragma omp parallel for reduction(+:cost)
         for (int y = 0; y < input.Height() - 1; y++)
         {
             for(int x = 0; x < input.Width() - 1; x++) 
@@ -740,11 +633,12 @@ public:
     bool alphaExpansion(image::Image<IndexT> & labels, const image::Image<int> & distanceMap, const image::Image<PixelInfo> & input, IndexT currentLabel)
     {
         image::Image<unsigned char> mask(labels.Width(), labels.Height(), true, 0);
-        image::Image<int> ids(labels.Width(), labels.Height(), true, -1);
         image::Image<image::RGBfColor> color_label(labels.Width(), labels.Height(), true, image::RGBfColor(0.0f, 0.0f, 0.0f));
         image::Image<image::RGBfColor> color_other(labels.Width(), labels.Height(), true, image::RGBfColor(0.0f, 0.0f, 0.0f));
 
+        size_t countValid = 0;
 
+        #pragma omp parallel for reduction(+:countValid)
         for (int y = 0; y < labels.Height(); y++) 
         {
             for (int x = 0; x < labels.Width(); x++)
@@ -796,197 +690,199 @@ public:
                 {
                     color_label(y, x) = currentColor;
                     color_other(y, x) = otherColor;
+                    countValid++;
                 }
             }
         }     
 
-        // The rectangle is a grid.
-        // However we want to ignore a lot of pixel.
-        // Let's create an index per valid pixels for graph cut reference
-        int count = 0;
-        for(int y = 0; y < labels.Height(); y++)
+        if(countValid == 0)
+        {
+            // We have no possibility for territory expansion 
+            // let's exit
+            return true;
+        }
+
+        // The area is split in overlapping tiles solved in parallel.
+        // Only the center of each tile is kept, so the seams are stitched along the tiles borders
+        // (the next iterations fix the remaining discontinuities).
+        const int countTilesX = (labels.Width() + _tileSize - 1) / _tileSize;
+        const int countTilesY = (labels.Height() + _tileSize - 1) / _tileSize;
+
+        #pragma omp parallel for schedule(dynamic)
+        for (int tileId = 0; tileId < countTilesX * countTilesY; tileId++)
+        {
+            BoundingBox core;
+            core.left = (tileId % countTilesX) * _tileSize;
+            core.top = (tileId / countTilesX) * _tileSize;
+            core.width = std::min(_tileSize, labels.Width() - core.left);
+            core.height = std::min(_tileSize, labels.Height() - core.top);
+
+            BoundingBox tile = core.dilate(_tileMargin);
+            tile.clampLeft();
+            tile.clampTop();
+            tile.clampRight(labels.Width() - 1);
+            tile.clampBottom(labels.Height() - 1);
+
+            alphaExpansionTile(labels, mask, color_label, color_other, tile, core, currentLabel);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Solve the alpha expansion graph cut on a tile
+     * @param[in,out] labels the labels, updated in the core of the tile only
+     * @param[in] mask 1 if the pixel is seen by alpha, 2 if it is owned by an other label and 3 for both
+     * @param[in] color_label the color of alpha (or of the owner if not seen by alpha)
+     * @param[in] color_other the color of the owner
+     * @param[in] tile the tile graph area
+     * @param[in] core the area of the tile where the result is kept
+     * @param[in] currentLabel alpha
+     */
+    void alphaExpansionTile(image::Image<IndexT> & labels, const image::Image<unsigned char> & mask, 
+                            const image::Image<image::RGBfColor> & color_label, const image::Image<image::RGBfColor> & color_other,
+                            const BoundingBox & tile, const BoundingBox & core, IndexT currentLabel)
+    {
+        // Skip the tiles where no pixel can change
+        bool hasCandidate = false;
+        for(int y = core.top; y <= core.getBottom() && !hasCandidate; y++)
         {
-            for(int x = 0; x < labels.Width(); x++)
+            for(int x = core.left; x <= core.getRight(); x++)
             {
-                if(mask(y, x) == 0)
+                if(mask(y, x) == 3)
                 {
-                    continue;
+                    hasCandidate = true;
+                    break;
                 }
-
-                ids(y, x) = count;
-                count++;
             }
-        }  
+        }
+
+        if(!hasCandidate)
+        {
+            return;
+        }
 
         //Create graph
-        MaxFlow_AdjList gc(count);
-        size_t countValid = 0;
+        GridMaxFlow gc(tile.width, tile.height);
 
-        for(int y = 0; y < labels.Height(); y++)
+        for(int i = 0; i < tile.height; i++)
         {
-            for(int x = 0; x < labels.Width(); x++)
+            for(int j = 0; j < tile.width; j++)
             {
+                const unsigned char m = mask(tile.top + i, tile.left + j);
 
-                // If this pixel is not valid, ignore 
-                if(mask(y, x) == 0)
+                // Pixels seen by both alpha and enemies have no terminal link:
+                // changing node owner will have no direct cost.
+                if(m != 1 && m != 2)
                 {
                     continue;
                 }
 
-                // Get this pixel ID 
-                int node_id = ids(y, x);
-
-                int ym1 = std::max(y - 1, 0);
-                int xm1 = std::max(x - 1, 0);
-                int yp1 = std::min(y + 1, labels.Height() - 1);
-                int xp1 = std::min(x + 1, labels.Width() - 1);
-
-                if(mask(y, x) == 1)
+                // Only add nodes close to borders (of the territory or of the tile)
+                bool isInside = true;
+                for(int l = -1; l <= 1 && isInside; l++)
                 {
-                    // Only add nodes close to borders 
-                    if(mask(ym1, xm1) == 1 && mask(ym1, x) == 1 && mask(ym1, xp1) == 1 &&
-                       mask(y, xm1) == 1 && mask(y, xp1) == 1 && 
-                       mask(yp1, xm1) == 1 && mask(yp1, x) == 1 && mask(yp1, xp1) == 1)
+                    for(int c = -1; c <= 1; c++)
                     {
-                        continue;
+                        const int ni = i + l;
+                        const int nj = j + c;
+                        if(ni < 0 || ni >= tile.height || nj < 0 || nj >= tile.width || mask(tile.top + ni, tile.left + nj) != m)
+                        {
+                            isInside = false;
+                            break;
+                        }
                     }
+                }
+
+                if(isInside)
+                {
+                    continue;
+                }
 
-                    
+                if(m == 1)
+                {
                     //This pixel is only seen by alpha.
                     //Enforce its domination by stating that removing this pixel
                     //from alpha territoy is infinitly costly (impossible).
-                    gc.addNodeToSource(node_id, 100000);
+                    gc.addNodeToSource(j, i, 100000);
                 }
-                else if(mask(y, x) == 2)
+                else
                 {
-                    // Only add nodes close to borders
-                    if(mask(ym1, xm1) == 2 && mask(ym1, x) == 2 && mask(ym1, xp1) == 2 &&
-                       mask(y, xm1) == 2 && mask(y, xp1) == 2 && 
-                       mask(yp1, xm1) == 2 && mask(yp1, x) == 2 && mask(yp1, xp1) == 2)
-                    {
-                        continue;
-                    }
-
                     //This pixel is only seen by an ennemy.
                     //Enforce its domination by stating that removing this pixel
                     //from ennemy territory is infinitly costly (impossible).
-                    gc.addNodeToSink(node_id, 100000);
-                }
-                else if(mask(y, x) == 3)
-                {
-
-                    // This pixel is seen by both alpha and enemies but is owned by ennemy.
-                    // Make sure that changing node owner will have no direct cost.
-                    // Connect it to both alpha and ennemy for the moment
-                    // (Graph cut will not allow a pixel to have both owners at the end).
-                    gc.addNodeToSource(node_id, 0);
-                    gc.addNodeToSink(node_id, 0);
-                    countValid++;
+                    gc.addNodeToSink(j, i, 100000);
                 }
             }
         }
 
-
-        if(countValid == 0)
-        {
-            // We have no possibility for territory expansion 
-            // let's exit
-            return true;
-        }
-
-
-        // Loop over alpha bounding box.
         // Let's define the transition cost.
         // When two neighboor pixels have different labels, there is a seam (border) cost.
         // Graph cut will try to make sure the territory will have a minimal border cost
-
-        for(int y = 0; y < labels.Height(); y++)
+        for(int i = 0; i < tile.height; i++)
         {
-            for(int x = 0; x < labels.Width(); x++)
+            const int y = tile.top + i;
+
+            for(int j = 0; j < tile.width; j++)
             {
+                const int x = tile.left + j;
 
                 if(mask(y, x) == 0)
                 {
                     continue;
                 }
 
-                int node_id = ids(y, x);
-
-                // Make sure it is possible to estimate this horizontal border
-                if(y < mask.Height() - 1)
+                // Make sure the other pixel is owned by someone
+                if(i < tile.height - 1 && mask(y + 1, x))
                 {
-                    // Make sure the other pixel is owned by someone
-                    if(mask(y + 1, x))
-                    {
-
-                        int other_node_id = ids(y + 1, x);
-                        float w = 1000;
-
-                        if(((mask(y, x) & 1) && (mask(y + 1, x) & 2)) || ((mask(y, x) & 2) && (mask(y + 1, x) & 1)))
-                        {
-                            float d1 = (color_label(y, x) - color_other(y, x)).norm();
-                            float d2 = (color_label(y + 1, x) - color_other(y + 1, x)).norm();
-
-                            d1 = std::min(2.0f, d1);
-                            d2 = std::min(2.0f, d2);
-
-                            w = (d1 + d2) * 100.0 + 1.0;
-                        }
-
-                        gc.addEdge(node_id, other_node_id, w, w);
-                    }
+                    const float w = seamCost(mask, color_label, color_other, x, y, x, y + 1);
+                    gc.addBottomEdge(j, i, w, w);
                 }
 
-                if(x < mask.Width() - 1)
+                if(j < tile.width - 1 && mask(y, x + 1))
                 {
-
-                    if(mask(y, x + 1))
-                    {
-
-                        int other_node_id = ids(y, x + 1);
-                        float w = 1000;
-
-                        if(((mask(y, x) & 1) && (mask(y, x + 1) & 2)) || ((mask(y, x) & 2) && (mask(y, x + 1) & 1)))
-                        {
-                            float d1 = (color_label(y, x) - color_other(y, x)).norm();
-                            float d2 = (color_label(y, x + 1) - color_other(y, x + 1)).norm();
-
-                            d1 = std::min(2.0f, d1);
-                            d2 = std::min(2.0f, d2);
-
-                            w = (d1 + d2) * 100.0 + 1.0;
-                        }
-
-                        gc.addEdge(node_id, other_node_id, w, w);
-                    }
+                    const float w = seamCost(mask, color_label, color_other, x, y, x + 1, y);
+                    gc.addRightEdge(j, i, w, w);
                 }
             }
         }
 
         gc.compute();
 
-        int changeCount = 0;
-        for(int y = 0; y < labels.Height(); y++)
+        for(int y = core.top; y <= core.getBottom(); y++)
         {
-            for(int x = 0; x < labels.Width(); x++)
+            for(int x = core.left; x <= core.getRight(); x++)
             {
-                IndexT label = labels(y, x);
-                int id = ids(y, x);
-
-                if(gc.isSource(id))
+                if(gc.isSource(x - tile.left, y - tile.top))
                 {
-
-                    if(label != currentLabel)
-                    {
-                        changeCount++;
-                    }
-
                     labels(y, x) = currentLabel;
                 }
             }
         }
+    }
 
-        return true;
+    /**
+     * @brief Cost of a seam between two neighboring pixels
+     */
+    static float seamCost(const image::Image<unsigned char> & mask, 
+                          const image::Image<image::RGBfColor> & color_label, const image::Image<image::RGBfColor> & color_other,
+                          int x1, int y1, int x2, int y2)
+    {
+        const unsigned char m1 = mask(y1, x1);
+        const unsigned char m2 = mask(y2, x2);
+
+        if(((m1 & 1) && (m2 & 2)) || ((m1 & 2) && (m2 & 1)))
+        {
+            float d1 = (color_label(y1, x1) - color_other(y1, x1)).norm();
+            float d2 = (color_label(y2, x2) - color_other(y2, x2)).norm();
+
+            d1 = std::min(2.0f, d1);
+            d2 = std::min(2.0f, d2);
+
+            return (d1 + d2) * 100.0 + 1.0;
+        }
+
+        return 1000;
     }
 
     image::Image<IndexT> & getLabels() 
@@ -1002,6 +898,11 @@ private:
     int _outputHeight;
     size_t _maximal_distance_change;
     image::Image<IndexT> _labels;
+
+    /// size of the graph cut tiles (without their margin)
+    int _tileSize;
+    /// overlap of the graph cut tiles
+    int _tileMargin;
 };
 
 } // namespace aliceVision
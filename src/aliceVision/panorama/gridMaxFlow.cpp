@@ -0,0 +1,376 @@
+#include "gridMaxFlow.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace aliceVision
+{
+
+GridMaxFlow::GridMaxFlow(int width, int height)
+    : _width(width)
+    , _height(height)
+    , _terminal(std::size_t(width) * height, 0.0f)
+{
+    for(int direction = 0; direction < 4; direction++)
+    {
+        _capacities[direction].assign(_terminal.size(), 0.0f);
+    }
+}
+
+void GridMaxFlow::setActive(int n)
+{
+    if(_isActive[n])
+    {
+        return;
+    }
+
+    _isActive[n] = 1;
+    _active.push_back(n);
+}
+
+void GridMaxFlow::setOrphan(int n)
+{
+    _parent[n] = ORPHAN;
+    _orphans.push_back(n);
+}
+
+GridMaxFlow::ValueType GridMaxFlow::compute()
+{
+    const std::size_t nbNodes = _terminal.size();
+
+    _tree.assign(nbNodes, FREE);
+    _parent.assign(nbNodes, NONE);
+    _distance.assign(nbNodes, 0);
+    _timestamp.assign(nbNodes, 0);
+    _isActive.assign(nbNodes, 0);
+    _active.clear();
+    _activeFront = 0;
+    _currentNode = -1;
+    _orphans.clear();
+    _orphansFront = 0;
+    _time = 0;
+
+    // The terminal links are the roots of the search trees
+    for(int n = 0; n < int(nbNodes); n++)
+    {
+        if(_terminal[n] == 0.0f)
+        {
+            continue;
+        }
+
+        _tree[n] = (_terminal[n] > 0.0f) ? SOURCE_TREE : SINK_TREE;
+        _parent[n] = TERMINAL;
+        _distance[n] = 1;
+        setActive(n);
+    }
+
+    ValueType flow = _flow;
+    int sourceNode;
+    int direction;
+
+    while(grow(sourceNode, direction))
+    {
+        _time++;
+        flow += augment(sourceNode, direction);
+        adoptOrphans();
+    }
+
+    return flow;
+}
+
+bool GridMaxFlow::grow(int& sourceNode, int& direction)
+{
+    while(true)
+    {
+        int i = -1;
+
+        // Keep on growing from the node which found the last path
+        if(_currentNode >= 0)
+        {
+            i = _currentNode;
+            _currentNode = -1;
+            _isActive[i] = 0;
+
+            if(_tree[i] == FREE)
+            {
+                i = -1;
+            }
+        }
+
+        while(i < 0)
+        {
+            if(_activeFront == _active.size())
+            {
+                _active.clear();
+                _activeFront = 0;
+                return false;
+            }
+
+            i = _active[_activeFront++];
+            _isActive[i] = 0;
+
+            if(_tree[i] == FREE)
+            {
+                i = -1;
+            }
+        }
+
+        // Compact the queue
+        if(_activeFront > 4096 && _activeFront * 2 > _active.size())
+        {
+            _active.erase(_active.begin(), _active.begin() + _activeFront);
+            _activeFront = 0;
+        }
+
+        const int x = i % _width;
+        const int y = i / _width;
+        const bool isSourceTree = (_tree[i] == SOURCE_TREE);
+        bool found = false;
+
+        for(int d = 0; d < 4; d++)
+        {
+            const int j = neighbor(i, x, y, d);
+            if(j < 0)
+            {
+                continue;
+            }
+
+            // Residual capacity in the direction of the flow (source to sink)
+            const ValueType residual = isSourceTree ? _capacities[d][i] : _capacities[opposite(d)][j];
+            if(residual <= 0.0f)
+            {
+                continue;
+            }
+
+            if(_tree[j] == FREE)
+            {
+                _tree[j] = _tree[i];
+                _parent[j] = opposite(d);
+                _timestamp[j] = _timestamp[i];
+                _distance[j] = _distance[i] + 1;
+                setActive(j);
+            }
+            else if(_tree[j] != _tree[i])
+            {
+                sourceNode = isSourceTree ? i : j;
+                direction = isSourceTree ? d : opposite(d);
+                found = true;
+                break;
+            }
+            else if(_timestamp[j] <= _timestamp[i] && _distance[j] > _distance[i])
+            {
+                // Shorter path to the terminal
+                _parent[j] = opposite(d);
+                _timestamp[j] = _timestamp[i];
+                _distance[j] = _distance[i] + 1;
+            }
+        }
+
+        if(found)
+        {
+            _isActive[i] = 1;
+            _currentNode = i;
+            return true;
+        }
+    }
+}
+
+GridMaxFlow::ValueType GridMaxFlow::augment(int sourceNode, int direction)
+{
+    const int sinkNode = neighbor(sourceNode, sourceNode % _width, sourceNode / _width, direction);
+
+    // Bottleneck capacity of the path
+    ValueType bottleneck = _capacities[direction][sourceNode];
+
+    for(int i = sourceNode;;)
+    {
+        if(_parent[i] == TERMINAL)
+        {
+            bottleneck = std::min(bottleneck, _terminal[i]);
+            break;
+        }
+
+        const int a = parentNode(i);
+        bottleneck = std::min(bottleneck, _capacities[opposite(_parent[i])][a]);
+        i = a;
+    }
+
+    for(int i = sinkNode;;)
+    {
+        if(_parent[i] == TERMINAL)
+        {
+            bottleneck = std::min(bottleneck, -_terminal[i]);
+            break;
+        }
+
+        bottleneck = std::min(bottleneck, _capacities[_parent[i]][i]);
+        i = parentNode(i);
+    }
+
+    // Push the flow, the saturated edges make orphans
+    _capacities[direction][sourceNode] -= bottleneck;
+    _capacities[opposite(direction)][sinkNode] += bottleneck;
+
+    for(int i = sourceNode;;)
+    {
+        const int p = _parent[i];
+        if(p == TERMINAL)
+        {
+            _terminal[i] -= bottleneck;
+            if(_terminal[i] == 0.0f)
+            {
+                setOrphan(i);
+            }
+            break;
+        }
+
+        const int a = parentNode(i);
+        _capacities[opposite(p)][a] -= bottleneck;
+        _capacities[p][i] += bottleneck;
+        if(_capacities[opposite(p)][a] == 0.0f)
+        {
+            setOrphan(i);
+        }
+        i = a;
+    }
+
+    for(int i = sinkNode;;)
+    {
+        const int p = _parent[i];
+        if(p == TERMINAL)
+        {
+            _terminal[i] += bottleneck;
+            if(_terminal[i] == 0.0f)
+            {
+                setOrphan(i);
+            }
+            break;
+        }
+
+        const int a = parentNode(i);
+        _capacities[p][i] -= bottleneck;
+        _capacities[opposite(p)][a] += bottleneck;
+        if(_capacities[p][i] == 0.0f)
+        {
+            setOrphan(i);
+        }
+        i = a;
+    }
+
+    return bottleneck;
+}
+
+void GridMaxFlow::adoptOrphans()
+{
+    const int infiniteDistance = std::numeric_limits<int>::max();
+
+    while(_orphansFront < _orphans.size())
+    {
+        const int i = _orphans[_orphansFront++];
+        const int x = i % _width;
+        const int y = i / _width;
+        const bool isSourceTree = (_tree[i] == SOURCE_TREE);
+
+        // Look for a new parent in the same tree, still connected to the terminal
+        int bestDirection = NONE;
+        int bestDistance = infiniteDistance;
+
+        for(int d = 0; d < 4; d++)
+        {
+            const int j = neighbor(i, x, y, d);
+            if(j < 0 || _tree[j] != _tree[i])
+            {
+                continue;
+            }
+
+            const ValueType residual = isSourceTree ? _capacities[opposite(d)][j] : _capacities[d][i];
+            if(residual <= 0.0f)
+            {
+                continue;
+            }
+
+            int distance = 0;
+            for(int k = j;;)
+            {
+                if(_timestamp[k] == _time)
+                {
+                    distance += _distance[k];
+                    break;
+                }
+
+                distance++;
+
+                if(_parent[k] == TERMINAL)
+                {
+                    _timestamp[k] = _time;
+                    _distance[k] = 1;
+                    break;
+                }
+
+                if(_parent[k] == ORPHAN)
+                {
+                    distance = infiniteDistance;
+                    break;
+                }
+
+                k = parentNode(k);
+            }
+
+            if(distance == infiniteDistance)
+            {
+                continue;
+            }
+
+            if(distance < bestDistance)
+            {
+                bestDirection = d;
+                bestDistance = distance;
+            }
+
+            // Cache the distances along the path
+            for(int k = j; _timestamp[k] != _time; k = parentNode(k))
+            {
+                _timestamp[k] = _time;
+                _distance[k] = distance--;
+            }
+        }
+
+        if(bestDirection != NONE)
+        {
+            _parent[i] = bestDirection;
+            _timestamp[i] = _time;
+            _distance[i] = bestDistance + 1;
+            continue;
+        }
+
+        // No parent found: the node becomes free and its children become orphans
+        for(int d = 0; d < 4; d++)
+        {
+            const int j = neighbor(i, x, y, d);
+            if(j < 0 || _tree[j] != _tree[i])
+            {
+                continue;
+            }
+
+            const ValueType residual = isSourceTree ? _capacities[opposite(d)][j] : _capacities[d][i];
+            if(residual > 0.0f)
+            {
+                setActive(j);
+            }
+
+            const int p = _parent[j];
+            if(p != TERMINAL && p != ORPHAN && parentNode(j) == i)
+            {
+                setOrphan(j);
+            }
+        }
+
+        _tree[i] = FREE;
+        _parent[i] = NONE;
+    }
+
+    _orphans.clear();
+    _orphansFront = 0;
+}
+
+} // namespace aliceVision
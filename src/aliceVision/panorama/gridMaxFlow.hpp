@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace aliceVision
+{
+
+/**
+ * @brief Maxflow computation on a 4-connected grid graph (Boykov-Kolmogorov algorithm).
+ *
+ * The nodes are the pixels of a width x height grid, the neighbors of a node are implicit
+ * and the residual capacities are stored in flat arrays (one per direction).
+ * It uses about 30 bytes per pixel, much less than a generic adjacency list.
+ * Pixels without any terminal or edge capacity are simply ignored (sink side).
+ */
+class GridMaxFlow
+{
+public:
+    using ValueType = float;
+
+    GridMaxFlow(int width, int height);
+
+    int getWidth() const { return _width; }
+    int getHeight() const { return _height; }
+
+    inline void addNodeToSource(int x, int y, ValueType source)
+    {
+        // The flow through a node linked to both terminals is pushed directly
+        ValueType& terminal = _terminal[index(x, y)];
+        if(terminal < 0.0f)
+        {
+            _flow += std::min(-terminal, source);
+        }
+        terminal += source;
+    }
+
+    inline void addNodeToSink(int x, int y, ValueType sink)
+    {
+        ValueType& terminal = _terminal[index(x, y)];
+        if(terminal > 0.0f)
+        {
+            _flow += std::min(terminal, sink);
+        }
+        terminal -= sink;
+    }
+
+    /**
+     * @brief Add an edge between (x, y) and (x + 1, y)
+     */
+    inline void addRightEdge(int x, int y, ValueType capacity, ValueType reverseCapacity)
+    {
+        const int n = index(x, y);
+        _capacities[RIGHT][n] += capacity;
+        _capacities[LEFT][n + 1] += reverseCapacity;
+    }
+
+    /**
+     * @brief Add an edge between (x, y) and (x, y + 1)
+     */
+    inline void addBottomEdge(int x, int y, ValueType capacity, ValueType reverseCapacity)
+    {
+        const int n = index(x, y);
+        _capacities[BOTTOM][n] += capacity;
+        _capacities[TOP][n + _width] += reverseCapacity;
+    }
+
+    /**
+     * @brief Compute the maximal flow (the minimal cut) between the source and the sink
+     * @return the maximal flow value
+     */
+    ValueType compute();
+
+    /// is on the source side of the minimal cut
+    inline bool isSource(int x, int y) const { return _tree[index(x, y)] == SOURCE_TREE; }
+    /// is on the sink side of the minimal cut
+    inline bool isTarget(int x, int y) const { return _tree[index(x, y)] != SOURCE_TREE; }
+
+private:
+    enum EDirection : std::uint8_t
+    {
+        RIGHT = 0,
+        BOTTOM = 1,
+        LEFT = 2,
+        TOP = 3,
+        TERMINAL = 4,
+        ORPHAN = 5,
+        NONE = 6
+    };
+
+    enum ETree : std::uint8_t
+    {
+        FREE = 0,
+        SOURCE_TREE = 1,
+        SINK_TREE = 2
+    };
+
+    inline int index(int x, int y) const { return y * _width + x; }
+
+    static inline int opposite(int direction) { return direction ^ 2; }
+
+    /// neighbor of a node in a direction (-1 if outside of the grid)
+    inline int neighbor(int n, int x, int y, int direction) const
+    {
+        switch(direction)
+        {
+            case RIGHT: return (x + 1 < _width) ? n + 1 : -1;
+            case BOTTOM: return (y + 1 < _height) ? n + _width : -1;
+            case LEFT: return (x > 0) ? n - 1 : -1;
+            default: return (y > 0) ? n - _width : -1;
+        }
+    }
+
+    inline int parentNode(int n) const
+    {
+        switch(_parent[n])
+        {
+            case RIGHT: return n + 1;
+            case BOTTOM: return n + _width;
+            case LEFT: return n - 1;
+            default: return n - _width;
+        }
+    }
+
+    void setActive(int n);
+    void setOrphan(int n);
+
+    /**
+     * @brief Grow the search trees from the active nodes until they touch
+     * @param[out] sourceNode the node of the source tree of the path
+     * @param[out] direction the direction of the edge from sourceNode to the sink tree
+     * @return false if there is no more augmenting path
+     */
+    bool grow(int& sourceNode, int& direction);
+
+    ValueType augment(int sourceNode, int direction);
+    void adoptOrphans();
+
+    int _width;
+    int _height;
+
+    /// residual terminal capacity: positive from the source, negative to the sink
+    std::vector<ValueType> _terminal;
+    /// residual capacity of the edge from each node to its neighbor, per direction
+    std::vector<ValueType> _capacities[4];
+
+    std::vector<std::uint8_t> _tree;
+    /// direction of the parent of each node in its tree
+    std::vector<std::uint8_t> _parent;
+    /// distance to the terminal, valid if the timestamp is up to date
+    std::vector<int> _distance;
+    std::vector<int> _timestamp;
+    std::vector<std::uint8_t> _isActive;
+
+    /// FIFO queue of active nodes
+    std::vector<int> _active;
+    std::size_t _activeFront = 0;
+    int _currentNode = -1;
+
+    std::vector<int> _orphans;
+    std::size_t _orphansFront = 0;
+    int _time = 0;
+
+    /// flow pushed directly between the terminals
+    ValueType _flow = 0.0f;
+};
+
+} // namespace aliceVision
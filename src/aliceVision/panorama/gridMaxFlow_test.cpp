@@ -0,0 +1,163 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/panorama/gridMaxFlow.hpp>
+
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE panoramaGridMaxFlow
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+/**
+ * @brief Reference Edmonds-Karp maxflow on a dense residual matrix
+ */
+class ReferenceMaxFlow
+{
+public:
+    explicit ReferenceMaxFlow(int nbNodes)
+        : _nbNodes(nbNodes + 2)
+        , _residual(_nbNodes * _nbNodes, 0.0)
+    {
+    }
+
+    int source() const { return _nbNodes - 2; }
+    int sink() const { return _nbNodes - 1; }
+
+    void addEdge(int from, int to, double capacity, double reverseCapacity)
+    {
+        _residual[from * _nbNodes + to] += capacity;
+        _residual[to * _nbNodes + from] += reverseCapacity;
+    }
+
+    double compute()
+    {
+        double flow = 0.0;
+        std::vector<int> parent;
+        while(findPath(parent))
+        {
+            double pathFlow = std::numeric_limits<double>::max();
+            for(int n = sink(); n != source(); n = parent[n])
+                pathFlow = std::min(pathFlow, _residual[parent[n] * _nbNodes + n]);
+            for(int n = sink(); n != source(); n = parent[n])
+            {
+                _residual[parent[n] * _nbNodes + n] -= pathFlow;
+                _residual[n * _nbNodes + parent[n]] += pathFlow;
+            }
+            flow += pathFlow;
+        }
+        _reached.assign(_nbNodes, false);
+        for(int n = 0; n < _nbNodes; ++n)
+            _reached[n] = (parent[n] != -1);
+        return flow;
+    }
+
+    /// is reachable from the source in the residual graph (minimal source side of the cut)
+    bool isSource(int n) const { return _reached[n]; }
+
+private:
+    bool findPath(std::vector<int>& parent) const
+    {
+        parent.assign(_nbNodes, -1);
+        parent[source()] = source();
+        std::queue<int> queue;
+        queue.push(source());
+        while(!queue.empty())
+        {
+            const int n = queue.front();
+            queue.pop();
+            for(int m = 0; m < _nbNodes; ++m)
+            {
+                if(parent[m] == -1 && _residual[n * _nbNodes + m] > 0.0)
+                {
+                    parent[m] = n;
+                    if(m == sink())
+                        return true;
+                    queue.push(m);
+                }
+            }
+        }
+        return false;
+    }
+
+    int _nbNodes;
+    std::vector<double> _residual;
+    std::vector<bool> _reached;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(panorama_gridMaxFlowRandom)
+{
+    std::mt19937 generator(42);
+    // Integer capacities keep the float sums exact, some of them are null
+    std::uniform_int_distribution<int> capacityDistribution(-3, 9);
+    auto randomCapacity = [&]() { return static_cast<float>(std::max(0, capacityDistribution(generator))); };
+
+    for(int test = 0; test < 300; ++test)
+    {
+        std::uniform_int_distribution<int> sizeDistribution(1, 16);
+        const int width = sizeDistribution(generator);
+        const int height = sizeDistribution(generator);
+
+        GridMaxFlow grid(width, height);
+        ReferenceMaxFlow reference(width * height);
+
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                const int n = y * width + x;
+
+                const float source = randomCapacity();
+                const float sink = randomCapacity();
+                grid.addNodeToSource(x, y, source);
+                grid.addNodeToSink(x, y, sink);
+                reference.addEdge(reference.source(), n, source, 0.0);
+                reference.addEdge(n, reference.sink(), sink, 0.0);
+
+                if(x + 1 < width)
+                {
+                    const float capacity = randomCapacity();
+                    const float reverseCapacity = randomCapacity();
+                    grid.addRightEdge(x, y, capacity, reverseCapacity);
+                    reference.addEdge(n, n + 1, capacity, reverseCapacity);
+                }
+                if(y + 1 < height)
+                {
+                    const float capacity = randomCapacity();
+                    const float reverseCapacity = randomCapacity();
+                    grid.addBottomEdge(x, y, capacity, reverseCapacity);
+                    reference.addEdge(n, n + width, capacity, reverseCapacity);
+                }
+            }
+        }
+
+        const double flow = grid.compute();
+        const double referenceFlow = reference.compute();
+        BOOST_REQUIRE_EQUAL(flow, referenceFlow);
+
+        // Both give the source side reachable from the source in the residual graph
+        int nbDifferent = 0;
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                const int n = y * width + x;
+                if(grid.isSource(x, y) != reference.isSource(n) || grid.isTarget(x, y) == grid.isSource(x, y))
+                    ++nbDifferent;
+            }
+        }
+        BOOST_CHECK_EQUAL(nbDifferent, 0);
+    }
+}
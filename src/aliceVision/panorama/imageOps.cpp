@@ -2,6 +2,12 @@
 #include "gaussian.hpp"
 #include "feathering.hpp"
 
+#include <aliceVision/config.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#endif
+
 namespace aliceVision
 {
 
@@ -38,4 +44,137 @@ void removeNegativeValues(image::Image<image::RGBfColor> & img)
     }
 }
 
-} // namespace aliceVision
\ No newline at end of file
+namespace
+{
+
+inline float blurDecimatePixel(const float* input, int inputWidth, int j)
+{
+    const int x = 2 * j;
+    return (input[mirrorIndex(x - 2, inputWidth)] + input[mirrorIndex(x + 2, inputWidth)]) / 16.0f +
+           (input[mirrorIndex(x - 1, inputWidth)] + input[mirrorIndex(x + 1, inputWidth)]) * 4.0f / 16.0f +
+           input[x] * 6.0f / 16.0f;
+}
+
+inline float blurInterpolatePixel(const float* input, int outputWidth, int x)
+{
+    const float kernel[5] = {2.0f / 16.0f, 8.0f / 16.0f, 12.0f / 16.0f, 8.0f / 16.0f, 2.0f / 16.0f};
+
+    float sum = 0.0f;
+    for(int k = 0; k < 5; k++)
+    {
+        const int p = mirrorIndex(x + k - 2, outputWidth);
+        if((p & 1) == 0)
+        {
+            sum += kernel[k] * input[p / 2];
+        }
+    }
+
+    return sum;
+}
+
+} // namespace
+
+void blurDecimateRow(float* output, const float* input, int inputWidth, int outputWidth)
+{
+    const float c0 = 1.0f / 16.0f;
+    const float c1 = 4.0f / 16.0f;
+    const float c2 = 6.0f / 16.0f;
+
+    // Outputs whose taps are all inside the row
+    const int interiorEnd = std::min(outputWidth, (inputWidth - 1) / 2);
+
+    int j = 0;
+    if(outputWidth > 0)
+    {
+        output[0] = blurDecimatePixel(input, inputWidth, 0);
+        j = 1;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    const __m128 v0 = _mm_set1_ps(c0);
+    const __m128 v1 = _mm_set1_ps(c1);
+    const __m128 v2 = _mm_set1_ps(c2);
+
+    // 4 outputs use the inputs [2j - 2, 2j + 9]
+    for(; j + 4 <= interiorEnd && 2 * j + 9 < inputWidth; j += 4)
+    {
+        const __m128 a = _mm_loadu_ps(input + 2 * j - 2);
+        const __m128 b = _mm_loadu_ps(input + 2 * j + 2);
+        const __m128 c = _mm_loadu_ps(input + 2 * j);
+        const __m128 d = _mm_loadu_ps(input + 2 * j + 4);
+        const __m128 e = _mm_loadu_ps(input + 2 * j + 6);
+
+        // Deinterleave the even and odd inputs around each output
+        const __m128 xm2 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 xm1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 x0 = _mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 xp1 = _mm_shuffle_ps(c, d, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 xp2 = _mm_shuffle_ps(b, e, _MM_SHUFFLE(2, 0, 2, 0));
+
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0, _mm_add_ps(xm2, xp2)), _mm_mul_ps(v1, _mm_add_ps(xm1, xp1))),
+                                      _mm_mul_ps(v2, x0));
+        _mm_storeu_ps(output + j, sum);
+    }
+#endif
+
+    for(; j < interiorEnd; j++)
+    {
+        const float* x = input + 2 * j;
+        output[j] = c0 * (x[-2] + x[2]) + c1 * (x[-1] + x[1]) + c2 * x[0];
+    }
+
+    for(; j < outputWidth; j++)
+    {
+        output[j] = blurDecimatePixel(input, inputWidth, j);
+    }
+}
+
+void blurInterpolateRow(float* output, const float* input, int outputWidth, int inputWidth)
+{
+    const float ceven = 1.0f / 8.0f;
+    const float ceven0 = 6.0f / 8.0f;
+    const float codd = 1.0f / 2.0f;
+
+    // output[2j] and output[2j + 1] only use input[j - 1], input[j] and input[j + 1] (no mirroring)
+    const int interiorEnd = std::min(inputWidth - 1, (outputWidth - 2) / 2);
+
+    for(int x = 0; x < std::min(2, outputWidth); x++)
+    {
+        output[x] = blurInterpolatePixel(input, outputWidth, x);
+    }
+
+    int j = 1;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+    const __m128 veven = _mm_set1_ps(ceven);
+    const __m128 veven0 = _mm_set1_ps(ceven0);
+    const __m128 vodd = _mm_set1_ps(codd);
+
+    for(; j + 4 <= interiorEnd; j += 4)
+    {
+        const __m128 xm1 = _mm_loadu_ps(input + j - 1);
+        const __m128 x0 = _mm_loadu_ps(input + j);
+        const __m128 xp1 = _mm_loadu_ps(input + j + 1);
+
+        const __m128 even = _mm_add_ps(_mm_mul_ps(veven, _mm_add_ps(xm1, xp1)), _mm_mul_ps(veven0, x0));
+        const __m128 odd = _mm_mul_ps(vodd, _mm_add_ps(x0, xp1));
+
+        // Interleave the even and odd outputs
+        _mm_storeu_ps(output + 2 * j, _mm_unpacklo_ps(even, odd));
+        _mm_storeu_ps(output + 2 * j + 4, _mm_unpackhi_ps(even, odd));
+    }
+#endif
+
+    for(; j < interiorEnd; j++)
+    {
+        output[2 * j] = ceven * (input[j - 1] + input[j + 1]) + ceven0 * input[j];
+        output[2 * j + 1] = codd * (input[j] + input[j + 1]);
+    }
+
+    for(int x = std::max(2, 2 * j); x < outputWidth; x++)
+    {
+        output[x] = blurInterpolatePixel(input, outputWidth, x);
+    }
+}
+
+} // namespace aliceVision
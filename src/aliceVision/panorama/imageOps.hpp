@@ -4,6 +4,8 @@
 #include "cachedImage.hpp"
 #include <OpenEXR/half.h>
 
+#include <vector>
+
 namespace aliceVision
 {
 
@@ -165,6 +167,211 @@ bool addition(aliceVision::image::Image<T>& AplusB, const aliceVision::image::Im
 
 void removeNegativeValues(image::Image<image::RGBfColor>& img);
 
+/**
+ * @brief Mirrored index (5432 | 123456 | 5432), the border convention of convolveGaussian5x5
+ */
+inline int mirrorIndex(int index, int size)
+{
+    if(index < 0)
+    {
+        return -index;
+    }
+
+    if(index >= size)
+    {
+        return 2 * size - 2 - index;
+    }
+
+    return index;
+}
+
+/**
+ * @brief 5 taps Gaussian filter of a row followed by a decimation by 2:
+ * output[j] is the filtered value of input[2 * j]
+ */
+template <class T>
+void blurDecimateRow(T* output, const T* input, int inputWidth, int outputWidth)
+{
+    const float c0 = 1.0f / 16.0f;
+    const float c1 = 4.0f / 16.0f;
+    const float c2 = 6.0f / 16.0f;
+
+    for(int j = 0; j < outputWidth; j++)
+    {
+        const int x = 2 * j;
+        output[j] = T(c0 * (input[mirrorIndex(x - 2, inputWidth)] + input[mirrorIndex(x + 2, inputWidth)]) +
+                      c1 * (input[mirrorIndex(x - 1, inputWidth)] + input[mirrorIndex(x + 1, inputWidth)]) +
+                      c2 * input[x]);
+    }
+}
+
+/**
+ * @brief 5 taps Gaussian filter of a row upscaled by 2 (filled with zeros), multiplied by 2:
+ * output[2 * j] and output[2 * j + 1] are interpolated from input[j - 1], input[j] and input[j + 1]
+ */
+template <class T>
+void blurInterpolateRow(T* output, const T* input, int outputWidth, int inputWidth)
+{
+    const float kernel[5] = {2.0f / 16.0f, 8.0f / 16.0f, 12.0f / 16.0f, 8.0f / 16.0f, 2.0f / 16.0f};
+
+    for(int x = 0; x < outputWidth; x++)
+    {
+        bool first = true;
+        for(int k = 0; k < 5; k++)
+        {
+            const int p = mirrorIndex(x + k - 2, outputWidth);
+            if(p & 1)
+            {
+                continue;
+            }
+
+            if(first)
+            {
+                output[x] = T(kernel[k] * input[p / 2]);
+                first = false;
+            }
+            else
+            {
+                output[x] += T(kernel[k] * input[p / 2]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Vectorized version of blurDecimateRow for planar images
+ */
+void blurDecimateRow(float* output, const float* input, int inputWidth, int outputWidth);
+
+/**
+ * @brief Vectorized version of blurInterpolateRow for planar images
+ */
+void blurInterpolateRow(float* output, const float* input, int outputWidth, int inputWidth);
+
+/**
+ * @brief Gaussian 5x5 filter followed by a decimation by 2.
+ * Same result as convolveGaussian5x5 followed by downscale, but only the kept pixels are filtered.
+ * @param[out] output the decimated image (at most half the size of the input, rounded up)
+ * @param[in] input the image to filter (at least 3x3)
+ */
+template <class T>
+bool blurDownscale(aliceVision::image::Image<T>& output, const aliceVision::image::Image<T>& input)
+{
+    const int width = input.Width();
+    const int height = input.Height();
+
+    if(width < 3 || height < 3)
+    {
+        return false;
+    }
+
+    if(output.Width() > (width + 1) / 2 || output.Height() > (height + 1) / 2)
+    {
+        return false;
+    }
+
+    const float c0 = 1.0f / 16.0f;
+    const float c1 = 4.0f / 16.0f;
+    const float c2 = 6.0f / 16.0f;
+
+    #pragma omp parallel
+    {
+        std::vector<T> filtered(width);
+
+        #pragma omp for
+        for(int i = 0; i < output.Height(); i++)
+        {
+            const int y = 2 * i;
+            const T* r0 = &input(mirrorIndex(y - 2, height), 0);
+            const T* r1 = &input(mirrorIndex(y - 1, height), 0);
+            const T* r2 = &input(y, 0);
+            const T* r3 = &input(mirrorIndex(y + 1, height), 0);
+            const T* r4 = &input(mirrorIndex(y + 2, height), 0);
+
+            // Vertical filter on full rows, then horizontal filter on the kept columns
+            for(int x = 0; x < width; x++)
+            {
+                filtered[x] = T(c0 * (r0[x] + r4[x]) + c1 * (r1[x] + r3[x]) + c2 * r2[x]);
+            }
+
+            blurDecimateRow(&output(i, 0), filtered.data(), width, output.Width());
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Upscale by 2 followed by a Gaussian 5x5 filter.
+ * Same result as upscale (filling with zeros) followed by convolveGaussian5x5 and a multiplication by 4,
+ * but the zeros are never filtered.
+ * @param[out] output the upscaled image (at least 3x3)
+ * @param[in] input the image to upscale (half the size of the output, rounded up)
+ */
+template <class T>
+bool upscaleBlur(aliceVision::image::Image<T>& output, const aliceVision::image::Image<T>& input)
+{
+    const int width = output.Width();
+    const int height = output.Height();
+
+    if(width < 3 || height < 3)
+    {
+        return false;
+    }
+
+    if(input.Width() != (width + 1) / 2 || input.Height() != (height + 1) / 2)
+    {
+        return false;
+    }
+
+    const float kernel[5] = {2.0f / 16.0f, 8.0f / 16.0f, 12.0f / 16.0f, 8.0f / 16.0f, 2.0f / 16.0f};
+
+    #pragma omp parallel
+    {
+        std::vector<T> filtered(input.Width());
+
+        #pragma omp for
+        for(int y = 0; y < height; y++)
+        {
+            // Rows of the input used by the vertical filter (the other upscaled rows are zeros)
+            const T* rows[3];
+            float weights[3];
+            int count = 0;
+
+            for(int k = 0; k < 5; k++)
+            {
+                const int p = mirrorIndex(y + k - 2, height);
+                if(p & 1)
+                {
+                    continue;
+                }
+
+                rows[count] = &input(p / 2, 0);
+                weights[count] = kernel[k];
+                count++;
+            }
+
+            for(int x = 0; x < input.Width(); x++)
+            {
+                filtered[x] = T(weights[0] * rows[0][x]);
+            }
+
+            for(int c = 1; c < count; c++)
+            {
+                for(int x = 0; x < input.Width(); x++)
+                {
+                    filtered[x] += T(weights[c] * rows[c][x]);
+                }
+            }
+
+            blurInterpolateRow(&output(y, 0), filtered.data(), width, input.Width());
+        }
+    }
+
+    return true;
+}
+
+
 template <class T>
 bool loopyImageAssign(image::Image<T> & output, const aliceVision::image::Image<T> & input, const BoundingBox & assignedOutputBb, const BoundingBox & assignedInputBb) 
 {
@@ -7,17 +7,33 @@
 namespace aliceVision
 {
 
+namespace
+{
+
+/// height of the bands of rows locked together when merging
+const int mergeBandHeight = 32;
+
+} // namespace
+
 LaplacianPyramid::LaplacianPyramid(size_t base_width, size_t base_height, size_t max_levels) :
 _baseWidth(base_width),
 _baseHeight(base_height),
 _maxLevels(max_levels)
 {
-    omp_init_lock(&_merge_lock);
+    omp_init_lock(&_inputInfosLock);
 }
 
 LaplacianPyramid::~LaplacianPyramid()
 {
-    omp_destroy_lock(&_merge_lock);
+    for (std::vector<omp_lock_t> & locks : _mergeLocks)
+    {
+        for (omp_lock_t & lock : locks)
+        {
+            omp_destroy_lock(&lock);
+        }
+    }
+
+    omp_destroy_lock(&_inputInfosLock);
 }
 
 bool LaplacianPyramid::initialize() 
@@ -25,18 +41,26 @@ bool LaplacianPyramid::initialize()
     size_t width = _baseWidth;
     size_t height = _baseHeight;
 
-    /*Make sure pyramid size can be divided by 2 on each levels*/
-    double max_scale = 1.0 / pow(2.0, _maxLevels - 1);
-
     /*Prepare pyramid*/
     for(int lvl = 0; lvl < _maxLevels; lvl++)
     {
-        image::Image<image::RGBfColor> color(width, height, true, image::RGBfColor(0.0f, 0.0f, 0.0f));
+        PlanarColor color;
+        for (int c = 0; c < 3; c++)
+        {
+            color[c] = image::Image<float>(width, height, true, 0.0f);
+        }
         image::Image<float> weights(width, height, true, 0.0f);
 
         _levels.push_back(color);
         _weights.push_back(weights);
 
+        std::vector<omp_lock_t> locks((height + mergeBandHeight - 1) / mergeBandHeight);
+        for (omp_lock_t & lock : locks)
+        {
+            omp_init_lock(&lock);
+        }
+        _mergeLocks.push_back(locks);
+
         width = int(ceil(float(width) / 2.0f));
         height = int(ceil(float(height) / 2.0f));
     }
@@ -56,8 +80,12 @@ bool LaplacianPyramid::apply(aliceVision::image::Image<image::RGBfColor>& source
     int offsetX = outputBoundingBox.left;
     int offsetY = outputBoundingBox.top;
 
-    image::Image<image::RGBfColor> currentColor(width, height, true, image::RGBfColor(0.0));
-    image::Image<image::RGBfColor> nextColor;
+    PlanarColor currentColor;
+    PlanarColor nextColor;
+    for (int c = 0; c < 3; c++)
+    {
+        currentColor[c] = image::Image<float>(width, height, true, 0.0f);
+    }
     image::Image<float> currentWeights(width, height, true, 0.0f);
     image::Image<float> nextWeights;
     image::Image<float> currentMask(width, height, true, 0.0f);
@@ -67,7 +95,15 @@ bool LaplacianPyramid::apply(aliceVision::image::Image<image::RGBfColor>& source
     {
         int di = contentBoudingBox.top + i;
 
-        memcpy(&currentColor(di, contentBoudingBox.left), &source(i, 0), sizeof(image::RGBfColor) * source.Width());
+        for (int j = 0; j < source.Width(); j++)
+        {
+            int dj = contentBoudingBox.left + j;
+
+            currentColor[0](di, dj) = source(i, j).r();
+            currentColor[1](di, dj) = source(i, j).g();
+            currentColor[2](di, dj) = source(i, j).b();
+        }
+
         memcpy(&currentWeights(di, contentBoudingBox.left), &weights(i, 0), sizeof(float) * source.Width());
         memcpy(&currentMask(di, contentBoudingBox.left), &mask(i, 0), sizeof(float) * source.Width());
     }
@@ -78,141 +114,99 @@ bool LaplacianPyramid::apply(aliceVision::image::Image<image::RGBfColor>& source
 
     for(int l = 0; l < _levels.size() - 1; l++)
     {
-        BoundingBox inputBbox;
-        inputBbox.left = offsetX;
-        inputBbox.top = offsetY;
-        inputBbox.width = width;
-        inputBbox.height = height;
-
-        image::Image<image::RGBfColor> bufMasked(width, height);
-        image::Image<image::RGBfColor> buf(width, height);
-        image::Image<image::RGBfColor> buf2(width, height);
-        image::Image<float> bufFloat(width, height);
+        PlanarColor masked;
+        for (int c = 0; c < 3; c++)
+        {
+            masked[c] = image::Image<float>(width, height);
+        }
 
         // Apply mask to content before convolution
+        #pragma omp parallel for
         for(int i = 0; i < height; i++)
         {
             for(int j = 0; j < width; j++)
             {
-                if(std::abs(currentMask(i, j)) > 1e-6)
-                {
-                    bufMasked(i, j) = currentColor(i, j);
-                }
-                else
-                {
-                    bufMasked(i, j).r() = 0.0f;
-                    bufMasked(i, j).g() = 0.0f;
-                    bufMasked(i, j).b() = 0.0f;
-                    currentWeights(i, j) = 0.0f;
-                }
-            }
-        }
-
-        if (!convolveGaussian5x5<image::RGBfColor>(buf, bufMasked)) 
-        {
-            return false;
-        }
+                const bool valid = std::abs(currentMask(i, j)) > 1e-6;
 
-        if (!convolveGaussian5x5<float>(bufFloat, currentMask)) 
-        {
-            return false;
-        }
-
-        //Normalize given mask
-        //(Make sure the convolution sum is 1)
-        for(int i = 0; i < buf.Height(); i++)
-        {
-            for(int j = 0; j < buf.Width(); j++)
-            {
-                float m = bufFloat(i, j);
-
-                if(std::abs(m) > 1e-6)
-                {
-                    buf(i, j).r() = buf(i, j).r() / m;
-                    buf(i, j).g() = buf(i, j).g() / m;
-                    buf(i, j).b() = buf(i, j).b() / m;
-                    bufFloat(i, j) = 1.0f;
-                }
-                else
-                {
-                    buf(i, j).r() = 0.0f;
-                    buf(i, j).g() = 0.0f;
-                    buf(i, j).b() = 0.0f;
-                    bufFloat(i, j) = 0.0f;
-                }
+                masked[0](i, j) = valid ? currentColor[0](i, j) : 0.0f;
+                masked[1](i, j) = valid ? currentColor[1](i, j) : 0.0f;
+                masked[2](i, j) = valid ? currentColor[2](i, j) : 0.0f;
+                currentWeights(i, j) = valid ? currentWeights(i, j) : 0.0f;
             }
         }
 
-
         int nextWidth = width / 2;
         int nextHeight = int(floor(float(height) / 2.0f));
 
-        nextColor = aliceVision::image::Image<image::RGBfColor>(nextWidth, nextHeight);
-        nextWeights = aliceVision::image::Image<float>(nextWidth, nextHeight);
-        nextMask = aliceVision::image::Image<float>(nextWidth, nextHeight);
-
-        if (!downscale(nextColor, buf)) 
+        // Gaussian filter and decimation at once
+        for (int c = 0; c < 3; c++)
         {
-            return false;
-        }
-
-        if (!downscale(nextMask, bufFloat)) 
-        {
-            return false;
+            nextColor[c] = aliceVision::image::Image<float>(nextWidth, nextHeight);
+            if (!blurDownscale(nextColor[c], masked[c]))
+            {
+                return false;
+            }
         }
 
-        if (!upscale(buf, nextColor)) 
+        nextMask = aliceVision::image::Image<float>(nextWidth, nextHeight);
+        if (!blurDownscale(nextMask, currentMask)) 
         {
             return false;
         }
 
-        //Filter
-        if (!convolveGaussian5x5<image::RGBfColor>(buf2, buf)) 
+        nextWeights = aliceVision::image::Image<float>(nextWidth, nextHeight);
+        if (!blurDownscale(nextWeights, currentWeights))
         {
             return false;
         }
 
-        //Values must be multiplied by 4 as our upscale was using 
-        //filling of 0 values
-        for(int i = 0; i < buf2.Height(); i++)
+        //Normalize given mask
+        //(Make sure the convolution sum is 1)
+        #pragma omp parallel for
+        for(int i = 0; i < nextHeight; i++)
         {
-            for(int j = 0; j < buf2.Width(); j++)
-            {   
-                buf2(i, j) *= 4.0f;
+            for(int j = 0; j < nextWidth; j++)
+            {
+                const float m = nextMask(i, j);
+                const bool valid = std::abs(m) > 1e-6;
+                const float scale = valid ? 1.0f / m : 0.0f;
+
+                nextColor[0](i, j) *= scale;
+                nextColor[1](i, j) *= scale;
+                nextColor[2](i, j) *= scale;
+                nextMask(i, j) = valid ? 1.0f : 0.0f;
             }
         }
 
         //Only keep the difference (Band pass)
-        if (!substract(currentColor, currentColor, buf2)) 
+        //The upscaled image is reusing the masked buffer
+        for (int c = 0; c < 3; c++)
         {
-            return false;
-        }
-        
-        //Downscale weights
-        if (!convolveGaussian5x5<float>(bufFloat, currentWeights)) 
-        {
-            return false;
-        }
+            image::Image<float> & upscaled = masked[c];
+            if (!upscaleBlur(upscaled, nextColor[c]))
+            {
+                return false;
+            }
 
-        if (!downscale(nextWeights, bufFloat))
-        {
-            return false;
+            if (!substract(currentColor[c], currentColor[c], upscaled)) 
+            {
+                return false;
+            }
         }
 
         //Merge this view with previous ones
-        omp_set_lock(&_merge_lock);
-        bool res = merge(currentColor, currentWeights, l, offsetX, offsetY);
-        omp_unset_lock(&_merge_lock);
-
-        if (!res)
+        if (!merge(currentColor, currentWeights, l, offsetX, offsetY))
         {
             return false;
         }
 
         //Swap buffers
-        currentColor = nextColor;
-        currentWeights = nextWeights;
-        currentMask = nextMask;
+        for (int c = 0; c < 3; c++)
+        {
+            currentColor[c].swap(nextColor[c]);
+        }
+        currentWeights.swap(nextWeights);
+        currentMask.swap(nextMask);
         width = nextWidth;
         height = nextHeight;
 
@@ -225,42 +219,70 @@ bool LaplacianPyramid::apply(aliceVision::image::Image<image::RGBfColor>& source
     InputInfo iinfo;
     iinfo.offsetX = offsetX;
     iinfo.offsetY = offsetY;
-    iinfo.color = currentColor;
-    iinfo.mask = currentMask;
-    iinfo.weights = currentWeights;
+    for (int c = 0; c < 3; c++)
+    {
+        iinfo.color[c].swap(currentColor[c]);
+    }
+    iinfo.mask.swap(currentMask);
+    iinfo.weights.swap(currentWeights);
 
-    omp_set_lock(&_merge_lock);
+    omp_set_lock(&_inputInfosLock);
     _inputInfos.push_back(iinfo);
-    omp_unset_lock(&_merge_lock);
-    
+    omp_unset_lock(&_inputInfosLock);
 
     return true;
 }
 
-bool LaplacianPyramid::merge(const aliceVision::image::Image<image::RGBfColor>& oimg,
+bool LaplacianPyramid::merge(const PlanarColor& oimg,
                              const aliceVision::image::Image<float>& oweight, 
                              size_t level, int offsetX, int offsetY)
 {
-    image::Image<image::RGBfColor> & img = _levels[level];
+    PlanarColor & img = _levels[level];
     image::Image<float> & weight = _weights[level];
 
-    for(int i = 0; i < oimg.Height(); i++)
-    {   
-        int y = i + offsetY;
-        if (y < 0 || y >= img.Height()) continue;
+    // Intersection with the level
+    const int top = std::max(0, offsetY);
+    const int bottom = std::min(int(weight.Height()), offsetY + int(oweight.Height()));
+    const int left = std::max(0, offsetX);
+    const int right = std::min(int(weight.Width()), offsetX + int(oweight.Width()));
 
-        for(int j = 0; j < oimg.Width(); j++)
-        {  
-            int x = j + offsetX;
-            if (x < 0 || x >= img.Width()) continue;
+    // The band is outside of the level
+    if (left >= right || top >= bottom)
+    {
+        return true;
+    }
 
-            img(y, x).r() += oimg(i, j).r() * oweight(i, j);
-            img(y, x).g() += oimg(i, j).g() * oweight(i, j);
-            img(y, x).b() += oimg(i, j).b() * oweight(i, j);
-            weight(y, x) += oweight(i, j);
+    for (int band = top / mergeBandHeight; band * mergeBandHeight < bottom; band++)
+    {
+        const int bandTop = std::max(top, band * mergeBandHeight);
+        const int bandBottom = std::min(bottom, (band + 1) * mergeBandHeight);
+
+        omp_set_lock(&_mergeLocks[level][band]);
+
+        for(int y = bandTop; y < bandBottom; y++)
+        {   
+            const int i = y - offsetY;
+
+            const float * ow = &oweight(i, left - offsetX);
+            const float * or_ = &oimg[0](i, left - offsetX);
+            const float * og = &oimg[1](i, left - offsetX);
+            const float * ob = &oimg[2](i, left - offsetX);
+            float * w = &weight(y, left);
+            float * r = &img[0](y, left);
+            float * g = &img[1](y, left);
+            float * b = &img[2](y, left);
+
+            for(int j = 0; j < right - left; j++)
+            {  
+                r[j] += or_[j] * ow[j];
+                g[j] += og[j] * ow[j];
+                b[j] += ob[j] * ow[j];
+                w[j] += ow[j];
+            }
         }
-    }
 
+        omp_unset_lock(&_mergeLocks[level][band]);
+    }
 
     return true;
 }
@@ -278,71 +300,49 @@ bool LaplacianPyramid::rebuild(image::Image<image::RGBAfColor>& output, const Bo
     // We first want to compute the final pixels mean
     for(int l = 0; l < _levels.size(); l++)
     {
-        image::Image<image::RGBfColor> & level = _levels[l];
+        PlanarColor & level = _levels[l];
         image::Image<float> & weight = _weights[l];
 
-        for (int i = 0; i < level.Height(); i++) 
+        #pragma omp parallel for
+        for (int i = 0; i < weight.Height(); i++) 
         {
-            for (int j = 0; j < level.Width(); j++)
+            for (int j = 0; j < weight.Width(); j++)
             {
-                float w = weight(i, j);
-                image::RGBfColor c = level(i, j);
-
-                if (w < 1e-6) 
-                {
-                   level(i, j) = image::RGBfColor(0.0f, 0.0f, 0.0f);
-                   continue;
-                }
+                const float w = weight(i, j);
+                const float scale = (w < 1e-6) ? 0.0f : 1.0f / w;
 
-                image::RGBfColor r;
-
-                r.r() = c.r() / w;
-                r.g() = c.g() / w;
-                r.b() = c.b() / w;
-
-                level(i, j) = r;
+                level[0](i, j) *= scale;
+                level[1](i, j) *= scale;
+                level[2](i, j) *= scale;
             }
         }
     }
 
-    removeNegativeValues(_levels[_levels.size() - 1]);
-
     for(int l = _levels.size() - 2; l >= 0; l--)
     {
         int halfLevel = l + 1;
         int currentLevel = l;
 
-        aliceVision::image::Image<image::RGBfColor> buf(_levels[currentLevel].Width(), _levels[currentLevel].Height());
-        aliceVision::image::Image<image::RGBfColor> buf2(_levels[currentLevel].Width(), _levels[currentLevel].Height());
+        aliceVision::image::Image<float> buf(_weights[currentLevel].Width(), _weights[currentLevel].Height());
 
-        if (!upscale(buf, _levels[halfLevel])) 
+        for (int c = 0; c < 3; c++)
         {
-            return false;
-        }
-
-        if (!convolveGaussian5x5<image::RGBfColor>(buf2, buf, false)) 
-        {
-            return false;
-        }
+            if (!upscaleBlur(buf, _levels[halfLevel][c])) 
+            {
+                return false;
+            }
 
-        for(int y = 0; y < buf2.Height(); y++)
-        {
-            for(int x = 0; x < buf2.Width(); x++)
+            if (!addition(_levels[currentLevel][c], _levels[currentLevel][c], buf))
             {
-                buf2(y, x) *= 4.0f;
+                return false;
             }
         }
-        
-        if (!addition(_levels[currentLevel], _levels[currentLevel], buf2))
-        {
-            return false;
-        }
-
-        removeNegativeValues(_levels[currentLevel]);
     }
     
-    image::Image<image::RGBfColor> & level = _levels[0];
+    PlanarColor & level = _levels[0];
     image::Image<float> & weight = _weights[0];
+
+    #pragma omp parallel for
     for(int i = 0; i < roi.height; i++)
     {
         int y = i + roi.top;
@@ -351,9 +351,9 @@ bool LaplacianPyramid::rebuild(image::Image<image::RGBAfColor>& output, const Bo
         {
             int x = j + roi.left;
 
-            output(i, j).r() = level(y, x).r();
-            output(i, j).g() = level(y, x).g();
-            output(i, j).b() = level(y, x).b();
+            output(i, j).r() = level[0](y, x);
+            output(i, j).g() = level[1](y, x);
+            output(i, j).b() = level[2](y, x);
 
             if (weight(y, x) < 1e-6)
             {
@@ -3,6 +3,10 @@
 #include "imageOps.hpp"
 
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <array>
+#include <vector>
 
 namespace aliceVision
 {
@@ -10,9 +14,12 @@ namespace aliceVision
 class LaplacianPyramid
 {
 public:
+    /// RGB image stored as one float image per channel
+    using PlanarColor = std::array<aliceVision::image::Image<float>, 3>;
+
     struct InputInfo 
     {
-        aliceVision::image::Image<image::RGBfColor> color; 
+        PlanarColor color;
         aliceVision::image::Image<float> mask;
         aliceVision::image::Image<float> weights;
         int offsetX;
@@ -26,12 +33,20 @@ public:
 
     bool initialize();
     
+    /**
+     * @brief Decompose a view in bands and merge them in the pyramid.
+     * Several views can be applied concurrently.
+     */
     bool apply(aliceVision::image::Image<image::RGBfColor>& source,
                aliceVision::image::Image<float>& mask, 
                aliceVision::image::Image<float>& weights,
                const BoundingBox &outputBoundingBox, const BoundingBox &contentBoudingBox);
 
-    bool merge(const aliceVision::image::Image<image::RGBfColor>& oimg, 
+    /**
+     * @brief Accumulate a weighted band in a level.
+     * The level is locked by bands of rows, so views with different footprints are merged in parallel.
+     */
+    bool merge(const PlanarColor& oimg, 
                const aliceVision::image::Image<float>& oweight,
                size_t level, int offset_x, int offset_y);
 
@@ -41,11 +56,14 @@ private:
     int _baseWidth;
     int _baseHeight;
     int _maxLevels;
-    omp_lock_t _merge_lock;
 
-    std::vector<image::Image<image::RGBfColor>> _levels;
+    std::vector<PlanarColor> _levels;
     std::vector<image::Image<float>> _weights;
     std::vector<InputInfo> _inputInfos;
+
+    /// one lock per band of rows of each level
+    std::vector<std::vector<omp_lock_t>> _mergeLocks;
+    omp_lock_t _inputInfosLock;
 };
 
-} // namespace aliceVision
\ No newline at end of file
+} // namespace aliceVision
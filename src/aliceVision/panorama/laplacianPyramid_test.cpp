@@ -0,0 +1,176 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/panorama/gaussian.hpp>
+#include <aliceVision/panorama/imageOps.hpp>
+#include <aliceVision/panorama/laplacianPyramid.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE panoramaLaplacianPyramid
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+template <class T>
+void fillRandom(image::Image<T>& img, std::mt19937& generator);
+
+template <>
+void fillRandom(image::Image<float>& img, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for(int i = 0; i < img.Height(); i++)
+        for(int j = 0; j < img.Width(); j++)
+            img(i, j) = distribution(generator);
+}
+
+template <>
+void fillRandom(image::Image<image::RGBfColor>& img, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for(int i = 0; i < img.Height(); i++)
+        for(int j = 0; j < img.Width(); j++)
+            img(i, j) = image::RGBfColor(distribution(generator), distribution(generator), distribution(generator));
+}
+
+float difference(float a, float b)
+{
+    return std::abs(a - b);
+}
+
+float difference(const image::RGBfColor& a, const image::RGBfColor& b)
+{
+    return (a - b).norm();
+}
+
+template <class T>
+void checkBlurDownscale(int width, int height, std::mt19937& generator)
+{
+    image::Image<T> input(width, height);
+    fillRandom(input, generator);
+
+    // reference: full resolution convolution, then decimation
+    image::Image<T> convolved(width, height);
+    image::Image<T> reference((width + 1) / 2, (height + 1) / 2);
+    BOOST_REQUIRE(convolveGaussian5x5<T>(convolved, input));
+    BOOST_REQUIRE(downscale(reference, convolved));
+
+    image::Image<T> output((width + 1) / 2, (height + 1) / 2);
+    BOOST_REQUIRE(blurDownscale(output, input));
+
+    for(int i = 0; i < output.Height(); i++)
+        for(int j = 0; j < output.Width(); j++)
+            BOOST_CHECK_SMALL(difference(output(i, j), reference(i, j)), 1e-5f);
+}
+
+template <class T>
+void checkUpscaleBlur(int width, int height, std::mt19937& generator)
+{
+    image::Image<T> input((width + 1) / 2, (height + 1) / 2);
+    fillRandom(input, generator);
+
+    // reference: upscale with zeros, then full resolution convolution
+    image::Image<T> upscaled(width, height);
+    image::Image<T> reference(width, height);
+    BOOST_REQUIRE(upscale(upscaled, input));
+    BOOST_REQUIRE(convolveGaussian5x5<T>(reference, upscaled));
+
+    image::Image<T> output(width, height);
+    BOOST_REQUIRE(upscaleBlur(output, input));
+
+    for(int i = 0; i < output.Height(); i++)
+        for(int j = 0; j < output.Width(); j++)
+            BOOST_CHECK_SMALL(difference(output(i, j), T(4.0f * reference(i, j))), 1e-5f);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(panorama_blurDownscale)
+{
+    std::mt19937 generator(42);
+
+    // odd and even sizes, including the smallest ones where the mirrored borders overlap
+    for(int width = 3; width < 40; width++)
+    {
+        for(int height = 3; height < 12; height++)
+        {
+            checkBlurDownscale<float>(width, height, generator);
+            checkBlurDownscale<image::RGBfColor>(width, height, generator);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(panorama_upscaleBlur)
+{
+    std::mt19937 generator(42);
+
+    for(int width = 3; width < 40; width++)
+    {
+        for(int height = 3; height < 12; height++)
+        {
+            checkUpscaleBlur<float>(width, height, generator);
+            checkUpscaleBlur<image::RGBfColor>(width, height, generator);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(panorama_laplacianPyramidMerge)
+{
+    const int width = 64;
+    const int height = 48;
+
+    LaplacianPyramid pyramid(width, height, 1);
+    BOOST_REQUIRE(pyramid.initialize());
+
+    // 16x16 band of color 1 and weight 0.5
+    LaplacianPyramid::PlanarColor band;
+    for(image::Image<float>& channel : band)
+        channel = image::Image<float>(16, 16, true, 1.0f);
+    const image::Image<float> weights(16, 16, true, 0.5f);
+
+    // bands outside of the level, on each side
+    BOOST_CHECK(pyramid.merge(band, weights, 0, -16, 0));
+    BOOST_CHECK(pyramid.merge(band, weights, 0, -40, 8));
+    BOOST_CHECK(pyramid.merge(band, weights, 0, width, 8));
+    BOOST_CHECK(pyramid.merge(band, weights, 0, 8, -16));
+    BOOST_CHECK(pyramid.merge(band, weights, 0, 8, height));
+    BOOST_CHECK(pyramid.merge(band, weights, 0, width + 10, height + 10));
+
+    // band overlapping the top right corner of the level on 8x8 pixels
+    BOOST_CHECK(pyramid.merge(band, weights, 0, width - 8, -8));
+
+    // band overlapping two locked bands of rows
+    BOOST_CHECK(pyramid.merge(band, weights, 0, 10, 24));
+
+    image::Image<image::RGBAfColor> output(width, height, true, image::RGBAfColor(0.0f));
+    BOOST_CHECK(pyramid.rebuild(output, BoundingBox(0, 0, width, height)));
+
+    // only the overlapping pixels are merged, with their color normalized by the weights
+    int nbMerged = 0;
+    for(int i = 0; i < height; i++)
+    {
+        for(int j = 0; j < width; j++)
+        {
+            const bool inCorner = (i < 8 && j >= width - 8);
+            const bool inBand = (i >= 24 && i < 40 && j >= 10 && j < 26);
+            if(!inCorner && !inBand)
+            {
+                BOOST_CHECK_EQUAL(output(i, j).a(), 0.0f);
+                continue;
+            }
+
+            ++nbMerged;
+            BOOST_CHECK_CLOSE(output(i, j).r(), 1.0f, 1e-3f);
+            BOOST_CHECK_CLOSE(output(i, j).g(), 1.0f, 1e-3f);
+            BOOST_CHECK_CLOSE(output(i, j).b(), 1.0f, 1e-3f);
+            BOOST_CHECK_EQUAL(output(i, j).a(), 1.0f);
+        }
+    }
+    BOOST_CHECK_EQUAL(nbMerged, 8 * 8 + 16 * 16);
+}
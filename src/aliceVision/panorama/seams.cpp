@@ -377,11 +377,9 @@ bool HierarchicalGraphcutSeams::append(const aliceVision::image::Image<image::RG
 
         aliceVision::image::Image<image::RGBfColor> nextImage(newWidth, newHeight);
         aliceVision::image::Image<unsigned char> nextMask(newWidth, newHeight);
-        aliceVision::image::Image<image::RGBfColor> buf(width, height);
 
         //Convolve + divide
-        convolveGaussian5x5<image::RGBfColor>(buf, feathered);
-        downscale(nextImage, buf);
+        blurDownscale(nextImage, feathered);
 
         //Just nearest neighboor divide for mask
         for(int i = 0; i < nextMask.Height(); i++)
@@ -450,6 +448,7 @@ bool HierarchicalGraphcutSeams::process()
         //Enlarge result of this level to be an initialization for next level
         image::Image<IndexT> & largeLabels = _graphcuts[level - 1].getLabels();
 
+        #pragma omp parallel for
         for (int y = 0; y < largeLabels.Height(); y++) 
         {
             int hy = y / 2;
@@ -1,6 +1,12 @@
 #include "warper.hpp"
+#include "distance.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
 #include <OpenEXR/half.h>
 
+#include <algorithm>
+
 namespace aliceVision
 {
 
@@ -146,4 +152,131 @@ bool GaussianWarper::warp(const CoordinatesMap& map, const GaussianPyramidNoMask
     return true;
 }
 
-} // namespace aliceVision
\ No newline at end of file
+WarpedTilesQueue::WarpedTilesQueue(size_t capacity)
+    : _slots(std::max<size_t>(1, capacity))
+    , _ready(_slots.size(), false)
+{
+}
+
+WarpedTile& WarpedTilesQueue::acquire(size_t tileIndex)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [&]() { return tileIndex < _nextTile + _slots.size(); });
+    return _slots[tileIndex % _slots.size()];
+}
+
+void WarpedTilesQueue::push(size_t tileIndex)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready[tileIndex % _slots.size()] = true;
+    }
+    _condition.notify_all();
+}
+
+const WarpedTile& WarpedTilesQueue::front()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    const size_t slot = _nextTile % _slots.size();
+    _condition.wait(lock, [&]() { return bool(_ready[slot]); });
+    return _slots[slot];
+}
+
+void WarpedTilesQueue::pop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready[_nextTile % _slots.size()] = false;
+        ++_nextTile;
+    }
+    _condition.notify_all();
+}
+
+void computeWarpedBoundingBox(BoundingBox& globalBbox, const std::pair<int, int>& panoramaSize,
+                              const geometry::Pose3& pose, const camera::IntrinsicBase& intrinsic,
+                              const BoundingBox& coarseBbox, int tileSize)
+{
+    std::vector<BoundingBox> boxes;
+    for(int y = 0; y < coarseBbox.height; y += tileSize)
+    {
+        for(int x = 0; x < coarseBbox.width; x += tileSize)
+        {
+            BoundingBox localBbox;
+            localBbox.left = x + coarseBbox.left;
+            localBbox.top = y + coarseBbox.top;
+            localBbox.width = tileSize;
+            localBbox.height = tileSize;
+
+            localBbox.clampRight(coarseBbox.getRight());
+            localBbox.clampBottom(coarseBbox.getBottom());
+
+            boxes.push_back(localBbox);
+        }
+    }
+
+    // one bounding box per thread, merged at the end
+    std::vector<BoundingBox> threadBboxes(omp_get_max_threads());
+
+    #pragma omp parallel
+    {
+        CoordinatesMap map;
+
+        #pragma omp for schedule(dynamic)
+        for(int boxId = 0; boxId < boxes.size(); boxId++)
+        {
+            if(!map.build(panoramaSize, pose, intrinsic, boxes[boxId]))
+            {
+                continue;
+            }
+
+            if(map.getBoundingBox().isEmpty())
+            {
+                continue;
+            }
+
+            BoundingBox& threadBbox = threadBboxes[omp_get_thread_num()];
+            threadBbox = threadBbox.unionWith(map.getBoundingBox());
+        }
+    }
+
+    globalBbox = BoundingBox();
+    for(const BoundingBox& threadBbox : threadBboxes)
+    {
+        if(!threadBbox.isEmpty())
+        {
+            globalBbox = globalBbox.unionWith(threadBbox);
+        }
+    }
+}
+
+bool warpTile(WarpedTile& tile, const std::pair<int, int>& panoramaSize, const geometry::Pose3& pose,
+              const camera::IntrinsicBase& intrinsic, const BoundingBox& tileBbox,
+              const GaussianPyramidNoMask& pyramid, bool clamp)
+{
+    tile.bbox = tileBbox;
+    tile.valid = false;
+
+    // Prepare coordinates map
+    CoordinatesMap map;
+    if(!map.build(panoramaSize, pose, intrinsic, tileBbox))
+    {
+        return false;
+    }
+
+    // Warp image
+    if(!tile.warper.warp(map, pyramid, clamp))
+    {
+        return false;
+    }
+
+    // Alpha mask
+    if(!distanceToCenter(tile.weights, map, intrinsic.w(), intrinsic.h()))
+    {
+        return false;
+    }
+
+    tile.valid = true;
+    return true;
+}
+
+} // namespace aliceVision
@@ -3,6 +3,10 @@
 #include "coordinatesMap.hpp"
 #include "gaussian.hpp"
 
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 
 namespace aliceVision
 {
@@ -34,4 +38,92 @@ public:
     virtual bool warp(const CoordinatesMap& map, const GaussianPyramidNoMask& pyramid, bool clamp);
 };
 
+/**
+ * @brief A tile of a view warped in the panorama
+ */
+struct WarpedTile
+{
+    /// tile bounding box in the panorama
+    BoundingBox bbox;
+    bool valid = false;
+
+    GaussianWarper warper;
+    aliceVision::image::Image<float> weights;
+};
+
+/**
+ * @brief Bounded queue of warped tiles between the warping threads and a single writer.
+ * The tile i is stored in the slot i % capacity: its warping waits for the writer to release
+ * the slot (after the tile i - capacity is written), and the writer consumes the tiles in order
+ * while the next tiles are warped. The memory usage is bounded by the capacity.
+ * The tiles must be acquired in increasing order by the warping threads (e.g. dynamic schedule).
+ */
+class WarpedTilesQueue
+{
+public:
+    explicit WarpedTilesQueue(size_t capacity);
+
+    /**
+     * @brief Wait for the slot of a tile to be released by the writer
+     * @param[in] tileIndex The tile index
+     * @return the slot to fill with the warped tile
+     */
+    WarpedTile& acquire(size_t tileIndex);
+
+    /**
+     * @brief Mark a filled tile as ready to be written
+     * @param[in] tileIndex The tile index
+     */
+    void push(size_t tileIndex);
+
+    /**
+     * @brief Wait for the next tile to write, in the tiles order
+     * @return the warped tile, valid until pop
+     */
+    const WarpedTile& front();
+
+    /**
+     * @brief Release the slot of the written tile
+     */
+    void pop();
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::vector<WarpedTile> _slots;
+    std::vector<bool> _ready;
+    /// index of the next tile to write
+    size_t _nextTile = 0;
+};
+
+/**
+ * @brief Compute the bounding box of a view in the panorama.
+ * The coarse bounding box is split in tiles processed in parallel.
+ * @param[out] globalBbox The bounding box of the view in the panorama
+ * @param[in] panoramaSize The panorama size
+ * @param[in] pose The camera pose
+ * @param[in] intrinsic The camera intrinsics
+ * @param[in] coarseBbox The coarse bounding box of the view (snapped to the tiles grid)
+ * @param[in] tileSize The tile size
+ */
+void computeWarpedBoundingBox(BoundingBox& globalBbox, const std::pair<int, int>& panoramaSize,
+                              const geometry::Pose3& pose, const camera::IntrinsicBase& intrinsic,
+                              const BoundingBox& coarseBbox, int tileSize);
+
+/**
+ * @brief Warp a tile of a view in the panorama: compute its coordinates map,
+ *        sample the (shared, read-only) pyramid of the view and compute the blending weights.
+ * @param[out] tile The warped tile
+ * @param[in] panoramaSize The panorama size
+ * @param[in] pose The camera pose
+ * @param[in] intrinsic The camera intrinsics
+ * @param[in] tileBbox The tile bounding box in the panorama
+ * @param[in] pyramid The gaussian pyramid of the view image
+ * @param[in] clamp Clamp the colors to the half float range
+ * @return false if the tile is not visible
+ */
+bool warpTile(WarpedTile& tile, const std::pair<int, int>& panoramaSize, const geometry::Pose3& pose,
+              const camera::IntrinsicBase& intrinsic, const BoundingBox& tileBbox,
+              const GaussianPyramidNoMask& pyramid, bool clamp);
+
 } // namespace aliceVision
\ No newline at end of file
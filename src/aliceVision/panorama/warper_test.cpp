@@ -0,0 +1,247 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/panorama/distance.hpp>
+#include <aliceVision/panorama/remapBbox.hpp>
+#include <aliceVision/panorama/warper.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <future>
+#include <random>
+
+#define BOOST_TEST_MODULE panoramaWarper
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+const std::pair<int, int> panoramaSize(1024, 512);
+const int tileSize = 64;
+
+/**
+ * @brief A smooth source image: the pyramid levels of neighbor pixels are close.
+ */
+image::Image<image::RGBfColor> createSource(int width, int height, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> distribution(-0.05f, 0.05f);
+    image::Image<image::RGBfColor> source(width, height);
+    for(int i = 0; i < height; i++)
+        for(int j = 0; j < width; j++)
+            source(i, j) = image::RGBfColor(float(j) / width + distribution(generator), float(i) / height,
+                                            0.5f + 0.25f * std::sin(0.05f * (i + j)));
+    return source;
+}
+
+/**
+ * @brief The tiles of the view bounding box, as in the panoramaWarping software.
+ */
+std::vector<BoundingBox> getTiles(const BoundingBox& globalBbox)
+{
+    std::vector<BoundingBox> boxes;
+    for(int y = 0; y < globalBbox.height; y += tileSize)
+    {
+        for(int x = 0; x < globalBbox.width; x += tileSize)
+        {
+            BoundingBox localBbox;
+            localBbox.left = x + globalBbox.left;
+            localBbox.top = y + globalBbox.top;
+            localBbox.width = tileSize;
+            localBbox.height = tileSize;
+            boxes.push_back(localBbox);
+        }
+    }
+    return boxes;
+}
+
+struct View
+{
+    geometry::Pose3 pose;
+    std::shared_ptr<camera::IntrinsicBase> intrinsic;
+    BoundingBox globalBbox;
+};
+
+View createView()
+{
+    View view;
+    view.pose = geometry::Pose3(RotationAroundY(0.3) * RotationAroundX(-0.2), Vec3::Zero());
+    view.intrinsic = std::make_shared<camera::PinholeRadialK3>(400, 300, 350.0, 200.0, 150.0, -0.05, 0.01, 0.0);
+
+    BoundingBox coarseBbox;
+    BOOST_REQUIRE(computeCoarseBB(coarseBbox, panoramaSize, view.pose, *view.intrinsic));
+    coarseBbox.snapToGrid(tileSize);
+
+    computeWarpedBoundingBox(view.globalBbox, panoramaSize, view.pose, *view.intrinsic, coarseBbox, tileSize);
+
+    // reference: serial union of the tiles bounding boxes
+    BoundingBox referenceBbox;
+    for(int y = 0; y < coarseBbox.height; y += tileSize)
+    {
+        for(int x = 0; x < coarseBbox.width; x += tileSize)
+        {
+            BoundingBox localBbox;
+            localBbox.left = x + coarseBbox.left;
+            localBbox.top = y + coarseBbox.top;
+            localBbox.width = tileSize;
+            localBbox.height = tileSize;
+            localBbox.clampRight(coarseBbox.getRight());
+            localBbox.clampBottom(coarseBbox.getBottom());
+
+            CoordinatesMap map;
+            if(map.build(panoramaSize, view.pose, *view.intrinsic, localBbox) && !map.getBoundingBox().isEmpty())
+                referenceBbox = referenceBbox.unionWith(map.getBoundingBox());
+        }
+    }
+
+    BOOST_CHECK_EQUAL(view.globalBbox.left, referenceBbox.left);
+    BOOST_CHECK_EQUAL(view.globalBbox.top, referenceBbox.top);
+    BOOST_CHECK_EQUAL(view.globalBbox.width, referenceBbox.width);
+    BOOST_CHECK_EQUAL(view.globalBbox.height, referenceBbox.height);
+
+    // the view does not cross the panorama border
+    BOOST_REQUIRE_GT(view.globalBbox.width, 2 * tileSize);
+    BOOST_REQUIRE_GT(view.globalBbox.height, 2 * tileSize);
+    BOOST_REQUIRE_LE(view.globalBbox.getRight(), panoramaSize.first - 1);
+
+    return view;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(panorama_warpTilesFull)
+{
+    std::mt19937 generator(42);
+    const View view = createView();
+    const BoundingBox& globalBbox = view.globalBbox;
+
+    GaussianPyramidNoMask pyramid(view.intrinsic->w(), view.intrinsic->h());
+    image::Image<image::RGBfColor> source = createSource(view.intrinsic->w(), view.intrinsic->h(), generator);
+    BOOST_REQUIRE(pyramid.processInPlace(source));
+
+    // reference: the whole bounding box warped at once
+    CoordinatesMap fullMap;
+    BOOST_REQUIRE(fullMap.build(panoramaSize, view.pose, *view.intrinsic, globalBbox));
+    GaussianWarper fullWarper;
+    BOOST_REQUIRE(fullWarper.warp(fullMap, pyramid, false));
+    image::Image<float> fullWeights;
+    BOOST_REQUIRE(distanceToCenter(fullWeights, fullMap, view.intrinsic->w(), view.intrinsic->h()));
+
+    const image::Image<image::RGBfColor>& fullColor = fullWarper.getColor();
+    const image::Image<unsigned char>& fullMask = fullWarper.getMask();
+
+    std::size_t nbValidPixels = 0;
+    std::size_t nbBorderDifferences = 0;
+    std::size_t nbBorderPixels = 0;
+
+    for(const BoundingBox& tileBbox : getTiles(globalBbox))
+    {
+        WarpedTile tile;
+        if(!warpTile(tile, panoramaSize, view.pose, *view.intrinsic, tileBbox, pyramid, false))
+            continue;
+
+        const image::Image<image::RGBfColor>& color = tile.warper.getColor();
+        const image::Image<unsigned char>& mask = tile.warper.getMask();
+
+        for(int i = 0; i < tileSize; i++)
+        {
+            const int y = tileBbox.top - globalBbox.top + i;
+            if(y >= globalBbox.height)
+                break;
+
+            for(int j = 0; j < tileSize; j++)
+            {
+                const int x = tileBbox.left - globalBbox.left + j;
+                if(x >= globalBbox.width)
+                    break;
+
+                // the mask and the weights only depend on the pixel coordinates
+                BOOST_REQUIRE_EQUAL(int(mask(i, j)), int(fullMask(y, x)));
+                BOOST_REQUIRE_EQUAL(tile.weights(i, j), fullWeights(y, x));
+
+                if(!mask(i, j))
+                    continue;
+
+                ++nbValidPixels;
+
+                // the pyramid level is chosen from the next pixels, or from the previous ones
+                // on the last row and column of a map: the level may differ on the tiles borders
+                const bool tileBorder = (i == tileSize - 1) || (j == tileSize - 1) ||
+                                        (y == globalBbox.height - 1) || (x == globalBbox.width - 1);
+                if(tileBorder)
+                {
+                    ++nbBorderPixels;
+                    if(!(color(i, j) == fullColor(y, x)))
+                    {
+                        ++nbBorderDifferences;
+                        BOOST_CHECK_SMALL((color(i, j) - fullColor(y, x)).norm(), 0.05f);
+                    }
+                    continue;
+                }
+
+                BOOST_REQUIRE_EQUAL(color(i, j).r(), fullColor(y, x).r());
+                BOOST_REQUIRE_EQUAL(color(i, j).g(), fullColor(y, x).g());
+                BOOST_REQUIRE_EQUAL(color(i, j).b(), fullColor(y, x).b());
+            }
+        }
+    }
+
+    BOOST_CHECK_GT(nbValidPixels, 10000);
+    BOOST_CHECK_LT(nbBorderDifferences, nbBorderPixels / 10);
+    BOOST_TEST_MESSAGE(nbValidPixels << " valid pixels, " << nbBorderDifferences << " / " << nbBorderPixels
+                                     << " tiles border pixels on another pyramid level");
+}
+
+BOOST_AUTO_TEST_CASE(panorama_warpedTilesQueue)
+{
+    std::mt19937 generator(7);
+    const View view = createView();
+    const BoundingBox& globalBbox = view.globalBbox;
+
+    GaussianPyramidNoMask pyramid(view.intrinsic->w(), view.intrinsic->h());
+    image::Image<image::RGBfColor> source = createSource(view.intrinsic->w(), view.intrinsic->h(), generator);
+    BOOST_REQUIRE(pyramid.processInPlace(source));
+
+    const std::vector<BoundingBox> boxes = getTiles(globalBbox);
+
+    // the tiles written through the queue, with a small capacity, are the serially warped tiles in order
+    for(const std::size_t capacity : {1, 2, 5})
+    {
+        WarpedTilesQueue queue(capacity);
+        std::vector<bool> checked(boxes.size(), false);
+
+        std::future<void> writing = std::async(std::launch::async, [&]() {
+            WarpedTile reference;
+            for(std::size_t boxId = 0; boxId < boxes.size(); boxId++)
+            {
+                const WarpedTile& tile = queue.front();
+                const bool valid = warpTile(reference, panoramaSize, view.pose, *view.intrinsic, boxes[boxId], pyramid, false);
+
+                checked[boxId] = (tile.bbox.left == boxes[boxId].left) && (tile.bbox.top == boxes[boxId].top) && (tile.valid == valid);
+                if(valid && checked[boxId])
+                {
+                    checked[boxId] = (tile.weights.GetMat() == reference.weights.GetMat()) &&
+                                     (tile.warper.getMask().GetMat() == reference.warper.getMask().GetMat());
+                }
+                queue.pop();
+            }
+        });
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int boxId = 0; boxId < boxes.size(); boxId++)
+        {
+            WarpedTile& tile = queue.acquire(boxId);
+            warpTile(tile, panoramaSize, view.pose, *view.intrinsic, boxes[boxId], pyramid, false);
+            queue.push(boxId);
+        }
+
+        writing.get();
+
+        for(std::size_t boxId = 0; boxId < boxes.size(); boxId++)
+            BOOST_CHECK(checked[boxId]);
+    }
+}
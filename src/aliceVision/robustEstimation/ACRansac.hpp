@@ -14,6 +14,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -130,6 +132,245 @@ inline ErrorIndex bestNFA(int startIndex, //number of point required for estimat
 }
 
 
+/**
+ * @brief Find the best NFA of the residuals of a model without sorting all of them.
+ *
+ * The residuals are bucketed by magnitude (counting sort on their binary representation,
+ * which is monotonic for positive floating point values). The NFA of the ranks of a bucket
+ * is bounded using the smallest and the largest residual of the bucket:
+ *  - a model is rejected without any sort if no bucket can reach the NFA to beat,
+ *  - otherwise only the buckets which can contain the best NFA are sorted and evaluated.
+ *
+ * The result is the same as bestNFA on the sorted residuals.
+ */
+class BucketedNFA
+{
+public:
+
+  /**
+   * @brief BucketedNFA constructor
+   * @param[in] startIndex number of point required for estimation
+   * @param[in] logalpha0 kernel logalpha0
+   * @param[in] loge0 log10 of the number of tests
+   * @param[in] maxThreshold maximum residual of an inlier
+   * @param[in] logc_n tabulated logcombi(.,n)
+   * @param[in] logc_k tabulated logcombi(k,.)
+   * @param[in] multError kernel error multiplier
+   */
+  BucketedNFA(std::size_t startIndex,
+              double logalpha0,
+              double loge0,
+              double maxThreshold,
+              const std::vector<float>& logc_n,
+              const std::vector<float>& logc_k,
+              double multError = 1.0)
+    : _startIndex(startIndex)
+    , _logalpha0(logalpha0)
+    , _loge0(loge0)
+    , _maxThreshold(maxThreshold)
+    , _logc_n(logc_n)
+    , _logc_k(logc_k)
+    , _multError(multError)
+  {}
+
+  /**
+   * @brief Find the best NFA of a model and its number of inliers.
+   * @param[in] residuals The residual of each data point (not sorted)
+   * @param[in] nfaToBeat The NFA of the best model so far
+   * @param[out] best The best NFA of the model and its number of inliers, only valid if the model is better
+   * @return true if the best NFA of the model is strictly lower than nfaToBeat
+   */
+  bool evaluate(const std::vector<double>& residuals, double nfaToBeat, ErrorIndex& best)
+  {
+    fillBuckets(residuals);
+
+    best = ErrorIndex(std::numeric_limits<double>::infinity(), _startIndex);
+
+    const std::size_t nbBuckets = _bucketsMin.size();
+    _lowerBounds.assign(nbBuckets, std::numeric_limits<double>::infinity());
+
+    // bound the NFA of each bucket with its smallest and largest residuals
+    double minLowerBound = std::numeric_limits<double>::infinity();
+    double minUpperBound = std::numeric_limits<double>::infinity();
+
+    for(std::size_t b = 0; b < nbBuckets; ++b)
+    {
+      const std::size_t kBegin = std::max(_bucketsBegin[b] + 1, _startIndex + 1);
+      const std::size_t kEnd = _bucketsBegin[b + 1];
+
+      if(kBegin > kEnd)
+        continue;
+
+      const double logalphaMin = logalpha(_bucketsMin[b]);
+      const double logalphaMax = logalpha(_bucketsMax[b]);
+
+      double lowerBound = std::numeric_limits<double>::infinity();
+      double upperBound = std::numeric_limits<double>::infinity();
+
+      for(std::size_t k = kBegin; k <= kEnd; ++k)
+      {
+        lowerBound = std::min(lowerBound, nfa(logalphaMin, k));
+        upperBound = std::min(upperBound, nfa(logalphaMax, k));
+      }
+
+      _lowerBounds[b] = lowerBound;
+      minLowerBound = std::min(minLowerBound, lowerBound);
+      minUpperBound = std::min(minUpperBound, upperBound);
+    }
+
+    // early rejection: no rank can beat the best model so far
+    if(!(minLowerBound < nfaToBeat))
+      return false;
+
+    // exact evaluation of the buckets which can contain the best NFA
+    for(std::size_t b = 0; b < nbBuckets; ++b)
+    {
+      const double lowerBound = _lowerBounds[b];
+
+      if(lowerBound > minUpperBound || !(lowerBound < best.first) || !(lowerBound < nfaToBeat))
+        continue;
+
+      sortBucket(b);
+
+      const std::size_t kBegin = std::max(_bucketsBegin[b] + 1, _startIndex + 1);
+      const std::size_t kEnd = _bucketsBegin[b + 1];
+
+      for(std::size_t k = kBegin; k <= kEnd; ++k)
+      {
+        const ErrorIndex index(nfa(logalpha(_buckets[k - 1].first), k), k);
+
+        if(index.first < best.first)
+          best = index;
+      }
+    }
+
+    return best.first < nfaToBeat;
+  }
+
+  /**
+   * @brief Get the inliers of the last evaluated model, sorted by increasing residual.
+   * @param[in] nbInliers The number of inliers
+   * @param[out] inliers The inliers indexes
+   * @return the residual of the last inlier
+   */
+  double getInliers(std::size_t nbInliers, std::vector<std::size_t>& inliers)
+  {
+    for(std::size_t b = 0; b < _bucketsMin.size() && _bucketsBegin[b] < nbInliers; ++b)
+      sortBucket(b);
+
+    inliers.resize(nbInliers);
+    for(std::size_t i = 0; i < nbInliers; ++i)
+      inliers[i] = _buckets[i].second;
+
+    return _buckets[nbInliers - 1].first;
+  }
+
+private:
+
+  inline double logalpha(double error) const
+  {
+    return _logalpha0 + _multError * log10(error + std::numeric_limits<float>::epsilon());
+  }
+
+  inline double nfa(double logalpha, std::size_t k) const
+  {
+    return _loge0 + logalpha * (double) (k - _startIndex) + _logc_n[k] + _logc_k[k];
+  }
+
+  inline static std::uint64_t residualBits(double error)
+  {
+    error += 0.0; // -0.0 to 0.0
+    std::uint64_t bits;
+    std::memcpy(&bits, &error, sizeof(bits));
+    return bits;
+  }
+
+  /**
+   * @brief Counting sort of the residuals below the threshold in buckets of similar magnitudes
+   */
+  void fillBuckets(const std::vector<double>& residuals)
+  {
+    std::uint64_t minBits = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t maxBits = 0;
+    std::size_t nbValid = 0;
+
+    for(const double error : residuals)
+    {
+      if(!(error <= _maxThreshold))
+        continue;
+      const std::uint64_t bits = residualBits(error);
+      minBits = std::min(minBits, bits);
+      maxBits = std::max(maxBits, bits);
+      ++nbValid;
+    }
+
+    const std::size_t nbBuckets = std::max<std::size_t>(1, nbValid / _bucketSize);
+    const double scale = (nbValid == 0) ? 0.0 : nbBuckets / (static_cast<double>(maxBits - minBits) + 1.0);
+
+    _bucketsBegin.assign(nbBuckets + 1, 0);
+    _bucketsMin.assign(nbBuckets, std::numeric_limits<double>::infinity());
+    _bucketsMax.assign(nbBuckets, 0.0);
+    _bucketsSorted.assign(nbBuckets, false);
+    _bucketIndexes.resize(residuals.size());
+
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      const double error = residuals[i];
+      if(!(error <= _maxThreshold))
+        continue;
+      const std::size_t b = std::min(nbBuckets - 1, static_cast<std::size_t>(static_cast<double>(residualBits(error) - minBits) * scale));
+      _bucketIndexes[i] = b;
+      ++_bucketsBegin[b + 1];
+      _bucketsMin[b] = std::min(_bucketsMin[b], error);
+      _bucketsMax[b] = std::max(_bucketsMax[b], error);
+    }
+
+    for(std::size_t b = 0; b < nbBuckets; ++b)
+      _bucketsBegin[b + 1] += _bucketsBegin[b];
+
+    _bucketsFill.assign(_bucketsBegin.begin(), _bucketsBegin.end() - 1);
+    _buckets.resize(nbValid);
+
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      const double error = residuals[i];
+      if(!(error <= _maxThreshold))
+        continue;
+      _buckets[_bucketsFill[_bucketIndexes[i]]++] = ErrorIndex(error, i);
+    }
+  }
+
+  void sortBucket(std::size_t b)
+  {
+    if(_bucketsSorted[b])
+      return;
+    std::sort(_buckets.begin() + _bucketsBegin[b], _buckets.begin() + _bucketsBegin[b + 1]);
+    _bucketsSorted[b] = true;
+  }
+
+  /// mean number of residuals per bucket
+  static constexpr std::size_t _bucketSize = 16;
+
+  const std::size_t _startIndex;
+  const double _logalpha0;
+  const double _loge0;
+  const double _maxThreshold;
+  const std::vector<float>& _logc_n;
+  const std::vector<float>& _logc_k;
+  const double _multError;
+
+  /// residuals below the threshold ordered by bucket
+  std::vector<ErrorIndex> _buckets;
+  /// first residual of each bucket (and the number of residuals at the end)
+  std::vector<std::size_t> _bucketsBegin;
+  std::vector<std::size_t> _bucketsFill;
+  std::vector<std::size_t> _bucketIndexes;
+  std::vector<double> _bucketsMin;
+  std::vector<double> _bucketsMax;
+  std::vector<double> _lowerBounds;
+  std::vector<bool> _bucketsSorted;
+};
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
@@ -160,8 +401,7 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
-  std::vector<double> vec_residuals_(nData);
+  std::vector<double> vec_residuals(nData);
 
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
   std::vector<size_t> vec_index(nData);
@@ -172,6 +412,8 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
   std::vector<float> vec_logc_n, vec_logc_k;
   makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
 
+  BucketedNFA nfaEvaluator(sizeSample, kernel.logalpha0(), loge0, maxThreshold, vec_logc_n, vec_logc_k, kernel.multError());
+
   // Output parameters
   double minNFA = std::numeric_limits<double>::infinity();
   double errorMax = std::numeric_limits<double>::infinity();
@@ -182,31 +424,33 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
+  std::vector<std::size_t> vec_sample(sizeSample); // Sample indices
+  std::vector<typename Kernel::ModelT> vec_models; // Up to max_models solutions
+
   // Main estimation loop.
   for(std::size_t iter = 0; iter < nIter; ++iter)
   {
-    std::vector<std::size_t> vec_sample(sizeSample); // Sample indices
     if (bACRansacMode)
       uniformSample(randomNumberGenerator, sizeSample, vec_index, vec_sample); // Get random sample
     else
       uniformSample(randomNumberGenerator, sizeSample, nData, vec_sample); // Get random sample
 
-    std::vector<typename Kernel::ModelT> vec_models; // Up to max_models solutions
+    vec_models.clear();
     kernel.fit(vec_sample, vec_models);
 
     // Evaluate models
     bool better = false;
     for (std::size_t k = 0; k < vec_models.size(); ++k)
     {
-      // Residuals computation and ordering
-      kernel.errors(vec_models[k], vec_residuals_);
+      // Residuals computation
+      kernel.errors(vec_models[k], vec_residuals);
 
       if (!bACRansacMode)
       {
         unsigned int nInlier = 0;
         for (std::size_t i = 0; i < nData; ++i)
         {
-          if (vec_residuals_[i] <= maxThreshold)
+          if (vec_residuals[i] <= maxThreshold)
             ++nInlier;
         }
         if (nInlier > 2.5 * sizeSample) // does the model is meaningful
@@ -214,33 +458,15 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
       }
       if (bACRansacMode)
       {
-        for (size_t i = 0; i < nData; ++i)
-        {
-          const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
-        }
-        std::sort(vec_residuals.begin(), vec_residuals.end());
-
         // Most meaningful discrimination inliers/outliers
-        const ErrorIndex best = bestNFA(
-          sizeSample,
-          kernel.logalpha0(),
-          vec_residuals,
-          loge0,
-          maxThreshold,
-          vec_logc_n,
-          vec_logc_k,
-          kernel.multError());
-
-        if (best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
+        // (models which cannot beat the best one are rejected before any sort)
+        ErrorIndex best;
+        if (nfaEvaluator.evaluate(vec_residuals, minNFA, best))
         {
           // A better model was found
           better = true;
           minNFA = best.first;
-          vec_inliers.resize(best.second);
-          for (size_t i=0; i<best.second; ++i)
-            vec_inliers[i] = vec_residuals[i].second;
-          errorMax = vec_residuals[best.second-1].first; // Error threshold
+          errorMax = nfaEvaluator.getInliers(best.second, vec_inliers); // Error threshold
           if(model) *model = vec_models[k];
 
           ALICEVISION_LOG_TRACE("  nfa=" << minNFA
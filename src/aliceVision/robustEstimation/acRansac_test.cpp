@@ -18,7 +18,9 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 
+#include <algorithm>
 #include <iterator>
+#include <limits>
 #include <random>
 
 using namespace svg;
@@ -271,3 +273,67 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// check that the bucketed NFA evaluation finds the same best NFA and inliers as
+// the evaluation over the sorted residuals
+BOOST_AUTO_TEST_CASE(ACRANSAC_BucketedNFA)
+{
+  std::mt19937 gen;
+  std::exponential_distribution<double> inlierDistribution(100.0);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  const std::size_t nData = 2000;
+  const std::size_t sizeSample = 7;
+  const double loge0 = log10(3.0 * (nData - sizeSample));
+  const double logalpha0 = log10(0.01);
+
+  std::vector<float> logc_n, logc_k;
+  makelogcombi(sizeSample, nData, logc_k, logc_n);
+
+  for(const double maxThreshold : {std::numeric_limits<double>::infinity(), 0.05})
+  {
+    BucketedNFA nfaEvaluator(sizeSample, logalpha0, loge0, maxThreshold, logc_n, logc_k, 0.5);
+
+    double minNFA = std::numeric_limits<double>::infinity();
+    double minNFABucketed = std::numeric_limits<double>::infinity();
+
+    for(std::size_t model = 0; model < 50; ++model)
+    {
+      // residuals of models with an increasing ratio of inliers
+      const double inlierRatio = model / 50.0;
+      std::vector<double> residuals(nData);
+      for(double& residual : residuals)
+        residual = (uniform(gen) < inlierRatio) ? inlierDistribution(gen) : uniform(gen);
+
+      // reference: sorted residuals
+      std::vector<ErrorIndex> sortedResiduals(nData);
+      for(std::size_t i = 0; i < nData; ++i)
+        sortedResiduals[i] = ErrorIndex(residuals[i], i);
+      std::sort(sortedResiduals.begin(), sortedResiduals.end());
+
+      const ErrorIndex best = bestNFA(sizeSample, logalpha0, sortedResiduals, loge0, maxThreshold, logc_n, logc_k, 0.5);
+
+      ErrorIndex bestBucketed;
+      const bool better = nfaEvaluator.evaluate(residuals, minNFABucketed, bestBucketed);
+
+      BOOST_CHECK_EQUAL(better, best.first < minNFA);
+
+      if(better)
+      {
+        BOOST_CHECK_EQUAL(best.first, bestBucketed.first);
+        BOOST_CHECK_EQUAL(best.second, bestBucketed.second);
+
+        std::vector<std::size_t> inliers;
+        const double errorMax = nfaEvaluator.getInliers(bestBucketed.second, inliers);
+
+        BOOST_CHECK_EQUAL(errorMax, sortedResiduals[best.second - 1].first);
+        BOOST_REQUIRE_EQUAL(inliers.size(), best.second);
+        for(std::size_t i = 0; i < inliers.size(); ++i)
+          BOOST_CHECK_EQUAL(inliers[i], sortedResiduals[i].second);
+
+        minNFA = best.first;
+        minNFABucketed = bestBucketed.first;
+      }
+    }
+  }
+}
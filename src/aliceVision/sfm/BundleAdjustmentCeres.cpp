@@ -7,9 +7,11 @@
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <aliceVision/sfm/ResidualErrorConstraintFunctor.hpp>
 #include <aliceVision/sfm/ResidualErrorRotationPriorFunctor.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/Timer.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/camera/Equidistant.hpp>
@@ -18,6 +20,7 @@
 
 #include <ceres/rotation.h>
 
+#include <exception>
 #include <fstream>
 
 
@@ -34,10 +37,32 @@ using namespace aliceVision::geometry;
  * @brief Create the appropriate cost functor according the provided input camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
  * @param[in] observation The corresponding observation
+ * @param[in] analyticDerivatives Use the cost functions with analytic derivatives instead of the automatic differentiation
  * @return cost functor
  */
-ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation)
+ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation, bool analyticDerivatives)
 {
+  if(analyticDerivatives)
+  {
+    switch(intrinsicPtr->getType())
+    {
+      case EINTRINSIC::PINHOLE_CAMERA:
+        return new analytic::ResidualErrorCostFunction<analytic::Pinhole>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_RADIAL1:
+        return new analytic::ResidualErrorCostFunction<analytic::PinholeRadialK1>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_RADIAL3:
+        return new analytic::ResidualErrorCostFunction<analytic::PinholeRadialK3>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_BROWN:
+        return new analytic::ResidualErrorCostFunction<analytic::PinholeBrownT2>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_FISHEYE:
+        return new analytic::ResidualErrorCostFunction<analytic::PinholeFisheye>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
+        return new analytic::ResidualErrorCostFunction<analytic::PinholeFisheye1>(observation);
+      default:
+        break; // fallback to the automatic differentiation
+    }
+  }
+
   switch(intrinsicPtr->getType())
   {
     case EINTRINSIC::PINHOLE_CAMERA:
@@ -61,10 +86,32 @@ ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intri
  * @brief Create the appropriate cost functor according the provided input rig camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
  * @param[in] observation The corresponding observation
+ * @param[in] analyticDerivatives Use the cost functions with analytic derivatives instead of the automatic differentiation
  * @return cost functor
  */
-ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation)
+ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation, bool analyticDerivatives)
 {
+  if(analyticDerivatives)
+  {
+    switch(intrinsicPtr->getType())
+    {
+      case EINTRINSIC::PINHOLE_CAMERA:
+        return new analytic::ResidualErrorRigCostFunction<analytic::Pinhole>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_RADIAL1:
+        return new analytic::ResidualErrorRigCostFunction<analytic::PinholeRadialK1>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_RADIAL3:
+        return new analytic::ResidualErrorRigCostFunction<analytic::PinholeRadialK3>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_BROWN:
+        return new analytic::ResidualErrorRigCostFunction<analytic::PinholeBrownT2>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_FISHEYE:
+        return new analytic::ResidualErrorRigCostFunction<analytic::PinholeFisheye>(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
+        return new analytic::ResidualErrorRigCostFunction<analytic::PinholeFisheye1>(observation);
+      default:
+        break; // fallback to the automatic differentiation
+    }
+  }
+
   switch(intrinsicPtr->getType())
   {
     case EINTRINSIC::PINHOLE_CAMERA:
@@ -257,6 +304,7 @@ void BundleAdjustmentCeres::Statistics::show() const
 
   ALICEVISION_LOG_INFO("Bundle Adjustment Statistics:\n"
                         << ss.str()
+                        << "\t- problem setup duration: " << setupTime << " s\n"
                         << "\t- adjustment duration: " << time << " s\n"
                         << "\t- poses:\n"
                         << "\t    - # refined:  " << states[EParameter::POSE][EParameterState::REFINED]  << "\n"
@@ -317,22 +365,25 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     poseBlock.at(5) = t(2);
 
     double* poseBlockPtr = poseBlock.data();
-    problem.AddParameterBlock(poseBlockPtr, 6);
 
     // add pose parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(poseBlockPtr);
 
+    ParameterBlockSetup setup;
+    setup.size = 6;
+
     // keep the camera extrinsics constants
     if(cameraPose.isLocked() || isConstant || (!refineTranslation && !refineRotation))
     {
       // set the whole parameter block as constant.
       _statistics.addState(EParameter::POSE, EParameterState::CONSTANT);
-      problem.SetParameterBlockConstant(poseBlockPtr);
+      setup.isConstant = true;
+      setupParameterBlock(poseBlockPtr, setup, problem);
       return;
     }
 
     // constant parameters
-    std::vector<int> constantExtrinsic;
+    std::vector<int>& constantExtrinsic = setup.constantParameters;
 
     // don't refine rotations
     if(!refineRotation)
@@ -350,12 +401,7 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
       constantExtrinsic.push_back(5);
     }
 
-    // subset parametrization
-    if(!constantExtrinsic.empty())
-    {
-      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(6, constantExtrinsic);
-      problem.SetParameterization(poseBlockPtr, subsetParameterization);
-    }
+    setupParameterBlock(poseBlockPtr, setup, problem);
 
     _statistics.addState(EParameter::POSE, EParameterState::REFINED);
   };
@@ -440,25 +486,39 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     assert(isValid(intrinsicPtr->getType()));
 
     std::vector<double>& intrinsicBlock = _intrinsicsBlocks[intrinsicId];
-    intrinsicBlock = intrinsicPtr->getParams();
+    const std::vector<double> intrinsicParams = intrinsicPtr->getParams();
+
+    if(intrinsicBlock.size() != intrinsicParams.size())
+    {
+      // the parameter block memory will move
+      removeParameterBlock(intrinsicBlock.data(), problem);
+      intrinsicBlock = intrinsicParams;
+    }
+    else
+    {
+      std::copy(intrinsicParams.begin(), intrinsicParams.end(), intrinsicBlock.begin());
+    }
 
     double* intrinsicBlockPtr = intrinsicBlock.data();
-    problem.AddParameterBlock(intrinsicBlockPtr, intrinsicBlock.size());
 
     // add intrinsic parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(intrinsicBlockPtr);
 
+    ParameterBlockSetup setup;
+    setup.size = intrinsicBlock.size();
+
     // keep the camera intrinsic constant
     if(intrinsicPtr->isLocked() || !refineIntrinsics || getIntrinsicState(intrinsicId) == EParameterState::CONSTANT)
     {
       // set the whole parameter block as constant.
       _statistics.addState(EParameter::INTRINSIC, EParameterState::CONSTANT);
-      problem.SetParameterBlockConstant(intrinsicBlockPtr);
+      setup.isConstant = true;
+      setupParameterBlock(intrinsicBlockPtr, setup, problem);
       continue;
     }
 
     // constant parameters
-    std::vector<int> constantIntrinisc;
+    std::vector<int>& constantIntrinisc = setup.constantParameters;
 
     // refine the focal length
     if(refineIntrinsicsFocalLength)
@@ -469,14 +529,14 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
         // if we have an initial guess, we only authorize a margin around this value.
         assert(intrinsicBlock.size() >= 1);
         const unsigned int maxFocalError = 0.2 * std::max(intrinsicPtr->w(), intrinsicPtr->h()); // TODO : check if rounding is needed
-        problem.SetParameterLowerBound(intrinsicBlockPtr, 0, static_cast<double>(intrinsicScaleOffset->initialScale() - maxFocalError));
-        problem.SetParameterUpperBound(intrinsicBlockPtr, 0, static_cast<double>(intrinsicScaleOffset->initialScale() + maxFocalError));
+        setup.lowerBounds.emplace_back(0, static_cast<double>(intrinsicScaleOffset->initialScale() - maxFocalError));
+        setup.upperBounds.emplace_back(0, static_cast<double>(intrinsicScaleOffset->initialScale() + maxFocalError));
       }
       else // no initial guess
       {
         // we don't have an initial guess, but we assume that we use
         // a converging lens, so the focal length should be positive.
-        problem.SetParameterLowerBound(intrinsicBlockPtr, 0, 0.0);
+        setup.lowerBounds.emplace_back(0, 0.0);
       }
     }
     else
@@ -497,10 +557,10 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       const double opticalCenterMaxPercent = 0.55;
 
       // add bounds to the principal point
-      problem.SetParameterLowerBound(intrinsicBlockPtr, 1, opticalCenterMinPercent * intrinsicPtr->w());
-      problem.SetParameterUpperBound(intrinsicBlockPtr, 1, opticalCenterMaxPercent * intrinsicPtr->w());
-      problem.SetParameterLowerBound(intrinsicBlockPtr, 2, opticalCenterMinPercent * intrinsicPtr->h());
-      problem.SetParameterUpperBound(intrinsicBlockPtr, 2, opticalCenterMaxPercent * intrinsicPtr->h());
+      setup.lowerBounds.emplace_back(1, opticalCenterMinPercent * intrinsicPtr->w());
+      setup.upperBounds.emplace_back(1, opticalCenterMaxPercent * intrinsicPtr->w());
+      setup.lowerBounds.emplace_back(2, opticalCenterMinPercent * intrinsicPtr->h());
+      setup.upperBounds.emplace_back(2, opticalCenterMaxPercent * intrinsicPtr->h());
     }
     else
     {
@@ -514,11 +574,7 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       for(std::size_t i = 3; i < intrinsicBlock.size(); ++i)
         constantIntrinisc.push_back(i);
 
-    if(!constantIntrinisc.empty())
-    {
-      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(intrinsicBlock.size(), constantIntrinisc);
-      problem.SetParameterization(intrinsicBlockPtr, subsetParameterization);
-    }
+    setupParameterBlock(intrinsicBlockPtr, setup, problem);
 
     _statistics.addState(EParameter::INTRINSIC, EParameterState::REFINED);
   }
@@ -532,7 +588,71 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
   // note: set it to NULL if you don't want use a lossFunction.
   ceres::LossFunction* lossFunction = _ceresOptions.lossFunction.get();
 
-  // build the residual blocks corresponding to the track observations
+  // parameter blocks needed to create the residual blocks of a view
+  struct ViewBlocks
+  {
+    const IntrinsicBase* intrinsicPtr;
+    /// intrinsic, pose and sub-pose (nullptr if not part of a rig) blocks
+    std::array<double*, 3> blocks;
+    std::array<std::size_t, 3> versions;
+  };
+
+  // residual block to add to the problem
+  struct ResidualBlockToCreate
+  {
+    LandmarkBlock* landmarkBlock;
+    std::size_t residualBlockIndex;
+    const ViewBlocks* viewBlocks;
+    const sfmData::Observation* observation;
+    ceres::CostFunction* costFunction;
+  };
+
+  std::map<IndexT, ViewBlocks> viewsBlocks;
+  std::vector<ResidualBlockToCreate> residualBlocksToCreate;
+
+  const auto getViewBlocks = [&](IndexT viewId) -> const ViewBlocks&
+  {
+    const auto viewBlocksIt = viewsBlocks.find(viewId);
+    if(viewBlocksIt != viewsBlocks.end())
+      return viewBlocksIt->second;
+
+    const sfmData::View& view = sfmData.getView(viewId);
+
+    assert(getPoseState(view.getPoseId()) != EParameterState::IGNORED);
+    assert(getIntrinsicState(view.getIntrinsicId()) != EParameterState::IGNORED);
+
+    // needed parameters to create a residual block (K, pose)
+    ViewBlocks viewBlocks;
+    viewBlocks.intrinsicPtr = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+    viewBlocks.blocks = {{_intrinsicsBlocks.at(view.getIntrinsicId()).data(), _posesBlocks.at(view.getPoseId()).data(), nullptr}};
+
+    if(view.isPartOfRig() && !view.isPoseIndependant())
+      viewBlocks.blocks[2] = _rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data();
+
+    for(std::size_t i = 0; i < viewBlocks.blocks.size(); ++i)
+      viewBlocks.versions[i] = (viewBlocks.blocks[i] == nullptr) ? 0 : _parametersBlocksStates.at(viewBlocks.blocks[i]).version;
+
+    // apply a specific parameter ordering:
+    if(_ceresOptions.useParametersOrdering)
+    {
+      _linearSolverOrdering.AddElementToGroup(viewBlocks.blocks[1], 1);
+      _linearSolverOrdering.AddElementToGroup(viewBlocks.blocks[0], 2);
+
+      if(viewBlocks.blocks[2] != nullptr)
+        _linearSolverOrdering.AddElementToGroup(viewBlocks.blocks[2], 1);
+    }
+
+    return viewsBlocks.emplace(viewId, viewBlocks).first->second;
+  };
+
+  const auto removeResidualBlock = [&](const ObservationResidualBlock& residualBlock)
+  {
+    // the residual block has already been removed with one of its parameter blocks
+    if(areParameterBlocksAlive(residualBlock.versions))
+      problem.RemoveResidualBlock(residualBlock.residualBlockId);
+  };
+
+  // update the residual blocks corresponding to the track observations
   for(const auto& landmarkPair: sfmData.getLandmarks())
   {
     const IndexT landmarkId = landmarkPair.first;
@@ -546,75 +666,163 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       continue;
     }
 
-    std::array<double,3>& landmarkBlock = _landmarksBlocks[landmarkId];
+    if(landmark.observations.empty())
+      continue;
+
+    const bool isNewLandmark = (_landmarksBlocks.find(landmarkId) == _landmarksBlocks.end());
+    const bool isConstant = (!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT);
+
+    LandmarkBlock& landmarkBlock = _landmarksBlocks[landmarkId];
+    landmarkBlock.generation = _problemGeneration;
+
     for(std::size_t i = 0; i < 3; ++i)
-      landmarkBlock.at(i) = landmark.X(Eigen::Index(i));
+      landmarkBlock.values.at(i) = landmark.X(Eigen::Index(i));
+
+    double* landmarkBlockPtr = landmarkBlock.values.data();
 
-    double* landmarkBlockPtr = landmarkBlock.data();
+    if(isNewLandmark)
+      problem.AddParameterBlock(landmarkBlockPtr, 3);
+
+    if(isNewLandmark || isConstant != landmarkBlock.isConstant)
+    {
+      // set the whole landmark parameter block as constant or not.
+      if(isConstant)
+        problem.SetParameterBlockConstant(landmarkBlockPtr);
+      else
+        problem.SetParameterBlockVariable(landmarkBlockPtr);
+
+      landmarkBlock.isConstant = isConstant;
+    }
 
     // add landmark parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(landmarkBlockPtr);
 
+    if(_ceresOptions.useParametersOrdering)
+      _linearSolverOrdering.AddElementToGroup(landmarkBlockPtr, 0);
+
+    // previous residual blocks and observations are both sorted by view id
+    std::vector<ObservationResidualBlock> previousResidualBlocks;
+    previousResidualBlocks.swap(landmarkBlock.residualBlocks);
+    landmarkBlock.residualBlocks.reserve(landmark.observations.size());
+    auto previousIt = previousResidualBlocks.cbegin();
+
     // iterate over 2D observation associated to the 3D landmark
     for(const auto& observationPair: landmark.observations)
     {
-      const sfmData::View& view = sfmData.getView(observationPair.first);
+      const IndexT viewId = observationPair.first;
       const sfmData::Observation& observation = observationPair.second;
+      const ViewBlocks& viewBlocks = getViewBlocks(viewId);
 
-      // each residual block takes a point and a camera as input and outputs a 2
-      // dimensional residual. Internally, the cost function stores the observed
-      // image location and compares the reprojection against the observation.
+      _statistics.addState(EParameter::LANDMARK, isConstant ? EParameterState::CONSTANT : EParameterState::REFINED);
 
-      assert(getPoseState(view.getPoseId()) != EParameterState::IGNORED);
-      assert(getIntrinsicState(view.getIntrinsicId()) != EParameterState::IGNORED);
+      // remove the residual blocks of the removed observations
+      for(; previousIt != previousResidualBlocks.cend() && previousIt->viewId < viewId; ++previousIt)
+        removeResidualBlock(*previousIt);
 
-      // needed parameters to create a residual block (K, pose)
-      double* poseBlockPtr = _posesBlocks.at(view.getPoseId()).data();
-      double* intrinsicBlockPtr = _intrinsicsBlocks.at(view.getIntrinsicId()).data();
-
-      // apply a specific parameter ordering:
-      if(_ceresOptions.useParametersOrdering)
+      if(previousIt != previousResidualBlocks.cend() && previousIt->viewId == viewId)
       {
-        _linearSolverOrdering.AddElementToGroup(landmarkBlockPtr, 0);
-        _linearSolverOrdering.AddElementToGroup(poseBlockPtr, 1);
-        _linearSolverOrdering.AddElementToGroup(intrinsicBlockPtr, 2);
+        const ObservationResidualBlock& previousResidualBlock = *(previousIt++);
+
+        // keep the residual block of an unchanged observation
+        if(previousResidualBlock.versions == viewBlocks.versions &&
+           previousResidualBlock.intrinsicType == viewBlocks.intrinsicPtr->getType() &&
+           previousResidualBlock.x == observation.x &&
+           previousResidualBlock.scale == observation.scale)
+        {
+          landmarkBlock.residualBlocks.push_back(previousResidualBlock);
+          continue;
+        }
+
+        removeResidualBlock(previousResidualBlock);
       }
 
-      if(view.isPartOfRig() && !view.isPoseIndependant())
-      {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
+      ObservationResidualBlock residualBlock;
+      residualBlock.viewId = viewId;
+      residualBlock.intrinsicType = viewBlocks.intrinsicPtr->getType();
+      residualBlock.versions = viewBlocks.versions;
+      residualBlock.x = observation.x;
+      residualBlock.scale = observation.scale;
+      residualBlock.residualBlockId = nullptr;
 
-        double* rigBlockPtr = _rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data();
-        _linearSolverOrdering.AddElementToGroup(rigBlockPtr, 1);
+      residualBlocksToCreate.push_back({&landmarkBlock, landmarkBlock.residualBlocks.size(), &viewBlocks, &observation, nullptr});
+      landmarkBlock.residualBlocks.push_back(residualBlock);
+    }
 
-        problem.AddResidualBlock(costFunction,
-            lossFunction,
-            intrinsicBlockPtr,
-            poseBlockPtr,
-            rigBlockPtr, // subpose of the cameras rig
-            landmarkBlockPtr); // do we need to copy 3D point to avoid false motion, if failure ?
-      }
-      else
-      {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
+    // remove the residual blocks of the removed observations
+    for(; previousIt != previousResidualBlocks.cend(); ++previousIt)
+      removeResidualBlock(*previousIt);
+  }
 
-        problem.AddResidualBlock(costFunction,
-            lossFunction,
-            intrinsicBlockPtr,
-            poseBlockPtr,
-            landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
-      }
+  // remove the landmarks unused by this update with their residual blocks
+  for(auto landmarkBlockIt = _landmarksBlocks.begin(); landmarkBlockIt != _landmarksBlocks.end();)
+  {
+    if(landmarkBlockIt->second.generation != _problemGeneration)
+    {
+      problem.RemoveParameterBlock(landmarkBlockIt->second.values.data());
+      landmarkBlockIt = _landmarksBlocks.erase(landmarkBlockIt);
+    }
+    else
+    {
+      ++landmarkBlockIt;
+    }
+  }
 
-      if(!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT)
-      {
-        // set the whole landmark parameter block as constant.
-        _statistics.addState(EParameter::LANDMARK, EParameterState::CONSTANT);
-        problem.SetParameterBlockConstant(landmarkBlockPtr);
-      }
+  // create the cost functors of the new observations by chunks of landmarks
+  std::exception_ptr exception;
+
+  #pragma omp parallel for schedule(static)
+  for(int i = 0; i < static_cast<int>(residualBlocksToCreate.size()); ++i)
+  {
+    ResidualBlockToCreate& residualBlockToCreate = residualBlocksToCreate.at(i);
+    const ViewBlocks& viewBlocks = *residualBlockToCreate.viewBlocks;
+
+    try
+    {
+      if(viewBlocks.blocks[2] != nullptr)
+        residualBlockToCreate.costFunction = createRigCostFunctionFromIntrinsics(viewBlocks.intrinsicPtr, *residualBlockToCreate.observation, _ceresOptions.useAnalyticDerivatives);
       else
-      {
-        _statistics.addState(EParameter::LANDMARK, EParameterState::REFINED);
-      }
+        residualBlockToCreate.costFunction = createCostFunctionFromIntrinsics(viewBlocks.intrinsicPtr, *residualBlockToCreate.observation, _ceresOptions.useAnalyticDerivatives);
+    }
+    catch(...)
+    {
+      #pragma omp critical(createCostFunction)
+      exception = std::current_exception();
+    }
+  }
+
+  if(exception)
+  {
+    for(const ResidualBlockToCreate& residualBlockToCreate : residualBlocksToCreate)
+      delete residualBlockToCreate.costFunction;
+    std::rethrow_exception(exception);
+  }
+
+  // each residual block takes a point and a camera as input and outputs a 2
+  // dimensional residual. Internally, the cost function stores the observed
+  // image location and compares the reprojection against the observation.
+  // note: the Ceres problem cannot be modified concurrently
+  for(const ResidualBlockToCreate& residualBlockToCreate : residualBlocksToCreate)
+  {
+    const std::array<double*, 3>& blocks = residualBlockToCreate.viewBlocks->blocks;
+    double* landmarkBlockPtr = residualBlockToCreate.landmarkBlock->values.data();
+    ObservationResidualBlock& residualBlock = residualBlockToCreate.landmarkBlock->residualBlocks.at(residualBlockToCreate.residualBlockIndex);
+
+    if(blocks[2] != nullptr)
+    {
+      residualBlock.residualBlockId = problem.AddResidualBlock(residualBlockToCreate.costFunction,
+          lossFunction,
+          blocks[0], // intrinsic
+          blocks[1], // pose
+          blocks[2], // subpose of the cameras rig
+          landmarkBlockPtr); // do we need to copy 3D point to avoid false motion, if failure ?
+    }
+    else
+    {
+      residualBlock.residualBlockId = problem.AddResidualBlock(residualBlockToCreate.costFunction,
+          lossFunction,
+          blocks[0], // intrinsic
+          blocks[1], // pose
+          landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
     }
   }
 }
@@ -645,7 +853,7 @@ void BundleAdjustmentCeres::addConstraints2DToProblem(const sfmData::SfMData& sf
 
 
     ceres::CostFunction* costFunction = createConstraintsCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view_1.getIntrinsicId()), constraint.ObservationFirst.x, constraint.ObservationSecond.x);
-    problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2);
+    _constraintsResidualBlocks.push_back(problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2));
   }
 }
 
@@ -667,41 +875,133 @@ void BundleAdjustmentCeres::addRotationPriorsToProblem(const sfmData::SfMData& s
 
 
     ceres::CostFunction* costFunction = new ceres::AutoDiffCostFunction<ResidualErrorRotationPriorFunctor, 3, 6, 6>(new ResidualErrorRotationPriorFunctor(prior._second_R_first));
-    problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2);
+    _constraintsResidualBlocks.push_back(problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2));
   }
 }
 
-void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
-                                          ERefineOptions refineOptions,
-                                          ceres::Problem& problem)
+void BundleAdjustmentCeres::addParametersPriorsToProblem(ceres::Problem& problem)
 {
-  // clear previously computed data
-  resetProblem();
+  // priors are not robustified
+  ceres::LossFunction* lossFunction = nullptr;
+
+  for(const auto& priorPair : _parametersPriors.intrinsics)
+  {
+    const auto intrinsicBlockIt = _intrinsicsBlocks.find(priorPair.first);
+    if(intrinsicBlockIt == _intrinsicsBlocks.end())
+      continue;
+
+    double* intrinsicBlockPtr = intrinsicBlockIt->second.data();
+    const auto stateIt = _parametersBlocksStates.find(intrinsicBlockPtr);
 
+    // skip intrinsics not refined by this update
+    if(stateIt == _parametersBlocksStates.end() || stateIt->second.generation != _problemGeneration || stateIt->second.setup.isConstant)
+      continue;
+
+    if(priorPair.second.target.size() != intrinsicBlockIt->second.size() ||
+       (!priorPair.second.scales.empty() && priorPair.second.scales.size() != priorPair.second.target.size()))
+      ALICEVISION_THROW_ERROR("Invalid prior size for the intrinsic " << priorPair.first << ".");
+
+    ceres::CostFunction* costFunction = new analytic::ParameterPriorCostFunction(priorPair.second.target, priorPair.second.weight, priorPair.second.scales);
+    _constraintsResidualBlocks.push_back(problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr));
+  }
+
+  for(const auto& priorPair : _parametersPriors.landmarks)
+  {
+    const auto landmarkBlockIt = _landmarksBlocks.find(priorPair.first);
+
+    // skip landmarks not refined by this update
+    if(landmarkBlockIt == _landmarksBlocks.end() || landmarkBlockIt->second.isConstant)
+      continue;
+
+    if(priorPair.second.target.size() != 3 || (!priorPair.second.scales.empty() && priorPair.second.scales.size() != 3))
+      ALICEVISION_THROW_ERROR("Invalid prior size for the landmark " << priorPair.first << ".");
+
+    ceres::CostFunction* costFunction = new analytic::ParameterPriorCostFunction(priorPair.second.target, priorPair.second.weight, priorPair.second.scales);
+    _constraintsResidualBlocks.push_back(problem.AddResidualBlock(costFunction, lossFunction, landmarkBlockIt->second.values.data()));
+  }
+}
+
+ceres::Problem& BundleAdjustmentCeres::updateProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+{
   // ensure we are not using incompatible options
   // REFINEINTRINSICS_OPTICALCENTER_ALWAYS and REFINEINTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
   assert(!((refineOptions & REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) && (refineOptions & REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA)));
 
-  // add SfM extrincics to the Ceres problem
-  addExtrinsicsToProblem(sfmData, refineOptions, problem);
+  // the residual blocks of the kept problem cannot change their loss function or cost function
+  if(_problem != nullptr &&
+     (_problemLossFunction != _ceresOptions.lossFunction ||
+      _problemUseAnalyticDerivatives != _ceresOptions.useAnalyticDerivatives))
+  {
+    resetProblem();
+  }
+
+  if(_problem == nullptr)
+  {
+    ceres::Problem::Options problemOptions;
+    problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    // residual and parameter blocks are removed between two adjustments
+    problemOptions.enable_fast_removal = true;
+    _problem.reset(new ceres::Problem(problemOptions));
+    _problemLossFunction = _ceresOptions.lossFunction;
+    _problemUseAnalyticDerivatives = _ceresOptions.useAnalyticDerivatives;
+  }
+
+  ceres::Problem& problem = *_problem;
 
-  // add SfM intrinsics to the Ceres problem
-  addIntrinsicsToProblem(sfmData, refineOptions, problem);
+  // clear previously computed data
+  ++_problemGeneration;
+  _statistics = Statistics();
+  _allParametersBlocks.clear();
+  _linearSolverOrdering.Clear();
+
+  try
+  {
+    // 2D constraints, rotation priors and parameters priors are recreated on each update
+    for(ceres::ResidualBlockId residualBlockId : _constraintsResidualBlocks)
+      problem.RemoveResidualBlock(residualBlockId);
+    _constraintsResidualBlocks.clear();
 
-  // add SfM landmarks to the Ceres problem
-  addLandmarksToProblem(sfmData, refineOptions, problem);
+    // add SfM extrincics to the Ceres problem
+    addExtrinsicsToProblem(sfmData, refineOptions, problem);
 
-  // add 2D constraints to the Ceres problem
-  addConstraints2DToProblem(sfmData, refineOptions, problem);
+    // add SfM intrinsics to the Ceres problem
+    addIntrinsicsToProblem(sfmData, refineOptions, problem);
 
-  // add rotation priors to the Ceres problem
-  addRotationPriorsToProblem(sfmData, refineOptions, problem);
+    // remove extrinsics and intrinsics no longer in the Ceres problem
+    removeUnusedParameterBlocks(problem);
+
+    // add SfM landmarks to the Ceres problem
+    addLandmarksToProblem(sfmData, refineOptions, problem);
+
+    // add 2D constraints to the Ceres problem
+    addConstraints2DToProblem(sfmData, refineOptions, problem);
+
+    // add rotation priors to the Ceres problem
+    addRotationPriorsToProblem(sfmData, refineOptions, problem);
+
+    // add parameters priors to the Ceres problem
+    addParametersPriorsToProblem(problem);
+  }
+  catch(...)
+  {
+    // the Ceres problem may be partially updated
+    resetProblem();
+    throw;
+  }
+
+  return problem;
 }
 
- void BundleAdjustmentCeres::resetProblem()
+void BundleAdjustmentCeres::resetProblem()
 {
   _statistics = Statistics();
 
+  _problem.reset();
+  _problemLossFunction.reset();
+  _aliveParametersBlocks.clear();
+  _parametersBlocksStates.clear();
+  _constraintsResidualBlocks.clear();
+
   _allParametersBlocks.clear();
   _posesBlocks.clear();
   _intrinsicsBlocks.clear();
@@ -711,6 +1011,134 @@ void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
   _linearSolverOrdering.Clear();
 }
 
+void BundleAdjustmentCeres::setupParameterBlock(double* blockPtr, const ParameterBlockSetup& setup, ceres::Problem& problem)
+{
+  ParameterBlockState& state = _parametersBlocksStates[blockPtr];
+  state.generation = _problemGeneration;
+
+  if(state.version != 0)
+  {
+    // the parameter values are updated in place
+    if(state.setup == setup)
+      return;
+
+    // a parameterization cannot be changed, the parameter block
+    // is removed (with its residual blocks) and created again
+    problem.RemoveParameterBlock(blockPtr);
+    _aliveParametersBlocks.at(state.version) = false;
+  }
+
+  problem.AddParameterBlock(blockPtr, setup.size);
+
+  if(setup.isConstant)
+  {
+    problem.SetParameterBlockConstant(blockPtr);
+  }
+  else
+  {
+    for(const auto& bound : setup.lowerBounds)
+      problem.SetParameterLowerBound(blockPtr, bound.first, bound.second);
+
+    for(const auto& bound : setup.upperBounds)
+      problem.SetParameterUpperBound(blockPtr, bound.first, bound.second);
+
+    // subset parametrization
+    if(!setup.constantParameters.empty())
+    {
+      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(setup.size, setup.constantParameters);
+      problem.SetParameterization(blockPtr, subsetParameterization);
+    }
+  }
+
+  // version 0 stands for no parameter block
+  if(_aliveParametersBlocks.empty())
+    _aliveParametersBlocks.push_back(false);
+
+  state.setup = setup;
+  state.version = _aliveParametersBlocks.size();
+  _aliveParametersBlocks.push_back(true);
+}
+
+void BundleAdjustmentCeres::removeParameterBlock(double* blockPtr, ceres::Problem& problem)
+{
+  const auto stateIt = _parametersBlocksStates.find(blockPtr);
+
+  if(stateIt == _parametersBlocksStates.end())
+    return;
+
+  problem.RemoveParameterBlock(blockPtr);
+  _aliveParametersBlocks.at(stateIt->second.version) = false;
+  _parametersBlocksStates.erase(stateIt);
+}
+
+void BundleAdjustmentCeres::removeUnusedParameterBlocks(ceres::Problem& problem)
+{
+  const auto isUnused = [&](double* blockPtr)
+  {
+    const auto stateIt = _parametersBlocksStates.find(blockPtr);
+    return (stateIt == _parametersBlocksStates.end() || stateIt->second.generation != _problemGeneration);
+  };
+
+  for(auto poseBlockIt = _posesBlocks.begin(); poseBlockIt != _posesBlocks.end();)
+  {
+    if(isUnused(poseBlockIt->second.data()))
+    {
+      removeParameterBlock(poseBlockIt->second.data(), problem);
+      poseBlockIt = _posesBlocks.erase(poseBlockIt);
+    }
+    else
+    {
+      ++poseBlockIt;
+    }
+  }
+
+  for(auto rigBlocksIt = _rigBlocks.begin(); rigBlocksIt != _rigBlocks.end();)
+  {
+    auto& subPosesBlocks = rigBlocksIt->second;
+
+    for(auto subPoseBlockIt = subPosesBlocks.begin(); subPoseBlockIt != subPosesBlocks.end();)
+    {
+      if(isUnused(subPoseBlockIt->second.data()))
+      {
+        removeParameterBlock(subPoseBlockIt->second.data(), problem);
+        subPoseBlockIt = subPosesBlocks.erase(subPoseBlockIt);
+      }
+      else
+      {
+        ++subPoseBlockIt;
+      }
+    }
+
+    if(subPosesBlocks.empty())
+      rigBlocksIt = _rigBlocks.erase(rigBlocksIt);
+    else
+      ++rigBlocksIt;
+  }
+
+  for(auto intrinsicBlockIt = _intrinsicsBlocks.begin(); intrinsicBlockIt != _intrinsicsBlocks.end();)
+  {
+    if(isUnused(intrinsicBlockIt->second.data()))
+    {
+      removeParameterBlock(intrinsicBlockIt->second.data(), problem);
+      intrinsicBlockIt = _intrinsicsBlocks.erase(intrinsicBlockIt);
+    }
+    else
+    {
+      ++intrinsicBlockIt;
+    }
+  }
+}
+
+bool BundleAdjustmentCeres::areParameterBlocksAlive(const std::array<std::size_t, 3>& versions) const
+{
+  for(const std::size_t version : versions)
+  {
+    if(version != 0 && !_aliveParametersBlocks.at(version))
+      return false;
+  }
+  return true;
+}
+
 void BundleAdjustmentCeres::updateFromSolution(sfmData::SfMData& sfmData, ERefineOptions refineOptions) const
 {
   const bool refinePoses = (refineOptions & REFINE_ROTATION) || (refineOptions & REFINE_TRANSLATION);
@@ -788,7 +1216,7 @@ void BundleAdjustmentCeres::updateFromSolution(sfmData::SfMData& sfmData, ERefin
         continue;
 
       for(std::size_t i = 0; i < 3; ++i)
-        landmark.X(Eigen::Index(i))= landmarksBlockPair.second.at(i);
+        landmark.X(Eigen::Index(i))= landmarksBlockPair.second.values.at(i);
     }
   }
 }
@@ -797,11 +1225,8 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
                                            ERefineOptions refineOptions,
                                            ceres::CRSMatrix& jacobian)
 {
-  // create problem
-  ceres::Problem::Options problemOptions;
-  problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-  ceres::Problem problem(problemOptions);
-  createProblem(sfmData, refineOptions, problem);
+  // create or update problem
+  ceres::Problem& problem = updateProblem(sfmData, refineOptions);
 
   // configure Jacobian engine
   double cost = 0.0;
@@ -816,11 +1241,10 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
 
 bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
 {
-  // create problem
-  ceres::Problem::Options problemOptions;
-  problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-  ceres::Problem problem(problemOptions);
-  createProblem(sfmData, refineOptions, problem);
+  // create or update problem
+  const system::Timer setupTimer;
+  ceres::Problem& problem = updateProblem(sfmData, refineOptions);
+  const double setupTime = setupTimer.elapsed();
 
   // configure a Bundle Adjustment engine and run it
   // make Ceres automatically detect the bundle structure.
@@ -848,6 +1272,7 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
 
   // store some statitics from the summary
   _statistics.time = summary.total_time_in_seconds;
+  _statistics.setupTime = setupTime;
   _statistics.nbSuccessfullIterations = summary.num_successful_steps;
   _statistics.nbUnsuccessfullIterations = summary.num_unsuccessful_steps;
   _statistics.nbResidualBlocks = summary.num_residuals;
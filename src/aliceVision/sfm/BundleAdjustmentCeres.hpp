@@ -11,11 +11,15 @@
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentGraph.hpp>
+#include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 
 #include <ceres/ceres.h>
 
+#include <array>
 #include <memory>
+#include <utility>
+#include <vector>
 
 
 namespace aliceVision {
@@ -26,6 +30,13 @@ class SfMData;
 
 namespace sfm {
 
+/**
+ * @brief Bundle adjustment based on Ceres.
+ *
+ * The Ceres problem is kept between two calls to adjust (or createJacobian) and only updated
+ * according to the changes of the SfMData: residual blocks of new observations are created,
+ * residual blocks of removed observations are removed and the unchanged ones are reused.
+ */
 class BundleAdjustmentCeres : public BundleAdjustment
 {
 public:
@@ -52,6 +63,9 @@ public:
     std::shared_ptr<ceres::LossFunction> lossFunction;
     unsigned int nbThreads;
     bool useParametersOrdering = true;
+    /// use the cost functions with analytic derivatives instead of the automatic differentiation
+    /// (opt-in, the automatic differentiation remains the reference)
+    bool useAnalyticDerivatives = false;
     bool summary = false;
     bool verbose = true;
   };
@@ -104,12 +118,39 @@ public:
     double RMSEfinal = 0.0;
     /// time spent to solve the BA (s)
     double time = 0.0;
+    /// time spent to create the BA problem (s)
+    double setupTime = 0.0;
     /// number of states per parameter
     std::map<EParameter, std::map<EParameterState, std::size_t>> parametersStates;
     /// The distribution of the cameras for each graph distance <distance, numOfCam>
     std::map<int, std::size_t> nbCamerasPerDistance;
   };
 
+  /**
+   * @brief Quadratic prior on a parameter block: 0.5 * weight^2 * sum((scale_i * (x_i - target_i))^2) is added to the cost.
+   */
+  struct ParameterPrior
+  {
+    /// prior value of the parameter block
+    std::vector<double> target;
+    /// prior weight
+    double weight = 0.0;
+    /// scale of each parameter of the block, to balance parameters of different units (empty: 1)
+    std::vector<double> scales;
+  };
+
+  /**
+   * @brief Priors on the intrinsics and landmarks parameter blocks.
+   *        Used to reconcile the parameters shared by several bundle adjustments (e.g. partitioned bundle adjustment).
+   */
+  struct ParametersPriors
+  {
+    /// priors per intrinsic id, target: intrinsic parameters
+    std::map<IndexT, ParameterPrior> intrinsics;
+    /// priors per landmark id, target: 3d position
+    std::map<IndexT, ParameterPrior> landmarks;
+  };
+
   /**
    * @brief Bundle adjustment constructor
    * @param[in] options The user Ceres options
@@ -119,6 +160,16 @@ public:
     : _ceresOptions(options)
   {}
 
+  /**
+   * @brief Change the Ceres options
+   * @note The Ceres problem is rebuilt on the next adjustment if the loss function or the derivatives type changes
+   * @param[in] options The user Ceres options
+   */
+  void setCeresOptions(const BundleAdjustmentCeres::CeresOptions& options)
+  {
+    _ceresOptions = options;
+  }
+
   /**
    * @brief Create a jacobian CRSMatrix
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction
@@ -147,6 +198,16 @@ public:
     _localGraph = localGraph;
   }
 
+  /**
+   * @brief Set the priors on the parameters used by the next adjustments.
+   *        Priors on parameters ignored or constant in an adjustment are not used.
+   * @param[in] priors The parameters priors
+   */
+  inline void setParametersPriors(const ParametersPriors& priors)
+  {
+    _parametersPriors = priors;
+  }
+
   /**
    * @brief Get bundle adjustment statistics structure
    * @return statistics structure const ptr
@@ -168,10 +229,110 @@ public:
 private:
 
   /**
-   * @brief Clear structures for a new problem
+   * @brief Setup of a parameter block in the Ceres problem.
+   *        A parameter block is recreated when its setup changes.
+   */
+  struct ParameterBlockSetup
+  {
+    /// number of parameters
+    std::size_t size = 0;
+    /// the whole parameter block is constant
+    bool isConstant = false;
+    /// indexes of the constant parameters (subset parameterization)
+    std::vector<int> constantParameters;
+    /// lower bounds <index, value>
+    std::vector<std::pair<int, double>> lowerBounds;
+    /// upper bounds <index, value>
+    std::vector<std::pair<int, double>> upperBounds;
+
+    bool operator==(const ParameterBlockSetup& other) const
+    {
+      return size == other.size &&
+             isConstant == other.isConstant &&
+             constantParameters == other.constantParameters &&
+             lowerBounds == other.lowerBounds &&
+             upperBounds == other.upperBounds;
+    }
+  };
+
+  /**
+   * @brief State of a pose, sub-pose or intrinsic parameter block in the Ceres problem.
+   */
+  struct ParameterBlockState
+  {
+    ParameterBlockSetup setup;
+    /// unique version of the parameter block, changes each time the block is (re)created
+    std::size_t version = 0;
+    /// last problem update using this parameter block
+    std::size_t generation = 0;
+  };
+
+  /**
+   * @brief Residual block of a landmark observation in the Ceres problem.
+   */
+  struct ObservationResidualBlock
+  {
+    /// observation view id
+    IndexT viewId;
+    /// camera model of the cost function
+    camera::EINTRINSIC intrinsicType;
+    /// versions of the intrinsic, pose and sub-pose parameter blocks (0 if not used)
+    std::array<std::size_t, 3> versions;
+    /// observation data used by the cost function
+    Vec2 x;
+    double scale;
+    /// Ceres residual block
+    ceres::ResidualBlockId residualBlockId;
+  };
+
+  /**
+   * @brief Landmark parameter block and its observations residual blocks in the Ceres problem.
+   */
+  struct LandmarkBlock
+  {
+    /// block: 3d position(3)
+    std::array<double,3> values;
+    /// the whole parameter block is constant
+    bool isConstant = false;
+    /// last problem update using this landmark
+    std::size_t generation = 0;
+    /// observations residual blocks, sorted by view id
+    std::vector<ObservationResidualBlock> residualBlocks;
+  };
+
+  /**
+   * @brief Clear the Ceres problem and all the structures
    */
   void resetProblem();
 
+  /**
+   * @brief Add a parameter block to the Ceres problem or update it if its setup has changed
+   * @param[in] blockPtr The parameter block
+   * @param[in] setup The parameter block setup
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void setupParameterBlock(double* blockPtr, const ParameterBlockSetup& setup, ceres::Problem& problem);
+
+  /**
+   * @brief Remove a pose, sub-pose or intrinsic parameter block and its residual blocks from the Ceres problem
+   * @param[in] blockPtr The parameter block
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void removeParameterBlock(double* blockPtr, ceres::Problem& problem);
+
+  /**
+   * @brief Remove the pose, sub-pose and intrinsic parameter blocks unused by the last problem update
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void removeUnusedParameterBlocks(ceres::Problem& problem);
+
+  /**
+   * @brief Return true if all the given parameter blocks versions are still in the Ceres problem
+   * @param[in] versions The parameter blocks versions (0 if not used)
+   * @return true if the parameter blocks versions are alive
+   */
+  bool areParameterBlocksAlive(const std::array<std::size_t, 3>& versions) const;
+
   /**
    * @brief Set user Ceres options to the solver
    * @param[in,out] solverOptions The solver options structure
@@ -179,7 +340,7 @@ private:
   void setSolverOptions(ceres::Solver::Options& solverOptions) const;
 
   /**
-   * @brief Create a parameter block for each extrinsics according to the Ceres format: [Rx, Ry, Rz, tx, ty, tz]
+   * @brief Create or update a parameter block for each extrinsics according to the Ceres format: [Rx, Ry, Rz, tx, ty, tz]
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction, notably the poses and sub-poses
    * @param[in] refineOptions The chosen refine flag
    * @param[out] problem The Ceres bundle adjustement problem
@@ -187,7 +348,7 @@ private:
   void addExtrinsicsToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
   /**
-   * @brief Create a parameter block for each intrinsic according to the Ceres format
+   * @brief Create or update a parameter block for each intrinsic according to the Ceres format
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction, notably the intrinsics
    * @param[in] refineOptions The chosen refine flag
    * @param[out] problem The Ceres bundle adjustement problem
@@ -195,7 +356,8 @@ private:
   void addIntrinsicsToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
   /**
-   * @brief Create a residual block for each landmarks according to the Ceres format
+   * @brief Create or update a parameter block for each landmark and a residual block for each of its observations.
+   *        Residual blocks of unchanged observations are kept, new ones are built in parallel.
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction, notably the intrinsics
    * @param[in] refineOptions The chosen refine flag
    * @param[out] problem The Ceres bundle adjustement problem
@@ -219,14 +381,20 @@ private:
   void addRotationPriorsToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
   /**
-   * @brief Create the Ceres bundle adjustement problem with:
+   * @brief Create a residual block for each parameter prior
+   * @param[out] problem The Ceres bundle adjustement problem
+   */
+  void addParametersPriorsToProblem(ceres::Problem& problem);
+
+  /**
+   * @brief Create or update the persistent Ceres bundle adjustement problem with:
    *  - extrincics and intrinsics parameters blocks.
    *  - residuals blocks for each observation.
-   * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
    * @param[in] refineOptions The chosen refine flag
-   * @param[out] problem The Ceres bundle adjustement problem
+   * @return the Ceres bundle adjustement problem
    */
-  void createProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
+  ceres::Problem& updateProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions);
 
   /**
    * @brief Update The given SfMData with the solver solution
@@ -281,6 +449,22 @@ private:
 
   // data wrappers for refinement
 
+  /// Ceres problem, kept between two adjustments
+  std::unique_ptr<ceres::Problem> _problem;
+  /// loss function of the residual blocks of the Ceres problem (not owned by the problem)
+  std::shared_ptr<ceres::LossFunction> _problemLossFunction;
+  /// derivatives type of the cost functions of the Ceres problem
+  bool _problemUseAnalyticDerivatives = true;
+  /// number of problem updates
+  std::size_t _problemGeneration = 0;
+  /// alive state of each pose, sub-pose and intrinsic parameter block version
+  std::vector<bool> _aliveParametersBlocks;
+  /// state of each pose, sub-pose and intrinsic parameter block
+  std::map<double*, ParameterBlockState> _parametersBlocksStates;
+  /// priors on the parameters
+  ParametersPriors _parametersPriors;
+  /// residual blocks of the 2D constraints, rotation priors and parameters priors, recreated on each update
+  std::vector<ceres::ResidualBlockId> _constraintsResidualBlocks;
   /// all parameters blocks pointers
   std::vector<double*> _allParametersBlocks;
   /// poses blocks wrapper
@@ -290,8 +474,7 @@ private:
   /// block: intrinsics params
   HashMap<IndexT, std::vector<double>> _intrinsicsBlocks;
   /// landmarks blocks wrapper
-  /// block: 3d position(3)
-  HashMap<IndexT, std::array<double,3>> _landmarksBlocks;
+  HashMap<IndexT, LandmarkBlock> _landmarksBlocks;
   /// rig sub-poses blocks wrapper
   /// block: ceres angleAxis(3) + translation(3)
   HashMap<IndexT, HashMap<IndexT, std::array<double,6>>> _rigBlocks;
@@ -0,0 +1,1145 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BundleAdjustmentPartitioned.hpp"
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/camera/IntrinsicsScaleOffset.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/process.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+/// number of following poses of a track connected to each pose in the covisibility graph
+const std::size_t covisibilityWindow = 8;
+
+/**
+ * @brief Parameter shared by several submaps.
+ */
+struct SharedParameter
+{
+  /// consensus value
+  std::vector<double> value;
+  /// submaps using the parameter
+  std::vector<std::size_t> submaps;
+  /// scaled dual variables, one per submap
+  std::vector<std::vector<double>> duals;
+  /// scale of each value, balancing values of different units (empty: 1)
+  std::vector<double> scales;
+};
+
+using SharedParameters = std::map<IndexT, SharedParameter>;
+
+/**
+ * @brief Residuals of the consensus update of a group of shared parameters.
+ */
+struct ConsensusResiduals
+{
+  /// squared primal residual: sum of the squared differences between the submaps values and the consensus
+  double primal2 = 0.0;
+  /// squared consensus change (the dual residual is penalty * sqrt(dual2))
+  double dual2 = 0.0;
+  /// squared norm of the submaps values
+  double localNorm2 = 0.0;
+  /// squared norm of the consensus values (one per submap value)
+  double consensusNorm2 = 0.0;
+  /// squared norm of the scaled dual variables
+  double dualNorm2 = 0.0;
+  /// number of submaps values
+  std::size_t nbValues = 0;
+
+  /**
+   * @brief Stopping criterion of the consensus iterations
+   * @param[in] penalty The consensus penalty
+   * @param[in] absoluteTolerance The absolute tolerance
+   * @param[in] relativeTolerance The relative tolerance
+   * @return true if the primal and dual residuals are small enough
+   */
+  bool isConverged(double penalty, double absoluteTolerance, double relativeTolerance) const
+  {
+    const double sqrtNbValues = std::sqrt(static_cast<double>(nbValues));
+    const double primalTolerance = sqrtNbValues * absoluteTolerance + relativeTolerance * std::sqrt(std::max(localNorm2, consensusNorm2));
+    const double dualTolerance = sqrtNbValues * absoluteTolerance + relativeTolerance * penalty * std::sqrt(dualNorm2);
+    return (std::sqrt(primal2) <= primalTolerance) && (penalty * std::sqrt(dual2) <= dualTolerance);
+  }
+};
+
+/**
+ * @brief Values of the shared parameters adjusted in a submap.
+ */
+struct SubmapSharedValues
+{
+  std::map<IndexT, std::vector<double>> landmarks;
+  std::map<IndexT, std::vector<double>> intrinsics;
+};
+
+/**
+ * @brief Get the submap of each reconstructed view
+ * @param[in] sfmData The input SfMData
+ * @param[in] partition The pose ids of each submap
+ * @return the submap index of each view in a submap
+ */
+std::map<IndexT, std::size_t> getViewsSubmaps(const sfmData::SfMData& sfmData, const std::vector<std::set<IndexT>>& partition)
+{
+  std::map<IndexT, std::size_t> poseSubmap;
+  for(std::size_t i = 0; i < partition.size(); ++i)
+    for(const IndexT poseId : partition.at(i))
+      poseSubmap[poseId] = i;
+
+  std::map<IndexT, std::size_t> viewSubmap;
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const sfmData::View& view = *viewPair.second;
+
+    if(!sfmData.isPoseAndIntrinsicDefined(&view))
+      continue;
+
+    const auto poseSubmapIt = poseSubmap.find(view.getPoseId());
+    if(poseSubmapIt != poseSubmap.end())
+      viewSubmap[view.getViewId()] = poseSubmapIt->second;
+  }
+
+  return viewSubmap;
+}
+
+/**
+ * @brief Find the landmarks and intrinsics used by several submaps
+ * @param[in] sfmData The input SfMData
+ * @param[in] partition The pose ids of each submap
+ * @param[out] landmarksSubmaps The submaps of each landmark used by several submaps
+ * @param[out] intrinsicsSubmaps The submaps of each intrinsic used by several submaps
+ */
+void findSharedParameters(const sfmData::SfMData& sfmData,
+                          const std::vector<std::set<IndexT>>& partition,
+                          std::map<IndexT, std::vector<std::size_t>>& landmarksSubmaps,
+                          std::map<IndexT, std::vector<std::size_t>>& intrinsicsSubmaps)
+{
+  landmarksSubmaps.clear();
+  intrinsicsSubmaps.clear();
+
+  const std::map<IndexT, std::size_t> viewSubmap = getViewsSubmaps(sfmData, partition);
+
+  for(const auto& viewSubmapPair : viewSubmap)
+    intrinsicsSubmaps[sfmData.getView(viewSubmapPair.first).getIntrinsicId()].push_back(viewSubmapPair.second);
+
+  for(auto it = intrinsicsSubmaps.begin(); it != intrinsicsSubmaps.end();)
+  {
+    std::vector<std::size_t>& submaps = it->second;
+    std::sort(submaps.begin(), submaps.end());
+    submaps.erase(std::unique(submaps.begin(), submaps.end()), submaps.end());
+
+    // remove the intrinsics used by a single submap
+    if(submaps.size() < 2)
+      it = intrinsicsSubmaps.erase(it);
+    else
+      ++it;
+  }
+
+  std::vector<std::size_t> observationsSubmaps;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    observationsSubmaps.clear();
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto viewSubmapIt = viewSubmap.find(observationPair.first);
+      if(viewSubmapIt != viewSubmap.end())
+        observationsSubmaps.push_back(viewSubmapIt->second);
+    }
+
+    std::sort(observationsSubmaps.begin(), observationsSubmaps.end());
+    observationsSubmaps.erase(std::unique(observationsSubmaps.begin(), observationsSubmaps.end()), observationsSubmaps.end());
+
+    if(observationsSubmaps.size() > 1)
+      landmarksSubmaps[landmarkPair.first] = observationsSubmaps;
+  }
+}
+
+/**
+ * @brief Create the submaps of a range of groups of poses.
+ *        A landmark belongs to each submap observing it, with the observations of the submap views.
+ * @param[in] sfmData The input SfMData
+ * @param[in] partition The pose ids of each submap
+ * @param[in] submapsBegin The first submap to create
+ * @param[in] submapsEnd The end of the range of submaps to create
+ * @param[out] submaps The submaps of the range
+ */
+void createSubmaps(const sfmData::SfMData& sfmData,
+                   const std::vector<std::set<IndexT>>& partition,
+                   std::size_t submapsBegin,
+                   std::size_t submapsEnd,
+                   std::vector<sfmData::SfMData>& submaps)
+{
+  submaps.clear();
+  submaps.resize(submapsEnd - submapsBegin);
+
+  // submap index in the range of each view of the range
+  std::map<IndexT, std::size_t> viewSubmap = getViewsSubmaps(sfmData, partition);
+
+  for(auto it = viewSubmap.begin(); it != viewSubmap.end();)
+  {
+    if(it->second < submapsBegin || it->second >= submapsEnd)
+    {
+      it = viewSubmap.erase(it);
+      continue;
+    }
+
+    it->second -= submapsBegin;
+    ++it;
+  }
+
+  // views, poses, rigs and intrinsics
+  for(const auto& viewSubmapPair : viewSubmap)
+  {
+    const sfmData::View& view = sfmData.getView(viewSubmapPair.first);
+    sfmData::SfMData& submap = submaps.at(viewSubmapPair.second);
+
+    submap.views[view.getViewId()] = std::make_shared<sfmData::View>(view);
+
+    if(submap.getPoses().count(view.getPoseId()) == 0)
+      submap.getPoses()[view.getPoseId()] = sfmData.getPoses().at(view.getPoseId());
+
+    if(view.isPartOfRig() && submap.getRigs().count(view.getRigId()) == 0)
+    {
+      sfmData::Rig rig = sfmData.getRigs().at(view.getRigId());
+
+      // the rig sub-poses are shared by all the submaps and are not reconciled
+      for(std::size_t subPoseId = 0; subPoseId < rig.getNbSubPoses(); ++subPoseId)
+      {
+        sfmData::RigSubPose& subPose = rig.getSubPose(subPoseId);
+        if(subPose.status != sfmData::ERigSubPoseStatus::UNINITIALIZED)
+          subPose.status = sfmData::ERigSubPoseStatus::CONSTANT;
+      }
+
+      submap.getRigs()[view.getRigId()] = rig;
+    }
+
+    if(submap.getIntrinsics().count(view.getIntrinsicId()) == 0)
+      submap.getIntrinsics()[view.getIntrinsicId()].reset(sfmData.getIntrinsics().at(view.getIntrinsicId())->clone());
+  }
+
+  // landmarks, with the observations of each submap
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    for(const auto& observationPair : landmark.observations)
+    {
+      const auto viewSubmapIt = viewSubmap.find(observationPair.first);
+      if(viewSubmapIt == viewSubmap.end())
+        continue;
+
+      sfmData::Landmarks& submapLandmarks = submaps.at(viewSubmapIt->second).getLandmarks();
+      auto submapLandmarkIt = submapLandmarks.find(landmarkPair.first);
+
+      if(submapLandmarkIt == submapLandmarks.end())
+      {
+        sfmData::Landmark& submapLandmark = submapLandmarks[landmarkPair.first];
+        submapLandmark.X = landmark.X;
+        submapLandmark.descType = landmark.descType;
+        submapLandmark.rgb = landmark.rgb;
+        submapLandmarkIt = submapLandmarks.find(landmarkPair.first);
+      }
+
+      submapLandmarkIt->second.observations.emplace_hint(submapLandmarkIt->second.observations.end(), observationPair);
+    }
+  }
+
+  // constraints between two views of the same submap
+  for(const auto& constraint : sfmData.getConstraints2D())
+  {
+    const auto firstIt = viewSubmap.find(constraint.ViewFirst);
+    const auto secondIt = viewSubmap.find(constraint.ViewSecond);
+    if(firstIt != viewSubmap.end() && secondIt != viewSubmap.end() && firstIt->second == secondIt->second)
+      submaps.at(firstIt->second).getConstraints2D().push_back(constraint);
+  }
+
+  for(const auto& prior : sfmData.getRotationPriors())
+  {
+    const auto firstIt = viewSubmap.find(prior.ViewFirst);
+    const auto secondIt = viewSubmap.find(prior.ViewSecond);
+    if(firstIt != viewSubmap.end() && secondIt != viewSubmap.end() && firstIt->second == secondIt->second)
+      submaps.at(firstIt->second).getRotationPriors().push_back(prior);
+  }
+}
+
+/**
+ * @brief Estimate the landmarks consensus penalty giving to a landmark displacement
+ *        the weight of the corresponding reprojection error (median focal / median depth)^2.
+ * @param[in] sfmData The input SfMData
+ * @param[in] landmarksSubmaps The landmarks shared by several submaps
+ * @return the landmarks penalty
+ */
+double estimateLandmarksPenalty(const sfmData::SfMData& sfmData, const std::map<IndexT, std::vector<std::size_t>>& landmarksSubmaps)
+{
+  const std::size_t maxNbSamples = 10000;
+  const std::size_t step = std::max<std::size_t>(1, landmarksSubmaps.size() / maxNbSamples);
+
+  std::vector<double> focals;
+  std::vector<double> depths;
+  std::size_t index = 0;
+
+  for(const auto& landmarkPair : landmarksSubmaps)
+  {
+    if(index++ % step != 0)
+      continue;
+
+    const sfmData::Landmark& landmark = sfmData.getLandmarks().at(landmarkPair.first);
+
+    for(const auto& observationPair : landmark.observations)
+    {
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      if(!sfmData.isPoseAndIntrinsicDefined(&view))
+        continue;
+
+      const camera::IntrinsicsScaleOffset* intrinsic = dynamic_cast<const camera::IntrinsicsScaleOffset*>(sfmData.getIntrinsicPtr(view.getIntrinsicId()));
+      const double depth = sfmData.getPose(view).getTransform().depth(landmark.X);
+
+      if(intrinsic != nullptr && depth > 0.0)
+      {
+        focals.push_back(intrinsic->getScale()(0));
+        depths.push_back(depth);
+      }
+    }
+  }
+
+  if(focals.empty())
+    return 1.0;
+
+  std::nth_element(focals.begin(), focals.begin() + focals.size() / 2, focals.end());
+  std::nth_element(depths.begin(), depths.begin() + depths.size() / 2, depths.end());
+
+  const double ratio = focals.at(focals.size() / 2) / depths.at(depths.size() / 2);
+  return ratio * ratio;
+}
+
+/**
+ * @brief Estimate the scale of each parameter of the shared intrinsics: the square root of the
+ *        reprojection error curvature of a submap along the parameter, the average number of observations
+ *        of the intrinsic per submap times the mean squared projection derivative (finite differences).
+ *        The intrinsics penalty is thus relative to the submaps data, whatever the parameters units.
+ * @param[in] sfmData The input SfMData
+ * @param[in,out] sharedIntrinsics The intrinsics shared by several submaps
+ */
+void estimateIntrinsicsScales(const sfmData::SfMData& sfmData, SharedParameters& sharedIntrinsics)
+{
+  // one observation out of samplingStep is sampled, up to maxNbSamples per intrinsic
+  const std::size_t samplingStep = 8;
+  const std::size_t maxNbSamples = 1000;
+
+  // observations of each shared intrinsic: <pose, landmark position>
+  std::map<IndexT, std::vector<std::pair<const geometry::Pose3*, const Vec3*>>> samples;
+  std::map<IndexT, std::size_t> nbObservations;
+  std::map<IndexT, geometry::Pose3> poses;
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const sfmData::View& view = *viewPair.second;
+    if(sharedIntrinsics.count(view.getIntrinsicId()) != 0 && sfmData.isPoseAndIntrinsicDefined(&view))
+      poses[view.getViewId()] = sfmData.getPose(view).getTransform();
+  }
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto poseIt = poses.find(observationPair.first);
+      if(poseIt == poses.end())
+        continue;
+
+      const IndexT intrinsicId = sfmData.getView(observationPair.first).getIntrinsicId();
+      std::vector<std::pair<const geometry::Pose3*, const Vec3*>>& intrinsicSamples = samples[intrinsicId];
+
+      if(nbObservations[intrinsicId]++ % samplingStep == 0 && intrinsicSamples.size() < maxNbSamples)
+        intrinsicSamples.emplace_back(&poseIt->second, &landmarkPair.second.X);
+    }
+  }
+
+  for(auto& sharedPair : sharedIntrinsics)
+  {
+    SharedParameter& shared = sharedPair.second;
+    const auto samplesIt = samples.find(sharedPair.first);
+
+    if(samplesIt == samples.end() || samplesIt->second.empty())
+      continue;
+
+    const std::vector<std::pair<const geometry::Pose3*, const Vec3*>>& intrinsicSamples = samplesIt->second;
+    const std::unique_ptr<camera::IntrinsicBase> intrinsic(sfmData.getIntrinsics().at(sharedPair.first)->clone());
+    const std::vector<double> params = intrinsic->getParams();
+    const double nbObservationsPerSubmap = static_cast<double>(nbObservations.at(sharedPair.first)) / shared.submaps.size();
+
+    shared.scales.assign(params.size(), 1.0);
+
+    for(std::size_t j = 0; j < params.size(); ++j)
+    {
+      const double step = 1e-6 * std::max(1.0, std::abs(params.at(j)));
+      std::vector<double> paramsPlus = params;
+      std::vector<double> paramsMinus = params;
+      paramsPlus.at(j) += step;
+      paramsMinus.at(j) -= step;
+
+      double squaredDerivative = 0.0;
+      for(const auto& sample : intrinsicSamples)
+      {
+        intrinsic->updateFromParams(paramsPlus);
+        const Vec2 projectionPlus = intrinsic->project(*sample.first, *sample.second);
+        intrinsic->updateFromParams(paramsMinus);
+        const Vec2 projectionMinus = intrinsic->project(*sample.first, *sample.second);
+        squaredDerivative += ((projectionPlus - projectionMinus) / (2.0 * step)).squaredNorm();
+      }
+
+      // parameters without effect on the projection (e.g. tied to another one) keep a unit scale
+      if(squaredDerivative > 0.0)
+        shared.scales.at(j) = std::sqrt(nbObservationsPerSubmap * squaredDerivative / intrinsicSamples.size());
+    }
+  }
+}
+
+/**
+ * @brief Set the priors pulling each submap value of the shared parameters toward the consensus
+ * @param[in] sharedParameters The shared parameters
+ * @param[in] penalty The consensus penalty
+ * @param[out] priors The priors of each submap (intrinsics or landmarks)
+ */
+void setConsensusPriors(const SharedParameters& sharedParameters,
+                        double penalty,
+                        std::vector<std::map<IndexT, BundleAdjustmentCeres::ParameterPrior>*>& priors)
+{
+  const double weight = std::sqrt(penalty);
+
+  for(const auto& sharedPair : sharedParameters)
+  {
+    const SharedParameter& shared = sharedPair.second;
+
+    for(std::size_t i = 0; i < shared.submaps.size(); ++i)
+    {
+      BundleAdjustmentCeres::ParameterPrior& prior = (*priors.at(shared.submaps.at(i)))[sharedPair.first];
+      prior.weight = weight;
+      prior.scales = shared.scales;
+      prior.target.resize(shared.value.size());
+
+      for(std::size_t j = 0; j < shared.value.size(); ++j)
+        prior.target.at(j) = shared.value.at(j) - shared.duals.at(i).at(j);
+    }
+  }
+}
+
+/**
+ * @brief Consensus update of a group of shared parameters:
+ *        z = mean(x + u), then u = u + x - z.
+ * @param[in,out] sharedParameters The shared parameters
+ * @param[in] getValue Function returning the value of a parameter in a submap
+ * @return the consensus residuals
+ */
+template <typename GetValueFunction>
+ConsensusResiduals updateConsensus(SharedParameters& sharedParameters, const GetValueFunction& getValue)
+{
+  ConsensusResiduals residuals;
+  std::vector<std::vector<double>> values;
+
+  for(auto& sharedPair : sharedParameters)
+  {
+    SharedParameter& shared = sharedPair.second;
+    const std::size_t size = shared.value.size();
+    const std::size_t nbSubmaps = shared.submaps.size();
+
+    values.resize(nbSubmaps);
+    for(std::size_t i = 0; i < nbSubmaps; ++i)
+      values.at(i) = getValue(sharedPair.first, shared.submaps.at(i));
+
+    for(std::size_t j = 0; j < size; ++j)
+    {
+      // the residuals are measured in scaled units
+      const double scale2 = shared.scales.empty() ? 1.0 : shared.scales.at(j) * shared.scales.at(j);
+
+      double mean = 0.0;
+      for(std::size_t i = 0; i < nbSubmaps; ++i)
+        mean += values.at(i).at(j) + shared.duals.at(i).at(j);
+      mean /= static_cast<double>(nbSubmaps);
+
+      const double change = mean - shared.value.at(j);
+      shared.value.at(j) = mean;
+
+      residuals.dual2 += scale2 * nbSubmaps * change * change;
+      residuals.consensusNorm2 += scale2 * nbSubmaps * mean * mean;
+
+      for(std::size_t i = 0; i < nbSubmaps; ++i)
+      {
+        const double x = values.at(i).at(j);
+        double& u = shared.duals.at(i).at(j);
+
+        u += x - mean;
+
+        residuals.primal2 += scale2 * (x - mean) * (x - mean);
+        residuals.localNorm2 += scale2 * x * x;
+        residuals.dualNorm2 += scale2 * u * u;
+      }
+    }
+
+    residuals.nbValues += nbSubmaps * size;
+  }
+
+  return residuals;
+}
+
+/**
+ * @brief Residual balancing: increase the penalty if the primal residual is much larger
+ *        than the dual residual, decrease it in the opposite case.
+ *        The dual residual is measured as the consensus change (without the penalty factor),
+ *        so that both residuals are in the parameters units and the balance does not depend
+ *        on the scale of the penalty (a landmarks penalty is in pixels^2 per scene unit^2).
+ *        The scaled dual variables are rescaled accordingly.
+ * @param[in] residuals The last consensus residuals
+ * @param[in,out] sharedParameters The shared parameters
+ * @param[in,out] penalty The consensus penalty
+ */
+void adaptPenalty(const ConsensusResiduals& residuals, SharedParameters& sharedParameters, double& penalty)
+{
+  const double balance = 10.0;
+  const double factor = 2.0;
+
+  const double primalResidual = std::sqrt(residuals.primal2);
+  const double dualResidual = std::sqrt(residuals.dual2);
+
+  double scale = 1.0;
+
+  if(primalResidual > balance * dualResidual)
+    scale = factor;
+  else if(dualResidual > balance * primalResidual)
+    scale = 1.0 / factor;
+  else
+    return;
+
+  penalty *= scale;
+
+  for(auto& sharedPair : sharedParameters)
+    for(std::vector<double>& dual : sharedPair.second.duals)
+      for(double& u : dual)
+        u /= scale;
+}
+
+/**
+ * @brief Copy the parameters owned by an adjusted submap to the scene,
+ *        and keep its values of the shared parameters for the consensus update
+ * @param[in] submap The adjusted submap
+ * @param[in] sharedLandmarks The landmarks shared by several submaps
+ * @param[in] sharedIntrinsics The intrinsics shared by several submaps
+ * @param[out] sharedValues The submap values of the shared parameters
+ * @param[in,out] sfmData The scene
+ */
+void updateSceneFromSubmap(const sfmData::SfMData& submap,
+                           const SharedParameters& sharedLandmarks,
+                           const SharedParameters& sharedIntrinsics,
+                           SubmapSharedValues& sharedValues,
+                           sfmData::SfMData& sfmData)
+{
+  for(const auto& posePair : submap.getPoses())
+    sfmData.getPoses().at(posePair.first) = posePair.second;
+
+  for(const auto& landmarkPair : submap.getLandmarks())
+  {
+    const Vec3& X = landmarkPair.second.X;
+
+    if(sharedLandmarks.count(landmarkPair.first) == 0)
+      sfmData.getLandmarks().at(landmarkPair.first).X = X;
+    else
+      sharedValues.landmarks[landmarkPair.first].assign(X.data(), X.data() + 3);
+  }
+
+  for(const auto& intrinsicPair : submap.getIntrinsics())
+  {
+    if(sharedIntrinsics.count(intrinsicPair.first) == 0)
+      sfmData.getIntrinsics().at(intrinsicPair.first)->updateFromParams(intrinsicPair.second->getParams());
+    else
+      sharedValues.intrinsics[intrinsicPair.first] = intrinsicPair.second->getParams();
+  }
+}
+
+/**
+ * @brief Copy the consensus values of the shared parameters to the scene
+ * @param[in] sharedLandmarks The landmarks shared by several submaps
+ * @param[in] sharedIntrinsics The intrinsics shared by several submaps
+ * @param[in,out] sfmData The scene
+ */
+void updateSceneConsensus(const SharedParameters& sharedLandmarks,
+                          const SharedParameters& sharedIntrinsics,
+                          sfmData::SfMData& sfmData)
+{
+  for(const auto& sharedPair : sharedLandmarks)
+    sfmData.getLandmarks().at(sharedPair.first).X = Eigen::Map<const Vec3>(sharedPair.second.value.data());
+
+  for(const auto& sharedPair : sharedIntrinsics)
+    sfmData.getIntrinsics().at(sharedPair.first)->updateFromParams(sharedPair.second.value);
+}
+
+/**
+ * @brief Compute the Root Mean Square Error of the residuals of the reconstructed views
+ * @param[in] sfmData The given input SfMData
+ * @return RMSE value
+ */
+double computeRMSE(const sfmData::SfMData& sfmData)
+{
+  double squaredError = 0.0;
+  std::size_t nbResiduals = 0;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto viewIt = sfmData.getViews().find(observationPair.first);
+      if(viewIt == sfmData.getViews().end() || !sfmData.isPoseAndIntrinsicDefined(viewIt->second.get()))
+        continue;
+
+      const sfmData::View& view = *viewIt->second;
+      const Vec2 residual = sfmData.getIntrinsics().at(view.getIntrinsicId())->residual(sfmData.getPose(view).getTransform(), landmarkPair.second.X, observationPair.second.x);
+      squaredError += residual.squaredNorm();
+      nbResiduals += 2;
+    }
+  }
+
+  return (nbResiduals > 0) ? std::sqrt(squaredError / nbResiduals) : 0.0;
+}
+
+} // namespace
+
+void BundleAdjustmentPartitioned::Statistics::show() const
+{
+  std::stringstream ss;
+  ss << "Partitioned bundle adjustment statistics:" << std::endl
+     << "\t- # submaps:              " << nbSubmaps << std::endl
+     << "\t- # shared landmarks:     " << nbSharedLandmarks << std::endl
+     << "\t- # shared intrinsics:    " << nbSharedIntrinsics << std::endl
+     << "\t- # iterations:           " << iterations.size() << (converged ? " (converged)" : "") << std::endl
+     << "\t- RMSE initial:           " << RMSEinitial << std::endl;
+
+  if(!iterations.empty())
+    ss << "\t- RMSE final:             " << iterations.back().RMSE << std::endl
+       << "\t- primal residual:        " << iterations.back().primalResidual << std::endl
+       << "\t- dual residual:          " << iterations.back().dualResidual << std::endl;
+
+  ss << "\t- time (s):               " << time;
+
+  ALICEVISION_LOG_INFO(ss.str());
+}
+
+std::vector<std::set<IndexT>> BundleAdjustmentPartitioned::partitionPoses(const sfmData::SfMData& sfmData, std::size_t maxNbPosesPerSubmap)
+{
+  // pose covisibility graph: <pose id, <neighbor pose id, number of shared landmarks>>
+  std::map<IndexT, std::map<IndexT, std::size_t>> covisibility;
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    if(sfmData.isPoseAndIntrinsicDefined(viewPair.second.get()))
+      covisibility[viewPair.second->getPoseId()];
+  }
+
+  std::vector<IndexT> trackPoses;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    trackPoses.clear();
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto viewIt = sfmData.getViews().find(observationPair.first);
+      if(viewIt != sfmData.getViews().end() && sfmData.isPoseAndIntrinsicDefined(viewIt->second.get()))
+        trackPoses.push_back(viewIt->second->getPoseId());
+    }
+
+    std::sort(trackPoses.begin(), trackPoses.end());
+    trackPoses.erase(std::unique(trackPoses.begin(), trackPoses.end()), trackPoses.end());
+
+    // long tracks only connect each pose to a window of the following poses
+    for(std::size_t i = 0; i < trackPoses.size(); ++i)
+    {
+      const std::size_t end = std::min(trackPoses.size(), i + 1 + covisibilityWindow);
+      for(std::size_t j = i + 1; j < end; ++j)
+      {
+        ++covisibility[trackPoses.at(i)][trackPoses.at(j)];
+        ++covisibility[trackPoses.at(j)][trackPoses.at(i)];
+      }
+    }
+  }
+
+  std::vector<std::set<IndexT>> partition;
+  std::set<IndexT> unassignedPoses;
+
+  for(const auto& posePair : covisibility)
+    unassignedPoses.insert(posePair.first);
+
+  while(!unassignedPoses.empty())
+  {
+    // seed: the pose with the fewest neighbors, on the border of the remaining graph
+    IndexT seed = UndefinedIndexT;
+    std::size_t minNbNeighbors = std::numeric_limits<std::size_t>::max();
+
+    for(const IndexT poseId : unassignedPoses)
+    {
+      const std::size_t nbNeighbors = covisibility.at(poseId).size();
+      if(nbNeighbors < minNbNeighbors)
+      {
+        minNbNeighbors = nbNeighbors;
+        seed = poseId;
+      }
+    }
+
+    // grow the group along the poses sharing the largest number of landmarks with it
+    std::set<IndexT> group;
+    std::map<IndexT, std::size_t> frontierWeights;
+    std::set<std::pair<std::size_t, IndexT>> frontier;
+    IndexT poseId = seed;
+
+    while(true)
+    {
+      group.insert(poseId);
+      unassignedPoses.erase(poseId);
+
+      if(group.size() >= maxNbPosesPerSubmap)
+        break;
+
+      for(const auto& neighborPair : covisibility.at(poseId))
+      {
+        if(unassignedPoses.count(neighborPair.first) == 0)
+          continue;
+
+        std::size_t& weight = frontierWeights[neighborPair.first];
+        frontier.erase(std::make_pair(weight, neighborPair.first));
+        weight += neighborPair.second;
+        frontier.insert(std::make_pair(weight, neighborPair.first));
+      }
+
+      if(frontier.empty())
+        break;
+
+      const auto bestIt = std::prev(frontier.end());
+      poseId = bestIt->second;
+      frontier.erase(bestIt);
+      frontierWeights.erase(poseId);
+    }
+
+    partition.push_back(std::move(group));
+  }
+
+  return partition;
+}
+
+bool BundleAdjustmentPartitioned::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+{
+  const system::Timer timer;
+
+  _statistics = Statistics();
+  _submapsBA.clear();
+
+  const std::vector<std::set<IndexT>> partition = partitionPoses(sfmData, _options.maxNbPosesPerSubmap);
+  _statistics.nbSubmaps = partition.size();
+
+  if(partition.size() <= 1)
+  {
+    // the scene fits in a single submap
+    BundleAdjustmentCeres BA(_options.ceresOptions);
+    const bool success = BA.adjust(sfmData, refineOptions);
+
+    _statistics.converged = success;
+    _statistics.RMSEinitial = BA.getStatistics().RMSEinitial;
+    _statistics.time = timer.elapsed();
+    return success;
+  }
+
+  std::map<IndexT, std::vector<std::size_t>> landmarksSubmaps;
+  std::map<IndexT, std::vector<std::size_t>> intrinsicsSubmaps;
+
+  findSharedParameters(sfmData, partition, landmarksSubmaps, intrinsicsSubmaps);
+
+  double landmarksPenalty = (_options.landmarksPenalty > 0.0) ? _options.landmarksPenalty : estimateLandmarksPenalty(sfmData, landmarksSubmaps);
+  double intrinsicsPenalty = _options.intrinsicsPenalty;
+
+  // consensus values, initialized with the input scene
+  SharedParameters sharedLandmarks;
+  SharedParameters sharedIntrinsics;
+
+  for(auto& landmarkPair : landmarksSubmaps)
+  {
+    SharedParameter& shared = sharedLandmarks[landmarkPair.first];
+    const Vec3& X = sfmData.getLandmarks().at(landmarkPair.first).X;
+    shared.value.assign(X.data(), X.data() + 3);
+    shared.submaps = std::move(landmarkPair.second);
+    shared.duals.assign(shared.submaps.size(), std::vector<double>(3, 0.0));
+  }
+
+  for(auto& intrinsicPair : intrinsicsSubmaps)
+  {
+    SharedParameter& shared = sharedIntrinsics[intrinsicPair.first];
+    shared.value = sfmData.getIntrinsics().at(intrinsicPair.first)->getParams();
+    shared.submaps = std::move(intrinsicPair.second);
+    shared.duals.assign(shared.submaps.size(), std::vector<double>(shared.value.size(), 0.0));
+  }
+
+  estimateIntrinsicsScales(sfmData, sharedIntrinsics);
+
+  _statistics.nbSharedLandmarks = sharedLandmarks.size();
+  _statistics.nbSharedIntrinsics = sharedIntrinsics.size();
+  _statistics.RMSEinitial = computeRMSE(sfmData);
+
+  ALICEVISION_LOG_INFO("Partitioned bundle adjustment: " << partition.size() << " submaps, "
+                       << sharedLandmarks.size() << " shared landmarks, "
+                       << sharedIntrinsics.size() << " shared intrinsics.");
+
+  // the in-process submaps are kept between the iterations,
+  // the worker submaps only live in the working folder
+  std::vector<sfmData::SfMData> submaps;
+  if(_options.workingFolder.empty())
+    createSubmaps(sfmData, partition, 0, partition.size(), submaps);
+  else
+    saveSubmaps(sfmData, partition);
+
+  std::vector<SubmapSharedValues> submapsSharedValues(partition.size());
+
+  const auto updateFromSubmap = [&](std::size_t submapIndex, const sfmData::SfMData& submap)
+  {
+    updateSceneFromSubmap(submap, sharedLandmarks, sharedIntrinsics, submapsSharedValues.at(submapIndex), sfmData);
+  };
+
+  std::vector<BundleAdjustmentCeres::ParametersPriors> priors(partition.size());
+  std::vector<std::map<IndexT, BundleAdjustmentCeres::ParameterPrior>*> landmarksPriors;
+  std::vector<std::map<IndexT, BundleAdjustmentCeres::ParameterPrior>*> intrinsicsPriors;
+
+  for(BundleAdjustmentCeres::ParametersPriors& submapPriors : priors)
+  {
+    landmarksPriors.push_back(&submapPriors.landmarks);
+    intrinsicsPriors.push_back(&submapPriors.intrinsics);
+  }
+
+  for(std::size_t iteration = 0; iteration < _options.maxNbIterations; ++iteration)
+  {
+    const system::Timer iterationTimer;
+
+    // adjust each submap with the priors pulling it toward the consensus
+    setConsensusPriors(sharedLandmarks, landmarksPenalty, landmarksPriors);
+    setConsensusPriors(sharedIntrinsics, intrinsicsPenalty, intrinsicsPriors);
+
+    if(!adjustSubmaps(submaps, priors, refineOptions, iteration, updateFromSubmap))
+    {
+      _statistics.time = timer.elapsed();
+      return false;
+    }
+
+    // update the consensus
+    const ConsensusResiduals landmarksResiduals = updateConsensus(sharedLandmarks, [&](IndexT landmarkId, std::size_t submapIndex)
+    {
+      return submapsSharedValues.at(submapIndex).landmarks.at(landmarkId);
+    });
+
+    const ConsensusResiduals intrinsicsResiduals = updateConsensus(sharedIntrinsics, [&](IndexT intrinsicId, std::size_t submapIndex)
+    {
+      return submapsSharedValues.at(submapIndex).intrinsics.at(intrinsicId);
+    });
+
+    updateSceneConsensus(sharedLandmarks, sharedIntrinsics, sfmData);
+
+    IterationStatistics iterationStatistics;
+    iterationStatistics.primalResidual = std::sqrt(landmarksResiduals.primal2 + intrinsicsResiduals.primal2);
+    iterationStatistics.dualResidual = std::sqrt(landmarksPenalty * landmarksPenalty * landmarksResiduals.dual2 +
+                                                 intrinsicsPenalty * intrinsicsPenalty * intrinsicsResiduals.dual2);
+    iterationStatistics.landmarksPenalty = landmarksPenalty;
+    iterationStatistics.intrinsicsPenalty = intrinsicsPenalty;
+    iterationStatistics.RMSE = computeRMSE(sfmData);
+    iterationStatistics.time = iterationTimer.elapsed();
+    _statistics.iterations.push_back(iterationStatistics);
+
+    ALICEVISION_LOG_INFO("Partitioned bundle adjustment iteration " << iteration << ":" << std::endl
+                         << "\t- primal residual: " << iterationStatistics.primalResidual << std::endl
+                         << "\t- dual residual: " << iterationStatistics.dualResidual << std::endl
+                         << "\t- landmarks penalty: " << iterationStatistics.landmarksPenalty << std::endl
+                         << "\t- RMSE: " << iterationStatistics.RMSE << std::endl
+                         << "\t- time (s): " << iterationStatistics.time);
+
+    if(landmarksResiduals.isConverged(landmarksPenalty, _options.absoluteTolerance, _options.relativeTolerance) &&
+       intrinsicsResiduals.isConverged(intrinsicsPenalty, _options.absoluteTolerance, _options.relativeTolerance))
+    {
+      _statistics.converged = true;
+      break;
+    }
+
+    if(_options.adaptivePenalty)
+    {
+      adaptPenalty(landmarksResiduals, sharedLandmarks, landmarksPenalty);
+      adaptPenalty(intrinsicsResiduals, sharedIntrinsics, intrinsicsPenalty);
+    }
+  }
+
+  _submapsBA.clear();
+  _statistics.time = timer.elapsed();
+
+  return true;
+}
+
+void BundleAdjustmentPartitioned::saveSubmaps(const sfmData::SfMData& sfmData, const std::vector<std::set<IndexT>>& partition) const
+{
+  const fs::path workingFolder(_options.workingFolder);
+  if(!fs::exists(workingFolder))
+    fs::create_directories(workingFolder);
+
+  // only a group of submaps is in memory at the same time
+  const std::size_t groupSize = static_cast<std::size_t>(std::max(1, _options.nbWorkers));
+  std::vector<sfmData::SfMData> submaps;
+
+  for(std::size_t groupBegin = 0; groupBegin < partition.size(); groupBegin += groupSize)
+  {
+    const std::size_t groupEnd = std::min(partition.size(), groupBegin + groupSize);
+    createSubmaps(sfmData, partition, groupBegin, groupEnd, submaps);
+
+    for(std::size_t i = groupBegin; i < groupEnd; ++i)
+    {
+      const std::string submapFilename = getSubmapFilename(i, ".sfm");
+      if(!sfmDataIO::Save(submaps.at(i - groupBegin), submapFilename, sfmDataIO::ESfMData::ALL))
+        ALICEVISION_THROW_ERROR("Partitioned bundle adjustment: cannot save the submap file '" << submapFilename << "'.");
+    }
+  }
+}
+
+std::string BundleAdjustmentPartitioned::getSubmapFilename(std::size_t submapIndex, const std::string& suffix) const
+{
+  return (fs::path(_options.workingFolder) / ("submap_" + std::to_string(submapIndex) + suffix)).string();
+}
+
+bool BundleAdjustmentPartitioned::adjustSubmaps(std::vector<sfmData::SfMData>& submaps,
+                                                const std::vector<BundleAdjustmentCeres::ParametersPriors>& priors,
+                                                ERefineOptions refineOptions,
+                                                std::size_t iteration,
+                                                const std::function<void(std::size_t, const sfmData::SfMData&)>& updateFromSubmap)
+{
+  const int nbSubmaps = static_cast<int>(priors.size());
+  bool success = true;
+  std::exception_ptr exception;
+
+  if(_options.workingFolder.empty())
+  {
+    // adjust the submaps in parallel in the current process,
+    // each bundle adjustment keeps its problem between the iterations
+    if(_submapsBA.size() != submaps.size())
+    {
+      // share the solver threads between the submaps adjusted at the same time
+      BundleAdjustmentCeres::CeresOptions ceresOptions = _options.ceresOptions;
+      const unsigned int nbParallelSubmaps = static_cast<unsigned int>(std::max(1, std::min(nbSubmaps, omp_get_max_threads())));
+      ceresOptions.nbThreads = std::max(1u, ceresOptions.nbThreads / nbParallelSubmaps);
+
+      _submapsBA.clear();
+      for(std::size_t i = 0; i < submaps.size(); ++i)
+        _submapsBA.emplace_back(new BundleAdjustmentCeres(ceresOptions));
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < nbSubmaps; ++i)
+    {
+      try
+      {
+        _submapsBA.at(i)->setParametersPriors(priors.at(i));
+
+        if(!_submapsBA.at(i)->adjust(submaps.at(i), refineOptions))
+        {
+          ALICEVISION_LOG_WARNING("Partitioned bundle adjustment: the bundle adjustment of the submap " << i << " failed.");
+
+          #pragma omp critical(partitionedBundleAdjustment)
+          success = false;
+          continue;
+        }
+
+        #pragma omp critical(partitionedBundleAdjustment)
+        updateFromSubmap(i, submaps.at(i));
+      }
+      catch(...)
+      {
+        #pragma omp critical(partitionedBundleAdjustment)
+        exception = std::current_exception();
+      }
+    }
+
+    if(exception)
+      std::rethrow_exception(exception);
+
+    return success;
+  }
+
+  // adjust the submaps in worker processes, exchanging files in the working folder
+  if(_options.workerCommand.empty())
+    ALICEVISION_THROW_ERROR("Partitioned bundle adjustment: no worker command.");
+
+  #pragma omp parallel for schedule(dynamic) num_threads(std::max(1, _options.nbWorkers))
+  for(int i = 0; i < nbSubmaps; ++i)
+  {
+    try
+    {
+      const std::string submapFilename = getSubmapFilename(i, ".sfm");
+      const std::string priorsFilename = getSubmapFilename(i, "_priors.txt");
+      const std::string adjustedFilename = getSubmapFilename(i, "_adjusted.sfm");
+
+      savePriors(priorsFilename, priors.at(i), refineOptions);
+
+      // the submap is sent once, then each worker starts from its previous result
+      std::vector<std::string> arguments = _options.workerCommand;
+      arguments.insert(arguments.end(), {"--submap", (iteration == 0) ? submapFilename : adjustedFilename,
+                                         "--priors", priorsFilename,
+                                         "--output", adjustedFilename});
+
+      ALICEVISION_LOG_DEBUG("Partitioned bundle adjustment: run the worker of the submap " << i << ".");
+
+      if(system::runProcess(arguments) != 0)
+      {
+        ALICEVISION_LOG_WARNING("Partitioned bundle adjustment: the bundle adjustment of the submap " << i << " failed.");
+
+        #pragma omp critical(partitionedBundleAdjustment)
+        success = false;
+        continue;
+      }
+
+      sfmData::SfMData adjustedSubmap;
+      if(!sfmDataIO::Load(adjustedSubmap, adjustedFilename, sfmDataIO::ESfMData::ALL))
+        ALICEVISION_THROW_ERROR("Partitioned bundle adjustment: cannot load the adjusted submap file '" << adjustedFilename << "'.");
+
+      #pragma omp critical(partitionedBundleAdjustment)
+      updateFromSubmap(i, adjustedSubmap);
+    }
+    catch(...)
+    {
+      #pragma omp critical(partitionedBundleAdjustment)
+      exception = std::current_exception();
+    }
+  }
+
+  if(exception)
+    std::rethrow_exception(exception);
+
+  return success;
+}
+
+bool BundleAdjustmentPartitioned::adjustSubmap(const std::string& submapFilename,
+                                               const std::string& priorsFilename,
+                                               const std::string& outputFilename,
+                                               const BundleAdjustmentCeres::CeresOptions& ceresOptions)
+{
+  sfmData::SfMData submap;
+  if(!sfmDataIO::Load(submap, submapFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The submap file '" << submapFilename << "' cannot be read.");
+    return false;
+  }
+
+  BundleAdjustmentCeres::ParametersPriors priors;
+  ERefineOptions refineOptions = REFINE_ALL;
+  loadPriors(priorsFilename, priors, refineOptions);
+
+  BundleAdjustmentCeres BA(ceresOptions);
+  BA.setParametersPriors(priors);
+
+  if(!BA.adjust(submap, refineOptions))
+    return false;
+
+  if(!sfmDataIO::Save(submap, outputFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The adjusted submap file '" << outputFilename << "' cannot be written.");
+    return false;
+  }
+
+  return true;
+}
+
+void BundleAdjustmentPartitioned::savePriors(const std::string& filename, const BundleAdjustmentCeres::ParametersPriors& priors, ERefineOptions refineOptions)
+{
+  std::ofstream file(filename);
+  if(!file.is_open())
+    ALICEVISION_THROW_ERROR("Cannot write the priors file '" << filename << "'.");
+
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  file << "refineOptions " << static_cast<int>(refineOptions) << "\n";
+
+  const auto writePriors = [&](const std::string& type, const std::map<IndexT, BundleAdjustmentCeres::ParameterPrior>& typePriors)
+  {
+    for(const auto& priorPair : typePriors)
+    {
+      file << type << " " << priorPair.first << " " << priorPair.second.weight << " " << priorPair.second.target.size();
+      for(const double value : priorPair.second.target)
+        file << " " << value;
+      file << " " << priorPair.second.scales.size();
+      for(const double scale : priorPair.second.scales)
+        file << " " << scale;
+      file << "\n";
+    }
+  };
+
+  writePriors("intrinsic", priors.intrinsics);
+  writePriors("landmark", priors.landmarks);
+
+  if(!file.good())
+    ALICEVISION_THROW_ERROR("Cannot write the priors file '" << filename << "'.");
+}
+
+void BundleAdjustmentPartitioned::loadPriors(const std::string& filename, BundleAdjustmentCeres::ParametersPriors& priors, ERefineOptions& refineOptions)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+    ALICEVISION_THROW_ERROR("Cannot read the priors file '" << filename << "'.");
+
+  priors = BundleAdjustmentCeres::ParametersPriors();
+
+  std::string type;
+  int refineOptionsValue = 0;
+
+  if(!(file >> type >> refineOptionsValue) || type != "refineOptions")
+    ALICEVISION_THROW_ERROR("Invalid priors file '" << filename << "'.");
+
+  refineOptions = static_cast<ERefineOptions>(refineOptionsValue);
+
+  while(file >> type)
+  {
+    IndexT id;
+    std::size_t size;
+    BundleAdjustmentCeres::ParameterPrior prior;
+
+    if(!(file >> id >> prior.weight >> size))
+      ALICEVISION_THROW_ERROR("Invalid priors file '" << filename << "'.");
+
+    prior.target.resize(size);
+    for(double& value : prior.target)
+      if(!(file >> value))
+        ALICEVISION_THROW_ERROR("Invalid priors file '" << filename << "'.");
+
+    if(!(file >> size))
+      ALICEVISION_THROW_ERROR("Invalid priors file '" << filename << "'.");
+
+    prior.scales.resize(size);
+    for(double& scale : prior.scales)
+      if(!(file >> scale))
+        ALICEVISION_THROW_ERROR("Invalid priors file '" << filename << "'.");
+
+    if(type == "intrinsic")
+      priors.intrinsics[id] = std::move(prior);
+    else if(type == "landmark")
+      priors.landmarks[id] = std::move(prior);
+    else
+      ALICEVISION_THROW_ERROR("Invalid prior type '" << type << "' in the priors file '" << filename << "'.");
+  }
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,230 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfm/BundleAdjustment.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+
+namespace sfmData {
+class SfMData;
+} // namespace sfmData
+
+namespace sfm {
+
+/**
+ * @brief Partitioned bundle adjustment for large scenes.
+ *
+ * The poses are split into submaps along the covisibility graph. The submaps are adjusted in parallel
+ * (in the current process or in worker processes exchanging files) and the landmarks and intrinsics
+ * shared by several submaps are reconciled with consensus ADMM iterations:
+ *  - each submap minimizes its reprojection error plus a quadratic prior (rho/2 * ||x - z + u||^2)
+ *    pulling its copy x of the shared parameters toward the consensus value z,
+ *  - the consensus value z is the average of the submaps copies (x + u),
+ *  - the scaled dual variables u accumulate the disagreement of each submap with the consensus.
+ *
+ * The rig sub-poses are kept constant.
+ */
+class BundleAdjustmentPartitioned : public BundleAdjustment
+{
+public:
+
+  /**
+   * @brief Contains all the partitioned bundle adjustment parameters.
+   */
+  struct PartitionedOptions
+  {
+    PartitionedOptions()
+      : ceresOptions(false) // no verbose submaps bundle adjustments
+    {}
+
+    /// options of the submaps bundle adjustments
+    BundleAdjustmentCeres::CeresOptions ceresOptions;
+    /// maximum number of poses per submap
+    std::size_t maxNbPosesPerSubmap = 500;
+    /// maximum number of consensus iterations
+    std::size_t maxNbIterations = 30;
+    /// initial penalty on the landmarks consensus, estimated from the scene if <= 0
+    double landmarksPenalty = 0.0;
+    /// initial penalty on the intrinsics consensus, relative to the reprojection error curvature of a submap along each parameter
+    double intrinsicsPenalty = 1.0;
+    /// adapt the penalties to balance the primal and dual residuals
+    bool adaptivePenalty = true;
+    /// relative tolerance on the primal and dual residuals
+    double relativeTolerance = 1e-5;
+    /// absolute tolerance on the primal and dual residuals
+    double absoluteTolerance = 1e-8;
+    /// folder used to exchange the submaps with the worker processes (empty: the submaps are adjusted in the current process)
+    std::string workingFolder;
+    /// worker program and its first arguments, run without shell with the additional arguments: --submap <file> --priors <file> --output <file>
+    std::vector<std::string> workerCommand;
+    /// maximum number of worker processes running at the same time
+    int nbWorkers = 1;
+  };
+
+  /**
+   * @brief Contains the informations related to a consensus iteration.
+   */
+  struct IterationStatistics
+  {
+    /// disagreement between the submaps and the consensus (primal residual)
+    double primalResidual = 0.0;
+    /// change of the consensus (dual residual)
+    double dualResidual = 0.0;
+    /// penalty on the landmarks consensus
+    double landmarksPenalty = 0.0;
+    /// penalty on the intrinsics consensus
+    double intrinsicsPenalty = 0.0;
+    /// RMSE of the reconciled scene
+    double RMSE = 0.0;
+    /// time spent in the iteration (s)
+    double time = 0.0;
+  };
+
+  /**
+   * @brief Contains all informations related to the performed bundle adjustment.
+   */
+  struct Statistics
+  {
+    /**
+     * @brief Display statistics about bundle adjustment in the terminal
+     *  Logger need to accept <info> log level
+     */
+    void show() const;
+
+    /// number of submaps
+    std::size_t nbSubmaps = 0;
+    /// number of landmarks shared by several submaps
+    std::size_t nbSharedLandmarks = 0;
+    /// number of intrinsics shared by several submaps
+    std::size_t nbSharedIntrinsics = 0;
+    /// true if the consensus converged before the maximum number of iterations
+    bool converged = false;
+    /// RMSE of the initial scene
+    double RMSEinitial = 0.0;
+    /// consensus iterations
+    std::vector<IterationStatistics> iterations;
+    /// total time (s)
+    double time = 0.0;
+  };
+
+  /**
+   * @brief Partitioned bundle adjustment constructor
+   * @param[in] options The partitioned bundle adjustment options
+   */
+  explicit BundleAdjustmentPartitioned(const PartitionedOptions& options = PartitionedOptions())
+    : _options(options)
+  {}
+
+  /**
+   * @brief Perform a partitioned Bundle Adjustment on the SfM scene with refinement of the requested parameters
+   * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions The chosen refine flag
+   * @return false if the bundle adjustment of a submap failed else true
+   * @see BundleAdjustment::Adjust
+   */
+  bool adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions = REFINE_ALL) override;
+
+  /**
+   * @brief Get bundle adjustment statistics structure
+   * @return statistics structure const ptr
+   */
+  inline const Statistics& getStatistics() const
+  {
+    return _statistics;
+  }
+
+  /**
+   * @brief Split the reconstructed poses in connected groups, growing each group along the
+   *        poses sharing the largest number of landmarks.
+   * @param[in] sfmData The input SfMData
+   * @param[in] maxNbPosesPerSubmap The maximum number of poses per group
+   * @return the pose ids of each group
+   */
+  static std::vector<std::set<IndexT>> partitionPoses(const sfmData::SfMData& sfmData, std::size_t maxNbPosesPerSubmap);
+
+  /**
+   * @brief Adjust a submap stored in files, used by the worker processes.
+   * @param[in] submapFilename The submap SfMData file
+   * @param[in] priorsFilename The consensus priors file
+   * @param[in] outputFilename The adjusted submap SfMData file
+   * @param[in] ceresOptions The bundle adjustment options
+   * @return false if the bundle adjustment failed else true
+   */
+  static bool adjustSubmap(const std::string& submapFilename,
+                           const std::string& priorsFilename,
+                           const std::string& outputFilename,
+                           const BundleAdjustmentCeres::CeresOptions& ceresOptions = BundleAdjustmentCeres::CeresOptions(false));
+
+  /**
+   * @brief Save the consensus priors of a submap
+   * @param[in] filename The priors file
+   * @param[in] priors The parameters priors
+   * @param[in] refineOptions The chosen refine flag
+   */
+  static void savePriors(const std::string& filename, const BundleAdjustmentCeres::ParametersPriors& priors, ERefineOptions refineOptions);
+
+  /**
+   * @brief Load the consensus priors of a submap
+   * @param[in] filename The priors file
+   * @param[out] priors The parameters priors
+   * @param[out] refineOptions The chosen refine flag
+   */
+  static void loadPriors(const std::string& filename, BundleAdjustmentCeres::ParametersPriors& priors, ERefineOptions& refineOptions);
+
+private:
+
+  /**
+   * @brief Adjust all the submaps with their consensus priors, in parallel.
+   * @param[in,out] submaps The submaps (in-process mode), empty in worker mode
+   * @param[in] priors The priors of each submap
+   * @param[in] refineOptions The chosen refine flag
+   * @param[in] iteration The consensus iteration
+   * @param[in] updateFromSubmap Function called with each adjusted submap, one at a time
+   * @return false if the bundle adjustment of a submap failed else true
+   */
+  bool adjustSubmaps(std::vector<sfmData::SfMData>& submaps,
+                     const std::vector<BundleAdjustmentCeres::ParametersPriors>& priors,
+                     ERefineOptions refineOptions,
+                     std::size_t iteration,
+                     const std::function<void(std::size_t, const sfmData::SfMData&)>& updateFromSubmap);
+
+  /**
+   * @brief Save the submaps in the working folder for the worker processes,
+   *        creating them by groups of nbWorkers submaps to bound the memory
+   * @param[in] sfmData The input SfMData
+   * @param[in] partition The pose ids of each submap
+   */
+  void saveSubmaps(const sfmData::SfMData& sfmData, const std::vector<std::set<IndexT>>& partition) const;
+
+  /**
+   * @brief Get the path of a submap file in the working folder
+   * @param[in] submapIndex The submap index
+   * @param[in] suffix The file suffix
+   * @return the file path
+   */
+  std::string getSubmapFilename(std::size_t submapIndex, const std::string& suffix) const;
+
+  /// partitioned bundle adjustment options
+  PartitionedOptions _options;
+  /// last adjustment statistics
+  Statistics _statistics;
+  /// bundle adjustment of each submap, kept between the consensus iterations (in-process mode)
+  std::vector<std::unique_ptr<BundleAdjustmentCeres>> _submapsBA;
+};
+
+} // namespace sfm
+} // namespace aliceVision
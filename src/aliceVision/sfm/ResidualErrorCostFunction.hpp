@@ -0,0 +1,472 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfmData/Landmark.hpp>
+
+#include <ceres/ceres.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Define ceres cost functions with analytic derivatives for each AliceVision camera model.
+// They compute the same residuals as the autodiff functors of ResidualErrorFunctor.hpp.
+
+namespace aliceVision {
+namespace sfm {
+namespace analytic {
+
+/**
+ * @brief Rotate a point with an angle-axis rotation (as ceres::AngleAxisRotatePoint)
+ *        and compute the derivatives of the rotated point.
+ * @param[in] angleAxis The angle-axis rotation
+ * @param[in] pt The point to rotate
+ * @param[out] rotatedPt The rotated point
+ * @param[out] rotation The rotation matrix
+ * @param[out] dRotatedPtdAngleAxis The derivative of the rotated point wrt. the angle-axis
+ */
+inline void angleAxisRotatePoint(const double* angleAxis, const Vec3& pt, Vec3& rotatedPt, Mat3& rotation, Mat3& dRotatedPtdAngleAxis)
+{
+  const Eigen::Map<const Vec3> w(angleAxis);
+  const double theta2 = w.squaredNorm();
+  const Mat3 wx = CrossProductMatrix(w);
+
+  // left Jacobian of SO(3): d(R(w) * pt) / dw = -[R(w) * pt]x * Jl(w)
+  Mat3 leftJacobian;
+
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    const double cosTheta = std::cos(theta);
+    const double sinTheta = std::sin(theta);
+
+    // Rodrigues' formula
+    rotation = Mat3::Identity() + (sinTheta / theta) * wx + ((1.0 - cosTheta) / theta2) * wx * wx;
+    leftJacobian = Mat3::Identity() + ((1.0 - cosTheta) / theta2) * wx + ((theta - sinTheta) / (theta2 * theta)) * wx * wx;
+  }
+  else
+  {
+    // first order approximation, as ceres::AngleAxisRotatePoint
+    rotation = Mat3::Identity() + wx;
+    leftJacobian = Mat3::Identity() + 0.5 * wx;
+  }
+
+  rotatedPt = rotation * pt;
+  dRotatedPtdAngleAxis = -CrossProductMatrix(rotatedPt) * leftJacobian;
+}
+
+/**
+ * @brief Pinhole camera model: [focal, principal point x, principal point y]
+ */
+struct Pinhole
+{
+  static constexpr int nbParams = 3;
+
+  /**
+   * @brief Apply the distortion of the camera model to an undistorted point (camera plane)
+   * @param[in] cam_K The intrinsics parameters
+   * @param[in] pt The undistorted point
+   * @param[out] distortedPt The distorted point
+   * @param[out] dDistortedPtdPt The derivative of the distorted point wrt. the undistorted point
+   * @param[out] dDistortedPtdK The derivative of the distorted point wrt. the intrinsics parameters
+   *             (focal and principal point derivatives are not filled)
+   */
+  static void addDistortion(const double* cam_K, const Vec2& pt, Vec2& distortedPt, Eigen::Matrix2d& dDistortedPtdPt, Eigen::Matrix<double, 2, nbParams>& dDistortedPtdK)
+  {
+    distortedPt = pt;
+    dDistortedPtdPt.setIdentity();
+  }
+};
+
+/**
+ * @brief Pinhole camera model with radial distortion: [focal, principal point x, principal point y, k1, ..., kN]
+ */
+template <int NbRadialParams>
+struct PinholeRadial
+{
+  static constexpr int nbParams = 3 + NbRadialParams;
+
+  static void addDistortion(const double* cam_K, const Vec2& pt, Vec2& distortedPt, Eigen::Matrix2d& dDistortedPtdPt, Eigen::Matrix<double, 2, nbParams>& dDistortedPtdK)
+  {
+    const double r2 = pt.squaredNorm();
+
+    // r_coeff = 1 + k1 * r2 + k2 * r2^2 + ...
+    double rCoeff = 1.0;
+    double dRCoeffdR2 = 0.0;
+    double r2Power = 1.0;
+
+    for(int i = 0; i < NbRadialParams; ++i)
+    {
+      const double k = cam_K[3 + i];
+      dRCoeffdR2 += (i + 1) * k * r2Power;
+      r2Power *= r2;
+      rCoeff += k * r2Power;
+      dDistortedPtdK.col(3 + i) = pt * r2Power;
+    }
+
+    distortedPt = pt * rCoeff;
+    dDistortedPtdPt = rCoeff * Eigen::Matrix2d::Identity() + (2.0 * dRCoeffdR2) * pt * pt.transpose();
+  }
+};
+
+using PinholeRadialK1 = PinholeRadial<1>;
+using PinholeRadialK3 = PinholeRadial<3>;
+
+/**
+ * @brief Pinhole camera model with Brown distortion: [focal, principal point x, principal point y, k1, k2, k3, t1, t2]
+ */
+struct PinholeBrownT2
+{
+  static constexpr int nbParams = 8;
+
+  static void addDistortion(const double* cam_K, const Vec2& pt, Vec2& distortedPt, Eigen::Matrix2d& dDistortedPtdPt, Eigen::Matrix<double, 2, nbParams>& dDistortedPtdK)
+  {
+    Eigen::Matrix<double, 2, PinholeRadialK3::nbParams> dRadialdK;
+    PinholeRadialK3::addDistortion(cam_K, pt, distortedPt, dDistortedPtdPt, dRadialdK);
+    dDistortedPtdK.block<2, 3>(0, 3) = dRadialdK.block<2, 3>(0, 3);
+
+    const double t1 = cam_K[6];
+    const double t2 = cam_K[7];
+    const double x = pt(0);
+    const double y = pt(1);
+    const double r2 = pt.squaredNorm();
+
+    // tangential distortion
+    distortedPt(0) += t2 * (r2 + 2.0 * x * x) + 2.0 * t1 * x * y;
+    distortedPt(1) += t1 * (r2 + 2.0 * y * y) + 2.0 * t2 * x * y;
+
+    dDistortedPtdPt(0, 0) += 6.0 * t2 * x + 2.0 * t1 * y;
+    dDistortedPtdPt(0, 1) += 2.0 * t2 * y + 2.0 * t1 * x;
+    dDistortedPtdPt(1, 0) += 2.0 * t1 * x + 2.0 * t2 * y;
+    dDistortedPtdPt(1, 1) += 6.0 * t1 * y + 2.0 * t2 * x;
+
+    dDistortedPtdK(0, 6) = 2.0 * x * y;
+    dDistortedPtdK(0, 7) = r2 + 2.0 * x * x;
+    dDistortedPtdK(1, 6) = r2 + 2.0 * y * y;
+    dDistortedPtdK(1, 7) = 2.0 * x * y;
+  }
+};
+
+/**
+ * @brief Pinhole camera model with fisheye distortion: [focal, principal point x, principal point y, k1, k2, k3, k4]
+ */
+struct PinholeFisheye
+{
+  static constexpr int nbParams = 7;
+
+  static void addDistortion(const double* cam_K, const Vec2& pt, Vec2& distortedPt, Eigen::Matrix2d& dDistortedPtdPt, Eigen::Matrix<double, 2, nbParams>& dDistortedPtdK)
+  {
+    const double r = pt.norm();
+
+    if(r <= 1e-8)
+    {
+      distortedPt = pt;
+      dDistortedPtdPt.setIdentity();
+      dDistortedPtdK.block<2, 4>(0, 3).setZero();
+      return;
+    }
+
+    const double theta = std::atan(r);
+    const double theta2 = theta * theta;
+
+    // theta_dist = theta + k1 * theta^3 + k2 * theta^5 + k3 * theta^7 + k4 * theta^9
+    double thetaDist = theta;
+    double dThetaDistdTheta = 1.0;
+    double thetaPower = theta;
+
+    for(int i = 0; i < 4; ++i)
+    {
+      const double k = cam_K[3 + i];
+      dThetaDistdTheta += (2 * i + 3) * k * thetaPower * theta;
+      thetaPower *= theta2;
+      thetaDist += k * thetaPower;
+      dDistortedPtdK.col(3 + i) = pt * (thetaPower / r);
+    }
+
+    const double cDist = thetaDist / r;
+    const double dThetadR = 1.0 / (1.0 + r * r);
+    const double dCDistdR = (dThetaDistdTheta * dThetadR * r - thetaDist) / (r * r);
+
+    distortedPt = pt * cDist;
+    dDistortedPtdPt = cDist * Eigen::Matrix2d::Identity() + (dCDistdR / r) * pt * pt.transpose();
+  }
+};
+
+/**
+ * @brief Pinhole camera model with fisheye (FOV) distortion: [focal, principal point x, principal point y, k1]
+ */
+struct PinholeFisheye1
+{
+  static constexpr int nbParams = 4;
+
+  static void addDistortion(const double* cam_K, const Vec2& pt, Vec2& distortedPt, Eigen::Matrix2d& dDistortedPtdPt, Eigen::Matrix<double, 2, nbParams>& dDistortedPtdK)
+  {
+    const double k1 = cam_K[3];
+    const double r = pt.norm();
+    const double tanHalfK1 = std::tan(0.5 * k1);
+    const double a = 2.0 * tanHalfK1;
+    const double dAdK1 = 1.0 + tanHalfK1 * tanHalfK1;
+
+    if(r <= 1e-8)
+    {
+      // limit of r_coeff = atan(a * r) / (k1 * r)
+      const double rCoeff = a / k1;
+      distortedPt = pt * rCoeff;
+      dDistortedPtdPt = rCoeff * Eigen::Matrix2d::Identity();
+      dDistortedPtdK.col(3) = pt * ((dAdK1 * k1 - a) / (k1 * k1));
+      return;
+    }
+
+    const double ar = a * r;
+    const double atanAR = std::atan(ar);
+    const double rCoeff = atanAR / (k1 * r);
+    const double dRCoeffdR = (a * r / (1.0 + ar * ar) - atanAR) / (k1 * r * r);
+    const double dRCoeffdK1 = (r * dAdK1 / (1.0 + ar * ar) * k1 - atanAR) / (k1 * k1 * r);
+
+    distortedPt = pt * rCoeff;
+    dDistortedPtdPt = rCoeff * Eigen::Matrix2d::Identity() + (dRCoeffdR / r) * pt * pt.transpose();
+    dDistortedPtdK.col(3) = pt * dRCoeffdK1;
+  }
+};
+
+/**
+ * @brief Project a point of the camera coordinate system and compute the residual
+ *        and its derivatives wrt. the intrinsics parameters and the camera point.
+ * @param[in] cam_K The intrinsics parameters
+ * @param[in] camPt The point in the camera coordinate system
+ * @param[in] obs The 2D observation
+ * @param[out] residuals The residuals
+ * @param[out] dResdK The residuals derivatives wrt. the intrinsics parameters
+ * @param[out] dResdCamPt The residuals derivatives wrt. the camera point
+ */
+template <class CameraModel>
+void computeResiduals(const double* cam_K,
+                      const Vec3& camPt,
+                      const sfmData::Observation& obs,
+                      double* residuals,
+                      Eigen::Matrix<double, 2, CameraModel::nbParams>& dResdK,
+                      Eigen::Matrix<double, 2, 3>& dResdCamPt)
+{
+  const double focal = cam_K[0];
+  const double invZ = 1.0 / camPt(2);
+
+  // transform the point from homogeneous to euclidean (undistorted point)
+  const Vec2 undistortedPt(camPt(0) * invZ, camPt(1) * invZ);
+
+  Eigen::Matrix<double, 2, 3> dUndistortedPtdCamPt;
+  dUndistortedPtdCamPt << invZ, 0.0, -undistortedPt(0) * invZ,
+                          0.0, invZ, -undistortedPt(1) * invZ;
+
+  // apply distortion
+  Vec2 distortedPt;
+  Eigen::Matrix2d dDistortedPtdPt;
+  CameraModel::addDistortion(cam_K, undistortedPt, distortedPt, dDistortedPtdPt, dResdK);
+
+  // apply focal length and principal point to get the final image coordinates
+  const double invScale = 1.0 / (obs.scale > 0.0 ? obs.scale : 1.0);
+  residuals[0] = (cam_K[1] + focal * distortedPt(0) - obs.x(0)) * invScale;
+  residuals[1] = (cam_K[2] + focal * distortedPt(1) - obs.x(1)) * invScale;
+
+  dResdK.template block<2, CameraModel::nbParams - 3>(0, 3) *= focal * invScale;
+  dResdK.col(0) = distortedPt * invScale;
+  dResdK.template block<2, 2>(0, 1) = invScale * Eigen::Matrix2d::Identity();
+
+  dResdCamPt = (focal * invScale) * dDistortedPtdPt * dUndistortedPtdCamPt;
+}
+
+/**
+ * @brief Ceres cost function with analytic derivatives for a camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2, CameraModel::nbParams, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - CameraModel::nbParams => the intrinsic data block [focal, principal point x, principal point y, distortion...],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+template <class CameraModel>
+class ResidualErrorCostFunction : public ceres::SizedCostFunction<2, CameraModel::nbParams, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction(const sfmData::Observation& obs)
+    : _obs(obs)
+  {}
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const Eigen::Map<const Vec3> pos_3dpoint(parameters[2]);
+
+    // apply external parameters (pose)
+    Vec3 rotatedPt;
+    Mat3 rotation;
+    Mat3 dRotatedPtdAngleAxis;
+    angleAxisRotatePoint(cam_Rt, pos_3dpoint, rotatedPt, rotation, dRotatedPtdAngleAxis);
+    const Vec3 camPt = rotatedPt + Eigen::Map<const Vec3>(&cam_Rt[3]);
+
+    // apply intrinsic parameters
+    Eigen::Matrix<double, 2, CameraModel::nbParams> dResdK;
+    Eigen::Matrix<double, 2, 3> dResdCamPt;
+    computeResiduals<CameraModel>(cam_K, camPt, _obs, residuals, dResdK, dResdCamPt);
+
+    if(jacobians == nullptr)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, CameraModel::nbParams, Eigen::RowMajor>> J(jacobians[0]);
+      J = dResdK;
+    }
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.block<2, 3>(0, 0) = dResdCamPt * dRotatedPtdAngleAxis;
+      J.block<2, 3>(0, 3) = dResdCamPt;
+    }
+
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[2]);
+      J = dResdCamPt * rotation;
+    }
+
+    return true;
+  }
+
+private:
+  const sfmData::Observation _obs; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic derivatives for a camera of a rig and a 3D point.
+ *
+ *  Data parameter blocks are the following <2, CameraModel::nbParams, 6, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - CameraModel::nbParams => the intrinsic data block [focal, principal point x, principal point y, distortion...],
+ *  - 6 => the rig extrinsic data block (rig orientation and position) [R;t],
+ *  - 6 => the camera sub-pose data block (camera orientation and position in the rig) [R;t],
+ *  - 3 => a 3D point data block.
+ */
+template <class CameraModel>
+class ResidualErrorRigCostFunction : public ceres::SizedCostFunction<2, CameraModel::nbParams, 6, 6, 3>
+{
+public:
+  explicit ResidualErrorRigCostFunction(const sfmData::Observation& obs)
+    : _obs(obs)
+  {}
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const double* subpose_Rt = parameters[2];
+    const Eigen::Map<const Vec3> pos_3dpoint(parameters[3]);
+
+    // apply external parameters (pose)
+    Vec3 rotatedPt;
+    Mat3 rotation;
+    Mat3 dRotatedPtdAngleAxis;
+    angleAxisRotatePoint(cam_Rt, pos_3dpoint, rotatedPt, rotation, dRotatedPtdAngleAxis);
+    const Vec3 rigPt = rotatedPt + Eigen::Map<const Vec3>(&cam_Rt[3]);
+
+    // apply external parameters (sub-pose)
+    Vec3 subRotatedPt;
+    Mat3 subRotation;
+    Mat3 dSubRotatedPtdAngleAxis;
+    angleAxisRotatePoint(subpose_Rt, rigPt, subRotatedPt, subRotation, dSubRotatedPtdAngleAxis);
+    const Vec3 camPt = subRotatedPt + Eigen::Map<const Vec3>(&subpose_Rt[3]);
+
+    // apply intrinsic parameters
+    Eigen::Matrix<double, 2, CameraModel::nbParams> dResdK;
+    Eigen::Matrix<double, 2, 3> dResdCamPt;
+    computeResiduals<CameraModel>(cam_K, camPt, _obs, residuals, dResdK, dResdCamPt);
+
+    if(jacobians == nullptr)
+      return true;
+
+    const Eigen::Matrix<double, 2, 3> dResdRigPt = dResdCamPt * subRotation;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, CameraModel::nbParams, Eigen::RowMajor>> J(jacobians[0]);
+      J = dResdK;
+    }
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.block<2, 3>(0, 0) = dResdRigPt * dRotatedPtdAngleAxis;
+      J.block<2, 3>(0, 3) = dResdRigPt;
+    }
+
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[2]);
+      J.block<2, 3>(0, 0) = dResdCamPt * dSubRotatedPtdAngleAxis;
+      J.block<2, 3>(0, 3) = dResdCamPt;
+    }
+
+    if(jacobians[3] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[3]);
+      J = dResdRigPt * rotation;
+    }
+
+    return true;
+  }
+
+private:
+  const sfmData::Observation _obs; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function of a quadratic prior on a whole parameter block.
+ *
+ *  The residuals are weight * scale_i * (x_i - target_i), the prior cost is thus 0.5 * weight^2 * sum((scale_i * (x_i - target_i))^2).
+ */
+class ParameterPriorCostFunction : public ceres::CostFunction
+{
+public:
+  ParameterPriorCostFunction(const std::vector<double>& target, double weight, const std::vector<double>& scales = std::vector<double>())
+    : _target(target)
+    , _weights(target.size(), weight)
+  {
+    for(std::size_t i = 0; i < scales.size(); ++i)
+      _weights[i] *= scales[i];
+
+    set_num_residuals(static_cast<int>(_target.size()));
+    mutable_parameter_block_sizes()->push_back(static_cast<int>(_target.size()));
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const int size = static_cast<int>(_target.size());
+
+    for(int i = 0; i < size; ++i)
+      residuals[i] = _weights[i] * (parameters[0][i] - _target[i]);
+
+    if(jacobians != nullptr && jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::MatrixXd> J(jacobians[0], size, size);
+      J = Eigen::Map<const Eigen::VectorXd>(_weights.data(), size).asDiagonal();
+    }
+
+    return true;
+  }
+
+private:
+  const std::vector<double> _target; // The prior value of the parameter block
+  std::vector<double> _weights; // The prior weight of each parameter
+};
+
+} // namespace analytic
+} // namespace sfm
+} // namespace aliceVision
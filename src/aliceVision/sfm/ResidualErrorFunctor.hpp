@@ -163,7 +163,7 @@ struct ResidualErrorFunctor_Pinhole
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -318,7 +318,7 @@ struct ResidualErrorFunctor_PinholeRadialK1
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -472,7 +472,7 @@ struct ResidualErrorFunctor_PinholeRadialK3
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -639,7 +639,7 @@ struct ResidualErrorFunctor_PinholeBrownT2
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 
@@ -808,7 +808,7 @@ struct ResidualErrorFunctor_PinholeFisheye
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -851,7 +851,8 @@ struct ResidualErrorFunctor_PinholeFisheye1
     // Apply distortion (xd,yd) = disto(x_u,y_u)
     const T r2 = x_u*x_u + y_u*y_u;
     const T r = sqrt(r2);
-    const T r_coeff = (atan(2.0 * r * tan(0.5 * k1)) / k1) / r;
+    // limit of r_coeff at the principal point
+    const T r_coeff = r > T(1e-8) ? (atan(2.0 * r * tan(0.5 * k1)) / k1) / r : (2.0 * tan(0.5 * k1)) / k1;
     const T x_d = x_u * r_coeff;
     const T y_d = y_u * r_coeff;
 
@@ -963,7 +964,7 @@ struct ResidualErrorFunctor_PinholeFisheye1
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 
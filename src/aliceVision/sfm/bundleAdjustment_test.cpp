@@ -6,12 +6,23 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/BundleAdjustmentPartitioned.hpp>
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/multiview/NViewDataSet.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
 
 #define BOOST_TEST_MODULE bundleAdjustment
 
@@ -30,6 +41,9 @@ SfMData getInputScene(const NViewDataSet& d, const NViewDatasetConfigurator& con
 
 track::TracksPerView getTracksPerViews(const SfMData& sfmData);
 
+template <class AutoDiffFunctor, class CameraModel>
+void checkAnalyticDerivatives(const std::vector<double>& intrinsicParams);
+
 // Test summary:
 // - Create a SfMData scene from a synthetic dataset
 //   - since random noise have been added on 2d data point (initial residual is not small)
@@ -137,6 +151,345 @@ BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeFisheye)
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_IncrementalProblemUpdate)
+{
+  const int nviews = 4;
+  const int npoints = 12;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  // the Ceres problem is kept by the bundle adjustment object between two calls
+  BundleAdjustmentCeres persistentBA;
+  BOOST_CHECK(persistentBA.adjust(sfmData));
+
+  // remove a landmark and some observations
+  sfmData.getLandmarks().erase(0);
+  for(auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(landmarkPair.first % 3 == 0)
+      landmarkPair.second.observations.erase(landmarkPair.second.observations.begin());
+  }
+
+  // change the setup of the intrinsic parameter blocks
+  const BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION |
+                                                         BundleAdjustment::REFINE_TRANSLATION |
+                                                         BundleAdjustment::REFINE_STRUCTURE;
+  SfMData sfmDataCopy = sfmData;
+
+  BOOST_CHECK(persistentBA.adjust(sfmData, refineOptions));
+
+  // compare with a problem created from scratch
+  BundleAdjustmentCeres newBA;
+  BOOST_CHECK(newBA.adjust(sfmDataCopy, refineOptions));
+
+  BOOST_CHECK_EQUAL(persistentBA.getStatistics().nbResidualBlocks, newBA.getStatistics().nbResidualBlocks);
+  BOOST_CHECK_CLOSE(persistentBA.getStatistics().RMSEinitial, newBA.getStatistics().RMSEinitial, 1e-6);
+  BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(sfmDataCopy), 1e-6);
+}
+
+// Test summary:
+// - Adjust a scene, then change the loss function and the derivatives type
+// - Check that the kept Ceres problem is rebuilt with the new options
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_ProblemUpdateOptions)
+{
+  const int nviews = 4;
+  const int npoints = 12;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  BundleAdjustmentCeres persistentBA;
+  BOOST_CHECK(persistentBA.adjust(sfmData));
+
+  // add some noise on the structure, so the loss function matters
+  for(auto& landmarkPair : sfmData.getLandmarks())
+    landmarkPair.second.X += Vec3(0.1, -0.2, 0.05) * double(landmarkPair.first % 3);
+  SfMData sfmDataCopy = sfmData;
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.lossFunction.reset();
+  options.useAnalyticDerivatives = true;
+
+  persistentBA.setCeresOptions(options);
+  BOOST_CHECK(persistentBA.adjust(sfmData));
+
+  // compare with a problem created from scratch with the same options
+  BundleAdjustmentCeres newBA(options);
+  BOOST_CHECK(newBA.adjust(sfmDataCopy));
+
+  BOOST_CHECK_EQUAL(persistentBA.getStatistics().nbResidualBlocks, newBA.getStatistics().nbResidualBlocks);
+  BOOST_CHECK_CLOSE(persistentBA.getStatistics().RMSEinitial, newBA.getStatistics().RMSEinitial, 1e-6);
+  BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(sfmDataCopy), 1e-6);
+}
+
+// Test summary:
+// - Run the outlier rejection loop of the sequential SfM with the same bundle adjustment object:
+//   observations, landmarks and a whole pose are removed between two adjustments
+// - Check that each adjustment gives the same result as a problem created from scratch
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_OutlierRejectionProblemUpdate)
+{
+  const int nviews = 6;
+  const int npoints = 60;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  // some observations are outliers
+  for(auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(landmarkPair.first % 7 == 0)
+      landmarkPair.second.observations.at(1).x += Vec2(40.0, -30.0);
+  }
+
+  // the last view is seen by too few landmarks and is removed after the first adjustment
+  for(auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(landmarkPair.first >= 5)
+      landmarkPair.second.observations.erase(nviews - 1);
+  }
+
+  BundleAdjustmentCeres persistentBA;
+  std::size_t nbOutliers = 0;
+  int iteration = 0;
+
+  do
+  {
+    SfMData sfmDataCopy = sfmData;
+
+    // intrinsics are shared by the copy
+    for(auto& intrinsicPair : sfmDataCopy.intrinsics)
+      intrinsicPair.second.reset(intrinsicPair.second->clone());
+
+    BOOST_CHECK(persistentBA.adjust(sfmData));
+
+    BundleAdjustmentCeres newBA;
+    BOOST_CHECK(newBA.adjust(sfmDataCopy));
+
+    BOOST_CHECK_EQUAL(persistentBA.getStatistics().nbResidualBlocks, newBA.getStatistics().nbResidualBlocks);
+    BOOST_CHECK_CLOSE(persistentBA.getStatistics().RMSEinitial, newBA.getStatistics().RMSEinitial, 1e-6);
+    BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(sfmDataCopy), 1e-6);
+
+    // same outlier rejection as ReconstructionEngine_sequentialSfM::bundleAdjustment
+    nbOutliers = RemoveOutliers_PixelResidualError(sfmData, EFeatureConstraint::BASIC, 4.0, 2);
+    eraseUnstablePosesAndObservations(sfmData, 6, 2);
+
+    if(iteration == 0)
+      BOOST_CHECK_EQUAL(sfmData.getPoses().size(), nviews - 1);
+
+    ++iteration;
+  }
+  while(nbOutliers > 0 && iteration < 10);
+
+  BOOST_CHECK_GT(iteration, 1);
+  BOOST_CHECK_EQUAL(nbOutliers, 0);
+}
+
+// Test summary:
+// - Compare the residuals and the jacobians of the cost functions with analytic derivatives
+//   with the ones computed by automatic differentiation, for each camera model, with and without rig
+// - The first evaluation projects the point on the principal point
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticDerivatives)
+{
+  checkAnalyticDerivatives<ResidualErrorFunctor_Pinhole, analytic::Pinhole>({1000.0, 500.0, 400.0});
+  checkAnalyticDerivatives<ResidualErrorFunctor_PinholeRadialK1, analytic::PinholeRadialK1>({1000.0, 500.0, 400.0, 0.1});
+  checkAnalyticDerivatives<ResidualErrorFunctor_PinholeRadialK3, analytic::PinholeRadialK3>({1000.0, 500.0, 400.0, 0.1, -0.05, 0.02});
+  checkAnalyticDerivatives<ResidualErrorFunctor_PinholeBrownT2, analytic::PinholeBrownT2>({1000.0, 500.0, 400.0, 0.1, -0.05, 0.02, 0.01, -0.02});
+  checkAnalyticDerivatives<ResidualErrorFunctor_PinholeFisheye, analytic::PinholeFisheye>({1000.0, 500.0, 400.0, 0.1, -0.05, 0.02, 0.01});
+  checkAnalyticDerivatives<ResidualErrorFunctor_PinholeFisheye1, analytic::PinholeFisheye1>({1000.0, 500.0, 400.0, 0.9});
+}
+
+// Test summary:
+// - Perform the bundle adjustment of the same scene with analytic and automatic derivatives
+// - Check that both converge to the same solution and report the time of each
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticDerivativesTiming)
+{
+  const int nviews = 20;
+  const int npoints = 500;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  for(EINTRINSIC eintrinsic : {EINTRINSIC::PINHOLE_CAMERA, EINTRINSIC::PINHOLE_CAMERA_RADIAL3,
+                               EINTRINSIC::PINHOLE_CAMERA_BROWN, EINTRINSIC::PINHOLE_CAMERA_FISHEYE})
+  {
+    // Translate the input dataset to a SfMData scene
+    SfMData sfmDataAnalytic = getInputScene(d, config, eintrinsic);
+    SfMData sfmDataAutoDiff = sfmDataAnalytic;
+
+    // intrinsics are shared by the copy
+    for(auto& intrinsicPair : sfmDataAutoDiff.intrinsics)
+      intrinsicPair.second.reset(intrinsicPair.second->clone());
+
+    BundleAdjustmentCeres::CeresOptions options(false);
+    options.summary = true;
+
+    options.useAnalyticDerivatives = true;
+    BundleAdjustmentCeres analyticBA(options);
+    BOOST_CHECK(analyticBA.adjust(sfmDataAnalytic));
+
+    options.useAnalyticDerivatives = false;
+    BundleAdjustmentCeres autoDiffBA(options);
+    BOOST_CHECK(autoDiffBA.adjust(sfmDataAutoDiff));
+
+    BOOST_CHECK_CLOSE(RMSE(sfmDataAnalytic), RMSE(sfmDataAutoDiff), 1e-2);
+    BOOST_TEST_MESSAGE(EINTRINSIC_enumToString(eintrinsic) << ": analytic derivatives BA: " << analyticBA.getStatistics().time
+                       << " s, automatic derivatives BA: " << autoDiffBA.getStatistics().time << " s");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned)
+{
+  const int nviews = 12;
+  const int npoints = 200;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmDataPartitioned = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+  SfMData sfmDataMonolithic = sfmDataPartitioned;
+
+  // intrinsics are shared by the copy
+  for(auto& intrinsicPair : sfmDataMonolithic.intrinsics)
+    intrinsicPair.second.reset(intrinsicPair.second->clone());
+
+  // each pose belongs to exactly one submap
+  const std::vector<std::set<IndexT>> submaps = BundleAdjustmentPartitioned::partitionPoses(sfmDataPartitioned, 4);
+  BOOST_CHECK_EQUAL(submaps.size(), 3);
+
+  std::set<IndexT> partitionedPoses;
+  for(const std::set<IndexT>& submap : submaps)
+  {
+    BOOST_CHECK_LE(submap.size(), 4);
+    partitionedPoses.insert(submap.begin(), submap.end());
+  }
+  BOOST_CHECK_EQUAL(partitionedPoses.size(), sfmDataPartitioned.getPoses().size());
+
+  const double dResidual_before = RMSE(sfmDataPartitioned);
+
+  BundleAdjustmentPartitioned::PartitionedOptions options;
+  options.maxNbPosesPerSubmap = 4;
+  options.maxNbIterations = 50;
+  BundleAdjustmentPartitioned partitionedBA(options);
+  BOOST_CHECK(partitionedBA.adjust(sfmDataPartitioned));
+
+  BundleAdjustmentCeres monolithicBA(BundleAdjustmentCeres::CeresOptions(false));
+  BOOST_CHECK(monolithicBA.adjust(sfmDataMonolithic));
+
+  const BundleAdjustmentPartitioned::Statistics& statistics = partitionedBA.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.nbSubmaps, 3);
+  BOOST_CHECK_EQUAL(statistics.nbSharedLandmarks, npoints);
+  BOOST_CHECK_EQUAL(statistics.nbSharedIntrinsics, 1);
+
+  // the consensus reaches the monolithic solution
+  const double dResidual_after = RMSE(sfmDataPartitioned);
+  BOOST_CHECK_LT(dResidual_after, dResidual_before);
+  BOOST_CHECK_SMALL(dResidual_after - RMSE(sfmDataMonolithic), 1e-2);
+
+  BOOST_TEST_MESSAGE("Partitioned BA: " << statistics.iterations.size() << " iterations, " << statistics.time
+                     << " s, monolithic BA: " << monolithicBA.getStatistics().time << " s");
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned_LimitedVisibility)
+{
+  // each landmark is only seen by its nearest views, with pixel noise,
+  // and the distortion of the shared intrinsic is refined
+  const int nviews = 24;
+  const int npoints = 600;
+  const std::size_t nbVisibleViews = 6;
+  const NViewDatasetConfigurator config(1000, 1000, 500, 500, 5, 0);
+
+  // the synthetic dataset is drawn with rand()
+  std::srand(0);
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmDataPartitioned = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  std::mt19937 generator(0);
+  std::normal_distribution<double> pixelNoise(0.0, 0.5);
+
+  for(auto& landmarkPair : sfmDataPartitioned.structure)
+  {
+    Landmark& landmark = landmarkPair.second;
+    std::vector<std::pair<double, IndexT>> distances;
+    for(const auto& observationPair : landmark.observations)
+      distances.emplace_back((d._C[observationPair.first] - landmark.X).norm(), observationPair.first);
+    std::sort(distances.begin(), distances.end());
+
+    Observations observations;
+    for(std::size_t i = 0; i < nbVisibleViews; ++i)
+    {
+      Observation observation = landmark.observations.at(distances.at(i).second);
+      observation.x += Vec2(pixelNoise(generator), pixelNoise(generator));
+      observations[distances.at(i).second] = observation;
+    }
+    landmark.observations = observations;
+  }
+
+  SfMData sfmDataMonolithic = sfmDataPartitioned;
+  for(auto& intrinsicPair : sfmDataMonolithic.intrinsics)
+    intrinsicPair.second.reset(intrinsicPair.second->clone());
+
+  BundleAdjustmentPartitioned::PartitionedOptions options;
+  options.maxNbPosesPerSubmap = 8;
+  options.maxNbIterations = 30;
+  BundleAdjustmentPartitioned partitionedBA(options);
+  BOOST_CHECK(partitionedBA.adjust(sfmDataPartitioned));
+
+  BundleAdjustmentCeres monolithicBA(BundleAdjustmentCeres::CeresOptions(false));
+  BOOST_CHECK(monolithicBA.adjust(sfmDataMonolithic));
+
+  const BundleAdjustmentPartitioned::Statistics& statistics = partitionedBA.getStatistics();
+  BOOST_CHECK_EQUAL(statistics.nbSubmaps, 3);
+  BOOST_CHECK_EQUAL(statistics.nbSharedIntrinsics, 1);
+
+  // the consensus does not drift away from the monolithic solution
+  double maxRMSE = 0.0;
+  for(const BundleAdjustmentPartitioned::IterationStatistics& iteration : statistics.iterations)
+    maxRMSE = std::max(maxRMSE, iteration.RMSE);
+
+  const double monolithicRMSE = RMSE(sfmDataMonolithic);
+  BOOST_CHECK_LT(maxRMSE, 2.0 * monolithicRMSE);
+  BOOST_CHECK_LT(RMSE(sfmDataPartitioned), 1.02 * monolithicRMSE);
+
+  BOOST_TEST_MESSAGE("Partitioned BA RMSE: " << RMSE(sfmDataPartitioned) << ", monolithic BA RMSE: " << monolithicRMSE);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned_PriorsFile)
+{
+  BundleAdjustmentCeres::ParametersPriors priors;
+  priors.intrinsics[3].target = {1000.5, 499.25, 501.0, 0.125};
+  priors.intrinsics[3].weight = 2.0;
+  priors.intrinsics[3].scales = {0.5, 20.0, 20.0, 8000.0};
+  priors.landmarks[7].target = {0.1, -0.2, 4.75};
+  priors.landmarks[7].weight = 150.0;
+
+  const std::string filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("priors_%%%%%%.txt")).string();
+  BundleAdjustmentPartitioned::savePriors(filename, priors, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_STRUCTURE);
+
+  BundleAdjustmentCeres::ParametersPriors loadedPriors;
+  BundleAdjustment::ERefineOptions refineOptions;
+  BundleAdjustmentPartitioned::loadPriors(filename, loadedPriors, refineOptions);
+  boost::filesystem::remove(filename);
+
+  BOOST_CHECK_EQUAL(refineOptions, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_STRUCTURE);
+  BOOST_REQUIRE_EQUAL(loadedPriors.intrinsics.size(), 1);
+  BOOST_REQUIRE_EQUAL(loadedPriors.landmarks.size(), 1);
+  BOOST_CHECK(loadedPriors.intrinsics.at(3).target == priors.intrinsics.at(3).target);
+  BOOST_CHECK(loadedPriors.intrinsics.at(3).scales == priors.intrinsics.at(3).scales);
+  BOOST_CHECK_EQUAL(loadedPriors.intrinsics.at(3).weight, priors.intrinsics.at(3).weight);
+  BOOST_CHECK(loadedPriors.landmarks.at(7).target == priors.landmarks.at(7).target);
+  BOOST_CHECK(loadedPriors.landmarks.at(7).scales.empty());
+  BOOST_CHECK_EQUAL(loadedPriors.landmarks.at(7).weight, priors.landmarks.at(7).weight);
+}
+
 BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_CamerasRing)
 {
   const int nviews = 4;
@@ -326,6 +679,78 @@ SfMData getInputScene(const NViewDataSet & d, const NViewDatasetConfigurator & c
   return sfm_data;
 }
 
+template <class AutoDiffFunctor, class CameraModel>
+void checkAnalyticDerivatives(const std::vector<double>& intrinsicParams, bool useRig)
+{
+  const int nbParams = CameraModel::nbParams;
+  BOOST_REQUIRE_EQUAL(intrinsicParams.size(), static_cast<std::size_t>(nbParams));
+
+  const Observation observation(Vec2(100.3, 200.7), 0, 1.5);
+
+  std::unique_ptr<ceres::CostFunction> autoDiffCost;
+  std::unique_ptr<ceres::CostFunction> analyticCost;
+
+  if(useRig)
+  {
+    autoDiffCost.reset(new ceres::AutoDiffCostFunction<AutoDiffFunctor, 2, nbParams, 6, 6, 3>(new AutoDiffFunctor(observation)));
+    analyticCost.reset(new analytic::ResidualErrorRigCostFunction<CameraModel>(observation));
+  }
+  else
+  {
+    autoDiffCost.reset(new ceres::AutoDiffCostFunction<AutoDiffFunctor, 2, nbParams, 6, 3>(new AutoDiffFunctor(observation)));
+    analyticCost.reset(new analytic::ResidualErrorCostFunction<CameraModel>(observation));
+  }
+
+  const std::vector<int> blockSizes = useRig ? std::vector<int>{nbParams, 6, 6, 3} : std::vector<int>{nbParams, 6, 3};
+
+  for(int i = 0; i < 20; ++i)
+  {
+    // random poses in front of a point, the first one without rotation
+    std::vector<std::vector<double>> parameters = {intrinsicParams};
+    for(std::size_t b = 1; b < blockSizes.size(); ++b)
+    {
+      const Vec random = (i == 0) ? Vec(Vec::Zero(blockSizes.at(b))) : Vec(0.3 * Vec::Random(blockSizes.at(b)));
+      parameters.emplace_back(random.data(), random.data() + random.size());
+    }
+    parameters.back().at(2) += 4.0;
+
+    std::vector<double*> parametersPtr;
+    std::vector<std::vector<double>> autoDiffJacobians;
+    std::vector<std::vector<double>> analyticJacobians;
+    std::vector<double*> autoDiffJacobiansPtr;
+    std::vector<double*> analyticJacobiansPtr;
+
+    for(std::size_t b = 0; b < blockSizes.size(); ++b)
+    {
+      parametersPtr.push_back(parameters.at(b).data());
+      autoDiffJacobians.emplace_back(2 * blockSizes.at(b));
+      analyticJacobians.emplace_back(2 * blockSizes.at(b));
+      autoDiffJacobiansPtr.push_back(autoDiffJacobians.back().data());
+      analyticJacobiansPtr.push_back(analyticJacobians.back().data());
+    }
+
+    double autoDiffResiduals[2];
+    double analyticResiduals[2];
+
+    BOOST_CHECK(autoDiffCost->Evaluate(parametersPtr.data(), autoDiffResiduals, autoDiffJacobiansPtr.data()));
+    BOOST_CHECK(analyticCost->Evaluate(parametersPtr.data(), analyticResiduals, analyticJacobiansPtr.data()));
+
+    for(int r = 0; r < 2; ++r)
+      BOOST_CHECK_SMALL(autoDiffResiduals[r] - analyticResiduals[r], 1e-8);
+
+    for(std::size_t b = 0; b < blockSizes.size(); ++b)
+      for(std::size_t j = 0; j < autoDiffJacobians.at(b).size(); ++j)
+        BOOST_CHECK_SMALL(autoDiffJacobians.at(b).at(j) - analyticJacobians.at(b).at(j), 1e-6 * (1.0 + std::abs(autoDiffJacobians.at(b).at(j))));
+  }
+}
+
+template <class AutoDiffFunctor, class CameraModel>
+void checkAnalyticDerivatives(const std::vector<double>& intrinsicParams)
+{
+  checkAnalyticDerivatives<AutoDiffFunctor, CameraModel>(intrinsicParams, false);
+  checkAnalyticDerivatives<AutoDiffFunctor, CameraModel>(intrinsicParams, true);
+}
+
 track::TracksPerView getTracksPerViews(const SfMData& sfmData)
 {
   track::TracksPerView tracksPerView;
@@ -32,6 +32,10 @@
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <map>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -301,6 +305,30 @@ void GlobalSfMTranslationAveragingSolver::Compute_translations(const SfMData& sf
     tripletWise_matches);
 }
 
+/// view pairs matches per pose pair (smallest pose id first)
+typedef std::map<Pair, std::vector<matching::PairwiseMatches::const_iterator>> MatchesPerPosePair;
+
+/**
+ * @brief List the view pairs matches between the poses of a triplet
+ * @param[in] matchesPerPosePair The view pairs matches per pose pair
+ * @param[in] triplet The triplet of poses (sorted pose ids)
+ * @param[out] out_tripletMatches The matches between the views of the triplet
+ */
+static void getTripletMatches(const MatchesPerPosePair& matchesPerPosePair,
+                              const graph::Triplet& triplet,
+                              matching::PairwiseMatches& out_tripletMatches)
+{
+  out_tripletMatches.clear();
+  for(const Pair& posePair : {Pair(triplet.i, triplet.j), Pair(triplet.i, triplet.k), Pair(triplet.j, triplet.k)})
+  {
+    const auto it = matchesPerPosePair.find(posePair);
+    if(it == matchesPerPosePair.end())
+      continue;
+    for(const auto& matchIt : it->second)
+      out_tripletMatches.insert(*matchIt);
+  }
+}
+
 //-- Perform a trifocal estimation of the graph contained in vec_triplets with an
 // edge coverage algorithm. Its complexity is sub-linear in term of edges count.
 void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCoverage(const SfMData & sfmData,
@@ -319,15 +347,18 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   //
   // 1. List plausible triplets over the global rotation pose graph Ids.
   //   - list all edges that have support in the rotation pose graph
+  //   - index the view pairs matches by pose pair (to list the matches of a triplet
+  //     without going through all the pairwise matches)
   //
   PairSet rotation_pose_id_graph;
+  MatchesPerPosePair matchesPerPosePair;
   std::set<IndexT> set_pose_ids;
   std::transform(map_globalR.begin(), map_globalR.end(),
     std::inserter(set_pose_ids, set_pose_ids.begin()), stl::RetrieveKey());
   // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
+  for (matching::PairwiseMatches::const_iterator match_iterator = pairwiseMatches.begin(); match_iterator != pairwiseMatches.end(); ++match_iterator)
   {
-    const Pair pair = match_iterator.first;
+    const Pair pair = match_iterator->first;
     const View * v1 = sfmData.getViews().at(pair.first).get();
     const View * v2 = sfmData.getViews().at(pair.second).get();
 
@@ -338,6 +369,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     {
       rotation_pose_id_graph.insert(
         std::make_pair(v1->getPoseId(), v2->getPoseId()));
+      matchesPerPosePair[std::minmax(v1->getPoseId(), v2->getPoseId())].push_back(match_iterator);
     }
   }
   // List putative triplets (from global rotations Ids)
@@ -351,40 +383,31 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     // An estimated triplets of translation mark three edges as estimated.
 
     //-- precompute the number of track per triplet:
-    HashMap<IndexT, IndexT> map_tracksPerTriplets;
+    std::vector<std::size_t> vec_tracksPerTriplets(vec_triplets.size(), 0);
 
-    #pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < (int)vec_triplets.size(); ++i)
+    #pragma omp parallel
     {
-      // List matches that belong to the triplet of poses
-      const graph::Triplet & triplet = vec_triplets[i];
       matching::PairwiseMatches map_triplet_matches;
-      const std::set<IndexT> set_triplet_pose_ids = {triplet.i, triplet.j, triplet.k};
-      // List shared correspondences (pairs) between the triplet poses
-      for (const auto & match_iterator : pairwiseMatches)
-      {
-        const Pair pair = match_iterator.first;
-        const View * v1 = sfmData.getViews().at(pair.first).get();
-        const View * v2 = sfmData.getViews().at(pair.second).get();
-        if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-            (v1->getPoseId() != v2->getPoseId())
-            && set_triplet_pose_ids.count(v1->getPoseId())
-            && set_triplet_pose_ids.count(v2->getPoseId()))
-        {
-          map_triplet_matches.insert( match_iterator );
-        }
-      }
-      // Compute tracks:
+
+      #pragma omp for schedule(dynamic)
+      for (int i = 0; i < (int)vec_triplets.size(); ++i)
       {
+        // List matches that belong to the triplet of poses
+        getTripletMatches(matchesPerPosePair, vec_triplets[i], map_triplet_matches);
+
+        // Compute tracks:
         aliceVision::track::TracksBuilder tracksBuilder;
         tracksBuilder.build(map_triplet_matches);
         tracksBuilder.filter(true,3);
-
-        #pragma omp critical
-        map_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
+        vec_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
       }
     }
 
+    // one random seed per triplet (in the triplets order)
+    std::vector<std::mt19937::result_type> vec_seeds(vec_triplets.size());
+    for (auto & seed : vec_seeds)
+      seed = randomNumberGenerator();
+
     typedef Pair myEdge;
 
     //-- Alias (list triplet ids used per pose id edges)
@@ -407,19 +430,18 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
       vec_edges.size(),
       std::cout,
       "\nRelative translations computation (edge coverage algorithm)\n");
+    std::size_t nbProcessedEdges = 0;
 
-    // set number of threads, 1 if openMP is not enabled  
+    // per-thread results, merged after the edge coverage
     std::vector<translationAveraging::RelativeInfoVec> initial_estimates(omp_get_max_threads());
-    const bool bVerbose = false;
+    std::vector<matching::PairwiseMatches> newpairMatchesPerThread(omp_get_max_threads());
 
     #pragma omp parallel for schedule(dynamic)
     for (int k = 0; k < vec_edges.size(); ++k)
     {
       const myEdge & edge = vec_edges[k];
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-      }
+      const int thread_id = omp_get_thread_num();
+
       if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
       {
         // Find the triplets that support the given edge
@@ -429,7 +451,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         std::vector<size_t> vec_commonTracksPerTriplets;
         for (const size_t triplet_index : vec_possibleTripletIndexes)
         {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
+          vec_commonTracksPerTriplets.push_back(vec_tracksPerTriplets[triplet_index]);
         }
 
         using namespace stl::indexed_sort;
@@ -463,14 +485,19 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           std::vector<size_t> vec_inliers;
           aliceVision::track::TracksMap pose_triplet_tracks;
 
+          matching::PairwiseMatches map_triplet_matches;
+          getTripletMatches(matchesPerPosePair, triplet, map_triplet_matches);
+
+          std::mt19937 tripletRandomNumberGenerator(vec_seeds[triplet_index]);
+
           const std::string sOutDirectory = "./";
           const bool bTriplet_estimation = Estimate_T_triplet(
               sfmData,
               map_globalR,
               normalizedFeaturesPerView,
-              pairwiseMatches,
+              map_triplet_matches,
               triplet,
-              randomNumberGenerator,
+              tripletRandomNumberGenerator,
               vec_tis,
               dPrecision,
               vec_inliers,
@@ -507,9 +534,6 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
               Vec3 tik;
               relativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
 
-              // set number of threads, 1 if openMP is not enabled
-              const int thread_id = omp_get_thread_num();
-
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.j), std::make_pair(Rij, tij));
               initial_estimates[thread_id].emplace_back(
@@ -517,40 +541,32 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.k), std::make_pair(Rik, tik));
 
-              //--- ATOMIC
-              #pragma omp critical
+              // Add inliers as valid pairwise matches (in the thread buffer)
+              using namespace aliceVision::track;
+              std::vector<TracksMap::const_iterator> vec_tracks;
+              vec_tracks.reserve(pose_triplet_tracks.size());
+              for (TracksMap::const_iterator it_tracks = pose_triplet_tracks.begin(); it_tracks != pose_triplet_tracks.end(); ++it_tracks)
+                vec_tracks.push_back(it_tracks);
+
+              for (const size_t inlier : vec_inliers)
               {
-                // Add inliers as valid pairwise matches
-                for (std::vector<size_t>::const_iterator iterInliers = vec_inliers.begin();
-                  iterInliers != vec_inliers.end(); ++iterInliers)
+                const Track & track = vec_tracks[inlier]->second;
+
+                // create pairwise matches from inlier track
+                for (Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin(); iter_I != track.featPerView.end(); ++iter_I)
                 {
-                  using namespace aliceVision::track;
-                  TracksMap::iterator it_tracks = pose_triplet_tracks.begin();
-                  std::advance(it_tracks, *iterInliers);
-                  const Track & track = it_tracks->second;
+                  // extract camera indexes
+                  const size_t id_view_I = iter_I->first;
+                  const size_t id_feat_I = iter_I->second;
 
-                  // create pairwise matches from inlier track
-                  for (size_t index_I = 0; index_I < track.featPerView.size() ; ++index_I)
+                  // loop on subtracks
+                  for (Track::FeatureIdPerView::const_iterator iter_J = std::next(iter_I); iter_J != track.featPerView.end(); ++iter_J)
                   {
-                    Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin();
-                    std::advance(iter_I, index_I);
-
                     // extract camera indexes
-                    const size_t id_view_I = iter_I->first;
-                    const size_t id_feat_I = iter_I->second;
-
-                    // loop on subtracks
-                    for (size_t index_J = index_I+1; index_J < track.featPerView.size() ; ++index_J)
-                    {
-                      Track::FeatureIdPerView::const_iterator iter_J = track.featPerView.begin();
-                      std::advance(iter_J, index_J);
-
-                      // extract camera indexes
-                      const size_t id_view_J = iter_J->first;
-                      const size_t id_feat_J = iter_J->second;
+                    const size_t id_view_J = iter_J->first;
+                    const size_t id_feat_J = iter_J->second;
 
-                      newpairMatches[std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
-                    }
+                    newpairMatchesPerThread[thread_id][std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
                   }
                 }
               }
@@ -561,15 +577,43 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           }
         }
       }
+
+      OMP_ATOMIC_UPDATE
+      ++nbProcessedEdges;
+
+      // the progress display is only updated by the first thread
+      if (thread_id == 0)
+      {
+        std::size_t nbProcessedEdgesCopy;
+        OMP_ATOMIC_READ
+        nbProcessedEdgesCopy = nbProcessedEdges;
+        my_progress_bar += nbProcessedEdgesCopy - my_progress_bar.count();
+      }
     }
+    my_progress_bar += vec_edges.size() - my_progress_bar.count();
+
     // Merge thread estimates
-    for(const auto vec : initial_estimates)
+    for(const auto& vec : initial_estimates)
     {
-      for(const auto val : vec)
+      for(const auto& val : vec)
       {
         vec_initialEstimates.emplace_back(val);
       }
     }
+
+    // Merge thread pairwise matches
+    for(auto& threadPairMatches : newpairMatchesPerThread)
+    {
+      for(auto& pairMatches : threadPairMatches)
+      {
+        for(auto& descMatches : pairMatches.second)
+        {
+          matching::IndMatches & matches = newpairMatches[pairMatches.first][descMatches.first];
+          matches.insert(matches.end(), descMatches.second.begin(), descMatches.second.end());
+        }
+      }
+      threadPairMatches.clear();
+    }
   }
 
 
@@ -590,7 +634,7 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   const SfMData& sfmData,
   const HashMap<IndexT, Mat3>& map_globalR,
   const feature::FeaturesPerView& normalizedFeaturesPerView,
-  const matching::PairwiseMatches& pairwiseMatches,
+  const matching::PairwiseMatches& tripletMatches,
   const graph::Triplet& poses_id,
   std::mt19937 & randomNumberGenerator,
   std::vector<Vec3>& vec_tis,
@@ -599,26 +643,8 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   aliceVision::track::TracksMap& tracks,
   const std::string& outDirectory) const
 {
-  // List matches that belong to the triplet of poses
-  matching::PairwiseMatches map_triplet_matches;
-  const std::set<IndexT> set_pose_ids = {poses_id.i, poses_id.j, poses_id.k};
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
-  {
-    const Pair& pair = match_iterator.first;
-    const View* v1 = sfmData.getViews().at(pair.first).get();
-    const View* v2 = sfmData.getViews().at(pair.second).get();
-    if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-        (v1->getPoseId() != v2->getPoseId())
-        && set_pose_ids.count(v1->getPoseId())
-        && set_pose_ids.count(v2->getPoseId()))
-    {
-      map_triplet_matches.insert( match_iterator );
-    }
-  }
-
   aliceVision::track::TracksBuilder tracksBuilder;
-  tracksBuilder.build(map_triplet_matches);
+  tracksBuilder.build(tripletMatches);
   tracksBuilder.filter(true,3);
   tracksBuilder.exportToSTL(tracks);
 
@@ -705,7 +731,7 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   tiny_scene.poses[poses_id.k] = Pose3(vec_global_R_Triplet[2], -vec_global_R_Triplet[2].transpose() * vec_tis[2]);
 
   // insert views used by the relative pose pairs
-  for (const auto & pairIterator : map_triplet_matches )
+  for (const auto & pairIterator : tripletMatches )
   {
     // initialize camera indexes
     const IndexT I = pairIterator.first.first;
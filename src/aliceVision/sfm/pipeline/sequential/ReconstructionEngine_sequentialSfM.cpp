@@ -20,6 +20,7 @@
 #include <aliceVision/multiview/essential.hpp>
 #include <aliceVision/multiview/triangulation/triangulationDLT.hpp>
 #include <aliceVision/multiview/triangulation/Triangulation.hpp>
+#include <aliceVision/multiview/triangulation/TriangulationBatch.hpp>
 #include <aliceVision/multiview/triangulation/NViewsTriangulationLORansac.hpp>
 #include <aliceVision/robustEstimation/LORansac.hpp>
 #include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
@@ -1664,165 +1665,148 @@ void ReconstructionEngine_sequentialSfM::triangulate_multiViewsLORANSAC(SfMData&
   // These tracks are seen by at least one new reconstructed view.  
   std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, observations> 
   getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, mapTracksToTriangulate);
-  
-  std::vector<IndexT> setTracksId; // <trackId>
-  std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
-                 std::inserter(setTracksId, setTracksId.begin()),
-                 stl::RetrieveKey());
 
-#pragma omp parallel for 
-  for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
+  // -- Prepare:
+  // one projective matrix per reconstructed view
+  std::map<IndexT, std::size_t> cameraIndexPerView;
+  multiview::TriangulationBatch batch;
+  for(const std::set<IndexT>* views : {&previousReconstructedViews, &newReconstructedViews})
   {
-    const IndexT trackId = setTracksId.at(i);
-    bool isValidTrack = true;
-    const track::Track& track = _map_tracks.at(trackId);
-    std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
-    
-    // The track needs to be seen by a min. number of views to be triangulated
-    if (observations.size() < _params.minNbObservationsForTriangulation)
-      continue;
-    
-    Vec3 X_euclidean = Vec3::Zero();
-    std::set<IndexT> inliers;
-    
-    if (observations.size() == 2) 
+    for(const IndexT viewId : *views)
     {
-      /* --------------------------------------------
-       *    2 observations : triangulation using DLT
-       * -------------------------------------------- */ 
-       
-      inliers = observations;
-      
-      // -- Prepare:
-      IndexT I =  *(observations.begin());
-      IndexT J =  *(observations.rbegin());
-      const View* viewI = scene.getViews().at(I).get();
-      const View* viewJ = scene.getViews().at(J).get();
-
-      std::shared_ptr<camera::IntrinsicBase> camI = scene.getIntrinsics().at(viewI->getIntrinsicId());
-      std::shared_ptr<camera::Pinhole> camIPinHole = std::dynamic_pointer_cast<camera::Pinhole>(camI);
-      if (!camIPinHole) {
+      const View* view = scene.getViews().at(viewId).get();
+      const camera::Pinhole* camPinHole = dynamic_cast<const camera::Pinhole*>(scene.getIntrinsicPtr(view->getIntrinsicId()));
+      if(!camPinHole)
+      {
         ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
         continue;
       }
+      cameraIndexPerView[viewId] = batch.addCamera(camPinHole->getProjectiveEquivalent(scene.getPose(*view).getTransform()));
+    }
+  }
 
-      std::shared_ptr<camera::IntrinsicBase> camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId());
-      std::shared_ptr<camera::Pinhole> camJPinHole = std::dynamic_pointer_cast<camera::Pinhole>(camJ);
-      if (!camJPinHole) {
-        ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
+  // undistorted 2D features of each track (one per pose)
+  std::vector<IndexT> tracksId;
+  std::vector<IndexT> observationsViewId;
+  for(const auto& trackObservations : mapTracksToTriangulate)
+  {
+    // The track needs to be seen by a min. number of views to be triangulated,
+    // otherwise it is skipped and a previously reconstructed landmark is kept
+    if(trackObservations.second.size() < _params.minNbObservationsForTriangulation)
+      continue;
+
+    const track::Track& track = _map_tracks.at(trackObservations.first);
+    tracksId.push_back(trackObservations.first);
+    batch.addPoint();
+
+    for(const IndexT viewId : trackObservations.second)
+    {
+      const auto cameraIt = cameraIndexPerView.find(viewId);
+      if(cameraIt == cameraIndexPerView.end())
         continue;
-      }
 
+      const View* view = scene.getViews().at(viewId).get();
+      const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
+      batch.addObservation(cameraIt->second, scene.getIntrinsicPtr(view->getIntrinsicId())->get_ud_pixel(x));
+      observationsViewId.push_back(viewId);
+    }
+  }
+
+  // -- Triangulate:
+  //  - 2 observations : triangulation using DLT
+  //  - N observations (N>2) : triangulation using LORANSAC
+  multiview::TriangulationBatchOptions options;
+  options.useLORansac = true;
+  options.loRansacThreshold = 8.0;
+
+  std::vector<multiview::TriangulatedPoint> points;
+  std::vector<unsigned char> inliersPerObservation;
+  multiview::triangulateBatch(batch, options, _randomNumberGenerator, points, inliersPerObservation);
+
+  // -- Check:
+  std::vector<unsigned char> isValidTrack(tracksId.size(), 0);
+  std::vector<std::set<IndexT>> inliersPerTrack(tracksId.size());
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < tracksId.size(); ++i) // each track (already reconstructed or not)
+  {
+    const track::Track& track = _map_tracks.at(tracksId.at(i));
+    const Vec3& X_euclidean = points.at(i).X;
+    std::set<IndexT>& inliers = inliersPerTrack.at(i);
+
+    for(std::size_t o = batch.pointBegin(i); o < batch.pointEnd(i); ++o)
+    {
+      if(inliersPerObservation.at(o))
+        inliers.insert(observationsViewId.at(o));
+    }
+
+    // nb of cameras validating the track
+    if(inliers.size() < _params.minNbObservationsForTriangulation || inliers.size() < 2)
+      continue;
+
+    if(batch.pointEnd(i) - batch.pointBegin(i) == 2)
+    {
+      //  - angle (small angle leads imprecise triangulation)
+      //  - positive depth
+      //  - residual values
+      const IndexT I = *(inliers.begin());
+      const IndexT J = *(inliers.rbegin());
+      const View* viewI = scene.getViews().at(I).get();
+      const View* viewJ = scene.getViews().at(J).get();
+      const camera::IntrinsicBase* camI = scene.getIntrinsicPtr(viewI->getIntrinsicId());
+      const camera::IntrinsicBase* camJ = scene.getIntrinsicPtr(viewJ->getIntrinsicId());
       const Pose3 poseI = scene.getPose(*viewI).getTransform();
       const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
       const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
       const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
-  
-      // -- Triangulate:
-      multiview::TriangulateDLT(camIPinHole->getProjectiveEquivalent(poseI),
-                     camI->get_ud_pixel(xI),
-                     camJPinHole->getProjectiveEquivalent(poseJ),
-                     camI->get_ud_pixel(xJ),
-                     &X_euclidean);
-
-      // -- Check:
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth
-      //  - residual values
+
       // TODO assert(acThresholdIt != _map_ACThreshold.end());
       const auto& acThresholdItI = _map_ACThreshold.find(I);
       const auto& acThresholdItJ = _map_ACThreshold.find(J);
       const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
       const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
-      
-      if (angleBetweenRays(poseI, camI.get(), poseJ, camJ.get(), xI, xJ) < _params.minAngleForTriangulation ||
-          poseI.depth(X_euclidean) < 0 || 
-          poseJ.depth(X_euclidean) < 0 || 
-          camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI || 
+
+      if (angleBetweenRays(poseI, camI, poseJ, camJ, xI, xJ) < _params.minAngleForTriangulation ||
+          poseI.depth(X_euclidean) < 0 ||
+          poseJ.depth(X_euclidean) < 0 ||
+          camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI ||
           camJ->residual(poseJ, X_euclidean, xJ).norm() > acThresholdJ)
-        isValidTrack = false;
+        continue;
     }
-    else 
+    else
     {
-      /* -------------------------------------------------------
-       *    N obsevations (N>2) : triangulation using LORANSAC 
-       * ------------------------------------------------------- */ 
-     
-      // -- Prepare:
-      Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
-      std::vector<Mat34> Ps; // projective matrices (one per pose)
-      {
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        int i = 0;
-        for (const IndexT& viewId : observations)
-        {
-          const View* view = scene.getViews().at(viewId).get();
-  
-          std::shared_ptr<camera::IntrinsicBase> cam = scene.getIntrinsics().at(view->getIntrinsicId());
-          std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-          if (!camPinHole) {
-            ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
-            continue;
-          }
-
-          const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
-          features(0,i) = x_ud(0); 
-          features(1,i) = x_ud(1);  
-          Ps.push_back(camPinHole->getProjectiveEquivalent(scene.getPose(*view).getTransform()));
-          i++;
-        }
-      }
-      
-      // -- Triangulate: 
-      Vec4 X_homogeneous = Vec4::Zero();
-      std::vector<std::size_t> inliersIndex;
-      
-      multiview::TriangulateNViewLORANSAC(features, Ps, _randomNumberGenerator, &X_homogeneous, &inliersIndex, 8.0);
-      
-      homogeneousToEuclidean(X_homogeneous, &X_euclidean);     
-      
-      // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
-      for (const auto & id : inliersIndex)
-        inliers.insert(*std::next(observations.begin(), id));
-
-      // -- Check:
-      //  - nb of cameras validing the track 
       //  - angle (small angle leads imprecise triangulation)
       //  - positive depth (chierality)
-      if (inliers.size() < _params.minNbObservationsForTriangulation ||
-          !checkAngles(X_euclidean, inliers, scene, _params.minAngleForTriangulation) ||
+      if (!checkAngles(X_euclidean, inliers, scene, _params.minAngleForTriangulation) ||
           !checkChieralities(X_euclidean, inliers, scene))
-        isValidTrack = false;
-    }  
+        continue;
+    }
+    isValidTrack.at(i) = 1;
+  }
+
+  // -- Add the tringulated points to the scene
+  for(std::size_t i = 0; i < tracksId.size(); ++i)
+  {
+    const IndexT trackId = tracksId.at(i);
 
-    // -- Add the tringulated point to the scene
-    if (isValidTrack)
+    if(!isValidTrack.at(i))
     {
-      Landmark landmark;
-      landmark.X = X_euclidean;
-      landmark.descType = track.descType;
-      for (const IndexT & viewId : inliers) // add inliers as observations
-      {
-        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
-        const feature::PointFeature& p = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
-        const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : p.scale();
-        landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId), scale);
-      }
-#pragma omp critical
-      {
-        scene.structure[trackId] = landmark;
-      }      
+      scene.structure.erase(trackId);
+      continue;
     }
-    else
+
+    const track::Track& track = _map_tracks.at(trackId);
+    Landmark& landmark = scene.structure[trackId];
+    landmark = Landmark();
+    landmark.X = points.at(i).X;
+    landmark.descType = track.descType;
+    for (const IndexT & viewId : inliersPerTrack.at(i)) // add inliers as observations
     {
-#pragma omp critical
-      {
-        if (scene.structure.find(trackId) != scene.structure.end()) 
-          scene.structure.erase(trackId);
-      }
+      const feature::PointFeature& p = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
+      const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : p.scale();
+      landmark.observations[viewId] = Observation(p.coords().cast<double>(), track.featPerView.at(viewId), scale);
     }
-  } // for all shared tracks 
+  }
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -7,12 +7,11 @@
 
 #include "sfmTriangulation.hpp"
 #include <aliceVision/multiview/triangulation/Triangulation.hpp>
+#include <aliceVision/multiview/triangulation/TriangulationBatch.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
 #include <aliceVision/config.hpp>
 
-#include <boost/progress.hpp>
-
-#include <deque>
+#include <map>
 #include <memory>
 
 namespace aliceVision {
@@ -29,80 +28,92 @@ StructureComputation_blind::StructureComputation_blind(bool verbose)
   : StructureComputation_basis(verbose)
 {}
 
-void StructureComputation_blind::triangulate(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const
+/**
+ * @brief Gather the observations of the landmarks seen by views with a valid pose and a pinhole intrinsic
+ * @param[in] sfmData The scene
+ * @param[out] batch The observations of each landmark (in the structure order)
+ */
+static void fillTriangulationBatch(const sfmData::SfMData& sfmData, multiview::TriangulationBatch& batch)
 {
-  std::deque<IndexT> rejectedId;
-  std::unique_ptr<boost::progress_display> my_progress_bar;
-  if (_bConsoleVerbose)
-    my_progress_bar.reset( new boost::progress_display(
-    sfmData.structure.size(),
-    std::cout,
-    "Blind triangulation progress:\n" ));
-  #pragma omp parallel
-  for(sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
-    iterTracks != sfmData.structure.end();
-    ++iterTracks)
+  batch.clear();
+
+  // one projection matrix per view
+  std::map<IndexT, std::size_t> cameraIndexPerView;
+  for(const auto& viewPair : sfmData.getViews())
   {
-    #pragma omp single nowait
+    const sfmData::View* view = viewPair.second.get();
+    if(!sfmData.isPoseAndIntrinsicDefined(view))
+      continue;
+
+    const camera::Pinhole* pinHoleCam = dynamic_cast<const camera::Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()));
+    if(!pinHoleCam)
     {
-      if (_bConsoleVerbose)
-      {
-        #pragma omp critical
-        ++(*my_progress_bar);
-      }
-      // Triangulate each landmark
-      multiview::Triangulation trianObj;
-      const sfmData::Observations & observations = iterTracks->second.observations;
-      for(const auto& itObs : observations)
-      {
-        const sfmData::View * view = sfmData.views.at(itObs.first).get();
-        if (sfmData.isPoseAndIntrinsicDefined(view))
-        {
-          std::shared_ptr<IntrinsicBase> cam = sfmData.getIntrinsics().at(view->getIntrinsicId());
-          std::shared_ptr<camera::Pinhole> pinHoleCam = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-          if (!pinHoleCam) {
-            ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate");
-            continue;
-          }
-
-          const Pose3 pose = sfmData.getPose(*view).getTransform();
-          trianObj.add(
-            pinHoleCam->getProjectiveEquivalent(pose),
-            cam->get_ud_pixel(itObs.second.x));
-        }
-      }
-      if (trianObj.size() < 2)
-      {
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
-      }
-      else
-      {
-        // Compute the 3D point
-        const Vec3 X = trianObj.compute();
-        if (trianObj.minDepth() > 0) // Keep the point only if it have a positive depth
-        {
-          iterTracks->second.X = X;
-        }
-        else
-        {
-          #pragma omp critical
-          {
-            rejectedId.push_front(iterTracks->first);
-          }
-        }
-      }
+      ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate");
+      continue;
     }
+    cameraIndexPerView[viewPair.first] = batch.addCamera(pinHoleCam->getProjectiveEquivalent(sfmData.getPose(*view).getTransform()));
   }
-  // Erase the unsuccessful triangulated tracks
-  for (auto& it : rejectedId)
+
+  for(const auto& landmarkPair : sfmData.structure)
   {
-    sfmData.structure.erase(it);
+    batch.addPoint();
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto cameraIt = cameraIndexPerView.find(observationPair.first);
+      if(cameraIt == cameraIndexPerView.end())
+        continue;
+
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      batch.addObservation(cameraIt->second, sfmData.getIntrinsicPtr(view.getIntrinsicId())->get_ud_pixel(observationPair.second.x));
+    }
   }
 }
 
+/**
+ * @brief Triangulate all the landmarks of the scene and remove the unsuccessful ones
+ * @param[in,out] sfmData The scene
+ * @param[in] options The triangulation options
+ * @param[in] minNbInliers The minimal number of inlier observations of a landmark
+ * @param[in] randomNumberGenerator The random number generator
+ */
+static void triangulateStructure(sfmData::SfMData& sfmData,
+                                 const multiview::TriangulationBatchOptions& options,
+                                 std::size_t minNbInliers,
+                                 std::mt19937& randomNumberGenerator)
+{
+  multiview::TriangulationBatch batch;
+  fillTriangulationBatch(sfmData, batch);
+
+  std::vector<multiview::TriangulatedPoint> points;
+  std::vector<unsigned char> inliers;
+  multiview::triangulateBatch(batch, options, randomNumberGenerator, points, inliers);
+
+  std::size_t i = 0;
+  for(sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin(); iterTracks != sfmData.structure.end(); ++i)
+  {
+    const multiview::TriangulatedPoint& point = points[i];
+
+    // Keep the point only if it has enough inliers with a positive depth
+    if(point.nbInliers >= minNbInliers && point.minDepth > 0)
+    {
+      iterTracks->second.X = point.X;
+      ++iterTracks;
+    }
+    else
+    {
+      iterTracks = sfmData.structure.erase(iterTracks);
+    }
+  }
+}
+
+void StructureComputation_blind::triangulate(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const
+{
+  if(_bConsoleVerbose)
+    ALICEVISION_LOG_INFO("Blind triangulation of " << sfmData.structure.size() << " landmarks.");
+
+  triangulateStructure(sfmData, multiview::TriangulationBatchOptions(), 2, randomNumberGenerator);
+}
+
 StructureComputation_robust::StructureComputation_robust(bool verbose)
   : StructureComputation_basis(verbose)
 {}
@@ -117,43 +128,15 @@ void StructureComputation_robust::triangulate(sfmData::SfMData& sfmData, std::mt
 /// Invalid landmark are removed.
 void StructureComputation_robust::robust_triangulation(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const
 {
-  std::deque<IndexT> rejectedId;
-  std::unique_ptr<boost::progress_display> my_progress_bar;
   if(_bConsoleVerbose)
-    my_progress_bar.reset( new boost::progress_display(
-    sfmData.structure.size(),
-    std::cout,
-    "Robust triangulation progress:\n" ));
-  #pragma omp parallel
-  for(sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
-    iterTracks != sfmData.structure.end();
-    ++iterTracks)
-  {
-    #pragma omp single nowait
-    {
-      if (_bConsoleVerbose)
-      {
-        #pragma omp critical
-        ++(*my_progress_bar);
-      }
-      Vec3 X;
-      if (robust_triangulation(sfmData, iterTracks->second.observations, randomNumberGenerator, X)) {
-        iterTracks->second.X = X;
-      }
-      else {
-        iterTracks->second.X = Vec3::Zero();
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
-      }
-    }
-  }
-  // Erase the unsuccessful triangulated tracks
-  for(auto& it : rejectedId)
-  {
-    sfmData.structure.erase(it);
-  }
+    ALICEVISION_LOG_INFO("Robust triangulation of " << sfmData.structure.size() << " landmarks.");
+
+  // A point must be seen in at least 3 views
+  multiview::TriangulationBatchOptions options;
+  options.useLORansac = true;
+  options.loRansacThreshold = 4.0; // TODO: make this parameter customizable
+
+  triangulateStructure(sfmData, options, 3, randomNumberGenerator);
 }
 
 /// Robustly try to estimate the best 3D point using a ransac Scheme
@@ -6,10 +6,14 @@
 
 #include "jsonIO.hpp"
 #include <aliceVision/camera/camera.hpp>
+#include <aliceVision/sfmDataIO/jsonStream.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
-#include <boost/property_tree/json_parser.hpp>
-
+#include <algorithm>
+#include <exception>
+#include <fstream>
 #include <memory>
 #include <cassert>
 
@@ -312,6 +316,708 @@ void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& l
 }
 
 
+namespace {
+
+/// number of elements formatted by a thread in a single fragment
+const std::size_t writeChunkSize = 512;
+
+void writeView(JsonWriter& writer, const sfmData::View& view)
+{
+  writer.beginObject();
+
+  if(view.getViewId() != UndefinedIndexT)
+    writer.write("viewId", view.getViewId());
+
+  if(view.getPoseId() != UndefinedIndexT)
+    writer.write("poseId", view.getPoseId());
+
+  if(view.isPartOfRig())
+  {
+    writer.write("rigId", view.getRigId());
+    writer.write("subPoseId", view.getSubPoseId());
+  }
+
+  if(view.getFrameId() != UndefinedIndexT)
+    writer.write("frameId", view.getFrameId());
+
+  if(view.getIntrinsicId() != UndefinedIndexT)
+    writer.write("intrinsicId", view.getIntrinsicId());
+
+  if(view.getResectionId() != UndefinedIndexT)
+    writer.write("resectionId", view.getResectionId());
+
+  if(view.isPoseIndependant() == false)
+    writer.write("isPoseIndependant", view.isPoseIndependant());
+
+  writer.write("path", view.getImagePath());
+  writer.write("width", view.getWidth());
+  writer.write("height", view.getHeight());
+
+  // metadata
+  {
+    const std::map<std::string, std::string>& metadata = view.getMetadata();
+
+    // with saveView, metadata names are property tree paths:
+    // fallback on a property tree to keep the same output for names with a path separator
+    const bool isFlat = std::none_of(metadata.begin(), metadata.end(), [](const std::pair<const std::string, std::string>& metadataPair) {
+      return metadataPair.first.empty() || metadataPair.first.find('.') != std::string::npos;
+    });
+
+    if(isFlat)
+    {
+      writer.beginObject("metadata");
+      for(const auto& metadataPair : metadata)
+        writer.write(metadataPair.first, metadataPair.second);
+      writer.endObject();
+    }
+    else
+    {
+      bpt::ptree metadataTree;
+      for(const auto& metadataPair : metadata)
+        metadataTree.put(metadataPair.first, metadataPair.second);
+      writer.writeTree("metadata", metadataTree);
+    }
+  }
+
+  writer.endObject();
+}
+
+void writeIntrinsic(JsonWriter& writer, IndexT intrinsicId, const std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  writer.beginObject();
+
+  camera::EINTRINSIC intrinsicType = intrinsic->getType();
+
+  writer.write("intrinsicId", intrinsicId);
+  writer.write("width", intrinsic->w());
+  writer.write("height", intrinsic->h());
+  writer.write("sensorWidth", intrinsic->sensorWidth());
+  writer.write("sensorHeight", intrinsic->sensorHeight());
+  writer.write("serialNumber", intrinsic->serialNumber());
+  writer.write("type", camera::EINTRINSIC_enumToString(intrinsicType));
+  writer.write("initializationMode", camera::EIntrinsicInitMode_enumToString(intrinsic->getInitializationMode()));
+
+  std::shared_ptr<camera::IntrinsicsScaleOffset> intrinsicScaleOffset = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffset>(intrinsic);
+  if(intrinsicScaleOffset)
+  {
+    writer.write("pxInitialFocalLength", intrinsicScaleOffset->initialScale());
+    writer.write("pxFocalLength", intrinsicScaleOffset->getScale()(0));
+    writer.writeMatrix("principalPoint", intrinsicScaleOffset->getOffset());
+  }
+
+  std::shared_ptr<camera::IntrinsicsScaleOffsetDisto> intrinsicScaleOffsetDisto = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffsetDisto>(intrinsic);
+  if(intrinsicScaleOffsetDisto)
+  {
+    writer.beginArray("distortionParams");
+    for(double param : intrinsicScaleOffsetDisto->getDistortionParams())
+      writer.write("", param);
+    writer.endArray();
+  }
+
+  std::shared_ptr<camera::EquiDistant> intrinsicEquidistant = std::dynamic_pointer_cast<camera::EquiDistant>(intrinsic);
+  if(intrinsicEquidistant)
+  {
+    writer.write("fisheyeCircleCenterX", intrinsicEquidistant->getCircleCenterX());
+    writer.write("fisheyeCircleCenterY", intrinsicEquidistant->getCircleCenterY());
+    writer.write("fisheyeCircleRadius", intrinsicEquidistant->getCircleRadius());
+  }
+
+  writer.write("locked", static_cast<int>(intrinsic->isLocked())); // convert bool to integer to avoid using "true/false" in exported file instead of "1/0".
+
+  writer.endObject();
+}
+
+void writePose3(JsonWriter& writer, const std::string& name, const geometry::Pose3& pose)
+{
+  writer.beginObject(name);
+  writer.writeMatrix("rotation", pose.rotation());
+  writer.writeMatrix("center", pose.center());
+  writer.endObject();
+}
+
+void writeRig(JsonWriter& writer, IndexT rigId, const sfmData::Rig& rig)
+{
+  writer.beginObject();
+  writer.write("rigId", rigId);
+  writer.beginArray("subPoses");
+
+  for(const auto& rigSubPose : rig.getSubPoses())
+  {
+    writer.beginObject();
+    writer.write("status", sfmData::ERigSubPoseStatus_enumToString(rigSubPose.status));
+    writePose3(writer, "pose", rigSubPose.pose);
+    writer.endObject();
+  }
+
+  writer.endArray();
+  writer.endObject();
+}
+
+void writeLandmark(JsonWriter& writer, IndexT landmarkId, const sfmData::Landmark& landmark, bool saveObservations, bool saveFeatures)
+{
+  writer.beginObject();
+  writer.write("landmarkId", landmarkId);
+  writer.write("descType", feature::EImageDescriberType_enumToString(landmark.descType));
+  writer.writeMatrix("color", landmark.rgb);
+  writer.writeMatrix("X", landmark.X);
+
+  // observations
+  if(saveObservations)
+  {
+    writer.beginArray("observations");
+    for(const auto& obsPair : landmark.observations)
+    {
+      const sfmData::Observation& observation = obsPair.second;
+
+      writer.beginObject();
+      writer.write("observationId", obsPair.first);
+
+      // features
+      if(saveFeatures)
+      {
+        writer.write("featureId", observation.id_feat);
+        writer.writeMatrix("x", observation.x);
+        writer.write("scale", observation.scale);
+      }
+      writer.endObject();
+    }
+    writer.endArray();
+  }
+
+  writer.endObject();
+}
+
+/**
+ * @brief Write the elements of a map in the current array of a writer.
+ *        Elements are formatted by chunks in parallel and appended in the map order.
+ * @param[in,out] writer The document writer
+ * @param[in] map The input map
+ * @param[in] writeElement The function writing one map element in a writer
+ */
+template<typename MapT, typename WriteFunction>
+void writeMapElements(JsonWriter& writer, const MapT& map, WriteFunction writeElement)
+{
+  std::vector<const typename MapT::value_type*> elements;
+  elements.reserve(map.size());
+  for(const auto& element : map)
+    elements.push_back(&element);
+
+  const std::size_t nbChunks = (elements.size() + writeChunkSize - 1) / writeChunkSize;
+  const std::size_t nbChunksPerBlock = 4 * omp_get_max_threads();
+
+  // bound the memory used by the formatted fragments
+  std::vector<std::string> fragments(std::min(nbChunks, nbChunksPerBlock));
+
+  // exceptions cannot cross the OpenMP parallel region
+  std::exception_ptr error;
+
+  for(std::size_t blockBegin = 0; blockBegin < nbChunks; blockBegin += nbChunksPerBlock)
+  {
+    const int blockSize = static_cast<int>(std::min(nbChunksPerBlock, nbChunks - blockBegin));
+
+    #pragma omp parallel for
+    for(int c = 0; c < blockSize; ++c)
+    {
+      const std::size_t begin = (blockBegin + c) * writeChunkSize;
+      const std::size_t end = std::min(begin + writeChunkSize, elements.size());
+
+      std::string& fragment = fragments.at(c);
+      fragment.clear();
+
+      try
+      {
+        JsonWriter fragmentWriter(fragment, writer.depth(), true);
+        for(std::size_t i = begin; i < end; ++i)
+          writeElement(fragmentWriter, *elements.at(i));
+      }
+      catch(...)
+      {
+        #pragma omp critical(writeMapElementsError)
+        {
+          if(!error)
+            error = std::current_exception();
+        }
+      }
+    }
+
+    if(error)
+      std::rethrow_exception(error);
+
+    for(int c = 0; c < blockSize; ++c)
+      writer.appendFragment(fragments.at(c));
+  }
+}
+
+void readView(JsonReader& reader, sfmData::View& view)
+{
+  IndexT rigId = UndefinedIndexT;
+  IndexT subPoseId = UndefinedIndexT;
+  bool hasRig = false;
+  bool hasPath = false;
+  std::string key;
+
+  view.setIndependantPose(true);
+
+  if(!reader.enterObject())
+    reader.throwError("No such node (path)");
+
+  while(reader.nextMember(key))
+  {
+    if(key == "viewId")
+      view.setViewId(reader.readUnsigned<IndexT>());
+    else if(key == "poseId")
+      view.setPoseId(reader.readUnsigned<IndexT>());
+    else if(key == "rigId")
+    {
+      rigId = reader.readUnsigned<IndexT>();
+      hasRig = true;
+    }
+    else if(key == "subPoseId")
+      subPoseId = reader.readUnsigned<IndexT>();
+    else if(key == "frameId")
+      view.setFrameId(reader.readUnsigned<IndexT>());
+    else if(key == "intrinsicId")
+      view.setIntrinsicId(reader.readUnsigned<IndexT>());
+    else if(key == "resectionId")
+      view.setResectionId(reader.readUnsigned<IndexT>());
+    else if(key == "isPoseIndependant")
+      view.setIndependantPose(reader.readBool());
+    else if(key == "path")
+    {
+      view.setImagePath(reader.readString());
+      hasPath = true;
+    }
+    else if(key == "width")
+      view.setWidth(reader.readUnsigned<std::size_t>());
+    else if(key == "height")
+      view.setHeight(reader.readUnsigned<std::size_t>());
+    else if(key == "metadata")
+    {
+      std::string metadataName;
+      if(reader.enterObject())
+        while(reader.nextMember(metadataName))
+          view.addMetadata(metadataName, reader.readString());
+    }
+    else
+      reader.skipValue();
+  }
+
+  if(!hasPath)
+    reader.throwError("No such node (path)");
+
+  if(hasRig)
+  {
+    if(subPoseId == UndefinedIndexT)
+      reader.throwError("No such node (subPoseId)");
+    view.setRigAndSubPoseId(rigId, subPoseId);
+  }
+}
+
+void readIntrinsic(JsonReader& reader, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  // all the members are read before the intrinsic creation, as its type can be anywhere in the object
+  intrinsicId = UndefinedIndexT;
+  unsigned int width = 0;
+  unsigned int height = 0;
+  double sensorWidth = 36.0;
+  double sensorHeight = 24.0;
+  std::string type;
+  std::string serialNumber;
+  camera::EIntrinsicInitMode initializationMode = camera::EIntrinsicInitMode::CALIBRATED;
+  double pxFocalLength = 0.0;
+  double pxInitialFocalLength = 0.0;
+  Vec2 principalPoint;
+  std::vector<double> distortionParams;
+  double fisheyeCircleCenterX = 0.0;
+  double fisheyeCircleCenterY = 0.0;
+  double fisheyeCircleRadius = 1.0;
+  bool locked = false;
+
+  // required members
+  enum : int {ID = 1, WIDTH = 2, HEIGHT = 4, TYPE = 8, FOCAL = 16, PRINCIPAL_POINT = 32, SERIAL = 64, INITIAL_FOCAL = 128, DISTORTION = 256};
+  int loaded = 0;
+
+  std::string key;
+  if(!reader.enterObject())
+    reader.throwError("No such node (intrinsicId)");
+
+  while(reader.nextMember(key))
+  {
+    if(key == "intrinsicId")
+    {
+      intrinsicId = reader.readUnsigned<IndexT>();
+      loaded |= ID;
+    }
+    else if(key == "width")
+    {
+      width = reader.readUnsigned<unsigned int>();
+      loaded |= WIDTH;
+    }
+    else if(key == "height")
+    {
+      height = reader.readUnsigned<unsigned int>();
+      loaded |= HEIGHT;
+    }
+    else if(key == "sensorWidth")
+      sensorWidth = reader.readDouble();
+    else if(key == "sensorHeight")
+      sensorHeight = reader.readDouble();
+    else if(key == "serialNumber")
+    {
+      serialNumber = reader.readString();
+      loaded |= SERIAL;
+    }
+    else if(key == "type")
+    {
+      type = reader.readString();
+      loaded |= TYPE;
+    }
+    else if(key == "initializationMode")
+      initializationMode = camera::EIntrinsicInitMode_stringToEnum(reader.readString());
+    else if(key == "pxFocalLength")
+    {
+      pxFocalLength = reader.readDouble();
+      loaded |= FOCAL;
+    }
+    else if(key == "pxInitialFocalLength")
+    {
+      pxInitialFocalLength = reader.readDouble();
+      loaded |= INITIAL_FOCAL;
+    }
+    else if(key == "principalPoint")
+    {
+      reader.readMatrix(principalPoint);
+      loaded |= PRINCIPAL_POINT;
+    }
+    else if(key == "distortionParams")
+    {
+      if(reader.enterArray())
+        while(reader.nextElement())
+          distortionParams.push_back(reader.readDouble());
+      loaded |= DISTORTION;
+    }
+    else if(key == "fisheyeCircleCenterX")
+      fisheyeCircleCenterX = reader.readDouble();
+    else if(key == "fisheyeCircleCenterY")
+      fisheyeCircleCenterY = reader.readDouble();
+    else if(key == "fisheyeCircleRadius")
+      fisheyeCircleRadius = reader.readDouble();
+    else if(key == "locked")
+      locked = reader.readBool();
+    else
+      reader.skipValue();
+  }
+
+  const int required = ID | WIDTH | HEIGHT | TYPE | FOCAL | PRINCIPAL_POINT | SERIAL;
+  if((loaded & required) != required)
+    reader.throwError("Missing intrinsic parameter");
+
+  // pinhole parameters
+  intrinsic = camera::createIntrinsic(camera::EINTRINSIC_stringToEnum(type), width, height, pxFocalLength, principalPoint(0), principalPoint(1));
+
+  intrinsic->setSerialNumber(serialNumber);
+  intrinsic->setInitializationMode(initializationMode);
+  intrinsic->setSensorWidth(sensorWidth);
+  intrinsic->setSensorHeight(sensorHeight);
+
+  // intrinsic lock
+  if(locked)
+    intrinsic->lock();
+  else
+    intrinsic->unlock();
+
+  std::shared_ptr<camera::IntrinsicsScaleOffset> intrinsicWithScale = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffset>(intrinsic);
+  if(intrinsicWithScale != nullptr)
+  {
+    if(!(loaded & INITIAL_FOCAL))
+      reader.throwError("No such node (pxInitialFocalLength)");
+    intrinsicWithScale->setInitialScale(pxInitialFocalLength);
+  }
+
+  // load distortion
+  std::shared_ptr<camera::IntrinsicsScaleOffsetDisto> intrinsicWithDistoEnabled = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffsetDisto>(intrinsic);
+  if(intrinsicWithDistoEnabled != nullptr)
+  {
+    if(!(loaded & DISTORTION))
+      reader.throwError("No such node (distortionParams)");
+
+    // ensure that we have the right number of params
+    distortionParams.resize(intrinsicWithDistoEnabled->getDistortionParams().size(), 0.0);
+    intrinsicWithDistoEnabled->setDistortionParams(distortionParams);
+  }
+
+  // load EquiDistant params
+  std::shared_ptr<camera::EquiDistant> intrinsicEquiDistant = std::dynamic_pointer_cast<camera::EquiDistant>(intrinsic);
+  if(intrinsicEquiDistant != nullptr)
+  {
+    intrinsicEquiDistant->setCircleCenterX(fisheyeCircleCenterX);
+    intrinsicEquiDistant->setCircleCenterY(fisheyeCircleCenterY);
+    intrinsicEquiDistant->setCircleRadius(fisheyeCircleRadius);
+  }
+}
+
+void readPose3(JsonReader& reader, geometry::Pose3& pose)
+{
+  Mat3 rotation;
+  Vec3 center;
+  bool hasRotation = false;
+  bool hasCenter = false;
+  std::string key;
+
+  if(reader.enterObject())
+  {
+    while(reader.nextMember(key))
+    {
+      if(key == "rotation")
+      {
+        reader.readMatrix(rotation);
+        hasRotation = true;
+      }
+      else if(key == "center")
+      {
+        reader.readMatrix(center);
+        hasCenter = true;
+      }
+      else
+        reader.skipValue();
+    }
+  }
+
+  if(!hasRotation || !hasCenter)
+    reader.throwError("No such node (rotation / center)");
+
+  pose = geometry::Pose3(rotation, center);
+}
+
+void readCameraPose(JsonReader& reader, IndexT& poseId, sfmData::CameraPose& cameraPose)
+{
+  bool hasPoseId = false;
+  std::string key;
+
+  if(reader.enterObject())
+  {
+    while(reader.nextMember(key))
+    {
+      if(key == "poseId")
+      {
+        poseId = reader.readUnsigned<IndexT>();
+        hasPoseId = true;
+      }
+      else if(key == "pose")
+      {
+        std::string poseKey;
+        if(reader.enterObject())
+        {
+          while(reader.nextMember(poseKey))
+          {
+            if(poseKey == "transform")
+            {
+              geometry::Pose3 pose;
+              readPose3(reader, pose);
+              cameraPose.setTransform(pose);
+            }
+            else if(poseKey == "locked")
+            {
+              if(reader.readBool())
+                cameraPose.lock();
+              else
+                cameraPose.unlock();
+            }
+            else
+              reader.skipValue();
+          }
+        }
+      }
+      else
+        reader.skipValue();
+    }
+  }
+
+  if(!hasPoseId)
+    reader.throwError("No such node (poseId)");
+}
+
+void readRig(JsonReader& reader, IndexT& rigId, sfmData::Rig& rig)
+{
+  std::vector<sfmData::RigSubPose> subPoses;
+  bool hasRigId = false;
+  std::string key;
+
+  if(reader.enterObject())
+  {
+    while(reader.nextMember(key))
+    {
+      if(key == "rigId")
+      {
+        rigId = reader.readUnsigned<IndexT>();
+        hasRigId = true;
+      }
+      else if(key == "subPoses")
+      {
+        if(!reader.enterArray())
+          continue;
+
+        while(reader.nextElement())
+        {
+          sfmData::RigSubPose subPose;
+          std::string subPoseKey;
+
+          if(reader.enterObject())
+          {
+            while(reader.nextMember(subPoseKey))
+            {
+              if(subPoseKey == "status")
+                subPose.status = sfmData::ERigSubPoseStatus_stringToEnum(reader.readString());
+              else if(subPoseKey == "pose")
+                readPose3(reader, subPose.pose);
+              else
+                reader.skipValue();
+            }
+          }
+          subPoses.push_back(subPose);
+        }
+      }
+      else
+        reader.skipValue();
+    }
+  }
+
+  if(!hasRigId)
+    reader.throwError("No such node (rigId)");
+
+  rig = sfmData::Rig(subPoses.size());
+  for(std::size_t subPoseId = 0; subPoseId < subPoses.size(); ++subPoseId)
+    rig.setSubPose(subPoseId, subPoses.at(subPoseId));
+}
+
+void readLandmark(JsonReader& reader, IndexT& landmarkId, sfmData::Landmark& landmark, bool loadObservations, bool loadFeatures)
+{
+  enum : int {ID = 1, DESC_TYPE = 2, COLOR = 4, POSITION = 8, OBSERVATIONS = 16};
+  int loaded = 0;
+  std::string key;
+
+  if(reader.enterObject())
+  {
+    while(reader.nextMember(key))
+    {
+      if(key == "landmarkId")
+      {
+        landmarkId = reader.readUnsigned<IndexT>();
+        loaded |= ID;
+      }
+      else if(key == "descType")
+      {
+        landmark.descType = feature::EImageDescriberType_stringToEnum(reader.readString());
+        loaded |= DESC_TYPE;
+      }
+      else if(key == "color")
+      {
+        reader.readMatrix(landmark.rgb);
+        loaded |= COLOR;
+      }
+      else if(key == "X")
+      {
+        reader.readMatrix(landmark.X);
+        loaded |= POSITION;
+      }
+      else if(key == "observations" && loadObservations)
+      {
+        loaded |= OBSERVATIONS;
+
+        if(!reader.enterArray())
+          continue;
+
+        std::string obsKey;
+        while(reader.nextElement())
+        {
+          IndexT observationId = UndefinedIndexT;
+          bool hasObservationId = false;
+          bool hasFeatureId = false;
+          bool hasPosition = false;
+          sfmData::Observation observation;
+
+          if(reader.enterObject())
+          {
+            while(reader.nextMember(obsKey))
+            {
+              if(obsKey == "observationId")
+              {
+                observationId = reader.readUnsigned<IndexT>();
+                hasObservationId = true;
+              }
+              else if(loadFeatures && obsKey == "featureId")
+              {
+                observation.id_feat = reader.readUnsigned<IndexT>();
+                hasFeatureId = true;
+              }
+              else if(loadFeatures && obsKey == "x")
+              {
+                reader.readMatrix(observation.x);
+                hasPosition = true;
+              }
+              else if(loadFeatures && obsKey == "scale")
+                observation.scale = reader.readDouble();
+              else
+                reader.skipValue();
+            }
+          }
+
+          if(!hasObservationId || (loadFeatures && (!hasFeatureId || !hasPosition)))
+            reader.throwError("Missing observation parameter");
+
+          // observations are written sorted: insertion at the end in O(1)
+          landmark.observations.emplace_hint(landmark.observations.end(), observationId, observation);
+        }
+      }
+      else
+        reader.skipValue();
+    }
+  }
+
+  const int required = ID | DESC_TYPE | COLOR | POSITION | (loadObservations ? OBSERVATIONS : 0);
+  if((loaded & required) != required)
+    reader.throwError("Missing landmark parameter");
+}
+
+/**
+ * @brief Read the elements of an array in parallel.
+ * @param[in] ranges The element ranges in the document
+ * @param[in] documentBegin The document begin
+ * @param[out] elements The output elements
+ * @param[in] readElement The function reading one element from a reader
+ */
+template<typename T, typename ReadFunction>
+void readElements(const std::vector<JsonReader::Range>& ranges, const char* documentBegin, std::vector<T>& elements, ReadFunction readElement)
+{
+  elements.resize(ranges.size());
+
+  // exceptions cannot cross the OpenMP parallel region
+  std::exception_ptr error;
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < ranges.size(); ++i)
+  {
+    try
+    {
+      JsonReader reader(ranges.at(i), documentBegin);
+      readElement(reader, elements.at(i));
+    }
+    catch(...)
+    {
+      #pragma omp critical(readElementsError)
+      {
+        if(!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
+}
+
+} // namespace
+
 bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
   const Vec3 version = {1, 0, 0};
@@ -325,121 +1031,107 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
   const bool saveFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
   const bool saveObservations = saveFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
 
+  std::ofstream stream(filename, std::ios::binary);
+
+  if(!stream.is_open())
+    ALICEVISION_THROW_ERROR("Cannot open the JSON file for writing: " << filename);
 
-  // main tree
-  bpt::ptree fileTree;
+  // the document is streamed in the same layout as boost::property_tree::write_json
+  JsonWriter writer(stream);
+  writer.beginDocument();
 
   // file version
-  saveMatrix("version", version, fileTree);
+  writer.writeMatrix("version", version);
 
   // folders
   if(!sfmData.getRelativeFeaturesFolders().empty())
   {
-    bpt::ptree featureFoldersTree;
-
+    writer.beginArray("featuresFolders");
     for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
-    {
-      bpt::ptree featureFolderTree;
-      featureFolderTree.put("", featuresFolder);
-      featureFoldersTree.push_back(std::make_pair("", featureFolderTree));
-    }
-
-    fileTree.add_child("featuresFolders", featureFoldersTree);
+      writer.write("", featuresFolder);
+    writer.endArray();
   }
 
   if(!sfmData.getRelativeMatchesFolders().empty())
   {
-    bpt::ptree matchingFoldersTree;
-
+    writer.beginArray("matchesFolders");
     for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
-    {
-      bpt::ptree matchingFolderTree;
-      matchingFolderTree.put("", matchesFolder);
-      matchingFoldersTree.push_back(std::make_pair("", matchingFolderTree));
-    }
-
-    fileTree.add_child("matchesFolders", matchingFoldersTree);
+      writer.write("", matchesFolder);
+    writer.endArray();
   }
 
   // views
   if(saveViews && !sfmData.getViews().empty())
   {
-    bpt::ptree viewsTree;
-
-    for(const auto& viewPair : sfmData.getViews())
-      saveView("", *(viewPair.second), viewsTree);
-
-    fileTree.add_child("views", viewsTree);
+    writer.beginArray("views");
+    writeMapElements(writer, sfmData.getViews(), [](JsonWriter& w, const sfmData::Views::value_type& viewPair) {
+      writeView(w, *(viewPair.second));
+    });
+    writer.endArray();
   }
 
   // intrinsics
   if(saveIntrinsics && !sfmData.getIntrinsics().empty())
   {
-    bpt::ptree intrinsicsTree;
-
+    writer.beginArray("intrinsics");
     for(const auto& intrinsicPair : sfmData.getIntrinsics())
-      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
-
-    fileTree.add_child("intrinsics", intrinsicsTree);
+      writeIntrinsic(writer, intrinsicPair.first, intrinsicPair.second);
+    writer.endArray();
   }
 
-  //extrinsics
+  // extrinsics
   if(saveExtrinsics)
   {
     // poses
     if(!sfmData.getPoses().empty())
     {
-      bpt::ptree posesTree;
-
+      writer.beginArray("poses");
       for(const auto& posePair : sfmData.getPoses())
       {
-        bpt::ptree poseTree;
-
-        poseTree.put("poseId", posePair.first);
-        saveCameraPose("pose", posePair.second, poseTree);
-        posesTree.push_back(std::make_pair("", poseTree));
+        writer.beginObject();
+        writer.write("poseId", posePair.first);
+        writer.beginObject("pose");
+        writePose3(writer, "transform", posePair.second.getTransform());
+        writer.write("locked", static_cast<int>(posePair.second.isLocked())); // convert bool to integer to avoid using "true/false" in exported file instead of "1/0".
+        writer.endObject();
+        writer.endObject();
       }
-
-      fileTree.add_child("poses", posesTree);
+      writer.endArray();
     }
 
     // rigs
     if(!sfmData.getRigs().empty())
     {
-      bpt::ptree rigsTree;
-
+      writer.beginArray("rigs");
       for(const auto& rigPair : sfmData.getRigs())
-        saveRig("", rigPair.first, rigPair.second, rigsTree);
-
-      fileTree.add_child("rigs", rigsTree);
+        writeRig(writer, rigPair.first, rigPair.second);
+      writer.endArray();
     }
   }
 
   // structure
   if(saveStructure && !sfmData.getLandmarks().empty())
   {
-    bpt::ptree structureTree;
-
-    for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree, saveObservations, saveFeatures);
-
-    fileTree.add_child("structure", structureTree);
+    writer.beginArray("structure");
+    writeMapElements(writer, sfmData.getLandmarks(), [&](JsonWriter& w, const sfmData::Landmarks::value_type& landmarkPair) {
+      writeLandmark(w, landmarkPair.first, landmarkPair.second, saveObservations, saveFeatures);
+    });
+    writer.endArray();
   }
 
   // control points
   if(saveControlPoints && !sfmData.getControlPoints().empty())
   {
-    bpt::ptree controlPointTree;
-
+    writer.beginArray("controlPoints");
     for(const auto& controlPointPair : sfmData.getControlPoints())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
-
-    fileTree.add_child("controlPoints", controlPointTree);
+      writeLandmark(writer, controlPointPair.first, controlPointPair.second, true, true);
+    writer.endArray();
   }
 
-  // write the json file with the tree
+  writer.endDocument();
 
-  bpt::write_json(filename, fileTree);
+  if(!stream.good())
+    ALICEVISION_THROW_ERROR("Cannot write the JSON file: " << filename);
 
   return true;
 }
@@ -447,8 +1139,6 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
 bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews,
               EViewIdMethod viewIdMethod, const std::string& viewIdRegex)
 {
-  Vec3 version;
-
   // load flags
   const bool loadViews = (partFlag & VIEWS) == VIEWS;
   const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
@@ -458,62 +1148,133 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
   const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
 
-  // main tree
-  bpt::ptree fileTree;
+  // read the whole file in memory, the document is parsed without property tree
+  std::string document;
+  {
+    std::ifstream stream(filename, std::ios::binary);
+
+    if(!stream.is_open())
+      ALICEVISION_THROW_ERROR("Cannot open the JSON file: " << filename);
+
+    stream.seekg(0, std::ios::end);
+    document.resize(static_cast<std::size_t>(stream.tellg()));
+    stream.seekg(0, std::ios::beg);
+    stream.read(&document[0], document.size());
+
+    if(!stream.good())
+      ALICEVISION_THROW_ERROR("Cannot read the JSON file: " << filename);
+  }
+
+  const char* documentBegin = document.data();
+  const char* documentEnd = documentBegin + document.size();
+
+  // first pass: locate each top-level member of the document,
+  // and each element of the large arrays parsed in parallel
+  std::map<std::string, JsonReader::Range> members;
+  std::vector<JsonReader::Range> viewElements;
+  std::vector<JsonReader::Range> landmarkElements;
+  {
+    JsonReader reader(documentBegin, documentEnd);
+    std::string key;
+
+    if(!reader.enterObject())
+      reader.throwError("expected '{'");
+
+    // keep the first occurrence of a member, as boost::property_tree does
+    while(reader.nextMember(key))
+    {
+      if(members.count(key))
+        reader.skipValue();
+      else if(key == "views" && loadViews)
+      {
+        members.emplace(key, JsonReader::Range());
+        reader.collectElements(viewElements);
+      }
+      else if(key == "structure" && loadStructure)
+      {
+        members.emplace(key, JsonReader::Range());
+        reader.collectElements(landmarkElements);
+      }
+      else
+        members.emplace(key, reader.skipValue());
+    }
+  }
+
+  const auto getMember = [&](const std::string& name, JsonReader::Range& range) {
+    const auto it = members.find(name);
+    if(it == members.end())
+      return false;
+    range = it->second;
+    return true;
+  };
 
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+  JsonReader::Range range;
 
   // version
-  loadMatrix("version", version, fileTree);
+  if(getMember("version", range))
+  {
+    Vec3 version;
+    JsonReader reader(range, documentBegin);
+    reader.readMatrix(version);
+  }
+  else
+  {
+    JsonReader(documentBegin, documentEnd).throwError("No such node (version)");
+  }
 
   // folders
-  if(fileTree.count("featuresFolders"))
-    for(bpt::ptree::value_type& featureFolderNode : fileTree.get_child("featuresFolders"))
-      sfmData.addFeaturesFolder(featureFolderNode.second.get_value<std::string>());
+  if(getMember("featuresFolders", range))
+  {
+    JsonReader reader(range, documentBegin);
+    if(reader.enterArray())
+      while(reader.nextElement())
+        sfmData.addFeaturesFolder(reader.readString());
+  }
 
-  if(fileTree.count("matchesFolders"))
-    for(bpt::ptree::value_type& matchingFolderNode : fileTree.get_child("matchesFolders"))
-      sfmData.addMatchesFolder(matchingFolderNode.second.get_value<std::string>());
+  if(getMember("matchesFolders", range))
+  {
+    JsonReader reader(range, documentBegin);
+    if(reader.enterArray())
+      while(reader.nextElement())
+        sfmData.addMatchesFolder(reader.readString());
+  }
 
   // intrinsics
-  if(loadIntrinsics && fileTree.count("intrinsics"))
+  if(loadIntrinsics && getMember("intrinsics", range))
   {
     sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+    JsonReader reader(range, documentBegin);
 
-    for(bpt::ptree::value_type &intrinsicNode : fileTree.get_child("intrinsics"))
+    if(reader.enterArray())
     {
-      IndexT intrinsicId;
-      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+      while(reader.nextElement())
+      {
+        IndexT intrinsicId;
+        std::shared_ptr<camera::IntrinsicBase> intrinsic;
 
-      loadIntrinsic(intrinsicId, intrinsic, intrinsicNode.second);
+        readIntrinsic(reader, intrinsicId, intrinsic);
 
-      intrinsics.emplace(intrinsicId, intrinsic);
+        intrinsics.emplace(intrinsicId, intrinsic);
+      }
     }
   }
 
   // views
-  if(loadViews && fileTree.count("views"))
+  if(loadViews && getMember("views", range))
   {
     sfmData::Views& views = sfmData.getViews();
 
+    // views are parsed in parallel
+    std::vector<sfmData::View> loadedViews;
+    readElements(viewElements, documentBegin, loadedViews, readView);
+
     if(incompleteViews)
     {
-      // store incomplete views in a vector
-      std::vector<sfmData::View> incompleteViews(fileTree.get_child("views").size());
-
-      int viewIndex = 0;
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
-      {
-        loadView(incompleteViews.at(viewIndex), viewNode.second);
-        ++viewIndex;
-      }
-
       // update incomplete views
       #pragma omp parallel for
-      for(int i = 0; i < incompleteViews.size(); ++i)
+      for(int i = 0; i < loadedViews.size(); ++i)
       {
-        sfmData::View& v = incompleteViews.at(i);
+        sfmData::View& v = loadedViews.at(i);
 
         // if we have the intrinsics and the view has an valid associated intrinsics
         // update the width and height field of View (they are mirrored)
@@ -532,22 +1293,15 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
           v.setWidth(intrinsics->w());
           v.setHeight(intrinsics->h());
         }
-        updateIncompleteView(incompleteViews.at(i), viewIdMethod, viewIdRegex);
+        updateIncompleteView(loadedViews.at(i), viewIdMethod, viewIdRegex);
       }
-
-      // copy complete views in the SfMData views map
-      for(const sfmData::View& view : incompleteViews)
-        views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
     }
-    else
+
+    // store complete views in the SfMData views map
+    for(sfmData::View& view : loadedViews)
     {
-      // store directly in the SfMData views map
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
-      {
-        sfmData::View view;
-        loadView(view, viewNode.second);
-        views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
-      }
+      const IndexT viewId = view.getViewId();
+      views.emplace(viewId, std::make_shared<sfmData::View>(std::move(view)));
     }
   }
 
@@ -555,67 +1309,79 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   if(loadExtrinsics)
   {
     // poses
-    if(fileTree.count("poses"))
+    if(getMember("poses", range))
     {
       sfmData::Poses& poses = sfmData.getPoses();
+      JsonReader reader(range, documentBegin);
 
-      for(bpt::ptree::value_type &poseNode : fileTree.get_child("poses"))
+      if(reader.enterArray())
       {
-        bpt::ptree& poseTree = poseNode.second;
-        sfmData::CameraPose pose;
+        while(reader.nextElement())
+        {
+          IndexT poseId;
+          sfmData::CameraPose pose;
 
-        loadCameraPose("pose", pose, poseTree);
+          readCameraPose(reader, poseId, pose);
 
-        poses.emplace(poseTree.get<IndexT>("poseId"), pose);
+          poses.emplace(poseId, pose);
+        }
       }
     }
 
     // rigs
-    if(fileTree.count("rigs"))
+    if(getMember("rigs", range))
     {
       sfmData::Rigs& rigs = sfmData.getRigs();
+      JsonReader reader(range, documentBegin);
 
-      for(bpt::ptree::value_type &rigNode : fileTree.get_child("rigs"))
+      if(reader.enterArray())
       {
-        IndexT rigId;
-        sfmData::Rig rig;
+        while(reader.nextElement())
+        {
+          IndexT rigId;
+          sfmData::Rig rig;
 
-        loadRig(rigId, rig, rigNode.second);
+          readRig(reader, rigId, rig);
 
-        rigs.emplace(rigId, rig);
+          rigs.emplace(rigId, rig);
+        }
       }
     }
   }
 
   // structure
-  if(loadStructure && fileTree.count("structure"))
+  if(loadStructure && getMember("structure", range))
   {
     sfmData::Landmarks& structure = sfmData.getLandmarks();
 
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second, loadObservations, loadFeatures);
+    // landmarks are parsed in parallel
+    std::vector<std::pair<IndexT, sfmData::Landmark>> landmarks;
+    readElements(landmarkElements, documentBegin, landmarks, [&](JsonReader& reader, std::pair<IndexT, sfmData::Landmark>& landmarkPair) {
+      readLandmark(reader, landmarkPair.first, landmarkPair.second, loadObservations, loadFeatures);
+    });
 
-      structure.emplace(landmarkId, landmark);
-    }
+    // landmarks are written sorted: insertion at the end in O(1)
+    for(auto& landmarkPair : landmarks)
+      structure.emplace_hint(structure.end(), landmarkPair.first, std::move(landmarkPair.second));
   }
 
   // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
+  if(loadControlPoints && getMember("controlPoints", range))
   {
     sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
+    JsonReader reader(range, documentBegin);
 
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
+    if(reader.enterArray())
     {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
+      while(reader.nextElement())
+      {
+        IndexT landmarkId;
+        sfmData::Landmark landmark;
 
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
+        readLandmark(reader, landmarkId, landmark, true, true);
 
-      controlPoints.emplace(landmarkId, landmark);
+        controlPoints.emplace(landmarkId, landmark);
+      }
     }
   }
 
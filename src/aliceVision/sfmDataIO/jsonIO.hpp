@@ -124,7 +124,7 @@ inline void loadCameraPose(const std::string& name, sfmData::CameraPose& cameraP
   loadPose3(name + ".transform", pose, cameraPoseTree);
   cameraPose.setTransform(pose);
 
-  if(cameraPoseTree.get<bool>("locked", false))
+  if(cameraPoseTree.get<bool>(name + ".locked", false))
     cameraPose.lock();
   else
     cameraPose.unlock();
@@ -205,7 +205,8 @@ void saveLandmark(const std::string& name, IndexT landmarkId, const sfmData::Lan
 void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& landmarkTree, bool loadObservations = true, bool loadFeatures = true);
 
 /**
- * @brief Save an SfMData in a JSON file with a boost property tree.
+ * @brief Save an SfMData in a JSON file.
+ * @note The file is streamed without building a property tree, with the same layout as boost::property_tree::write_json.
  * @param[in] sfmData The input SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData save flag
@@ -215,6 +216,7 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
 
 /**
  * @brief Load a JSON SfMData file.
+ * @note The file is parsed without building a property tree, views and landmarks are parsed in parallel.
  * @param[out] sfmData The output SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData load flag
@@ -0,0 +1,716 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "jsonStream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+/// size of the writer buffer before flushing in the output stream
+const std::size_t writerBufferSize = 1 << 20;
+
+/// @return true if the character can be written without escape sequence (same rule as write_json)
+inline bool isPlainCharacter(unsigned char c)
+{
+  return c == 0x20 || c == 0x21 || (c >= 0x23 && c <= 0x2E) ||
+         (c >= 0x30 && c <= 0x5B) || (c >= 0x5D);
+}
+
+inline bool isWhitespace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+void appendUtf8(std::string& str, unsigned long codepoint)
+{
+  if(codepoint < 0x80)
+  {
+    str += static_cast<char>(codepoint);
+  }
+  else if(codepoint < 0x800)
+  {
+    str += static_cast<char>(0xC0 | (codepoint >> 6));
+    str += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+  else if(codepoint < 0x10000)
+  {
+    str += static_cast<char>(0xE0 | (codepoint >> 12));
+    str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+  else
+  {
+    str += static_cast<char>(0xF0 | (codepoint >> 18));
+    str += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+    str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(std::ostream& stream)
+  : _stream(&stream)
+  , _buffer(_localBuffer)
+{
+  _buffer.reserve(writerBufferSize + 4096);
+}
+
+JsonWriter::JsonWriter(std::string& buffer, int depth, bool isArray)
+  : _buffer(buffer)
+{
+  // the enclosing levels are never closed by a fragment writer,
+  // only the depth and the type of the last one matter
+  _levels.assign(depth, Level{false, true});
+  _levels.push_back(Level{isArray, true});
+}
+
+JsonWriter::~JsonWriter()
+{
+  if(_stream != nullptr)
+    flushBuffer(true);
+}
+
+void JsonWriter::beginDocument()
+{
+  _levels.push_back(Level{false, false});
+}
+
+void JsonWriter::endDocument()
+{
+  endContainer();
+  _buffer += '\n';
+  flushBuffer(true);
+  _stream->flush();
+}
+
+void JsonWriter::beginObject(const std::string& key)
+{
+  beginContainer(key, false);
+}
+
+void JsonWriter::endObject()
+{
+  endContainer();
+}
+
+void JsonWriter::beginArray(const std::string& key)
+{
+  beginContainer(key, true);
+}
+
+void JsonWriter::endArray()
+{
+  endContainer();
+}
+
+void JsonWriter::write(const std::string& key, const std::string& value)
+{
+  beginElement(key);
+  _buffer += '"';
+  writeEscaped(value.data(), value.size());
+  _buffer += '"';
+  flushBuffer(false);
+}
+
+void JsonWriter::write(const std::string& key, const char* value)
+{
+  beginElement(key);
+  _buffer += '"';
+  writeEscaped(value, std::strlen(value));
+  _buffer += '"';
+  flushBuffer(false);
+}
+
+void JsonWriter::write(const std::string& key, bool value)
+{
+  // same as boost::property_tree (boolalpha)
+  if(value)
+    writeRawValue(key, "true", 4);
+  else
+    writeRawValue(key, "false", 5);
+}
+
+void JsonWriter::write(const std::string& key, double value)
+{
+  // same as boost::property_tree: precision set to max_digits10 with the default floatfield
+  char str[64];
+  const int size = std::snprintf(str, sizeof(str), "%.*g", std::numeric_limits<double>::max_digits10, value);
+  writeRawValue(key, str, size);
+}
+
+void JsonWriter::write(const std::string& key, float value)
+{
+  char str[64];
+  const int size = std::snprintf(str, sizeof(str), "%.*g", std::numeric_limits<float>::max_digits10, static_cast<double>(value));
+  writeRawValue(key, str, size);
+}
+
+void JsonWriter::writeInteger(const std::string& key, long long value)
+{
+  char str[32];
+  const int size = std::snprintf(str, sizeof(str), "%lld", value);
+  writeRawValue(key, str, size);
+}
+
+void JsonWriter::writeUnsignedInteger(const std::string& key, unsigned long long value)
+{
+  char str[32];
+  const int size = std::snprintf(str, sizeof(str), "%llu", value);
+  writeRawValue(key, str, size);
+}
+
+void JsonWriter::writeTree(const std::string& key, const boost::property_tree::ptree& tree)
+{
+  if(tree.empty())
+  {
+    write(key, tree.data());
+    return;
+  }
+
+  const bool isArray = (tree.count("") == tree.size());
+
+  beginContainer(key, isArray);
+  for(const auto& child : tree)
+    writeTree(child.first, child.second);
+  endContainer();
+}
+
+void JsonWriter::appendFragment(const std::string& fragment)
+{
+  if(fragment.empty())
+    return;
+
+  Level& level = _levels.back();
+
+  // a fragment always starts with an element separator,
+  // replace it by the container opening for the first element
+  if(!level.hasChildren)
+  {
+    _buffer += (level.isArray ? '[' : '{');
+    _buffer.append(fragment, 1, std::string::npos);
+    level.hasChildren = true;
+  }
+  else
+  {
+    _buffer += fragment;
+  }
+  flushBuffer(false);
+}
+
+void JsonWriter::writeRawValue(const std::string& key, const char* value, std::size_t size)
+{
+  beginElement(key);
+  _buffer += '"';
+  _buffer.append(value, size);
+  _buffer += '"';
+  flushBuffer(false);
+}
+
+void JsonWriter::beginElement(const std::string& key)
+{
+  Level& level = _levels.back();
+
+  if(level.hasChildren)
+    _buffer += ",\n";
+  else
+  {
+    _buffer += (level.isArray ? '[' : '{');
+    _buffer += '\n';
+    level.hasChildren = true;
+  }
+
+  writeIndent(_levels.size());
+
+  if(!level.isArray)
+  {
+    _buffer += '"';
+    writeEscaped(key.data(), key.size());
+    _buffer += "\": ";
+  }
+}
+
+void JsonWriter::beginContainer(const std::string& key, bool isArray)
+{
+  beginElement(key);
+  // the container opening is deferred to its first element:
+  // an empty container is written as an empty string
+  _levels.push_back(Level{isArray, false});
+}
+
+void JsonWriter::endContainer()
+{
+  const Level level = _levels.back();
+  _levels.pop_back();
+
+  if(level.hasChildren)
+  {
+    _buffer += '\n';
+    writeIndent(_levels.size());
+    _buffer += (level.isArray ? ']' : '}');
+  }
+  else if(_levels.empty())
+  {
+    // empty root object
+    _buffer += "{\n}";
+  }
+  else
+  {
+    _buffer += "\"\"";
+  }
+}
+
+void JsonWriter::writeEscaped(const char* str, std::size_t size)
+{
+  static const char* hexdigits = "0123456789ABCDEF";
+
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const unsigned char c = static_cast<unsigned char>(str[i]);
+
+    if(isPlainCharacter(c))
+    {
+      _buffer += static_cast<char>(c);
+      continue;
+    }
+
+    _buffer += '\\';
+    switch(c)
+    {
+      case '\b': _buffer += 'b'; break;
+      case '\f': _buffer += 'f'; break;
+      case '\n': _buffer += 'n'; break;
+      case '\r': _buffer += 'r'; break;
+      case '\t': _buffer += 't'; break;
+      case '/':  _buffer += '/'; break;
+      case '"':  _buffer += '"'; break;
+      case '\\': _buffer += '\\'; break;
+      default:
+        _buffer += "u00";
+        _buffer += hexdigits[c / 16];
+        _buffer += hexdigits[c % 16];
+    }
+  }
+}
+
+void JsonWriter::writeIndent(std::size_t depth)
+{
+  _buffer.append(4 * depth, ' ');
+}
+
+void JsonWriter::flushBuffer(bool force)
+{
+  if(_stream == nullptr)
+    return;
+
+  if(force || _buffer.size() >= writerBufferSize)
+  {
+    _stream->write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+  }
+}
+
+JsonReader::JsonReader(const char* begin, const char* end)
+  : _documentBegin(begin)
+  , _current(begin)
+  , _end(end)
+{}
+
+JsonReader::JsonReader(const Range& range, const char* documentBegin)
+  : _documentBegin(documentBegin)
+  , _current(range.first)
+  , _end(range.second)
+{}
+
+bool JsonReader::enterObject()
+{
+  skipWhitespaces();
+  if(_current < _end && *_current == '"')
+  {
+    // empty object written as an empty string
+    skipValue();
+    return false;
+  }
+  expect('{');
+  _firstElement.push_back(true);
+  return true;
+}
+
+bool JsonReader::nextMember(std::string& key)
+{
+  skipWhitespaces();
+
+  if(_current < _end && *_current == '}')
+  {
+    ++_current;
+    _firstElement.pop_back();
+    return false;
+  }
+
+  if(!_firstElement.back())
+  {
+    expect(',');
+    skipWhitespaces();
+  }
+  _firstElement.back() = false;
+
+  readQuotedString(key);
+  skipWhitespaces();
+  expect(':');
+  return true;
+}
+
+bool JsonReader::enterArray()
+{
+  skipWhitespaces();
+  if(_current < _end && *_current == '"')
+  {
+    // empty array written as an empty string
+    skipValue();
+    return false;
+  }
+  expect('[');
+  _firstElement.push_back(true);
+  return true;
+}
+
+bool JsonReader::nextElement()
+{
+  skipWhitespaces();
+
+  if(_current < _end && *_current == ']')
+  {
+    ++_current;
+    _firstElement.pop_back();
+    return false;
+  }
+
+  if(!_firstElement.back())
+    expect(',');
+  _firstElement.back() = false;
+  return true;
+}
+
+JsonReader::Range JsonReader::skipValue()
+{
+  skipWhitespaces();
+
+  if(_current >= _end)
+    throwError("unexpected end of data");
+
+  const char* begin = _current;
+  const char c = *_current;
+
+  if(c == '"')
+  {
+    skipQuotedString();
+  }
+  else if(c == '{' || c == '[')
+  {
+    // containers are skipped by counting the nesting level,
+    // in a single tight loop as it is used to split large arrays
+    int depth = 0;
+    do
+    {
+      if(_current >= _end)
+        throwError("unexpected end of data");
+
+      switch(*_current)
+      {
+        case '"':
+          skipQuotedString();
+          continue;
+        case '{':
+        case '[':
+          ++depth;
+          break;
+        case '}':
+        case ']':
+          --depth;
+          break;
+        default:
+          break;
+      }
+      ++_current;
+    }
+    while(depth > 0);
+  }
+  else
+  {
+    const char* tokenBegin;
+    const char* tokenEnd;
+    readToken(tokenBegin, tokenEnd);
+  }
+
+  return Range(begin, _current);
+}
+
+void JsonReader::collectElements(std::vector<Range>& elements)
+{
+  elements.clear();
+
+  if(!enterArray())
+    return;
+
+  while(nextElement())
+    elements.push_back(skipValue());
+}
+
+std::string JsonReader::readString()
+{
+  skipWhitespaces();
+
+  std::string str;
+  if(_current < _end && (*_current == '{' || *_current == '['))
+  {
+    skipValue();
+  }
+  else if(_current < _end && *_current == '"')
+  {
+    readQuotedString(str);
+  }
+  else
+  {
+    const char* begin;
+    const char* end;
+    readToken(begin, end);
+    str.assign(begin, end);
+  }
+  return str;
+}
+
+double JsonReader::readDouble()
+{
+  const char* begin;
+  const char* end;
+  if(!readToken(begin, end))
+    throwError("conversion of data to type \"double\" failed");
+
+  char* parsed;
+  const double value = std::strtod(begin, &parsed);
+
+  while(parsed < end && isWhitespace(*parsed))
+    ++parsed;
+
+  if(parsed != end || begin == end)
+    throwError("conversion of data to type \"double\" failed");
+
+  return value;
+}
+
+bool JsonReader::readBool()
+{
+  const char* begin;
+  const char* end;
+  readToken(begin, end);
+
+  const std::size_t size = end - begin;
+
+  // same as boost::property_tree: numeric form first, then word form
+  if(size == 1 && (*begin == '0' || *begin == '1'))
+    return *begin == '1';
+  if(size == 4 && std::strncmp(begin, "true", 4) == 0)
+    return true;
+  if(size == 5 && std::strncmp(begin, "false", 5) == 0)
+    return false;
+
+  throwError("conversion of data to type \"bool\" failed");
+}
+
+unsigned long long JsonReader::readUnsignedInteger()
+{
+  const char* begin;
+  const char* end;
+  readToken(begin, end);
+
+  // strtoull accepts a minus sign and negates the result
+  if(begin < end && *begin == '-')
+    throwError("conversion of data to unsigned integer type failed");
+
+  char* parsed;
+  errno = 0;
+  const unsigned long long value = std::strtoull(begin, &parsed, 10);
+
+  while(parsed < end && isWhitespace(*parsed))
+    ++parsed;
+
+  if(parsed != end || begin == end || errno == ERANGE)
+    throwError("conversion of data to unsigned integer type failed");
+
+  return value;
+}
+
+long long JsonReader::readInteger()
+{
+  const char* begin;
+  const char* end;
+  readToken(begin, end);
+
+  char* parsed;
+  errno = 0;
+  const long long value = std::strtoll(begin, &parsed, 10);
+
+  while(parsed < end && isWhitespace(*parsed))
+    ++parsed;
+
+  if(parsed != end || begin == end || errno == ERANGE)
+    throwError("conversion of data to integer type failed");
+
+  return value;
+}
+
+void JsonReader::throwError(const std::string& message) const
+{
+  const long line = 1 + std::count(_documentBegin, std::min(_current, _end), '\n');
+  throw std::runtime_error("JSON parser error at line " + std::to_string(line) + ": " + message);
+}
+
+bool JsonReader::readToken(const char*& begin, const char*& end)
+{
+  skipWhitespaces();
+
+  if(_current >= _end)
+    throwError("unexpected end of data");
+
+  bool plain = true;
+
+  if(*_current == '"')
+  {
+    ++_current;
+    begin = _current;
+    while(_current < _end && *_current != '"')
+    {
+      if(*_current == '\\')
+      {
+        plain = false;
+        ++_current;
+      }
+      ++_current;
+    }
+    end = _current;
+    expect('"');
+  }
+  else
+  {
+    // unquoted number or literal
+    begin = _current;
+    while(_current < _end && !isWhitespace(*_current) &&
+          *_current != ',' && *_current != '}' && *_current != ']')
+      ++_current;
+    end = _current;
+
+    if(begin == end)
+      throwError(std::string("unexpected character '") + *_current + "'");
+  }
+
+  // leading whitespaces are accepted in the value (as with boost::property_tree)
+  while(begin < end && isWhitespace(*begin))
+    ++begin;
+
+  return plain;
+}
+
+void JsonReader::readQuotedString(std::string& str)
+{
+  expect('"');
+
+  str.clear();
+
+  const char* begin = _current;
+  while(_current < _end && *_current != '"' && *_current != '\\')
+    ++_current;
+  str.assign(begin, _current);
+
+  // slow path with escape sequences
+  while(_current < _end && *_current != '"')
+  {
+    if(*_current != '\\')
+    {
+      str += *_current++;
+      continue;
+    }
+
+    ++_current;
+    if(_current >= _end)
+      break;
+
+    const char c = *_current++;
+    switch(c)
+    {
+      case 'b': str += '\b'; break;
+      case 'f': str += '\f'; break;
+      case 'n': str += '\n'; break;
+      case 'r': str += '\r'; break;
+      case 't': str += '\t'; break;
+      case '/': str += '/'; break;
+      case '"': str += '"'; break;
+      case '\\': str += '\\'; break;
+      case 'u':
+      {
+        if(_end - _current < 4)
+          throwError("invalid escape sequence");
+
+        unsigned long codepoint = std::strtoul(std::string(_current, _current + 4).c_str(), nullptr, 16);
+        _current += 4;
+
+        // surrogate pair
+        if(codepoint >= 0xD800 && codepoint < 0xDC00 && _end - _current >= 6 && _current[0] == '\\' && _current[1] == 'u')
+        {
+          const unsigned long low = std::strtoul(std::string(_current + 2, _current + 6).c_str(), nullptr, 16);
+          if(low >= 0xDC00 && low < 0xE000)
+          {
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            _current += 6;
+          }
+        }
+        appendUtf8(str, codepoint);
+        break;
+      }
+      default:
+        throwError("invalid escape sequence");
+    }
+  }
+
+  expect('"');
+}
+
+void JsonReader::skipQuotedString()
+{
+  ++_current;
+  while(_current < _end && *_current != '"')
+  {
+    if(*_current == '\\')
+      ++_current;
+    ++_current;
+  }
+  expect('"');
+}
+
+void JsonReader::skipWhitespaces()
+{
+  while(_current < _end && isWhitespace(*_current))
+    ++_current;
+}
+
+void JsonReader::expect(char c)
+{
+  if(_current >= _end || *_current != c)
+    throwError(std::string("expected '") + c + "'");
+  ++_current;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,300 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * Produces byte for byte the layout of boost::property_tree::write_json
+ * (4 spaces indentation, every value written as a quoted string,
+ * empty objects/arrays written as "") without building a property tree.
+ */
+class JsonWriter
+{
+public:
+  /**
+   * @brief Write a document in the given stream.
+   * @param[in,out] stream The output stream
+   */
+  explicit JsonWriter(std::ostream& stream);
+
+  /**
+   * @brief Write a fragment of the content of an array or an object.
+   *        The fragment can be appended to a document writer with appendFragment.
+   *        This allows to format independent parts of a document in parallel.
+   * @param[out] buffer The output fragment buffer
+   * @param[in] depth The depth of the container the fragment belongs to
+   * @param[in] isArray true if the fragment belongs to an array
+   */
+  JsonWriter(std::string& buffer, int depth, bool isArray);
+
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  /// Open the root object of the document
+  void beginDocument();
+
+  /// Close the root object of the document and flush the stream
+  void endDocument();
+
+  /**
+   * @brief Open an object.
+   * @param[in] key The object name (ignored inside an array)
+   */
+  void beginObject(const std::string& key = "");
+  void endObject();
+
+  /**
+   * @brief Open an array.
+   * @param[in] key The array name (ignored inside an array)
+   */
+  void beginArray(const std::string& key = "");
+  void endArray();
+
+  /**
+   * @brief Write a value.
+   * @param[in] key The value name (ignored inside an array)
+   * @param[in] value The value, formatted as boost::property_tree::ptree::put would
+   */
+  void write(const std::string& key, const std::string& value);
+  void write(const std::string& key, const char* value);
+  void write(const std::string& key, bool value);
+  void write(const std::string& key, double value);
+  void write(const std::string& key, float value);
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type
+  write(const std::string& key, T value)
+  {
+    if(std::is_signed<T>::value)
+      writeInteger(key, static_cast<long long>(value));
+    else
+      writeUnsignedInteger(key, static_cast<unsigned long long>(value));
+  }
+
+  /**
+   * @brief Write an Eigen Matrix (or Vector) as an array, as saveMatrix does.
+   * @param[in] key The array name (ignored inside an array)
+   * @param[in] matrix The input matrix
+   */
+  template<typename Derived>
+  void writeMatrix(const std::string& key, const Eigen::MatrixBase<Derived>& matrix)
+  {
+    beginArray(key);
+    const int size = matrix.size();
+    for(int i = 0; i < size; ++i)
+      write("", matrix(i));
+    endArray();
+  }
+
+  /**
+   * @brief Write a boost property tree with the write_json rules.
+   * @param[in] key The tree name (ignored inside an array)
+   * @param[in] tree The input tree
+   */
+  void writeTree(const std::string& key, const boost::property_tree::ptree& tree);
+
+  /**
+   * @brief Append a fragment written by a fragment writer to the current container.
+   * @param[in] fragment The fragment, its depth must match the current container depth
+   */
+  void appendFragment(const std::string& fragment);
+
+  /// @return The depth of the current container (0 for the root object)
+  int depth() const { return static_cast<int>(_levels.size()) - 1; }
+
+private:
+  struct Level
+  {
+    bool isArray;
+    bool hasChildren;
+  };
+
+  void writeInteger(const std::string& key, long long value);
+  void writeUnsignedInteger(const std::string& key, unsigned long long value);
+  void writeRawValue(const std::string& key, const char* value, std::size_t size);
+  void beginElement(const std::string& key);
+  void beginContainer(const std::string& key, bool isArray);
+  void endContainer();
+  void writeEscaped(const char* str, std::size_t size);
+  void writeIndent(std::size_t depth);
+  void flushBuffer(bool force);
+
+  std::ostream* _stream = nullptr;
+  std::string _localBuffer;
+  std::string& _buffer;
+  std::vector<Level> _levels;
+};
+
+/**
+ * @brief Streaming (pull) JSON reader.
+ *
+ * Reads a JSON document in memory without building a property tree.
+ * Values are returned with the boost::property_tree conversion rules:
+ * scalars may be quoted or not, and an empty string stands for an empty
+ * object or array (as written by write_json).
+ */
+class JsonReader
+{
+public:
+  /// Range of characters of a JSON value in the document
+  using Range = std::pair<const char*, const char*>;
+
+  /**
+   * @brief Read a document from a memory buffer.
+   * @param[in] begin The buffer begin
+   * @param[in] end The buffer end, *end must be readable and not part of a JSON token (e.g. '\0')
+   */
+  JsonReader(const char* begin, const char* end);
+
+  /**
+   * @brief Read a value from a range of a document.
+   * @param[in] range The value range in the document
+   * @param[in] documentBegin The document begin (used for error messages)
+   */
+  JsonReader(const Range& range, const char* documentBegin);
+
+  /**
+   * @brief Enter an object.
+   * @return false if the value is a string, considered as an empty object
+   */
+  bool enterObject();
+
+  /**
+   * @brief Move to the next member of the current object.
+   * @param[out] key The member name
+   * @return false if the end of the object has been reached
+   */
+  bool nextMember(std::string& key);
+
+  /**
+   * @brief Enter an array.
+   * @return false if the value is a string, considered as an empty array
+   */
+  bool enterArray();
+
+  /**
+   * @brief Move to the next element of the current array.
+   * @return false if the end of the array has been reached
+   */
+  bool nextElement();
+
+  /**
+   * @brief Skip the current value.
+   * @return The range of the skipped value
+   */
+  Range skipValue();
+
+  /**
+   * @brief Collect the range of each element of the current array.
+   * @param[out] elements The element ranges
+   */
+  void collectElements(std::vector<Range>& elements);
+
+  /**
+   * @brief Read the current value as a string.
+   * @return The value, or an empty string for an object or an array
+   *         (the data of a property tree node with children)
+   */
+  std::string readString();
+  double readDouble();
+  bool readBool();
+  unsigned long long readUnsignedInteger();
+  long long readInteger();
+
+  template<typename T>
+  T readUnsigned()
+  {
+    const unsigned long long value = readUnsignedInteger();
+    if(value > std::numeric_limits<T>::max())
+      throwError("integer value out of range");
+    return static_cast<T>(value);
+  }
+
+  /**
+   * @brief Read an Eigen Matrix (or Vector) from an array, as loadMatrix does.
+   * @param[out] matrix The output matrix
+   */
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    const int size = matrix.size();
+    int i = 0;
+    if(!enterArray())
+      return;
+    while(nextElement())
+    {
+      if(i >= size)
+        throwError("invalid matrix / vector size");
+      matrix(i++) = readScalar<typename Derived::Scalar>();
+    }
+  }
+
+  /// @return The current position in the document
+  const char* position() const { return _current; }
+
+  /**
+   * @brief Throw a std::runtime_error with the current line number.
+   * @param[in] message The error message
+   */
+  [[noreturn]] void throwError(const std::string& message) const;
+
+private:
+  template<typename T>
+  typename std::enable_if<std::is_floating_point<T>::value, T>::type readScalar()
+  {
+    return static_cast<T>(readDouble());
+  }
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, T>::type readScalar()
+  {
+    return readUnsigned<T>();
+  }
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, T>::type readScalar()
+  {
+    return static_cast<T>(readInteger());
+  }
+
+  /**
+   * @brief Read a scalar token without unescaping.
+   * @param[out] begin The token begin
+   * @param[out] end The token end
+   * @return true if the token is free of escape sequences
+   */
+  bool readToken(const char*& begin, const char*& end);
+  void readQuotedString(std::string& str);
+  void skipQuotedString();
+  void skipWhitespaces();
+  void expect(char c);
+
+  const char* _documentBegin;
+  const char* _current;
+  const char* _end;
+  std::vector<bool> _firstElement;
+};
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -8,9 +8,13 @@
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/sfmDataIO/jsonStream.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
+#include <fstream>
 #include <sstream>
 
 #define BOOST_TEST_MODULE sfmDataIO
@@ -178,6 +182,145 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_PROPERTY_TREE_LAYOUT) {
+
+  const std::string filename = "PROPERTY_TREE_LAYOUT.sfm";
+
+  sfmData::SfMData sfmData = createTestScene(3, 3, false);
+  sfmData.addFeaturesFolder("features");
+  sfmData.getViews().at(0)->addMetadata("Exif:Make", "\"Camera\"\t/\\");
+  sfmData.getViews().at(1)->addMetadata("dotted.metadata.name", "value");
+  sfmData.getViews().at(2)->setRigAndSubPoseId(0, 1);
+  sfmData.getRigs()[0] = sfmData::Rig(2);
+  sfmData.intrinsics.at(1) = std::make_shared<PinholeRadialK3>(1000, 1000, 1234.5678, 500.25, 499.75, 0.1, -0.01, 1e-5);
+  sfmData.intrinsics.at(1)->lock();
+  sfmData.structure[1] = sfmData::Landmark(Vec3(1.0 / 3.0, -2.0 / 7.0, 1e-12), feature::EImageDescriberType::SIFT);
+
+  // the streaming writer should produce the same file as boost::property_tree
+  BOOST_CHECK( saveJSON(sfmData, filename, ALL) );
+
+  bpt::ptree fileTree;
+  {
+    bpt::ptree viewsTree, intrinsicsTree, posesTree, rigsTree, structureTree, featuresFoldersTree, featuresFolderTree;
+
+    saveMatrix("version", Vec3(1, 0, 0), fileTree);
+    featuresFolderTree.put("", "features");
+    featuresFoldersTree.push_back(std::make_pair("", featuresFolderTree));
+    fileTree.add_child("featuresFolders", featuresFoldersTree);
+
+    for(const auto& viewPair : sfmData.getViews())
+      saveView("", *(viewPair.second), viewsTree);
+    fileTree.add_child("views", viewsTree);
+
+    for(const auto& intrinsicPair : sfmData.getIntrinsics())
+      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+    fileTree.add_child("intrinsics", intrinsicsTree);
+
+    for(const auto& posePair : sfmData.getPoses())
+    {
+      bpt::ptree poseTree;
+      poseTree.put("poseId", posePair.first);
+      saveCameraPose("pose", posePair.second, poseTree);
+      posesTree.push_back(std::make_pair("", poseTree));
+    }
+    fileTree.add_child("poses", posesTree);
+
+    for(const auto& rigPair : sfmData.getRigs())
+      saveRig("", rigPair.first, rigPair.second, rigsTree);
+    fileTree.add_child("rigs", rigsTree);
+
+    for(const auto& landmarkPair : sfmData.getLandmarks())
+      saveLandmark("", landmarkPair.first, landmarkPair.second, structureTree);
+    fileTree.add_child("structure", structureTree);
+  }
+
+  std::ostringstream expected;
+  bpt::write_json(expected, fileTree);
+
+  std::ifstream file(filename);
+  std::ostringstream written;
+  written << file.rdbuf();
+
+  BOOST_CHECK_EQUAL( written.str(), expected.str() );
+
+  // the streaming reader should load back the same scene
+  sfmData::SfMData sfmDataLoad;
+  BOOST_CHECK( loadJSON(sfmDataLoad, filename, ALL) );
+  BOOST_CHECK_EQUAL( sfmDataLoad.getViews().size(), sfmData.getViews().size() );
+  BOOST_CHECK_EQUAL( sfmDataLoad.getRigs().size(), 1 );
+  BOOST_CHECK_EQUAL( sfmDataLoad.getView(0).getMetadata().at("Exif:Make"), "\"Camera\"\t/\\" );
+  BOOST_CHECK( sfmDataLoad.getView(2).isPartOfRig() );
+  BOOST_CHECK( sfmDataLoad.getIntrinsics().at(1)->isLocked() );
+  BOOST_CHECK_EQUAL( sfmDataLoad.getIntrinsics().at(1)->getParams().size(), sfmData.getIntrinsics().at(1)->getParams().size() );
+  BOOST_CHECK( sfmDataLoad.getLandmarks() == sfmData.getLandmarks() );
+  BOOST_CHECK_EQUAL( sfmDataLoad.getLandmarks().at(1).X, sfmData.getLandmarks().at(1).X );
+
+  // values written without quotes are accepted
+  {
+    std::ofstream unquotedFile(filename);
+    unquotedFile << "{ \"version\": [1, 0, 0], \"views\": [ { \"viewId\": 12, \"path\": \"a.jpg\", \"width\": 10, \"height\": 20, \"metadata\": \"\" } ] }";
+  }
+  sfmData::SfMData sfmDataUnquoted;
+  BOOST_CHECK( loadJSON(sfmDataUnquoted, filename, ALL) );
+  BOOST_CHECK_EQUAL( sfmDataUnquoted.getViews().size(), 1 );
+  BOOST_CHECK_EQUAL( sfmDataUnquoted.getView(12).getWidth(), 10 );
+  BOOST_CHECK_EQUAL( sfmDataUnquoted.getView(12).getImagePath(), "a.jpg" );
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_POSE_LOCKED) {
+
+  const std::string filename = "POSE_LOCKED.sfm";
+
+  sfmData::SfMData sfmData = createTestScene(3, 3, false);
+  sfmData.getPoses().at(1).lock();
+
+  // the streaming loader and the property tree loader read the same lock state
+  BOOST_CHECK( saveJSON(sfmData, filename, ALL) );
+
+  sfmData::SfMData sfmDataLoad;
+  BOOST_CHECK( loadJSON(sfmDataLoad, filename, ALL) );
+  BOOST_REQUIRE_EQUAL( sfmDataLoad.getPoses().size(), sfmData.getPoses().size() );
+
+  bpt::ptree fileTree;
+  bpt::read_json(filename, fileTree);
+  std::size_t nbTreePoses = 0;
+  for(bpt::ptree::value_type& poseNode : fileTree.get_child("poses"))
+  {
+    const IndexT poseId = poseNode.second.get<IndexT>("poseId");
+    sfmData::CameraPose cameraPose;
+    cameraPose.lock();
+    loadCameraPose("pose", cameraPose, poseNode.second);
+
+    BOOST_CHECK_EQUAL( cameraPose.isLocked(), sfmData.getPoses().at(poseId).isLocked() );
+    BOOST_CHECK_EQUAL( sfmDataLoad.getPoses().at(poseId).isLocked(), sfmData.getPoses().at(poseId).isLocked() );
+    BOOST_CHECK( cameraPose.getTransform() == sfmDataLoad.getPoses().at(poseId).getTransform() );
+    ++nbTreePoses;
+  }
+  BOOST_CHECK_EQUAL( nbTreePoses, sfmData.getPoses().size() );
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_READER_UNSIGNED) {
+
+  const std::string document = "[\"18446744073709551615\", 12, \" 7\", \"-1\", -3, \"18446744073709551616\"]";
+  JsonReader reader(document.c_str(), document.c_str() + document.size());
+
+  BOOST_REQUIRE( reader.enterArray() );
+  BOOST_REQUIRE( reader.nextElement() );
+  BOOST_CHECK_EQUAL( reader.readUnsignedInteger(), 18446744073709551615ull );
+  BOOST_REQUIRE( reader.nextElement() );
+  BOOST_CHECK_EQUAL( reader.readUnsignedInteger(), 12 );
+  BOOST_REQUIRE( reader.nextElement() );
+  BOOST_CHECK_EQUAL( reader.readUnsignedInteger(), 7 );
+
+  // strtoull would wrap negative values
+  BOOST_REQUIRE( reader.nextElement() );
+  BOOST_CHECK_THROW( reader.readUnsignedInteger(), std::runtime_error );
+  BOOST_REQUIRE( reader.nextElement() );
+  BOOST_CHECK_THROW( reader.readUnsignedInteger(), std::runtime_error );
+  BOOST_REQUIRE( reader.nextElement() );
+  BOOST_CHECK_THROW( reader.readUnsignedInteger(), std::runtime_error );
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
@@ -0,0 +1,105 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "process.hpp"
+
+#include <aliceVision/system/system.hpp>
+
+#if defined(__WINDOWS__)
+#include <process.h>
+#else
+#include <cerrno>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+namespace aliceVision {
+namespace system {
+
+#if defined(__WINDOWS__)
+namespace {
+
+/**
+ * @brief Quote an argument for the command line parsing of the C runtime,
+ *        as the spawn functions join the arguments with spaces.
+ */
+std::string quoteArgument(const std::string& argument)
+{
+  if(!argument.empty() && argument.find_first_of(" \t\n\v\"") == std::string::npos)
+    return argument;
+
+  std::string quoted = "\"";
+  std::size_t nbBackslashes = 0;
+
+  for(const char c : argument)
+  {
+    if(c == '\\')
+    {
+      ++nbBackslashes;
+      continue;
+    }
+
+    // backslashes are escaped only before a double quote
+    if(c == '"')
+      quoted.append(2 * nbBackslashes + 1, '\\');
+    else
+      quoted.append(nbBackslashes, '\\');
+
+    nbBackslashes = 0;
+    quoted += c;
+  }
+
+  // the closing double quote must not be escaped
+  quoted.append(2 * nbBackslashes, '\\');
+  quoted += '"';
+  return quoted;
+}
+
+} // namespace
+#endif
+
+int runProcess(const std::vector<std::string>& arguments)
+{
+  if(arguments.empty())
+    return -1;
+
+#if defined(__WINDOWS__)
+  std::vector<std::string> quotedArguments;
+  quotedArguments.reserve(arguments.size());
+  for(const std::string& argument : arguments)
+    quotedArguments.push_back(quoteArgument(argument));
+
+  std::vector<const char*> argv;
+  for(const std::string& argument : quotedArguments)
+    argv.push_back(argument.c_str());
+  argv.push_back(nullptr);
+
+  return static_cast<int>(_spawnvp(_P_WAIT, arguments.front().c_str(), argv.data()));
+#else
+  std::vector<char*> argv;
+  for(const std::string& argument : arguments)
+    argv.push_back(const_cast<char*>(argument.c_str()));
+  argv.push_back(nullptr);
+
+  pid_t pid;
+  if(posix_spawnp(&pid, argv.front(), nullptr, nullptr, argv.data(), environ) != 0)
+    return -1;
+
+  int status = 0;
+  while(waitpid(pid, &status, 0) == -1)
+  {
+    if(errno != EINTR)
+      return -1;
+  }
+
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,24 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Run a program and wait for its termination.
+ *        The program is started directly, without any shell: the arguments are passed as they are.
+ * @param[in] arguments The program (searched in the PATH if it has no directory) followed by its arguments
+ * @return the exit code of the program, -1 if it cannot be started or does not terminate normally
+ */
+int runProcess(const std::vector<std::string>& arguments);
+
+} // namespace system
+} // namespace aliceVision
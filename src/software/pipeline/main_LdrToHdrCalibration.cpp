@@ -36,7 +36,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 0
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 3
 
 using namespace aliceVision;
 
@@ -266,22 +266,13 @@ int aliceVision_main(int argc, char** argv)
         {
             // Read from file
             const std::string samplesFilepath = (fs::path(samplesFolder) / (std::to_string(group_pos) + "_samples.dat")).string();
-            std::ifstream fileSamples(samplesFilepath, std::ios::binary);
-            if (!fileSamples.is_open())
+            std::vector<hdr::ImageSample> samples;
+            if (!hdr::readSamples(samples, samplesFilepath))
             {
                 ALICEVISION_LOG_ERROR("Impossible to read samples from file " << samplesFilepath);
                 return EXIT_FAILURE;
             }
 
-            std::size_t size;
-            fileSamples.read((char *)&size, sizeof(size));
-
-            std::vector<hdr::ImageSample> samples(size);
-            for (std::size_t i = 0; i < size; ++i)
-            {
-                fileSamples >> samples[i];
-            }
-
             sampling.analyzeSource(samples, channelQuantization, group_pos);
 
             ++group_pos;
@@ -298,22 +289,13 @@ int aliceVision_main(int argc, char** argv)
         {
             // Read from file
             const std::string samplesFilepath = (fs::path(samplesFolder) / (std::to_string(group_pos) + "_samples.dat")).string();
-            std::ifstream fileSamples(samplesFilepath, std::ios::binary);
-            if (!fileSamples.is_open())
+            std::vector<hdr::ImageSample> samples;
+            if (!hdr::readSamples(samples, samplesFilepath))
             {
                 ALICEVISION_LOG_ERROR("Impossible to read samples from file " << samplesFilepath);
                 return EXIT_FAILURE;
             }
 
-            std::size_t size = 0;
-            fileSamples.read((char *)&size, sizeof(size));
-
-            std::vector<hdr::ImageSample> samples(size);
-            for (int i = 0; i < size; ++i)
-            {
-                fileSamples >> samples[i];
-            }
-
             std::vector<hdr::ImageSample> out_samples;
             sampling.extractUsefulSamples(out_samples, samples, group_pos);
 
@@ -23,6 +23,8 @@
 // Command line parameters
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
+#include <future>
+#include <memory>
 #include <sstream>
 
 // These constants define the current software version.
@@ -264,16 +266,31 @@ int aliceVision_main(int argc, char** argv)
     hdr::rgbCurve response(channelQuantization);
     response.read(inputResponsePath);
 
+    // The groups are merged by bands of rows, so only a few rows of each bracket are in memory.
+    // The brackets of a band are decoded in parallel, while the previous band is written.
+    // The writing of the last band of a group is also overlapped with the decoding of the next group.
+    const int rowsPerBand = 256;
+    std::future<void> writing;
+
     for(std::size_t g = rangeStart; g < rangeStart + rangeSize; ++g)
     {
         const std::vector<std::shared_ptr<sfmData::View>>& group = groupedViews[g];
+        const int nbImages = group.size();
+
+        if(group.empty())
+        {
+            ALICEVISION_LOG_ERROR("The group " << g << " has no image.");
+            return EXIT_FAILURE;
+        }
 
-        std::vector<image::Image<image::RGBfColor>> images(group.size());
         std::shared_ptr<sfmData::View> targetView = targetViews[g];
-        std::vector<float> exposures(group.size(), 0.0f);
+        std::vector<float> exposures(nbImages, 0.0f);
+        std::vector<std::unique_ptr<image::ImageRowsReader>> readers(nbImages);
+        std::string readError;
 
-        // Load all images of the group
-        for(std::size_t i = 0; i < group.size(); ++i)
+        // Open all images of the group
+        #pragma omp parallel for
+        for(int i = 0; i < nbImages; ++i)
         {
             const std::string filepath = group[i]->getImagePath();
             ALICEVISION_LOG_INFO("Load " << filepath);
@@ -281,28 +298,36 @@ int aliceVision_main(int argc, char** argv)
             image::ImageReadOptions options;
             options.outputColorSpace = image::EImageColorSpace::SRGB;
             options.applyWhiteBalance = group[i]->getApplyWhiteBalance();
-            image::readImage(filepath, images[i], options);
+
+            try
+            {
+                readers[i].reset(new image::ImageRowsReader(filepath, options));
+            }
+            catch(const std::exception& e)
+            {
+                #pragma omp critical
+                readError = e.what();
+            }
 
             exposures[i] = group[i]->getCameraExposureSetting(/*targetView->getMetadataISO(), targetView->getMetadataFNumber()*/);
         }
 
-        // Merge HDR images
-        image::Image<image::RGBfColor> HDRimage;
-        if(images.size() > 1)
+        if(!readError.empty())
         {
-            hdr::hdrMerge merge;
-            float targetCameraExposure = targetView->getCameraExposureSetting();
-            ALICEVISION_LOG_INFO("[" << g - rangeStart << "/" << rangeSize << "] Merge " << group.size() << " LDR images " << g << "/" << groupedViews.size());
-            merge.process(images, exposures, fusionWeight, response, HDRimage, targetCameraExposure);
-            if(highlightCorrectionFactor > 0.0f)
-            {
-                merge.postProcessHighlight(images, exposures, fusionWeight, response, HDRimage, targetCameraExposure, highlightCorrectionFactor, highlightTargetLux);
-            }
+            ALICEVISION_LOG_ERROR(readError);
+            return EXIT_FAILURE;
         }
-        else if(images.size() == 1)
+
+        const int width = readers.front()->getWidth();
+        const int height = readers.front()->getHeight();
+
+        for(const auto& reader : readers)
         {
-            // Nothing to do
-            HDRimage = images[0];
+            if(reader->getWidth() != width || reader->getHeight() != height)
+            {
+                ALICEVISION_LOG_ERROR("The images of the group " << g << " do not have the same size.");
+                return EXIT_FAILURE;
+            }
         }
 
         const std::string hdrImagePath = getHdrImagePath(outputPath, g);
@@ -311,7 +336,94 @@ int aliceVision_main(int argc, char** argv)
         oiio::ParamValueList targetMetadata = image::readImageMetadata(targetView->getImagePath());
         targetMetadata.push_back(oiio::ParamValue("AliceVision:storageDataType", image::EStorageDataType_enumToString(storageDataType)));
 
-        image::writeImage(hdrImagePath, HDRimage, image::EImageColorSpace::AUTO, targetMetadata);
+        std::shared_ptr<image::ImageRowsWriter> writer = std::make_shared<image::ImageRowsWriter>(hdrImagePath, width, height, image::EImageColorSpace::AUTO, targetMetadata);
+
+        if(nbImages > 1)
+        {
+            ALICEVISION_LOG_INFO("[" << g - rangeStart << "/" << rangeSize << "] Merge " << nbImages << " LDR images " << g << "/" << groupedViews.size());
+        }
+
+        hdr::hdrMerge merge;
+        const float targetCameraExposure = targetView->getCameraExposureSetting();
+
+        // Rows of the brackets in memory: the band and its neighbor rows, used by the highlight correction
+        std::vector<image::Image<image::RGBfColor>> rows(nbImages);
+        int rowsBegin = 0;
+        int rowsEnd = 0;
+
+        for(int bandBegin = 0; bandBegin < height; bandBegin += rowsPerBand)
+        {
+            const int bandEnd = std::min(height, bandBegin + rowsPerBand);
+            const int nextRowsBegin = std::max(0, bandBegin - 1);
+            const int nextRowsEnd = std::min(height, bandEnd + 1);
+
+            // Keep the rows already read and read the next ones, in sequential order
+            #pragma omp parallel for
+            for(int i = 0; i < nbImages; ++i)
+            {
+                image::Image<image::RGBfColor> nextRows(width, nextRowsEnd - nextRowsBegin);
+
+                for(int y = nextRowsBegin; y < rowsEnd; ++y)
+                {
+                    nextRows.row(y - nextRowsBegin) = rows[i].row(y - rowsBegin);
+                }
+
+                try
+                {
+                    readers[i]->readRows(std::max(rowsEnd, nextRowsBegin), nextRowsEnd, nextRows, std::max(rowsEnd, nextRowsBegin) - nextRowsBegin);
+                }
+                catch(const std::exception& e)
+                {
+                    #pragma omp critical
+                    readError = e.what();
+                }
+
+                rows[i].swap(nextRows);
+            }
+
+            if(!readError.empty())
+            {
+                ALICEVISION_LOG_ERROR(readError);
+                return EXIT_FAILURE;
+            }
+
+            rowsBegin = nextRowsBegin;
+            rowsEnd = nextRowsEnd;
+
+            // Merge HDR images
+            std::shared_ptr<image::Image<image::RGBfColor>> HDRrows = std::make_shared<image::Image<image::RGBfColor>>(width, bandEnd - bandBegin);
+            if(nbImages > 1)
+            {
+                merge.processBand(rows, bandBegin - rowsBegin, exposures, fusionWeight, response, *HDRrows,
+                                  targetCameraExposure, highlightCorrectionFactor, highlightTargetLux);
+            }
+            else
+            {
+                // Nothing to do
+                *HDRrows = rows[0].block(bandBegin - rowsBegin, 0, bandEnd - bandBegin, width);
+            }
+
+            // Wait for the previous band to be written (and get its errors)
+            if(writing.valid())
+            {
+                writing.get();
+            }
+
+            const bool isLastBand = (bandEnd == height);
+            writing = std::async(std::launch::async, [writer, HDRrows, bandBegin, isLastBand]()
+            {
+                writer->writeRows(bandBegin, *HDRrows);
+                if(isLastBand)
+                {
+                    writer->close();
+                }
+            });
+        }
+    }
+
+    if(writing.valid())
+    {
+        writing.get();
     }
 
     return EXIT_SUCCESS;
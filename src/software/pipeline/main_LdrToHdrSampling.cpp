@@ -39,7 +39,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 0
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 3
 
 using namespace aliceVision;
 
@@ -82,6 +82,9 @@ int aliceVision_main(int argc, char** argv)
          "Radius of the patch used to analyze the sample statistics.")
         ("maxCountSample", po::value<size_t>(&params.maxCountSample)->default_value(params.maxCountSample),
          "Max number of samples per image group.")
+        ("removeDuplicates", po::value<bool>(&params.removeDuplicates)->default_value(params.removeDuplicates),
+         "Keep a single sample among the pixels with the same quantized values on the same brackets. "
+         "The kept sample stores its number of duplicates, used as equations weight by the Debevec calibration.")
         ("debug", po::value<bool>(&debug)->default_value(debug),
          "Export debug files.")
         ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
@@ -265,20 +268,11 @@ int aliceVision_main(int argc, char** argv)
 
         // Store to file
         const std::string samplesFilepath = (fs::path(outputFolder) / (std::to_string(groupIdx) + "_samples.dat")).string();
-        std::ofstream fileSamples(samplesFilepath, std::ios::binary);
-        if (!fileSamples.is_open())
+        if (!hdr::writeSamples(samplesFilepath, out_samples))
         {
             ALICEVISION_LOG_ERROR("Impossible to write samples");
             return EXIT_FAILURE;
         }
-
-        const std::size_t size = out_samples.size();
-        fileSamples.write((const char *)&size, sizeof(size));
-
-        for(std::size_t i = 0; i < out_samples.size(); ++i)
-        {
-            fileSamples << out_samples[i];
-        }
     }
 
     return EXIT_SUCCESS;
@@ -301,6 +301,16 @@ int aliceVision_main(int argc, char **argv)
 
   ALICEVISION_LOG_INFO("Number of pairs: " << pairs.size());
 
+  // check the connectivity of the view graph defined by the pairs (not meaningful for a range of views)
+  if(rangeSize == 0)
+  {
+    const graph::ViewGraph pairsGraph(pairs);
+    std::vector<IndexT> componentPerView;
+    const std::size_t nbComponents = graph::connectedComponents(pairsGraph, componentPerView);
+    if(nbComponents > 1)
+      ALICEVISION_LOG_WARNING("The image pairs to match define " << nbComponents << " disconnected groups of views.");
+  }
+
   // filter creation
   for(const auto& pair: pairs)
   {
@@ -9,14 +9,8 @@
 #include <aliceVision/system/main.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
-
-#include <OpenMesh/Core/IO/reader/OBJReader.hh>
-#include <OpenMesh/Core/IO/writer/OBJWriter.hh>
-#include <OpenMesh/Core/IO/MeshIO.hh>
-#include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
-#include <OpenMesh/Core/Geometry/VectorT.hh>
-#include <OpenMesh/Tools/Decimater/DecimaterT.hh>
-#include <OpenMesh/Tools/Decimater/ModQuadricT.hh>
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshDecimate.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -24,7 +18,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 
@@ -44,15 +38,16 @@ int aliceVision_main(int argc, char* argv[])
     int minVertices = 0;
     int maxVertices = 0;
     bool flipNormals = false;
+    mesh::DecimationParams decimationParams;
 
     po::options_description allParams("AliceVision meshResampling");
 
     po::options_description requiredParams("Required parameters");
     requiredParams.add_options()
         ("input,i", po::value<std::string>(&inputMeshPath)->required(),
-            "Input Mesh (OBJ file format).")
+            "Input Mesh (OBJ, PLY or AVMESH file format).")
         ("output,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ, PLY or AVMESH file format).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -64,6 +59,13 @@ int aliceVision_main(int argc, char* argv[])
             "Min number of output vertices.")
         ("maxVertices", po::value<int>(&maxVertices)->default_value(maxVertices),
             "Max number of output vertices.")
+        ("nbTriangles", po::value<int>(&decimationParams.nbTriangles)->default_value(decimationParams.nbTriangles),
+            "Max number of output triangles (0 to ignore).")
+        ("maxError", po::value<double>(&decimationParams.maxError)->default_value(decimationParams.maxError),
+            "Max distance between the output and the input surfaces (0 to ignore). "
+            "If no number of vertices or triangles is given, decimate as much as possible under this error.")
+        ("candidatesRatio", po::value<double>(&decimationParams.candidatesRatio)->default_value(decimationParams.candidatesRatio),
+            "Ratio of the cheapest edges collapsed together at each decimation round: higher is faster, lower is closer to a sequential decimation.")
         ("flipNormals", po::value<bool>(&flipNormals)->default_value(flipNormals),
             "Option to flip face normals. It can be needed as it depends on the vertices order in triangles and the convention change from one software to another.");
 
@@ -111,15 +113,8 @@ int aliceVision_main(int argc, char* argv[])
     if(!bfs::is_directory(outDirectory))
         bfs::create_directory(outDirectory);
 
-    // Mesh type
-    typedef OpenMesh::TriMesh_ArrayKernelT<>                      Mesh;
-    // Decimater type
-    typedef OpenMesh::Decimater::DecimaterT< Mesh >               Decimater;
-    // Decimation Module Handle type
-    typedef OpenMesh::Decimater::ModQuadricT< Mesh >::Handle HModQuadric;
-
-    Mesh mesh;
-    if(!OpenMesh::IO::read_mesh(mesh, inputMeshPath.c_str()))
+    mesh::Mesh inputMesh;
+    if(!inputMesh.load(inputMeshPath))
     {
         ALICEVISION_LOG_ERROR("Unable to read input mesh from the file: " << inputMeshPath);
         return EXIT_FAILURE;
@@ -127,7 +122,7 @@ int aliceVision_main(int argc, char* argv[])
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << inputMeshPath << "\" loaded.");
 
-    int nbInputPoints = mesh.n_vertices();
+    const int nbInputPoints = inputMesh.pts.size();
     int nbOutputPoints = 0;
     if(fixedNbVertices != 0)
     {
@@ -151,35 +146,15 @@ int aliceVision_main(int argc, char* argv[])
         }
     }
 
-    ALICEVISION_LOG_INFO("Input mesh: " << nbInputPoints << " vertices and " << mesh.n_faces() << " facets.");
+    ALICEVISION_LOG_INFO("Input mesh: " << nbInputPoints << " vertices and " << inputMesh.tris.size() << " facets.");
     ALICEVISION_LOG_INFO("Target output mesh: " << nbOutputPoints << " vertices.");
 
-    {
-        // a decimater object, connected to a mesh
-        Decimater   decimater(mesh);
-        // use a quadric module
-        HModQuadric hModQuadric;
-        // register module at the decimater
-        decimater.add(hModQuadric);
-
-        // the way to access the module
-        std::cout << decimater.module(hModQuadric).name() << std::endl;
-
-        /*
-         * since we need exactly one priority module (non-binary)
-         * we have to call set_binary(false) for our priority module
-         * in the case of HModQuadric, unset_max_err() calls set_binary(false) internally
-         */
-        decimater.module(hModQuadric).unset_max_err();
-        // let the decimater initialize the mesh and the modules
-        decimater.initialize();
-        // do decimation
-        size_t removedVertices = decimater.decimate_to(nbOutputPoints);
-        decimater.mesh().garbage_collection();
-    }
-    ALICEVISION_LOG_INFO("Output mesh: " << mesh.n_vertices() << " vertices and " << mesh.n_faces() << " facets.");
+    decimationParams.nbVertices = nbOutputPoints;
+    mesh::decimateMesh(inputMesh, decimationParams);
+
+    ALICEVISION_LOG_INFO("Output mesh: " << inputMesh.pts.size() << " vertices and " << inputMesh.tris.size() << " facets.");
 
-    if(mesh.n_faces() == 0)
+    if(inputMesh.tris.empty())
     {
         ALICEVISION_LOG_ERROR("Failed: the output mesh is empty.");
         return EXIT_FAILURE;
@@ -187,7 +162,7 @@ int aliceVision_main(int argc, char* argv[])
 
     ALICEVISION_LOG_INFO("Save mesh.");
     // Save output mesh
-    if(!OpenMesh::IO::write_mesh(mesh, outputMeshPath))
+    if(!inputMesh.save(outputMeshPath))
     {
         ALICEVISION_LOG_ERROR("Failed to save mesh \"" << outputMeshPath << "\".");
         return EXIT_FAILURE;
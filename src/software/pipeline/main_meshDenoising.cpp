@@ -9,6 +9,7 @@
 #include <aliceVision/system/main.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mesh/openMesh.hpp>
 
 #include <EigenTypes.h>
 #include <MeshTypes.h>
@@ -26,7 +27,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -55,9 +56,9 @@ int aliceVision_main(int argc, char* argv[])
     po::options_description requiredParams("Required parameters");
     requiredParams.add_options()
         ("input,i", po::value<std::string>(&inputMeshPath)->required(),
-            "Input Mesh (OBJ file format).")
+            "Input Mesh (OBJ, PLY or AVMESH file format).")
         ("output,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ, PLY or AVMESH file format).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -124,7 +125,7 @@ int aliceVision_main(int argc, char* argv[])
 
 
     TriMesh inMesh;
-    if(!OpenMesh::IO::read_mesh(inMesh, inputMeshPath.c_str()))
+    if(!mesh::loadOpenMesh(inputMeshPath, inMesh))
     {
         ALICEVISION_LOG_ERROR("Unable to read input mesh from the file: " << inputMeshPath);
         return EXIT_FAILURE;
@@ -205,7 +206,7 @@ int aliceVision_main(int argc, char* argv[])
 
     ALICEVISION_LOG_INFO("Save mesh.");
     // Save output mesh
-    if(!OpenMesh::IO::write_mesh(outMesh, outputMeshPath))
+    if(!mesh::saveOpenMesh(outputMeshPath, outMesh))
     {
         ALICEVISION_LOG_ERROR("Failed to save mesh file: \"" << outputMeshPath << "\".");
         return EXIT_FAILURE;
@@ -9,6 +9,7 @@
 #include <aliceVision/system/main.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mesh/geoMesh.hpp>
 
 #include <geogram/mesh/mesh.h>
 #include <geogram/mesh/mesh_io.h>
@@ -26,7 +27,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -53,9 +54,9 @@ int aliceVision_main(int argc, char* argv[])
     po::options_description requiredParams("Required parameters");
     requiredParams.add_options()
         ("input,i", po::value<std::string>(&inputMeshPath)->required(),
-            "Input Mesh (OBJ file format).")
+            "Input Mesh (OBJ, PLY or AVMESH file format).")
         ("output,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ, PLY or AVMESH file format).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -120,13 +121,27 @@ int aliceVision_main(int argc, char* argv[])
 
     ALICEVISION_LOG_INFO("Geogram initialized.");
 
+    // PLY and native files are read with aliceVision::Mesh (for the binary layouts and the visibilities written by AliceVision)
+    const auto useAliceVisionMeshIO = [](const std::string& filepath) {
+        const mesh::Mesh::EFileType fileType = mesh::Mesh::getFileType(filepath);
+        return fileType == mesh::Mesh::EFileType::PLY || fileType == mesh::Mesh::EFileType::NATIVE;
+    };
+
     GEO::Mesh M_in, M_out;
+    if(useAliceVisionMeshIO(inputMeshPath))
     {
-        if(!GEO::mesh_load(inputMeshPath, M_in))
+        mesh::Mesh inputMesh;
+        if(!inputMesh.load(inputMeshPath))
         {
             ALICEVISION_LOG_ERROR("Failed to load mesh file: \"" << inputMeshPath << "\".");
             return 1;
         }
+        mesh::toGeoMesh(inputMesh, M_in);
+    }
+    else if(!GEO::mesh_load(inputMeshPath, M_in))
+    {
+        ALICEVISION_LOG_ERROR("Failed to load mesh file: \"" << inputMeshPath << "\".");
+        return 1;
     }
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << inputMeshPath << "\" loaded.");
@@ -196,7 +211,18 @@ int aliceVision_main(int argc, char* argv[])
     }
 
     ALICEVISION_LOG_INFO("Save mesh.");
-    if(!GEO::mesh_save(M_out, outputMeshPath))
+    bool saved = false;
+    if(useAliceVisionMeshIO(outputMeshPath))
+    {
+        mesh::Mesh outputMesh;
+        mesh::fromGeoMesh(M_out, outputMesh);
+        saved = outputMesh.save(outputMeshPath);
+    }
+    else
+    {
+        saved = GEO::mesh_save(M_out, outputMeshPath);
+    }
+    if(!saved)
     {
         ALICEVISION_LOG_ERROR("Failed to save mesh file: \"" << outputMeshPath << "\".");
         return EXIT_FAILURE;
@@ -10,6 +10,7 @@
 #include <aliceVision/fuseCut/LargeScale.hpp>
 #include <aliceVision/fuseCut/ReconstructionPlan.hpp>
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/fuseCut/SpacePartition.hpp>
 #include <aliceVision/mesh/meshPostProcessing.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
@@ -28,11 +29,13 @@
 #include <boost/filesystem.hpp>
 
 #include <cmath>
+#include <iomanip>
+#include <sstream>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 4
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 
@@ -246,6 +249,57 @@ inline std::istream& operator>>(std::istream& in, BoundingBox& out_bbox)
     return in;
 }
 
+/// Rough estimate of the memory used by DelaunayGraphCut per point: tetrahedralization, cells attributes and graph
+const std::size_t meshingBytesPerPoint = 2048;
+
+/// Estimate the reconstruction volume from the bounding box, the depth maps or the SfM
+void computeReconstructionVolume(const sfmData::SfMData& sfmData, mvsUtils::MultiViewParams& mp, const BoundingBox& boundingBox,
+                                 bool meshingFromDepthMaps, bool estimateSpaceFromSfM,
+                                 std::size_t estimateSpaceMinObservations, float estimateSpaceMinObservationAngle,
+                                 std::array<Point3d, 8>& hexah)
+{
+    float minPixSize;
+    fuseCut::Fuser fs(&mp);
+
+    if (boundingBox.isInitialized())
+        boundingBox.toHexahedron(&hexah[0]);
+    else if(meshingFromDepthMaps && (!estimateSpaceFromSfM || sfmData.getLandmarks().empty()))
+      fs.divideSpaceFromDepthMaps(&hexah[0], minPixSize);
+    else
+      fs.divideSpaceFromSfM(sfmData, &hexah[0], estimateSpaceMinObservations, estimateSpaceMinObservationAngle);
+
+    {
+        const double length = hexah[0].x - hexah[1].x;
+        const double width = hexah[0].y - hexah[3].y;
+        const double height = hexah[0].z - hexah[4].z;
+
+        ALICEVISION_LOG_INFO("bounding Box : length: " << length << ", width: " << width << ", height: " << height);
+    }
+}
+
+/// Cameras used to reconstruct a volume
+StaticVector<int> getReconstructionCameras(const mvsUtils::MultiViewParams& mp, const Point3d* hexah, bool meshingFromDepthMaps)
+{
+    StaticVector<int> cams;
+    if(meshingFromDepthMaps)
+    {
+      cams = mp.findCamsWhichIntersectsHexahedron(hexah);
+    }
+    else
+    {
+      cams.resize(mp.getNbCameras());
+      for(int i = 0; i < cams.size(); ++i)
+          cams[i] = i;
+    }
+    return cams;
+}
+
+std::string getCellMeshFilepath(const fs::path& partitionDirectory, int cellId)
+{
+    std::ostringstream filename;
+    filename << "cell_" << std::setw(4) << std::setfill('0') << cellId << ".avmesh";
+    return (partitionDirectory / filename.str()).string();
+}
 
 int aliceVision_main(int argc, char* argv[])
 {
@@ -273,6 +327,10 @@ int aliceVision_main(int argc, char* argv[])
     int nbSolidAngleFilteringIterations = 2;
     unsigned int seed = 0;
     BoundingBox boundingBox;
+    double partitionMaxMemory = 8192.0;
+    double partitionOverlap = 0.15;
+    int rangeStart = -1;
+    int rangeSize = -1;
 
     fuseCut::FuseParams fuseParams;
 
@@ -294,7 +352,7 @@ int aliceVision_main(int argc, char* argv[])
         ("output,o", po::value<std::string>(&outputDensePointCloud)->required(),
           "Output Dense SfMData file.")
         ("outputMesh,o", po::value<std::string>(&outputMesh)->required(),
-          "Output mesh (OBJ file format).");
+          "Output mesh (OBJ, PLY or AVMESH file format).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -318,7 +376,17 @@ int aliceVision_main(int argc, char* argv[])
         ("minVis", po::value<int>(&fuseParams.minVis)->default_value(fuseParams.minVis),
             "Filter points based on their number of observations")
         ("partitioning", po::value<EPartitioningMode>(&partitioningMode)->default_value(partitioningMode),
-            "Partitioning: 'singleBlock' or 'auto'.")
+            "Partitioning: 'singleBlock' or 'auto'. 'auto' splits the volume in cells meshed independently "
+            "to fit partitionMaxMemory and stitches their meshes.")
+        ("partitionMaxMemory", po::value<double>(&partitionMaxMemory)->default_value(partitionMaxMemory),
+            "Partitioning 'auto': memory budget (in MB) to mesh a cell.")
+        ("partitionOverlap", po::value<double>(&partitionOverlap)->default_value(partitionOverlap),
+            "Partitioning 'auto': overlap margins of the cells, relatively to their size.")
+        ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+            "Partitioning 'auto': compute a sub-range of cells from index rangeStart to rangeStart+rangeSize. "
+            "The cells meshes are kept in the output folder, call again without range to stitch them.")
+        ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+            "Partitioning 'auto': compute a sub-range of N cells (N=rangeSize).")
         ("repartition", po::value<ERepartitionMode>(&repartitionMode)->default_value(repartitionMode),
             "Repartition: 'multiResolution' or 'regularGrid'.")
         ("estimateSpaceFromSfM", po::value<bool>(&estimateSpaceFromSfM)->default_value(estimateSpaceFromSfM),
@@ -491,42 +559,140 @@ int aliceVision_main(int argc, char* argv[])
             {
                 case ePartitioningAuto:
                 {
-                    throw std::invalid_argument("Meshing mode: 'multiResolution', partitioning: 'auto' is not yet implemented.");
-                }
-                case ePartitioningSingleBlock:
-                {
-                    ALICEVISION_LOG_INFO("Meshing mode: multi-resolution, partitioning: single block.");
+                    ALICEVISION_LOG_INFO("Meshing mode: multi-resolution, partitioning: auto.");
                     std::array<Point3d, 8> hexah;
+                    computeReconstructionVolume(sfmData, mp, boundingBox, meshingFromDepthMaps, estimateSpaceFromSfM,
+                                                estimateSpaceMinObservations, estimateSpaceMinObservationAngle, hexah);
+
+                    std::vector<Point3d> landmarks;
+                    landmarks.reserve(sfmData.getLandmarks().size());
+                    for(const auto& landmarkPair : sfmData.getLandmarks())
+                    {
+                        const Vec3& X = landmarkPair.second.X;
+                        landmarks.emplace_back(X.x(), X.y(), X.z());
+                    }
+
+                    // the points expected in the whole volume, split in cells fitting the memory budget
+                    const std::size_t nbPoints = meshingFromDepthMaps ? std::size_t(fuseParams.maxPoints) : landmarks.size();
+                    const std::size_t maxPointsPerCell = std::max<std::size_t>(1, std::size_t(partitionMaxMemory * 1024.0 * 1024.0) / meshingBytesPerPoint);
 
-                    float minPixSize;
-                    fuseCut::Fuser fs(&mp);
+                    fuseCut::SpacePartition partition(&hexah[0]);
+                    partition.build(landmarks, nbPoints, maxPointsPerCell, partitionOverlap);
 
-                    if (boundingBox.isInitialized())
-                        boundingBox.toHexahedron(&hexah[0]);
-                    else if(meshingFromDepthMaps && (!estimateSpaceFromSfM || sfmData.getLandmarks().empty()))
-                      fs.divideSpaceFromDepthMaps(&hexah[0], minPixSize);
-                    else
-                      fs.divideSpaceFromSfM(sfmData, &hexah[0], estimateSpaceMinObservations, estimateSpaceMinObservationAngle);
+                    const int nbCells = partition.getNbCells();
+                    if(nbCells == 0)
+                        throw std::runtime_error("No cell to make the reconstruction");
 
+                    const fs::path partitionDirectory = outDirectory / "partition";
+                    if(!fs::is_directory(partitionDirectory))
+                        fs::create_directory(partitionDirectory);
+
+                    int cellStart = 0;
+                    int cellEnd = nbCells;
+                    if(rangeSize != -1)
                     {
-                        const double length = hexah[0].x - hexah[1].x;
-                        const double width = hexah[0].y - hexah[3].y;
-                        const double height = hexah[0].z - hexah[4].z;
+                        if(rangeStart < 0 || rangeSize < 0)
+                        {
+                            ALICEVISION_LOG_ERROR("Range is incorrect");
+                            return EXIT_FAILURE;
+                        }
+                        cellStart = std::min(rangeStart, nbCells);
+                        cellEnd = std::min(rangeStart + rangeSize, nbCells);
+                    }
 
-                        ALICEVISION_LOG_INFO("bounding Box : length: " << length << ", width: " << width << ", height: " << height);
+                    // the cells are meshed one after the other, each one uses all the threads
+                    for(int cellId = cellStart; cellId < cellEnd; ++cellId)
+                    {
+                        const std::string cellMeshFilepath = getCellMeshFilepath(partitionDirectory, cellId);
+                        if(fs::exists(cellMeshFilepath))
+                        {
+                            ALICEVISION_LOG_INFO("Cell " << cellId << "/" << nbCells << " already computed.");
+                            continue;
+                        }
+                        ALICEVISION_LOG_INFO("Mesh cell " << cellId << "/" << nbCells << ", " << partition.getNbEstimatedPoints(cellId) << " estimated points.");
+
+                        std::array<Point3d, 8> cellHexah;
+                        partition.getCellHexahedron(cellId, &cellHexah[0]);
+
+                        const StaticVector<int> cams = getReconstructionCameras(mp, &cellHexah[0], meshingFromDepthMaps);
+                        if(cams.empty())
+                        {
+                            ALICEVISION_LOG_WARNING("No camera to reconstruct cell " << cellId << ".");
+                            mesh::Mesh().save(cellMeshFilepath);
+                            continue;
+                        }
+
+                        // same density as a single block: the cell gets its share of the max number of points
+                        fuseCut::FuseParams cellFuseParams = fuseParams;
+                        cellFuseParams.maxPoints = int(std::min(partition.getNbEstimatedPoints(cellId), maxPointsPerCell));
+
+                        const std::string cellDirectory = (partitionDirectory / ("cell_" + std::to_string(cellId))).string() + "/";
+                        if(!fs::is_directory(cellDirectory))
+                            fs::create_directory(cellDirectory);
+
+                        fuseCut::DelaunayGraphCut delaunayGC(&mp);
+                        delaunayGC.createDensePointCloud(&cellHexah[0], cams, addLandmarksToTheDensePointCloud ? &sfmData : nullptr, meshingFromDepthMaps ? &cellFuseParams : nullptr);
+                        delaunayGC.createGraphCut(&cellHexah[0], cams, cellDirectory, cellDirectory + "SpaceCamsTracks/", false,
+                                                  exportDebugTetrahedralization);
+                        delaunayGC.graphCutPostProcessing(&cellHexah[0], cellDirectory);
+
+                        mesh::Mesh* cellMesh = delaunayGC.createMesh(maxNbConnectedHelperPoints);
+                        StaticVector<StaticVector<int>> cellPtsCams;
+                        delaunayGC.createPtsCams(cellPtsCams);
+                        mesh::meshPostProcessing(cellMesh, cellPtsCams, mp, cellDirectory, nullptr, &cellHexah[0]);
+
+                        // the overlap margins are only used to get the same surface as the neighbor cells on the cell borders
+                        std::swap(cellMesh->pointsVisibilities, cellPtsCams);
+                        fuseCut::cropMeshToCell(*cellMesh, partition, cellId);
+
+                        const bool saved = cellMesh->save(cellMeshFilepath);
+                        delete cellMesh;
+                        if(!saved)
+                        {
+                            ALICEVISION_LOG_ERROR("Failed to save cell mesh file: \"" << cellMeshFilepath << "\".");
+                            return EXIT_FAILURE;
+                        }
+                        fs::remove_all(cellDirectory);
                     }
 
-                    StaticVector<int> cams;
-                    if(meshingFromDepthMaps)
+                    if(rangeSize != -1)
                     {
-                      cams = mp.findCamsWhichIntersectsHexahedron(&hexah[0]);
+                        ALICEVISION_LOG_INFO("Cells " << cellStart << " to " << cellEnd << " done in (s): " + std::to_string(timer.elapsed()));
+                        return EXIT_SUCCESS;
                     }
-                    else
+
+                    // merge and stitch the cells meshes
+                    mesh = new mesh::Mesh();
+                    std::vector<int> ptsCellIds;
+                    for(int cellId = 0; cellId < nbCells; ++cellId)
                     {
-                      cams.resize(mp.getNbCameras());
-                      for(int i = 0; i < cams.size(); ++i)
-                          cams[i] = i;
+                        mesh::Mesh cellMesh;
+                        if(!cellMesh.load(getCellMeshFilepath(partitionDirectory, cellId)))
+                            throw std::runtime_error("Failed to load the mesh of cell " + std::to_string(cellId));
+                        // cell without camera or without surface
+                        if(cellMesh.tris.empty())
+                        {
+                            ALICEVISION_LOG_INFO("Cell " << cellId << "/" << nbCells << " is empty.");
+                            continue;
+                        }
+                        mesh->addMesh(cellMesh);
+                        ptsCellIds.resize(mesh->pts.size(), cellId);
                     }
+                    if(mesh->tris.empty())
+                        throw std::runtime_error("All the cells meshes are empty");
+                    fuseCut::stitchCellsMeshes(*mesh, ptsCellIds, partition);
+                    std::swap(ptsCams, mesh->pointsVisibilities);
+
+                    break;
+                }
+                case ePartitioningSingleBlock:
+                {
+                    ALICEVISION_LOG_INFO("Meshing mode: multi-resolution, partitioning: single block.");
+                    std::array<Point3d, 8> hexah;
+                    computeReconstructionVolume(sfmData, mp, boundingBox, meshingFromDepthMaps, estimateSpaceFromSfM,
+                                                estimateSpaceMinObservations, estimateSpaceMinObservationAngle, hexah);
+
+                    const StaticVector<int> cams = getReconstructionCameras(mp, &hexah[0], meshingFromDepthMaps);
 
                     if(cams.empty())
                         throw std::logic_error("No camera to make the reconstruction");
@@ -601,9 +767,14 @@ int aliceVision_main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Save dense point cloud.");
     sfmDataIO::Save(densePointCloud, outputDensePointCloud, sfmDataIO::ESfMData::ALL_DENSE);
 
-    ALICEVISION_LOG_INFO("Save obj mesh file.");
-    mesh->saveToObj(outputMesh);
+    ALICEVISION_LOG_INFO("Save mesh file.");
+    const bool saved = mesh->save(outputMesh);
     delete mesh;
+    if(!saved)
+    {
+        ALICEVISION_LOG_ERROR("Failed to save mesh file: \"" << outputMesh << "\".");
+        return EXIT_FAILURE;
+    }
 
 
     ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
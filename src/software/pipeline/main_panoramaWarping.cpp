@@ -23,6 +23,10 @@
 #include <aliceVision/panorama/warper.hpp>
 #include <aliceVision/panorama/distance.hpp>
 
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <future>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
@@ -297,49 +301,9 @@ int aliceVision_main(int argc, char** argv)
 				snappedCoarseBbox = coarseBbox;
 				snappedCoarseBbox.snapToGrid(tileSize);
 
-				//Initialize bouding box for image
+				// Compute the bounding box of the view in the panorama (tiles in parallel)
 				BoundingBox globalBbox;
-				
-				std::vector<BoundingBox> boxes;
-				for (int y = 0; y < snappedCoarseBbox.height; y += tileSize) 
-				{
-					for (int x = 0; x < snappedCoarseBbox.width; x += tileSize) 
-					{
-						BoundingBox localBbox;
-						localBbox.left = x + snappedCoarseBbox.left;
-						localBbox.top = y + snappedCoarseBbox.top;
-					    localBbox.width = tileSize;
-						localBbox.height = tileSize;
-
-						localBbox.clampRight(snappedCoarseBbox.getRight());
-						localBbox.clampBottom(snappedCoarseBbox.getBottom());
-
-						boxes.push_back(localBbox);
-					}
-				}
-
-				#pragma omp parallel for
-				for (int boxId = 0; boxId < boxes.size(); boxId++) {
-
-					BoundingBox localBbox = boxes[boxId];
-
-					// Prepare coordinates map
-					CoordinatesMap map;
-					if (!map.build(panoramaSize, camPose, *(intrinsic.get()), localBbox)) {
-						continue;
-					}
-
-					if (map.getBoundingBox().isEmpty()) 
-					{
-						continue;
-					}
-
-
-					#pragma omp critical 
-					{
-						globalBbox = globalBbox.unionWith(map.getBoundingBox());
-					}
-				}
+				computeWarpedBoundingBox(globalBbox, panoramaSize, camPose, *(intrinsic.get()), snappedCoarseBbox, tileSize);
 
 				//Rare case ... When all boxes valid are after the loop
 				if (globalBbox.left >= panoramaSize.first)
@@ -404,13 +368,14 @@ int aliceVision_main(int argc, char** argv)
 				out_mask->open(maskFilepath, spec_mask);
 				out_weights->open(weightFilepath, spec_weights);
 
+				// The source image is moved in the first level of the pyramid (no copy)
 				GaussianPyramidNoMask pyramid(source.Width(), source.Height());
-				if (!pyramid.process(source)) {
+				if (!pyramid.processInPlace(source)) {
 					ALICEVISION_LOG_ERROR("Problem creating pyramid.");
 					continue;
 				}
 
-				boxes.clear();
+				std::vector<BoundingBox> boxes;
 				for (int y = 0; y < globalBbox.height; y += tileSize) 
 				{
 					for (int x = 0; x < globalBbox.width; x += tileSize) 
@@ -424,53 +389,37 @@ int aliceVision_main(int argc, char** argv)
 					}
 				}
 
-				
-				#pragma omp parallel for 
-				for (int boxId = 0; boxId < boxes.size(); boxId++) 
-				{
-					BoundingBox localBbox = boxes[boxId];
-
-					int x = localBbox.left - globalBbox.left;
-					int y = localBbox.top - globalBbox.top;
-
-					// Prepare coordinates map
-					CoordinatesMap map;
-					if (!map.build(panoramaSize, camPose, *(intrinsic.get()), localBbox)) 
-					{
-						continue;
-					}
-
-					// Warp image
-					GaussianWarper warper;
-					if (!warper.warp(map, pyramid, clampHalf)) {
-						continue;
-					}
-
-					// Alpha mask
-					aliceVision::image::Image<float> weights;
-					if (!distanceToCenter(weights, map, intrinsic->w(), intrinsic->h())) {
-						continue;
-					}
-
-					// Store
-					#pragma omp critical 
-					{
-						out_view->write_tile(x, y, 0, oiio::TypeDesc::FLOAT, warper.getColor().data());
-					}
+				// The tiles are warped in parallel while a single thread writes them in the tiles order:
+				// the writes need no lock and the memory usage is bounded by the queue capacity, whatever the panorama size
+				WarpedTilesQueue queue(4 * omp_get_max_threads());
 
-					// Store
-					#pragma omp critical 
+				std::future<void> writing = std::async(std::launch::async, [&]() {
+					for (size_t boxId = 0; boxId < boxes.size(); boxId++)
 					{
-						out_mask->write_tile(x, y, 0, oiio::TypeDesc::UCHAR, warper.getMask().data());
+						const WarpedTile& tile = queue.front();
+						if (tile.valid)
+						{
+							const int x = tile.bbox.left - globalBbox.left;
+							const int y = tile.bbox.top - globalBbox.top;
+
+							out_view->write_tile(x, y, 0, oiio::TypeDesc::FLOAT, tile.warper.getColor().data());
+							out_mask->write_tile(x, y, 0, oiio::TypeDesc::UCHAR, tile.warper.getMask().data());
+							out_weights->write_tile(x, y, 0, oiio::TypeDesc::FLOAT, tile.weights.data());
+						}
+						queue.pop();
 					}
+				});
 
-					// Store
-					#pragma omp critical 
-					{
-						out_weights->write_tile(x, y, 0, oiio::TypeDesc::FLOAT, weights.data());
-					}
+				#pragma omp parallel for schedule(dynamic)
+				for (int boxId = 0; boxId < boxes.size(); boxId++) 
+				{
+					WarpedTile& tile = queue.acquire(boxId);
+					warpTile(tile, panoramaSize, camPose, *(intrinsic.get()), boxes[boxId], pyramid, clampHalf);
+					queue.push(boxId);
 				}
 
+				writing.get();
+
 				out_view->close();
 				out_mask->close();
 				out_weights->close();
@@ -0,0 +1,271 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2021 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/BundleAdjustmentPartitioned.hpp>
+#include <aliceVision/sfm/utils/alignment.hpp>
+#include <aliceVision/sfm/utils/statistics.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/main.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/config.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Compare the poses and the landmarks of two scenes with the same ids.
+ *        The bundle adjustment gauge is free, so the first scene is aligned on the second one
+ *        with a similarity estimated from the common camera centers before the comparison.
+ * @param[in] sfmDataA The first scene
+ * @param[in] sfmDataB The second scene
+ */
+void compareScenes(const sfmData::SfMData& sfmDataA, const sfmData::SfMData& sfmDataB)
+{
+  double S = 1.0;
+  Mat3 R = Mat3::Identity();
+  Vec3 t = Vec3::Zero();
+  std::mt19937 randomNumberGenerator;
+
+  if(!sfm::computeSimilarityFromCommonCameras_poseId(sfmDataA, sfmDataB, randomNumberGenerator, &S, &R, &t))
+    ALICEVISION_LOG_WARNING("Cannot align the scenes, they are compared in their own coordinate systems.");
+
+  double maxCenterDistance = 0.0;
+  for(const auto& posePair : sfmDataA.getPoses())
+  {
+    const auto it = sfmDataB.getPoses().find(posePair.first);
+    if(it == sfmDataB.getPoses().end())
+      continue;
+    const Vec3 alignedCenter = S * R * posePair.second.getTransform().center() + t;
+    const double distance = (alignedCenter - it->second.getTransform().center()).norm();
+    maxCenterDistance = std::max(maxCenterDistance, distance);
+  }
+
+  std::vector<double> landmarksDistances;
+  landmarksDistances.reserve(sfmDataA.getLandmarks().size());
+  for(const auto& landmarkPair : sfmDataA.getLandmarks())
+  {
+    const auto it = sfmDataB.getLandmarks().find(landmarkPair.first);
+    if(it != sfmDataB.getLandmarks().end())
+      landmarksDistances.push_back((S * R * landmarkPair.second.X + t - it->second.X).norm());
+  }
+
+  double medianLandmarkDistance = 0.0;
+  if(!landmarksDistances.empty())
+  {
+    std::nth_element(landmarksDistances.begin(), landmarksDistances.begin() + landmarksDistances.size() / 2, landmarksDistances.end());
+    medianLandmarkDistance = landmarksDistances.at(landmarksDistances.size() / 2);
+  }
+
+  ALICEVISION_LOG_INFO("Partitioned vs monolithic bundle adjustment:" << std::endl
+    << "\t- RMSE partitioned: " << sfm::RMSE(sfmDataA) << std::endl
+    << "\t- RMSE monolithic: " << sfm::RMSE(sfmDataB) << std::endl
+    << "\t- max camera center distance: " << maxCenterDistance << std::endl
+    << "\t- median landmark distance: " << medianLandmarkDistance);
+}
+
+int aliceVision_main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::string outputSfM;
+
+  // worker parameters
+  std::string submapFilename;
+  std::string priorsFilename;
+
+  // user optional parameters
+  sfm::BundleAdjustmentPartitioned::PartitionedOptions options;
+  std::vector<std::string> workerCommand;
+  bool lockAllIntrinsics = false;
+  bool compareMonolithic = false;
+
+  po::options_description allParams(
+    "Partitioned bundle adjustment\n"
+    "Adjust a large scene split in submaps reconciled by consensus iterations.\n"
+    "The submaps can be adjusted by worker processes exchanging files in a working folder.\n"
+    "AliceVision sfmBundleAdjustmentPartitioned");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("output,o", po::value<std::string>(&outputSfM)->required(),
+      "Path to the output SfMData file.")
+    ;
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename),
+      "SfMData file to adjust (coordinator mode).")
+    ("submap", po::value<std::string>(&submapFilename),
+      "Submap SfMData file to adjust (worker mode).")
+    ("priors", po::value<std::string>(&priorsFilename),
+      "Consensus priors file of the submap (worker mode).")
+    ("maxNbPosesPerSubmap", po::value<std::size_t>(&options.maxNbPosesPerSubmap)->default_value(options.maxNbPosesPerSubmap),
+      "Maximum number of poses per submap.")
+    ("maxNbIterations", po::value<std::size_t>(&options.maxNbIterations)->default_value(options.maxNbIterations),
+      "Maximum number of consensus iterations.")
+    ("relativeTolerance", po::value<double>(&options.relativeTolerance)->default_value(options.relativeTolerance),
+      "Relative tolerance on the consensus residuals.")
+    ("workingFolder", po::value<std::string>(&options.workingFolder)->default_value(options.workingFolder),
+      "Folder used to exchange the submaps with the worker processes.\n"
+      "If empty, the submaps are adjusted in the current process.")
+    ("workerCommand", po::value<std::vector<std::string>>(&workerCommand)->multitoken(),
+      "Program and first arguments used to run a worker process (this software by default), run without shell.\n"
+      "It can be a remote execution wrapper if the working folder is shared.")
+    ("nbWorkers", po::value<int>(&options.nbWorkers)->default_value(options.nbWorkers),
+      "Maximum number of worker processes running at the same time.")
+    ("lockAllIntrinsics", po::value<bool>(&lockAllIntrinsics)->default_value(lockAllIntrinsics),
+      "Force lock of all camera intrinsic parameters, so they will not be refined.")
+    ("compareMonolithic", po::value<bool>(&compareMonolithic)->default_value(compareMonolithic),
+      "Also run the monolithic bundle adjustment and compare the results.")
+    ;
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // worker mode: adjust a single submap with its consensus priors
+  if(!submapFilename.empty())
+  {
+    if(priorsFilename.empty())
+    {
+      ALICEVISION_LOG_ERROR("The worker mode requires the '--priors' parameter.");
+      return EXIT_FAILURE;
+    }
+
+    if(!sfm::BundleAdjustmentPartitioned::adjustSubmap(submapFilename, priorsFilename, outputSfM, options.ceresOptions))
+      return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+  }
+
+  // coordinator mode
+  if(sfmDataFilename.empty())
+  {
+    ALICEVISION_LOG_ERROR("The '--input' parameter is required in coordinator mode.");
+    return EXIT_FAILURE;
+  }
+
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  if(lockAllIntrinsics)
+  {
+    for(auto& intrinsicPair : sfmData.getIntrinsics())
+      intrinsicPair.second->lock();
+  }
+
+  if(!options.workingFolder.empty())
+  {
+    if(!fs::exists(options.workingFolder))
+      fs::create_directories(options.workingFolder);
+
+    // the worker processes run this software in worker mode by default
+    if(workerCommand.empty())
+      workerCommand = {fs::system_complete(argv[0]).string(), "--verboseLevel", verboseLevel};
+
+    options.workerCommand = workerCommand;
+  }
+
+  // keep an independent copy of the input scene for the comparison
+  sfmData::SfMData sfmDataMonolithic;
+  if(compareMonolithic)
+  {
+    sfmDataMonolithic = sfmData;
+    for(auto& intrinsicPair : sfmDataMonolithic.getIntrinsics())
+      intrinsicPair.second.reset(intrinsicPair.second->clone());
+  }
+
+  aliceVision::system::Timer timer;
+
+  sfm::BundleAdjustmentPartitioned bundleAdjustment(options);
+  if(!bundleAdjustment.adjust(sfmData))
+  {
+    ALICEVISION_LOG_ERROR("The partitioned bundle adjustment failed.");
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Partitioned bundle adjustment took: " << timer.elapsedMs() / 1000.0 << " s");
+
+  if(compareMonolithic)
+  {
+    timer.reset();
+
+    sfm::BundleAdjustmentCeres::CeresOptions ceresOptions;
+    sfm::BundleAdjustmentCeres monolithicBundleAdjustment(ceresOptions);
+    if(!monolithicBundleAdjustment.adjust(sfmDataMonolithic))
+      ALICEVISION_LOG_WARNING("The monolithic bundle adjustment failed.");
+
+    ALICEVISION_LOG_INFO("Monolithic bundle adjustment took: " << timer.elapsedMs() / 1000.0 << " s");
+    compareScenes(sfmData, sfmDataMonolithic);
+  }
+
+  ALICEVISION_LOG_INFO("Save the adjusted SfMData: " << outputSfM);
+  if(!sfmDataIO::Save(sfmData, outputSfM, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The output SfMData file '" << outputSfM << "' cannot be written.");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -25,7 +25,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 3
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -62,7 +62,7 @@ int aliceVision_main(int argc, char* argv[])
         ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
           "Dense point cloud SfMData file.")
         ("inputMesh", po::value<std::string>(&inputMeshFilepath)->required(),
-            "Input mesh to texture.")
+            "Input mesh to texture (OBJ, PLY or AVMESH file format).")
         ("output,o", po::value<std::string>(&outputFolder)->required(),
             "Folder for output mesh: OBJ, material and texture files.");
 
@@ -184,9 +184,9 @@ int aliceVision_main(int argc, char* argv[])
     {
         mesh.clear();
 
-        // load input mesh (to texture) obj file
+        // load input mesh (to texture) file
         ALICEVISION_LOG_INFO("Load input mesh.");
-        mesh.loadOBJWithAtlas(inputMeshFilepath, flipNormals);
+        mesh.loadWithAtlas(inputMeshFilepath, flipNormals);
 
         // load reference dense point cloud with visibilities
         ALICEVISION_LOG_INFO("Convert dense point cloud into ref mesh");